@@ -59,12 +59,31 @@
 // class CRectification::CRectificationMapper
 // ****************************************************************************
 
-void CRectification::CRectificationMapper::Init(const Mat3d &homography, const CCalibration *pCalibration)
+void CRectification::CRectificationMapper::Init(const Mat3d &homography, const CCalibration *pCalibration, const char *pCacheDirectory)
 {
 	m_pCalibration = pCalibration;
 	Math3d::SetMat(m_homography, homography);
 
-	ComputeMap(m_pCalibration->GetCameraParameters().width, m_pCalibration->GetCameraParameters().height);
+	const CCalibration::CCameraParameters &cameraParameters = m_pCalibration->GetCameraParameters();
+
+	if (pCacheDirectory)
+	{
+		const int nUndistort = m_bUndistort ? 1 : 0;
+		
+		unsigned int nKey = UpdateKey(2166136261u, "rectification", 13);
+		nKey = UpdateKey(nKey, &m_homography, sizeof(m_homography));
+		nKey = UpdateKey(nKey, &nUndistort, sizeof(nUndistort));
+		nKey = UpdateKey(nKey, &cameraParameters, sizeof(cameraParameters));
+
+		char szFileName[32];
+		sprintf(szFileName, "/rectification_%.8x.map", nKey);
+
+		ComputeMap(cameraParameters.width, cameraParameters.height, (std::string(pCacheDirectory) + szFileName).c_str(), nKey);
+	}
+	else
+	{
+		ComputeMap(cameraParameters.width, cameraParameters.height);
+	}
 }
 
 void CRectification::CRectificationMapper::ComputeOriginalCoordinates(const Vec2d &newCoordinates, Vec2d &originalCoordinates)
@@ -136,8 +155,15 @@ void CRectification::UpdateMaps()
 		return;
 	}
 	
-	m_pRectificationMapperLeft->Init(m_pUsedStereoCalibration->rectificationHomographyLeft, m_pUsedStereoCalibration->GetLeftCalibration());
-	m_pRectificationMapperRight->Init(m_pUsedStereoCalibration->rectificationHomographyRight, m_pUsedStereoCalibration->GetRightCalibration());
+	const char *pCacheDirectory = m_sMapCacheDirectory.empty() ? 0 : m_sMapCacheDirectory.c_str();
+	
+	m_pRectificationMapperLeft->Init(m_pUsedStereoCalibration->rectificationHomographyLeft, m_pUsedStereoCalibration->GetLeftCalibration(), pCacheDirectory);
+	m_pRectificationMapperRight->Init(m_pUsedStereoCalibration->rectificationHomographyRight, m_pUsedStereoCalibration->GetRightCalibration(), pCacheDirectory);
+}
+
+void CRectification::SetMapCacheDirectory(const char *pDirectory)
+{
+	m_sMapCacheDirectory = pDirectory ? pDirectory : "";
 }
 
 void CRectification::Rectify(const CByteImage * const *ppInputImages, CByteImage **ppOutputImages)
@@ -145,3 +171,9 @@ void CRectification::Rectify(const CByteImage * const *ppInputImages, CByteImage
 	m_pRectificationMapperLeft->PerformMapping(ppInputImages[0], ppOutputImages[0]);
 	m_pRectificationMapperRight->PerformMapping(ppInputImages[1], ppOutputImages[1]);
 }
+
+void CRectification::Rectify(const CByteImage * const *ppBayerImages, CByteImage **ppOutputImages, ImageProcessor::BayerPatternType type)
+{
+	m_pRectificationMapperLeft->PerformMapping(ppBayerImages[0], ppOutputImages[0], type);
+	m_pRectificationMapperRight->PerformMapping(ppBayerImages[1], ppOutputImages[1], type);
+}
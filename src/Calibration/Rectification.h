@@ -49,6 +49,7 @@
 
 #include "Image/ImageMapper.h"
 #include "Math/Math3d.h"
+#include <string>
 
 
 // ****************************************************************************
@@ -90,7 +91,13 @@ public:
 	// use this method for re-calculating the maps (not needed for static calibrations)
 	void UpdateMaps();
 
+	// caches the maps in files in the given directory, keyed by the calibration (call before Init; pass 0 to disable)
+	void SetMapCacheDirectory(const char *pDirectory);
+
 	void Rectify(const CByteImage * const *ppInputImages, CByteImage **ppOutputImages);
+
+	// Bayer pattern conversion (see ImageProcessor::ConvertBayerPattern), rectification and, for grayscale output images, conversion to grayscale in one pass
+	void Rectify(const CByteImage * const *ppBayerImages, CByteImage **ppOutputImages, ImageProcessor::BayerPatternType type);
 	
 	
 private:
@@ -102,7 +109,7 @@ private:
 			m_bUndistort = bUndistort;
 		}
 
-		void Init(const Mat3d &homography, const CCalibration *pCalibration);
+		void Init(const Mat3d &homography, const CCalibration *pCalibration, const char *pCacheDirectory = 0);
 
 	private:
 		void ComputeOriginalCoordinates(const Vec2d &newCoordinates, Vec2d &originalCoordinates);
@@ -120,6 +127,8 @@ private:
 	
 	CRectificationMapper *m_pRectificationMapperLeft;
 	CRectificationMapper *m_pRectificationMapperRight;
+
+	std::string m_sMapCacheDirectory;
 };
 
 
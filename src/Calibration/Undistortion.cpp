@@ -59,10 +59,26 @@
 // class CUndistortion::CUndistortionMapper
 // ****************************************************************************
 
-void CUndistortion::CUndistortionMapper::Init(const CCalibration *pCalibration)
+void CUndistortion::CUndistortionMapper::Init(const CCalibration *pCalibration, const char *pCacheDirectory)
 {
 	m_pCalibration = pCalibration;
-	ComputeMap(m_pCalibration->GetCameraParameters().width, m_pCalibration->GetCameraParameters().height);
+
+	const CCalibration::CCameraParameters &cameraParameters = m_pCalibration->GetCameraParameters();
+
+	if (pCacheDirectory)
+	{
+		unsigned int nKey = UpdateKey(2166136261u, "undistortion", 12);
+		nKey = UpdateKey(nKey, &cameraParameters, sizeof(cameraParameters));
+
+		char szFileName[32];
+		sprintf(szFileName, "/undistortion_%.8x.map", nKey);
+
+		ComputeMap(cameraParameters.width, cameraParameters.height, (std::string(pCacheDirectory) + szFileName).c_str(), nKey);
+	}
+	else
+	{
+		ComputeMap(cameraParameters.width, cameraParameters.height);
+	}
 }
 
 void CUndistortion::CUndistortionMapper::ComputeOriginalCoordinates(const Vec2d &newCoordinates, Vec2d &originalCoordinates)
@@ -152,11 +168,18 @@ void CUndistortion::UpdateMaps()
 		return;
 	}
 	
+	const char *pCacheDirectory = m_sMapCacheDirectory.empty() ? 0 : m_sMapCacheDirectory.c_str();
+	
 	if (m_pCalibrationLeft)
-		m_pUndistortionMapperLeft->Init(m_pCalibrationLeft);
+		m_pUndistortionMapperLeft->Init(m_pCalibrationLeft, pCacheDirectory);
 	
 	if (m_pCalibrationRight)
-		m_pUndistortionMapperRight->Init(m_pCalibrationRight);
+		m_pUndistortionMapperRight->Init(m_pCalibrationRight, pCacheDirectory);
+}
+
+void CUndistortion::SetMapCacheDirectory(const char *pDirectory)
+{
+	m_sMapCacheDirectory = pDirectory ? pDirectory : "";
 }
 
 
@@ -171,3 +194,14 @@ void CUndistortion::Undistort(const CByteImage * const *ppInputImages, CByteImag
 	m_pUndistortionMapperLeft->PerformMapping(ppInputImages[0], ppOutputImages[0]);
 	m_pUndistortionMapperRight->PerformMapping(ppInputImages[1], ppOutputImages[1]);
 }
+
+void CUndistortion::Undistort(const CByteImage *pBayerImage, CByteImage *pOutputImage, ImageProcessor::BayerPatternType type)
+{
+	m_pUndistortionMapperLeft->PerformMapping(pBayerImage, pOutputImage, type);
+}
+
+void CUndistortion::Undistort(const CByteImage * const *ppBayerImages, CByteImage **ppOutputImages, ImageProcessor::BayerPatternType type)
+{
+	m_pUndistortionMapperLeft->PerformMapping(ppBayerImages[0], ppOutputImages[0], type);
+	m_pUndistortionMapperRight->PerformMapping(ppBayerImages[1], ppOutputImages[1], type);
+}
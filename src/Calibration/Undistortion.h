@@ -48,6 +48,7 @@
 // ****************************************************************************
 
 #include "Image/ImageMapper.h"
+#include <string>
 
 
 // ****************************************************************************
@@ -90,8 +91,15 @@ public:
 	// use this method for re-calculating the maps (not needed for static calibrations)
 	void UpdateMaps();
 
+	// caches the maps in files in the given directory, keyed by the calibration (call before Init; pass 0 to disable)
+	void SetMapCacheDirectory(const char *pDirectory);
+
 	void Undistort(const CByteImage *pInputImage, CByteImage *pOutputImage);
 	void Undistort(const CByteImage * const *ppInputImages, CByteImage **ppOutputImages);
+
+	// Bayer pattern conversion (see ImageProcessor::ConvertBayerPattern), undistortion and, for grayscale output images, conversion to grayscale in one pass
+	void Undistort(const CByteImage *pBayerImage, CByteImage *pOutputImage, ImageProcessor::BayerPatternType type);
+	void Undistort(const CByteImage * const *ppBayerImages, CByteImage **ppOutputImages, ImageProcessor::BayerPatternType type);
 	
 	
 private:
@@ -100,7 +108,7 @@ private:
 	public:
 		CUndistortionMapper(bool bInterpolate) : CImageMapper(bInterpolate) { }
 
-		void Init(const CCalibration *pCalibration);
+		void Init(const CCalibration *pCalibration, const char *pCacheDirectory = 0);
 
 	private:
 		void ComputeOriginalCoordinates(const Vec2d &newCoordinates, Vec2d &originalCoordinates);
@@ -117,6 +125,8 @@ private:
 
 	CUndistortionMapper *m_pUndistortionMapperLeft;
 	CUndistortionMapper *m_pUndistortionMapperRight;
+
+	std::string m_sMapCacheDirectory;
 };
 
 
@@ -47,7 +47,9 @@
 
 #include "NearestNeighbor.h"
 #include "DataStructures/KdTree/KdTree.h"
+#include "DataStructures/KdTree/KdForest.h"
 #include "Helpers/OptimizedFunctions.h"
+#include "Math/VectorDistance.h"
 
 #include <string.h>
 #include <float.h>
@@ -63,12 +65,19 @@
 CNearestNeighbor::CNearestNeighbor(ComputationMethod method)
 {
 	m_pData = 0;
+	m_pDataSquaredNorms = 0;
+	m_pDataMean = 0;
+	m_pByteData = 0;
 	m_pKdTree = 0;
+	m_pKdForest = 0;
+	m_pKdForestSearchContext = 0;
+	m_nKdForestTrees = 4;
 	m_nDimension = 0;
 	m_nDataSets = 0;
 	m_nKdTreeMaxLeaves = -1;
 	m_method = method;
 	m_bTrained = false;
+	m_bTrainedWithBytes = false;
 }
 
 CNearestNeighbor::~CNearestNeighbor()
@@ -76,8 +85,23 @@ CNearestNeighbor::~CNearestNeighbor()
 	if (m_pData)
 		delete [] m_pData;
 	
+	if (m_pDataSquaredNorms)
+		delete [] m_pDataSquaredNorms;
+	
+	if (m_pDataMean)
+		delete [] m_pDataMean;
+	
+	if (m_pByteData)
+		delete [] m_pByteData;
+	
 	if (m_pKdTree)
 		delete m_pKdTree;
+	
+	if (m_pKdForest)
+		delete m_pKdForest;
+	
+	if (m_pKdForestSearchContext)
+		delete m_pKdForestSearchContext;
 
 	OPTIMIZED_FUNCTION_HEADER_0(NearestNeighbor_CleanupGPU)
 	OPTIMIZED_FUNCTION_FOOTER
@@ -99,6 +123,7 @@ bool CNearestNeighbor::Train(const float *pData, int nDimension, int nDataSets)
 	m_nDimension = nDimension;
 	m_nDataSets = nDataSets;
 	m_bTrained = false;
+	m_bTrainedWithBytes = false;
 	
 	if (m_method == eBruteForce)
 	{
@@ -108,8 +133,21 @@ bool CNearestNeighbor::Train(const float *pData, int nDimension, int nDataSets)
 		m_pData = new float[nDimension * nDataSets];
 		
 		memcpy(m_pData, pData, nDimension * nDataSets * sizeof(float));
+		
+		// needed for the blocked search in the batch version of Classify
+		if (m_pDataSquaredNorms)
+			delete [] m_pDataSquaredNorms;
+		
+		if (m_pDataMean)
+			delete [] m_pDataMean;
+		
+		m_pDataSquaredNorms = new float[nDataSets];
+		m_pDataMean = new float[nDimension];
+		
+		VectorDistance::Mean(m_pData, nDimension, nDataSets, m_pDataMean);
+		VectorDistance::SquaredNorms(m_pData, nDimension, nDataSets, m_pDataSquaredNorms, m_pDataMean);
 	}
-	else if (m_method == eKdTree)
+	else if (m_method == eKdTree || m_method == eKdForest)
 	{
 		const int nOverallDimension = nDimension + 2;
 		int i;
@@ -128,11 +166,24 @@ bool CNearestNeighbor::Train(const float *pData, int nDimension, int nDataSets)
 			memcpy(&ppValues[i][nDimension], &i, sizeof(int));
 		}
 		
-		if (m_pKdTree)
-			delete m_pKdTree;
-		
-		m_pKdTree = new CKdTree();
-		m_pKdTree->Build(ppValues, 0, nDataSets - 1, 3, nDimension, 2);
+		if (m_method == eKdTree)
+		{
+			if (m_pKdTree)
+				delete m_pKdTree;
+			
+			m_pKdTree = new CKdTree();
+			m_pKdTree->Build(ppValues, 0, nDataSets - 1, 3, nDimension, 2);
+		}
+		else
+		{
+			if (!m_pKdForest)
+			{
+				m_pKdForest = new CKdForest();
+				m_pKdForestSearchContext = new CKdTreeSearchContext();
+			}
+			
+			m_pKdForest->Build(ppValues, 0, nDataSets - 1, m_nKdForestTrees, 3, nDimension, 2);
+		}
 		
 		for (i = 0; i < nDataSets; i++)
 			delete [] ppValues[i];
@@ -167,6 +218,12 @@ int CNearestNeighbor::Classify(const float *pQuery, int nDimension, float &fResu
 	
 	if (m_method == eBruteForce)
 	{
+		if (m_bTrainedWithBytes)
+		{
+			printf("error: classifier was trained with 8 bit data in CNearestNeighbor::Classify\n");
+			return -1;
+		}
+		
 		const float *pData = m_pData;
 		
 		int best_i = -1;
@@ -207,6 +264,18 @@ int CNearestNeighbor::Classify(const float *pQuery, int nDimension, float &fResu
 		
 		return nResultIndex;
 	}
+	else if (m_method == eKdForest)
+	{
+		const float *pData;
+		
+		if (!m_pKdForest->KNearestNeighborsBBF(pQuery, 1, &fResultError, &pData, m_nKdTreeMaxLeaves, m_pKdForestSearchContext))
+			return -1;
+		
+		int nResultIndex;
+		memcpy(&nResultIndex, pData + m_nDimension, sizeof(int));
+		
+		return nResultIndex;
+	}
 	else if (m_method == eBruteForceGPU)
 	{
 		int nResult;
@@ -234,57 +303,48 @@ bool CNearestNeighbor::Classify(const float *pQueries, int nDimension, int nQuer
 	
 	if (m_method == eBruteForce)
 	{
-		const float *pQuery = pQueries;
+		if (m_bTrainedWithBytes)
+		{
+			printf("error: classifier was trained with 8 bit data in CNearestNeighbor::Classify\n");
+			return false;
+		}
+		
+		int *pIndices = new int[2 * nQueries];
+		float *pErrors = new float[2 * nQueries];
+		
+		VectorDistance::TwoNearestNeighbors(pQueries, nQueries, m_pData, m_pDataSquaredNorms, m_pDataMean, m_nDimension, m_nDataSets, pIndices, pErrors);
 		
 		for (int k = 0; k < nQueries; k++)
 		{
-			const float *pData = m_pData;
-			
-			int best_i = -1;
-			float min = FLT_MAX;
-			
-			for (int i = 0; i < m_nDataSets; i++)
-			{
-				float error = 0.0f;
-				
-				for (int j = 0; j < m_nDimension; j++)
-				{
-					register float v = pQuery[j] - pData[j];
-					error += v * v;
-				}
-				
-				if (error < min)
-				{
-					min = error;
-					best_i = i;
-				}
-				
-				pData += m_nDimension;
-			}
-			
-			pResults[k] = best_i;
-			pResultErrors[k] = min;
-			
-			pQuery += m_nDimension;
+			pResults[k] = pIndices[2 * k];
+			pResultErrors[k] = pErrors[2 * k];
 		}
 		
+		delete [] pIndices;
+		delete [] pErrors;
+		
 		return true;
 	}
-	else if (m_method == eKdTree)
+	else if (m_method == eKdTree || m_method == eKdForest)
 	{
-		const float *pQuery = pQueries;
+		// queries are distributed over the worker pool
+		const float **ppData = new const float*[nQueries];
+		
+		if (m_method == eKdTree)
+			m_pKdTree->KNearestNeighborsBBF(pQueries, nQueries, 1, pResultErrors, ppData, m_nKdTreeMaxLeaves);
+		else
+			m_pKdForest->KNearestNeighborsBBF(pQueries, nQueries, 1, pResultErrors, ppData, m_nKdTreeMaxLeaves);
 		
 		for (int k = 0; k < nQueries; k++)
 		{
-			float *pData, error;
-			m_pKdTree->NearestNeighborBBF(pQuery, error, pData, m_nKdTreeMaxLeaves);
-		
-			memcpy(pResults + k, pData + m_nDimension, sizeof(int)); // index
-			pResultErrors[k] = error;
-		
-			pQuery += m_nDimension;
+			if (ppData[k])
+				memcpy(pResults + k, ppData[k] + m_nDimension, sizeof(int)); // index
+			else
+				pResults[k] = -1;
 		}
 		
+		delete [] ppData;
+		
 		return true;
 	}
 	else if (m_method == eBruteForceGPU)
@@ -297,3 +357,261 @@ bool CNearestNeighbor::Classify(const float *pQueries, int nDimension, int nQuer
 	
 	return false; // will never happen
 }
+
+
+bool CNearestNeighbor::Classify(const float *pQueries, int nDimension, int nQueries, int *pResults, float *pResultErrors, int *pSecondResults, float *pSecondResultErrors)
+{
+	if (!m_bTrained)
+	{
+		printf("error: classifier not trained in CNearestNeighbor::Classify\n");
+		return false;
+	}
+	
+	if (m_nDimension != nDimension)
+	{
+		printf("error: query dimension and trained dimension do not match in CNearestNeighbor::Classify\n");
+		return false;
+	}
+	
+	if (m_method == eBruteForceGPU || (m_method == eBruteForce && m_bTrainedWithBytes))
+	{
+		printf("error: second nearest neighbor is not supported by the chosen method in CNearestNeighbor::Classify\n");
+		return false;
+	}
+	
+	int *pIndices = new int[2 * nQueries];
+	float *pErrors = new float[2 * nQueries];
+	int k;
+	
+	if (m_method == eBruteForce)
+	{
+		VectorDistance::TwoNearestNeighbors(pQueries, nQueries, m_pData, m_pDataSquaredNorms, m_pDataMean, m_nDimension, m_nDataSets, pIndices, pErrors);
+	}
+	else
+	{
+		const float **ppData = new const float*[2 * nQueries];
+		
+		if (m_method == eKdTree)
+			m_pKdTree->KNearestNeighborsBBF(pQueries, nQueries, 2, pErrors, ppData, m_nKdTreeMaxLeaves);
+		else
+			m_pKdForest->KNearestNeighborsBBF(pQueries, nQueries, 2, pErrors, ppData, m_nKdTreeMaxLeaves);
+		
+		for (k = 0; k < 2 * nQueries; k++)
+		{
+			if (ppData[k])
+				memcpy(pIndices + k, ppData[k] + m_nDimension, sizeof(int)); // index
+			else
+				pIndices[k] = -1;
+		}
+		
+		delete [] ppData;
+	}
+	
+	for (k = 0; k < nQueries; k++)
+	{
+		pResults[k] = pIndices[2 * k];
+		pResultErrors[k] = pErrors[2 * k];
+		pSecondResults[k] = pIndices[2 * k + 1];
+		pSecondResultErrors[k] = pErrors[2 * k + 1];
+	}
+	
+	delete [] pIndices;
+	delete [] pErrors;
+	
+	return true;
+}
+
+
+bool CNearestNeighbor::Train(const unsigned char *pData, int nDimension, int nDataSets)
+{
+	if (nDataSets < 1)
+	{
+		m_bTrained = false;
+		return false;
+	}
+	
+	if (m_method == eBruteForce)
+	{
+		m_nDimension = nDimension;
+		m_nDataSets = nDataSets;
+		
+		if (m_pByteData)
+			delete [] m_pByteData;
+		
+		m_pByteData = new unsigned char[nDimension * nDataSets];
+		
+		memcpy(m_pByteData, pData, nDimension * nDataSets);
+		
+		m_bTrained = true;
+	}
+	else if (m_method == eKdTree || m_method == eKdForest)
+	{
+		const int nValues = nDimension * nDataSets;
+		
+		float *pFloatData = new float[nValues];
+		
+		for (int i = 0; i < nValues; i++)
+			pFloatData[i] = pData[i];
+		
+		Train(pFloatData, nDimension, nDataSets);
+		
+		delete [] pFloatData;
+	}
+	else
+	{
+		printf("error: 8 bit data is not supported by the chosen method in CNearestNeighbor::Train\n");
+		m_bTrained = false;
+		return false;
+	}
+	
+	m_bTrainedWithBytes = true;
+	
+	return m_bTrained;
+}
+
+int CNearestNeighbor::Classify(const unsigned char *pQuery, int nDimension, float &fResultError)
+{
+	if (!m_bTrained || (m_method == eBruteForce && !m_bTrainedWithBytes))
+	{
+		printf("error: classifier not trained with 8 bit data in CNearestNeighbor::Classify\n");
+		return -1;
+	}
+	
+	if (m_nDimension != nDimension)
+	{
+		printf("error: query dimension and trained dimension do not match in CNearestNeighbor::Classify\n");
+		return -1;
+	}
+	
+	if (m_method == eBruteForce)
+	{
+		unsigned int nDistance;
+		const int nResult = VectorDistance::NearestNeighbor(pQuery, m_pByteData, m_nDimension, m_nDataSets, nDistance);
+		
+		fResultError = float(nDistance);
+		
+		return nResult;
+	}
+	
+	// eKdTree, eKdForest
+	float *pFloatQuery = new float[nDimension];
+	
+	for (int i = 0; i < nDimension; i++)
+		pFloatQuery[i] = pQuery[i];
+	
+	const int nResultIndex = Classify(pFloatQuery, nDimension, fResultError);
+	
+	delete [] pFloatQuery;
+	
+	return nResultIndex;
+}
+
+bool CNearestNeighbor::Classify(const unsigned char *pQueries, int nDimension, int nQueries, int *pResults, float *pResultErrors)
+{
+	if (!m_bTrained || (m_method == eBruteForce && !m_bTrainedWithBytes))
+	{
+		printf("error: classifier not trained with 8 bit data in CNearestNeighbor::Classify\n");
+		return false;
+	}
+	
+	if (m_nDimension != nDimension)
+	{
+		printf("error: query dimension and trained dimension do not match in CNearestNeighbor::Classify\n");
+		return false;
+	}
+	
+	if (m_method == eKdTree || m_method == eKdForest)
+	{
+		const int nValues = nDimension * nQueries;
+		
+		float *pFloatQueries = new float[nValues];
+		
+		for (int i = 0; i < nValues; i++)
+			pFloatQueries[i] = pQueries[i];
+		
+		const bool bResult = Classify(pFloatQueries, nDimension, nQueries, pResults, pResultErrors);
+		
+		delete [] pFloatQueries;
+		
+		return bResult;
+	}
+	
+	for (int k = 0; k < nQueries; k++)
+		pResults[k] = Classify(pQueries + k * nDimension, nDimension, pResultErrors[k]);
+	
+	return true;
+}
+
+bool CNearestNeighbor::SaveToFile(const char *pFileName) const
+{
+	if (!m_bTrained)
+	{
+		printf("error: classifier not trained in CNearestNeighbor::SaveToFile\n");
+		return false;
+	}
+	
+	if (m_method == eKdTree)
+		return m_pKdTree->SaveToFile(pFileName);
+	
+	if (m_method == eKdForest)
+		return m_pKdForest->SaveToFile(pFileName);
+	
+	printf("error: index files are only supported by eKdTree and eKdForest in CNearestNeighbor::SaveToFile\n");
+	
+	return false;
+}
+
+bool CNearestNeighbor::LoadFromFile(const char *pFileName, bool bMemoryMap)
+{
+	m_bTrained = false;
+	m_bTrainedWithBytes = false;
+	
+	int nDimension, nDataSets, nUserDataSize;
+	
+	if (m_method == eKdTree)
+	{
+		if (!m_pKdTree)
+			m_pKdTree = new CKdTree();
+		
+		if (!m_pKdTree->LoadFromFile(pFileName, bMemoryMap))
+			return false;
+		
+		nDimension = m_pKdTree->GetNumberOfDimensions();
+		nDataSets = m_pKdTree->GetNumberOfVectors();
+		nUserDataSize = m_pKdTree->GetUserDataSize();
+	}
+	else if (m_method == eKdForest)
+	{
+		if (!m_pKdForest)
+		{
+			m_pKdForest = new CKdForest();
+			m_pKdForestSearchContext = new CKdTreeSearchContext();
+		}
+		
+		if (!m_pKdForest->LoadFromFile(pFileName, bMemoryMap))
+			return false;
+		
+		nDimension = m_pKdForest->GetNumberOfDimensions();
+		nDataSets = m_pKdForest->GetNumberOfVectors();
+		nUserDataSize = m_pKdForest->GetUserDataSize();
+		m_nKdForestTrees = m_pKdForest->GetNumberOfTrees();
+	}
+	else
+	{
+		printf("error: index files are only supported by eKdTree and eKdForest in CNearestNeighbor::LoadFromFile\n");
+		return false;
+	}
+	
+	// the index stores the index of each vector as userdata (see Train)
+	if (nUserDataSize != 2)
+	{
+		printf("error: file '%s' does not contain an index of CNearestNeighbor in CNearestNeighbor::LoadFromFile\n", pFileName);
+		return false;
+	}
+	
+	m_nDimension = nDimension;
+	m_nDataSets = nDataSets;
+	m_bTrained = true;
+	
+	return true;
+}
@@ -57,6 +57,8 @@
 // ****************************************************************************
 
 class CKdTree;
+class CKdForest;
+class CKdTreeSearchContext;
 
 
 
@@ -67,6 +69,24 @@ class CKdTree;
 /*!
 	\ingroup Classificators
 	\brief Class containing different implementations of the nearest neighbor classificator.
+
+	Besides float vectors, 8 bit vectors (e.g. quantized SIFT descriptors, see CSIFTFeatureEntry::Quantize(bool)) can be used.
+	With eBruteForce, they are stored as 8 bit values and compared with the SIMD kernels from VectorDistance.
+	With eKdTree, the tree is built from float copies, which yields the same (exact) squared distances.
+	eBruteForceGPU does not support 8 bit vectors. The returned errors are squared euclidean distances.
+
+	eKdForest uses a set of randomized kd-trees (see CKdForest), which are searched with one common priority queue.
+	For high-dimensional data such as SIFT descriptors, it finds the exact nearest neighbor considerably more often
+	than eKdTree for the same maximum number of leaves to visit (SetKdTreeMaxLeaves), which applies to all trees together.
+
+	With eBruteForce, the batch version of Classify for float vectors computes the distances in cache-blocked tiles with SIMD instructions
+	(see VectorDistance::TwoNearestNeighbors), which is exact and for training sets of up to some ten thousand vectors often faster than eKdTree.
+	With eBruteForce, eKdTree and eKdForest, the batch versions of Classify distribute the queries over the worker pool of the IVT (see Threading::SetNumberOfWorkerThreads).
+	The variant returning the second nearest neighbor as well is meant for the distance ratio test of feature matching.
+
+	With eKdTree and eKdForest, the built index can be saved with SaveToFile and loaded with LoadFromFile instead of calling Train.
+	The index file contains the nodes, the permutation and the vectors with offsets only, so that it is used in place after being read
+	with one call or memory-mapped (bMemoryMap = true). Both float and 8 bit queries can be classified with a loaded index.
 */
 class CNearestNeighbor : public CClassificatorInterface
 {
@@ -75,7 +95,8 @@ public:
 	{
 		eBruteForce,
 		eKdTree,
-		eBruteForceGPU
+		eBruteForceGPU,
+		eKdForest
 	};
 	
 	// constructor
@@ -87,9 +108,19 @@ public:
 	
 	// public methods
 	void SetKdTreeMaxLeaves(int nKdTreeMaxLeaves) { m_nKdTreeMaxLeaves = nKdTreeMaxLeaves; }
+	void SetKdForestTrees(int nKdForestTrees) { m_nKdForestTrees = nKdForestTrees; } // must be called before Train
 	bool Train(const float *pData, int nDimension, int nDataSets);
 	int Classify(const float *pQuery, int nDimension, float &fResultError);
 	bool Classify(const float *pQueries, int nDimension, int nQueries, int *pResults, float *pResultErrors);
+	bool Classify(const float *pQueries, int nDimension, int nQueries, int *pResults, float *pResultErrors, int *pSecondResults, float *pSecondResultErrors);
+
+	bool Train(const unsigned char *pData, int nDimension, int nDataSets);
+	int Classify(const unsigned char *pQuery, int nDimension, float &fResultError);
+	bool Classify(const unsigned char *pQueries, int nDimension, int nQueries, int *pResults, float *pResultErrors);
+
+	// index files (eKdTree and eKdForest only)
+	bool SaveToFile(const char *pFileName) const;
+	bool LoadFromFile(const char *pFileName, bool bMemoryMap = false);
 
 
 private:
@@ -97,9 +128,16 @@ private:
 	int m_nDimension;
 	int m_nDataSets;
 	float *m_pData;
+	float *m_pDataSquaredNorms;
+	float *m_pDataMean;
+	unsigned char *m_pByteData;
 	CKdTree *m_pKdTree;
 	int m_nKdTreeMaxLeaves;
+	CKdForest *m_pKdForest;
+	CKdTreeSearchContext *m_pKdForestSearchContext;
+	int m_nKdForestTrees;
 	bool m_bTrained;
+	bool m_bTrainedWithBytes;
 	ComputationMethod m_method;
 };
 
@@ -46,100 +46,182 @@
 #include <new> // for explicitly using correct new/delete operators on VC DSPs
 
 #include "RANSAC.h"
+#include "RANSACTemplate.h"
 
 #include "Structs/Structs.h"
 #include "Math/Math2d.h"
 #include "Math/Math3d.h"
 #include "Math/LinearAlgebra.h"
+#include "Math/FixedSizeLinearAlgebra.h"
 
-#include <stdlib.h>
+#include <stdio.h>
 #include <math.h>
 
 
 
 // ****************************************************************************
-// Functions
+// Estimators
 // ****************************************************************************
 
-bool RANSAC::RANSACAffineTransformation(const CDynamicArrayTemplate<PointPair2d> &matchCandidates, CDynamicArrayTemplate<PointPair2d> &resultMatches, float fRANSACThreshold, int nIterations)
+// squared transfer error of a point pair, same as Math2d::Distance(A * p2, p1)^2
+static inline float SquaredTransferError(const Mat3d &A, const PointPair2d &pair)
 {
-	const int nMatchCandidates = matchCandidates.GetSize();
+	const Vec2d &p = pair.p2;
+	const float z_ = A.r7 * p.x + A.r8 * p.y + A.r9;
+	const float dx = (A.r1 * p.x + A.r2 * p.y + A.r3) / z_ - pair.p1.x;
+	const float dy = (A.r4 * p.x + A.r5 * p.y + A.r6) / z_ - pair.p1.y;
 	
-	if (nMatchCandidates < 3)
+	return dx * dx + dy * dy;
+}
+
+class CAffineTransformationEstimator
+{
+public:
+	typedef Mat3d Model;
+	enum { nSampleSize = 3, nModelCost = 100 };
+	
+	CAffineTransformationEstimator(const CDynamicArrayTemplate<PointPair2d> &matchCandidates, float fThreshold) :
+		m_matchCandidates(matchCandidates), m_fSquaredThreshold(fThreshold * fThreshold) { }
+	
+	int GetNumberOfData() const { return m_matchCandidates.GetSize(); }
+	
+	bool EstimateModel(const int *pSampleIndices, Mat3d &model) const
 	{
-		printf("error: at least 3 match candidates must be provided for RANSAC::RANSACAffineTransformation (%i provided)\n", nMatchCandidates);
-		return false;
+		Vec2d pFeaturesLeft[3];
+		Vec2d pFeaturesRight[3];
+		
+		for (int i = 0; i < 3; i++)
+		{
+			Math2d::SetVec(pFeaturesLeft[i], m_matchCandidates[pSampleIndices[i]].p1);
+			Math2d::SetVec(pFeaturesRight[i], m_matchCandidates[pSampleIndices[i]].p2);
+		}
+		
+		return FixedSizeLinearAlgebra::DetermineAffineTransformation<3>(pFeaturesRight, pFeaturesLeft, model);
 	}
 	
-	Mat3d best_B;
-	int i, max = 0;
+	bool IsInlier(const Mat3d &model, int nIndex) const
+	{
+		return SquaredTransferError(model, m_matchCandidates[nIndex]) < m_fSquaredThreshold;
+	}
+	
+private:
+	const CDynamicArrayTemplate<PointPair2d> &m_matchCandidates;
+	const float m_fSquaredThreshold;
+};
 
-	for (i = 0; i < nIterations; i++)
+class CHomographyEstimator
+{
+public:
+	typedef Mat3d Model;
+	enum { nSampleSize = 4, nModelCost = 250 };
+	
+	CHomographyEstimator(const CDynamicArrayTemplate<PointPair2d> &matchCandidates, float fThreshold) :
+		m_matchCandidates(matchCandidates), m_fSquaredThreshold(fThreshold * fThreshold) { }
+	
+	int GetNumberOfData() const { return m_matchCandidates.GetSize(); }
+	
+	bool EstimateModel(const int *pSampleIndices, Mat3d &model) const
 	{
-		// identify 3 different points
-		const int nFirstIndex = rand() % nMatchCandidates;
-		
-		int nTempIndex;
-		
-		do { nTempIndex = rand() % nMatchCandidates; } while (nTempIndex == nFirstIndex);
-		const int nSecondIndex = nTempIndex;
-		
-		do { nTempIndex = rand() % nMatchCandidates; } while (nTempIndex == nFirstIndex || nTempIndex == nSecondIndex);
+		Vec2d pFeaturesLeft[4];
+		Vec2d pFeaturesRight[4];
 		
-		Vec2d pFeaturesLeft[3];
-		Vec2d pFeaturesRight[3];
+		for (int i = 0; i < 4; i++)
+		{
+			Math2d::SetVec(pFeaturesLeft[i], m_matchCandidates[pSampleIndices[i]].p1);
+			Math2d::SetVec(pFeaturesRight[i], m_matchCandidates[pSampleIndices[i]].p2);
+		}
 		
-		Math2d::SetVec(pFeaturesLeft[0], matchCandidates[nFirstIndex].p1);
-		Math2d::SetVec(pFeaturesLeft[1], matchCandidates[nSecondIndex].p1);
-		Math2d::SetVec(pFeaturesLeft[2], matchCandidates[nTempIndex].p1);
+		return FixedSizeLinearAlgebra::DetermineHomography<4>(pFeaturesRight, pFeaturesLeft, model);
+	}
+	
+	bool IsInlier(const Mat3d &model, int nIndex) const
+	{
+		return SquaredTransferError(model, m_matchCandidates[nIndex]) < m_fSquaredThreshold;
+	}
+	
+private:
+	const CDynamicArrayTemplate<PointPair2d> &m_matchCandidates;
+	const float m_fSquaredThreshold;
+};
+
+struct Plane3d
+{
+	Vec3d n;
+	float c;
+};
+
+class CPlaneEstimator
+{
+public:
+	typedef Plane3d Model;
+	enum { nSampleSize = 3, nModelCost = 10 };
+	
+	CPlaneEstimator(const CVec3dArray &pointCandidates, float fThreshold) :
+		m_pointCandidates(pointCandidates), m_fThreshold(fThreshold) { }
+	
+	int GetNumberOfData() const { return m_pointCandidates.GetSize(); }
+	
+	bool EstimateModel(const int *pSampleIndices, Plane3d &model) const
+	{
+		const Vec3d &p1 = m_pointCandidates[pSampleIndices[0]];
+		const Vec3d &p2 = m_pointCandidates[pSampleIndices[1]];
+		const Vec3d &p3 = m_pointCandidates[pSampleIndices[2]];
 		
-		Math2d::SetVec(pFeaturesRight[0], matchCandidates[nFirstIndex].p2);
-		Math2d::SetVec(pFeaturesRight[1], matchCandidates[nSecondIndex].p2);
-		Math2d::SetVec(pFeaturesRight[2], matchCandidates[nTempIndex].p2);
+		Vec3d u1, u2;
+		Math3d::SubtractVecVec(p2, p1, u1);
+		Math3d::SubtractVecVec(p3, p1, u2);
+		Math3d::CrossProduct(u1, u2, model.n);
 		
-		// calculate affine transformation for these points
-		Mat3d B;
-		LinearAlgebra::DetermineAffineTransformation(pFeaturesRight, pFeaturesLeft, 3, B);
+		// collinear points do not define a plane
+		if (Math3d::Length(model.n) == 0.0f)
+			return false;
 		
-		// count support
-		int nSupport = 0;
-		for (int j = 0; j < nMatchCandidates; j++)
-		{
-			Vec2d p;
-			Math2d::ApplyHomography(B, matchCandidates[j].p2, p);
-			
-			const float distance = Math2d::Distance(p, matchCandidates[j].p1);
-			
-			if (distance < fRANSACThreshold)
-				nSupport++;
-		}
+		Math3d::NormalizeVec(model.n);
+		model.c = Math3d::ScalarProduct(model.n, p1);
 		
-		// store if it is the current maximum
-		if (nSupport > max)
-		{
-			max = nSupport;
-			Math3d::SetMat(best_B, B);
-		}
+		return true;
 	}
+	
+	bool IsInlier(const Plane3d &model, int nIndex) const
+	{
+		return fabsf(Math3d::ScalarProduct(model.n, m_pointCandidates[nIndex]) - model.c) <= m_fThreshold;
+	}
+	
+private:
+	const CVec3dArray &m_pointCandidates;
+	const float m_fThreshold;
+};
+
+
+
+// ****************************************************************************
+// Functions
+// ****************************************************************************
 
+bool RANSAC::RANSACAffineTransformation(const CDynamicArrayTemplate<PointPair2d> &matchCandidates, CDynamicArrayTemplate<PointPair2d> &resultMatches, float fRANSACThreshold, int nIterations)
+{
+	const int nMatchCandidates = matchCandidates.GetSize();
+	
+	if (nMatchCandidates < 3)
+	{
+		printf("error: at least 3 match candidates must be provided for RANSAC::RANSACAffineTransformation (%i provided)\n", nMatchCandidates);
+		return false;
+	}
+	
+	CAffineTransformationEstimator estimator(matchCandidates, fRANSACThreshold);
+	CRANSACTemplate<CAffineTransformationEstimator> ransac(estimator);
+	ransac.SetMaximumIterations(nIterations);
+	
+	Mat3d best_B;
+	
 	// filter matches
 	resultMatches.Clear();
 	
-	for (i = 0; i < nMatchCandidates; i++)
+	if (ransac.Run(best_B) > 0)
 	{
-		Vec2d p;
-		Math2d::ApplyHomography(best_B, matchCandidates[i].p2, p);
-		
-		const float distance = Math2d::Distance(p, matchCandidates[i].p1);
-		
-		if (distance < fRANSACThreshold)
-		{
-			PointPair2d match;
-			Math2d::SetVec(match.p1, matchCandidates[i].p1);
-			Math2d::SetVec(match.p2, matchCandidates[i].p2);
-			
-			resultMatches.AddElement(match);
-		}
+		for (int i = 0; i < nMatchCandidates; i++)
+			if (estimator.IsInlier(best_B, i))
+				resultMatches.AddElement(matchCandidates[i]);
 	}
 
 	return true;
@@ -155,80 +237,57 @@ bool RANSAC::RANSACHomography(const CDynamicArrayTemplate<PointPair2d> &matchCan
 		return false;
 	}
 	
+	CHomographyEstimator estimator(matchCandidates, fRANSACThreshold);
+	CRANSACTemplate<CHomographyEstimator> ransac(estimator);
+	ransac.SetMaximumIterations(nIterations);
+	
 	Mat3d best_B;
-	int i, max = 0;
 	
-	for (i = 0; i < nIterations; i++)
+	const int nSupport = ransac.Run(best_B);
+	
+	if (nSupport > 4)
 	{
-		// identify 4 different points
-		const int nFirstIndex = rand() % nMatchCandidates;
-		
-		int nTempIndex;
+		// refit to all inliers with the normalized DLT, keep the result if the support does not decrease
+		Vec2d *pFeaturesLeft = new Vec2d[nSupport];
+		Vec2d *pFeaturesRight = new Vec2d[nSupport];
+		int i, nInliers = 0;
 		
-		do { nTempIndex = rand() % nMatchCandidates; } while (nTempIndex == nFirstIndex);
-		const int nSecondIndex = nTempIndex;
-		
-		do { nTempIndex = rand() % nMatchCandidates; } while (nTempIndex == nFirstIndex || nTempIndex == nSecondIndex);
-		const int nThirdIndex = nTempIndex;
-		
-		do { nTempIndex = rand() % nMatchCandidates; } while (nTempIndex == nFirstIndex || nTempIndex == nSecondIndex || nTempIndex == nThirdIndex);
-		
-		Vec2d pFeaturesLeft[4];
-		Vec2d pFeaturesRight[4];
-		
-		Math2d::SetVec(pFeaturesLeft[0], matchCandidates[nFirstIndex].p1);
-		Math2d::SetVec(pFeaturesLeft[1], matchCandidates[nSecondIndex].p1);
-		Math2d::SetVec(pFeaturesLeft[2], matchCandidates[nThirdIndex].p1);
-		Math2d::SetVec(pFeaturesLeft[3], matchCandidates[nTempIndex].p1);
-		
-		Math2d::SetVec(pFeaturesRight[0], matchCandidates[nFirstIndex].p2);
-		Math2d::SetVec(pFeaturesRight[1], matchCandidates[nSecondIndex].p2);
-		Math2d::SetVec(pFeaturesRight[2], matchCandidates[nThirdIndex].p2);
-		Math2d::SetVec(pFeaturesRight[3], matchCandidates[nTempIndex].p1);
+		for (i = 0; i < nMatchCandidates && nInliers < nSupport; i++)
+		{
+			if (estimator.IsInlier(best_B, i))
+			{
+				Math2d::SetVec(pFeaturesLeft[nInliers], matchCandidates[i].p1);
+				Math2d::SetVec(pFeaturesRight[nInliers], matchCandidates[i].p2);
+				nInliers++;
+			}
+		}
 		
-		// calculate affine transformation for these points
 		Mat3d B;
-		LinearAlgebra::DetermineHomography(pFeaturesRight, pFeaturesLeft, 4, B, false);
 		
-		// count support
-		int nSupport = 0;
-		for (int j = 0; j < nMatchCandidates; j++)
+		if (LinearAlgebra::DetermineHomographyDLT(pFeaturesRight, pFeaturesLeft, nInliers, B))
 		{
-			Vec2d p;
-			Math2d::ApplyHomography(B, matchCandidates[j].p2, p);
+			int nRefinedSupport = 0;
 			
-			const float distance = Math2d::Distance(p, matchCandidates[j].p1);
+			for (i = 0; i < nMatchCandidates; i++)
+				if (estimator.IsInlier(B, i))
+					nRefinedSupport++;
 			
-			if (distance < fRANSACThreshold)
-				nSupport++;
+			if (nRefinedSupport >= nSupport)
+				Math3d::SetMat(best_B, B);
 		}
 		
-		// store if it is the current maximum
-		if (nSupport > max)
-		{
-			max = nSupport;
-			Math3d::SetMat(best_B, B);
-		}
+		delete [] pFeaturesLeft;
+		delete [] pFeaturesRight;
 	}
 	
 	// filter matches
 	resultMatches.Clear();
 	
-	for (i = 0; i < nMatchCandidates; i++)
+	if (nSupport > 0)
 	{
-		Vec2d p;
-		Math2d::ApplyHomography(best_B, matchCandidates[i].p2, p);
-		
-		const float distance = Math2d::Distance(p, matchCandidates[i].p1);
-		
-		if (distance < fRANSACThreshold)
-		{
-			PointPair2d match;
-			Math2d::SetVec(match.p1, matchCandidates[i].p1);
-			Math2d::SetVec(match.p2, matchCandidates[i].p2);
-			
-			resultMatches.AddElement(match);
-		}
+		for (int i = 0; i < nMatchCandidates; i++)
+			if (estimator.IsInlier(best_B, i))
+				resultMatches.AddElement(matchCandidates[i]);
 	}
 	
 	return true;
@@ -244,55 +303,20 @@ bool RANSAC::RANSAC3DPlane(const CVec3dArray &pointCandidates, CVec3dArray &resu
 		return false;
 	}
 	
-	int i, max = 0;
-	float best_c = 0.0f;
-	Vec3d best_n = { 0.0f, 0.0f };
+	CPlaneEstimator estimator(pointCandidates, fRANSACThreshold);
+	CRANSACTemplate<CPlaneEstimator> ransac(estimator);
+	ransac.SetMaximumIterations(nIterations);
 	
-	for (i = 0; i < nIterations; i++)
-	{
-		// identify 3 different points
-		const int nFirstIndex = rand() % nPointCandidates;
-		
-		int nTempIndex;
-		
-		do { nTempIndex = rand() % nPointCandidates; } while (nTempIndex == nFirstIndex);
-		const int nSecondIndex = nTempIndex;
-		
-		do { nTempIndex = rand() % nPointCandidates; } while (nTempIndex == nFirstIndex || nTempIndex == nSecondIndex);
-		
-		const Vec3d &p1 = pointCandidates[nFirstIndex];
-		const Vec3d &p2 = pointCandidates[nSecondIndex];
-		const Vec3d &p3 = pointCandidates[nTempIndex];
-		
-		Vec3d u1, u2, n;
-		Math3d::SubtractVecVec(p2, p1, u1);
-		Math3d::SubtractVecVec(p3, p1, u2);
-		Math3d::CrossProduct(u1, u2, n);
-		Math3d::NormalizeVec(n);
-		const float c = Math3d::ScalarProduct(n, p1);
-		
-		// count support
-		int nSupport = 0;
-		for (int j = 0; j < nPointCandidates; j++)
-			if (fabsf(Math3d::ScalarProduct(n, pointCandidates[j]) - c) <= fRANSACThreshold)
-				nSupport++;
-		
-		// store if it is the current maximum
-		if (nSupport > max)
-		{
-			max = nSupport;
-			Math3d::SetVec(best_n, n);
-			best_c = c;
-		}
-	}
+	Plane3d bestPlane;
 	
 	// filter points
 	resultPoints.Clear();
 	
-	for (i = 0; i < nPointCandidates; i++)
+	if (ransac.Run(bestPlane) > 0)
 	{
-		if (fabsf(Math3d::ScalarProduct(pointCandidates[i], best_n) - best_c) <= fRANSACThreshold)
-			resultPoints.AddElement(pointCandidates[i]);
+		for (int i = 0; i < nPointCandidates; i++)
+			if (estimator.IsInlier(bestPlane, i))
+				resultPoints.AddElement(pointCandidates[i]);
 	}
 	
 	return true;
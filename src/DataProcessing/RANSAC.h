@@ -61,6 +61,9 @@
 /*!
 	\ingroup DataProcessing
 	\brief Implementation of the RANSAC algorithm for specific applications/models.
+
+	The functions are based on CRANSACTemplate. nIterations is the maximum number of hypotheses,
+	the search terminates earlier once the best model has been found with a confidence of 99%.
 */
 namespace RANSAC
 {
@@ -0,0 +1,431 @@
+// ****************************************************************************
+// This file is part of the Integrating Vision Toolkit (IVT).
+//
+// The IVT is maintained by the Karlsruhe Institute of Technology (KIT)
+// (www.kit.edu) in cooperation with the company Keyetech (www.keyetech.de).
+//
+// Copyright (C) 2014 Karlsruhe Institute of Technology (KIT).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the KIT nor the names of its contributors may be
+//    used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE KIT AND CONTRIBUTORS “AS IS” AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE KIT OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ****************************************************************************
+// ****************************************************************************
+// Filename:  RANSACTemplate.h
+// Author:    agent
+// Date:      17.10.2026
+// ****************************************************************************
+
+
+#ifndef _RANSAC_TEMPLATE_H_
+#define _RANSAC_TEMPLATE_H_
+
+
+// ****************************************************************************
+// Necessary includes
+// ****************************************************************************
+
+#include <new> // for explicitly using correct new/delete operators on VC DSPs
+#include <math.h>
+
+#include "Threading/WorkerPool.h"
+
+
+
+// ****************************************************************************
+// Defines
+// ****************************************************************************
+
+// number of hypotheses generated and evaluated in one step (in parallel if the worker pool is enabled)
+#define RANSAC_BATCH_SIZE	16
+
+
+
+// ****************************************************************************
+// CRANSACTemplate
+// ****************************************************************************
+
+/*!
+	\ingroup DataProcessing
+	\brief Generic RANSAC engine with adaptive termination and early rejection of bad hypotheses.
+
+	The model specific parts are provided by the template parameter Estimator, which must offer:
+
+	\code
+	typedef ... Model;                                                  // copyable model type
+	enum { nSampleSize = ..., nModelCost = ... };                       // size of minimal samples, cost of EstimateModel in units of IsInlier calls
+	int GetNumberOfData() const;
+	bool EstimateModel(const int *pSampleIndices, Model &model) const;  // from a minimal sample, false for degenerate samples
+	bool IsInlier(const Model &model, int nIndex) const;
+	\endcode
+
+	Both EstimateModel and IsInlier are called from several threads at the same time if the worker pool is enabled.
+
+	Hypotheses are generated until the probability of having drawn at least one outlier-free sample reaches the confidence
+	(see SetConfidence(float)), given the inlier ratio of the best model found so far, or until the maximum number of iterations is reached.
+	The data are verified in a random order. The verification of a hypothesis stops as soon as it cannot reach the support of the best model anymore.
+	In addition, a sequential probability ratio test (SPRT, Chum and Matas, 2008) rejects hypotheses after a few data
+	that are unlikely to be consistent with a good model (see SetSPRT(bool)).
+
+	The random numbers are derived from the random seed and the index of the hypothesis, and the hypotheses of one step
+	are merged in the order of their indices, so that the result does not depend on the number of threads.
+*/
+template <class Estimator> class CRANSACTemplate
+{
+public:
+	typedef typename Estimator::Model Model;
+	
+	// constructor
+	CRANSACTemplate(const Estimator &estimator) : m_estimator(estimator)
+	{
+		m_nMaximumIterations = 500;
+		m_fConfidence = 0.99f;
+		m_bSPRT = true;
+		m_nRandomSeed = 0;
+		m_nHypotheses = 0;
+		m_nVerifications = 0;
+		m_pOrder = 0;
+		m_nData = 0;
+	}
+	
+	
+	// public methods
+	/*!
+		\brief Sets the maximum number of hypotheses (default: 500).
+	*/
+	void SetMaximumIterations(int nMaximumIterations) { m_nMaximumIterations = nMaximumIterations; }
+	
+	/*!
+		\brief Sets the confidence for the adaptive termination (default: 0.99). A value of 1 disables the adaptive termination.
+	*/
+	void SetConfidence(float fConfidence) { m_fConfidence = fConfidence; }
+	
+	/*!
+		\brief Enables or disables the sequential probability ratio test (default: enabled).
+	*/
+	void SetSPRT(bool bSPRT) { m_bSPRT = bSPRT; }
+	
+	/*!
+		\brief Sets the random seed (default: 0). Run() yields the same result for the same seed.
+	*/
+	void SetRandomSeed(unsigned int nRandomSeed) { m_nRandomSeed = nRandomSeed; }
+	
+	/*!
+		\brief Runs RANSAC and writes the best model to bestModel.
+
+		@return the number of inliers of the best model, 0 if no model could be estimated (bestModel is not changed in this case).
+	*/
+	int Run(Model &bestModel);
+	
+	/*!
+		\brief Returns the number of hypotheses generated by the last call of Run().
+	*/
+	int GetNumberOfHypotheses() const { return m_nHypotheses; }
+	
+	/*!
+		\brief Returns the number of calls of Estimator::IsInlier(..) in the last call of Run().
+	*/
+	int GetNumberOfVerifications() const { return m_nVerifications; }
+	
+	
+private:
+	// private structs
+	struct Hypothesis
+	{
+		Model model;
+		int nSupport;
+		int nVerified;
+		bool bValid;
+		bool bComplete;
+	};
+	
+	struct EvaluationParameters
+	{
+		const CRANSACTemplate *pRANSAC;
+		Hypothesis *pHypotheses;
+		int nFirstHypothesis;
+		int nBestSupport;
+		bool bSPRT;
+		float fLogConsistent;
+		float fLogInconsistent;
+		float fLogThreshold;
+	};
+	
+	// private methods
+	static unsigned int Hash(unsigned int x)
+	{
+		x ^= x >> 16;
+		x *= 0x7feb352du;
+		x ^= x >> 15;
+		x *= 0x846ca68bu;
+		x ^= x >> 16;
+		return x;
+	}
+	
+	static unsigned int NextRandom(unsigned int &nState)
+	{
+		// xorshift32, the state must not be 0
+		nState ^= nState << 13;
+		nState ^= nState >> 17;
+		nState ^= nState << 5;
+		return nState;
+	}
+	
+	static void EvaluateHypotheses(void *pParameter, int nFirst, int nLast)
+	{
+		const EvaluationParameters *pParameters = (const EvaluationParameters *) pParameter;
+		
+		for (int i = nFirst; i < nLast; i++)
+			pParameters->pRANSAC->EvaluateHypothesis(pParameters->nFirstHypothesis + i, *pParameters, pParameters->pHypotheses[i]);
+	}
+	
+	void EvaluateHypothesis(int nHypothesis, const EvaluationParameters &parameters, Hypothesis &hypothesis) const;
+	
+	// private attributes
+	const Estimator &m_estimator;
+	int m_nMaximumIterations;
+	float m_fConfidence;
+	bool m_bSPRT;
+	unsigned int m_nRandomSeed;
+	
+	// statistics of the last run
+	int m_nHypotheses;
+	int m_nVerifications;
+	
+	// order in which the data are verified
+	int *m_pOrder;
+	int m_nData;
+};
+
+
+
+// ****************************************************************************
+// Implementation
+// ****************************************************************************
+
+template <class Estimator> void CRANSACTemplate<Estimator>::EvaluateHypothesis(int nHypothesis, const EvaluationParameters &parameters, Hypothesis &hypothesis) const
+{
+	const int nSampleSize = Estimator::nSampleSize;
+	int pSampleIndices[Estimator::nSampleSize];
+	int i, j;
+	
+	hypothesis.nSupport = 0;
+	hypothesis.nVerified = 0;
+	hypothesis.bComplete = false;
+	
+	// draw nSampleSize different indices
+	unsigned int nState = Hash(Hash(m_nRandomSeed) ^ (unsigned int) nHypothesis) | 1u;
+	
+	for (i = 0; i < nSampleSize; i++)
+	{
+		int nIndex;
+		
+		do
+		{
+			nIndex = int(NextRandom(nState) % (unsigned int) m_nData);
+			
+			for (j = 0; j < i; j++)
+				if (pSampleIndices[j] == nIndex)
+					break;
+		}
+		while (j < i);
+		
+		pSampleIndices[i] = nIndex;
+	}
+	
+	hypothesis.bValid = m_estimator.EstimateModel(pSampleIndices, hypothesis.model);
+	
+	if (!hypothesis.bValid)
+		return;
+	
+	// verify until the support of the best model cannot be exceeded anymore
+	const int nMaximumOutliers = m_nData - parameters.nBestSupport - 1;
+	int nSupport = 0, nOutliers = 0;
+	float fLogLambda = 0.0f;
+	
+	for (i = 0; i < m_nData; i++)
+	{
+		if (m_estimator.IsInlier(hypothesis.model, m_pOrder[i]))
+		{
+			nSupport++;
+			fLogLambda += parameters.fLogConsistent;
+		}
+		else
+		{
+			if (++nOutliers > nMaximumOutliers)
+				break;
+			
+			fLogLambda += parameters.fLogInconsistent;
+			
+			// SPRT: the hypothesis is likely to be bad
+			if (parameters.bSPRT && fLogLambda > parameters.fLogThreshold)
+				break;
+		}
+	}
+	
+	hypothesis.nSupport = nSupport;
+	hypothesis.nVerified = i < m_nData ? i + 1 : m_nData;
+	hypothesis.bComplete = i == m_nData;
+}
+
+template <class Estimator> int CRANSACTemplate<Estimator>::Run(Model &bestModel)
+{
+	const int nSampleSize = Estimator::nSampleSize;
+	int i;
+	
+	m_nHypotheses = 0;
+	m_nVerifications = 0;
+	m_nData = m_estimator.GetNumberOfData();
+	
+	if (m_nData < nSampleSize || m_nMaximumIterations < 1)
+		return 0;
+	
+	// random order of the data, so that the early rejection is not affected by the order of the input
+	m_pOrder = new int[m_nData];
+	
+	unsigned int nState = Hash(m_nRandomSeed ^ 0x9e3779b9u) | 1u;
+	
+	for (i = 0; i < m_nData; i++)
+		m_pOrder[i] = i;
+	
+	for (i = m_nData - 1; i > 0; i--)
+	{
+		const int j = int(NextRandom(nState) % (unsigned int) (i + 1));
+		const int nTemp = m_pOrder[i];
+		m_pOrder[i] = m_pOrder[j];
+		m_pOrder[j] = nTemp;
+	}
+	
+	Hypothesis *pHypotheses = new Hypothesis[RANSAC_BATCH_SIZE];
+	
+	// SPRT: epsilon is the inlier ratio of good models, delta the ratio of data consistent with bad models
+	double dEpsilon = 0.1, dDelta = 0.01;
+	int nRejectedSupport = 0, nRejectedVerified = 0;
+	
+	int nBestSupport = 0;
+	int nRequiredIterations = m_nMaximumIterations;
+	
+	while (m_nHypotheses < nRequiredIterations)
+	{
+		EvaluationParameters parameters;
+		parameters.pRANSAC = this;
+		parameters.pHypotheses = pHypotheses;
+		parameters.nFirstHypothesis = m_nHypotheses;
+		parameters.nBestSupport = nBestSupport;
+		parameters.bSPRT = m_bSPRT && dEpsilon > dDelta;
+		parameters.fLogConsistent = 0.0f;
+		parameters.fLogInconsistent = 0.0f;
+		parameters.fLogThreshold = 0.0f;
+		
+		double dA = 1.0;
+		
+		if (parameters.bSPRT)
+		{
+			// decision threshold A from the costs of model estimation and verification (Chum and Matas, 2008)
+			const double C = (1.0 - dDelta) * log((1.0 - dDelta) / (1.0 - dEpsilon)) + dDelta * log(dDelta / dEpsilon);
+			const double dA0 = Estimator::nModelCost * C + 1.0;
+			
+			dA = dA0;
+			
+			for (i = 0; i < 10; i++)
+				dA = dA0 + log(dA);
+			
+			parameters.fLogConsistent = float(log(dDelta / dEpsilon));
+			parameters.fLogInconsistent = float(log((1.0 - dDelta) / (1.0 - dEpsilon)));
+			parameters.fLogThreshold = float(log(dA));
+		}
+		
+		const int nHypotheses = nRequiredIterations - m_nHypotheses < RANSAC_BATCH_SIZE ? nRequiredIterations - m_nHypotheses : RANSAC_BATCH_SIZE;
+		
+		Threading::ParallelFor(EvaluateHypotheses, &parameters, nHypotheses, 4);
+		
+		// merge in the order of the hypotheses
+		const int nPreviousBestSupport = nBestSupport;
+		
+		for (i = 0; i < nHypotheses; i++)
+		{
+			const Hypothesis &hypothesis = pHypotheses[i];
+			
+			if (!hypothesis.bValid)
+				continue;
+			
+			m_nVerifications += hypothesis.nVerified;
+			
+			if (hypothesis.bComplete && hypothesis.nSupport > nBestSupport)
+			{
+				nBestSupport = hypothesis.nSupport;
+				bestModel = hypothesis.model;
+			}
+			else if (!hypothesis.bComplete)
+			{
+				nRejectedSupport += hypothesis.nSupport;
+				nRejectedVerified += hypothesis.nVerified;
+			}
+		}
+		
+		m_nHypotheses += nHypotheses;
+		
+		// update SPRT parameters
+		if (nRejectedVerified > 0)
+		{
+			dDelta = double(nRejectedSupport) / nRejectedVerified;
+			
+			if (dDelta < 0.0001)
+				dDelta = 0.0001;
+			else if (dDelta > 0.5)
+				dDelta = 0.5;
+		}
+		
+		// update the number of required iterations
+		if (nBestSupport > nPreviousBestSupport)
+		{
+			const double dInlierRatio = double(nBestSupport) / m_nData;
+			
+			if (dInlierRatio > dEpsilon)
+				dEpsilon = dInlierRatio < 0.99 ? dInlierRatio : 0.99;
+			
+			// probability of drawing an outlier-free sample whose model is not rejected by the SPRT
+			const double P = pow(dInlierRatio, nSampleSize) * (parameters.bSPRT ? 1.0 - 1.0 / dA : 1.0);
+			
+			if (m_fConfidence < 1.0f && P > 0.0)
+			{
+				const double dRequiredIterations = P < 1.0 ? log(1.0 - m_fConfidence) / log(1.0 - P) : 1.0;
+				
+				if (dRequiredIterations < nRequiredIterations)
+					nRequiredIterations = int(ceil(dRequiredIterations));
+			}
+		}
+	}
+	
+	delete [] pHypotheses;
+	delete [] m_pOrder;
+	m_pOrder = 0;
+	
+	return nBestSupport;
+}
+
+
+
+#endif /* _RANSAC_TEMPLATE_H_ */
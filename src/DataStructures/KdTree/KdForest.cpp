@@ -0,0 +1,659 @@
+// ****************************************************************************
+// This file is part of the Integrating Vision Toolkit (IVT).
+//
+// The IVT is maintained by the Karlsruhe Institute of Technology (KIT)
+// (www.kit.edu) in cooperation with the company Keyetech (www.keyetech.de).
+//
+// Copyright (C) 2014 Karlsruhe Institute of Technology (KIT).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the KIT nor the names of its contributors may be
+//    used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE KIT AND CONTRIBUTORS “AS IS” AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE KIT OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ****************************************************************************
+// ****************************************************************************
+// Filename:  KdForest.cpp
+// Author:    agent
+// Date:      17.10.2026
+// ****************************************************************************
+
+
+// ****************************************************************************
+// Includes
+// ****************************************************************************
+
+#include <new> // for explicitly using correct new/delete operators on VC DSPs
+
+#include "KdForest.h"
+#include "KdTree.h"
+#include "KdUtils.h"
+#include "KdIndexFile.h"
+#include "KdPriorityQueue.h"
+
+#include "Threading/WorkerPool.h"
+#include "Helpers/BasicFileIO.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <float.h>
+#include <string.h>
+
+
+// ****************************************************************************
+// Defines
+// ****************************************************************************
+
+// number of vectors used for estimating the variances in a node
+#define KD_FOREST_VARIANCE_SAMPLES	100
+
+// the cut dimension is chosen randomly among this number of dimensions with highest variance
+#define KD_FOREST_CANDIDATE_DIMENSIONS	5
+
+// header of index files
+#define HEADER_KD_FOREST	"IVTKDFR1"
+
+
+
+static inline float SquaredEuclideanDistance(const float *pVector1, const float *pVector2, int nDimension)
+{
+	// four independent partial sums, so that the compiler can vectorize the loop
+	float sum0 = 0.0f, sum1 = 0.0f, sum2 = 0.0f, sum3 = 0.0f;
+	int x;
+	
+	for (x = 0; x + 3 < nDimension; x += 4)
+	{
+		const float v0 = pVector1[x] - pVector2[x];
+		const float v1 = pVector1[x + 1] - pVector2[x + 1];
+		const float v2 = pVector1[x + 2] - pVector2[x + 2];
+		const float v3 = pVector1[x + 3] - pVector2[x + 3];
+		sum0 += v0 * v0;
+		sum1 += v1 * v1;
+		sum2 += v2 * v2;
+		sum3 += v3 * v3;
+	}
+	
+	for (; x < nDimension; x++)
+	{
+		const float v = pVector1[x] - pVector2[x];
+		sum0 += v * v;
+	}
+	
+	return (sum0 + sum1) + (sum2 + sum3);
+}
+
+// linear congruential generator, each tree uses its own state
+static inline unsigned int NextRandom(unsigned int &nState)
+{
+	nState = nState * 1664525u + 1013904223u;
+	return nState >> 8;
+}
+
+// orders vector indices by one of the elements of the vectors (used for median selection)
+class CCompareIndexedElement
+{
+public:
+	CCompareIndexedElement(const float *pValues, int nTotalVectorSize, int nDimension) : m_pValues(pValues + nDimension), m_nTotalVectorSize(nTotalVectorSize) { }
+	
+	bool operator()(int nIndex1, int nIndex2) const
+	{
+		return m_pValues[nIndex1 * m_nTotalVectorSize] < m_pValues[nIndex2 * m_nTotalVectorSize];
+	}
+
+private:
+	const float *m_pValues;
+	int m_nTotalVectorSize;
+};
+
+struct KNearestNeighborsParameters
+{
+	const CKdForest *pForest;
+	const float *pQueries;
+	int k;
+	float *pfDistances;
+	const float **ppfNN;
+	int nMaximumLeavesToVisit;
+};
+
+
+
+// ****************************************************************************
+// Constructor / Destructor
+// ****************************************************************************
+
+CKdForest::CKdForest()
+{
+	m_pNodes = 0;
+	m_pIndices = 0;
+	m_pValues = 0;
+	m_EnclosingBox.pfLow = 0;
+	m_EnclosingBox.pfHigh = 0;
+	m_pFileData = 0;
+	m_nFileDataSize = 0;
+	m_bFileDataMapped = false;
+	
+	m_nNodesPerTree = 0;
+	m_nTrees = 0;
+	m_nBucketSize = 1;
+	m_nDimensions = 0;
+	m_nUserDataSize = 0;
+	m_nTotalVectorSize = 0;
+	m_nVectors = 0;
+	m_nDepth = 0;
+	m_nRandomSeed = 0;
+}
+
+CKdForest::~CKdForest()
+{
+	Dispose();
+}
+
+
+// ****************************************************************************
+// Methods
+// ****************************************************************************
+
+void CKdForest::Dispose()
+{
+	if (m_pFileData)
+	{
+		// loaded index, all arrays point into the file data
+		CBasicFileIO::FreeFileData(m_pFileData, m_nFileDataSize, m_bFileDataMapped);
+		m_pFileData = 0;
+		m_nFileDataSize = 0;
+		m_bFileDataMapped = false;
+		
+		m_pNodes = 0;
+		m_pIndices = 0;
+		m_pValues = 0;
+		m_EnclosingBox.pfLow = 0;
+		m_EnclosingBox.pfHigh = 0;
+	}
+	
+	if (m_pNodes)
+	{
+		delete [] m_pNodes;
+		m_pNodes = 0;
+	}
+	
+	if (m_pIndices)
+	{
+		delete [] m_pIndices;
+		m_pIndices = 0;
+	}
+	
+	if (m_pValues)
+	{
+		delete [] m_pValues;
+		m_pValues = 0;
+	}
+	
+	if (m_EnclosingBox.pfLow)
+	{
+		delete [] m_EnclosingBox.pfLow;
+		m_EnclosingBox.pfLow = 0;
+	}
+	
+	if (m_EnclosingBox.pfHigh)
+	{
+		delete [] m_EnclosingBox.pfHigh;
+		m_EnclosingBox.pfHigh = 0;
+	}
+	
+	m_nNodesPerTree = 0;
+	m_nTrees = 0;
+	m_nVectors = 0;
+	m_nDepth = 0;
+}
+
+void CKdForest::Build(float **ppfValues, int nLow, int nHigh, int nTrees, int nBucketSize, int nDimensions, int nUserDataSize, unsigned int nRandomSeed)
+{
+	// free previous forest
+	Dispose();
+	
+	// set members
+	m_nBucketSize = nBucketSize < 1 ? 1 : nBucketSize;
+	m_nDimensions = nDimensions;
+	m_nUserDataSize = nUserDataSize;
+	m_nTotalVectorSize = m_nDimensions + m_nUserDataSize;
+	m_nRandomSeed = nRandomSeed;
+	m_nVectors = nHigh - nLow + 1;
+	
+	if (m_nVectors <= 0 || nTrees < 1)
+	{
+		m_nVectors = 0;
+		return;
+	}
+	
+	m_nTrees = nTrees;
+	
+	// find enclosing bounding box
+	m_EnclosingBox = CalculateEnclosingBoundingBox(ppfValues + nLow, m_nDimensions, m_nVectors);
+	
+	// copy vectors
+	m_pValues = new float[m_nVectors * m_nTotalVectorSize];
+	
+	for (int i = 0; i < m_nVectors; i++)
+		memcpy(m_pValues + i * m_nTotalVectorSize, ppfValues[nLow + i], m_nTotalVectorSize * sizeof(float));
+	
+	// allocate nodes and index lists (all trees have the same structure)
+	m_nNodesPerTree = CalculateNumberOfNodes(m_nVectors);
+	m_nDepth = CalculateDepth(m_nVectors);
+	m_pNodes = new KdTreeNode[m_nTrees * m_nNodesPerTree];
+	m_pIndices = new int[m_nTrees * m_nVectors];
+	
+	// build trees
+	Threading::ParallelFor(BuildTrees, this, m_nTrees);
+}
+
+bool CKdForest::SaveToFile(const char *pFileName) const
+{
+	if (!m_pNodes)
+	{
+		printf("error: forest has not been built in CKdForest::SaveToFile\n");
+		return false;
+	}
+	
+	KdIndexData data;
+	data.nTrees = m_nTrees;
+	data.nNodesPerTree = m_nNodesPerTree;
+	data.nVectors = m_nVectors;
+	data.nDimensions = m_nDimensions;
+	data.nUserDataSize = m_nUserDataSize;
+	data.nBucketSize = m_nBucketSize;
+	data.nRandomSeed = m_nRandomSeed;
+	data.pNodes = m_pNodes;
+	data.pIndices = m_pIndices;
+	data.pValues = m_pValues;
+	data.pfLow = m_EnclosingBox.pfLow;
+	data.pfHigh = m_EnclosingBox.pfHigh;
+	
+	return KdIndexFile::Save(pFileName, HEADER_KD_FOREST, data);
+}
+
+bool CKdForest::LoadFromFile(const char *pFileName, bool bMemoryMap)
+{
+	// free previous forest
+	Dispose();
+	
+	KdIndexData data;
+	size_t nSize;
+	bool bMapped;
+	
+	unsigned char *pFileData = KdIndexFile::Load(pFileName, HEADER_KD_FOREST, bMemoryMap, data, nSize, bMapped);
+	if (!pFileData)
+		return false;
+	
+	m_nBucketSize = data.nBucketSize < 1 ? 1 : data.nBucketSize;
+	
+	// all trees have the structure given by the number of vectors and the bucket size
+	if (!data.pIndices || data.nNodesPerTree != CalculateNumberOfNodes(data.nVectors))
+	{
+		printf("error: file '%s' is corrupted\n", pFileName);
+		CBasicFileIO::FreeFileData(pFileData, nSize, bMapped);
+		return false;
+	}
+	
+	m_pFileData = pFileData;
+	m_nFileDataSize = nSize;
+	m_bFileDataMapped = bMapped;
+	
+	m_pNodes = data.pNodes;
+	m_pIndices = data.pIndices;
+	m_pValues = data.pValues;
+	m_EnclosingBox.nDimension = data.nDimensions;
+	m_EnclosingBox.pfLow = data.pfLow;
+	m_EnclosingBox.pfHigh = data.pfHigh;
+	
+	m_nTrees = data.nTrees;
+	m_nNodesPerTree = data.nNodesPerTree;
+	m_nDimensions = data.nDimensions;
+	m_nUserDataSize = data.nUserDataSize;
+	m_nTotalVectorSize = m_nDimensions + m_nUserDataSize;
+	m_nVectors = data.nVectors;
+	m_nDepth = CalculateDepth(m_nVectors);
+	m_nRandomSeed = data.nRandomSeed;
+	
+	return true;
+}
+
+int CKdForest::CalculateNumberOfNodes(int nSize) const
+{
+	if (nSize <= m_nBucketSize)
+		return 1;
+	
+	// median is element of left branch
+	const int nLeftSize = (nSize - 1) / 2 + 1;
+	
+	return 1 + CalculateNumberOfNodes(nLeftSize) + CalculateNumberOfNodes(nSize - nLeftSize);
+}
+
+int CKdForest::CalculateDepth(int nSize) const
+{
+	int nDepth = 0;
+	
+	// the left branch is never smaller than the right branch
+	while (nSize > m_nBucketSize)
+	{
+		nSize = (nSize - 1) / 2 + 1;
+		nDepth++;
+	}
+	
+	return nDepth;
+}
+
+void CKdForest::BuildTrees(void *pParameter, int nFirst, int nLast)
+{
+	CKdForest *pForest = (CKdForest *) pParameter;
+	const int nDimensions = pForest->m_nDimensions;
+	const int nVectors = pForest->m_nVectors;
+	
+	float *pBuffer = new float[4 * nDimensions];
+	
+	for (int i = nFirst; i < nLast; i++)
+	{
+		int *pIndices = pForest->m_pIndices + i * nVectors;
+		
+		for (int j = 0; j < nVectors; j++)
+			pIndices[j] = j;
+		
+		KdBoundingBox boundingBox;
+		boundingBox.nDimension = nDimensions;
+		boundingBox.pfLow = pBuffer;
+		boundingBox.pfHigh = pBuffer + nDimensions;
+		memcpy(boundingBox.pfLow, pForest->m_EnclosingBox.pfLow, nDimensions * sizeof(float));
+		memcpy(boundingBox.pfHigh, pForest->m_EnclosingBox.pfHigh, nDimensions * sizeof(float));
+		
+		BuildState state;
+		state.nRandomState = pForest->m_nRandomSeed * 2654435761u + (unsigned int) i * 40503u + 1u;
+		state.pfMean = pBuffer + 2 * nDimensions;
+		state.pfVariance = pBuffer + 3 * nDimensions;
+		
+		pForest->BuildRecursive(pIndices, 0, nVectors - 1, i * pForest->m_nNodesPerTree, &boundingBox, state);
+	}
+	
+	delete [] pBuffer;
+}
+
+void CKdForest::BuildRecursive(int *pIndices, int nLow, int nHigh, int nNode, KdBoundingBox *pCurrentBoundingBox, BuildState &state)
+{
+	KdTreeNode *pNode = m_pNodes + nNode;
+	int i, d;
+	
+	// **************************************
+	// case1: create a leaf
+	// **************************************
+	if ((nHigh - nLow) <= (m_nBucketSize - 1))
+	{
+		pNode->nCutDimension = -1;
+		pNode->nRightChild = 0;
+		pNode->nFirstValue = int(pIndices - m_pIndices) + nLow;
+		pNode->nSize = nHigh - nLow + 1;
+		pNode->fMedianValue = 0.0f;
+		pNode->bounding.fLow = 0.0f;
+		pNode->bounding.fHigh = 0.0f;
+		
+		return;
+	}
+	
+	// *********************************************
+	// case2: choose cut dimension
+	// *********************************************
+	
+	// estimate variances from the first vectors of the range
+	const int nSamples = nHigh - nLow + 1 < KD_FOREST_VARIANCE_SAMPLES ? nHigh - nLow + 1 : KD_FOREST_VARIANCE_SAMPLES;
+	
+	for (d = 0; d < m_nDimensions; d++)
+	{
+		state.pfMean[d] = 0.0f;
+		state.pfVariance[d] = 0.0f;
+	}
+	
+	for (i = 0; i < nSamples; i++)
+	{
+		const float *pValues = m_pValues + pIndices[nLow + i] * m_nTotalVectorSize;
+		
+		for (d = 0; d < m_nDimensions; d++)
+			state.pfMean[d] += pValues[d];
+	}
+	
+	for (d = 0; d < m_nDimensions; d++)
+		state.pfMean[d] /= nSamples;
+	
+	for (i = 0; i < nSamples; i++)
+	{
+		const float *pValues = m_pValues + pIndices[nLow + i] * m_nTotalVectorSize;
+		
+		for (d = 0; d < m_nDimensions; d++)
+		{
+			const float v = pValues[d] - state.pfMean[d];
+			state.pfVariance[d] += v * v;
+		}
+	}
+	
+	// find dimensions with highest variance (sorted descendingly)
+	int pCandidates[KD_FOREST_CANDIDATE_DIMENSIONS];
+	int nCandidates = 0;
+	
+	for (d = 0; d < m_nDimensions; d++)
+	{
+		const float fVariance = state.pfVariance[d];
+		
+		if (nCandidates == KD_FOREST_CANDIDATE_DIMENSIONS && fVariance <= state.pfVariance[pCandidates[nCandidates - 1]])
+			continue;
+		
+		int j = nCandidates < KD_FOREST_CANDIDATE_DIMENSIONS ? nCandidates++ : nCandidates - 1;
+		
+		for (; j > 0 && state.pfVariance[pCandidates[j - 1]] < fVariance; j--)
+			pCandidates[j] = pCandidates[j - 1];
+		
+		pCandidates[j] = d;
+	}
+	
+	const int nDimension = pCandidates[NextRandom(state.nRandomState) % nCandidates];
+	
+	// *********************************************
+	// case3: partition the set and start recursion
+	// *********************************************
+	
+	// select median in linear time and partition sets
+	const int nMedianIndex = (nHigh - nLow) / 2 + nLow;
+	std::nth_element(pIndices + nLow, pIndices + nMedianIndex, pIndices + nHigh + 1, CCompareIndexedElement(m_pValues, m_nTotalVectorSize, nDimension));
+	
+	// retrieve median value
+	const float fMedianValue = m_pValues[pIndices[nMedianIndex] * m_nTotalVectorSize + nDimension];
+	
+	// remember original boundings in dimension
+	const float fHigh = pCurrentBoundingBox->pfHigh[nDimension];
+	const float fLow = pCurrentBoundingBox->pfLow[nDimension];
+	
+	// left child follows the node, right child follows the left subtree
+	const int nLeftChild = nNode + 1;
+	const int nRightChild = nLeftChild + CalculateNumberOfNodes(nMedianIndex - nLow + 1);
+	
+	// note that median is element of left branch
+	pCurrentBoundingBox->pfHigh[nDimension] = fMedianValue;
+	BuildRecursive(pIndices, nLow, nMedianIndex, nLeftChild, pCurrentBoundingBox, state);
+	
+	pCurrentBoundingBox->pfHigh[nDimension] = fHigh;
+	pCurrentBoundingBox->pfLow[nDimension] = fMedianValue;
+	BuildRecursive(pIndices, nMedianIndex + 1, nHigh, nRightChild, pCurrentBoundingBox, state);
+	
+	pCurrentBoundingBox->pfLow[nDimension] = fLow;
+	
+	// create inner node
+	pNode->nCutDimension = nDimension;
+	pNode->fMedianValue = fMedianValue;
+	pNode->nRightChild = nRightChild;
+	pNode->nFirstValue = 0;
+	pNode->nSize = 0;
+	pNode->bounding.fLow = fLow;
+	pNode->bounding.fHigh = fHigh;
+}
+
+
+int CKdForest::KNearestNeighborsBBF(const float *pQuery, int k, float *pfDistances, const float **ppfNN, int nMaximumLeavesToVisit, CKdTreeSearchContext *pContext) const
+{
+	int i;
+	
+	for (i = 0; i < k; i++)
+	{
+		pfDistances[i] = FLT_MAX;
+		ppfNN[i] = 0;
+	}
+	
+	if (k <= 0 || !m_pNodes)
+		return 0;
+	
+	const int nNodes = m_nTrees * m_nNodesPerTree;
+	int nLeavesToVisit = nMaximumLeavesToVisit <= 0 ? nNodes : nMaximumLeavesToVisit;
+	
+	// each descent pushes at most m_nDepth nodes, so that the queue cannot overflow
+	const int nMaximumQueueSize = m_nDepth == 0 || nLeavesToVisit < (nNodes - m_nTrees) / m_nDepth ? m_nTrees + nLeavesToVisit * m_nDepth : nNodes;
+	
+	CKdTreeSearchContext localContext;
+	CKdTreeSearchContext *pSearchContext = pContext ? pContext : &localContext;
+	CKdPriorityQueue *pNodeList = pSearchContext->GetNodeList(nMaximumQueueSize);
+	
+	int nQueryIndex;
+	int *pVisitedList = pSearchContext->GetVisitedList(m_nVectors, nQueryIndex);
+	
+	int nFound = 0;
+	
+	// start at roots of all trees with distance to enclosing box
+	const float fDistanceBB = GetDistanceFromBox(m_EnclosingBox, pQuery, m_nDimensions);
+	
+	for (i = 0; i < m_nTrees; i++)
+		pNodeList->Push(fDistanceBB, (void *) (m_pNodes + i * m_nNodesPerTree));
+	
+	while (nLeavesToVisit > 0 && pNodeList->GetSize() > 0)
+	{
+		// take best node of all trees from priority queue
+		float fNodeDistanceBB;
+		void *pMeta;
+		pNodeList->Pop(fNodeDistanceBB, pMeta);
+		
+		// all remaining nodes are farther away than the k-th neighbor
+		if (nFound == k && fNodeDistanceBB > pfDistances[k - 1])
+			break;
+		
+		const KdTreeNode *pNode = (const KdTreeNode *) pMeta;
+		
+		// step down to leaf, storing the other children in the queue
+		while (pNode->nCutDimension >= 0)
+		{
+			const int nDimension = pNode->nCutDimension;
+			
+			// difference from query to cut plane
+			const float fCutDifference = pQuery[nDimension] - pNode->fMedianValue;
+			
+			if (fCutDifference < 0.0f)
+			{
+				// difference from box to point (was the old distance for this node)
+				float fBoxDifference = pNode->bounding.fLow - pQuery[nDimension];
+				
+				if (fBoxDifference < 0.0f)
+					fBoxDifference = 0.0f;
+				
+				pNodeList->Push(fNodeDistanceBB - fBoxDifference * fBoxDifference + fCutDifference * fCutDifference, (void *) (m_pNodes + pNode->nRightChild));
+				
+				pNode = pNode + 1;
+			}
+			else
+			{
+				// difference from box to point (was the old distance for this node)
+				float fBoxDifference = pQuery[nDimension] - pNode->bounding.fHigh;
+				
+				if (fBoxDifference < 0.0f)
+					fBoxDifference = 0.0f;
+				
+				pNodeList->Push(fNodeDistanceBB - fBoxDifference * fBoxDifference + fCutDifference * fCutDifference, (void *) (pNode + 1));
+				
+				pNode = m_pNodes + pNode->nRightChild;
+			}
+		}
+		
+		// go through bucket, skipping vectors already checked in other trees
+		const int *pIndices = m_pIndices + pNode->nFirstValue;
+		const int nSize = pNode->nSize;
+		
+		for (i = 0; i < nSize; i++)
+		{
+			const int nIndex = pIndices[i];
+			
+			if (pVisitedList[nIndex] == nQueryIndex)
+				continue;
+			
+			pVisitedList[nIndex] = nQueryIndex;
+			
+			const float *pValues = m_pValues + nIndex * m_nTotalVectorSize;
+			const float fDistance = SquaredEuclideanDistance(pValues, pQuery, m_nDimensions);
+			
+			if (fDistance < pfDistances[k - 1])
+			{
+				int j = nFound < k ? nFound++ : k - 1;
+				
+				for (; j > 0 && pfDistances[j - 1] > fDistance; j--)
+				{
+					pfDistances[j] = pfDistances[j - 1];
+					ppfNN[j] = ppfNN[j - 1];
+				}
+				
+				pfDistances[j] = fDistance;
+				ppfNN[j] = pValues;
+			}
+		}
+		
+		nLeavesToVisit--;
+	}
+	
+	return nFound;
+}
+
+void CKdForest::KNearestNeighborsBBFBatch(void *pParameter, int nFirst, int nLast)
+{
+	const KNearestNeighborsParameters *pParameters = (const KNearestNeighborsParameters *) pParameter;
+	const CKdForest *pForest = pParameters->pForest;
+	const int k = pParameters->k;
+	
+	CKdTreeSearchContext context;
+	
+	for (int i = nFirst; i < nLast; i++)
+	{
+		pForest->KNearestNeighborsBBF(pParameters->pQueries + i * pForest->m_nDimensions, k,
+			pParameters->pfDistances + i * k, pParameters->ppfNN + i * k, pParameters->nMaximumLeavesToVisit, &context);
+	}
+}
+
+void CKdForest::KNearestNeighborsBBF(const float *pQueries, int nQueries, int k, float *pfDistances, const float **ppfNN, int nMaximumLeavesToVisit) const
+{
+	KNearestNeighborsParameters parameters;
+	parameters.pForest = this;
+	parameters.pQueries = pQueries;
+	parameters.k = k;
+	parameters.pfDistances = pfDistances;
+	parameters.ppfNN = ppfNN;
+	parameters.nMaximumLeavesToVisit = nMaximumLeavesToVisit;
+	
+	Threading::ParallelFor(KNearestNeighborsBBFBatch, &parameters, nQueries, 16);
+}
@@ -0,0 +1,162 @@
+// ****************************************************************************
+// This file is part of the Integrating Vision Toolkit (IVT).
+//
+// The IVT is maintained by the Karlsruhe Institute of Technology (KIT)
+// (www.kit.edu) in cooperation with the company Keyetech (www.keyetech.de).
+//
+// Copyright (C) 2014 Karlsruhe Institute of Technology (KIT).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the KIT nor the names of its contributors may be
+//    used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE KIT AND CONTRIBUTORS “AS IS” AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE KIT OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ****************************************************************************
+// ****************************************************************************
+// Filename:  KdForest.h
+// Author:    agent
+// Date:      17.10.2026
+// ****************************************************************************
+
+
+#ifndef _KD_FOREST_H_
+#define _KD_FOREST_H_
+
+
+// ****************************************************************************
+// Necessary includes
+// ****************************************************************************
+
+#include "KdStructs.h"
+#include <stddef.h>
+
+
+// ****************************************************************************
+// Forward declarations
+// ****************************************************************************
+
+class CKdTreeSearchContext;
+
+
+// ****************************************************************************
+// CKdForest
+// ****************************************************************************
+
+// Set of randomized kd-trees over the same vectors.
+// In each node, the cut dimension is chosen randomly among the dimensions
+// with the highest variance, so that the trees partition the space differently.
+// A query searches all trees with one common priority queue (best bin first),
+// i.e. the maximum number of leaves to visit applies to all trees together.
+// For high-dimensional data (e.g. SIFT descriptors), this yields a
+// considerably higher probability of finding the exact nearest neighbor than
+// a single CKdTree with the same number of leaves.
+class CKdForest
+{
+public:
+	// constructor
+	CKdForest();
+	
+	// destructor
+	~CKdForest();
+	
+	
+	// build nTrees trees over ppfValues[nLow..nHigh]
+	// same conventions as CKdTree::Build (userdata in the upper elements of the
+	// vectors), but the order of ppfValues is not changed
+	// trees are built in parallel if the worker pool is enabled, the result
+	// depends only on the values and nRandomSeed
+	void Build(float **ppfValues, int nLow, int nHigh, int nTrees, int nBucketSize, int nDimensions, int nUserDataSize, unsigned int nRandomSeed = 0);
+	
+	// save the built forest to a binary index file (see KdIndexFile.h)
+	bool SaveToFile(const char *pFileName) const;
+	// load a forest saved with SaveToFile instead of building it
+	// same semantics as CKdTree::LoadFromFile
+	bool LoadFromFile(const char *pFileName, bool bMemoryMap = false);
+	
+	// k nearest neighbors with best bin first strategy over all trees
+	// same semantics as CKdTree::KNearestNeighborsBBF, each vector is returned at most once
+	int KNearestNeighborsBBF(const float *pQuery, int k, float *pfDistances, const float **ppfNN, int nMaximumLeavesToVisit = -1, CKdTreeSearchContext *pContext = 0) const;
+	
+	// batch version, queries are distributed over the worker pool
+	void KNearestNeighborsBBF(const float *pQueries, int nQueries, int k, float *pfDistances, const float **ppfNN, int nMaximumLeavesToVisit = -1) const;
+	
+	// member access
+	int GetNumberOfTrees() const { return m_nTrees; }
+	int GetNumberOfDimensions() const { return m_nDimensions; }
+	int GetNumberOfVectors() const { return m_nVectors; }
+	int GetUserDataSize() const { return m_nUserDataSize; }
+	
+
+private:
+	// state of the build process of one tree
+	struct BuildState
+	{
+		unsigned int nRandomState;
+		float *pfMean;
+		float *pfVariance;
+	};
+	
+	// private methods
+	void Dispose();
+	int CalculateNumberOfNodes(int nSize) const;
+	int CalculateDepth(int nSize) const;
+	void BuildRecursive(int *pIndices, int nLow, int nHigh, int nNode, KdBoundingBox *pCurrentBoundingBox, BuildState &state);
+	static void BuildTrees(void *pParameter, int nFirst, int nLast);
+	static void KNearestNeighborsBBFBatch(void *pParameter, int nFirst, int nLast);
+	
+	
+	// nodes of all trees in depth-first order, root of tree i is m_pNodes[i * m_nNodesPerTree]
+	KdTreeNode *m_pNodes;
+	int m_nNodesPerTree;
+	// indices of the vectors in the order of the leaves, m_nVectors per tree
+	// (KdTreeNode::nFirstValue refers to this array)
+	int *m_pIndices;
+	// all vectors in original order
+	float *m_pValues;
+	// number of trees
+	int m_nTrees;
+	// maximum bucket size in trees
+	int m_nBucketSize;
+	// number of dimensions of vectors
+	int m_nDimensions;
+	// size of userdata in vectors
+	int m_nUserDataSize;
+	// m_nDimensions + m_nUserDataSize
+	int m_nTotalVectorSize;
+	// number of vectors
+	int m_nVectors;
+	// maximum depth of a leaf
+	int m_nDepth;
+	// random seed used for building
+	unsigned int m_nRandomSeed;
+	// bounding box of all vectors
+	KdBoundingBox m_EnclosingBox;
+	// data of a loaded index file, the arrays above point into it
+	unsigned char *m_pFileData;
+	size_t m_nFileDataSize;
+	bool m_bFileDataMapped;
+};
+
+
+
+#endif // _KD_FOREST_H_
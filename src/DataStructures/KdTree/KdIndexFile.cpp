@@ -0,0 +1,344 @@
+// ****************************************************************************
+// This file is part of the Integrating Vision Toolkit (IVT).
+//
+// The IVT is maintained by the Karlsruhe Institute of Technology (KIT)
+// (www.kit.edu) in cooperation with the company Keyetech (www.keyetech.de).
+//
+// Copyright (C) 2014 Karlsruhe Institute of Technology (KIT).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the KIT nor the names of its contributors may be
+//    used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE KIT AND CONTRIBUTORS “AS IS” AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE KIT OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ****************************************************************************
+// ****************************************************************************
+// Filename:  KdIndexFile.cpp
+// Author:    agent
+// Date:      17.10.2026
+// ****************************************************************************
+
+
+// ****************************************************************************
+// Includes
+// ****************************************************************************
+
+#include <new> // for explicitly using correct new/delete operators on VC DSPs
+
+#include "KdIndexFile.h"
+
+#include "Helpers/helpers.h"
+#include "Helpers/BasicFileIO.h"
+
+#include <stdio.h>
+#include <string.h>
+
+
+
+// ****************************************************************************
+// Defines
+// ****************************************************************************
+
+#define KD_INDEX_FILE_VERSION	1
+#define KD_INDEX_FILE_ALIGNMENT	64 // alignment of the sections in bytes
+
+
+
+// ****************************************************************************
+// File format
+// ****************************************************************************
+
+/*
+	All values are stored in little-endian byte order. The sections follow the header in the given order,
+	each one starting at a multiple of KD_INDEX_FILE_ALIGNMENT bytes:
+
+	- low end of the enclosing bounding box: nDimensions floats
+	- high end of the enclosing bounding box: nDimensions floats
+	- nodes: nTrees * nNodesPerTree records of KdTreeNode (7 words), trees one after another
+	- permutation: nIndices ints (0 or nTrees * nVectors)
+	- vectors: nVectors rows of nDimensions + nUserDataSize floats
+*/
+struct KdIndexFileHeader
+{
+	char header[8];
+	unsigned int nVersion;
+	unsigned int nHeaderSize;
+	unsigned int nTrees;
+	unsigned int nNodesPerTree;
+	unsigned int nVectors;
+	unsigned int nIndices;
+	unsigned int nDimensions;
+	unsigned int nUserDataSize;
+	unsigned int nBucketSize;
+	unsigned int nRandomSeed;
+	unsigned int nChecksum; // FNV-1a of the header with nChecksum = 0
+	unsigned int reserved[3];
+};
+
+struct KdIndexFileLayout
+{
+	size_t nLowOffset;
+	size_t nHighOffset;
+	size_t nNodesOffset;
+	size_t nIndicesOffset;
+	size_t nValuesOffset;
+	size_t nSize;
+};
+
+// the nodes are stored as they are laid out in memory
+typedef char KdTreeNodeSizeCheck[sizeof(KdTreeNode) == 7 * 4 ? 1 : -1];
+typedef char KdIndexFileHeaderSizeCheck[sizeof(KdIndexFileHeader) == 64 ? 1 : -1];
+
+static size_t Align(size_t nOffset)
+{
+	return CBasicFileIO::Align(nOffset, KD_INDEX_FILE_ALIGNMENT);
+}
+
+static bool ComputeLayout(const KdIndexFileHeader &header, KdIndexFileLayout &layout)
+{
+	const double dSize = double(sizeof(KdIndexFileHeader)) + 8.0 * header.nDimensions +
+		double(sizeof(KdTreeNode)) * header.nTrees * header.nNodesPerTree + 4.0 * header.nIndices +
+		4.0 * header.nVectors * (double(header.nDimensions) + header.nUserDataSize) + 5 * KD_INDEX_FILE_ALIGNMENT;
+
+	if (dSize >= double((size_t) -1))
+		return false;
+
+	layout.nLowOffset = Align(sizeof(KdIndexFileHeader));
+	layout.nHighOffset = Align(layout.nLowOffset + 4 * size_t(header.nDimensions));
+	layout.nNodesOffset = Align(layout.nHighOffset + 4 * size_t(header.nDimensions));
+	layout.nIndicesOffset = Align(layout.nNodesOffset + sizeof(KdTreeNode) * size_t(header.nTrees) * header.nNodesPerTree);
+	layout.nValuesOffset = Align(layout.nIndicesOffset + 4 * size_t(header.nIndices));
+	layout.nSize = layout.nValuesOffset + 4 * size_t(header.nVectors) * (header.nDimensions + header.nUserDataSize);
+
+	return true;
+}
+
+static unsigned int ComputeChecksum(const KdIndexFileHeader &header)
+{
+	KdIndexFileHeader temp = header;
+	temp.nChecksum = 0;
+
+	return CBasicFileIO::ComputeChecksum(&temp, sizeof(temp));
+}
+
+static bool WriteWords(FILE *f, size_t &nOffset, const void *pData, size_t nWords)
+{
+	if (nWords == 0)
+		return true;
+
+	#ifdef IVT_BIG_ENDIAN
+	// convert a copy in chunks
+	const int *p = (const int *) pData;
+	int buffer[1024];
+
+	for (size_t i = 0; i < nWords; i += 1024)
+	{
+		const size_t n = nWords - i < 1024 ? nWords - i : 1024;
+		memcpy(buffer, p + i, n * 4);
+		CBasicFileIO::ConvertWords(buffer, n);
+
+		if (fwrite(buffer, n * 4, 1, f) != 1)
+			return false;
+	}
+	#else
+	if (fwrite(pData, nWords * 4, 1, f) != 1)
+		return false;
+	#endif
+
+	nOffset += nWords * 4;
+
+	return true;
+}
+
+// checks that all references of the nodes stay inside of the index,
+// so that no query can leave the arrays or loop
+static bool ValidateNodes(const KdIndexData &data, int nIndices)
+{
+	const int nValueRange = nIndices > 0 ? nIndices : data.nVectors;
+	
+	for (int t = 0; t < data.nTrees; t++)
+	{
+		const int nFirstNode = t * data.nNodesPerTree;
+		const int nEndNode = nFirstNode + data.nNodesPerTree;
+		
+		for (int i = nFirstNode; i < nEndNode; i++)
+		{
+			const KdTreeNode &node = data.pNodes[i];
+			
+			if (node.nCutDimension == -1)
+			{
+				if (node.nSize < 0 || node.nFirstValue < 0 || node.nFirstValue > nValueRange - node.nSize)
+					return false;
+			}
+			else
+			{
+				// the left child is the next node, the right child follows the left subtree
+				if (node.nCutDimension < 0 || node.nCutDimension >= data.nDimensions ||
+					i + 1 >= nEndNode || node.nRightChild <= i + 1 || node.nRightChild >= nEndNode)
+					return false;
+			}
+		}
+	}
+	
+	for (int i = 0; i < nIndices; i++)
+	{
+		if (data.pIndices[i] < 0 || data.pIndices[i] >= data.nVectors)
+			return false;
+	}
+	
+	return true;
+}
+
+
+
+// ****************************************************************************
+// Functions
+// ****************************************************************************
+
+bool KdIndexFile::Save(const char *pFileName, const char *pHeader, const KdIndexData &data)
+{
+	if (data.nTrees < 1 || data.nVectors < 1 || data.nNodesPerTree < 1 || data.nDimensions < 1 || data.nUserDataSize < 0)
+	{
+		printf("error: index is empty in KdIndexFile::Save\n");
+		return false;
+	}
+	
+	const int nIndices = data.pIndices ? data.nTrees * data.nVectors : 0;
+	const int nTotalVectorSize = data.nDimensions + data.nUserDataSize;
+
+	KdIndexFileHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.header, pHeader, sizeof(header.header));
+	header.nVersion = KD_INDEX_FILE_VERSION;
+	header.nHeaderSize = sizeof(KdIndexFileHeader);
+	header.nTrees = data.nTrees;
+	header.nNodesPerTree = data.nNodesPerTree;
+	header.nVectors = data.nVectors;
+	header.nIndices = nIndices;
+	header.nDimensions = data.nDimensions;
+	header.nUserDataSize = data.nUserDataSize;
+	header.nBucketSize = data.nBucketSize;
+	header.nRandomSeed = data.nRandomSeed;
+
+	KdIndexFileLayout layout;
+	if (!ComputeLayout(header, layout))
+		return false;
+	
+	CBasicFileIO::ConvertWords(&header.nVersion, (sizeof(header) - sizeof(header.header)) / 4);
+	header.nChecksum = ComputeChecksum(header);
+	CBasicFileIO::ConvertWords(&header.nChecksum, 1);
+
+	FILE *f = fopen(pFileName, "wb");
+	if (!f)
+		return false;
+
+	size_t nOffset = sizeof(header);
+	bool bSuccess = fwrite(&header, sizeof(header), 1, f) == 1;
+
+	bSuccess = bSuccess && CBasicFileIO::WritePadding(f, nOffset, layout.nLowOffset) && WriteWords(f, nOffset, data.pfLow, data.nDimensions);
+	bSuccess = bSuccess && CBasicFileIO::WritePadding(f, nOffset, layout.nHighOffset) && WriteWords(f, nOffset, data.pfHigh, data.nDimensions);
+	bSuccess = bSuccess && CBasicFileIO::WritePadding(f, nOffset, layout.nNodesOffset) && WriteWords(f, nOffset, data.pNodes, size_t(data.nTrees) * data.nNodesPerTree * (sizeof(KdTreeNode) / 4));
+	bSuccess = bSuccess && CBasicFileIO::WritePadding(f, nOffset, layout.nIndicesOffset) && WriteWords(f, nOffset, data.pIndices, nIndices);
+	bSuccess = bSuccess && CBasicFileIO::WritePadding(f, nOffset, layout.nValuesOffset) && WriteWords(f, nOffset, data.pValues, size_t(data.nVectors) * nTotalVectorSize);
+
+	fclose(f);
+
+	return bSuccess;
+}
+
+unsigned char* KdIndexFile::Load(const char *pFileName, const char *pHeader, bool bMemoryMap, KdIndexData &data, size_t &nSize, bool &bMapped)
+{
+	unsigned char *pData = CBasicFileIO::LoadFileData(pFileName, nSize, bMemoryMap, bMapped, KD_INDEX_FILE_ALIGNMENT);
+
+	if (!pData)
+	{
+		printf("error: could not read file '%s' in KdIndexFile::Load\n", pFileName);
+		return 0;
+	}
+
+	KdIndexFileHeader header;
+	
+	if (nSize < sizeof(header))
+	{
+		printf("error: file '%s' is not a valid index file\n", pFileName);
+		CBasicFileIO::FreeFileData(pData, nSize, bMapped);
+		return 0;
+	}
+	
+	memcpy(&header, pData, sizeof(header));
+	
+	if (memcmp(header.header, pHeader, sizeof(header.header)) != 0)
+	{
+		printf("error: file '%s' is not a valid index file of the requested type\n", pFileName);
+		CBasicFileIO::FreeFileData(pData, nSize, bMapped);
+		return 0;
+	}
+
+	const unsigned int nChecksum = ComputeChecksum(header);
+	CBasicFileIO::ConvertWords(&header.nVersion, (sizeof(header) - sizeof(header.header)) / 4);
+
+	KdIndexFileLayout layout;
+
+	if (header.nChecksum != nChecksum || header.nVersion != KD_INDEX_FILE_VERSION || header.nHeaderSize != sizeof(KdIndexFileHeader) ||
+		header.nTrees < 1 || header.nVectors < 1 || header.nNodesPerTree < 1 || header.nDimensions < 1 ||
+		header.nTrees > 0x7fffffff || header.nVectors > 0x7fffffff || header.nNodesPerTree > 0x7fffffff ||
+		header.nDimensions > 0x7fffffff || header.nUserDataSize > 0x7fffffff || header.nBucketSize > 0x7fffffff || header.nIndices > 0x7fffffff ||
+		double(header.nTrees) * header.nNodesPerTree > 2147483647.0 ||
+		double(header.nVectors) * (double(header.nDimensions) + header.nUserDataSize) > 2147483647.0 ||
+		(header.nIndices != 0 && double(header.nIndices) != double(header.nTrees) * header.nVectors) ||
+		!ComputeLayout(header, layout) || layout.nSize > nSize)
+	{
+		printf("error: file '%s' is corrupted\n", pFileName);
+		CBasicFileIO::FreeFileData(pData, nSize, bMapped);
+		return 0;
+	}
+
+	data.nTrees = header.nTrees;
+	data.nNodesPerTree = header.nNodesPerTree;
+	data.nVectors = header.nVectors;
+	data.nDimensions = header.nDimensions;
+	data.nUserDataSize = header.nUserDataSize;
+	data.nBucketSize = header.nBucketSize;
+	data.nRandomSeed = header.nRandomSeed;
+	data.pfLow = (float *) (pData + layout.nLowOffset);
+	data.pfHigh = (float *) (pData + layout.nHighOffset);
+	data.pNodes = (KdTreeNode *) (pData + layout.nNodesOffset);
+	data.pIndices = header.nIndices ? (int *) (pData + layout.nIndicesOffset) : 0;
+	data.pValues = (float *) (pData + layout.nValuesOffset);
+
+	// all sections are stored in little-endian byte order (the data is a private copy)
+	CBasicFileIO::ConvertWords(data.pfLow, data.nDimensions);
+	CBasicFileIO::ConvertWords(data.pfHigh, data.nDimensions);
+	CBasicFileIO::ConvertWords(data.pNodes, size_t(data.nTrees) * data.nNodesPerTree * (sizeof(KdTreeNode) / 4));
+	CBasicFileIO::ConvertWords(data.pIndices, header.nIndices);
+	CBasicFileIO::ConvertWords(data.pValues, size_t(data.nVectors) * (data.nDimensions + data.nUserDataSize));
+
+	if (!ValidateNodes(data, header.nIndices))
+	{
+		printf("error: file '%s' is corrupted\n", pFileName);
+		CBasicFileIO::FreeFileData(pData, nSize, bMapped);
+		return 0;
+	}
+
+	return pData;
+}
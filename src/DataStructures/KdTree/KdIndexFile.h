@@ -0,0 +1,106 @@
+// ****************************************************************************
+// This file is part of the Integrating Vision Toolkit (IVT).
+//
+// The IVT is maintained by the Karlsruhe Institute of Technology (KIT)
+// (www.kit.edu) in cooperation with the company Keyetech (www.keyetech.de).
+//
+// Copyright (C) 2014 Karlsruhe Institute of Technology (KIT).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the KIT nor the names of its contributors may be
+//    used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE KIT AND CONTRIBUTORS “AS IS” AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE KIT OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ****************************************************************************
+// ****************************************************************************
+// Filename:  KdIndexFile.h
+// Author:    agent
+// Date:      17.10.2026
+// ****************************************************************************
+
+
+#ifndef _KD_INDEX_FILE_H_
+#define _KD_INDEX_FILE_H_
+
+
+// ****************************************************************************
+// Necessary includes
+// ****************************************************************************
+
+#include "KdStructs.h"
+#include <stddef.h>
+
+
+
+// ****************************************************************************
+// KdIndexData
+// ****************************************************************************
+
+// description of a built CKdTree or CKdForest as stored in an index file
+// (a CKdTree is stored as a single tree without permutation)
+struct KdIndexData
+{
+	int nTrees;
+	int nNodesPerTree;
+	int nVectors;
+	int nDimensions;
+	int nUserDataSize;
+	int nBucketSize;
+	unsigned int nRandomSeed;
+	
+	// nTrees * nNodesPerTree nodes
+	KdTreeNode *pNodes;
+	// nTrees * nVectors indices or 0
+	int *pIndices;
+	// nVectors * (nDimensions + nUserDataSize) floats
+	float *pValues;
+	// enclosing bounding box, nDimensions floats each
+	float *pfLow;
+	float *pfHigh;
+};
+
+
+
+// ****************************************************************************
+// KdIndexFile
+// ****************************************************************************
+
+// Binary index files for CKdTree and CKdForest.
+// The file is a fixed header followed by the box, the node array, the
+// permutation and the vector block, each section starting at a multiple of
+// 64 bytes. Nodes refer to each other and to the vectors by indices only, so
+// that a loaded (or memory-mapped) file is used directly without relocation.
+namespace KdIndexFile
+{
+	// pHeader identifies the index type (8 characters)
+	bool Save(const char *pFileName, const char *pHeader, const KdIndexData &data);
+	
+	// loads and validates a file written by Save
+	// on success, returns the file data (free with CBasicFileIO::FreeFileData)
+	// and sets the pointers in data to the sections inside of it
+	unsigned char* Load(const char *pFileName, const char *pHeader, bool bMemoryMap, KdIndexData &data, size_t &nSize, bool &bMapped);
+}
+
+
+
+#endif // _KD_INDEX_FILE_H_
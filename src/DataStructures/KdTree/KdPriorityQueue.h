@@ -96,13 +96,15 @@ public:
 	
 	inline void Push(float fValue, void* pMeta)
 	{
-		// check for oveflow
-		if (++m_nSize > m_nMaxSize) 
+		// check for oveflow (element is dropped)
+		if (m_nSize == m_nMaxSize) 
 		{
 			//printf("CKdPriorityQueue: Overflow!!\n");
 			return;
 		}
 		
+		m_nSize++;
+		
 		register int nPos = m_nSize;
 		
 		while (nPos > 1) {
@@ -67,5 +67,26 @@ struct KdBoundingBox
 };
 
 
+// node of a kd-tree, stored in a contiguous array in depth-first order
+// (the left child of an inner node is the node directly following it)
+struct KdTreeNode
+{
+	// value of median in cut dimension (inner nodes)
+	float fMedianValue;
+	
+	// bounding in cut dimension (BBF)
+	KdBounding bounding;
+	
+	// cut dimension, -1 for leaves
+	int nCutDimension;
+	
+	// index of right child in node array (inner nodes)
+	int nRightChild;
+	
+	// index of first vector in value block and number of vectors (leaves)
+	int nFirstValue;
+	int nSize;
+};
+
 
 #endif /* _KD_STRUCTS_H_ */
@@ -47,30 +47,86 @@
 
 #include "KdTree.h"
 #include "KdUtils.h"
+#include "KdIndexFile.h"
 #include "KdPriorityQueue.h"
 
-#include "Helpers/Quicksort.h"
+#include "Threading/WorkerPool.h"
 #include "Helpers/BasicFileIO.h"
 
+#include <algorithm>
 #include <stdio.h>
 #include <float.h>
 #include <string.h>
 
 
+// ****************************************************************************
+// Defines
+// ****************************************************************************
+
+// header of index files
+#define HEADER_KD_TREE	"IVTKDTR1"
+
+
 
 static inline float SquaredEuclideanDistance(const float *pVector1, const float *pVector2, int nDimension)
 {
-	register float sum = 0.0f;
+	// four independent partial sums, so that the compiler can vectorize the loop
+	float sum0 = 0.0f, sum1 = 0.0f, sum2 = 0.0f, sum3 = 0.0f;
+	int x;
 	
-	for (register int x = 0; x < nDimension; x++)
+	for (x = 0; x + 3 < nDimension; x += 4)
+	{
+		const float v0 = pVector1[x] - pVector2[x];
+		const float v1 = pVector1[x + 1] - pVector2[x + 1];
+		const float v2 = pVector1[x + 2] - pVector2[x + 2];
+		const float v3 = pVector1[x + 3] - pVector2[x + 3];
+		sum0 += v0 * v0;
+		sum1 += v1 * v1;
+		sum2 += v2 * v2;
+		sum3 += v3 * v3;
+	}
+	
+	for (; x < nDimension; x++)
 	{
 		const float v = pVector1[x] - pVector2[x];
-		sum += v * v;
+		sum0 += v * v;
 	}
 	
-	return sum;
+	return (sum0 + sum1) + (sum2 + sum3);
 }
 
+// orders vectors by one of their elements (used for median selection)
+class CCompareElement
+{
+public:
+	CCompareElement(int nDimension) : m_nDimension(nDimension) { }
+	
+	bool operator()(const float *pVector1, const float *pVector2) const
+	{
+		return pVector1[m_nDimension] < pVector2[m_nDimension];
+	}
+
+private:
+	int m_nDimension;
+};
+
+struct BuildParameters
+{
+	CKdTree *pTree;
+	float **ppfValues;
+	void *pTasks;
+};
+
+struct KNearestNeighborsParameters
+{
+	const CKdTree *pTree;
+	const float *pQueries;
+	int k;
+	float *pfDistances;
+	const float **ppfNN;
+	int nMaximumLeavesToVisit;
+};
+
 static inline float CrossCorrelation(const float *pVector1, const float *pVector2, int nDimension)
 {
 	register float sum = 0.0f;
@@ -83,6 +139,70 @@ static inline float CrossCorrelation(const float *pVector1, const float *pVector
 
 
 
+// ****************************************************************************
+// CKdTreeSearchContext
+// ****************************************************************************
+
+CKdTreeSearchContext::CKdTreeSearchContext()
+{
+	m_pNodeList = 0;
+	m_nMaximumSize = 0;
+	
+	m_pVisitedList = 0;
+	m_nVisitedListSize = 0;
+	m_nQueryIndex = 0;
+}
+
+CKdTreeSearchContext::~CKdTreeSearchContext()
+{
+	if (m_pNodeList)
+		delete m_pNodeList;
+	
+	if (m_pVisitedList)
+		delete [] m_pVisitedList;
+}
+
+int* CKdTreeSearchContext::GetVisitedList(int nVectors, int &nQueryIndex)
+{
+	if (nVectors > m_nVisitedListSize || m_nQueryIndex == 0x7fffffff)
+	{
+		if (nVectors > m_nVisitedListSize)
+		{
+			if (m_pVisitedList)
+				delete [] m_pVisitedList;
+			
+			m_pVisitedList = new int[nVectors];
+			m_nVisitedListSize = nVectors;
+		}
+		
+		memset(m_pVisitedList, 0, m_nVisitedListSize * sizeof(int));
+		m_nQueryIndex = 0;
+	}
+	
+	// vectors with m_pVisitedList[i] == nQueryIndex have been visited in this query
+	nQueryIndex = ++m_nQueryIndex;
+	
+	return m_pVisitedList;
+}
+
+CKdPriorityQueue* CKdTreeSearchContext::GetNodeList(int nMaximumSize)
+{
+	if (nMaximumSize > m_nMaximumSize)
+	{
+		if (m_pNodeList)
+			delete m_pNodeList;
+		
+		m_pNodeList = new CKdPriorityQueue(nMaximumSize);
+		m_nMaximumSize = nMaximumSize;
+	}
+	
+	m_pNodeList->Empty();
+	
+	return m_pNodeList;
+}
+
+
+
 // ****************************************************************************
 // Constructor / Destructor
 // ****************************************************************************
@@ -90,9 +210,13 @@ static inline float CrossCorrelation(const float *pVector1, const float *pVector
 CKdTree::CKdTree(int nMaximumNumberOfNodes)
 {
 	// init pointers
-	m_pRoot = 0;
+	m_pNodes = 0;
+	m_pValues = 0;
 	m_EnclosingBox.pfLow = 0;
 	m_EnclosingBox.pfHigh = 0;
+	m_pFileData = 0;
+	m_nFileDataSize = 0;
+	m_bFileDataMapped = false;
 	
 	// create priority list for BFF search
 	m_pNodeListBBF = new CKdPriorityQueue(nMaximumNumberOfNodes);
@@ -101,8 +225,11 @@ CKdTree::CKdTree(int nMaximumNumberOfNodes)
 	m_pNearestNeighborList_ = new CKdPriorityQueue(nMaximumNumberOfNodes);
 	m_pNearestNeighborList = 0;
 	
+	m_nNodes = 0;
+	m_nDepth = 0;
 	m_nLeaves = 0;
 	m_nMaximumLeavesToVisit = 0;
+	m_nParallelBuildDepth = -1;
 }
 
 CKdTree::~CKdTree()
@@ -121,73 +248,252 @@ CKdTree::~CKdTree()
 
 void CKdTree::Build(float **ppfValues, int nLow, int nHigh, int nBucketSize, int nDimensions, int nUserDataSize)
 {
+	// free previous tree
+	Dispose();
+	
 	// set members
-	m_nBucketSize =	nBucketSize;
+	m_nBucketSize =	nBucketSize < 1 ? 1 : nBucketSize;
 	m_nDimensions =	nDimensions;
     m_nUserDataSize = nUserDataSize;
 	m_nTotalVectorSize = m_nDimensions + m_nUserDataSize;
 	m_nLeaves = nHigh - nLow + 1;
 	
+	if (m_nLeaves <= 0)
+	{
+		m_nLeaves = 0;
+		return;
+	}
+	
 	// find enclosing bounding box
-	m_EnclosingBox = CalculateEnclosingBoundingBox(ppfValues, m_nDimensions, m_nLeaves);
+	m_EnclosingBox = CalculateEnclosingBoundingBox(ppfValues + nLow, m_nDimensions, m_nLeaves);
+	
+	// allocate nodes and value block
+	m_nNodes = CalculateNumberOfNodes(m_nLeaves);
+	m_nDepth = CalculateDepth(m_nLeaves);
+	m_pNodes = new KdTreeNode[m_nNodes];
+	m_pValues = new float[m_nLeaves * m_nTotalVectorSize];
+	
+	// split the tree into about four subtrees per thread
+	const int nThreads = Threading::GetNumberOfWorkerThreads();
+	
+	m_nParallelBuildDepth = -1;
+	
+	if (nThreads > 1 && m_nLeaves >= 8 * m_nBucketSize * nThreads)
+	{
+		m_nParallelBuildDepth = 0;
+		
+		while ((1 << m_nParallelBuildDepth) < 4 * nThreads)
+			m_nParallelBuildDepth++;
+	}
+	
+	// build top of the tree
+	std::vector<BuildTask> tasks;
+	BuildRecursive(ppfValues, nLow, nHigh, 0, &m_EnclosingBox, 0, &tasks);
+	
+	// build subtrees
+	if (!tasks.empty())
+	{
+		BuildParameters parameters;
+		parameters.pTree = this;
+		parameters.ppfValues = ppfValues;
+		parameters.pTasks = &tasks;
+		
+		Threading::ParallelFor(BuildSubtrees, &parameters, (int) tasks.size());
+		
+		for (int i = 0; i < (int) tasks.size(); i++)
+			delete [] tasks[i].pfLow;
+	}
+	
+	// copy vectors in the order of the leaves
+	float *pValues = m_pValues;
+	
+	for (int i = nLow; i <= nHigh; i++, pValues += m_nTotalVectorSize)
+		memcpy(pValues, ppfValues[i], m_nTotalVectorSize * sizeof(float));
+	
+	for (int i = 0; i < m_nNodes; i++)
+	{
+		if (m_pNodes[i].nCutDimension < 0)
+			m_pNodes[i].nFirstValue -= nLow;
+	}
+	
+	m_nParallelBuildDepth = -1;
+}
+
+bool CKdTree::SaveToFile(const char *pFileName) const
+{
+	if (!m_pNodes)
+	{
+		printf("error: tree has not been built in CKdTree::SaveToFile\n");
+		return false;
+	}
+	
+	KdIndexData data;
+	data.nTrees = 1;
+	data.nNodesPerTree = m_nNodes;
+	data.nVectors = m_nLeaves;
+	data.nDimensions = m_nDimensions;
+	data.nUserDataSize = m_nUserDataSize;
+	data.nBucketSize = m_nBucketSize;
+	data.nRandomSeed = 0;
+	data.pNodes = m_pNodes;
+	data.pIndices = 0;
+	data.pValues = m_pValues;
+	data.pfLow = m_EnclosingBox.pfLow;
+	data.pfHigh = m_EnclosingBox.pfHigh;
+	
+	return KdIndexFile::Save(pFileName, HEADER_KD_TREE, data);
+}
+
+bool CKdTree::LoadFromFile(const char *pFileName, bool bMemoryMap)
+{
+	// free previous tree
+	Dispose();
+	
+	KdIndexData data;
+	size_t nSize;
+	bool bMapped;
+	
+	unsigned char *pFileData = KdIndexFile::Load(pFileName, HEADER_KD_TREE, bMemoryMap, data, nSize, bMapped);
+	if (!pFileData)
+		return false;
+	
+	m_nBucketSize = data.nBucketSize < 1 ? 1 : data.nBucketSize;
+	
+	// the structure of the tree is given by the number of vectors and the bucket size
+	if (data.nTrees != 1 || data.pIndices || data.nNodesPerTree != CalculateNumberOfNodes(data.nVectors))
+	{
+		printf("error: file '%s' is corrupted\n", pFileName);
+		CBasicFileIO::FreeFileData(pFileData, nSize, bMapped);
+		return false;
+	}
+	
+	m_pFileData = pFileData;
+	m_nFileDataSize = nSize;
+	m_bFileDataMapped = bMapped;
+	
+	m_pNodes = data.pNodes;
+	m_pValues = data.pValues;
+	m_EnclosingBox.nDimension = data.nDimensions;
+	m_EnclosingBox.pfLow = data.pfLow;
+	m_EnclosingBox.pfHigh = data.pfHigh;
+	
+	m_nNodes = data.nNodesPerTree;
+	m_nDimensions = data.nDimensions;
+	m_nUserDataSize = data.nUserDataSize;
+	m_nTotalVectorSize = m_nDimensions + m_nUserDataSize;
+	m_nLeaves = data.nVectors;
+	m_nDepth = CalculateDepth(m_nLeaves);
+	
+	return true;
+}
+
+int CKdTree::CalculateNumberOfNodes(int nSize) const
+{
+	if (nSize <= m_nBucketSize)
+		return 1;
+	
+	// median is element of left branch
+	const int nLeftSize = (nSize - 1) / 2 + 1;
+	
+	return 1 + CalculateNumberOfNodes(nLeftSize) + CalculateNumberOfNodes(nSize - nLeftSize);
+}
+
+int CKdTree::CalculateDepth(int nSize) const
+{
+	int nDepth = 0;
+	
+	// the left branch is never smaller than the right branch
+	while (nSize > m_nBucketSize)
+	{
+		nSize = (nSize - 1) / 2 + 1;
+		nDepth++;
+	}
 	
-	// init members for recursion
-	m_pRoot = BuildRecursive(ppfValues, nLow, nHigh, &m_EnclosingBox, 0);
+	return nDepth;
+}
+
+void CKdTree::BuildSubtrees(void *pParameter, int nFirst, int nLast)
+{
+	const BuildParameters *pParameters = (const BuildParameters *) pParameter;
+	CKdTree *pTree = pParameters->pTree;
+	std::vector<BuildTask> &tasks = *(std::vector<BuildTask> *) pParameters->pTasks;
+	
+	for (int i = nFirst; i < nLast; i++)
+	{
+		KdBoundingBox boundingBox;
+		boundingBox.nDimension = pTree->m_nDimensions;
+		boundingBox.pfLow = tasks[i].pfLow;
+		boundingBox.pfHigh = tasks[i].pfHigh;
+		
+		pTree->BuildRecursive(pParameters->ppfValues, tasks[i].nLow, tasks[i].nHigh, tasks[i].nNode, &boundingBox, tasks[i].nDepth, 0);
+	}
 }
 
-CKdTreeNode* CKdTree::BuildRecursive(float **ppfValues,int nLow, int nHigh, KdBoundingBox* pCurrentBoundingBox, int nCurrentDepth)
+void CKdTree::BuildRecursive(float **ppfValues, int nLow, int nHigh, int nNode, KdBoundingBox *pCurrentBoundingBox, int nCurrentDepth, std::vector<BuildTask> *pTasks)
 {
+	KdTreeNode *pNode = m_pNodes + nNode;
+	
 	// **************************************
 	// case1: create a leaf
 	// **************************************
 	if ((nHigh-nLow) <= (m_nBucketSize - 1))
 	{
-		// create leaf
-		CKdTreeNode* pNewNode = new CKdTreeNode();
+		const int nDimension = nCurrentDepth % m_nDimensions;
 		
-		pNewNode->m_bIsLeaf = 1;
+		// vectors are copied to the value block after the build
+		pNode->nCutDimension = -1;
+		pNode->nRightChild = 0;
+		pNode->nFirstValue = nLow;
+		pNode->nSize = nHigh - nLow + 1;
+		pNode->fMedianValue = 0.0f;
+		pNode->bounding.fLow = pCurrentBoundingBox->pfLow[nDimension];
+		pNode->bounding.fHigh = pCurrentBoundingBox->pfHigh[nDimension];
 		
-		// create and fill bucket
-		const int nSize = nHigh - nLow + 1;
-				
-		pNewNode->m_pValues = new float[nSize * m_nTotalVectorSize];
-		pNewNode->m_nSize = nSize;
-		
-		float *pValues = pNewNode->m_pValues;
-		
-		for (int n = 0 ; n <  nSize; n++)
-		{
-			for (int d = 0; d < m_nTotalVectorSize; d++)
-				pValues[d] = ppfValues[nLow + n][d];
-			
-			pValues += m_nTotalVectorSize;
-		}
+		return;
+	}
+	
+	// *********************************************
+	// case2: leave subtree to a parallel task
+	// *********************************************
+	if (pTasks && nCurrentDepth == m_nParallelBuildDepth)
+	{
+		BuildTask task;
+		task.nLow = nLow;
+		task.nHigh = nHigh;
+		task.nNode = nNode;
+		task.nDepth = nCurrentDepth;
+		task.pfLow = new float[2 * m_nDimensions];
+		task.pfHigh = task.pfLow + m_nDimensions;
+		memcpy(task.pfLow, pCurrentBoundingBox->pfLow, m_nDimensions * sizeof(float));
+		memcpy(task.pfHigh, pCurrentBoundingBox->pfHigh, m_nDimensions * sizeof(float));
 		
-		pNewNode->m_nCutDimension = nCurrentDepth % m_nDimensions;
-		pNewNode->m_Bounding.fLow = pCurrentBoundingBox->pfLow[pNewNode->m_nCutDimension];
-		pNewNode->m_Bounding.fHigh = pCurrentBoundingBox->pfHigh[pNewNode->m_nCutDimension];
+		pTasks->push_back(task);
 		
-		return pNewNode;
-	} 
+		return;
+	}
 
 	
 	// *********************************************
-	// case2: partition the set and start recursion
+	// case3: partition the set and start recursion
 	// *********************************************
 	
 	const int nDimension = nCurrentDepth % m_nDimensions;
 	
-	// Quicksort array to find median and patition sets
-	Quicksort::QuicksortByElementOfVector(ppfValues, nLow, nHigh, nDimension);
+	// select median in linear time and partition sets
+	const int nMedianIndex = (nHigh - nLow) / 2 + nLow;
+	std::nth_element(ppfValues + nLow, ppfValues + nMedianIndex, ppfValues + nHigh + 1, CCompareElement(nDimension));
 	
 	// retrieve median value
-	const int nMedianIndex = (nHigh - nLow) / 2 + nLow;
 	const float fMedianValue = ppfValues[nMedianIndex][nDimension];
 	
 	// remember original boundings in dimension
 	const float fHigh = pCurrentBoundingBox->pfHigh[nDimension];
 	const float fLow = pCurrentBoundingBox->pfLow[nDimension];
 	
+	// left child follows the node, right child follows the left subtree
+	const int nLeftChild = nNode + 1;
+	const int nRightChild = nLeftChild + CalculateNumberOfNodes(nMedianIndex - nLow + 1);
+	
 	// *********************************************
 	// start next recursion
 	// *********************************************
@@ -196,63 +502,77 @@ CKdTreeNode* CKdTree::BuildRecursive(float **ppfValues,int nLow, int nHigh, KdBo
 	pCurrentBoundingBox->pfHigh[nDimension] = fMedianValue;
 	
 	// create left node
-	CKdTreeNode* pNodeLeft = BuildRecursive(ppfValues, nLow, nMedianIndex, pCurrentBoundingBox, nCurrentDepth + 1);
+	BuildRecursive(ppfValues, nLow, nMedianIndex, nLeftChild, pCurrentBoundingBox, nCurrentDepth + 1, pTasks);
 	
 	// adjust bounding box to mirror higher part of interval
 	pCurrentBoundingBox->pfHigh[nDimension] = fHigh;
 	pCurrentBoundingBox->pfLow[nDimension] = fMedianValue;
 	
 	// create right node
-	CKdTreeNode* pNodeRight = BuildRecursive(ppfValues, nMedianIndex+1, nHigh, pCurrentBoundingBox, nCurrentDepth + 1);
+	BuildRecursive(ppfValues, nMedianIndex + 1, nHigh, nRightChild, pCurrentBoundingBox, nCurrentDepth + 1, pTasks);
 	
 	// readjust bounding box
 	pCurrentBoundingBox->pfLow[nDimension] = fLow;
 	
 	// *********************************************
-	// create inner nodes
+	// create inner node
 	// *********************************************
-	CKdTreeNode* pNewNode = new CKdTreeNode();
 	// set cut dimension
-	pNewNode->m_nCutDimension = nCurrentDepth % m_nDimensions;
+	pNode->nCutDimension = nDimension;
 	// set value of median
-	pNewNode->m_fMedianValue = fMedianValue;
-	// set children
-	pNewNode->m_pLeftChild = pNodeLeft;
-	pNewNode->m_pRightChild = pNodeRight;
+	pNode->fMedianValue = fMedianValue;
+	// set right child (left child is next node)
+	pNode->nRightChild = nRightChild;
+	pNode->nFirstValue = 0;
+	pNode->nSize = 0;
 	// set boundings in dimension
-	pNewNode->m_Bounding.fLow = pCurrentBoundingBox->pfLow[pNewNode->m_nCutDimension];
-	pNewNode->m_Bounding.fHigh = pCurrentBoundingBox->pfHigh[pNewNode->m_nCutDimension];
-	// this is no leaf!
-	pNewNode->m_bIsLeaf = 0;
-	
-	return pNewNode;
+	pNode->bounding.fLow = fLow;
+	pNode->bounding.fHigh = fHigh;
 }
 
 void CKdTree::Dispose()
 {
-	if (m_pRoot)
-		DisposeRecursive(m_pRoot);
+	if (m_pFileData)
+	{
+		// loaded index, all arrays point into the file data
+		CBasicFileIO::FreeFileData(m_pFileData, m_nFileDataSize, m_bFileDataMapped);
+		m_pFileData = 0;
+		m_nFileDataSize = 0;
+		m_bFileDataMapped = false;
+		
+		m_pNodes = 0;
+		m_pValues = 0;
+		m_EnclosingBox.pfLow = 0;
+		m_EnclosingBox.pfHigh = 0;
+	}
+	
+	if (m_pNodes)
+	{
+		delete [] m_pNodes;
+		m_pNodes = 0;
+	}
+	
+	if (m_pValues)
+	{
+		delete [] m_pValues;
+		m_pValues = 0;
+	}
 		
 	if (m_EnclosingBox.pfLow)
+	{
 		delete [] m_EnclosingBox.pfLow;
+		m_EnclosingBox.pfLow = 0;
+	}
 	
 	if (m_EnclosingBox.pfHigh)
-		delete [] m_EnclosingBox.pfHigh;
-}
-
-void CKdTree::DisposeRecursive(CKdTreeNode *pNode)
-{
-	if (pNode->m_bIsLeaf)
 	{
-		delete pNode;
-		return;
+		delete [] m_EnclosingBox.pfHigh;
+		m_EnclosingBox.pfHigh = 0;
 	}
 	
-	// recursion
-	if (pNode->m_pLeftChild) DisposeRecursive(pNode->m_pLeftChild);	
-	if (pNode->m_pRightChild) DisposeRecursive(pNode->m_pRightChild);
-
-	delete pNode;
+	m_nNodes = 0;
+	m_nDepth = 0;
+	m_nLeaves = 0;
 }
 
 
@@ -266,7 +586,7 @@ void CKdTree::NearestNeighbor(const float *pQuery, float &fError, float *&pfNN,
 	m_fCurrentMinDistance = FLT_MAX;
 	
 	// start recursion
-	NearestNeighborRecursive(m_pRoot, pQuery);	
+	NearestNeighborRecursive(m_pNodes, pQuery);	
 	
 	// set return values
 	fError = m_fCurrentMinDistance;
@@ -287,7 +607,7 @@ void CKdTree::NearestNeighborBBF(const float *pQuery, float &fError, float *&pfN
 
 	// start recursion
 	const float fDistanceBB = GetDistanceFromBox(m_EnclosingBox, pQuery, m_nDimensions);
-	NearestNeighborRecursiveBBF(m_pRoot, pQuery, fDistanceBB);	
+	NearestNeighborRecursiveBBF(m_pNodes, pQuery, fDistanceBB);	
 	
 	// return result
 	fError = m_fCurrentMinDistance;
@@ -305,7 +625,7 @@ void CKdTree::NearestNeighbor(const float *pQuery, float &fError, CKdPriorityQue
 	m_fCurrentMinDistance = FLT_MAX;
 	
 	// start recursion
-	NearestNeighborRecursive(m_pRoot, pQuery);	
+	NearestNeighborRecursive(m_pNodes, pQuery);	
 	
 	// set return values
 	fError = m_fCurrentMinDistance;
@@ -327,7 +647,7 @@ void CKdTree::NearestNeighborBBF(const float *pQuery, float &fError, CKdPriority
 
 	// start recursion	
 	const float fDistanceBB = GetDistanceFromBox(m_EnclosingBox, pQuery, m_nDimensions);
-	NearestNeighborRecursiveBBF(m_pRoot, pQuery, fDistanceBB);	
+	NearestNeighborRecursiveBBF(m_pNodes, pQuery, fDistanceBB);	
 	
 	// return result
 	fError = m_fCurrentMinDistance;
@@ -335,17 +655,17 @@ void CKdTree::NearestNeighborBBF(const float *pQuery, float &fError, CKdPriority
 }
 
 
-void CKdTree::NearestNeighborRecursive(CKdTreeNode *pNode, const float *pQuery)
+void CKdTree::NearestNeighborRecursive(const KdTreeNode *pNode, const float *pQuery)
 {
 	// maximum number of leaves searched
 	if (m_nMaximumLeavesToVisit == 0)
 		return;
 	
-	if (pNode->m_bIsLeaf)
+	if (pNode->nCutDimension < 0)
 	{
 		// go through bucket and find nearest neighbor with linear search
-		float *pValues = pNode->m_pValues;
-		const int nSize = pNode->m_nSize;
+		float *pValues = m_pValues + pNode->nFirstValue * m_nTotalVectorSize;
+		const int nSize = pNode->nSize;
 		
 		for (int i = 0 ; i < nSize; i++)
 		{
@@ -361,6 +681,8 @@ void CKdTree::NearestNeighborRecursive(CKdTreeNode *pNode, const float *pQuery)
 				if (m_pNearestNeighborList)
 					m_pNearestNeighborList->Push(m_fCurrentMinDistance, pValues);
 			}
+			
+			pValues += m_nTotalVectorSize;
 		}
         
 		m_nMaximumLeavesToVisit--;
@@ -370,30 +692,32 @@ void CKdTree::NearestNeighborRecursive(CKdTreeNode *pNode, const float *pQuery)
 	}
     
 	// step down
-	const float fCutDifference = pQuery[pNode->m_nCutDimension] - pNode->m_fMedianValue;
+	const KdTreeNode *pLeftChild = pNode + 1;
+	const KdTreeNode *pRightChild = m_pNodes + pNode->nRightChild;
+	const float fCutDifference = pQuery[pNode->nCutDimension] - pNode->fMedianValue;
 	const bool bFromLeft = fCutDifference < 0.0f;
 	
-	NearestNeighborRecursive(bFromLeft ? pNode->m_pLeftChild : pNode->m_pRightChild, pQuery);
+	NearestNeighborRecursive(bFromLeft ? pLeftChild : pRightChild, pQuery);
 
 	// worst-case estimation
 	if (m_fCurrentMinDistance >= fCutDifference * fCutDifference)
 	{
 		// search other sub-tree
-		NearestNeighborRecursive(bFromLeft ? pNode->m_pRightChild : pNode->m_pLeftChild, pQuery);
+		NearestNeighborRecursive(bFromLeft ? pRightChild : pLeftChild, pQuery);
 	}
 }
 
-void CKdTree::NearestNeighborRecursiveBBF(CKdTreeNode* pNode, const float *pQuery, float fDistanceBB)
+void CKdTree::NearestNeighborRecursiveBBF(const KdTreeNode *pNode, const float *pQuery, float fDistanceBB)
 {
 	// maximum number of leaves searched
 	if (m_nMaximumLeavesToVisit == 0)
 		return;
 	
-	if (pNode->m_bIsLeaf)
+	if (pNode->nCutDimension < 0)
 	{
 		// go through bucket and find nearest neighbor with linear search
-		float *pValues = pNode->m_pValues;
-		const int nSize = pNode->m_nSize;
+		float *pValues = m_pValues + pNode->nFirstValue * m_nTotalVectorSize;
+		const int nSize = pNode->nSize;
 
 		for (int i = 0; i < nSize; i++)
 		{
@@ -419,15 +743,15 @@ void CKdTree::NearestNeighborRecursiveBBF(CKdTreeNode* pNode, const float *pQuer
 	    
 	
 	// step down
-	const int nDimension = pNode->m_nCutDimension;
+	const int nDimension = pNode->nCutDimension;
 
 	// difference from query to cut plane
-	const float fCutDifference = pQuery[nDimension] - pNode->m_fMedianValue;
+	const float fCutDifference = pQuery[nDimension] - pNode->fMedianValue;
 	
 	if (fCutDifference < 0.0f)
 	{
 		// difference from box to point (was the old distance for this node)
-		float fBoxDifference = pNode->m_Bounding.fLow - pQuery[nDimension];
+		float fBoxDifference = pNode->bounding.fLow - pQuery[nDimension];
 
 		// point inside? -> no difference
 		if (fBoxDifference < 0.0f)
@@ -439,15 +763,15 @@ void CKdTree::NearestNeighborRecursiveBBF(CKdTreeNode* pNode, const float *pQuer
 		const float fChildDistanceBB = fDistanceBB - fBoxDifference * fBoxDifference + fCutDifference * fCutDifference;
 			
 		// store node in BBF node list
-		m_pNodeListBBF->Push(fChildDistanceBB, pNode->m_pRightChild);
+		m_pNodeListBBF->Push(fChildDistanceBB, (void *) (m_pNodes + pNode->nRightChild));
 		
 		// step down left
-		NearestNeighborRecursiveBBF(pNode->m_pLeftChild, pQuery,  fDistanceBB);
+		NearestNeighborRecursiveBBF(pNode + 1, pQuery,  fDistanceBB);
 	} 
 	else
 	{
 		// difference from box to point (was the old distance for this node)
-		float fBoxDifference = pQuery[nDimension] - pNode->m_Bounding.fHigh;
+		float fBoxDifference = pQuery[nDimension] - pNode->bounding.fHigh;
 
 		// point inside? -> no difference
 		if (fBoxDifference < 0.0f)
@@ -459,19 +783,154 @@ void CKdTree::NearestNeighborRecursiveBBF(CKdTreeNode* pNode, const float *pQuer
 		const float fChildDistanceBB = fDistanceBB - fBoxDifference * fBoxDifference + fCutDifference * fCutDifference;
 			
 		// store node in BBF node list
-		m_pNodeListBBF->Push(fChildDistanceBB, pNode->m_pLeftChild);
+		m_pNodeListBBF->Push(fChildDistanceBB, (void *) (pNode + 1));
 		
 		// step down right
-		NearestNeighborRecursiveBBF(pNode->m_pRightChild, pQuery, fDistanceBB);
+		NearestNeighborRecursiveBBF(m_pNodes + pNode->nRightChild, pQuery, fDistanceBB);
 	}
 
 	// step up (using best node - BBF)
 	// take best node from priority queue as next possible node
+	if (m_pNodeListBBF->GetSize() == 0)
+		return;
+	
 	float fChildDistanceBB;
-	m_pNodeListBBF->Pop(fChildDistanceBB, (void *&) pNode);
+	void *pNextNode;
+	m_pNodeListBBF->Pop(fChildDistanceBB, pNextNode);
 	
 	// pruefe ob Distanz zwischen Median und Anfrage in der Dimension 
 	// des Knotens groesser ist, als die minimale distanz bisher
 	if (m_fCurrentMinDistance >= fChildDistanceBB)
-		NearestNeighborRecursiveBBF(pNode, pQuery, fChildDistanceBB);
+		NearestNeighborRecursiveBBF((const KdTreeNode *) pNextNode, pQuery, fChildDistanceBB);
+}
+
+
+int CKdTree::KNearestNeighborsBBF(const float *pQuery, int k, float *pfDistances, const float **ppfNN, int nMaximumLeavesToVisit, CKdTreeSearchContext *pContext) const
+{
+	int i;
+	
+	for (i = 0; i < k; i++)
+	{
+		pfDistances[i] = FLT_MAX;
+		ppfNN[i] = 0;
+	}
+	
+	if (k <= 0 || !m_pNodes)
+		return 0;
+	
+	int nLeavesToVisit = nMaximumLeavesToVisit <= 0 ? m_nLeaves : nMaximumLeavesToVisit;
+	
+	// each descent pushes at most m_nDepth nodes, so that the queue cannot overflow
+	const int nMaximumQueueSize = nLeavesToVisit < (m_nNodes + m_nDepth) / (m_nDepth + 1) ? nLeavesToVisit * (m_nDepth + 1) : m_nNodes;
+	
+	CKdTreeSearchContext localContext;
+	CKdPriorityQueue *pNodeList = (pContext ? pContext : &localContext)->GetNodeList(nMaximumQueueSize);
+	
+	int nFound = 0;
+	
+	// start at root with distance to enclosing box
+	pNodeList->Push(GetDistanceFromBox(m_EnclosingBox, pQuery, m_nDimensions), (void *) m_pNodes);
+	
+	while (nLeavesToVisit > 0 && pNodeList->GetSize() > 0)
+	{
+		// take best node from priority queue
+		float fDistanceBB;
+		void *pMeta;
+		pNodeList->Pop(fDistanceBB, pMeta);
+		
+		// all remaining nodes are farther away than the k-th neighbor
+		if (nFound == k && fDistanceBB > pfDistances[k - 1])
+			break;
+		
+		const KdTreeNode *pNode = (const KdTreeNode *) pMeta;
+		
+		// step down to leaf, storing the other children in the queue
+		while (pNode->nCutDimension >= 0)
+		{
+			const int nDimension = pNode->nCutDimension;
+			
+			// difference from query to cut plane
+			const float fCutDifference = pQuery[nDimension] - pNode->fMedianValue;
+			
+			if (fCutDifference < 0.0f)
+			{
+				// difference from box to point (was the old distance for this node)
+				float fBoxDifference = pNode->bounding.fLow - pQuery[nDimension];
+				
+				if (fBoxDifference < 0.0f)
+					fBoxDifference = 0.0f;
+				
+				pNodeList->Push(fDistanceBB - fBoxDifference * fBoxDifference + fCutDifference * fCutDifference, (void *) (m_pNodes + pNode->nRightChild));
+				
+				pNode = pNode + 1;
+			}
+			else
+			{
+				// difference from box to point (was the old distance for this node)
+				float fBoxDifference = pQuery[nDimension] - pNode->bounding.fHigh;
+				
+				if (fBoxDifference < 0.0f)
+					fBoxDifference = 0.0f;
+				
+				pNodeList->Push(fDistanceBB - fBoxDifference * fBoxDifference + fCutDifference * fCutDifference, (void *) (pNode + 1));
+				
+				pNode = m_pNodes + pNode->nRightChild;
+			}
+		}
+		
+		// go through bucket and insert vectors into sorted list of k best vectors
+		const float *pValues = m_pValues + pNode->nFirstValue * m_nTotalVectorSize;
+		const int nSize = pNode->nSize;
+		
+		for (i = 0; i < nSize; i++, pValues += m_nTotalVectorSize)
+		{
+			const float fDistance = SquaredEuclideanDistance(pValues, pQuery, m_nDimensions);
+			
+			if (fDistance < pfDistances[k - 1])
+			{
+				int j = nFound < k ? nFound++ : k - 1;
+				
+				for (; j > 0 && pfDistances[j - 1] > fDistance; j--)
+				{
+					pfDistances[j] = pfDistances[j - 1];
+					ppfNN[j] = ppfNN[j - 1];
+				}
+				
+				pfDistances[j] = fDistance;
+				ppfNN[j] = pValues;
+			}
+		}
+		
+		nLeavesToVisit--;
+	}
+	
+	return nFound;
+}
+
+void CKdTree::KNearestNeighborsBBFBatch(void *pParameter, int nFirst, int nLast)
+{
+	const KNearestNeighborsParameters *pParameters = (const KNearestNeighborsParameters *) pParameter;
+	const CKdTree *pTree = pParameters->pTree;
+	const int k = pParameters->k;
+	
+	CKdTreeSearchContext context;
+	
+	for (int i = nFirst; i < nLast; i++)
+	{
+		pTree->KNearestNeighborsBBF(pParameters->pQueries + i * pTree->m_nDimensions, k,
+			pParameters->pfDistances + i * k, pParameters->ppfNN + i * k, pParameters->nMaximumLeavesToVisit, &context);
+	}
+}
+
+void CKdTree::KNearestNeighborsBBF(const float *pQueries, int nQueries, int k, float *pfDistances, const float **ppfNN, int nMaximumLeavesToVisit) const
+{
+	KNearestNeighborsParameters parameters;
+	parameters.pTree = this;
+	parameters.pQueries = pQueries;
+	parameters.k = k;
+	parameters.pfDistances = pfDistances;
+	parameters.ppfNN = ppfNN;
+	parameters.nMaximumLeavesToVisit = nMaximumLeavesToVisit;
+	
+	Threading::ParallelFor(KNearestNeighborsBBFBatch, &parameters, nQueries, 16);
 }
@@ -48,6 +48,8 @@
 // ****************************************************************************
 
 #include "KdStructs.h"
+#include <stddef.h>
+#include <vector>
 
 
 // ****************************************************************************
@@ -58,43 +60,37 @@ class CKdPriorityQueue;
 
 
 // ****************************************************************************
-// CKdTreeNode
+// CKdTreeSearchContext
 // ****************************************************************************
 
-class CKdTreeNode
+// scratch memory for the const queries of CKdTree and CKdForest
+// one context must not be used by several threads at the same time
+class CKdTreeSearchContext
 {
 public:
-	CKdTreeNode()
-	{
-		m_pLeftChild = 0; 
-		m_pRightChild = 0; 
-		m_nCutDimension = 0;
-		m_bIsLeaf = 0;
-		m_Bounding.fLow = 0;
-		m_Bounding.fHigh = 0;
-		m_nSize = 0;
-		m_pValues = 0;
-	}
-	
-	~CKdTreeNode()
-	{
-		if (m_pValues)
-			delete [] m_pValues;
-	}
+	// constructor
+	CKdTreeSearchContext();
 	
-
-	// public methods
-	CKdTreeNode *m_pLeftChild, *m_pRightChild;
-    
-	float m_fMedianValue;
+	// destructor
+	~CKdTreeSearchContext();
 	
-	KdBounding m_Bounding;
 	
-	int m_bIsLeaf;
-	int m_nCutDimension;
-		
-	int m_nSize;
-	float *m_pValues;
+private:
+	friend class CKdTree;
+	friend class CKdForest;
+	
+	// private methods
+	CKdPriorityQueue* GetNodeList(int nMaximumSize);
+	int* GetVisitedList(int nVectors, int &nQueryIndex);
+	
+	// private attributes
+	CKdPriorityQueue *m_pNodeList;
+	int m_nMaximumSize;
+	
+	// index of last query per vector (CKdForest)
+	int *m_pVisitedList;
+	int m_nVisitedListSize;
+	int m_nQueryIndex;
 };
 
 
@@ -121,7 +117,19 @@ public:
 	// the userdata in the upper elements of the vector.
 	// Casting of float values to the appropriate type
 	// has to be handled by user.
+	// The order of the pointers in ppfValues[nLow..nHigh] is changed,
+	// the vectors are copied into the tree.
+	// Subtrees are built in parallel if the worker pool is enabled
+	// (see Threading::SetNumberOfWorkerThreads), the result does not
+	// depend on the number of threads.
 	void Build(float **ppfValues, int nLow, int nHigh, int nBucketSize, int nDimensions, int nUserDataSize);
+	
+	// save the built tree to a binary index file (see KdIndexFile.h)
+	bool SaveToFile(const char *pFileName) const;
+	// load a tree saved with SaveToFile instead of building it
+	// the file is read with one call or memory-mapped (bMemoryMap = true),
+	// in both cases the tree is used in place without relocation
+	bool LoadFromFile(const char *pFileName, bool bMemoryMap = false);
 
 	// nearest neighbor only
 	void NearestNeighbor(const float *pQuery, float &fError, float*& pfNN, int nMaximumLeavesToVisit = -1);
@@ -131,18 +139,57 @@ public:
 	void NearestNeighbor(const float *pQuery, float &fError, CKdPriorityQueue *&pNNList, int nMaximumLeavesToVisit = -1);
 	void NearestNeighborBBF(const float *pQuery, float &fError, CKdPriorityQueue *&pNNList, int nMaximumLeavesToVisit = -1); // with best bin first strategy
 	
+	// k nearest neighbors with best bin first strategy
+	// The queries are const and can be called from several threads at the
+	// same time, each thread using its own search context (if pContext is 0,
+	// temporary scratch memory is allocated for the call).
+	// pfDistances and ppfNN must have k elements, they are filled with the
+	// squared distances in ascending order and the vectors (with userdata).
+	// Returns the number of neighbors found, remaining elements are set to
+	// FLT_MAX and 0.
+	int KNearestNeighborsBBF(const float *pQuery, int k, float *pfDistances, const float **ppfNN, int nMaximumLeavesToVisit = -1, CKdTreeSearchContext *pContext = 0) const;
+	
+	// batch version for nQueries queries stored one after another (nDimensions floats each)
+	// pfDistances and ppfNN must have nQueries * k elements (k per query)
+	// queries are distributed over the worker pool (see Threading::SetNumberOfWorkerThreads)
+	void KNearestNeighborsBBF(const float *pQueries, int nQueries, int k, float *pfDistances, const float **ppfNN, int nMaximumLeavesToVisit = -1) const;
+	
+	// member access
+	int GetNumberOfDimensions() const { return m_nDimensions; }
+	int GetNumberOfVectors() const { return m_nLeaves; }
+	int GetUserDataSize() const { return m_nUserDataSize; }
+	
 
 private:
+	// structure for subtrees built in parallel
+	struct BuildTask
+	{
+		int nLow;
+		int nHigh;
+		int nNode;
+		int nDepth;
+		float *pfLow;
+		float *pfHigh;
+	};
+	
 	// private methods
 	void Dispose();
-	CKdTreeNode* BuildRecursive(float** ppfValues,int nLow, int nHigh, KdBoundingBox* pCurrentBoundingBox, int nCurrentDepth);
-	void DisposeRecursive(CKdTreeNode *pNode);
-	void NearestNeighborRecursive(CKdTreeNode* pNode, const float *pQuery);
-	void NearestNeighborRecursiveBBF(CKdTreeNode* pNode, const float *pQuery, float fDistanceBB);
+	int CalculateNumberOfNodes(int nSize) const;
+	int CalculateDepth(int nSize) const;
+	void BuildRecursive(float **ppfValues, int nLow, int nHigh, int nNode, KdBoundingBox *pCurrentBoundingBox, int nCurrentDepth, std::vector<BuildTask> *pTasks);
+	static void BuildSubtrees(void *pParameter, int nFirst, int nLast);
+	static void KNearestNeighborsBBFBatch(void *pParameter, int nFirst, int nLast);
+	void NearestNeighborRecursive(const KdTreeNode *pNode, const float *pQuery);
+	void NearestNeighborRecursiveBBF(const KdTreeNode *pNode, const float *pQuery, float fDistanceBB);
 	
 	
-	// root node
-	CKdTreeNode *m_pRoot;
+	// nodes in depth-first order, root is m_pNodes[0]
+	KdTreeNode *m_pNodes;
+	int m_nNodes;
+	// maximum depth of a leaf
+	int m_nDepth;
+	// vectors of all leaves in one block, in the order of the leaves
+	float *m_pValues;
 	// maximum bucket size in tree
 	int m_nBucketSize;
 	// number of dimensions of vectors
@@ -151,10 +198,16 @@ private:
 	int	m_nUserDataSize;
 	// m_nDimensions + m_nUserDataSize
 	int m_nTotalVectorSize;
-	// number of leaves
+	// number of vectors
 	int m_nLeaves;
+	// depth at which the build process is split into parallel tasks
+	int m_nParallelBuildDepth;
 	// bounding box of whole tree (calculated in build process)
 	KdBoundingBox m_EnclosingBox;
+	// data of a loaded index file, the arrays above point into it
+	unsigned char *m_pFileData;
+	size_t m_nFileDataSize;
+	bool m_bFileDataMapped;
 	
 	// used for query recursion
 	float m_fCurrentMinDistance;
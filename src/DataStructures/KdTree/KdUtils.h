@@ -59,36 +59,33 @@
 
 // find smallest enclosing rectangle
 // used to find initial bounding box for recursion in build process
-KdBoundingBox CalculateEnclosingBoundingBox(float **ppValues, int nDimension, int nSize)
+inline KdBoundingBox CalculateEnclosingBoundingBox(float **ppValues, int nDimension, int nSize)
 {
 	KdBoundingBox EnclosingBox;
 	EnclosingBox.nDimension = nDimension;
 	EnclosingBox.pfLow = new float[nDimension];
 	EnclosingBox.pfHigh = new float[nDimension];
 	
-	// find boundings for each dimension
+	// init lower and upper bound
 	for (int d = 0; d < nDimension; d++)
 	{
-		// init lower and upper bound
-		float fLow = ppValues[0][d];
-		float fHigh = ppValues[0][d];
+		EnclosingBox.pfLow[d] = ppValues[0][d];
+		EnclosingBox.pfHigh[d] = ppValues[0][d];
+	}
+	
+	// find smallest and highest element of each dimension
+	// (vector by vector for linear memory access)
+	for (int i = 1; i < nSize; i++)
+	{
+		const float *pValues = ppValues[i];
 		
-		// find smallest and highest element
-		for (int i = 0; i < nSize; i++)
+		for (int d = 0; d < nDimension; d++)
 		{
-			if (ppValues[i][d] < fLow) 
-			{
-				fLow = ppValues[i][d];
-			} 
-			else if (ppValues[i][d] > fHigh)
-			{
-				fHigh = ppValues[i][d];
-			}
+			if (pValues[d] < EnclosingBox.pfLow[d])
+				EnclosingBox.pfLow[d] = pValues[d];
+			else if (pValues[d] > EnclosingBox.pfHigh[d])
+				EnclosingBox.pfHigh[d] = pValues[d];
 		}
-		
-		// store in Box
-		EnclosingBox.pfLow[d] = fLow;
-		EnclosingBox.pfHigh[d] = fHigh;
 	}
 	
 	return EnclosingBox;
@@ -97,7 +94,7 @@ KdBoundingBox CalculateEnclosingBoundingBox(float **ppValues, int nDimension, in
 
 // calculate distance form query point to bounding box
 // used once to initiate recursion for BBF search
-float GetDistanceFromBox(KdBoundingBox BoundingBox, const float *pValues, int nDimension)
+inline float GetDistanceFromBox(KdBoundingBox BoundingBox, const float *pValues, int nDimension)
 {
 	register float fDistance = 0.0f;
 
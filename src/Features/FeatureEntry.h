@@ -90,6 +90,8 @@ public:
 			m_pFeature = new float[nSize];
 		else
 			m_pFeature = 0;
+
+		m_bOwnMemory = true;
 	}
 
 	CFeatureEntry(const float *pFeature, int nSize, float x, float y, float angle, float scale, Vec3d point3d = Math3d::zero_vec) : CDynamicArrayElement()
@@ -103,6 +105,31 @@ public:
 
 		m_pFeature = new float[nSize];
 		memcpy(m_pFeature, pFeature, nSize * sizeof(float));
+
+		m_bOwnMemory = true;
+	}
+
+	// the descriptor refers to pFeature if bAttachFeature is set to true (see AttachFeature(float*)), otherwise it is copied
+	CFeatureEntry(float *pFeature, int nSize, float x, float y, float angle, float scale, Vec3d point3d, bool bAttachFeature) : CDynamicArrayElement()
+	{
+		m_nSize = nSize;
+
+		Math2d::SetVec(point, x, y);
+		Math3d::SetVec(this->point3d, point3d);
+		this->angle = angle;
+		this->scale = scale;
+
+		if (bAttachFeature)
+		{
+			m_pFeature = pFeature;
+			m_bOwnMemory = false;
+		}
+		else
+		{
+			m_pFeature = new float[nSize];
+			memcpy(m_pFeature, pFeature, nSize * sizeof(float));
+			m_bOwnMemory = true;
+		}
 	}
 
 	CFeatureEntry(const CFeatureEntry &featureEntry)
@@ -113,15 +140,21 @@ public:
 		scale = featureEntry.scale;
 		m_nSize = featureEntry.m_nSize;
 
-		m_pFeature = new float[m_nSize];
-		memcpy(m_pFeature, featureEntry.m_pFeature, m_nSize * sizeof(float));
+		if (featureEntry.m_pFeature)
+		{
+			m_pFeature = new float[m_nSize];
+			memcpy(m_pFeature, featureEntry.m_pFeature, m_nSize * sizeof(float));
+		}
+		else
+			m_pFeature = 0;
+
+		m_bOwnMemory = true;
 	}
 
 	// destructor
 	~CFeatureEntry()
 	{
-		if (m_pFeature)
-			delete [] m_pFeature;
+		FreeFeature();
 	}
 
 
@@ -133,8 +166,9 @@ public:
 		m_nSize = invert_byte_order_long(m_nSize);
 		#endif
 
-		if (m_pFeature) delete [] m_pFeature;
+		FreeFeature();
 		m_pFeature = new float[m_nSize];
+		m_bOwnMemory = true;
 
 		float u, v;
 
@@ -165,8 +199,9 @@ public:
 		m_nSize = invert_byte_order_long(m_nSize);
 		#endif
 
-		if (m_pFeature) delete [] m_pFeature;
+		FreeFeature();
 		m_pFeature = new float[m_nSize];
+		m_bOwnMemory = true;
 
 		float u, v, x, y, z;
 
@@ -243,6 +278,43 @@ public:
 
 	// other public methods
 	int GetSize() const { return m_nSize; }
+
+	/*!
+		\brief Lets the descriptor refer to external memory, e.g. a row of a CFeatureMatrix.
+
+		The descriptor is copied to pFeature, which must provide GetSize() floats and remain valid as long as the entry uses it.
+		The memory is not freed by the entry.
+	*/
+	void AttachFeature(float *pFeature)
+	{
+		if (pFeature == m_pFeature)
+			return;
+
+		if (m_pFeature)
+			memcpy(pFeature, m_pFeature, m_nSize * sizeof(float));
+
+		FreeFeature();
+		m_pFeature = pFeature;
+		m_bOwnMemory = false;
+	}
+
+	/*!
+		\brief Copies an attached descriptor (see AttachFeature(float*)) to memory owned by the entry.
+	*/
+	void DetachFeature()
+	{
+		if (m_bOwnMemory || !m_pFeature)
+			return;
+
+		float *pFeature = new float[m_nSize];
+		memcpy(pFeature, m_pFeature, m_nSize * sizeof(float));
+
+		m_pFeature = pFeature;
+		m_bOwnMemory = true;
+	}
+
+	//! Returns false if the descriptor refers to external memory (see AttachFeature(float*)).
+	bool OwnsFeature() const { return m_bOwnMemory; }
 	
 	virtual int GetSizeOnDisk() const
 	{
@@ -257,8 +329,18 @@ public:
 
 
 protected:
+	// protected methods
+	void FreeFeature()
+	{
+		if (m_pFeature && m_bOwnMemory)
+			delete [] m_pFeature;
+
+		m_pFeature = 0;
+	}
+
 	// protected attribute
 	int m_nSize;
+	bool m_bOwnMemory;
 	
 public:
 	float *m_pFeature;
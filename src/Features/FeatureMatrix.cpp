@@ -0,0 +1,213 @@
+// ****************************************************************************
+// This file is part of the Integrating Vision Toolkit (IVT).
+//
+// The IVT is maintained by the Karlsruhe Institute of Technology (KIT)
+// (www.kit.edu) in cooperation with the company Keyetech (www.keyetech.de).
+//
+// Copyright (C) 2014 Karlsruhe Institute of Technology (KIT).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the KIT nor the names of its contributors may be
+//    used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE KIT AND CONTRIBUTORS “AS IS” AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE KIT OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ****************************************************************************
+// ****************************************************************************
+// Filename:  FeatureMatrix.cpp
+// Author:    agent
+// Date:      17.10.2026
+// ****************************************************************************
+
+
+// ****************************************************************************
+// Includes
+// ****************************************************************************
+
+#include <new> // for explicitly using correct new/delete operators on VC DSPs
+
+#include "FeatureMatrix.h"
+#include "FeatureEntry.h"
+#include "DataStructures/DynamicArray.h"
+#include "DataStructures/DynamicArrayTemplatePointer.h"
+#include "Helpers/helpers.h"
+
+#include <stdio.h>
+#include <string.h>
+
+
+
+// ****************************************************************************
+// Constructor / Destructor
+// ****************************************************************************
+
+CFeatureMatrix::CFeatureMatrix()
+{
+	m_nFeatures = 0;
+	m_nDimension = 0;
+	m_nStride = 0;
+
+	m_pData = 0;
+	m_pKeypoints = 0;
+	m_bOwnMemory = true;
+}
+
+CFeatureMatrix::~CFeatureMatrix()
+{
+	Clear();
+}
+
+
+// ****************************************************************************
+// Methods
+// ****************************************************************************
+
+void CFeatureMatrix::Clear()
+{
+	if (m_bOwnMemory)
+	{
+		if (m_pData)
+			aligned_free(m_pData);
+
+		if (m_pKeypoints)
+			delete [] m_pKeypoints;
+	}
+
+	m_nFeatures = 0;
+	m_nDimension = 0;
+	m_nStride = 0;
+
+	m_pData = 0;
+	m_pKeypoints = 0;
+	m_bOwnMemory = true;
+}
+
+void CFeatureMatrix::SetData(float *pData, Keypoint *pKeypoints, int nFeatures, int nDimension, int nStride)
+{
+	Clear();
+
+	m_nFeatures = nFeatures;
+	m_nDimension = nDimension;
+	m_nStride = nStride;
+
+	m_pData = pData;
+	m_pKeypoints = pKeypoints;
+	m_bOwnMemory = false;
+}
+
+bool CFeatureMatrix::SetFeatures(CFeatureEntry * const *ppFeatures, int nFeatures, bool bAttachFeatures)
+{
+	const int nDimension = nFeatures > 0 ? ppFeatures[0]->GetSize() : 0;
+	int i;
+
+	for (i = 0; i < nFeatures; i++)
+	{
+		if (ppFeatures[i]->GetSize() != nDimension)
+		{
+			printf("error: features with different descriptor sizes in CFeatureMatrix::SetFeatures\n");
+			return false;
+		}
+
+		if (nDimension > 0 && !ppFeatures[i]->m_pFeature)
+		{
+			printf("error: feature without float descriptor in CFeatureMatrix::SetFeatures\n");
+			return false;
+		}
+	}
+
+	const int nFloatsPerAlignment = IVT_ROW_ALIGNMENT / sizeof(float);
+	const int nStride = (nDimension + nFloatsPerAlignment - 1) / nFloatsPerAlignment * nFloatsPerAlignment;
+
+	// the features might be attached to the current matrix, therefore the old memory is freed
+	// only after the descriptors have been copied
+	float *pData = 0;
+	Keypoint *pKeypoints = 0;
+
+	if (nFeatures > 0)
+	{
+		pData = (float *) aligned_malloc(nFeatures * nStride * sizeof(float), IVT_ROW_ALIGNMENT);
+		pKeypoints = new Keypoint[nFeatures];
+	}
+
+	for (i = 0; i < nFeatures; i++)
+	{
+		CFeatureEntry *pFeature = ppFeatures[i];
+		float *pDescriptor = pData + i * nStride;
+
+		if (nStride > nDimension)
+			memset(pDescriptor + nDimension, 0, (nStride - nDimension) * sizeof(float));
+
+		if (bAttachFeatures)
+			pFeature->AttachFeature(pDescriptor);
+		else if (nDimension > 0)
+			memcpy(pDescriptor, pFeature->m_pFeature, nDimension * sizeof(float));
+
+		Keypoint &keypoint = pKeypoints[i];
+		Math2d::SetVec(keypoint.point, pFeature->point);
+		Math3d::SetVec(keypoint.point3d, pFeature->point3d);
+		keypoint.angle = pFeature->angle;
+		keypoint.scale = pFeature->scale;
+	}
+
+	Clear();
+
+	m_nFeatures = nFeatures;
+	m_nDimension = nDimension;
+	m_nStride = nStride;
+
+	m_pData = pData;
+	m_pKeypoints = pKeypoints;
+
+	return true;
+}
+
+bool CFeatureMatrix::SetFeatures(const CDynamicArrayTemplatePointer<CFeatureEntry> &featureList, bool bAttachFeatures)
+{
+	const int nFeatures = featureList.GetSize();
+
+	CFeatureEntry **ppFeatures = new CFeatureEntry*[nFeatures > 0 ? nFeatures : 1];
+
+	for (int i = 0; i < nFeatures; i++)
+		ppFeatures[i] = (CFeatureEntry *) featureList[i];
+
+	const bool bResult = SetFeatures(ppFeatures, nFeatures, bAttachFeatures);
+
+	delete [] ppFeatures;
+
+	return bResult;
+}
+
+bool CFeatureMatrix::SetFeatures(const CDynamicArray &featureList, bool bAttachFeatures)
+{
+	const int nFeatures = featureList.GetSize();
+
+	CFeatureEntry **ppFeatures = new CFeatureEntry*[nFeatures > 0 ? nFeatures : 1];
+
+	for (int i = 0; i < nFeatures; i++)
+		ppFeatures[i] = (CFeatureEntry *) featureList.GetElementNoCheck(i);
+
+	const bool bResult = SetFeatures(ppFeatures, nFeatures, bAttachFeatures);
+
+	delete [] ppFeatures;
+
+	return bResult;
+}
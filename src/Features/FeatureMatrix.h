@@ -0,0 +1,149 @@
+// ****************************************************************************
+// This file is part of the Integrating Vision Toolkit (IVT).
+//
+// The IVT is maintained by the Karlsruhe Institute of Technology (KIT)
+// (www.kit.edu) in cooperation with the company Keyetech (www.keyetech.de).
+//
+// Copyright (C) 2014 Karlsruhe Institute of Technology (KIT).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the KIT nor the names of its contributors may be
+//    used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE KIT AND CONTRIBUTORS “AS IS” AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE KIT OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ****************************************************************************
+// ****************************************************************************
+// Filename:  FeatureMatrix.h
+// Author:    agent
+// Date:      17.10.2026
+// ****************************************************************************
+
+
+#ifndef _FEATURE_MATRIX_H_
+#define _FEATURE_MATRIX_H_
+
+
+// ****************************************************************************
+// Necessary includes
+// ****************************************************************************
+
+#include "Math/Math2d.h"
+#include "Math/Math3d.h"
+
+
+// ****************************************************************************
+// Forward declarations
+// ****************************************************************************
+
+class CFeatureEntry;
+class CDynamicArray;
+template <typename T> class CDynamicArrayTemplatePointer;
+
+
+
+// ****************************************************************************
+// CFeatureMatrix
+// ****************************************************************************
+
+/*!
+	\ingroup FeatureRepresentations
+	\brief Contiguous storage of the descriptors and keypoints of a list of features.
+
+	The descriptors are stored row by row in one block of memory. Each row starts at a multiple of IVT_ROW_ALIGNMENT bytes,
+	the padding floats at the end of a row are set to zero, so that distances can be computed over GetStride() floats as well.
+	The keypoint attributes are stored in a parallel array (see GetKeypoint(int)).
+
+	If the features are attached to the matrix (see SetFeatures), the member CFeatureEntry::m_pFeature of each entry refers
+	to its row. In this case, the matrix must not be modified or deleted as long as the entries are used,
+	or the entries must be detached with CFeatureEntry::DetachFeature() before.
+	The keypoint attributes are a copy made by SetFeatures and are not updated when the entries change.
+*/
+class CFeatureMatrix
+{
+public:
+	// structs
+	struct Keypoint
+	{
+		Vec2d point;
+		Vec3d point3d;
+		float angle;
+		float scale;
+	};
+
+	// constructor
+	CFeatureMatrix();
+
+	// destructor
+	~CFeatureMatrix();
+
+
+	// public methods
+	/*!
+		\brief Copies the descriptors and keypoints of the given features to the matrix.
+
+		All features must have the same descriptor size.
+
+		\param[in] ppFeatures The features.
+		\param[in] nFeatures The number of features.
+		\param[in] bAttachFeatures If set to true, the descriptor of each entry is replaced by a reference to its row of the matrix (see CFeatureEntry::AttachFeature(float*)).
+		\return false if the descriptor sizes differ, true otherwise.
+	*/
+	bool SetFeatures(CFeatureEntry * const *ppFeatures, int nFeatures, bool bAttachFeatures = false);
+	bool SetFeatures(const CDynamicArrayTemplatePointer<CFeatureEntry> &featureList, bool bAttachFeatures = false);
+	//! The elements of featureList must be instances of CFeatureEntry, e.g. the result of CSIFTFeatureCalculator::CalculateFeatures.
+	bool SetFeatures(const CDynamicArray &featureList, bool bAttachFeatures = false);
+	
+	/*!
+		\brief Lets the matrix refer to external memory, e.g. a memory mapped file (see CFeatureSet::LoadFromFile).
+
+		The memory is not freed by the matrix. Descriptor i starts at pData + i * nStride.
+	*/
+	void SetData(float *pData, Keypoint *pKeypoints, int nFeatures, int nDimension, int nStride);
+	void Clear();
+
+	int GetSize() const { return m_nFeatures; }
+	int GetDimension() const { return m_nDimension; }
+	//! Returns the distance between two descriptors in floats.
+	int GetStride() const { return m_nStride; }
+
+	const float* GetData() const { return m_pData; }
+	const float* GetDescriptor(int nFeature) const { return m_pData + nFeature * m_nStride; }
+	float* GetDescriptor(int nFeature) { return m_pData + nFeature * m_nStride; }
+	const Keypoint& GetKeypoint(int nFeature) const { return m_pKeypoints[nFeature]; }
+	const Keypoint* GetKeypoints() const { return m_pKeypoints; }
+
+
+private:
+	// private attributes
+	int m_nFeatures;
+	int m_nDimension;
+	int m_nStride;
+
+	float *m_pData;
+	Keypoint *m_pKeypoints;
+	bool m_bOwnMemory;
+};
+
+
+
+#endif /* _FEATURE_MATRIX_H_ */
@@ -47,14 +47,91 @@
 #include "FeatureSet.h"
 #include "FeatureEntry.h"
 #include "Helpers/helpers.h"
+#include "Helpers/BasicFileIO.h"
 
 #include "Features/SIFTFeatures/SIFTFeatureEntry.h"
 
 #include <stdio.h>
+#include <string.h>
 
 
 
 #define HEADER_FEATURE_SET	"FEATURESET"
+#define HEADER_PACKED_FEATURE_SET	"IVTFSET1"
+#define PACKED_FEATURE_SET_VERSION	1
+#define PACKED_ALIGNMENT	64 // alignment of the sections of the packed format in bytes
+
+
+
+// ****************************************************************************
+// Packed format
+// ****************************************************************************
+
+/*
+	All values are stored in little-endian byte order. The sections follow the header in the given order,
+	each one starting at a multiple of PACKED_ALIGNMENT bytes:
+
+	- name: nNameLength characters
+	- contour points: nContourPoints records of u, v, x, y, z (float) and bHas3dPoint (int)
+	- keypoints: nFeatures records of CFeatureMatrix::Keypoint (7 floats)
+	- descriptors: nFeatures rows of nStride floats, the first nDimension of which are the descriptor
+*/
+struct PackedFileHeader
+{
+	char header[8];
+	unsigned int nVersion;
+	unsigned int nHeaderSize;
+	unsigned int nFeatures;
+	unsigned int nFeatureType;
+	unsigned int nDimension;
+	unsigned int nStride;
+	unsigned int nContourPoints;
+	unsigned int nNameLength;
+	unsigned int nChecksum; // FNV-1a of the header with nChecksum = 0
+	unsigned int reserved[5];
+};
+
+struct PackedFileLayout
+{
+	size_t nNameOffset;
+	size_t nContourPointsOffset;
+	size_t nKeypointsOffset;
+	size_t nDescriptorsOffset;
+	size_t nSize;
+};
+
+// the keypoints are stored as they are laid out in memory
+typedef char KeypointSizeCheck[sizeof(CFeatureMatrix::Keypoint) == 7 * sizeof(float) ? 1 : -1];
+
+static size_t Align(size_t nOffset)
+{
+	return CBasicFileIO::Align(nOffset, PACKED_ALIGNMENT);
+}
+
+static bool ComputeLayout(const PackedFileHeader &header, PackedFileLayout &layout)
+{
+	const double dSize = double(sizeof(PackedFileHeader)) + header.nNameLength + 24.0 * header.nContourPoints +
+		header.nFeatures * (double(sizeof(CFeatureMatrix::Keypoint)) + 4.0 * header.nStride) + 4 * PACKED_ALIGNMENT;
+
+	if (dSize >= double((size_t) -1))
+		return false;
+
+	layout.nNameOffset = Align(sizeof(PackedFileHeader));
+	layout.nContourPointsOffset = Align(layout.nNameOffset + header.nNameLength);
+	layout.nKeypointsOffset = Align(layout.nContourPointsOffset + 24 * size_t(header.nContourPoints));
+	layout.nDescriptorsOffset = Align(layout.nKeypointsOffset + sizeof(CFeatureMatrix::Keypoint) * size_t(header.nFeatures));
+	layout.nSize = layout.nDescriptorsOffset + 4 * size_t(header.nFeatures) * header.nStride;
+
+	return true;
+}
+
+static unsigned int ComputeChecksum(const PackedFileHeader &header)
+{
+	PackedFileHeader temp = header;
+	temp.nChecksum = 0;
+
+	return CBasicFileIO::ComputeChecksum(&temp, sizeof(temp));
+}
 
 
 
@@ -64,10 +141,16 @@
 
 CFeatureSet::CFeatureSet() : m_featureArray(true, 1000), m_contourPointArray(10)
 {
+	m_pFileData = 0;
+	m_nFileDataSize = 0;
+	m_bFileDataMapped = false;
 }
 
 CFeatureSet::~CFeatureSet()
 {
+	m_featureArray.Clear();
+	m_featureMatrix.Clear();
+	FreeFileData();
 }
 
 
@@ -94,6 +177,29 @@ void CFeatureSet::AddFeatureWithoutCloning(CFeatureEntry *pFeature)
 void CFeatureSet::ClearFeatureList()
 {
 	m_featureArray.Clear();
+	m_featureMatrix.Clear();
+	FreeFileData();
+}
+
+bool CFeatureSet::UpdateFeatureMatrix()
+{
+	// on failure, the old matrix is kept, since entries might still be attached to it
+	if (!m_featureMatrix.SetFeatures(m_featureArray, true))
+		return false;
+
+	// all entries refer to the new matrix now
+	FreeFileData();
+
+	return true;
+}
+
+void CFeatureSet::FreeFileData()
+{
+	CBasicFileIO::FreeFileData(m_pFileData, m_nFileDataSize, m_bFileDataMapped);
+
+	m_pFileData = 0;
+	m_nFileDataSize = 0;
+	m_bFileDataMapped = false;
 }
 
 void CFeatureSet::AddContourPoint(const Vec2d &point)
@@ -122,7 +228,135 @@ void CFeatureSet::ClearContourPointList()
 }
 
 
-bool CFeatureSet::SaveToFile(const char *pFileName) const
+bool CFeatureSet::SaveToFile(const char *pFileName, bool bPackedFormat) const
+{
+	const int nFeatures = m_featureArray.GetSize();
+
+	for (int i = 1; i < nFeatures && bPackedFormat; i++)
+	{
+		if (m_featureArray[i]->GetType() != m_featureArray[0]->GetType() || m_featureArray[i]->GetSize() != m_featureArray[0]->GetSize())
+			bPackedFormat = false;
+	}
+
+	return bPackedFormat ? SaveToPackedFile(pFileName) : SaveToStreamFile(pFileName);
+}
+
+bool CFeatureSet::SaveToPackedFile(const char *pFileName) const
+{
+	const int nFeatures = m_featureArray.GetSize();
+	const int nContourPoints = m_contourPointArray.GetSize();
+	const int nDimension = nFeatures > 0 ? m_featureArray[0]->GetSize() : 0;
+	const int nFloatsPerAlignment = PACKED_ALIGNMENT / sizeof(float);
+	const int nStride = (nDimension + nFloatsPerAlignment - 1) / nFloatsPerAlignment * nFloatsPerAlignment;
+	int i;
+
+	PackedFileHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.header, HEADER_PACKED_FEATURE_SET, sizeof(header.header));
+	header.nVersion = PACKED_FEATURE_SET_VERSION;
+	header.nHeaderSize = sizeof(PackedFileHeader);
+	header.nFeatures = nFeatures;
+	header.nFeatureType = nFeatures > 0 ? m_featureArray[0]->GetType() : CFeatureEntry::tSIFT;
+	header.nDimension = nDimension;
+	header.nStride = nStride;
+	header.nContourPoints = nContourPoints;
+	header.nNameLength = (unsigned int) m_sName.length();
+
+	PackedFileLayout layout;
+	if (!ComputeLayout(header, layout))
+		return false;
+	
+	CBasicFileIO::ConvertWords(&header.nVersion, (sizeof(header) - sizeof(header.header)) / 4);
+	header.nChecksum = ComputeChecksum(header);
+	CBasicFileIO::ConvertWords(&header.nChecksum, 1);
+
+	FILE *f = fopen(pFileName, "wb");
+	if (!f)
+		return false;
+
+	size_t nOffset = sizeof(header);
+	bool bSuccess = fwrite(&header, sizeof(header), 1, f) == 1 && CBasicFileIO::WritePadding(f, nOffset, layout.nNameOffset);
+
+	// name
+	if (bSuccess && m_sName.length() > 0)
+	{
+		bSuccess = fwrite(m_sName.c_str(), m_sName.length(), 1, f) == 1;
+		nOffset += m_sName.length();
+	}
+
+	bSuccess = bSuccess && CBasicFileIO::WritePadding(f, nOffset, layout.nContourPointsOffset);
+
+	// contour points
+	for (i = 0; i < nContourPoints && bSuccess; i++)
+	{
+		const ContourPoint &point = m_contourPointArray[i];
+		float record[6] = { point.point.x, point.point.y, point.point3d.x, point.point3d.y, point.point3d.z, 0.0f };
+		const int nHas3dPoint = point.bHas3dPoint ? 1 : 0;
+		memcpy(record + 5, &nHas3dPoint, sizeof(int));
+		
+		CBasicFileIO::ConvertWords(record, 6);
+		bSuccess = fwrite(record, sizeof(record), 1, f) == 1;
+		nOffset += sizeof(record);
+	}
+
+	bSuccess = bSuccess && CBasicFileIO::WritePadding(f, nOffset, layout.nKeypointsOffset);
+
+	// keypoints
+	for (i = 0; i < nFeatures && bSuccess; i++)
+	{
+		const CFeatureEntry *pFeatureEntry = m_featureArray[i];
+
+		CFeatureMatrix::Keypoint keypoint;
+		Math2d::SetVec(keypoint.point, pFeatureEntry->point);
+		Math3d::SetVec(keypoint.point3d, pFeatureEntry->point3d);
+		keypoint.angle = pFeatureEntry->angle;
+		keypoint.scale = pFeatureEntry->scale;
+		
+		CBasicFileIO::ConvertWords(&keypoint, sizeof(keypoint) / 4);
+		bSuccess = fwrite(&keypoint, sizeof(keypoint), 1, f) == 1;
+		nOffset += sizeof(keypoint);
+	}
+
+	bSuccess = bSuccess && CBasicFileIO::WritePadding(f, nOffset, layout.nDescriptorsOffset);
+
+	// descriptors
+	if (nFeatures > 0)
+	{
+		float *pRow = new float[nStride];
+		memset(pRow, 0, nStride * sizeof(float));
+
+		for (i = 0; i < nFeatures && bSuccess; i++)
+		{
+			const CFeatureEntry *pFeatureEntry = m_featureArray[i];
+
+			if (pFeatureEntry->m_pFeature)
+			{
+				memcpy(pRow, pFeatureEntry->m_pFeature, nDimension * sizeof(float));
+			}
+			else if (pFeatureEntry->GetType() == CFeatureEntry::tSIFT)
+			{
+				// quantized descriptor
+				CSIFTFeatureEntry entry(*(const CSIFTFeatureEntry *) pFeatureEntry);
+				entry.Dequantize();
+				memcpy(pRow, entry.m_pFeature, nDimension * sizeof(float));
+			}
+			else
+				bSuccess = false;
+
+			CBasicFileIO::ConvertWords(pRow, nDimension);
+			bSuccess = bSuccess && fwrite(pRow, nStride * sizeof(float), 1, f) == 1;
+		}
+
+		delete [] pRow;
+	}
+
+	if (fclose(f) != 0)
+		bSuccess = false;
+
+	return bSuccess;
+}
+
+bool CFeatureSet::SaveToStreamFile(const char *pFileName) const
 {
 	FILE *f = fopen(pFileName, "wb");
 	if (!f)
@@ -234,15 +468,111 @@ bool CFeatureSet::SaveToFile(const char *pFileName) const
 	return true;
 }
 
-bool CFeatureSet::LoadFromFile(const char *pFileName)
+bool CFeatureSet::LoadFromFile(const char *pFileName, bool bMemoryMap)
 {
 	m_featureArray.Clear();
+	m_featureMatrix.Clear();
 	m_contourPointArray.Clear();
+	FreeFileData();
 	
 	FILE *f = fopen(pFileName, "rb");
 	if (!f)
 		return false;
+
+	char header[sizeof(HEADER_PACKED_FEATURE_SET) - 1];
 	
+	if (fread(header, sizeof(header), 1, f) != 1 || memcmp(header, HEADER_PACKED_FEATURE_SET, sizeof(header)) != 0)
+	{
+		// stream format
+		rewind(f);
+		return LoadFromStreamFile(f, pFileName);
+	}
+
+	fclose(f);
+
+	m_pFileData = CBasicFileIO::LoadFileData(pFileName, m_nFileDataSize, bMemoryMap, m_bFileDataMapped, PACKED_ALIGNMENT);
+
+	if (!m_pFileData || m_nFileDataSize < sizeof(PackedFileHeader))
+	{
+		FreeFileData();
+		return false;
+	}
+
+	if (!LoadFromPackedData(m_pFileData, m_nFileDataSize))
+	{
+		printf("error: file '%s' is corrupted\n", pFileName);
+		m_featureArray.Clear();
+		m_featureMatrix.Clear();
+		m_contourPointArray.Clear();
+		FreeFileData();
+		return false;
+	}
+
+	return true;
+}
+
+bool CFeatureSet::LoadFromPackedData(unsigned char *pData, size_t nSize)
+{
+	PackedFileHeader header;
+	memcpy(&header, pData, sizeof(header));
+
+	const unsigned int nChecksum = ComputeChecksum(header);
+	CBasicFileIO::ConvertWords(&header.nVersion, (sizeof(header) - sizeof(header.header)) / 4);
+
+	PackedFileLayout layout;
+
+	if (header.nVersion != PACKED_FEATURE_SET_VERSION || header.nHeaderSize != sizeof(PackedFileHeader) || header.nChecksum != nChecksum ||
+		header.nStride < header.nDimension || header.nStride % (PACKED_ALIGNMENT / sizeof(float)) != 0 ||
+		!ComputeLayout(header, layout) || layout.nSize > nSize)
+		return false;
+
+	if (header.nFeatures > 0 && (header.nFeatureType != CFeatureEntry::tSIFT || header.nDimension != 128))
+	{
+		printf("error: type %i with descriptor size %i is not supported\n", header.nFeatureType, header.nDimension);
+		return false;
+	}
+
+	// all values after the name are 4 byte words
+	CBasicFileIO::ConvertWords(pData + layout.nContourPointsOffset, (layout.nSize - layout.nContourPointsOffset) / 4);
+
+	unsigned int i;
+
+	// name
+	m_sName.assign((const char *) pData + layout.nNameOffset, header.nNameLength);
+
+	// contour points
+	for (i = 0; i < header.nContourPoints; i++)
+	{
+		const float *record = (const float *) (pData + layout.nContourPointsOffset) + 6 * i;
+		
+		int nHas3dPoint;
+		memcpy(&nHas3dPoint, record + 5, sizeof(int));
+
+		ContourPoint point;
+		Math2d::SetVec(point.point, record[0], record[1]);
+		Math3d::SetVec(point.point3d, record[2], record[3], record[4]);
+		point.bHas3dPoint = nHas3dPoint ? true : false;
+			
+		m_contourPointArray.AddElement(point);
+	}
+
+	// features
+	CFeatureMatrix::Keypoint *pKeypoints = (CFeatureMatrix::Keypoint *) (pData + layout.nKeypointsOffset);
+	float *pDescriptors = (float *) (pData + layout.nDescriptorsOffset);
+
+	m_featureMatrix.SetData(pDescriptors, pKeypoints, header.nFeatures, header.nDimension, header.nStride);
+
+	for (i = 0; i < header.nFeatures; i++)
+	{
+		const CFeatureMatrix::Keypoint &keypoint = pKeypoints[i];
+		m_featureArray.AddElement(new CSIFTFeatureEntry(pDescriptors + i * header.nStride, keypoint.point.x, keypoint.point.y, keypoint.angle, keypoint.scale, keypoint.point3d, true));
+	}
+
+	return true;
+}
+
+bool CFeatureSet::LoadFromStreamFile(FILE *f, const char *pFileName)
+{
 	char buffer[sizeof(HEADER_FEATURE_SET)];
 	if (fread(buffer, sizeof(HEADER_FEATURE_SET) - 1, 1, f) != 1)
 		return false;
@@ -416,5 +746,7 @@ bool CFeatureSet::LoadFromFile(const char *pFileName)
 
 	fclose(f);
 
+	UpdateFeatureMatrix();
+
 	return true;
 }
@@ -49,9 +49,11 @@
 // ****************************************************************************
 
 #include "DataStructures/DynamicArrayTemplatePointer.h"
+#include "Features/FeatureMatrix.h"
 #include "Math/Math2d.h"
 #include "Math/Math3d.h"
 #include <string>
+#include <stdio.h>
 
 
 // ****************************************************************************
@@ -84,8 +86,13 @@ public:
 	};
 
 	// public methods
-	bool SaveToFile(const char *pFileName) const;
-	bool LoadFromFile(const char *pFileName);
+	// bPackedFormat = true writes the packed binary format (little-endian, sections aligned to 64 bytes,
+	// header checksum), which can only be read by LoadFromFile of versions that know this format;
+	// if the features differ in type or descriptor size, the stream format is written instead
+	bool SaveToFile(const char *pFileName, bool bPackedFormat = false) const;
+	// reads both formats; files in the packed format are read with one read call (or memory mapped if
+	// bMemoryMap is set to true) and the entries refer to the descriptors in the file data directly
+	bool LoadFromFile(const char *pFileName, bool bMemoryMap = false);
 
 	void SetName(const char *pName);
 	const char* GetName() const { return m_sName.c_str(); }
@@ -95,6 +102,12 @@ public:
 	void ClearFeatureList();
 	const CDynamicArrayTemplatePointer<CFeatureEntry>& GetFeatureList() const { return m_featureArray; }
 	
+	// packs the descriptors of all features into the feature matrix and attaches the entries to it;
+	// must be called again after adding features. Called by LoadFromFile.
+	// Returns false if the descriptor sizes differ; the previous matrix is kept unchanged in this case.
+	bool UpdateFeatureMatrix();
+	const CFeatureMatrix& GetFeatureMatrix() const { return m_featureMatrix; }
+	
 	void AddContourPoint(const Vec2d &point);
 	void AddContourPoint(const Vec2d &point, const Vec3d &point3d);
 	void ClearContourPointList();
@@ -102,11 +115,24 @@ public:
 
 
 private:
+	// private methods
+	bool SaveToStreamFile(const char *pFileName) const;
+	bool SaveToPackedFile(const char *pFileName) const;
+	bool LoadFromStreamFile(FILE *f, const char *pFileName);
+	bool LoadFromPackedData(unsigned char *pData, size_t nSize);
+	void FreeFileData();
+
 	// private attribute
 	CDynamicArrayTemplatePointer<CFeatureEntry> m_featureArray;
+	CFeatureMatrix m_featureMatrix;
 	CDynamicArrayTemplate<ContourPoint> m_contourPointArray;
 
 	std::string m_sName;
+
+	// contents of a file in the packed format, referred to by m_featureMatrix and the entries
+	unsigned char *m_pFileData;
+	size_t m_nFileDataSize;
+	bool m_bFileDataMapped;
 };
 
 
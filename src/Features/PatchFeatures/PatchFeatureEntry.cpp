@@ -62,8 +62,9 @@ bool CPatchFeatureEntry::ExtractFeature(const CByteImage *pImage, int nWindowSiz
 	// construct new feature entry
 	Math2d::SetVec(point, x, y);
 	m_nSize = nWindowSize * nWindowSize;
-	if (m_pFeature) delete [] m_pFeature;
+	FreeFeature();
 	m_pFeature = new float[m_nSize];
+	m_bOwnMemory = true;
 
 	// extract the feature
 	const int diff = width - nWindowSize;
@@ -47,6 +47,7 @@
 #include "Math/FloatMatrix.h"
 #include "Math/Constants.h"
 #include "DataStructures/DynamicArray.h"
+#include "Threading/WorkerPool.h"
 #include "SIFTFeatureEntry.h"
 
 #include <math.h>
@@ -63,6 +64,61 @@
 #define PRESCALE		1.0f	// input will be prescaled, 2.0f doubles size, 0.5f half size
 #define EDGE_THRESHOLD	10.0f
 
+#define EXTREMA_ROWS_PER_TASK	16	// number of rows of a DoG image searched for extrema by one task
+
+
+// ****************************************************************************
+// Static functions
+// ****************************************************************************
+
+// returns the buffer at the given index, which is (re)allocated if it does not exist yet or has a different size
+static CFloatMatrix* GetMatrix(std::vector<CFloatMatrix *> &buffers, int nIndex, int width, int height)
+{
+	if (nIndex >= (int) buffers.size())
+		buffers.resize(nIndex + 1, 0);
+
+	CFloatMatrix *&pMatrix = buffers[nIndex];
+
+	if (pMatrix && (pMatrix->columns != width || pMatrix->rows != height))
+	{
+		delete pMatrix;
+		pMatrix = 0;
+	}
+
+	if (!pMatrix)
+		pMatrix = new CFloatMatrix(width, height);
+
+	return pMatrix;
+}
+
+static void FreeMatrices(std::vector<CFloatMatrix *> &buffers)
+{
+	for (int i = 0; i < (int) buffers.size(); i++)
+	{
+		if (buffers[i])
+			delete buffers[i];
+	}
+
+	buffers.clear();
+}
+
+struct ExtremaTask
+{
+	const CSIFTFeatureCalculator *pCalculator;
+	int nOctave;
+	int nScale;
+	int nFirstRow, nLastRow;
+	CDynamicArray *pResultList; // allocated by the task if features were found
+};
+
+struct DiffParameters
+{
+	CFloatMatrix * const *ppBlurredImages;
+	CFloatMatrix * const *ppDOGImages;
+	int height;
+};
+
+
 
 // ****************************************************************************
 // Static variables
@@ -93,15 +149,14 @@ CSIFTFeatureCalculator::CSIFTFeatureCalculator(float fThreshold, int nOctaves)
 {
 	m_fThreshold = fThreshold;
 	m_nOctaves = nOctaves;
-
-	m_pResultList = 0;
-	m_bManageMemory = true;
+	m_bQuantize = false;
 	
 	InitializeVariables();
 }
 
 CSIFTFeatureCalculator::~CSIFTFeatureCalculator()
 {
+	FreeScaleSpace();
 }
 
 
@@ -172,29 +227,81 @@ int CSIFTFeatureCalculator::CalculateFeatures(const CByteImage *pImage, CDynamic
 		return -1;
 	}
 
-	m_pResultList = pResultList;
-	m_bManageMemory = bManageMemory;
+
+	const int newWidth = int(pImage->width * PRESCALE);
+	const int newHeight = int(pImage->height * PRESCALE);
+
+	CFloatMatrix *pMatrix = GetMatrix(m_octaveImages, 0, newWidth, newHeight);
 
 	if (PRESCALE == 1.0f)
 	{
-		CFloatMatrix matrix(pImage->width, pImage->height);
-		
-		ImageProcessor::GaussianSmooth(pImage, &matrix, diffsigma0_ * diffsigma0_, 2 * int(ceil(3 * diffsigma0_)) + 1);
-		
-		FindScaleSpaceExtrema(&matrix, PRESCALE, m_nOctaves);
+		ImageProcessor::GaussianSmooth(pImage, pMatrix, diffsigma0_ * diffsigma0_, 2 * int(ceil(3 * diffsigma0_)) + 1);
 	}
 	else
 	{
-		const int newWidth = int(pImage->width * PRESCALE);
-		const int newHeight = int(pImage->height * PRESCALE);
-
-		CFloatMatrix matrix(newWidth, newHeight);
 		CByteImage image(newWidth, newHeight, CByteImage::eGrayScale);
 		
 		ImageProcessor::Resize(pImage, &image);
-		ImageProcessor::GaussianSmooth(&image, &matrix, diffsigma0_ * diffsigma0_, 2 * int(ceil(3 * diffsigma0_)) + 1);
+		ImageProcessor::GaussianSmooth(&image, pMatrix, diffsigma0_ * diffsigma0_, 2 * int(ceil(3 * diffsigma0_)) + 1);
+	}
+
+	int nOctaves;
+	BuildScaleSpace(nOctaves);
+
+	// search all octaves and scales in parallel; the results of each task are collected
+	// separately and appended in the order of a sequential search
+	const int nDOGImages = S + 2;
+	std::vector<ExtremaTask> tasks;
+	
+	for (int nOctave = 0; nOctave < nOctaves; nOctave++)
+	{
+		const int height = m_octaveImages[nOctave]->rows;
+
+		for (int i = 1; i < nDOGImages - 1; i++)
+		{
+			for (int y = 1; y < height - 1; y += EXTREMA_ROWS_PER_TASK)
+			{
+				ExtremaTask task;
+				task.pCalculator = this;
+				task.nOctave = nOctave;
+				task.nScale = i;
+				task.nFirstRow = y;
+				task.nLastRow = y + EXTREMA_ROWS_PER_TASK < height - 1 ? y + EXTREMA_ROWS_PER_TASK : height - 1;
+				task.pResultList = 0;
+				tasks.push_back(task);
+			}
+		}
+	}
+
+	if (!tasks.empty())
+	{
+		const int nTasks = (int) tasks.size();
 		
-		FindScaleSpaceExtrema(&matrix, PRESCALE, m_nOctaves);
+		Threading::ParallelFor(FindScaleSpaceExtrema, &tasks[0], nTasks, 1);
+
+		for (int i = 0; i < nTasks; i++)
+		{
+			if (tasks[i].pResultList)
+			{
+				CDynamicArray *pTaskResultList = tasks[i].pResultList;
+				const int nFeatures = pTaskResultList->GetSize();
+
+				const int nFirst = pResultList->GetSize();
+
+				// the features are not managed by the task list; the flag is set after the
+				// task list has been deleted because it is stored in the elements themselves
+				for (int j = 0; j < nFeatures; j++)
+					pResultList->AddElement(pTaskResultList->GetElementNoCheck(j), false, false);
+
+				delete pTaskResultList;
+
+				if (bManageMemory)
+				{
+					for (int j = 0; j < nFeatures; j++)
+						pResultList->GetElementNoCheck(nFirst + j)->bDelete = true;
+				}
+			}
+		}
 	}
 
 	return pResultList->GetSize();
@@ -624,77 +731,121 @@ static void ScaleDown(const CFloatMatrix *pInputImage, CFloatMatrix *pOutputImag
 	}
 }
 
-static void Diff(const CFloatMatrix *pInputImage1, const CFloatMatrix *pInputImage2, CFloatMatrix *pOutputImage)
+// computes the rows of all DoG images of an octave; item = scale * height + row
+static void DiffRows(void *pParameter, int nBegin, int nEnd)
 {
-	float *input1 = pInputImage1->data;
-	float *input2 = pInputImage2->data;
-	float *output = pOutputImage->data;
-  
-	const int nPixels = pInputImage1->rows * pInputImage1->columns;
-  
-	for (int i = 0; i < nPixels; i++)
-		*output++ = *input1++ - *input2++;
+	const DiffParameters *pParameters = (const DiffParameters *) pParameter;
+	const int height = pParameters->height;
+
+	for (int k = nBegin; k < nEnd; k++)
+	{
+		const int i = k / height;
+		const int y = k - i * height;
+		const int width = pParameters->ppDOGImages[i]->columns;
+
+		const float *input1 = pParameters->ppBlurredImages[i + 1]->data + y * width;
+		const float *input2 = pParameters->ppBlurredImages[i]->data + y * width;
+		float *output = pParameters->ppDOGImages[i]->data + y * width;
+
+		for (int x = 0; x < width; x++)
+			output[x] = input1[x] - input2[x];
+	}
 }
 
 
-void CSIFTFeatureCalculator::FindScaleSpaceExtrema(const CFloatMatrix *pImage, float scale, int nOctave)
+void CSIFTFeatureCalculator::FreeScaleSpace()
 {
-	const int width = pImage->columns;
-	const int height = pImage->rows;
-
-	if (nOctave == 0 || width < 40 || height < 40)
-		return;
+	FreeMatrices(m_octaveImages);
+	FreeMatrices(m_blurredImages);
+	FreeMatrices(m_DOGImages);
+}
 
+void CSIFTFeatureCalculator::BuildScaleSpace(int &nOctaves)
+{
 	const int nBlurredImages = S + 3;
 	const int nDOGImages = nBlurredImages - 1;
-	
-	int i;
 
-	CFloatMatrix** ppBlurredImages = new CFloatMatrix*[nBlurredImages];
-	CFloatMatrix** ppDOGImages = new CFloatMatrix*[nDOGImages];
+	nOctaves = 0;
 
-	CFloatMatrix tempImage(height, width);
-
-	// calculate Gaussians
-	ppBlurredImages[0] = new CFloatMatrix(width, height);
-	ImageProcessor::CopyMatrix(pImage, ppBlurredImages[0]);
-	
-	for (i = 1; i < nBlurredImages; i++)
+	for (int nOctave = 0; nOctave < m_nOctaves; nOctave++)
 	{
-		ppBlurredImages[i] = new CFloatMatrix(width, height);		
-		ImageProcessor::GaussianSmooth(ppBlurredImages[i - 1], ppBlurredImages[i], SIFTDiffSigmas[i] * SIFTDiffSigmas[i], 2 * SIFTKernelRadius[i] + 1);
+		CFloatMatrix *pImage = m_octaveImages[nOctave];
+		const int width = pImage->columns;
+		const int height = pImage->rows;
+
+		if (width < 40 || height < 40)
+			break;
+
+		int i;
+
+		// calculate Gaussians
+		CFloatMatrix *ppBlurredImages[S + 3];
+		ppBlurredImages[0] = pImage;
+		
+		for (i = 1; i < nBlurredImages; i++)
+		{
+			ppBlurredImages[i] = GetMatrix(m_blurredImages, nOctave * nBlurredImages + i, width, height);
+			ImageProcessor::GaussianSmooth(ppBlurredImages[i - 1], ppBlurredImages[i], SIFTDiffSigmas[i] * SIFTDiffSigmas[i], 2 * SIFTKernelRadius[i] + 1);
+		}
+
+		// halfsize image with doubled sigma for later
+		// ppBlurredImages[s] because ppBlurredImages[i] has (k^i * sigma)
+		// therefore k^s * sigma = 2 * sigma as k^s = 2
+		/*
+		the octave is from sigma to 2 * sigma or k^0*sigma to k^s * sigma
+		so we have s intervals from 0 to s having s+1 blurred images
+		but for extrema detection we always need one image before and one after
+		therefore if we want D(k^0*sigma) to D(k^s * sigma) we need
+		D(k^-1*sigma) to D(k^s+1*sigma) having s+3 images.
+		but we shift it to D(k^0*sigma) till D(k^s+2*digma)
+		therefore our doubled sigma is like said before at k^s*sigma.
+		but important is that we have to go from 0 to s+2.
+		*/
+		
+		// calculate Difference of Gaussians (DoG)
+		CFloatMatrix *ppDOGImages[S + 2];
+
+		for (i = 0; i < nDOGImages; i++)
+			ppDOGImages[i] = GetMatrix(m_DOGImages, nOctave * nDOGImages + i, width, height);
+
+		DiffParameters parameters;
+		parameters.ppBlurredImages = ppBlurredImages;
+		parameters.ppDOGImages = ppDOGImages;
+		parameters.height = height;
+
+		Threading::ParallelFor(DiffRows, &parameters, nDOGImages * height, 64);
+
+		nOctaves++;
+
+		if (nOctave + 1 < m_nOctaves)
+			ScaleDown(ppBlurredImages[S], GetMatrix(m_octaveImages, nOctave + 1, width / 2, height / 2));
 	}
+}
 
-	// halfsize image with doubled sigma for later
-	// ppBlurredImages[s] because ppBlurredImages[i] has (k^i * sigma)
-	// therefore k^s * sigma = 2 * sigma as k^s = 2
-	/*
-	the octave is from sigma to 2 * sigma or k^0*sigma to k^s * sigma
-	so we have s intervals from 0 to s having s+1 blurred images
-	but for extrema detection we always need one image before and one after
-	therefore if we want D(k^0*sigma) to D(k^s * sigma) we need
-	D(k^-1*sigma) to D(k^s+1*sigma) having s+3 images.
-	but we shift it to D(k^0*sigma) till D(k^s+2*digma)
-	therefore our doubled sigma is like said before at k^s*sigma.
-	but important is that we have to go from 0 to s+2.
-	*/
+void CSIFTFeatureCalculator::FindScaleSpaceExtrema(void *pParameter, int nBegin, int nEnd)
+{
+	ExtremaTask *pTasks = (ExtremaTask *) pParameter;
+
+	const int nBlurredImages = S + 3;
+	const int nDOGImages = nBlurredImages - 1;
 	
-	// calculate Difference of Gaussians (DoG)
-	for (i = 0; i < nDOGImages; i++)
+	for (int nTask = nBegin; nTask < nEnd; nTask++)
 	{
-		ppDOGImages[i] = new CFloatMatrix(width, height);
-		Diff(ppBlurredImages[i + 1], ppBlurredImages[i], ppDOGImages[i]);
-	}
+		ExtremaTask &task = pTasks[nTask];
+		const CSIFTFeatureCalculator *pCalculator = task.pCalculator;
+		const int nOctave = task.nOctave;
+		const int i = task.nScale;
+
+		const int width = pCalculator->m_octaveImages[nOctave]->columns;
+		const float scale = PRESCALE / float(1 << nOctave);
+		const float fThreshold = pCalculator->m_fThreshold * 255.0f;
+		const CFloatMatrix *pBlurredImage = pCalculator->m_blurredImages[nOctave * nBlurredImages + i];
 		
-	// find scale space extrema
-	const float fThreshold = m_fThreshold * 255.0f;
-	for (i = 1; i < nDOGImages - 1; i++)
-	{
-		const float *dm = ppDOGImages[i - 1]->data;
-		const float *d	= ppDOGImages[i]->data;
-		const float *dp = ppDOGImages[i + 1]->data;
+		const float *dm = pCalculator->m_DOGImages[nOctave * nDOGImages + i - 1]->data;
+		const float *d	= pCalculator->m_DOGImages[nOctave * nDOGImages + i]->data;
+		const float *dp = pCalculator->m_DOGImages[nOctave * nDOGImages + i + 1]->data;
 		
-		for (int y = 1, p = width + 1; y < height - 1; y++, p += 2)
+		for (int y = task.nFirstRow, p = y * width + 1; y < task.nLastRow; y++, p += 2)
 		{
 			for (int x = 1; x < width - 1; x++, p++)
 			{
@@ -770,21 +921,23 @@ void CSIFTFeatureCalculator::FindScaleSpaceExtrema(const CFloatMatrix *pImage, f
 					const float Dxy = 0.25f * (d[p + 1 + width] + d[p - 1 - width] - d[p - 1 + width] - d[p + 1 - width]);
 					const float score = (Dxx + Dyy) * (Dxx + Dyy) / (Dxx * Dyy - Dxy * Dxy); 
 
-					if (fabsf(score) < edgethreshold_)	
-						CreateSIFTDescriptors(ppBlurredImages[i], m_pResultList, float(x), float(y), scale, SIFTSigmas[i], SIFTOrientationWeights + i * 256, m_bManageMemory);
+					if (fabsf(score) < edgethreshold_)
+					{
+						if (!task.pResultList)
+							task.pResultList = new CDynamicArray(100);
+						
+						const int nFirst = task.pResultList->GetSize();
+
+						CreateSIFTDescriptors(pBlurredImage, task.pResultList, float(x), float(y), scale, SIFTSigmas[i], SIFTOrientationWeights + i * 256, false);
+
+						if (pCalculator->m_bQuantize)
+						{
+							for (int j = nFirst; j < task.pResultList->GetSize(); j++)
+								((CSIFTFeatureEntry *) task.pResultList->GetElementNoCheck(j))->Quantize(false);
+						}
+					}
 				}
 			}
 		}
 	}
-
-	CFloatMatrix scaled_image(width / 2, height / 2);
-	ScaleDown(ppBlurredImages[S], &scaled_image);
-
-	// free images
-	for (i = 0; i < nBlurredImages; i++)
-		delete ppBlurredImages[i];
-	for (i = 0; i < nDOGImages; i++)
-		delete ppDOGImages[i];
-	
-	FindScaleSpaceExtrema(&scaled_image, scale / 2, nOctave - 1);
 }
@@ -77,6 +77,12 @@ struct Vec2d;
 /*!
 	\ingroup FeatureComputation
 	\brief Class for computing SIFT features in a CByteImage.
+
+	The scale space images are kept by the instance and reused as long as the image size does not change, so that
+	processing a video does not allocate the scale space for each frame. Therefore, CalculateFeatures must not be called concurrently for the same instance.
+	
+	The scale space extrema of all octaves and scales are searched in parallel on the library-wide worker pool
+	(see Threading::SetNumberOfWorkerThreads(int)); the order of the resulting features does not depend on the number of threads.
 */
 class CSIFTFeatureCalculator : public CFeatureCalculatorInterface
 {
@@ -94,9 +100,12 @@ public:
 	// member access
 	void SetThreshold(float fThreshold) { m_fThreshold = fThreshold;}
 	void SetNumberOfOctaves(int nOctaves) { m_nOctaves = nOctaves; }
+	//! If set to true, the descriptors of the calculated features are quantized to 8 bit (see CSIFTFeatureEntry::Quantize(bool)) and the float descriptors are freed.
+	void SetQuantization(bool bQuantize) { m_bQuantize = bQuantize; }
 
 	float GetThreshold() { return m_fThreshold; }
 	int GetNumberOfOctaves() { return m_nOctaves; }
+	bool GetQuantization() { return m_bQuantize; }
 
 	// public static methods
 	static void InitializeVariables();
@@ -108,14 +117,19 @@ public:
 private:
 	// private methods
 	static void DetermineDominatingOrientations(const CFloatMatrix *pAngleMatrix, const CFloatMatrix *pMagnitudeMatrix, CDynamicArrayTemplate<float> &orientations, bool bPerform80PercentCheck);
-	void FindScaleSpaceExtrema(const CFloatMatrix *pImage, float scale, int nOctave);
+	static void FindScaleSpaceExtrema(void *pParameter, int nBegin, int nEnd);
+	void BuildScaleSpace(int &nOctaves);
+	void FreeScaleSpace();
 
 	// private attributes
 	float m_fThreshold;
 	int m_nOctaves;
+	bool m_bQuantize;
 
-	CDynamicArray *m_pResultList;
-	bool m_bManageMemory;
+	// scale space, reused across calls of CalculateFeatures
+	std::vector<CFloatMatrix *> m_octaveImages; // first image of each octave
+	std::vector<CFloatMatrix *> m_blurredImages; // index: octave * (S + 3) + scale, scale = 0 refers to m_octaveImages
+	std::vector<CFloatMatrix *> m_DOGImages; // index: octave * (S + 2) + scale
 
 	// static constants for internal use
 	static float edgethreshold_;
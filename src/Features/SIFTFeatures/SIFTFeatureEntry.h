@@ -48,6 +48,16 @@
 // ****************************************************************************
 
 #include "../FeatureEntry.h"
+#include "Math/VectorDistance.h"
+
+
+
+// ****************************************************************************
+// Defines
+// ****************************************************************************
+
+// factor for quantizing the components of a normalized SIFT descriptor to 8 bit
+#define SIFT_QUANTIZATION_FACTOR	512.0f
 
 
 
@@ -58,6 +68,10 @@
 /*!
 	\ingroup FeatureRepresentations
 	\brief Data structure for the representation of SIFT features.
+
+	The descriptor can be quantized to 8 bit per component (see Quantize(bool)), reducing its size from 512 to 128 bytes.
+	If both entries are quantized, Error(const CDynamicArrayElement*) is computed with the 8 bit descriptors.
+	Quantized entries without float descriptor are written to files with the dequantized float descriptor.
 */
 class CSIFTFeatureEntry : public CFeatureEntry
 {
@@ -65,18 +79,96 @@ public:
 	// constructors
 	CSIFTFeatureEntry(float *data, float x, float y, float angle, float scale) : CFeatureEntry(data, 128, x, y, angle, scale)
 	{
+		m_pQuantizedFeature = 0;
+	}
+
+	CSIFTFeatureEntry(float *data, float x, float y, float angle, float scale, Vec3d point3d, bool bAttachFeature) : CFeatureEntry(data, 128, x, y, angle, scale, point3d, bAttachFeature)
+	{
+		m_pQuantizedFeature = 0;
 	}
 
 	CSIFTFeatureEntry(float x, float y, float angle, float scale)  : CFeatureEntry(128, x, y, angle, scale)
 	{
+		m_pQuantizedFeature = 0;
 	}
 
 	CSIFTFeatureEntry() : CFeatureEntry(128, 0.0f, 0.0f, 0.0f, 0.0f, Math3d::zero_vec)
 	{
+		m_pQuantizedFeature = 0;
 	}
 
 	CSIFTFeatureEntry(const CSIFTFeatureEntry &featureEntry) : CFeatureEntry(featureEntry)
 	{
+		if (featureEntry.m_pQuantizedFeature)
+		{
+			m_pQuantizedFeature = new unsigned char[128];
+			memcpy(m_pQuantizedFeature, featureEntry.m_pQuantizedFeature, 128);
+		}
+		else
+			m_pQuantizedFeature = 0;
+	}
+
+	// destructor
+	~CSIFTFeatureEntry()
+	{
+		if (m_pQuantizedFeature)
+			delete [] m_pQuantizedFeature;
+	}
+
+
+	// public methods
+	/*!
+		\brief Computes the 8 bit descriptor m_pQuantizedFeature from the float descriptor.
+
+		\param[in] bKeepFloatDescriptor If set to false, the float descriptor is freed and m_pFeature is set to 0.
+	*/
+	void Quantize(bool bKeepFloatDescriptor = false)
+	{
+		if (!m_pFeature)
+			return;
+
+		if (!m_pQuantizedFeature)
+			m_pQuantizedFeature = new unsigned char[128];
+
+		VectorDistance::Quantize(m_pFeature, m_pQuantizedFeature, 128, SIFT_QUANTIZATION_FACTOR);
+
+		if (!bKeepFloatDescriptor)
+			FreeFeature();
+	}
+
+	//! Restores the float descriptor m_pFeature from the 8 bit descriptor if it has been freed.
+	void Dequantize()
+	{
+		if (m_pFeature || !m_pQuantizedFeature)
+			return;
+
+		m_pFeature = new float[128];
+		m_bOwnMemory = true;
+
+		VectorDistance::Dequantize(m_pQuantizedFeature, m_pFeature, 128, SIFT_QUANTIZATION_FACTOR);
+	}
+
+	bool ReadFromFileOld(FILE *pFile)
+	{
+		FreeQuantizedFeature();
+		return CFeatureEntry::ReadFromFileOld(pFile);
+	}
+
+	bool ReadFromFile(FILE *pFile)
+	{
+		FreeQuantizedFeature();
+		return CFeatureEntry::ReadFromFile(pFile);
+	}
+
+	bool WriteToFile(FILE *pFile) const
+	{
+		if (m_pFeature)
+			return CFeatureEntry::WriteToFile(pFile);
+
+		CSIFTFeatureEntry entry(*this);
+		entry.Dequantize();
+
+		return entry.WriteToFile(pFile);
 	}
 
 
@@ -95,14 +187,50 @@ public:
 	{
 		const CSIFTFeatureEntry *pCastedElement = (const CSIFTFeatureEntry *) pElement;
 
-		const float *pFeature = pCastedElement->m_pFeature;
+		if (m_pQuantizedFeature && pCastedElement->m_pQuantizedFeature)
+		{
+			// 1 - <a, b> = |a - b|^2 / 2 for normalized descriptors
+			const unsigned int distance = VectorDistance::SquaredDistance(m_pQuantizedFeature, pCastedElement->m_pQuantizedFeature, 128);
+			return distance * (0.5f / (SIFT_QUANTIZATION_FACTOR * SIFT_QUANTIZATION_FACTOR));
+		}
+
+		float buffer1[128], buffer2[128];
+		const float *pFeature1 = GetFloatDescriptor(buffer1);
+		const float *pFeature2 = pCastedElement->GetFloatDescriptor(buffer2);
 		float sum = 0.0f;
 
 		for (int i = 0; i < m_nSize; i++)
-			sum += pFeature[i] * m_pFeature[i];
+			sum += pFeature2[i] * pFeature1[i];
 			
 		return 1.0f - sum;
 	}
+
+
+private:
+	// private methods
+	const float* GetFloatDescriptor(float *pBuffer) const
+	{
+		if (m_pFeature)
+			return m_pFeature;
+
+		VectorDistance::Dequantize(m_pQuantizedFeature, pBuffer, 128, SIFT_QUANTIZATION_FACTOR);
+
+		return pBuffer;
+	}
+
+	void FreeQuantizedFeature()
+	{
+		if (m_pQuantizedFeature)
+		{
+			delete [] m_pQuantizedFeature;
+			m_pQuantizedFeature = 0;
+		}
+	}
+
+
+public:
+	// public attribute
+	unsigned char *m_pQuantizedFeature;
 };
 
 
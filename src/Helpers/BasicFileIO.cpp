@@ -50,9 +50,18 @@
 #include <new> // for explicitly using correct new/delete operators on VC DSPs
 
 #include "BasicFileIO.h"
+#include "helpers.h"
 #include <string.h>
 #include <stdlib.h>
 
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 
 
 // ****************************************************************************
@@ -176,3 +185,146 @@ int CBasicFileIO::GetFileSize(FILE *fp)
 	fseek(fp, nCurrentFilePos, SEEK_SET);
 	return nFileSize;
 }
+
+unsigned char* CBasicFileIO::LoadFileData(const char *pFileName, size_t &nSize, bool bMemoryMap, bool &bMapped, int nAlignment)
+{
+	unsigned char *pData = 0;
+
+	nSize = 0;
+	bMapped = false;
+
+	FILE *f = fopen(pFileName, "rb");
+	if (!f)
+		return 0;
+
+	fseek(f, 0, SEEK_END);
+	const long nFileSize = ftell(f);
+	rewind(f);
+
+	if (nFileSize <= 0)
+	{
+		fclose(f);
+		return 0;
+	}
+
+	if (bMemoryMap)
+	{
+		#ifdef WIN32
+		HANDLE hFile = CreateFileA(pFileName, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+
+		if (hFile != INVALID_HANDLE_VALUE)
+		{
+			HANDLE hMapping = CreateFileMapping(hFile, 0, PAGE_WRITECOPY, 0, 0, 0);
+
+			if (hMapping)
+			{
+				// copy-on-write, so that the caller may modify the data
+				pData = (unsigned char *) MapViewOfFile(hMapping, FILE_MAP_COPY, 0, 0, 0);
+				CloseHandle(hMapping);
+			}
+
+			CloseHandle(hFile);
+		}
+		#else
+		const int fd = open(pFileName, O_RDONLY);
+
+		if (fd != -1)
+		{
+			// copy-on-write, so that the caller may modify the data
+			void *pMapping = mmap(0, nFileSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+			pData = pMapping != MAP_FAILED ? (unsigned char *) pMapping : 0;
+			close(fd);
+		}
+		#endif
+
+		bMapped = pData != 0;
+	}
+
+	if (!pData)
+	{
+		// read the whole file with one call
+		pData = (unsigned char *) aligned_malloc(nFileSize, nAlignment);
+
+		if (!pData || fread(pData, nFileSize, 1, f) != 1)
+		{
+			if (pData)
+				aligned_free(pData);
+
+			fclose(f);
+			return 0;
+		}
+	}
+
+	fclose(f);
+
+	nSize = nFileSize;
+
+	return pData;
+}
+
+void CBasicFileIO::FreeFileData(unsigned char *pData, size_t nSize, bool bMapped)
+{
+	if (!pData)
+		return;
+
+	if (bMapped)
+	{
+		#ifdef WIN32
+		UnmapViewOfFile(pData);
+		#else
+		munmap(pData, nSize);
+		#endif
+	}
+	else
+		aligned_free(pData);
+}
+
+size_t CBasicFileIO::Align(size_t nOffset, size_t nAlignment)
+{
+	return (nOffset + nAlignment - 1) / nAlignment * nAlignment;
+}
+
+bool CBasicFileIO::WritePadding(FILE *fp, size_t &nOffset, size_t nTargetOffset)
+{
+	const char zeros[64] = { 0 };
+
+	while (nOffset < nTargetOffset)
+	{
+		const size_t n = nTargetOffset - nOffset < sizeof(zeros) ? nTargetOffset - nOffset : sizeof(zeros);
+
+		if (fwrite(zeros, n, 1, fp) != 1)
+			return false;
+
+		nOffset += n;
+	}
+
+	nOffset = nTargetOffset;
+
+	return true;
+}
+
+unsigned int CBasicFileIO::ComputeChecksum(const void *pData, size_t nSize)
+{
+	const unsigned char *p = (const unsigned char *) pData;
+	unsigned int nChecksum = 2166136261u;
+
+	for (size_t i = 0; i < nSize; i++)
+	{
+		nChecksum ^= p[i];
+		nChecksum *= 16777619u;
+	}
+
+	return nChecksum;
+}
+
+void CBasicFileIO::ConvertWords(void *pData, size_t nWords)
+{
+	(void) pData;
+	(void) nWords;
+
+	#ifdef IVT_BIG_ENDIAN
+	int *p = (int *) pData;
+	for (size_t i = 0; i < nWords; i++)
+		p[i] = invert_byte_order_int(p[i]);
+	#endif
+}
@@ -80,6 +80,23 @@ public:
 	
 	// others
 	static int GetFileSize(FILE *fp);
+	
+	// whole files
+	// reads a file into memory aligned to nAlignment bytes with one call, or maps it (copy-on-write) if bMemoryMap is true
+	// (falls back to reading if mapping fails); bMapped tells which one happened, returns 0 on failure
+	static unsigned char* LoadFileData(const char *pFileName, size_t &nSize, bool bMemoryMap, bool &bMapped, int nAlignment = 64);
+	// frees the memory returned by LoadFileData
+	static void FreeFileData(unsigned char *pData, size_t nSize, bool bMapped);
+	
+	// binary formats with aligned sections
+	// rounds nOffset up to the next multiple of nAlignment
+	static size_t Align(size_t nOffset, size_t nAlignment);
+	// writes zero bytes from nOffset up to nTargetOffset and sets nOffset to nTargetOffset
+	static bool WritePadding(FILE *fp, size_t &nOffset, size_t nTargetOffset);
+	// 32 bit FNV-1a hash of nSize bytes
+	static unsigned int ComputeChecksum(const void *pData, size_t nSize);
+	// converts 4 byte words between little-endian and the byte order of the platform (no-op on little-endian platforms)
+	static void ConvertWords(void *pData, size_t nWords);
 };
 
 
@@ -55,6 +55,7 @@
 class CByteImage;
 class CShortImage;
 class CIntImage;
+class CBinaryImage;
 struct Vec2d;
 
 
@@ -90,6 +91,9 @@ DECLARE_OPTIMIZED_FUNCTION_5(CannyList, const CByteImage *pInputImage, CVec2dArr
 // Morphological filters
 DECLARE_OPTIMIZED_FUNCTION_2(Erode3x3, const CByteImage *pInputImage, CByteImage *pOutputImage)
 DECLARE_OPTIMIZED_FUNCTION_2(Dilate3x3, const CByteImage *pInputImage, CByteImage *pOutputImage)
+// rows of the van Herk/Gil-Werman filters: pOutput[i] = max/min(pInput1[i], pInput2[i]), set to 255 for non-zero results if bBinarize is true
+DECLARE_OPTIMIZED_FUNCTION_5(MorphologyRowMax, const unsigned char *pInput1, const unsigned char *pInput2, unsigned char *pOutput, int nPixels, bool bBinarize)
+DECLARE_OPTIMIZED_FUNCTION_5(MorphologyRowMin, const unsigned char *pInput1, const unsigned char *pInput2, unsigned char *pOutput, int nPixels, bool bBinarize)
 
 // Point operators
 DECLARE_OPTIMIZED_FUNCTION_3(ThresholdBinarize, const CByteImage *pInputImage, CByteImage *pOutputImage, unsigned char nThreshold)
@@ -133,6 +137,8 @@ DECLARE_OPTIMIZED_FUNCTION_2(PixelSum, const CByteImage *pImage, unsigned int &r
 
 // Conversion (grayscale, RGB24 (split))
 DECLARE_OPTIMIZED_FUNCTION_3(ConvertImage, const CByteImage *pInputImage, CByteImage *pOutputImage, bool bFast)
+DECLARE_OPTIMIZED_FUNCTION_2(ConvertImage_ByteToBinary, const CByteImage *pInputImage, CBinaryImage *pOutputImage)
+DECLARE_OPTIMIZED_FUNCTION_2(ConvertImage_BinaryToByte, const CBinaryImage *pInputImage, CByteImage *pOutputImage)
 
 // Harris
 DECLARE_OPTIMIZED_FUNCTION_5_RET(CalculateHarrisInterestPoints, const CByteImage *pInputImage, Vec2d *pInterestPoints, int nMaxPoints, float fQualityLevel, float fMinDistance)
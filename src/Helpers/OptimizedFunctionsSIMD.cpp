@@ -0,0 +1,1410 @@
+// ****************************************************************************
+// This file is part of the Integrating Vision Toolkit (IVT).
+//
+// The IVT is maintained by the Karlsruhe Institute of Technology (KIT)
+// (www.kit.edu) in cooperation with the company Keyetech (www.keyetech.de).
+//
+// Copyright (C) 2014 Karlsruhe Institute of Technology (KIT).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the KIT nor the names of its contributors may be
+//    used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE KIT AND CONTRIBUTORS “AS IS” AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE KIT OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ****************************************************************************
+// ****************************************************************************
+// Filename:  OptimizedFunctionsSIMD.cpp
+// Author:    agent
+// Date:      17.10.2026
+// ****************************************************************************
+
+
+// ****************************************************************************
+// Includes
+// ****************************************************************************
+
+#include <new> // for explicitly using correct new/delete operators on VC DSPs
+
+#include "OptimizedFunctionsSIMD.h"
+
+#include "Helpers/OptimizedFunctions.h"
+#include "Image/ByteImage.h"
+#include "Image/ShortImage.h"
+#include "Image/IntImage.h"
+#include "Image/BinaryImage.h"
+#include "Image/ImageProcessor.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+
+#if defined(USE_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define SIMD_AVAILABLE
+#endif
+
+
+#ifdef SIMD_AVAILABLE
+
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#include <immintrin.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define SIMD_TARGET_SSSE3
+#define SIMD_TARGET_AVX2
+#else
+#include <cpuid.h>
+#define SIMD_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+
+
+// ****************************************************************************
+// CPU detection
+// ****************************************************************************
+
+static void ExecuteCPUID(int nLeaf, int nSubLeaf, unsigned int regs[4])
+{
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuidex(info, nLeaf, nSubLeaf);
+	regs[0] = info[0]; regs[1] = info[1]; regs[2] = info[2]; regs[3] = info[3];
+#else
+	__cpuid_count(nLeaf, nSubLeaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+static unsigned int xgetbv0()
+{
+#if defined(_MSC_VER)
+	return (unsigned int) _xgetbv(0);
+#else
+	unsigned int eax, edx;
+	__asm__ __volatile__("xgetbv" : "=a" (eax), "=d" (edx) : "c" (0));
+	return eax;
+#endif
+}
+
+static OptimizedFunctionsSIMD::InstructionSet DetectInstructionSet()
+{
+	unsigned int regs[4];
+	
+	ExecuteCPUID(0, 0, regs);
+	const unsigned int nMaxLeaf = regs[0];
+	
+	if (nMaxLeaf < 1)
+		return OptimizedFunctionsSIMD::eNone;
+	
+	ExecuteCPUID(1, 0, regs);
+	const unsigned int ecx = regs[2], edx = regs[3];
+	
+	if (!(edx & (1 << 26)))
+		return OptimizedFunctionsSIMD::eNone;
+	
+	if (!(ecx & (1 << 9)))
+		return OptimizedFunctionsSIMD::eSSE2;
+	
+	// AVX2 requires OS support for saving the YMM registers (OSXSAVE + XCR0)
+	const bool bOSXSave = (ecx & (1 << 27)) != 0;
+	const bool bAVX = (ecx & (1 << 28)) != 0;
+	
+	if (nMaxLeaf >= 7 && bOSXSave && bAVX && (xgetbv0() & 6) == 6)
+	{
+		ExecuteCPUID(7, 0, regs);
+		
+		if (regs[1] & (1 << 5))
+			return OptimizedFunctionsSIMD::eAVX2;
+	}
+	
+	return OptimizedFunctionsSIMD::eSSSE3;
+}
+
+
+// ****************************************************************************
+// Static variables
+// ****************************************************************************
+
+static OptimizedFunctionsSIMD::InstructionSet instructionSet = OptimizedFunctionsSIMD::eNone;
+static bool bInstructionSetDetected = false;
+
+// (1 << 20) / i, identical to the table in ImageProcessor.cpp
+static int division_table[256];
+
+
+
+// ****************************************************************************
+// Helpers
+// ****************************************************************************
+
+static inline bool IsGrayScale(const CByteImage *pImage)
+{
+	return pImage->type == CByteImage::eGrayScale;
+}
+
+// copies the input image in case of in-place operation, the caller must delete the result if != pInputImage
+static const CByteImage *GetSafeInput(const CByteImage *pInputImage, const CByteImage *pOutputImage)
+{
+	if (pInputImage->pixels != pOutputImage->pixels)
+		return pInputImage;
+	
+	CByteImage *pCopy = new CByteImage(pInputImage);
+	ImageProcessor::CopyImage(pInputImage, pCopy);
+	
+	return pCopy;
+}
+
+// element-wise operations process unpadded images as one single row
+static inline int GetRowCount(const CByteImage *pImage, bool bPadded)
+{
+	if (!bPadded)
+		return 1;
+	
+	return pImage->type == CByteImage::eRGB24Split ? 3 * pImage->height : pImage->height;
+}
+
+static inline __m128i abs_epi16(__m128i x)
+{
+	return _mm_max_epi16(x, _mm_sub_epi16(_mm_setzero_si128(), x));
+}
+
+static inline __m128i load_epu8_epi16(const unsigned char *p)
+{
+	return _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *) p), _mm_setzero_si128());
+}
+
+
+
+// ****************************************************************************
+// Element-wise binary operators
+// ****************************************************************************
+
+#define SIMD_BINARY_OPERATOR(name, sse2, avx2, scalar) \
+	struct Op##name \
+	{ \
+		static inline __m128i SSE2(__m128i a, __m128i b) { return sse2; } \
+		SIMD_TARGET_AVX2 static inline __m256i AVX2(__m256i a, __m256i b) { return avx2; } \
+		static inline unsigned char Scalar(int a, int b) { return (unsigned char) (scalar); } \
+	};
+
+SIMD_BINARY_OPERATOR(And, _mm_and_si128(a, b), _mm256_and_si256(a, b), a & b)
+SIMD_BINARY_OPERATOR(Or, _mm_or_si128(a, b), _mm256_or_si256(a, b), a | b)
+SIMD_BINARY_OPERATOR(Xor, _mm_xor_si128(a, b), _mm256_xor_si256(a, b), a ^ b)
+SIMD_BINARY_OPERATOR(Add, _mm_add_epi8(a, b), _mm256_add_epi8(a, b), a + b)
+SIMD_BINARY_OPERATOR(AddWithSaturation, _mm_adds_epu8(a, b), _mm256_adds_epu8(a, b), a + b > 255 ? 255 : a + b)
+SIMD_BINARY_OPERATOR(Subtract, _mm_sub_epi8(a, b), _mm256_sub_epi8(a, b), a - b)
+SIMD_BINARY_OPERATOR(SubtractWithSaturation, _mm_subs_epu8(a, b), _mm256_subs_epu8(a, b), a > b ? a - b : 0)
+SIMD_BINARY_OPERATOR(AbsoluteDifference, _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a)), _mm256_or_si256(_mm256_subs_epu8(a, b), _mm256_subs_epu8(b, a)), a > b ? a - b : b - a)
+SIMD_BINARY_OPERATOR(Average, _mm_avg_epu8(a, b), _mm256_avg_epu8(a, b), (a + b + 1) >> 1)
+SIMD_BINARY_OPERATOR(Min, _mm_min_epu8(a, b), _mm256_min_epu8(a, b), a < b ? a : b)
+SIMD_BINARY_OPERATOR(Max, _mm_max_epu8(a, b), _mm256_max_epu8(a, b), a > b ? a : b)
+
+template <class Op>
+SIMD_TARGET_AVX2 static int BinaryOperatorAVX2(const unsigned char *input1, const unsigned char *input2, unsigned char *output, int nBytes)
+{
+	int i;
+	
+	for (i = 0; i + 32 <= nBytes; i += 32)
+	{
+		const __m256i a = _mm256_loadu_si256((const __m256i *) (input1 + i));
+		const __m256i b = _mm256_loadu_si256((const __m256i *) (input2 + i));
+		_mm256_storeu_si256((__m256i *) (output + i), Op::AVX2(a, b));
+	}
+	
+	return i;
+}
+
+template <class Op>
+static int BinaryOperator(const CByteImage *pInputImage1, const CByteImage *pInputImage2, CByteImage *pOutputImage)
+{
+	if (!pInputImage1->IsCompatible(pInputImage2) || !pInputImage1->IsCompatible(pOutputImage))
+		return 0;
+	
+	const int nRows = GetRowCount(pInputImage1, pInputImage1->IsPadded() || pInputImage2->IsPadded() || pOutputImage->IsPadded());
+	const int nBytes = pInputImage1->width * pInputImage1->height * pInputImage1->bytesPerPixel / nRows;
+	
+	for (int y = 0; y < nRows; y++)
+	{
+		const unsigned char *input1 = pInputImage1->pixels + y * pInputImage1->GetStride();
+		const unsigned char *input2 = pInputImage2->pixels + y * pInputImage2->GetStride();
+		unsigned char *output = pOutputImage->pixels + y * pOutputImage->GetStride();
+		int i = 0;
+		
+		if (instructionSet >= OptimizedFunctionsSIMD::eAVX2)
+			i = BinaryOperatorAVX2<Op>(input1, input2, output, nBytes);
+		
+		for (; i + 16 <= nBytes; i += 16)
+		{
+			const __m128i a = _mm_loadu_si128((const __m128i *) (input1 + i));
+			const __m128i b = _mm_loadu_si128((const __m128i *) (input2 + i));
+			_mm_storeu_si128((__m128i *) (output + i), Op::SSE2(a, b));
+		}
+		
+		for (; i < nBytes; i++)
+			output[i] = Op::Scalar(input1[i], input2[i]);
+	}
+	
+	return 1;
+}
+
+static int SIMD_And(const CByteImage *p1, const CByteImage *p2, CByteImage *pOut) { return BinaryOperator<OpAnd>(p1, p2, pOut); }
+static int SIMD_Or(const CByteImage *p1, const CByteImage *p2, CByteImage *pOut) { return BinaryOperator<OpOr>(p1, p2, pOut); }
+static int SIMD_Xor(const CByteImage *p1, const CByteImage *p2, CByteImage *pOut) { return BinaryOperator<OpXor>(p1, p2, pOut); }
+static int SIMD_Add(const CByteImage *p1, const CByteImage *p2, CByteImage *pOut) { return BinaryOperator<OpAdd>(p1, p2, pOut); }
+static int SIMD_AddWithSaturation(const CByteImage *p1, const CByteImage *p2, CByteImage *pOut) { return BinaryOperator<OpAddWithSaturation>(p1, p2, pOut); }
+static int SIMD_Subtract(const CByteImage *p1, const CByteImage *p2, CByteImage *pOut) { return BinaryOperator<OpSubtract>(p1, p2, pOut); }
+static int SIMD_SubtractWithSaturation(const CByteImage *p1, const CByteImage *p2, CByteImage *pOut) { return BinaryOperator<OpSubtractWithSaturation>(p1, p2, pOut); }
+static int SIMD_AbsoluteDifference(const CByteImage *p1, const CByteImage *p2, CByteImage *pOut) { return BinaryOperator<OpAbsoluteDifference>(p1, p2, pOut); }
+static int SIMD_Average(const CByteImage *p1, const CByteImage *p2, CByteImage *pOut) { return BinaryOperator<OpAverage>(p1, p2, pOut); }
+static int SIMD_Min(const CByteImage *p1, const CByteImage *p2, CByteImage *pOut) { return BinaryOperator<OpMin>(p1, p2, pOut); }
+static int SIMD_Max(const CByteImage *p1, const CByteImage *p2, CByteImage *pOut) { return BinaryOperator<OpMax>(p1, p2, pOut); }
+
+
+
+// ****************************************************************************
+// Point operators
+// ****************************************************************************
+
+static int SIMD_Invert(const CByteImage *pInputImage, CByteImage *pOutputImage)
+{
+	if (!pInputImage->IsCompatible(pOutputImage))
+		return 0;
+	
+	const int nRows = GetRowCount(pInputImage, pInputImage->IsPadded() || pOutputImage->IsPadded());
+	const int nBytes = pInputImage->width * pInputImage->height * pInputImage->bytesPerPixel / nRows;
+	const __m128i ones = _mm_set1_epi8((char) 0xff);
+	
+	for (int y = 0; y < nRows; y++)
+	{
+		const unsigned char *input = pInputImage->pixels + y * pInputImage->GetStride();
+		unsigned char *output = pOutputImage->pixels + y * pOutputImage->GetStride();
+		int i;
+		
+		for (i = 0; i + 16 <= nBytes; i += 16)
+			_mm_storeu_si128((__m128i *) (output + i), _mm_xor_si128(_mm_loadu_si128((const __m128i *) (input + i)), ones));
+		
+		for (; i < nBytes; i++)
+			output[i] = 255 - input[i];
+	}
+	
+	return 1;
+}
+
+enum ThresholdMode
+{
+	eBinarize,
+	eBinarizeInverse,
+	eFilter,
+	eFilterInverse
+};
+
+static int Threshold(const CByteImage *pInputImage, CByteImage *pOutputImage, unsigned char nThreshold, ThresholdMode mode)
+{
+	if (!pInputImage->IsCompatible(pOutputImage) || !IsGrayScale(pInputImage))
+		return 0;
+	
+	const int nRows = GetRowCount(pInputImage, pInputImage->IsPadded() || pOutputImage->IsPadded());
+	const int nPixels = pInputImage->width * pInputImage->height / nRows;
+	const __m128i t = _mm_set1_epi8((char) nThreshold);
+	const bool bInverse = mode == eBinarizeInverse || mode == eFilterInverse;
+	const bool bFilter = mode == eFilter || mode == eFilterInverse;
+	
+	for (int y = 0; y < nRows; y++)
+	{
+		const unsigned char *input = pInputImage->pixels + y * pInputImage->GetStride();
+		unsigned char *output = pOutputImage->pixels + y * pOutputImage->GetStride();
+		int i;
+		
+		for (i = 0; i + 16 <= nPixels; i += 16)
+		{
+			const __m128i x = _mm_loadu_si128((const __m128i *) (input + i));
+			
+			// x >= t <=> max(x, t) == x, x <= t <=> min(x, t) == x
+			const __m128i mask = _mm_cmpeq_epi8(bInverse ? _mm_min_epu8(x, t) : _mm_max_epu8(x, t), x);
+			
+			_mm_storeu_si128((__m128i *) (output + i), bFilter ? _mm_and_si128(mask, x) : mask);
+		}
+		
+		for (; i < nPixels; i++)
+		{
+			const bool bPass = bInverse ? input[i] <= nThreshold : input[i] >= nThreshold;
+			output[i] = bPass ? (bFilter ? input[i] : 255) : 0;
+		}
+	}
+	
+	return 1;
+}
+
+static int SIMD_ThresholdBinarize(const CByteImage *pInputImage, CByteImage *pOutputImage, unsigned char nThreshold) { return Threshold(pInputImage, pOutputImage, nThreshold, eBinarize); }
+static int SIMD_ThresholdBinarizeInverse(const CByteImage *pInputImage, CByteImage *pOutputImage, unsigned char nThreshold) { return Threshold(pInputImage, pOutputImage, nThreshold, eBinarizeInverse); }
+static int SIMD_ThresholdFilter(const CByteImage *pInputImage, CByteImage *pOutputImage, unsigned char nThreshold) { return Threshold(pInputImage, pOutputImage, nThreshold, eFilter); }
+static int SIMD_ThresholdFilterInverse(const CByteImage *pInputImage, CByteImage *pOutputImage, unsigned char nThreshold) { return Threshold(pInputImage, pOutputImage, nThreshold, eFilterInverse); }
+
+
+
+// ****************************************************************************
+// Min / Max / Sum
+// ****************************************************************************
+
+static void MinMax(const unsigned char *input, int nPixels, unsigned char &min, unsigned char &max)
+{
+	__m128i vmin = _mm_set1_epi8((char) 0xff);
+	__m128i vmax = _mm_setzero_si128();
+	int i;
+	
+	for (i = 0; i + 16 <= nPixels; i += 16)
+	{
+		const __m128i x = _mm_loadu_si128((const __m128i *) (input + i));
+		vmin = _mm_min_epu8(vmin, x);
+		vmax = _mm_max_epu8(vmax, x);
+	}
+	
+	unsigned char buffer_min[16], buffer_max[16];
+	_mm_storeu_si128((__m128i *) buffer_min, vmin);
+	_mm_storeu_si128((__m128i *) buffer_max, vmax);
+	
+	min = 255;
+	max = 0;
+	
+	for (int j = 0; j < 16; j++)
+	{
+		if (buffer_min[j] < min) min = buffer_min[j];
+		if (buffer_max[j] > max) max = buffer_max[j];
+	}
+	
+	for (; i < nPixels; i++)
+	{
+		if (input[i] < min) min = input[i];
+		if (input[i] > max) max = input[i];
+	}
+}
+
+static int SIMD_MinMaxValue(const CByteImage *pInputImage, unsigned char &min, unsigned char &max)
+{
+	if (!IsGrayScale(pInputImage))
+		return 0;
+	
+	const int nRows = GetRowCount(pInputImage, pInputImage->IsPadded());
+	const int nPixels = pInputImage->width * pInputImage->height / nRows;
+	
+	MinMax(pInputImage->pixels, nPixels, min, max);
+	
+	for (int y = 1; y < nRows; y++)
+	{
+		unsigned char row_min, row_max;
+		
+		MinMax(pInputImage->pixels + y * pInputImage->GetStride(), nPixels, row_min, row_max);
+		
+		if (row_min < min) min = row_min;
+		if (row_max > max) max = row_max;
+	}
+	
+	return 1;
+}
+
+static int SIMD_MinValue(const CByteImage *pInputImage, unsigned char &min)
+{
+	unsigned char max;
+	return SIMD_MinMaxValue(pInputImage, min, max);
+}
+
+static int SIMD_MaxValue(const CByteImage *pInputImage, unsigned char &max)
+{
+	unsigned char min;
+	return SIMD_MinMaxValue(pInputImage, min, max);
+}
+
+static int SIMD_PixelSum(const CByteImage *pImage, unsigned int &resultSum)
+{
+	if (!IsGrayScale(pImage))
+		return 0;
+	
+	const int nRows = GetRowCount(pImage, pImage->IsPadded());
+	const int nPixels = pImage->width * pImage->height / nRows;
+	const __m128i zero = _mm_setzero_si128();
+	unsigned int result = 0;
+	
+	for (int y = 0; y < nRows; y++)
+	{
+		const unsigned char *input = pImage->pixels + y * pImage->GetStride();
+		__m128i sum = _mm_setzero_si128();
+		int i;
+		
+		for (i = 0; i + 16 <= nPixels; i += 16)
+			sum = _mm_add_epi64(sum, _mm_sad_epu8(_mm_loadu_si128((const __m128i *) (input + i)), zero));
+		
+		// the generic implementation accumulates with unsigned int overflow semantics as well
+		result += (unsigned int) _mm_cvtsi128_si32(sum) + (unsigned int) _mm_cvtsi128_si32(_mm_srli_si128(sum, 8));
+		
+		for (; i < nPixels; i++)
+			result += input[i];
+	}
+	
+	resultSum = result;
+	
+	return 1;
+}
+
+
+
+// ****************************************************************************
+// Smoothing filters
+// ****************************************************************************
+
+// horizontal part of the 3x3 Gaussian (l + 2c + r) for one row, d is the distance between horizontally neighboring values (1 or 3)
+static void Gaussian3x3Row(const unsigned char *row, unsigned short *result, int w, int d)
+{
+	const __m128i zero = _mm_setzero_si128();
+	int x = d;
+	
+	for (; x + 16 + d <= w; x += 16)
+	{
+		const __m128i l = _mm_loadu_si128((const __m128i *) (row + x - d));
+		const __m128i c = _mm_loadu_si128((const __m128i *) (row + x));
+		const __m128i r = _mm_loadu_si128((const __m128i *) (row + x + d));
+		
+		_mm_storeu_si128((__m128i *) (result + x), _mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi8(l, zero), _mm_unpacklo_epi8(r, zero)), _mm_slli_epi16(_mm_unpacklo_epi8(c, zero), 1)));
+		_mm_storeu_si128((__m128i *) (result + x + 8), _mm_add_epi16(_mm_add_epi16(_mm_unpackhi_epi8(l, zero), _mm_unpackhi_epi8(r, zero)), _mm_slli_epi16(_mm_unpackhi_epi8(c, zero), 1)));
+	}
+	
+	for (; x < w - d; x++)
+		result[x] = row[x - d] + (row[x] << 1) + row[x + d];
+}
+
+static int SIMD_GaussianSmooth3x3(const CByteImage *pInputImage, CByteImage *pOutputImage)
+{
+	if (!pInputImage->IsCompatible(pOutputImage) || pInputImage->type == CByteImage::eRGB24Split)
+		return 0;
+
+	if (pInputImage->width < 3 || pInputImage->height < 3)
+		return 0;
+	
+	const CByteImage *pSafeInputImage = GetSafeInput(pInputImage, pOutputImage);
+	
+	const int height = pInputImage->height;
+	const int d = pInputImage->bytesPerPixel;
+	const int w = pInputImage->width * d;
+	const int input_stride = pSafeInputImage->GetStride();
+	const int output_stride = pOutputImage->GetStride();
+	const unsigned char *p = pSafeInputImage->pixels;
+	unsigned char *output = pOutputImage->pixels;
+	const __m128i eight = _mm_set1_epi16(8);
+	
+	// ring buffer holding the horizontal results of three consecutive rows
+	unsigned short *pBuffer = new unsigned short[3 * w];
+	unsigned short *rows[3] = { pBuffer, pBuffer + w, pBuffer + 2 * w };
+	
+	Gaussian3x3Row(p, rows[0], w, d);
+	Gaussian3x3Row(p + input_stride, rows[1], w, d);
+	
+	for (int y = 1; y < height - 1; y++)
+	{
+		const unsigned short *top = rows[(y - 1) % 3];
+		const unsigned short *center = rows[y % 3];
+		unsigned short *bottom = rows[(y + 1) % 3];
+		
+		Gaussian3x3Row(p + (y + 1) * input_stride, bottom, w, d);
+		
+		const unsigned char *row = p + y * input_stride;
+		unsigned char *out = output + y * output_stride;
+		int x = d;
+		
+		for (; x + 16 + d <= w; x += 16)
+		{
+			const __m128i lo = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(
+				_mm_add_epi16(_mm_loadu_si128((const __m128i *) (top + x)), _mm_loadu_si128((const __m128i *) (bottom + x))),
+				_mm_slli_epi16(_mm_loadu_si128((const __m128i *) (center + x)), 1)), eight), 4);
+			const __m128i hi = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(
+				_mm_add_epi16(_mm_loadu_si128((const __m128i *) (top + x + 8)), _mm_loadu_si128((const __m128i *) (bottom + x + 8))),
+				_mm_slli_epi16(_mm_loadu_si128((const __m128i *) (center + x + 8)), 1)), eight), 4);
+			
+			_mm_storeu_si128((__m128i *) (out + x), _mm_packus_epi16(lo, hi));
+		}
+		
+		for (; x < w - d; x++)
+			out[x] = (top[x] + (center[x] << 1) + bottom[x] + 8) >> 4;
+		
+		// copy left and right border
+		memcpy(out, row, d);
+		memcpy(out + w - d, row + w - d, d);
+	}
+	
+	// copy top and bottom border
+	memcpy(output, p, w);
+	memcpy(output + (height - 1) * output_stride, p + (height - 1) * input_stride, w);
+	
+	delete [] pBuffer;
+	
+	if (pSafeInputImage != pInputImage)
+		delete pSafeInputImage;
+	
+	return 1;
+}
+
+static inline __m128i Binomial5(__m128i a, __m128i b, __m128i c, __m128i d, __m128i e)
+{
+	// a + 4b + 6c + 4d + e + 8
+	const __m128i c2 = _mm_slli_epi16(c, 1);
+	
+	return _mm_add_epi16(_mm_add_epi16(_mm_add_epi16(a, e), _mm_slli_epi16(_mm_add_epi16(_mm_add_epi16(b, d), c), 2)), _mm_add_epi16(c2, _mm_set1_epi16(8)));
+}
+
+static int SIMD_GaussianSmooth5x5(const CByteImage *pInputImage, CByteImage *pOutputImage)
+{
+	if (!pInputImage->IsCompatible(pOutputImage) || !IsGrayScale(pInputImage))
+		return 0;
+
+	const int width = pInputImage->width;
+	const int height = pInputImage->height;
+	
+	if (width < 5 || height < 5)
+		return 0;
+	
+	unsigned char *temp = new unsigned char[width * height];
+	const unsigned char *input = pInputImage->pixels;
+	unsigned char *output = pOutputImage->pixels;
+	const __m128i zero = _mm_setzero_si128();
+	int x, y;
+	
+	// x direction
+	for (y = 0; y < height; y++)
+	{
+		const unsigned char *in = input + y * pInputImage->GetStride();
+		unsigned char *t = temp + y * width;
+		
+		t[0] = (11 * in[0] + (in[1] << 2) + in[2] + 8) >> 4;
+		t[1] = (5 * in[0] + 6 * in[1] + (in[2] << 2) + in[3] + 8) >> 4;
+		
+		for (x = 2; x + 18 <= width; x += 16)
+		{
+			const __m128i a = _mm_loadu_si128((const __m128i *) (in + x - 2));
+			const __m128i b = _mm_loadu_si128((const __m128i *) (in + x - 1));
+			const __m128i c = _mm_loadu_si128((const __m128i *) (in + x));
+			const __m128i d = _mm_loadu_si128((const __m128i *) (in + x + 1));
+			const __m128i e = _mm_loadu_si128((const __m128i *) (in + x + 2));
+			
+			const __m128i lo = _mm_srli_epi16(Binomial5(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero), _mm_unpacklo_epi8(c, zero), _mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi8(e, zero)), 4);
+			const __m128i hi = _mm_srli_epi16(Binomial5(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero), _mm_unpackhi_epi8(c, zero), _mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi8(e, zero)), 4);
+			
+			_mm_storeu_si128((__m128i *) (t + x), _mm_packus_epi16(lo, hi));
+		}
+		
+		for (; x < width - 2; x++)
+			t[x] = (in[x - 2] + (in[x - 1] << 2) + 6 * in[x] + (in[x + 1] << 2) + in[x + 2] + 8) >> 4;
+		
+		t[x] = (in[x - 2] + (in[x - 1] << 2) + 6 * in[x] + 5 * in[x + 1] + 8) >> 4;
+		t[x + 1] = (in[x - 1] + (in[x] << 2) + 11 * in[x + 1] + 8) >> 4;
+	}
+	
+	// y direction
+	const int width2 = width << 1;
+	
+	const int output_stride = pOutputImage->GetStride();
+	
+	for (x = 0; x < width; x++)
+	{
+		output[x] = (11 * temp[x] + (temp[x + width] << 2) + temp[x + width2] + 8) >> 4;
+		output[x + output_stride] = (5 * temp[x] + 6 * temp[x + width] + (temp[x + width2] << 2) + temp[x + 3 * width] + 8) >> 4;
+	}
+	
+	for (y = 2; y < height - 2; y++)
+	{
+		const unsigned char *t = temp + y * width;
+		unsigned char *out = output + y * output_stride;
+		
+		for (x = 0; x + 16 <= width; x += 16)
+		{
+			const __m128i a = _mm_loadu_si128((const __m128i *) (t + x - width2));
+			const __m128i b = _mm_loadu_si128((const __m128i *) (t + x - width));
+			const __m128i c = _mm_loadu_si128((const __m128i *) (t + x));
+			const __m128i d = _mm_loadu_si128((const __m128i *) (t + x + width));
+			const __m128i e = _mm_loadu_si128((const __m128i *) (t + x + width2));
+			
+			const __m128i lo = _mm_srli_epi16(Binomial5(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero), _mm_unpacklo_epi8(c, zero), _mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi8(e, zero)), 4);
+			const __m128i hi = _mm_srli_epi16(Binomial5(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero), _mm_unpackhi_epi8(c, zero), _mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi8(e, zero)), 4);
+			
+			_mm_storeu_si128((__m128i *) (out + x), _mm_packus_epi16(lo, hi));
+		}
+		
+		for (; x < width; x++)
+			out[x] = (t[x - width2] + (t[x - width] << 2) + 6 * t[x] + (t[x + width] << 2) + t[x + width2] + 8) >> 4;
+	}
+	
+	for (x = 0; x < width; x++)
+	{
+		const int offset = (height - 2) * width + x;
+		const int output_offset = (height - 2) * output_stride + x;
+		output[output_offset] = (temp[offset - width2] + (temp[offset - width] << 2) + 6 * temp[offset] + 5 * temp[offset + width] + 8) >> 4;
+		output[output_offset + output_stride] = (temp[offset - width] + (temp[offset] << 2) + 11 * temp[offset + width] + 8) >> 4;
+	}
+	
+	delete [] temp;
+	
+	return 1;
+}
+
+
+
+// ****************************************************************************
+// Edge filters
+// ****************************************************************************
+
+enum EdgeFilterType
+{
+	eSobelX,
+	eSobelY,
+	ePrewittX,
+	ePrewittY
+};
+
+// computes 8 filter responses starting at p, stride is the distance between two rows in bytes
+static inline __m128i EdgeFilter(const unsigned char *p, int stride, EdgeFilterType type)
+{
+	if (type == eSobelX || type == ePrewittX)
+	{
+		const __m128i left = _mm_add_epi16(load_epu8_epi16(p - stride - 1), load_epu8_epi16(p + stride - 1));
+		const __m128i right = _mm_add_epi16(load_epu8_epi16(p - stride + 1), load_epu8_epi16(p + stride + 1));
+		const __m128i l = load_epu8_epi16(p - 1), r = load_epu8_epi16(p + 1);
+		
+		if (type == eSobelX)
+			return _mm_sub_epi16(_mm_add_epi16(right, _mm_slli_epi16(r, 1)), _mm_add_epi16(left, _mm_slli_epi16(l, 1)));
+		
+		return _mm_sub_epi16(_mm_add_epi16(right, r), _mm_add_epi16(left, l));
+	}
+	else
+	{
+		const __m128i top = _mm_add_epi16(load_epu8_epi16(p - stride - 1), load_epu8_epi16(p - stride + 1));
+		const __m128i bottom = _mm_add_epi16(load_epu8_epi16(p + stride - 1), load_epu8_epi16(p + stride + 1));
+		const __m128i t = load_epu8_epi16(p - stride), b = load_epu8_epi16(p + stride);
+		
+		if (type == eSobelY)
+			return _mm_sub_epi16(_mm_add_epi16(bottom, _mm_slli_epi16(b, 1)), _mm_add_epi16(top, _mm_slli_epi16(t, 1)));
+		
+		return _mm_sub_epi16(_mm_add_epi16(bottom, b), _mm_add_epi16(top, t));
+	}
+}
+
+static inline int EdgeFilterScalar(const unsigned char *p, int stride, EdgeFilterType type)
+{
+	switch (type)
+	{
+		case eSobelX: return p[-stride + 1] + (p[1] << 1) + p[stride + 1] - p[-stride - 1] - (p[-1] << 1) - p[stride - 1];
+		case eSobelY: return p[stride - 1] + (p[stride] << 1) + p[stride + 1] - p[-stride - 1] - (p[-stride] << 1) - p[-stride + 1];
+		case ePrewittX: return p[-stride + 1] + p[1] + p[stride + 1] - p[-stride - 1] - p[-1] - p[stride - 1];
+		case ePrewittY: return p[stride - 1] + p[stride] + p[stride + 1] - p[-stride - 1] - p[-stride] - p[-stride + 1];
+	}
+	
+	return 0;
+}
+
+static int EdgeFilter(const CByteImage *pInputImage, CShortImage *pOutputImage, bool bAbsoluteValue, EdgeFilterType type)
+{
+	if (pInputImage->width != pOutputImage->width || pInputImage->height != pOutputImage->height || !IsGrayScale(pInputImage))
+		return 0;
+	
+	const int width = pInputImage->width;
+	const int height = pInputImage->height;
+	
+	if (width < 3 || height < 3)
+		return 0;
+	
+	const int stride = pInputImage->GetStride();
+	const unsigned char *input = pInputImage->pixels;
+	short *output = pOutputImage->pixels;
+	
+	// zero frame
+	memset(output, 0, width * sizeof(short));
+	memset(output + (height - 1) * pOutputImage->GetStride(), 0, width * sizeof(short));
+	
+	for (int y = 1; y < height - 1; y++)
+	{
+		const unsigned char *in = input + y * stride;
+		short *out = output + y * pOutputImage->GetStride();
+		int x;
+		
+		out[0] = out[width - 1] = 0;
+		
+		for (x = 1; x + 9 <= width; x += 8)
+		{
+			const __m128i value = EdgeFilter(in + x, stride, type);
+			_mm_storeu_si128((__m128i *) (out + x), bAbsoluteValue ? abs_epi16(value) : value);
+		}
+		
+		for (; x < width - 1; x++)
+		{
+			const int value = EdgeFilterScalar(in + x, stride, type);
+			out[x] = bAbsoluteValue ? abs(value) : value;
+		}
+	}
+	
+	return 1;
+}
+
+static int SIMD_SobelX(const CByteImage *pInputImage, CShortImage *pOutputImage, bool bAbsoluteValue) { return EdgeFilter(pInputImage, pOutputImage, bAbsoluteValue, eSobelX); }
+static int SIMD_SobelY(const CByteImage *pInputImage, CShortImage *pOutputImage, bool bAbsoluteValue) { return EdgeFilter(pInputImage, pOutputImage, bAbsoluteValue, eSobelY); }
+static int SIMD_PrewittX(const CByteImage *pInputImage, CShortImage *pOutputImage, bool bAbsoluteValue) { return EdgeFilter(pInputImage, pOutputImage, bAbsoluteValue, ePrewittX); }
+static int SIMD_PrewittY(const CByteImage *pInputImage, CShortImage *pOutputImage, bool bAbsoluteValue) { return EdgeFilter(pInputImage, pOutputImage, bAbsoluteValue, ePrewittY); }
+
+static int GradientImage(const CByteImage *pInputImage, CByteImage *pOutputImage, bool bSobel)
+{
+	if (pInputImage->width != pOutputImage->width || pInputImage->height != pOutputImage->height || !IsGrayScale(pInputImage) || !IsGrayScale(pOutputImage))
+		return 0;
+	
+	const int width = pInputImage->width;
+	const int height = pInputImage->height;
+	
+	if (width < 3 || height < 3)
+		return 0;
+	
+	const CByteImage *pSafeInputImage = GetSafeInput(pInputImage, pOutputImage);
+	const int stride = pSafeInputImage->GetStride();
+	const unsigned char *input = pSafeInputImage->pixels;
+	unsigned char *output = pOutputImage->pixels;
+	const EdgeFilterType typeX = bSobel ? eSobelX : ePrewittX;
+	const EdgeFilterType typeY = bSobel ? eSobelY : ePrewittY;
+	
+	memset(output, 0, width);
+	memset(output + (height - 1) * pOutputImage->GetStride(), 0, width);
+	
+	for (int y = 1; y < height - 1; y++)
+	{
+		const unsigned char *in = input + y * stride;
+		unsigned char *out = output + y * pOutputImage->GetStride();
+		int x;
+		
+		out[0] = out[width - 1] = 0;
+		
+		for (x = 1; x + 9 <= width; x += 8)
+		{
+			const __m128i value = _mm_max_epi16(abs_epi16(EdgeFilter(in + x, stride, typeX)), abs_epi16(EdgeFilter(in + x, stride, typeY)));
+			_mm_storel_epi64((__m128i *) (out + x), _mm_packus_epi16(value, value));
+		}
+		
+		for (; x < width - 1; x++)
+		{
+			const int value_x = abs(EdgeFilterScalar(in + x, stride, typeX));
+			const int value_y = abs(EdgeFilterScalar(in + x, stride, typeY));
+			const int value = value_x > value_y ? value_x : value_y;
+			
+			out[x] = value > 255 ? 255 : value;
+		}
+	}
+	
+	if (pSafeInputImage != pInputImage)
+		delete pSafeInputImage;
+	
+	return 1;
+}
+
+static int SIMD_CalculateGradientImageSobel(const CByteImage *pInputImage, CByteImage *pOutputImage) { return GradientImage(pInputImage, pOutputImage, true); }
+static int SIMD_CalculateGradientImagePrewitt(const CByteImage *pInputImage, CByteImage *pOutputImage) { return GradientImage(pInputImage, pOutputImage, false); }
+
+
+
+// ****************************************************************************
+// Morphological filters
+// ****************************************************************************
+
+// Semantics of the generic implementation: only pixels (u, v) with 1 <= u <= width - 2 and
+// 1 <= v <= height - 2 are considered as input. Dilate sets all pixels in the 3x3 neighborhood
+// of a non-zero input pixel to 255, Erode sets a pixel to 255 if all pixels of its 3x3 neighborhood
+// are non-zero. All other pixels are set to 0.
+static int Morphology3x3(const CByteImage *pInputImage, CByteImage *pOutputImage, bool bDilate)
+{
+	if (!pInputImage->IsCompatible(pOutputImage) || !IsGrayScale(pInputImage))
+		return 0;
+	
+	const int width = pInputImage->width;
+	const int height = pInputImage->height;
+	
+	if (width < 3 || height < 3)
+		return 0;
+	
+	const CByteImage *pSafeInputImage = GetSafeInput(pInputImage, pOutputImage);
+	const int stride = pSafeInputImage->GetStride();
+	const unsigned char *input = pSafeInputImage->pixels;
+	unsigned char *output = pOutputImage->pixels;
+	
+	// vertical result, padded by one zero byte left and right
+	unsigned char *pVertical = new unsigned char[width + 2];
+	unsigned char *vertical = pVertical + 1;
+	pVertical[0] = pVertical[width + 1] = 0;
+	
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i ones = _mm_set1_epi8((char) 0xff);
+	
+	for (int y = 0; y < height; y++)
+	{
+		unsigned char *out = output + y * pOutputImage->GetStride();
+		int x;
+		
+		if (!bDilate && (y == 0 || y == height - 1))
+		{
+			memset(out, 0, width);
+			continue;
+		}
+		
+		// determine range of contributing rows
+		const int y1 = bDilate ? (y - 1 < 1 ? 1 : y - 1) : y - 1;
+		const int y2 = bDilate ? (y + 1 > height - 2 ? height - 2 : y + 1) : y + 1;
+		
+		// vertical pass (for dilation, the left and right border columns are not considered as input)
+		const int min_x = bDilate ? 1 : 0;
+		const int max_x = bDilate ? width - 1 : width;
+		
+		for (x = min_x; x + 16 <= max_x; x += 16)
+		{
+			__m128i acc = bDilate ? zero : ones;
+			
+			for (int yy = y1; yy <= y2; yy++)
+			{
+				const __m128i nonzero = _mm_xor_si128(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) (input + yy * stride + x)), zero), ones);
+				acc = bDilate ? _mm_or_si128(acc, nonzero) : _mm_and_si128(acc, nonzero);
+			}
+			
+			_mm_storeu_si128((__m128i *) (vertical + x), acc);
+		}
+		
+		for (; x < max_x; x++)
+		{
+			unsigned char acc = bDilate ? 0 : 255;
+			
+			for (int yy = y1; yy <= y2; yy++)
+			{
+				const unsigned char nonzero = input[yy * stride + x] ? 255 : 0;
+				acc = bDilate ? (acc | nonzero) : (acc & nonzero);
+			}
+			
+			vertical[x] = acc;
+		}
+		
+		if (bDilate)
+			vertical[0] = vertical[width - 1] = 0;
+		
+		// horizontal pass
+		for (x = 0; x + 16 <= width; x += 16)
+		{
+			const __m128i l = _mm_loadu_si128((const __m128i *) (vertical + x - 1));
+			const __m128i c = _mm_loadu_si128((const __m128i *) (vertical + x));
+			const __m128i r = _mm_loadu_si128((const __m128i *) (vertical + x + 1));
+			
+			_mm_storeu_si128((__m128i *) (out + x), bDilate ? _mm_or_si128(_mm_or_si128(l, c), r) : _mm_and_si128(_mm_and_si128(l, c), r));
+		}
+		
+		for (; x < width; x++)
+			out[x] = bDilate ? (vertical[x - 1] | vertical[x] | vertical[x + 1]) : (vertical[x - 1] & vertical[x] & vertical[x + 1]);
+		
+		if (!bDilate)
+			out[0] = out[width - 1] = 0;
+	}
+	
+	delete [] pVertical;
+	
+	if (pSafeInputImage != pInputImage)
+		delete pSafeInputImage;
+	
+	return 1;
+}
+
+static int SIMD_Dilate3x3(const CByteImage *pInputImage, CByteImage *pOutputImage) { return Morphology3x3(pInputImage, pOutputImage, true); }
+static int SIMD_Erode3x3(const CByteImage *pInputImage, CByteImage *pOutputImage) { return Morphology3x3(pInputImage, pOutputImage, false); }
+
+template <class Op>
+SIMD_TARGET_AVX2 static int MorphologyRowAVX2(const unsigned char *input1, const unsigned char *input2, unsigned char *output, int nPixels, bool bBinarize)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i ones = _mm256_set1_epi8((char) 0xff);
+	int i;
+	
+	for (i = 0; i + 32 <= nPixels; i += 32)
+	{
+		const __m256i a = _mm256_loadu_si256((const __m256i *) (input1 + i));
+		const __m256i b = _mm256_loadu_si256((const __m256i *) (input2 + i));
+		const __m256i v = Op::AVX2(a, b);
+		_mm256_storeu_si256((__m256i *) (output + i), bBinarize ? _mm256_xor_si256(_mm256_cmpeq_epi8(v, zero), ones) : v);
+	}
+	
+	return i;
+}
+
+// one row of the vertical pass of the van Herk/Gil-Werman filters in ImageProcessor::Dilate and ImageProcessor::Erode
+template <class Op>
+static int MorphologyRow(const unsigned char *input1, const unsigned char *input2, unsigned char *output, int nPixels, bool bBinarize)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i ones = _mm_set1_epi8((char) 0xff);
+	int i = 0;
+	
+	if (instructionSet >= OptimizedFunctionsSIMD::eAVX2)
+		i = MorphologyRowAVX2<Op>(input1, input2, output, nPixels, bBinarize);
+	
+	for (; i + 16 <= nPixels; i += 16)
+	{
+		const __m128i a = _mm_loadu_si128((const __m128i *) (input1 + i));
+		const __m128i b = _mm_loadu_si128((const __m128i *) (input2 + i));
+		const __m128i v = Op::SSE2(a, b);
+		_mm_storeu_si128((__m128i *) (output + i), bBinarize ? _mm_xor_si128(_mm_cmpeq_epi8(v, zero), ones) : v);
+	}
+	
+	for (; i < nPixels; i++)
+	{
+		const unsigned char v = Op::Scalar(input1[i], input2[i]);
+		output[i] = bBinarize ? (v ? 255 : 0) : v;
+	}
+	
+	return 1;
+}
+
+static int SIMD_MorphologyRowMax(const unsigned char *p1, const unsigned char *p2, unsigned char *pOut, int nPixels, bool bBinarize) { return MorphologyRow<OpMax>(p1, p2, pOut, nPixels, bBinarize); }
+static int SIMD_MorphologyRowMin(const unsigned char *p1, const unsigned char *p2, unsigned char *pOut, int nPixels, bool bBinarize) { return MorphologyRow<OpMin>(p1, p2, pOut, nPixels, bBinarize); }
+
+
+
+// ****************************************************************************
+// Color conversion
+// ****************************************************************************
+
+// converts 16 RGB24 pixels (48 bytes) to grayscale
+SIMD_TARGET_SSSE3 static inline void ConvertRGB24ToGray16(const unsigned char *input, unsigned char *output, bool bFast)
+{
+	const __m128i a = _mm_loadu_si128((const __m128i *) input);
+	const __m128i b = _mm_loadu_si128((const __m128i *) (input + 16));
+	const __m128i c = _mm_loadu_si128((const __m128i *) (input + 32));
+	
+	const __m128i r = _mm_or_si128(_mm_or_si128(
+		_mm_shuffle_epi8(a, _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+		_mm_shuffle_epi8(b, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1))),
+		_mm_shuffle_epi8(c, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13)));
+	const __m128i g = _mm_or_si128(_mm_or_si128(
+		_mm_shuffle_epi8(a, _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+		_mm_shuffle_epi8(b, _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1))),
+		_mm_shuffle_epi8(c, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14)));
+	const __m128i bl = _mm_or_si128(_mm_or_si128(
+		_mm_shuffle_epi8(a, _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+		_mm_shuffle_epi8(b, _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1))),
+		_mm_shuffle_epi8(c, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15)));
+	
+	const __m128i zero = _mm_setzero_si128();
+	__m128i result;
+	
+	if (bFast)
+	{
+		// (r + 2g + b + 2) >> 2
+		const __m128i two = _mm_set1_epi16(2);
+		const __m128i lo = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi8(r, zero), _mm_unpacklo_epi8(bl, zero)), _mm_add_epi16(_mm_slli_epi16(_mm_unpacklo_epi8(g, zero), 1), two)), 2);
+		const __m128i hi = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(_mm_unpackhi_epi8(r, zero), _mm_unpackhi_epi8(bl, zero)), _mm_add_epi16(_mm_slli_epi16(_mm_unpackhi_epi8(g, zero), 1), two)), 2);
+		result = _mm_packus_epi16(lo, hi);
+	}
+	else
+	{
+		// (9797 r + 19235 g + 3736 b + 16384) >> 15, exact with 32 bit intermediate results
+		const __m128i crg = _mm_set1_epi32((19235 << 16) | 9797);
+		const __m128i cb1 = _mm_set1_epi32((16384 << 16) | 3736);
+		const __m128i one = _mm_set1_epi16(1);
+		
+		const __m128i r16lo = _mm_unpacklo_epi8(r, zero), r16hi = _mm_unpackhi_epi8(r, zero);
+		const __m128i g16lo = _mm_unpacklo_epi8(g, zero), g16hi = _mm_unpackhi_epi8(g, zero);
+		const __m128i b16lo = _mm_unpacklo_epi8(bl, zero), b16hi = _mm_unpackhi_epi8(bl, zero);
+		
+		__m128i v0 = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(r16lo, g16lo), crg), _mm_madd_epi16(_mm_unpacklo_epi16(b16lo, one), cb1));
+		__m128i v1 = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(r16lo, g16lo), crg), _mm_madd_epi16(_mm_unpackhi_epi16(b16lo, one), cb1));
+		__m128i v2 = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(r16hi, g16hi), crg), _mm_madd_epi16(_mm_unpacklo_epi16(b16hi, one), cb1));
+		__m128i v3 = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(r16hi, g16hi), crg), _mm_madd_epi16(_mm_unpackhi_epi16(b16hi, one), cb1));
+		
+		v0 = _mm_srli_epi32(v0, 15);
+		v1 = _mm_srli_epi32(v1, 15);
+		v2 = _mm_srli_epi32(v2, 15);
+		v3 = _mm_srli_epi32(v3, 15);
+		
+		result = _mm_packus_epi16(_mm_packs_epi32(v0, v1), _mm_packs_epi32(v2, v3));
+	}
+	
+	_mm_storeu_si128((__m128i *) output, result);
+}
+
+SIMD_TARGET_SSSE3 static int ConvertRGB24ToGraySSSE3(const unsigned char *input, unsigned char *output, int nPixels, bool bFast)
+{
+	int i;
+	
+	for (i = 0; i + 16 <= nPixels; i += 16)
+		ConvertRGB24ToGray16(input + 3 * i, output + i, bFast);
+	
+	return i;
+}
+
+static int SIMD_ConvertImage(const CByteImage *pInputImage, CByteImage *pOutputImage, bool bFast)
+{
+	if (instructionSet < OptimizedFunctionsSIMD::eSSSE3)
+		return 0;
+	
+	if (pInputImage->width != pOutputImage->width || pInputImage->height != pOutputImage->height ||
+		pInputImage->type != CByteImage::eRGB24 || pOutputImage->type != CByteImage::eGrayScale)
+		return 0;
+	
+	const int nRows = GetRowCount(pInputImage, pInputImage->IsPadded() || pOutputImage->IsPadded());
+	const int nPixels = pInputImage->width * pInputImage->height / nRows;
+	
+	for (int y = 0; y < nRows; y++)
+	{
+		const unsigned char *input = pInputImage->pixels + y * pInputImage->GetStride();
+		unsigned char *output = pOutputImage->pixels + y * pOutputImage->GetStride();
+		
+		int i = ConvertRGB24ToGraySSSE3(input, output, nPixels, bFast);
+		
+		if (bFast)
+		{
+			for (int offset = 3 * i; i < nPixels; i++, offset += 3)
+				output[i] = (input[offset] + (input[offset + 1] << 1) + input[offset + 2] + 2) >> 2;
+		}
+		else
+		{
+			for (int offset = 3 * i; i < nPixels; i++, offset += 3)
+				output[i] = (9797 * input[offset] + 19235 * input[offset + 1] + 3736 * input[offset + 2] + 16384) >> 15;
+		}
+	}
+	
+	return 1;
+}
+
+// bit j of each word is set for a non-zero input byte j, 16 bytes per movemask
+static int SIMD_ConvertImage_ByteToBinary(const CByteImage *pInputImage, CBinaryImage *pOutputImage)
+{
+	typedef CBinaryImage::Word Word;
+	
+	if (pInputImage->width != pOutputImage->width || pInputImage->height != pOutputImage->height || !IsGrayScale(pInputImage))
+		return 0;
+	
+	const int width = pInputImage->width;
+	const int nWords = pOutputImage->stride;
+	const int nFullWords = width / 64;
+	const __m128i zero = _mm_setzero_si128();
+	
+	for (int y = 0; y < pInputImage->height; y++)
+	{
+		const unsigned char *input = pInputImage->pixels + y * pInputImage->GetStride();
+		Word *output = pOutputImage->words + y * nWords;
+		int i;
+		
+		for (i = 0; i < nFullWords; i++, input += 64)
+		{
+			const unsigned int m0 = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) input), zero));
+			const unsigned int m1 = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) (input + 16)), zero));
+			const unsigned int m2 = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) (input + 32)), zero));
+			const unsigned int m3 = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) (input + 48)), zero));
+			
+			output[i] = ~(Word(m0 | (m1 << 16)) | (Word(m2 | (m3 << 16)) << 32));
+		}
+		
+		if (i < nWords)
+		{
+			const int n = width - 64 * nFullWords;
+			Word word = 0;
+			
+			for (int j = 0; j < n; j++)
+			{
+				if (input[j])
+					word |= Word(1) << j;
+			}
+			
+			output[i] = word;
+		}
+	}
+	
+	return 1;
+}
+
+// byte j of the result is 255 if bit j of the 16 bit mask is set
+static inline __m128i ExpandBits16(unsigned int mask, const __m128i bits)
+{
+	const __m128i v = _mm_unpacklo_epi64(_mm_set1_epi8((char) (mask & 0xff)), _mm_set1_epi8((char) (mask >> 8)));
+	return _mm_cmpeq_epi8(_mm_and_si128(v, bits), bits);
+}
+
+static int SIMD_ConvertImage_BinaryToByte(const CBinaryImage *pInputImage, CByteImage *pOutputImage)
+{
+	typedef CBinaryImage::Word Word;
+	
+	if (pInputImage->width != pOutputImage->width || pInputImage->height != pOutputImage->height || !IsGrayScale(pOutputImage))
+		return 0;
+	
+	const int width = pInputImage->width;
+	const int nWords = pInputImage->stride;
+	const int nFullWords = width / 64;
+	const __m128i bits = _mm_set_epi8((char) 128, 64, 32, 16, 8, 4, 2, 1, (char) 128, 64, 32, 16, 8, 4, 2, 1);
+	
+	for (int y = 0; y < pInputImage->height; y++)
+	{
+		const Word *input = pInputImage->words + y * nWords;
+		unsigned char *output = pOutputImage->pixels + y * pOutputImage->GetStride();
+		int i;
+		
+		for (i = 0; i < nFullWords; i++, output += 64)
+		{
+			const Word word = input[i];
+			const unsigned int low = (unsigned int) word;
+			const unsigned int high = (unsigned int) (word >> 32);
+			
+			_mm_storeu_si128((__m128i *) output, ExpandBits16(low & 0xffff, bits));
+			_mm_storeu_si128((__m128i *) (output + 16), ExpandBits16(low >> 16, bits));
+			_mm_storeu_si128((__m128i *) (output + 32), ExpandBits16(high & 0xffff, bits));
+			_mm_storeu_si128((__m128i *) (output + 48), ExpandBits16(high >> 16, bits));
+		}
+		
+		if (i < nWords)
+		{
+			const int n = width - 64 * nFullWords;
+			const Word word = input[i];
+			
+			for (int j = 0; j < n; j++)
+				output[j] = (unsigned char) (0 - int((word >> j) & 1));
+		}
+	}
+	
+	return 1;
+}
+
+
+// HSV conversion of 8 pixels given as 32 bit integers, result: h | s << 8 | v << 16
+SIMD_TARGET_AVX2 static inline __m256i CalculateHSV8(__m256i r, __m256i g, __m256i b)
+{
+	const __m256i max = _mm256_max_epi32(_mm256_max_epi32(r, g), b);
+	const __m256i min = _mm256_min_epi32(_mm256_min_epi32(r, g), b);
+	const __m256i delta = _mm256_sub_epi32(max, min);
+	
+	const __m256i s = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_mullo_epi32(delta, _mm256_set1_epi32(255)), _mm256_i32gather_epi32(division_table, max, 4)), 20);
+	
+	const __m256i r_max = _mm256_cmpeq_epi32(r, max);
+	const __m256i g_max = _mm256_andnot_si256(r_max, _mm256_cmpeq_epi32(g, max));
+	
+	// select difference and base hue depending on the maximum channel
+	__m256i diff = _mm256_sub_epi32(r, g);
+	__m256i base = _mm256_set1_epi32(120);
+	diff = _mm256_blendv_epi8(diff, _mm256_sub_epi32(b, r), g_max);
+	base = _mm256_blendv_epi8(base, _mm256_set1_epi32(60), g_max);
+	diff = _mm256_blendv_epi8(diff, _mm256_sub_epi32(g, b), r_max);
+	base = _mm256_blendv_epi8(base, _mm256_set1_epi32(180), r_max);
+	
+	const __m256i q = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_mullo_epi32(_mm256_abs_epi32(diff), _mm256_set1_epi32(30)), _mm256_i32gather_epi32(division_table, delta, 4)), 20);
+	const __m256i positive = _mm256_cmpgt_epi32(diff, _mm256_setzero_si256());
+	
+	__m256i h = _mm256_blendv_epi8(_mm256_sub_epi32(base, q), _mm256_add_epi32(base, q), positive);
+	h = _mm256_sub_epi32(h, _mm256_and_si256(_mm256_cmpgt_epi32(h, _mm256_set1_epi32(179)), _mm256_set1_epi32(180)));
+	
+	return _mm256_or_si256(_mm256_or_si256(h, _mm256_slli_epi32(s, 8)), _mm256_slli_epi32(max, 16));
+}
+
+static inline void CalculateHSVScalar(int r, int g, int b, unsigned char &h_out, unsigned char &s_out, unsigned char &v_out)
+{
+	const int max = r > g ? (r > b ? r : b) : (g > b ? g : b);
+	const int min = r < g ? (r < b ? r : b) : (g < b ? g : b);
+	const int delta = max - min;
+	const int s = (255 * delta * division_table[max]) >> 20;
+	int h;
+	
+	if (r == max)
+		h = g > b ? 180 + ((30 * (g - b) * division_table[delta]) >> 20) : 180 - ((30 * (b - g) * division_table[delta]) >> 20);
+	else if (g == max)
+		h = b > r ? 60 + ((30 * (b - r) * division_table[delta]) >> 20) : 60 - ((30 * (r - b) * division_table[delta]) >> 20);
+	else
+		h = r > g ? 120 + ((30 * (r - g) * division_table[delta]) >> 20) : 120 - ((30 * (g - r) * division_table[delta]) >> 20);
+	
+	if (h >= 180) h -= 180;
+	
+	h_out = h;
+	s_out = s;
+	v_out = max;
+}
+
+SIMD_TARGET_AVX2 static int CalculateHSVImageAVX2(const unsigned char *input, unsigned char *output, int nPixels, bool bSplit)
+{
+	const __m256i mask = _mm256_set1_epi32(0xff);
+	int hsv[8];
+	int i = 0;
+	
+	if (bSplit)
+	{
+		for (; i + 8 <= nPixels; i += 8)
+		{
+			const __m256i r = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *) (input + i)));
+			const __m256i g = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *) (input + nPixels + i)));
+			const __m256i b = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *) (input + 2 * nPixels + i)));
+			
+			_mm256_storeu_si256((__m256i *) hsv, CalculateHSV8(r, g, b));
+			
+			for (int j = 0; j < 8; j++)
+			{
+				output[i + j] = hsv[j] & 0xff;
+				output[nPixels + i + j] = (hsv[j] >> 8) & 0xff;
+				output[2 * nPixels + i + j] = hsv[j] >> 16;
+			}
+		}
+	}
+	else
+	{
+		const __m256i indices = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+		
+		// each gather reads 4 bytes per pixel, so the last pixel is never processed here
+		for (; i + 9 <= nPixels; i += 8)
+		{
+			const __m256i rgbx = _mm256_i32gather_epi32((const int *) (input + 3 * i), indices, 1);
+			const __m256i r = _mm256_and_si256(rgbx, mask);
+			const __m256i g = _mm256_and_si256(_mm256_srli_epi32(rgbx, 8), mask);
+			const __m256i b = _mm256_and_si256(_mm256_srli_epi32(rgbx, 16), mask);
+			
+			_mm256_storeu_si256((__m256i *) hsv, CalculateHSV8(r, g, b));
+			
+			unsigned char *out = output + 3 * i;
+			
+			for (int j = 0; j < 8; j++, out += 3)
+			{
+				out[0] = hsv[j] & 0xff;
+				out[1] = (hsv[j] >> 8) & 0xff;
+				out[2] = hsv[j] >> 16;
+			}
+		}
+	}
+	
+	return i;
+}
+
+static int SIMD_CalculateHSVImage(const CByteImage *pInputImage, CByteImage *pOutputImage)
+{
+	if (instructionSet < OptimizedFunctionsSIMD::eAVX2)
+		return 0;
+	
+	if (!pInputImage->IsCompatible(pOutputImage) || (pInputImage->type != CByteImage::eRGB24 && pInputImage->type != CByteImage::eRGB24Split))
+		return 0;
+	
+	const bool bPadded = pInputImage->IsPadded() || pOutputImage->IsPadded();
+	const bool bSplit = pInputImage->type == CByteImage::eRGB24Split;
+	
+	// the channel planes of padded eRGB24Split images are handled by the generic implementation
+	if (bSplit && bPadded)
+		return 0;
+	
+	const int nRows = GetRowCount(pInputImage, bPadded);
+	const int nPixels = pInputImage->width * pInputImage->height / nRows;
+	
+	for (int y = 0; y < nRows; y++)
+	{
+		const unsigned char *input = pInputImage->pixels + y * pInputImage->GetStride();
+		unsigned char *output = pOutputImage->pixels + y * pOutputImage->GetStride();
+		
+		int i = CalculateHSVImageAVX2(input, output, nPixels, bSplit);
+		
+		for (; i < nPixels; i++)
+		{
+			if (bSplit)
+				CalculateHSVScalar(input[i], input[nPixels + i], input[2 * nPixels + i], output[i], output[nPixels + i], output[2 * nPixels + i]);
+			else
+				CalculateHSVScalar(input[3 * i], input[3 * i + 1], input[3 * i + 2], output[3 * i], output[3 * i + 1], output[3 * i + 2]);
+		}
+	}
+	
+	return 1;
+}
+
+#endif /* SIMD_AVAILABLE */
+
+
+
+// ****************************************************************************
+// Functions
+// ****************************************************************************
+
+OptimizedFunctionsSIMD::InstructionSet OptimizedFunctionsSIMD::GetInstructionSet()
+{
+#ifdef SIMD_AVAILABLE
+	if (!bInstructionSetDetected)
+	{
+		instructionSet = DetectInstructionSet();
+		bInstructionSetDetected = true;
+	}
+	
+	return instructionSet;
+#else
+	return eNone;
+#endif
+}
+
+bool OptimizedFunctionsSIMD::Register()
+{
+#ifdef SIMD_AVAILABLE
+	if (GetInstructionSet() < eSSE2)
+		return false;
+	
+	division_table[0] = 0;
+	for (int i = 1; i < 256; i++)
+		division_table[i] = (1 << 20) / i;
+	
+	OptimizedGaussianSmooth3x3 = SIMD_GaussianSmooth3x3;
+	OptimizedGaussianSmooth5x5 = SIMD_GaussianSmooth5x5;
+	
+	OptimizedSobelX = SIMD_SobelX;
+	OptimizedSobelY = SIMD_SobelY;
+	OptimizedPrewittX = SIMD_PrewittX;
+	OptimizedPrewittY = SIMD_PrewittY;
+	OptimizedCalculateGradientImageSobel = SIMD_CalculateGradientImageSobel;
+	OptimizedCalculateGradientImagePrewitt = SIMD_CalculateGradientImagePrewitt;
+	
+	OptimizedDilate3x3 = SIMD_Dilate3x3;
+	OptimizedErode3x3 = SIMD_Erode3x3;
+	OptimizedMorphologyRowMax = SIMD_MorphologyRowMax;
+	OptimizedMorphologyRowMin = SIMD_MorphologyRowMin;
+	
+	OptimizedThresholdBinarize = SIMD_ThresholdBinarize;
+	OptimizedThresholdBinarizeInverse = SIMD_ThresholdBinarizeInverse;
+	OptimizedThresholdFilter = SIMD_ThresholdFilter;
+	OptimizedThresholdFilterInverse = SIMD_ThresholdFilterInverse;
+	OptimizedInvert = SIMD_Invert;
+	
+	OptimizedAnd = SIMD_And;
+	OptimizedOr = SIMD_Or;
+	OptimizedXor = SIMD_Xor;
+	
+	OptimizedAdd = SIMD_Add;
+	OptimizedAddWithSaturation = SIMD_AddWithSaturation;
+	OptimizedSubtract = SIMD_Subtract;
+	OptimizedSubtractWithSaturation = SIMD_SubtractWithSaturation;
+	OptimizedAbsoluteDifference = SIMD_AbsoluteDifference;
+	OptimizedAverage = SIMD_Average;
+	OptimizedMin = SIMD_Min;
+	OptimizedMax = SIMD_Max;
+	
+	OptimizedMaxValue = SIMD_MaxValue;
+	OptimizedMinValue = SIMD_MinValue;
+	OptimizedMinMaxValue = SIMD_MinMaxValue;
+	OptimizedPixelSum = SIMD_PixelSum;
+	
+	// these check the instruction set themselves and fall back if necessary
+	OptimizedConvertImage = SIMD_ConvertImage;
+	OptimizedConvertImage_ByteToBinary = SIMD_ConvertImage_ByteToBinary;
+	OptimizedConvertImage_BinaryToByte = SIMD_ConvertImage_BinaryToByte;
+	OptimizedCalculateHSVImage = SIMD_CalculateHSVImage;
+	
+	return true;
+#else
+	return false;
+#endif
+}
@@ -0,0 +1,91 @@
+// ****************************************************************************
+// This file is part of the Integrating Vision Toolkit (IVT).
+//
+// The IVT is maintained by the Karlsruhe Institute of Technology (KIT)
+// (www.kit.edu) in cooperation with the company Keyetech (www.keyetech.de).
+//
+// Copyright (C) 2014 Karlsruhe Institute of Technology (KIT).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the KIT nor the names of its contributors may be
+//    used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE KIT AND CONTRIBUTORS “AS IS” AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE KIT OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ****************************************************************************
+// ****************************************************************************
+// Filename:  OptimizedFunctionsSIMD.h
+// Author:    agent
+// Date:      17.10.2026
+// ****************************************************************************
+
+
+#ifndef _OPTIMIZED_FUNCTIONS_SIMD_H_
+#define _OPTIMIZED_FUNCTIONS_SIMD_H_
+
+
+
+// ****************************************************************************
+// OptimizedFunctionsSIMD
+// ****************************************************************************
+
+/*!
+	\namespace OptimizedFunctionsSIMD
+	\ingroup ImageProcessing
+	\brief Built-in SSE2/SSSE3/AVX2 implementations of the functions declared in OptimizedFunctionsList.h.
+	
+	If the IVT is built with USE_SIMD defined, the CPU is inspected at program start and the best
+	available implementation of each function is registered through the Optimized* function pointers,
+	unless the KPP have been loaded. Functions return 0 for unsupported parameters (e.g. image types),
+	in which case the generic implementation in ImageProcessor is executed.
+*/
+namespace OptimizedFunctionsSIMD
+{
+	/*!
+		\brief Enum specifying the instruction set levels detected at runtime.
+	*/
+	enum InstructionSet
+	{
+		eNone = 0,
+		eSSE2 = 1,
+		eSSSE3 = 2,
+		eAVX2 = 3
+	};
+
+	/*!
+		\brief Returns the highest instruction set level that is supported by both the CPU and the build.
+		
+		The result is determined once with the CPUID instruction and then cached.
+	*/
+	InstructionSet GetInstructionSet();
+	
+	/*!
+		\brief Assigns the built-in implementations to the Optimized* function pointers.
+		
+		\return true if at least SSE2 is available and the functions have been registered, otherwise false.
+	*/
+	bool Register();
+}
+
+
+
+#endif /* _OPTIMIZED_FUNCTIONS_SIMD_H_ */
@@ -41,6 +41,7 @@
 #include <new> // for explicitly using correct new/delete operators on VC DSPs
 
 #include "PerformanceLib.h"
+#include "OptimizedFunctionsSIMD.h"
 
 
 // this is needed so that the function pointers are not declared extern
@@ -100,9 +101,13 @@ CPerformanceLibInitializer performanceLibInitializer;
 #define DECLARE_OPTIMIZED_FUNCTION_9(name, p1, p2, p3, p4, p5, p6, p7, p8, p9) LOAD_OPTIMIZED_FUNCTION(name)
 
 
-CPerformanceLibInitializer::CPerformanceLibInitializer() : m_pLibHandle(0)
+CPerformanceLibInitializer::CPerformanceLibInitializer() : m_pLibHandle(0), m_bBuiltinSIMD(false)
 {
 	LoadPerformanceLib();
+	
+	// fall back to the built-in SIMD implementations if the KPP are not available
+	if (m_pLibHandle == 0)
+		m_bBuiltinSIMD = OptimizedFunctionsSIMD::Register();
 }
 
 CPerformanceLibInitializer::~CPerformanceLibInitializer()
@@ -197,6 +202,8 @@ void CPerformanceLibInitializer::FreePerformanceLib()
 		m_pLibHandle = 0;
 	}
 	
+	m_bBuiltinSIMD = false;
+	
 	// this include will generate the necessary clear operations
 	// due to the DECLARE_OPTIMIZED_FUNCTION_x macros
 	#include "OptimizedFunctionsList.h"
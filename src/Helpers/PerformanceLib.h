@@ -67,6 +67,7 @@ public:
 	~CPerformanceLibInitializer();
 	
 	bool HasIVTPerformance() { return m_pLibHandle != 0; }
+	bool HasBuiltinSIMD() { return m_bBuiltinSIMD; }
 
 
 private:
@@ -76,6 +77,8 @@ private:
 	void *m_pLibHandle;
 	#endif
 	
+	bool m_bBuiltinSIMD;
+	
 	void LoadPerformanceLib();
 	void FreePerformanceLib();
 };
@@ -63,6 +63,9 @@
 #define MY_MAX(a, b)    (((a) > (b)) ? (a) : (b))
 #define MY_MIN(a, b)    (((a) < (b)) ? (a) : (b))
 
+// alignment in bytes of the memory and of the rows of padded images and matrices
+#define IVT_ROW_ALIGNMENT	64
+
 
 // ****************************************************************************
 // Declarations
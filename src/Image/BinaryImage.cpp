@@ -0,0 +1,156 @@
+// ****************************************************************************
+// This file is part of the Integrating Vision Toolkit (IVT).
+//
+// The IVT is maintained by the Karlsruhe Institute of Technology (KIT)
+// (www.kit.edu) in cooperation with the company Keyetech (www.keyetech.de).
+//
+// Copyright (C) 2014 Karlsruhe Institute of Technology (KIT).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the KIT nor the names of its contributors may be
+//    used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE KIT AND CONTRIBUTORS “AS IS” AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE KIT OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ****************************************************************************
+// ****************************************************************************
+// Filename:  BinaryImage.cpp
+// Author:    agent
+// Date:      17.10.2026
+// ****************************************************************************
+
+
+// ****************************************************************************
+// Includes
+// ****************************************************************************
+
+#include <new> // for explicitly using correct new/delete operators on VC DSPs
+
+#include "BinaryImage.h"
+
+#include "Helpers/helpers.h"
+
+#include <string.h>
+
+
+
+// ****************************************************************************
+// Constructors / Destructor
+// ****************************************************************************
+
+CBinaryImage::CBinaryImage()
+{
+	width = 0;
+	height = 0;
+	stride = 0;
+	words = 0;
+	m_bOwnMemory = false;
+}
+
+CBinaryImage::CBinaryImage(int nImageWidth, int nImageHeight, bool bHeaderOnly)
+{
+	width = nImageWidth;
+	height = nImageHeight;
+
+	if (bHeaderOnly)
+	{
+		stride = (width + 63) / 64;
+		words = 0;
+		m_bOwnMemory = false;
+	}
+	else
+	{
+		AllocateMemory();
+	}
+}
+
+CBinaryImage::CBinaryImage(const CBinaryImage &image, bool bHeaderOnly)
+{
+	width = image.width;
+	height = image.height;
+	
+	if (bHeaderOnly)
+	{
+		stride = image.stride;
+		words = 0;
+		m_bOwnMemory = false;
+	}
+	else
+	{
+		AllocateMemory();
+	}
+}
+
+CBinaryImage::CBinaryImage(const CBinaryImage *pImage, bool bHeaderOnly)
+{
+	width = pImage->width;
+	height = pImage->height;
+	
+	if (bHeaderOnly)
+	{
+		stride = pImage->stride;
+		words = 0;
+		m_bOwnMemory = false;
+	}
+	else
+	{
+		AllocateMemory();
+	}
+}
+
+CBinaryImage::~CBinaryImage()
+{
+    FreeMemory();
+}
+
+
+// ****************************************************************************
+// Methods
+// ****************************************************************************
+
+bool CBinaryImage::IsCompatible(const CBinaryImage *pImage) const
+{
+	return width == pImage->width && height == pImage->height;
+}
+
+void CBinaryImage::AllocateMemory()
+{
+	stride = (width + 63) / 64;
+	
+	// the bits beyond the width must be zero
+	const int nBytes = stride * height * sizeof(Word);
+	words = (Word *) aligned_malloc(nBytes, IVT_ROW_ALIGNMENT);
+	memset(words, 0, nBytes);
+	m_bOwnMemory = true;
+}
+
+void CBinaryImage::FreeMemory()
+{
+	if (words)
+	{
+		if (m_bOwnMemory)
+			aligned_free(words);
+
+		words = 0;
+		m_bOwnMemory = false;
+	}
+}
@@ -0,0 +1,112 @@
+// ****************************************************************************
+// This file is part of the Integrating Vision Toolkit (IVT).
+//
+// The IVT is maintained by the Karlsruhe Institute of Technology (KIT)
+// (www.kit.edu) in cooperation with the company Keyetech (www.keyetech.de).
+//
+// Copyright (C) 2014 Karlsruhe Institute of Technology (KIT).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the KIT nor the names of its contributors may be
+//    used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE KIT AND CONTRIBUTORS “AS IS” AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE KIT OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ****************************************************************************
+// ****************************************************************************
+// Filename:  BinaryImage.h
+// Author:    agent
+// Date:      17.10.2026
+// ****************************************************************************
+
+
+#ifndef __BINARY_IMAGE_H__
+#define __BINARY_IMAGE_H__
+
+
+// ****************************************************************************
+// CBinaryImage
+// ****************************************************************************
+
+/*!
+	\ingroup ImageRepresentations
+	\brief Data structure for the representation of binary images with one bit per pixel.
+
+	The pixels of each row are packed into 64 bit words: pixel x of row y is bit (x % 64) of the word words[y * stride + x / 64],
+	i.e. the leftmost pixel of a word is its least significant bit. The bits beyond the width of the image in the last word of each row
+	are always zero, so that word-wise operations can process whole rows and the number of foreground pixels can be counted directly.
+
+	Compared to a binary CByteImage with the values 0 and 255, the memory consumption and bandwidth is reduced by a factor of 8.
+	The conversion from and to CByteImage, logic operators, 3x3 morphology, the binary gradient image, the pixel count and
+	the connected component labeling are offered by the ImageProcessor namespace.
+*/
+class CBinaryImage
+{
+public:
+	// typedefs
+	typedef unsigned long long Word;
+	
+	// constructors
+	CBinaryImage();
+	CBinaryImage(int nImageWidth, int nImageHeight, bool bHeaderOnly = false);
+
+	// copy constructors (will copy header and allocate memory)
+	CBinaryImage(const CBinaryImage *pImage, bool bHeaderOnly = false);
+	CBinaryImage(const CBinaryImage &image, bool bHeaderOnly = false);
+
+	// destructor
+	~CBinaryImage();
+
+	// public methods
+	bool IsCompatible(const CBinaryImage *pImage) const;
+	
+	bool GetPixel(int x, int y) const { return ((words[y * stride + (x >> 6)] >> (x & 63)) & 1) != 0; }
+	void SetPixel(int x, int y, bool bValue)
+	{
+		const Word mask = Word(1) << (x & 63);
+		Word &word = words[y * stride + (x >> 6)];
+		word = bValue ? (word | mask) : (word & ~mask);
+	}
+	
+	// mask of the valid bits of the last word of each row
+	Word GetLastWordMask() const { return (width & 63) ? (Word(1) << (width & 63)) - 1 : ~Word(0); }
+
+
+	// public attributes - not clean OOP design but easy access
+	int width;
+	int height;
+	Word *words;
+	int stride; // distance between two rows in words, i.e. (width + 63) / 64
+
+
+private:
+	// private methods
+	void AllocateMemory();
+	void FreeMemory();
+
+	// private attributes - only used internally
+	bool m_bOwnMemory;
+};
+
+
+
+#endif /* __BINARY_IMAGE_H__ */
@@ -82,12 +82,13 @@ CByteImage::CByteImage()
 	width = 0;
 	height = 0;
 	bytesPerPixel = 0;
+	stride = 0;
 	pixels = 0;
 	type = eGrayScale;
 	m_bOwnMemory = false;
 }
 
-CByteImage::CByteImage(int nImageWidth, int nImageHeight, ImageType imageType, bool bHeaderOnly)
+CByteImage::CByteImage(int nImageWidth, int nImageHeight, ImageType imageType, bool bHeaderOnly, bool bPadded)
 {
 	switch (imageType)
 	{
@@ -107,13 +108,13 @@ CByteImage::CByteImage(int nImageWidth, int nImageHeight, ImageType imageType, b
 
 	if (bHeaderOnly)
 	{
+		stride = type == eRGB24 ? 3 * width : width;
 		pixels = 0;
 		m_bOwnMemory = false;
 	}
 	else
 	{
-		pixels = new unsigned char[width * height * bytesPerPixel + EXTRA_BYTES];
-		m_bOwnMemory = true;
+		AllocateMemory(bPadded);
 	}
 }
 
@@ -126,13 +127,13 @@ CByteImage::CByteImage(const CByteImage &image, bool bHeaderOnly)
 	
 	if (bHeaderOnly)
 	{
+		stride = image.stride;
 		pixels = 0;
 		m_bOwnMemory = false;
 	}
 	else
 	{
-		pixels = new unsigned char[width * height * bytesPerPixel + EXTRA_BYTES];
-		m_bOwnMemory = true;
+		AllocateMemory(image.IsPadded());
 	}
 }
 
@@ -145,13 +146,13 @@ CByteImage::CByteImage(const CByteImage *pImage, bool bHeaderOnly)
 	
 	if (bHeaderOnly)
 	{
+		stride = pImage->stride;
 		pixels = 0;
 		m_bOwnMemory = false;
 	}
 	else
 	{
-		pixels = new unsigned char[width * height * bytesPerPixel + EXTRA_BYTES];
-		m_bOwnMemory = true;
+		AllocateMemory(pImage->IsPadded());
 	}
 }
 
@@ -165,7 +166,7 @@ CByteImage::~CByteImage()
 // Methods
 // ****************************************************************************
 
-void CByteImage::Set(int nImageWidth, int nImageHeight, ImageType imageType, bool bHeaderOnly)
+void CByteImage::Set(int nImageWidth, int nImageHeight, ImageType imageType, bool bHeaderOnly, bool bPadded)
 {
 	FreeMemory();
 
@@ -187,22 +188,32 @@ void CByteImage::Set(int nImageWidth, int nImageHeight, ImageType imageType, boo
 
 	if (bHeaderOnly)
 	{
+		stride = type == eRGB24 ? 3 * width : width;
 		pixels = 0;
 		m_bOwnMemory = false;
 	}
 	else
 	{
-		pixels = new unsigned char[width * height * bytesPerPixel + EXTRA_BYTES];
-		m_bOwnMemory = true;
+		AllocateMemory(bPadded);
 	}
 }
 
+void CByteImage::AllocateMemory(bool bPadded)
+{
+	const int nRowBytes = type == eRGB24 ? 3 * width : width;
+	const int nChannels = type == eRGB24Split ? 3 : 1;
+	
+	stride = bPadded ? (nRowBytes + IVT_ROW_ALIGNMENT - 1) / IVT_ROW_ALIGNMENT * IVT_ROW_ALIGNMENT : nRowBytes;
+	pixels = (unsigned char *) aligned_malloc(stride * height * nChannels + EXTRA_BYTES, IVT_ROW_ALIGNMENT);
+	m_bOwnMemory = true;
+}
+
 void CByteImage::FreeMemory()
 {
 	if (pixels)
 	{
 		if (m_bOwnMemory)
-			delete [] pixels;
+			aligned_free(pixels);
 
 		pixels = 0;
 		m_bOwnMemory = false;
@@ -214,6 +225,11 @@ bool CByteImage::IsCompatible(const CByteImage *pImage) const
 	return width == pImage->width && height == pImage->height && type == pImage->type;
 }
 
+bool CByteImage::IsPadded() const
+{
+	return stride != 0 && stride != (type == eRGB24 ? 3 * width : width);
+}
+
 
 static int my_strcmpi(const char *pString1, const char *pString2)
 {
@@ -242,6 +258,19 @@ bool CByteImage::LoadFromFile(const char *pFileName)
 
 bool CByteImage::SaveToFile(const char *pFileName) const
 {
+	if (IsPadded())
+	{
+		// write an unpadded copy
+		CByteImage image(width, height, type);
+		const int nRowBytes = type == eRGB24 ? 3 * width : width;
+		const int nRows = type == eRGB24Split ? 3 * height : height;
+		
+		for (int i = 0; i < nRows; i++)
+			memcpy(image.pixels + i * nRowBytes, pixels + i * stride, nRowBytes);
+		
+		return image.SaveToFile(pFileName);
+	}
+	
 	const char *pBeginEnding = pFileName + strlen(pFileName) - 4;
 	if (my_strcmpi(pBeginEnding, ".bmp") ==  0)
 		return SaveToFileBMP(pFileName);
@@ -422,12 +451,9 @@ bool CByteImage::LoadFromFileBMP(const char *pFileName)
 
 	const int padding_bytes = ((width * nReadBytesPerPixel) % 4 == 0) ? 0 : 4 - ((width * nReadBytesPerPixel) % 4);
 
-	const int nPixels = width * height;
-
 	// allocate memory
-	pixels = new unsigned char[nPixels * bytesPerPixel + EXTRA_BYTES];
+	AllocateMemory(false);
 	unsigned char *pTempBuffer = new unsigned char[(width * nReadBytesPerPixel + padding_bytes) * height + EXTRA_BYTES];
-	m_bOwnMemory = true;
 
 	// fill pixels from file
 	if (fread(pTempBuffer, (width * nReadBytesPerPixel + padding_bytes) * height, 1, f) != 1)
@@ -915,8 +941,7 @@ bool CByteImage::LoadFromFilePNM(const char *pFileName)
 		return false;
 	}
 
-	pixels = new unsigned char[width * height * bytesPerPixel + EXTRA_BYTES];
-	m_bOwnMemory = true;
+	AllocateMemory(false);
 
 	if (fread (pixels , width * height * bytesPerPixel, 1, f ) !=  1)
 	{
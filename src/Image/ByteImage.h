@@ -116,13 +116,15 @@ public:
 			   The latter can be useful for assigning image data from other sources (see e.g. implementation of ImageAccessCV::LoadFromFile).
 			   Note that if bHeaderOnly is set to true, the member variable CByteImage::m_bOwnMemory is set to false so that memory assigned to the member variable CByteImage::pixels is not freed
 			   throughout re-initialization/destruction, i.e. freeing memory must be handled by the caller in this case.
+		\param[in] bPadded If set to true, each row is padded to a multiple of IVT_ROW_ALIGNMENT bytes (see CByteImage::stride), so that each row starts at an aligned address.
+			   If set to false (default value), the rows are stored without gaps.
 	 */
-	CByteImage(int nImageWidth, int nImageHeight, ImageType imageType, bool bHeaderOnly = false);
+	CByteImage(int nImageWidth, int nImageHeight, ImageType imageType, bool bHeaderOnly = false, bool bPadded = false);
 	
 	/*!
 		\brief Constructor for creating an image given a pointer to a CByteImage.
 	 
-		This constructor creates a new instance with the same properties as the image provided by the parameter 'pImage'.
+		This constructor creates a new instance with the same properties (including the row layout, see CByteImage::stride) as the image provided by the parameter 'pImage'.
 		<b>Note that the contents of the image are not copied.</b> Use ImageProcessor::CopyImage(const CByteImage*, CByteImage*, const MyRegion*, bool) for copying image contents.
 	 
 		\param[in] pImage The template image.
@@ -136,7 +138,7 @@ public:
 	/*!
 		\brief Copy constructor.
 	 
-		This copy constructor creates a new instance with the same properties as the image provided by the parameter 'image'.
+		This copy constructor creates a new instance with the same properties (including the row layout, see CByteImage::stride) as the image provided by the parameter 'image'.
 		<b>Note that the contents of the image are not copied.</b> Use ImageProcessor::CopyImage(const CByteImage*, CByteImage*, const MyRegion*, bool) for copying image contents.
 	 
 		\param[in] image The template image.
@@ -168,8 +170,10 @@ public:
 			   The latter can be useful for assigning image data from other sources (see e.g. implementation of ImageAccessCV::LoadFromFile).
 			   Note that if bHeaderOnly is set to true, the member variable CByteImage::m_bOwnMemory is set to false so that memory assigned to the member variable CByteImage::pixels is not freed
 			   throughout re-initialization/destruction, i.e. freeing memory must be handled by the caller in this case.
+		\param[in] bPadded If set to true, each row is padded to a multiple of IVT_ROW_ALIGNMENT bytes (see CByteImage::stride).
+			   If set to false (default value), the rows are stored without gaps.
 	 */
-	void Set(int nImageWidth, int nImageHeight, ImageType imageType, bool bHeaderOnly = false);
+	void Set(int nImageWidth, int nImageHeight, ImageType imageType, bool bHeaderOnly = false, bool bPadded = false);
 
 	/*!
 		\brief Checks whether two images are compatible or not.
@@ -179,6 +183,20 @@ public:
 	*/
 	bool IsCompatible(const CByteImage *pImage) const;
 	
+	/*!
+		\brief Checks whether the rows of the image are padded or not.
+		
+		\return true if CByteImage::stride is greater than the number of bytes needed for the pixels of one row, otherwise returns false.
+	*/
+	bool IsPadded() const;
+	
+	/*!
+		\brief Returns the distance between the beginnings of two consecutive rows in bytes.
+		
+		\return CByteImage::stride, or the number of bytes of an unpadded row if CByteImage::stride is 0.
+	*/
+	int GetStride() const { return stride ? stride : (type == eRGB24 ? 3 * width : width); }
+	
 	/*!
 		\brief Loads an image from a file.
 		
@@ -235,6 +253,7 @@ private:
 	};
 	
 	// private methods
+	void AllocateMemory(bool bPadded);
 	void FreeMemory();
 	
 	bool LoadFromFilePNM(const char *pFileName);
@@ -250,7 +269,7 @@ public:
 	/*!
 		\brief The width of the image in pixels.
 		
-		Padding is not implemented (on purpose).
+		Note that the rows can be padded, i.e. the distance between two rows is given by CByteImage::stride, which can be greater than width * bytesPerPixel.
 	 
 		This variable should only be read. It should only be modified by external image loaders (e.g. ImageAccessCV::LoadFromFile).
 	*/
@@ -281,6 +300,22 @@ public:
 		This variable should only be read. It should only be modified by external image loaders (e.g. ImageAccessCV::LoadFromFile).
 	*/
 	unsigned char *pixels;
+	
+	/*!
+		\brief The distance between the beginnings of two consecutive rows in bytes.
+		
+		For unpadded images (default), stride is width * bytesPerPixel for CByteImage::eGrayScale and CByteImage::eRGB24, and width for CByteImage::eRGB24Split.
+		For padded images (see CByteImage(int, int, ImageType, bool, bool)), stride is rounded up to a multiple of IVT_ROW_ALIGNMENT, and all rows start at an aligned address.
+		The pixel at (x, y) is thus located at pixels[y * stride + x * bytesPerPixel] for CByteImage::eGrayScale and CByteImage::eRGB24 images.
+		In the case of CByteImage::eRGB24Split images, each channel consists of height rows of stride bytes, i.e. the second channel starts at pixels + stride * height.
+		
+		The bytes between the end of a row and the beginning of the next row are undefined, they are however readable and writable.
+		
+		This variable should only be read. It should only be modified by external image loaders or code wrapping foreign memory (e.g. DMA buffers) with an image header.
+		If stride is 0, e.g. when the header fields of an image created with the default constructor are filled in manually,
+		the rows are unpadded. Therefore, code processing the rows should use GetStride() rather than this variable.
+	*/
+	int stride;
  
 	/*!
 		\brief The type of the image.
@@ -295,6 +330,7 @@ public:
 		\brief Flag signaling if memory is to be freed or not.
 		
 		This flag signals whether the image memory must be freed throughut re-initiallization/destruction or not.
+		Memory owned by the image is allocated with aligned_malloc and freed with aligned_free.
 	 
 		This flag is usually for internal use only. It should only be modified by external image loaders (e.g. ImageAccessCV::LoadFromFile).
 	*/
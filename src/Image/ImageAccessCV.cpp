@@ -66,15 +66,7 @@ bool ImageAccessCV::LoadFromFile(CByteImage *pImage, const char *pFilePath)
 		return false;
 	}
 		
-	if (pImage->pixels && pImage->m_bOwnMemory)
-		delete [] pImage->pixels;
-	
-	pImage->type = pIplImage->nChannels == 1 ? CByteImage::eGrayScale : CByteImage::eRGB24;
-	pImage->width = pIplImage->width;
-	pImage->height = pIplImage->height;
-	pImage->bytesPerPixel = pIplImage->nChannels;
-	pImage->pixels = new unsigned char[pImage->width * pImage->height * pImage->bytesPerPixel];
-	pImage->m_bOwnMemory = true;
+	pImage->Set(pIplImage->width, pIplImage->height, pIplImage->nChannels == 1 ? CByteImage::eGrayScale : CByteImage::eRGB24);
 
 	const int nPaddingBytes = pIplImage->widthStep - pImage->bytesPerPixel * pIplImage->width;
 	const unsigned char *input = (unsigned char *) pIplImage->imageData;
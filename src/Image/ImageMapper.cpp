@@ -52,10 +52,324 @@
 #include "Calibration/Calibration.h"
 #include "Helpers/helpers.h"
 
+#include "Threading/WorkerPool.h"
+
 #include <stdio.h>
+#include <string.h>
 #include <math.h>
 
 
+#if defined(USE_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define MAPPER_SIMD_AVAILABLE
+#include <emmintrin.h>
+#endif
+
+
+
+// ****************************************************************************
+// Defines
+// ****************************************************************************
+
+// precision of the fractional parts: 1/128 pixel, so that the interpolation weights fit into 15 bit
+#define FRACTION_BITS		7
+#define FRACTION_ONE		(1 << FRACTION_BITS)
+#define WEIGHT_SHIFT		(2 * FRACTION_BITS)
+
+// flag of the offset map for pixels without a corresponding pixel in the original image;
+// the offset of these pixels is 0 so that they can be read without branching
+#define INVALID_OFFSET		0x80000000
+
+#define PIXEL_OFFSET(c)		((c) & 0x7fffffff)
+#define PIXEL_MASK(c)		(~(int(c) >> 31))
+
+// header of the cache files (see CImageMapper::SaveMap)
+#define MAP_FILE_HEADER		"IVTMAP01"
+#define MAP_FILE_BYTE_ORDER	0x01020304
+
+// minimum number of rows of the output image that are mapped from one band of a converted Bayer pattern image
+#define MIN_BAYER_BAND_HEIGHT	32
+
+
+
+// ****************************************************************************
+// Static functions
+// ****************************************************************************
+
+struct MapFileHeader
+{
+	char header[8];
+	unsigned int nByteOrder;
+	unsigned int nKey;
+	int width;
+	int height;
+	int nInterpolate;
+	int nFractionBits;
+	int nOffsetMapStride;
+	int nOffsetMapBytesPerPixel;
+	int reserved[2]; // the tables following the header are aligned to 16 bytes
+};
+
+struct MappingParameters
+{
+	const CByteImage *pInputImage;
+	CByteImage *pOutputImage;
+	const unsigned int *pOffsetMap;
+	const unsigned short *pFractionMap;
+	int nInputOffset; // offset of pInputImage within the image the offset map refers to (MapRGB24Rows only)
+};
+
+static void MapGrayScaleRows(void *pParameter, int nBegin, int nEnd)
+{
+	const MappingParameters *pParameters = (const MappingParameters *) pParameter;
+	const unsigned char *input = pParameters->pInputImage->pixels;
+	const int input_stride = pParameters->pInputImage->GetStride();
+	const int width = pParameters->pOutputImage->width;
+
+	for (int y = nBegin; y < nEnd; y++)
+	{
+		const unsigned int *pOffsets = pParameters->pOffsetMap + y * width;
+		unsigned char *output = pParameters->pOutputImage->pixels + y * pParameters->pOutputImage->GetStride();
+
+		if (!pParameters->pFractionMap)
+		{
+			for (int x = 0; x < width; x++)
+			{
+				const unsigned int c = pOffsets[x];
+				output[x] = (unsigned char) (input[PIXEL_OFFSET(c)] & PIXEL_MASK(c));
+			}
+
+			continue;
+		}
+		
+		const unsigned short *pFractions = pParameters->pFractionMap + y * width;
+		int x = 0;
+
+#ifdef MAPPER_SIMD_AVAILABLE
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i one = _mm_set1_epi16(FRACTION_ONE);
+		const __m128i fraction_mask = _mm_set1_epi16(FRACTION_ONE - 1);
+		const __m128i rounding = _mm_set1_epi32(1 << (WEIGHT_SHIFT - 1));
+
+		for (; x + 8 <= width; x += 8)
+		{
+			// gather the pixel pairs of the upper and the lower row
+			__m128i upper = zero, lower = zero;
+
+			#define GATHER_PIXEL_PAIRS(i) \
+			{ \
+				const unsigned int c = pOffsets[x + i]; \
+				const unsigned char *p = input + PIXEL_OFFSET(c); \
+				const int mask = PIXEL_MASK(c); \
+				upper = _mm_insert_epi16(upper, (p[0] | (p[1] << 8)) & mask, i); \
+				lower = _mm_insert_epi16(lower, (p[input_stride] | (p[input_stride + 1] << 8)) & mask, i); \
+			}
+
+			GATHER_PIXEL_PAIRS(0)
+			GATHER_PIXEL_PAIRS(1)
+			GATHER_PIXEL_PAIRS(2)
+			GATHER_PIXEL_PAIRS(3)
+			GATHER_PIXEL_PAIRS(4)
+			GATHER_PIXEL_PAIRS(5)
+			GATHER_PIXEL_PAIRS(6)
+			GATHER_PIXEL_PAIRS(7)
+
+			#undef GATHER_PIXEL_PAIRS
+
+			// interpolation weights
+			const __m128i fractions = _mm_loadu_si128((const __m128i *) (pFractions + x));
+			const __m128i fx = _mm_and_si128(fractions, fraction_mask);
+			const __m128i fy = _mm_srli_epi16(fractions, 8);
+			const __m128i ix = _mm_sub_epi16(one, fx);
+			const __m128i iy = _mm_sub_epi16(one, fy);
+			const __m128i w00 = _mm_mullo_epi16(ix, iy);
+			const __m128i w10 = _mm_mullo_epi16(fx, iy);
+			const __m128i w01 = _mm_mullo_epi16(ix, fy);
+			const __m128i w11 = _mm_mullo_epi16(fx, fy);
+
+			__m128i sum0 = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi8(upper, zero), _mm_unpacklo_epi16(w00, w10)),
+				_mm_madd_epi16(_mm_unpacklo_epi8(lower, zero), _mm_unpacklo_epi16(w01, w11)));
+			__m128i sum1 = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi8(upper, zero), _mm_unpackhi_epi16(w00, w10)),
+				_mm_madd_epi16(_mm_unpackhi_epi8(lower, zero), _mm_unpackhi_epi16(w01, w11)));
+			
+			sum0 = _mm_srli_epi32(_mm_add_epi32(sum0, rounding), WEIGHT_SHIFT);
+			sum1 = _mm_srli_epi32(_mm_add_epi32(sum1, rounding), WEIGHT_SHIFT);
+
+			const __m128i result = _mm_packs_epi32(sum0, sum1);
+			_mm_storel_epi64((__m128i *) (output + x), _mm_packus_epi16(result, result));
+		}
+#endif
+
+		for (; x < width; x++)
+		{
+			const unsigned int c = pOffsets[x];
+			const unsigned char *p = input + PIXEL_OFFSET(c);
+			const int fx = pFractions[x] & (FRACTION_ONE - 1);
+			const int fy = pFractions[x] >> 8;
+			const int ix = FRACTION_ONE - fx;
+			const int iy = FRACTION_ONE - fy;
+
+			output[x] = (unsigned char) (((p[0] * ix * iy + p[1] * fx * iy + p[input_stride] * ix * fy + p[input_stride + 1] * fx * fy + (1 << (WEIGHT_SHIFT - 1))) >> WEIGHT_SHIFT) & PIXEL_MASK(c));
+		}
+	}
+}
+
+template <bool bGrayScaleOutput>
+static inline void WritePixel(unsigned char *output, int r, int g, int b)
+{
+	if (bGrayScaleOutput)
+	{
+		// same weights as ImageProcessor::ConvertImage
+		output[0] = (unsigned char) ((9797 * r + 19235 * g + 3736 * b + 16384) >> 15);
+	}
+	else
+	{
+		output[0] = (unsigned char) r;
+		output[1] = (unsigned char) g;
+		output[2] = (unsigned char) b;
+	}
+}
+
+// the output image is of type eRGB24 or, if bGrayScaleOutput is set, of type eGrayScale
+template <bool bGrayScaleOutput>
+static void MapRGB24Rows(void *pParameter, int nBegin, int nEnd)
+{
+	const MappingParameters *pParameters = (const MappingParameters *) pParameter;
+	const unsigned char *input = pParameters->pInputImage->pixels;
+	const int input_stride = pParameters->pInputImage->GetStride();
+	const int input_offset = pParameters->nInputOffset;
+	const int width = pParameters->pOutputImage->width;
+	const int output_bytes_per_pixel = bGrayScaleOutput ? 1 : 3;
+
+	for (int y = nBegin; y < nEnd; y++)
+	{
+		const unsigned int *pOffsets = pParameters->pOffsetMap + y * width;
+		unsigned char *output = pParameters->pOutputImage->pixels + y * pParameters->pOutputImage->GetStride();
+
+		if (!pParameters->pFractionMap)
+		{
+			for (int x = 0; x < width; x++, output += output_bytes_per_pixel)
+			{
+				const unsigned int c = pOffsets[x];
+				const int mask = PIXEL_MASK(c);
+				const unsigned char *p = input + ((PIXEL_OFFSET(c) - input_offset) & mask);
+
+				WritePixel<bGrayScaleOutput>(output, p[0] & mask, p[1] & mask, p[2] & mask);
+			}
+
+			continue;
+		}
+
+		const unsigned short *pFractions = pParameters->pFractionMap + y * width;
+
+		for (int x = 0; x < width; x++, output += output_bytes_per_pixel)
+		{
+			const unsigned int c = pOffsets[x];
+			const int mask = PIXEL_MASK(c);
+			const unsigned char *p = input + ((PIXEL_OFFSET(c) - input_offset) & mask);
+			const unsigned char *q = p + input_stride;
+			
+			const int fx = pFractions[x] & (FRACTION_ONE - 1);
+			const int fy = pFractions[x] >> 8;
+			const int w10 = fx * (FRACTION_ONE - fy);
+			const int w11 = fx * fy;
+			const int w00 = (FRACTION_ONE - fy) * FRACTION_ONE - w10;
+			const int w01 = fy * FRACTION_ONE - w11;
+
+			const int r = (p[0] * w00 + p[3] * w10 + q[0] * w01 + q[3] * w11 + (1 << (WEIGHT_SHIFT - 1))) >> WEIGHT_SHIFT;
+			const int g = (p[1] * w00 + p[4] * w10 + q[1] * w01 + q[4] * w11 + (1 << (WEIGHT_SHIFT - 1))) >> WEIGHT_SHIFT;
+			const int b = (p[2] * w00 + p[5] * w10 + q[2] * w01 + q[5] * w11 + (1 << (WEIGHT_SHIFT - 1))) >> WEIGHT_SHIFT;
+
+			WritePixel<bGrayScaleOutput>(output, r & mask, g & mask, b & mask);
+		}
+	}
+}
+
+struct BayerMappingParameters
+{
+	const CByteImage *pBayerImage;
+	CByteImage *pOutputImage;
+	const unsigned int *pOffsetMap;
+	const unsigned short *pFractionMap;
+	const int *pSourceRows;
+	int nBandHeight;
+	ImageProcessor::BayerPatternType type;
+};
+
+static void MapBayerPatternRows(void *pParameter, int nBegin, int nEnd)
+{
+	const BayerMappingParameters *pParameters = (const BayerMappingParameters *) pParameter;
+	const CByteImage *pBayerImage = pParameters->pBayerImage;
+	CByteImage *pOutputImage = pParameters->pOutputImage;
+	const int width = pBayerImage->width;
+	const int height = pBayerImage->height;
+
+	// color image of the rows of the Bayer pattern image needed for the current band of the output image
+	CByteImage *pBandImage = 0;
+
+	for (int nBandBegin = nBegin; nBandBegin < nEnd; nBandBegin += pParameters->nBandHeight)
+	{
+		const int nBandEnd = nBandBegin + pParameters->nBandHeight < nEnd ? nBandBegin + pParameters->nBandHeight : nEnd;
+
+		int nMinRow = height, nMaxRow = -1;
+
+		for (int y = nBandBegin; y < nBandEnd; y++)
+		{
+			if (pParameters->pSourceRows[2 * y] < nMinRow)
+				nMinRow = pParameters->pSourceRows[2 * y];
+
+			if (pParameters->pSourceRows[2 * y + 1] > nMaxRow)
+				nMaxRow = pParameters->pSourceRows[2 * y + 1];
+		}
+
+		if (nMinRow > nMaxRow)
+		{
+			// no pixel of this band has a corresponding pixel in the original image
+			for (int y = nBandBegin; y < nBandEnd; y++)
+				memset(pOutputImage->pixels + y * pOutputImage->GetStride(), 0, width * pOutputImage->bytesPerPixel);
+
+			continue;
+		}
+
+		// ImageProcessor::ConvertBayerPattern needs one additional row on each side (except for the frame of the image)
+		// and the first row must be even in order not to change the type of the Bayer pattern
+		const int nFirstRow = (nMinRow - 1 > 0 ? nMinRow - 1 : 0) & ~1;
+		const int nLastRow = nMaxRow + 2 < height ? nMaxRow + 2 : height;
+		const int nRows = nLastRow - nFirstRow;
+
+		if (!pBandImage || pBandImage->height < nRows)
+		{
+			if (pBandImage)
+				delete pBandImage;
+
+			pBandImage = new CByteImage(width, nRows, CByteImage::eRGB24);
+		}
+
+		CByteImage bayerImage(width, nRows, CByteImage::eGrayScale, true);
+		bayerImage.pixels = pBayerImage->pixels + nFirstRow * pBayerImage->GetStride();
+		bayerImage.stride = pBayerImage->GetStride();
+
+		CByteImage colorImage(width, nRows, CByteImage::eRGB24, true);
+		colorImage.pixels = pBandImage->pixels;
+
+		ImageProcessor::ConvertBayerPattern(&bayerImage, &colorImage, pParameters->type);
+
+		MappingParameters parameters;
+		parameters.pInputImage = &colorImage;
+		parameters.pOutputImage = pOutputImage;
+		parameters.pOffsetMap = pParameters->pOffsetMap;
+		parameters.pFractionMap = pParameters->pFractionMap;
+		parameters.nInputOffset = nFirstRow * colorImage.GetStride();
+
+		if (pOutputImage->type == CByteImage::eGrayScale)
+			MapRGB24Rows<true>(&parameters, nBandBegin, nBandEnd);
+		else
+			MapRGB24Rows<false>(&parameters, nBandBegin, nBandEnd);
+	}
+
+	if (pBandImage)
+		delete pBandImage;
+}
+
 
 // ****************************************************************************
 // Constructor / Destructor
@@ -66,7 +380,10 @@ CImageMapper::CImageMapper(bool bInterpolate)
 	m_bInterpolate = bInterpolate;
 
 	m_pOffsetMap = 0;
-	m_pCoordinateMap = 0;
+	m_pFractionMap = 0;
+	m_pSourceRows = 0;
+	m_nOffsetMapStride = 0;
+	m_nOffsetMapBytesPerPixel = 1;
 	
 	width = height = 0;
 
@@ -78,8 +395,11 @@ CImageMapper::~CImageMapper()
 	if (m_pOffsetMap)
 		delete [] m_pOffsetMap;
 
-	if (m_pCoordinateMap)
-		delete [] m_pCoordinateMap;
+	if (m_pFractionMap)
+		delete [] m_pFractionMap;
+
+	if (m_pSourceRows)
+		delete [] m_pSourceRows;
 }
 
 
@@ -97,20 +417,27 @@ void CImageMapper::ComputeMap(int width, int height)
 		if (m_pOffsetMap)
 			delete [] m_pOffsetMap;
 	
-		m_pOffsetMap = new int[width * height];
+		m_pOffsetMap = new unsigned int[width * height];
 	
 		if (m_bInterpolate)
 		{
-			if (m_pCoordinateMap)
-				delete [] m_pCoordinateMap;
+			if (m_pFractionMap)
+				delete [] m_pFractionMap;
 			
-			m_pCoordinateMap = new MapCoordinates[width * height];
+			m_pFractionMap = new unsigned short[width * height];
 		}
+
+		if (m_pSourceRows)
+			delete [] m_pSourceRows;
+
+		m_pSourceRows = new int[2 * height];
 	}
 	
 	// compute map
 	for (int i = 0, offset = 0; i < height; i++)
 	{
+		int nMinRow = height, nMaxRow = -1;
+
 		for (int j = 0; j < width; j++, offset++)
 		{
 			const Vec2d newCoordinates = { float(j), float(i) };
@@ -122,52 +449,85 @@ void CImageMapper::ComputeMap(int width, int height)
 			const float u = originalCoordinates.x;
 			const float v = originalCoordinates.y;
 
-			const int u_int = m_bInterpolate ? int(floor(u)) : my_round(u);
-			const int v_int = m_bInterpolate ? int(floor(v)) : my_round(v);
+			int u_int, v_int, fx = 0, fy = 0;
 
-			if (u_int >= 0 && u_int < width - 1 && v_int >= 0 && v_int < height - 1)
+			if (m_bInterpolate)
 			{
-				m_pOffsetMap[offset] = v_int * width + u_int;
+				// fixed point coordinates with FRACTION_BITS fractional bits
+				const double u_fixed = floor(u * FRACTION_ONE + 0.5);
+				const double v_fixed = floor(v * FRACTION_ONE + 0.5);
 
-				if (m_bInterpolate)
+				if (u_fixed < 0 || v_fixed < 0 || u_fixed >= (width - 1) * FRACTION_ONE || v_fixed >= (height - 1) * FRACTION_ONE)
 				{
-					const int u1 = int(floor(u));
-					const int v1 = int(floor(v));
-					const float x = u - u1;
-					const float y = v - v1;
-				
-					const float f00 = (1 - x) * (1 - y);
-					const float f10 = x * (1 - y);
-					const float f01 = (1 - x) * y;
-					const float f11 = x * y;
-
-					const float sum = f00 + f10 + f01 + f11;
-
-					// 2^22 = 4194304
-					m_pCoordinateMap[offset].f00 = int((f00 / sum) * 4194304);
-					m_pCoordinateMap[offset].f10 = int((f10 / sum) * 4194304);
-					m_pCoordinateMap[offset].f01 = int((f01 / sum) * 4194304);
-					m_pCoordinateMap[offset].f11 = int((f11 / sum) * 4194304);
+					u_int = v_int = -1;
 				}
+				else
+				{
+					u_int = int(u_fixed) >> FRACTION_BITS;
+					v_int = int(v_fixed) >> FRACTION_BITS;
+					fx = int(u_fixed) & (FRACTION_ONE - 1);
+					fy = int(v_fixed) & (FRACTION_ONE - 1);
+				}
+			}
+			else
+			{
+				u_int = my_round(u);
+				v_int = my_round(v);
+			}
+
+			if (u_int >= 0 && u_int < width - 1 && v_int >= 0 && v_int < height - 1)
+			{
+				m_pOffsetMap[offset] = (unsigned int) (v_int * width + u_int);
+
+				if (m_bInterpolate)
+					m_pFractionMap[offset] = (unsigned short) (fx | (fy << 8));
+
+				if (v_int < nMinRow)
+					nMinRow = v_int;
+
+				if (v_int > nMaxRow)
+					nMaxRow = v_int;
 			}
 			else
 			{
-				m_pOffsetMap[offset] = 0;
+				m_pOffsetMap[offset] = INVALID_OFFSET;
 				
 				if (m_bInterpolate)
-				{
-					m_pCoordinateMap[offset].f00 = 0;
-					m_pCoordinateMap[offset].f10 = 0;
-					m_pCoordinateMap[offset].f01 = 0;
-					m_pCoordinateMap[offset].f11 = 0;
-				}
+					m_pFractionMap[offset] = 0;
 			}
 		}
+
+		// rows of the input image that are read for this row, including the lower row for interpolation
+		m_pSourceRows[2 * i] = nMinRow;
+		m_pSourceRows[2 * i + 1] = m_bInterpolate && nMaxRow >= 0 ? nMaxRow + 1 : nMaxRow;
 	}
 
+	// the offsets refer to an unpadded grayscale image
+	m_nOffsetMapStride = width;
+	m_nOffsetMapBytesPerPixel = 1;
+
 	m_bMapComputed = true;
 }
 
+void CImageMapper::UpdateOffsetMap(int nStride, int nBytesPerPixel)
+{
+	const int nPixels = width * height;
+
+	for (int i = 0; i < nPixels; i++)
+	{
+		if (m_pOffsetMap[i] != INVALID_OFFSET)
+		{
+			const int y = m_pOffsetMap[i] / m_nOffsetMapStride;
+			const int x = (m_pOffsetMap[i] - y * m_nOffsetMapStride) / m_nOffsetMapBytesPerPixel;
+
+			m_pOffsetMap[i] = (unsigned int) (y * nStride + x * nBytesPerPixel);
+		}
+	}
+
+	m_nOffsetMapStride = nStride;
+	m_nOffsetMapBytesPerPixel = nBytesPerPixel;
+}
+
 void CImageMapper::PerformMapping(const CByteImage *pInputImage, CByteImage *pOutputImage)
 {
 	if (!m_bMapComputed)
@@ -194,80 +554,250 @@ void CImageMapper::PerformMapping(const CByteImage *pInputImage, CByteImage *pOu
 		return;
 	}
 
-	CByteImage *pSaveOutputImage = 0;
+	if (pInputImage->type != CByteImage::eGrayScale && pInputImage->type != CByteImage::eRGB24)
+	{
+		printf("error: image type not supported by CImageMapper::PerformMapping\n");
+		return;
+	}
+
+	// in-place operation is handled with a copy
+	CByteImage *pTempImage = 0;
 	if (pInputImage->pixels == pOutputImage->pixels)
 	{
-		pSaveOutputImage = pOutputImage;
-		pOutputImage = new CByteImage(pInputImage);
+		pTempImage = new CByteImage(pInputImage);
+		ImageProcessor::CopyImage(pInputImage, pTempImage);
+		pInputImage = pTempImage;
 	}
 
-	unsigned char *input = pInputImage->pixels;
-	unsigned char *output = pOutputImage->pixels;
+	// the offsets are kept for the memory layout of the last input image
+	if (pInputImage->GetStride() != m_nOffsetMapStride || pInputImage->bytesPerPixel != m_nOffsetMapBytesPerPixel)
+		UpdateOffsetMap(pInputImage->GetStride(), pInputImage->bytesPerPixel);
 
-	const int nPixels = width * height;
+	MappingParameters parameters;
+	parameters.pInputImage = pInputImage;
+	parameters.pOutputImage = pOutputImage;
+	parameters.pOffsetMap = m_pOffsetMap;
+	parameters.pFractionMap = m_bInterpolate ? m_pFractionMap : 0;
+	parameters.nInputOffset = 0;
 
 	if (pInputImage->type == CByteImage::eGrayScale)
+		Threading::ParallelFor(MapGrayScaleRows, &parameters, height, 16);
+	else
+		Threading::ParallelFor(MapRGB24Rows<false>, &parameters, height, 16);
+
+	if (pTempImage)
+		delete pTempImage;
+}
+
+void CImageMapper::PerformMapping(const CByteImage *pBayerImage, CByteImage *pOutputImage, ImageProcessor::BayerPatternType type)
+{
+	if (!m_bMapComputed)
 	{
-		const unsigned char g = input[0];
-		input[0] = 0;
+		printf("error: map has not been computed yet. call CImageMapper::ComputeMap\n");
+		return;
+	}
 
-		if (m_bInterpolate)
-		{
-			for (int i = 0; i < nPixels; i++)
-			{
-				const int input_offset = m_pOffsetMap[i];
-				const MapCoordinates &m = m_pCoordinateMap[i];
-				output[i] = (unsigned char) ((input[input_offset] * m.f00 + input[input_offset + width] * m.f01 + input[input_offset + 1] * m.f10 + input[input_offset + width + 1] * m.f11 + 2097152) >> 22);
-			}
-		}
-		else
-		{
-			for (int i = 0; i < nPixels; i++)
-				output[i] = input[m_pOffsetMap[i]];
-		}
+	if (pBayerImage->type != CByteImage::eGrayScale || (pOutputImage->type != CByteImage::eRGB24 && pOutputImage->type != CByteImage::eGrayScale))
+	{
+		printf("error: input image must be of type eGrayScale and output image of type eRGB24 or eGrayScale for CImageMapper::PerformMapping\n");
+		return;
+	}
 
-		input[0] = g;
+	if (pBayerImage->width != width || pBayerImage->height != height)
+	{
+		printf("error: input image does not match calibration file for CImageMapper::PerformMapping\n");
+		return;
 	}
-	else if (pInputImage->type == CByteImage::eRGB24)
+
+	if (pOutputImage->width != width || pOutputImage->height != height)
 	{
-		const unsigned char r = input[0];
-		const unsigned char g = input[1];
-		const unsigned char b = input[2];
-		input[0] = input[1] = input[2] = 0;
+		printf("error: output image does not match calibration file for CImageMapper::PerformMapping\n");
+		return;
+	}
 
-		if (m_bInterpolate)
-		{
-			for (int i = 0, output_offset = 0; i < nPixels; i++, output_offset += 3)
-			{
-				const int input_offset = 3 * m_pOffsetMap[i];
-				const int width3 = 3 * width;
+	// in-place operation is handled with a copy
+	CByteImage *pTempImage = 0;
+	if (pBayerImage->pixels == pOutputImage->pixels)
+	{
+		pTempImage = new CByteImage(pBayerImage);
+		ImageProcessor::CopyImage(pBayerImage, pTempImage);
+		pBayerImage = pTempImage;
+	}
 
-				const MapCoordinates &m = m_pCoordinateMap[i];
-				
-				output[output_offset] = (unsigned char) ((input[input_offset] * m.f00 + input[input_offset + width3] * m.f01 + input[input_offset + 3] * m.f10 + input[input_offset + width3 + 3] * m.f11 + 2097152) >> 22);
-				output[output_offset + 1] = (unsigned char) ((input[input_offset + 1] * m.f00 + input[input_offset + width3 + 1] * m.f01 + input[input_offset + 4] * m.f10 + input[input_offset + width3 + 4] * m.f11 + 2097152) >> 22);
-				output[output_offset + 2] = (unsigned char) ((input[input_offset + 2] * m.f00 + input[input_offset + width3 + 2] * m.f01 + input[input_offset + 5] * m.f10 + input[input_offset + width3 + 5] * m.f11 + 2097152) >> 22);
-			}
-		}
-		else
-		{
-			for (int i = 0, output_offset = 0; i < nPixels; i++, output_offset += 3)
-			{
-				const int input_offset = 3 * m_pOffsetMap[i];
-				output[output_offset] = input[input_offset];
-				output[output_offset + 1] = input[input_offset + 1];
-				output[output_offset + 2] = input[input_offset + 2];
-			}
-		}
+	// the bands of the converted image are unpadded eRGB24 images
+	if (m_nOffsetMapStride != 3 * width || m_nOffsetMapBytesPerPixel != 3)
+		UpdateOffsetMap(3 * width, 3);
+
+	BayerMappingParameters parameters;
+	parameters.pBayerImage = pBayerImage;
+	parameters.pOutputImage = pOutputImage;
+	parameters.pOffsetMap = m_pOffsetMap;
+	parameters.pFractionMap = m_bInterpolate ? m_pFractionMap : 0;
+	parameters.pSourceRows = m_pSourceRows;
+	parameters.type = type;
+
+	// the bands must be high enough compared to the number of input rows read for one output row (rotation, distortion),
+	// so that only few rows are converted for more than one band
+	int nMaxSourceRows = 0;
+	for (int i = 0; i < height; i++)
+	{
+		if (m_pSourceRows[2 * i + 1] - m_pSourceRows[2 * i] > nMaxSourceRows)
+			nMaxSourceRows = m_pSourceRows[2 * i + 1] - m_pSourceRows[2 * i];
+	}
 
-		input[0] = r;
-		input[1] = g;
-		input[2] = b;
+	parameters.nBandHeight = 4 * nMaxSourceRows > MIN_BAYER_BAND_HEIGHT ? 4 * nMaxSourceRows : MIN_BAYER_BAND_HEIGHT;
+
+	Threading::ParallelFor(MapBayerPatternRows, &parameters, height, parameters.nBandHeight);
+
+	if (pTempImage)
+		delete pTempImage;
+}
+
+
+void CImageMapper::ComputeMap(int width, int height, const char *pCacheFileName, unsigned int nKey)
+{
+	if (LoadMap(pCacheFileName, nKey, width, height))
+		return;
+
+	ComputeMap(width, height);
+
+	if (!SaveMap(pCacheFileName, nKey))
+		printf("warning: could not write cache file '%s' in CImageMapper::ComputeMap\n", pCacheFileName);
+}
+
+bool CImageMapper::SaveMap(const char *pFileName, unsigned int nKey) const
+{
+	if (!m_bMapComputed)
+	{
+		printf("error: map has not been computed yet. call CImageMapper::ComputeMap\n");
+		return false;
 	}
 
-	if (pSaveOutputImage)
+	MapFileHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.header, MAP_FILE_HEADER, sizeof(header.header));
+	header.nByteOrder = MAP_FILE_BYTE_ORDER;
+	header.nKey = nKey;
+	header.width = width;
+	header.height = height;
+	header.nInterpolate = m_bInterpolate ? 1 : 0;
+	header.nFractionBits = FRACTION_BITS;
+	header.nOffsetMapStride = m_nOffsetMapStride;
+	header.nOffsetMapBytesPerPixel = m_nOffsetMapBytesPerPixel;
+
+	FILE *f = fopen(pFileName, "wb");
+	if (!f)
+		return false;
+
+	const int nPixels = width * height;
+
+	bool bSuccess = fwrite(&header, sizeof(header), 1, f) == 1 &&
+		fwrite(m_pOffsetMap, nPixels * sizeof(unsigned int), 1, f) == 1 &&
+		fwrite(m_pSourceRows, 2 * height * sizeof(int), 1, f) == 1;
+
+	if (bSuccess && m_bInterpolate)
+		bSuccess = fwrite(m_pFractionMap, nPixels * sizeof(unsigned short), 1, f) == 1;
+
+	if (fclose(f) != 0)
+		bSuccess = false;
+
+	// do not leave an incomplete file, which would be read again and again
+	if (!bSuccess)
+		remove(pFileName);
+
+	return bSuccess;
+}
+
+bool CImageMapper::LoadMap(const char *pFileName, unsigned int nKey, int width, int height)
+{
+	FILE *f = fopen(pFileName, "rb");
+	if (!f)
+		return false;
+
+	MapFileHeader header;
+	
+	if (fread(&header, sizeof(header), 1, f) != 1 || memcmp(header.header, MAP_FILE_HEADER, sizeof(header.header)) != 0 ||
+		header.nByteOrder != MAP_FILE_BYTE_ORDER || header.nKey != nKey || header.width != width || header.height != height ||
+		header.nInterpolate != (m_bInterpolate ? 1 : 0) || header.nFractionBits != FRACTION_BITS ||
+		(header.nOffsetMapBytesPerPixel != 1 && header.nOffsetMapBytesPerPixel != 3) ||
+		header.nOffsetMapStride < width * header.nOffsetMapBytesPerPixel || width < 2 || height < 2)
 	{
-		ImageProcessor::CopyImage(pOutputImage, pSaveOutputImage);
-		delete pOutputImage;
+		fclose(f);
+		return false;
 	}
+
+	const int nPixels = width * height;
+
+	unsigned int *pOffsetMap = new unsigned int[nPixels];
+	int *pSourceRows = new int[2 * height];
+	unsigned short *pFractionMap = m_bInterpolate ? new unsigned short[nPixels] : 0;
+
+	bool bSuccess = fread(pOffsetMap, nPixels * sizeof(unsigned int), 1, f) == 1 &&
+		fread(pSourceRows, 2 * height * sizeof(int), 1, f) == 1;
+
+	if (bSuccess && pFractionMap)
+		bSuccess = fread(pFractionMap, nPixels * sizeof(unsigned short), 1, f) == 1;
+	
+	fclose(f);
+
+	// make sure that a damaged file cannot cause reads outside of the images
+	const unsigned int nMaxOffset = (height - 2) * header.nOffsetMapStride + (width - 2) * header.nOffsetMapBytesPerPixel;
+	
+	for (int i = 0; i < nPixels && bSuccess; i++)
+	{
+		if (pOffsetMap[i] != INVALID_OFFSET && pOffsetMap[i] > nMaxOffset)
+			bSuccess = false;
+	}
+	
+	for (int i = 0; i < height && bSuccess; i++)
+	{
+		if (pSourceRows[2 * i] <= pSourceRows[2 * i + 1] && (pSourceRows[2 * i] < 0 || pSourceRows[2 * i + 1] >= height))
+			bSuccess = false;
+	}
+
+	if (!bSuccess)
+	{
+		delete [] pOffsetMap;
+		delete [] pSourceRows;
+
+		if (pFractionMap)
+			delete [] pFractionMap;
+
+		return false;
+	}
+
+	if (m_pOffsetMap)
+		delete [] m_pOffsetMap;
+
+	if (m_pSourceRows)
+		delete [] m_pSourceRows;
+
+	if (m_pFractionMap)
+		delete [] m_pFractionMap;
+
+	m_pOffsetMap = pOffsetMap;
+	m_pSourceRows = pSourceRows;
+	m_pFractionMap = pFractionMap;
+	m_nOffsetMapStride = header.nOffsetMapStride;
+	m_nOffsetMapBytesPerPixel = header.nOffsetMapBytesPerPixel;
+
+	this->width = width;
+	this->height = height;
+
+	m_bMapComputed = true;
+
+	return true;
+}
+
+unsigned int CImageMapper::UpdateKey(unsigned int nKey, const void *pData, int nBytes)
+{
+	const unsigned char *pBytes = (const unsigned char *) pData;
+
+	for (int i = 0; i < nBytes; i++)
+	{
+		nKey ^= pBytes[i];
+		nKey *= 16777619u;
+	}
+
+	return nKey;
 }
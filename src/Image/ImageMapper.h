@@ -42,6 +42,14 @@
 #define _IMAGE_MAPPER_H_
 
 
+// ****************************************************************************
+// Necessary includes
+// ****************************************************************************
+
+#include "Image/ImageProcessor.h"
+
+
+
 // ****************************************************************************
 // Forward declarations
 // ****************************************************************************
@@ -64,14 +72,26 @@ struct Vec2d;
 	ComputeOriginalCoordinates(const Vec2d&, Vec2d&).
 
 	For initialization the method ComputeMap(int, int) must be called. Throughout initialization,
-	an internal lookup table is built, including pre-computed coefficients for bilinear interpolation if the interpolation
-	flag was set to true in the constructor CImageMapper(bool).
+	an internal lookup table is built, including the fractional parts of the original coordinates for bilinear interpolation
+	if the interpolation flag was set to true in the constructor CImageMapper(bool).
 
-	Bilinear interpolation has been optimized with integer arithmetics.
+	The lookup table stores the integer coordinates as a 32 bit offset and the fractional parts with a precision of 1/128 pixel
+	packed into 16 bit, i.e. 6 bytes per pixel (4 bytes without interpolation).
+	The offsets refer to the memory layout (stride and bytes per pixel) of the last input image and are converted by
+	PerformMapping(const CByteImage*, CByteImage*) if the layout changes. Therefore, PerformMapping must not be called
+	concurrently for the same instance.
+	Bilinear interpolation has been optimized with integer arithmetics and, for grayscale images, with SSE2 if the IVT is built with USE_SIMD.
+	The rows are distributed to the library-wide worker pool (see Threading::SetNumberOfWorkerThreads(int)).
 
 	After initialization, the mapping is performed by calling the method PerformMapping(const CByteImage*, CByteImage*).
 
+	Since computing the map can take considerable time for complex transformations and large images, the map can be written to
+	and read from a file with SaveMap(const char*, unsigned int) and LoadMap(const char*, unsigned int, int, int).
+	ComputeMap(int, int, const char*, unsigned int) combines both for caching the map across runs of a program.
+
 	Images of type CByteImage::eGrayScale and CByteImage::eRGB24 are supported.
+	Raw Bayer pattern images can be mapped directly with PerformMapping(const CByteImage*, CByteImage*, ImageProcessor::BayerPatternType),
+	which performs the Bayer pattern conversion, the mapping and optionally the conversion to grayscale without full-size intermediate images.
 */
 class CImageMapper
 {
@@ -108,6 +128,47 @@ public:
 	*/
 	void ComputeMap(int width, int height);
 
+	/*!
+		\brief This method initializes the instance using a cache file.
+
+		If the file pCacheFileName contains a map for the given image size, key and interpolation flag, the map is loaded from the file.
+		Otherwise, the map is computed by calling ComputeMap(int, int) and written to the file.
+
+		The key must identify the transformation, e.g. a hash of the parameters of the transformation computed with UpdateKey(unsigned int, const void*, int).
+		A file with a different key is never used.
+
+		@param[in] width The width of the images to be mapped in pixels.
+		@param[in] height The height of the images to be mapped in pixels.
+		@param[in] pCacheFileName The path to the cache file.
+		@param[in] nKey The key identifying the transformation.
+	*/
+	void ComputeMap(int width, int height, const char *pCacheFileName, unsigned int nKey);
+
+	/*!
+		\brief Writes the computed map to a file.
+
+		The file consists of a fixed-size header followed by the uncompressed tables in the byte order of the machine,
+		so that it can be read (or memory-mapped) without any conversion.
+
+		@param[in] pFileName The path to the file.
+		@param[in] nKey The key identifying the transformation, see ComputeMap(int, int, const char*, unsigned int).
+		@return true on success, false if the map has not been computed yet or the file could not be written.
+	*/
+	bool SaveMap(const char *pFileName, unsigned int nKey) const;
+
+	/*!
+		\brief Reads a map that has been written with SaveMap(const char*, unsigned int).
+
+		The map is only read if the key, the image size and the interpolation flag match and if the file was written on a machine with the same byte order.
+
+		@param[in] pFileName The path to the file.
+		@param[in] nKey The expected key.
+		@param[in] width The expected width of the images to be mapped in pixels.
+		@param[in] height The expected height of the images to be mapped in pixels.
+		@return true on success, false otherwise. In the latter case, the state of the instance is not changed.
+	*/
+	bool LoadMap(const char *pFileName, unsigned int nKey, int width, int height);
+
 	/*!
 		\brief This method performs the mapping.
 
@@ -120,24 +181,51 @@ public:
 		@param[out] pOutputImage The output image.
 	*/
 	void PerformMapping(const CByteImage *pInputImage, CByteImage *pOutputImage);
+
+	/*!
+		\brief This method performs the mapping of a raw Bayer pattern image.
+
+		Before application of this method, the instance must have been initialized by calling the method ComputeMap(int, int).
+
+		The result is the same as applying ImageProcessor::ConvertBayerPattern(const CByteImage*, CByteImage*, ImageProcessor::BayerPatternType),
+		then PerformMapping(const CByteImage*, CByteImage*) and, for grayscale output images, ImageProcessor::ConvertImage(const CByteImage*, CByteImage*, bool, const MyRegion*),
+		but without full-size intermediate images: the output image is processed in bands of rows and for each band only the rows
+		of the Bayer pattern image that are read are converted, so that the converted rows are still in the cache when they are mapped.
+
+		The width and height of pBayerImage and pOutputImage must match.
+
+		@param[in] pBayerImage The input image containing the raw data of the Bayer pattern. Must be of type CByteImage::eGrayScale.
+		@param[out] pOutputImage The output image. Must be of type CByteImage::eRGB24 or CByteImage::eGrayScale.
+		@param[in] type The variant of the Bayer pattern, see ImageProcessor::BayerPatternType.
+	*/
+	void PerformMapping(const CByteImage *pBayerImage, CByteImage *pOutputImage, ImageProcessor::BayerPatternType type);
 	
 	
-private:
-	struct MapCoordinates
-	{
-		int f00, f01, f10, f11;
-	};
+	/*!
+		\brief Updates a key for the cache file with the given data (32 bit FNV-1a hash).
 
+		Start with nKey = 2166136261 and call this method for each parameter of the transformation.
+	*/
+	static unsigned int UpdateKey(unsigned int nKey, const void *pData, int nBytes);
+	
+	
+private:
 	// pure virtual method
 	virtual void ComputeOriginalCoordinates(const Vec2d &newCoordinates, Vec2d &originalCoordinates) = 0;
+
+	// private methods
+	void UpdateOffsetMap(int nStride, int nBytesPerPixel);
 	
 
 	// private attributes
 	int width, height; // image size
 
 	// precomputed maps
-	int *m_pOffsetMap;
-	MapCoordinates *m_pCoordinateMap;
+	unsigned int *m_pOffsetMap; // byte offset of the top left pixel in the input image
+	unsigned short *m_pFractionMap; // fractional parts in 1/128 pixel: fx | (fy << 8)
+	int m_nOffsetMapStride;
+	int m_nOffsetMapBytesPerPixel;
+	int *m_pSourceRows; // first and last row of the input image read for each row of the output image
 
 	// flags
 	bool m_bInterpolate;
@@ -58,6 +58,7 @@
 #include "ByteImage.h"
 #include "ShortImage.h"
 #include "IntImage.h"
+#include "BinaryImage.h"
 #include "FloatImage.h"
 #include "PrimitivesDrawer.h"
 #include "Color/RGBColorModel.h"
@@ -71,6 +72,7 @@
 #include "Helpers/helpers.h"
 #include "Helpers/OptimizedFunctions.h"
 #include "Color/ColorParameterSet.h"
+#include "Threading/WorkerPool.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -156,13 +158,296 @@ static void InitSinCosTables()
 }
 
 
+// Most functions below are implemented for unpadded images only. Padded images
+// (see CByteImage::stride) are passed to these functions via CUnpaddedImage, which
+// provides an unpadded copy of the image and writes the result back if needed.
+static CByteImage *CreateUnpaddedImage(const CByteImage *pImage) { return new CByteImage(pImage->width, pImage->height, pImage->type); }
+static CShortImage *CreateUnpaddedImage(const CShortImage *pImage) { return new CShortImage(pImage->width, pImage->height); }
+static CIntImage *CreateUnpaddedImage(const CIntImage *pImage) { return new CIntImage(pImage->width, pImage->height); }
+static CFloatMatrix *CreateUnpaddedImage(const CFloatMatrix *pMatrix) { return new CFloatMatrix(pMatrix->columns, pMatrix->rows); }
+
+static void CopyPixels(const CByteImage *pInputImage, CByteImage *pOutputImage) { ImageProcessor::CopyImage(pInputImage, pOutputImage); }
+static void CopyPixels(const CShortImage *pInputImage, CShortImage *pOutputImage) { ImageProcessor::CopyImage(pInputImage, pOutputImage); }
+static void CopyPixels(const CFloatMatrix *pInputMatrix, CFloatMatrix *pOutputMatrix) { ImageProcessor::CopyMatrix(pInputMatrix, pOutputMatrix); }
+
+static void CopyPixels(const CIntImage *pInputImage, CIntImage *pOutputImage)
+{
+	for (int y = 0; y < pInputImage->height; y++)
+		memcpy(pOutputImage->pixels + y * pOutputImage->GetStride(), pInputImage->pixels + y * pInputImage->GetStride(), pInputImage->width * sizeof(int));
+}
+
+// number of rows and bytes per row of the pixel data, the three channels of
+// CByteImage::eRGB24Split images are treated as 3 * height rows
+static inline int GetRows(const CByteImage *pImage) { return pImage->type == CByteImage::eRGB24Split ? 3 * pImage->height : pImage->height; }
+static inline int GetRowBytes(const CByteImage *pImage) { return pImage->type == CByteImage::eRGB24 ? 3 * pImage->width : pImage->width; }
+
+template <class T>
+class CUnpaddedImage
+{
+public:
+	CUnpaddedImage(const T *pImage, bool bWriteBack = false)
+	{
+		m_pTargetImage = const_cast<T *>(pImage);
+		m_bWriteBack = bWriteBack;
+		
+		if (pImage && pImage->IsPadded())
+		{
+			m_pImage = CreateUnpaddedImage(pImage);
+			CopyPixels(pImage, m_pImage);
+		}
+		else
+			m_pImage = m_pTargetImage;
+	}
+	
+	~CUnpaddedImage()
+	{
+		if (m_pImage != m_pTargetImage)
+		{
+			if (m_bWriteBack)
+				CopyPixels(m_pImage, m_pTargetImage);
+			
+			delete m_pImage;
+		}
+	}
+	
+	operator T *() const { return m_pImage; }
+	
+private:
+	T *m_pImage;
+	T *m_pTargetImage;
+	bool m_bWriteBack;
+};
+
+
+// Row band processing with the worker pool (see Threading::SetNumberOfWorkerThreads).
+// The image is split into horizontal bands and the serial function is called for each band on
+// header-only views (see CreateRowView), so that the results are bit-identical to the serial path.
+// For neighborhood operations, each band is processed with nHalo additional rows on each side into a
+// temporary image and only the rows owned by the band are copied to the output image.
+// Operations are function objects calling the public function for one band; since the pool is busy
+// while the bands are processed, the nested call takes the serial path.
+static CByteImage *CreateRowView(const CByteImage *pImage, int nFirstRow, int nRows)
+{
+	CByteImage *pView = new CByteImage(pImage->width, nRows, pImage->type, true);
+	pView->pixels = pImage->pixels + nFirstRow * pImage->GetStride();
+	pView->stride = pImage->GetStride();
+	return pView;
+}
+
+static CShortImage *CreateRowView(const CShortImage *pImage, int nFirstRow, int nRows)
+{
+	CShortImage *pView = new CShortImage(pImage->width, nRows, true);
+	pView->pixels = pImage->pixels + nFirstRow * pImage->GetStride();
+	pView->stride = pImage->GetStride();
+	return pView;
+}
+
+static CFloatMatrix *CreateRowView(const CFloatMatrix *pMatrix, int nFirstRow, int nRows)
+{
+	CFloatMatrix *pView = new CFloatMatrix(pMatrix->columns, nRows, true);
+	pView->data = pMatrix->data + nFirstRow * pMatrix->GetStride();
+	pView->stride = pMatrix->GetStride();
+	return pView;
+}
+
+static CByteImage *CreateRowBandImage(const CByteImage *pImage, int nRows) { return new CByteImage(pImage->width, nRows, pImage->type); }
+static CShortImage *CreateRowBandImage(const CShortImage *pImage, int nRows) { return new CShortImage(pImage->width, nRows); }
+static CFloatMatrix *CreateRowBandImage(const CFloatMatrix *pMatrix, int nRows) { return new CFloatMatrix(pMatrix->columns, nRows); }
+
+static inline int GetHeight(const CByteImage *pImage) { return pImage->height; }
+static inline int GetHeight(const CShortImage *pImage) { return pImage->height; }
+static inline int GetHeight(const CFloatMatrix *pMatrix) { return pMatrix->rows; }
+
+static inline int GetWidth(const CByteImage *pImage) { return pImage->width; }
+static inline int GetWidth(const CShortImage *pImage) { return pImage->width; }
+static inline int GetWidth(const CFloatMatrix *pMatrix) { return pMatrix->columns; }
+
+static inline const void *GetData(const CByteImage *pImage) { return pImage->pixels; }
+static inline const void *GetData(const CShortImage *pImage) { return pImage->pixels; }
+static inline const void *GetData(const CFloatMatrix *pMatrix) { return pMatrix->data; }
+
+// the channels of CByteImage::eRGB24Split images are not contiguous in rows
+static inline bool SupportsRowBands(const CByteImage *pImage) { return pImage->type != CByteImage::eRGB24Split; }
+static inline bool SupportsRowBands(const CShortImage *) { return true; }
+static inline bool SupportsRowBands(const CFloatMatrix *) { return true; }
+
+template <class TOperation, class TInput, class TOutput>
+class CRowBandProcessor
+{
+public:
+	CRowBandProcessor(const TOperation &operation, const TInput *pInputImage1, const TInput *pInputImage2, TOutput *pOutputImage, int nHalo, int nRowAlignment) :
+		m_operation(operation), m_pInputImage1(pInputImage1), m_pInputImage2(pInputImage2), m_pOutputImage(pOutputImage),
+		m_nHalo(nHalo), m_nRowAlignment(nRowAlignment), m_bResult(true)
+	{
+	}
+	
+	bool Process(bool &bResult)
+	{
+		// small images are not worth the overhead
+		const int nRows = GetHeight(m_pOutputImage);
+		const int nMinRowsPerTask = MY_MAX(16, 4 * m_nHalo);
+		
+		if (Threading::GetNumberOfWorkerThreads() < 2 || nRows < 2 * nMinRowsPerTask)
+			return false;
+		
+		// invalid parameters are handled by the serial path
+		if (GetWidth(m_pInputImage1) != GetWidth(m_pOutputImage) || GetHeight(m_pInputImage1) != nRows ||
+			(m_pInputImage2 && (GetWidth(m_pInputImage2) != GetWidth(m_pOutputImage) || GetHeight(m_pInputImage2) != nRows)))
+			return false;
+		
+		if (!SupportsRowBands(m_pInputImage1) || !SupportsRowBands(m_pOutputImage) || (m_pInputImage2 && !SupportsRowBands(m_pInputImage2)))
+			return false;
+		
+		if (m_nHalo > 0 && (GetData(m_pInputImage1) == GetData(m_pOutputImage) || (m_pInputImage2 && GetData(m_pInputImage2) == GetData(m_pOutputImage))))
+		{
+			// in-place neighborhood operation: the bands must read the original input
+			TInput *pInputCopy1 = CreateUnpaddedImage(m_pInputImage1);
+			TInput *pInputCopy2 = m_pInputImage2 ? CreateUnpaddedImage(m_pInputImage2) : 0;
+			CopyPixels(m_pInputImage1, pInputCopy1);
+			if (pInputCopy2)
+				CopyPixels(m_pInputImage2, pInputCopy2);
+			
+			CRowBandProcessor processor(m_operation, pInputCopy1, pInputCopy2, m_pOutputImage, m_nHalo, m_nRowAlignment);
+			const bool bProcessed = Threading::TryParallelFor(ProcessRows, &processor, nRows, nMinRowsPerTask);
+			bResult = processor.m_bResult;
+			
+			delete pInputCopy1;
+			delete pInputCopy2;
+			
+			return bProcessed;
+		}
+		
+		if (!Threading::TryParallelFor(ProcessRows, this, nRows, nMinRowsPerTask))
+			return false;
+		
+		bResult = m_bResult;
+		
+		return true;
+	}
+
+private:
+	static void ProcessRows(void *pParameter, int nBegin, int nEnd)
+	{
+		CRowBandProcessor *pProcessor = (CRowBandProcessor *) pParameter;
+		
+		if (!pProcessor->ProcessBand(nBegin, nEnd))
+			pProcessor->m_bResult = false;
+	}
+	
+	bool ProcessBand(int nBegin, int nEnd)
+	{
+		if (m_nHalo == 0)
+		{
+			TInput *pInputView1 = CreateRowView(m_pInputImage1, nBegin, nEnd - nBegin);
+			TInput *pInputView2 = m_pInputImage2 ? CreateRowView(m_pInputImage2, nBegin, nEnd - nBegin) : 0;
+			TOutput *pOutputView = CreateRowView(m_pOutputImage, nBegin, nEnd - nBegin);
+			
+			const bool bResult = m_operation(pInputView1, pInputView2, pOutputView);
+			
+			delete pInputView1;
+			delete pInputView2;
+			delete pOutputView;
+			
+			return bResult;
+		}
+		
+		int nFirst = MY_MAX(0, nBegin - m_nHalo);
+		nFirst -= nFirst % m_nRowAlignment;
+		const int nLast = MY_MIN(GetHeight(m_pOutputImage), nEnd + m_nHalo);
+		
+		TInput *pInputView1 = CreateRowView(m_pInputImage1, nFirst, nLast - nFirst);
+		TInput *pInputView2 = m_pInputImage2 ? CreateRowView(m_pInputImage2, nFirst, nLast - nFirst) : 0;
+		TOutput *pBandImage = CreateRowBandImage(m_pOutputImage, nLast - nFirst);
+		
+		const bool bResult = m_operation(pInputView1, pInputView2, pBandImage);
+		
+		TOutput *pBandView = CreateRowView(pBandImage, nBegin - nFirst, nEnd - nBegin);
+		TOutput *pOutputView = CreateRowView(m_pOutputImage, nBegin, nEnd - nBegin);
+		CopyPixels(pBandView, pOutputView);
+		delete pBandView;
+		delete pOutputView;
+		
+		delete pInputView1;
+		delete pInputView2;
+		delete pBandImage;
+		
+		return bResult;
+	}
+	
+	const TOperation &m_operation;
+	const TInput *m_pInputImage1;
+	const TInput *m_pInputImage2;
+	TOutput *m_pOutputImage;
+	int m_nHalo;
+	int m_nRowAlignment;
+	volatile bool m_bResult;
+};
+
+template <class TOperation>
+class CUnaryOperation
+{
+public:
+	CUnaryOperation(const TOperation &operation) : m_operation(operation) { }
+	
+	template <class TInput, class TOutput>
+	bool operator()(const TInput *pInputImage, const TInput *, TOutput *pOutputImage) const { return m_operation(pInputImage, pOutputImage); }
+	
+private:
+	const TOperation &m_operation;
+};
+
+// Processes the operation in row bands if the worker pool is enabled and available.
+// Returns true if the image has been processed (bResult then holds the result), or false if the serial path must be taken.
+// nHalo is the number of neighboring rows on each side needed for computing one output row (0 for pixel-wise operations),
+// nRowAlignment the alignment of the first row of each band view (e.g. 2 for Bayer patterns).
+template <class TOperation, class TInput, class TOutput>
+static bool ProcessInRowBands(const TOperation &operation, const TInput *pInputImage, TOutput *pOutputImage, int nHalo, bool &bResult, int nRowAlignment = 1)
+{
+	const CUnaryOperation<TOperation> unaryOperation(operation);
+	CRowBandProcessor<CUnaryOperation<TOperation>, TInput, TOutput> processor(unaryOperation, pInputImage, 0, pOutputImage, nHalo, nRowAlignment);
+	return processor.Process(bResult);
+}
+
+// pixel-wise operations with two input images
+template <class TOperation, class TInput, class TOutput>
+static bool ProcessInRowBands(const TOperation &operation, const TInput *pInputImage1, const TInput *pInputImage2, TOutput *pOutputImage, bool &bResult)
+{
+	CRowBandProcessor<TOperation, TInput, TOutput> processor(operation, pInputImage1, pInputImage2, pOutputImage, 0, 1);
+	return processor.Process(bResult);
+}
+
+
 
 // ****************************************************************************
 // Functions
 // ****************************************************************************
 
+struct GeneralFilterOperation
+{
+	GeneralFilterOperation(const int *pKernel, int nMaskSize, int nDivider, bool bAbsoluteValue) :
+		pKernel(pKernel), nMaskSize(nMaskSize), nDivider(nDivider), bAbsoluteValue(bAbsoluteValue) { }
+	
+	template <class TOutput>
+	bool operator()(const CByteImage *pInputImage, TOutput *pOutputImage) const { return ImageProcessor::GeneralFilter(pInputImage, pOutputImage, pKernel, nMaskSize, nDivider, bAbsoluteValue); }
+	
+	const int *pKernel;
+	int nMaskSize;
+	int nDivider;
+	bool bAbsoluteValue;
+};
+
 bool ImageProcessor::GeneralFilter(const CByteImage *pInputImage, CByteImage *pOutputImage, const int *pKernel, int nMaskSize, int nDivider, bool bAbsoluteValue)
 {
+	bool bResult;
+	if (nMaskSize > 0 && ProcessInRowBands(GeneralFilterOperation(pKernel, nMaskSize, nDivider, bAbsoluteValue), pInputImage, pOutputImage, nMaskSize / 2 + 1, bResult))
+		return bResult;
+	
+	if (pInputImage->IsPadded() || pOutputImage->IsPadded())
+	{
+		CUnpaddedImage<CByteImage> input(pInputImage), output(pOutputImage, true);
+		return GeneralFilter(input, output, pKernel, nMaskSize, nDivider, bAbsoluteValue);
+	}
+	
 	if (pInputImage->width != pOutputImage->width || pInputImage->height != pOutputImage->height ||
 		pInputImage->type != CByteImage::eGrayScale || pOutputImage->type != CByteImage::eGrayScale)
 	{
@@ -283,6 +568,17 @@ bool ImageProcessor::GeneralFilter(const CByteImage *pInputImage, CByteImage *pO
 
 bool ImageProcessor::GeneralFilter(const CByteImage *pInputImage, CShortImage *pOutputImage, const int *pKernel, int nMaskSize, int nDivider, bool bAbsoluteValue)
 {
+	bool bResult;
+	if (nMaskSize > 0 && ProcessInRowBands(GeneralFilterOperation(pKernel, nMaskSize, nDivider, bAbsoluteValue), pInputImage, pOutputImage, nMaskSize / 2 + 1, bResult))
+		return bResult;
+	
+	if (pInputImage->IsPadded() || pOutputImage->IsPadded())
+	{
+		CUnpaddedImage<CByteImage> input(pInputImage);
+		CUnpaddedImage<CShortImage> output(pOutputImage, true);
+		return GeneralFilter(input, output, pKernel, nMaskSize, nDivider, bAbsoluteValue);
+	}
+	
 	if (pInputImage->width != pOutputImage->width || pInputImage->height != pOutputImage->height ||
 		pInputImage->type != CByteImage::eGrayScale)
 	{
@@ -392,6 +688,17 @@ bool ImageProcessor::GeneralFilter(const CByteImage *pInputImage, CShortImage *p
 
 bool ImageProcessor::GeneralFilter(const CByteImage *pInputImage, CFloatMatrix *pOutputMatrix, const int *pKernel, int nMaskSize, int nDivider, bool bAbsoluteValue)
 {
+	bool bResult;
+	if (nMaskSize > 0 && ProcessInRowBands(GeneralFilterOperation(pKernel, nMaskSize, nDivider, bAbsoluteValue), pInputImage, pOutputMatrix, nMaskSize / 2 + 1, bResult))
+		return bResult;
+	
+	if (pInputImage->IsPadded() || pOutputMatrix->IsPadded())
+	{
+		CUnpaddedImage<CByteImage> input(pInputImage);
+		CUnpaddedImage<CFloatMatrix> output(pOutputMatrix, true);
+		return GeneralFilter(input, output, pKernel, nMaskSize, nDivider, bAbsoluteValue);
+	}
+	
 	if (pInputImage->width != pOutputMatrix->columns || pInputImage->height != pOutputMatrix->rows ||
 		pInputImage->type != CByteImage::eGrayScale)
 	{
@@ -531,10 +838,25 @@ bool ImageProcessor::GeneralFilter(const CByteImage *pInputImage, CFloatMatrix *
 // ( 4 16 24 16  4 )     ( 4 )
 // ( 1  4  6  4  1 )     ( 1 )
 
+struct GaussianSmooth5x5Operation
+{
+	bool operator()(const CByteImage *pInputImage, CByteImage *pOutputImage) const { return ImageProcessor::GaussianSmooth5x5(pInputImage, pOutputImage); }
+};
+
 bool ImageProcessor::GaussianSmooth5x5(const CByteImage *pInputImage, CByteImage *pOutputImage)
 {
+	bool bResult;
+	if (ProcessInRowBands(GaussianSmooth5x5Operation(), pInputImage, pOutputImage, 3, bResult))
+		return bResult;
+	
 	OPTIMIZED_FUNCTION_HEADER_2(GaussianSmooth5x5, pInputImage, pOutputImage)
 	
+	if (pInputImage->IsPadded() || pOutputImage->IsPadded())
+	{
+		CUnpaddedImage<CByteImage> input(pInputImage), output(pOutputImage, true);
+		return GaussianSmooth5x5(input, output);
+	}
+	
 	if (!pInputImage->IsCompatible(pOutputImage))
 	{
 		printf("error: input and output image do not match for ImageProcessor::GaussianSmooth5x5\n");
@@ -689,6 +1011,12 @@ static bool AverageFilter3x3(const CByteImage *pInputImage, CByteImage *pOutputI
 
 bool ImageProcessor::AverageFilter(const CByteImage *pInputImage, CByteImage *pOutputImage, int nMaskSize)
 {
+	if (pInputImage->IsPadded() || pOutputImage->IsPadded())
+	{
+		CUnpaddedImage<CByteImage> input(pInputImage), output(pOutputImage, true);
+		return AverageFilter(input, output, nMaskSize);
+	}
+	
 	if (nMaskSize == 3)
 	{
 		AverageFilter3x3(pInputImage, pOutputImage);
@@ -743,8 +1071,17 @@ bool ImageProcessor::AverageFilter(const CByteImage *pInputImage, CByteImage *pO
 }
 
 
+struct GaussianSmooth3x3Operation
+{
+	bool operator()(const CByteImage *pInputImage, CByteImage *pOutputImage) const { return ImageProcessor::GaussianSmooth3x3(pInputImage, pOutputImage); }
+};
+
 bool ImageProcessor::GaussianSmooth3x3(const CByteImage *pInputImage, CByteImage *pOutputImage)
 {
+	bool bResult;
+	if (ProcessInRowBands(GaussianSmooth3x3Operation(), pInputImage, pOutputImage, 2, bResult))
+		return bResult;
+	
 	OPTIMIZED_FUNCTION_HEADER_2(GaussianSmooth3x3, pInputImage, pOutputImage)
 	
 	if (pInputImage->width != pOutputImage->width || pInputImage->height != pOutputImage->height ||
@@ -768,60 +1105,43 @@ bool ImageProcessor::GaussianSmooth3x3(const CByteImage *pInputImage, CByteImage
 	}
 
 	const int maxj = pInputImage->width - 1, maxi = pInputImage->height - 1;
-	const unsigned char *p = pInputImage->pixels;
-	unsigned char *output = pOutputImage->pixels;
+	const int input_stride = pInputImage->GetStride();
+	const int output_stride = pOutputImage->GetStride();
 	
 	if (pInputImage->type == CByteImage::eGrayScale)
 	{
-		const int width = pInputImage->width;
-
-		for (int i = 1, offset = width + 1; i < maxi; i++, offset += 2)
+		for (int i = 1; i < maxi; i++)
 		{
-			for (int j = 1; j < maxj; j++, offset++)
+			const unsigned char *p = pInputImage->pixels + i * input_stride;
+			unsigned char *output = pOutputImage->pixels + i * output_stride;
+
+			for (int offset = 1; offset < maxj; offset++)
 			{
 				output[offset] = (
-					p[offset - width - 1] + (p[offset - width] << 1) + p[offset - width + 1] +
+					p[offset - input_stride - 1] + (p[offset - input_stride] << 1) + p[offset - input_stride + 1] +
 					(p[offset - 1] << 1) + (p[offset] << 2) + (p[offset + 1] << 1) + 
-					p[offset + width - 1] + (p[offset + width] << 1) + p[offset + width + 1] + 8
+					p[offset + input_stride - 1] + (p[offset + input_stride] << 1) + p[offset + input_stride + 1] + 8
 				) >> 4;
 			}
 		}
 	}
 	else if (pInputImage->type == CByteImage::eRGB24)
 	{
-		const int width = 3 * pInputImage->width;
-		int offset = width + 3;
-
+		const int maxoffset = 3 * maxj;
+		
 		for (int i = 1; i < maxi; i++)
 		{
-			for (int j = 1; j < maxj; j++)
-			{
-				output[offset] = (
-					p[offset - width - 3] + (p[offset - width] << 1) + p[offset - width + 3] +
-					(p[offset - 3] << 1) + (p[offset] << 2) + (p[offset + 3] << 1) + 
-					p[offset + width - 3] + (p[offset + width] << 1) + p[offset + width + 3] + 8
-				) >> 4;
-
-				offset++;
-
-				output[offset] = (
-					p[offset - width - 3] + (p[offset - width] << 1) + p[offset - width + 3] +
-					(p[offset - 3] << 1) + (p[offset] << 2) + (p[offset + 3] << 1) + 
-					p[offset + width - 3] + (p[offset + width] << 1) + p[offset + width + 3] + 8
-				) >> 4;
-
-				offset++;
+			const unsigned char *p = pInputImage->pixels + i * input_stride;
+			unsigned char *output = pOutputImage->pixels + i * output_stride;
 
+			for (int offset = 3; offset < maxoffset; offset++)
+			{
 				output[offset] = (
-					p[offset - width - 3] + (p[offset - width] << 1) + p[offset - width + 3] +
+					p[offset - input_stride - 3] + (p[offset - input_stride] << 1) + p[offset - input_stride + 3] +
 					(p[offset - 3] << 1) + (p[offset] << 2) + (p[offset + 3] << 1) + 
-					p[offset + width - 3] + (p[offset + width] << 1) + p[offset + width + 3] + 8
+					p[offset + input_stride - 3] + (p[offset + input_stride] << 1) + p[offset + input_stride + 3] + 8
 				) >> 4;
-
-				offset++;
 			}
-
-			offset += 6;
 		}
 	}
 	
@@ -863,8 +1183,21 @@ bool ImageProcessor::SobelY(const CByteImage *pInputImage, CByteImage *pOutputIm
 	return ConvertImage(&image, pOutputImage);
 }
 
+struct SobelYOperation
+{
+	SobelYOperation(bool bAbsoluteValue) : bAbsoluteValue(bAbsoluteValue) { }
+	
+	bool operator()(const CByteImage *pInputImage, CShortImage *pOutputImage) const { return ImageProcessor::SobelY(pInputImage, pOutputImage, bAbsoluteValue); }
+	
+	bool bAbsoluteValue;
+};
+
 bool ImageProcessor::SobelY(const CByteImage *pInputImage, CShortImage *pOutputImage, bool bAbsoluteValue)
 {
+	bool bResult;
+	if (ProcessInRowBands(SobelYOperation(bAbsoluteValue), pInputImage, pOutputImage, 2, bResult))
+		return bResult;
+	
 	OPTIMIZED_FUNCTION_HEADER_3(SobelY, pInputImage, pOutputImage, bAbsoluteValue)
 
 	if (pInputImage->width != pOutputImage->width || pInputImage->height != pOutputImage->height ||
@@ -877,31 +1210,35 @@ bool ImageProcessor::SobelY(const CByteImage *pInputImage, CShortImage *pOutputI
 	ZeroFrame(pOutputImage);
 
 	const int maxj = pInputImage->width - 1, maxi = pInputImage->height - 1;
-	const int width = pInputImage->width;
-	const unsigned char *input = pInputImage->pixels;
-	short *output = pOutputImage->pixels;
+	const int stride = pInputImage->GetStride();
 
 	if (bAbsoluteValue)
 	{
-		for (int i = 1, offset = width + 1; i < maxi; i++, offset += 2)
+		for (int i = 1; i < maxi; i++)
 		{
-			for (int j = 1; j < maxj; j++, offset++)
+			const unsigned char *input = pInputImage->pixels + i * stride;
+			short *output = pOutputImage->pixels + i * pOutputImage->GetStride();
+
+			for (int offset = 1; offset < maxj; offset++)
 			{
 				output[offset] =
-					abs(input[offset + width - 1] + (input[offset + width] << 1) + input[offset + width + 1] -
-					input[offset - width - 1] - (input[offset - width] << 1) - input[offset - width + 1]);
+					abs(input[offset + stride - 1] + (input[offset + stride] << 1) + input[offset + stride + 1] -
+					input[offset - stride - 1] - (input[offset - stride] << 1) - input[offset - stride + 1]);
 			}
 		}
 	}
 	else
 	{
-		for (int i = 1, offset = width + 1; i < maxi; i++, offset += 2)
+		for (int i = 1; i < maxi; i++)
 		{
-			for (int j = 1; j < maxj; j++, offset++)
+			const unsigned char *input = pInputImage->pixels + i * stride;
+			short *output = pOutputImage->pixels + i * pOutputImage->GetStride();
+
+			for (int offset = 1; offset < maxj; offset++)
 			{
 				output[offset] =
-					input[offset + width - 1] + (input[offset + width] << 1) + input[offset + width + 1] -
-					input[offset - width - 1] - (input[offset - width] << 1) - input[offset - width + 1];
+					input[offset + stride - 1] + (input[offset + stride] << 1) + input[offset + stride + 1] -
+					input[offset - stride - 1] - (input[offset - stride] << 1) - input[offset - stride + 1];
 			}
 		}
 	}
@@ -911,8 +1248,21 @@ bool ImageProcessor::SobelY(const CByteImage *pInputImage, CShortImage *pOutputI
 	return true;
 }
 
+struct SobelXOperation
+{
+	SobelXOperation(bool bAbsoluteValue) : bAbsoluteValue(bAbsoluteValue) { }
+	
+	bool operator()(const CByteImage *pInputImage, CShortImage *pOutputImage) const { return ImageProcessor::SobelX(pInputImage, pOutputImage, bAbsoluteValue); }
+	
+	bool bAbsoluteValue;
+};
+
 bool ImageProcessor::SobelX(const CByteImage *pInputImage, CShortImage *pOutputImage, bool bAbsoluteValue)
 {
+	bool bResult;
+	if (ProcessInRowBands(SobelXOperation(bAbsoluteValue), pInputImage, pOutputImage, 2, bResult))
+		return bResult;
+	
 	OPTIMIZED_FUNCTION_HEADER_3(SobelX, pInputImage, pOutputImage, bAbsoluteValue)
 
 	if (pInputImage->width != pOutputImage->width || pInputImage->height != pOutputImage->height ||
@@ -925,31 +1275,35 @@ bool ImageProcessor::SobelX(const CByteImage *pInputImage, CShortImage *pOutputI
 	ZeroFrame(pOutputImage);
 
 	const int maxj = pInputImage->width - 1, maxi = pInputImage->height - 1;
-	const int width = pInputImage->width;
-	const unsigned char *input = pInputImage->pixels;
-	short *output = pOutputImage->pixels;
+	const int stride = pInputImage->GetStride();
 
 	if (bAbsoluteValue)
 	{
-		for (int i = 1, offset = width + 1; i < maxi; i++, offset += 2)
+		for (int i = 1; i < maxi; i++)
 		{
-			for (int j = 1; j < maxj; j++, offset++)
+			const unsigned char *input = pInputImage->pixels + i * stride;
+			short *output = pOutputImage->pixels + i * pOutputImage->GetStride();
+
+			for (int offset = 1; offset < maxj; offset++)
 			{
 				output[offset] =
-					abs(input[offset - width + 1] + (input[offset + 1] << 1) + input[offset + width + 1] -
-					input[offset - width - 1] - (input[offset - 1] << 1) - input[offset + width - 1]);
+					abs(input[offset - stride + 1] + (input[offset + 1] << 1) + input[offset + stride + 1] -
+					input[offset - stride - 1] - (input[offset - 1] << 1) - input[offset + stride - 1]);
 			}
 		}
 	}
 	else
 	{
-		for (int i = 1, offset = width + 1; i < maxi; i++, offset += 2)
+		for (int i = 1; i < maxi; i++)
 		{
-			for (int j = 1; j < maxj; j++, offset++)
+			const unsigned char *input = pInputImage->pixels + i * stride;
+			short *output = pOutputImage->pixels + i * pOutputImage->GetStride();
+
+			for (int offset = 1; offset < maxj; offset++)
 			{
 				output[offset] =
-					input[offset - width + 1] + (input[offset + 1] << 1) + input[offset + width + 1] -
-					input[offset - width - 1] - (input[offset - 1] << 1) - input[offset + width - 1];
+					input[offset - stride + 1] + (input[offset + 1] << 1) + input[offset + stride + 1] -
+					input[offset - stride - 1] - (input[offset - 1] << 1) - input[offset + stride - 1];
 			}
 		}
 	}
@@ -980,8 +1334,21 @@ bool ImageProcessor::PrewittY(const CByteImage *pInputImage, CByteImage *pOutput
 	return ConvertImage(&image, pOutputImage);
 }
 
+struct PrewittYOperation
+{
+	PrewittYOperation(bool bAbsoluteValue) : bAbsoluteValue(bAbsoluteValue) { }
+	
+	bool operator()(const CByteImage *pInputImage, CShortImage *pOutputImage) const { return ImageProcessor::PrewittY(pInputImage, pOutputImage, bAbsoluteValue); }
+	
+	bool bAbsoluteValue;
+};
+
 bool ImageProcessor::PrewittY(const CByteImage *pInputImage, CShortImage *pOutputImage, bool bAbsoluteValue)
 {
+	bool bResult;
+	if (ProcessInRowBands(PrewittYOperation(bAbsoluteValue), pInputImage, pOutputImage, 2, bResult))
+		return bResult;
+	
 	OPTIMIZED_FUNCTION_HEADER_3(PrewittY, pInputImage, pOutputImage, bAbsoluteValue)
 
 	if (pInputImage->width != pOutputImage->width || pInputImage->height != pOutputImage->height ||
@@ -994,31 +1361,35 @@ bool ImageProcessor::PrewittY(const CByteImage *pInputImage, CShortImage *pOutpu
 	ZeroFrame(pOutputImage);
 
 	const int maxj = pInputImage->width - 1, maxi = pInputImage->height - 1;
-	const int width = pInputImage->width;
-	const unsigned char *input = pInputImage->pixels;
-	short *output = pOutputImage->pixels;
+	const int stride = pInputImage->GetStride();
 
 	if (bAbsoluteValue)
 	{
-		for (int i = 1, offset = width + 1; i < maxi; i++, offset += 2)
+		for (int i = 1; i < maxi; i++)
 		{
-			for (int j = 1; j < maxj; j++, offset++)
+			const unsigned char *input = pInputImage->pixels + i * stride;
+			short *output = pOutputImage->pixels + i * pOutputImage->GetStride();
+
+			for (int offset = 1; offset < maxj; offset++)
 			{
 				output[offset] =
-					abs(input[offset + width - 1] + input[offset + width] + input[offset + width + 1] -
-					input[offset - width - 1] - input[offset - width] - input[offset - width + 1]);
+					abs(input[offset + stride - 1] + input[offset + stride] + input[offset + stride + 1] -
+					input[offset - stride - 1] - input[offset - stride] - input[offset - stride + 1]);
 			}
 		}
 	}
 	else
 	{
-		for (int i = 1, offset = width + 1; i < maxi; i++, offset += 2)
+		for (int i = 1; i < maxi; i++)
 		{
-			for (int j = 1; j < maxj; j++, offset++)
+			const unsigned char *input = pInputImage->pixels + i * stride;
+			short *output = pOutputImage->pixels + i * pOutputImage->GetStride();
+
+			for (int offset = 1; offset < maxj; offset++)
 			{
 				output[offset] =
-					input[offset + width - 1] + input[offset + width] + input[offset + width + 1] -
-					input[offset - width - 1] - input[offset - width] - input[offset - width + 1];
+					input[offset + stride - 1] + input[offset + stride] + input[offset + stride + 1] -
+					input[offset - stride - 1] - input[offset - stride] - input[offset - stride + 1];
 			}
 		}
 	}
@@ -1028,8 +1399,21 @@ bool ImageProcessor::PrewittY(const CByteImage *pInputImage, CShortImage *pOutpu
 	return true;
 }
 
+struct PrewittXOperation
+{
+	PrewittXOperation(bool bAbsoluteValue) : bAbsoluteValue(bAbsoluteValue) { }
+	
+	bool operator()(const CByteImage *pInputImage, CShortImage *pOutputImage) const { return ImageProcessor::PrewittX(pInputImage, pOutputImage, bAbsoluteValue); }
+	
+	bool bAbsoluteValue;
+};
+
 bool ImageProcessor::PrewittX(const CByteImage *pInputImage, CShortImage *pOutputImage, bool bAbsoluteValue)
 {
+	bool bResult;
+	if (ProcessInRowBands(PrewittXOperation(bAbsoluteValue), pInputImage, pOutputImage, 2, bResult))
+		return bResult;
+	
 	OPTIMIZED_FUNCTION_HEADER_3(PrewittX, pInputImage, pOutputImage, bAbsoluteValue)
 
 	if (pInputImage->width != pOutputImage->width || pInputImage->height != pOutputImage->height ||
@@ -1042,33 +1426,35 @@ bool ImageProcessor::PrewittX(const CByteImage *pInputImage, CShortImage *pOutpu
 	ZeroFrame(pOutputImage);
 
 	const int maxj = pInputImage->width - 1, maxi = pInputImage->height - 1;
-	const int width = pInputImage->width;
-	const unsigned char *input = pInputImage->pixels;
-	short *output = pOutputImage->pixels;
+	const int stride = pInputImage->GetStride();
 
 	if (bAbsoluteValue)
 	{
-		for (int i = 1; i < maxi; ++i)
+		for (int i = 1; i < maxi; i++)
 		{
-			int offset = width * i + 1;
-			for (int j = 1; j < maxj; ++j, ++offset)
+			const unsigned char *input = pInputImage->pixels + i * stride;
+			short *output = pOutputImage->pixels + i * pOutputImage->GetStride();
+
+			for (int offset = 1; offset < maxj; offset++)
 			{
 				output[offset] =
-					abs(input[offset - width + 1] + input[offset + 1] + input[offset + width + 1] -
-					input[offset - width - 1] - input[offset - 1] - input[offset + width - 1]);
+					abs(input[offset - stride + 1] + input[offset + 1] + input[offset + stride + 1] -
+					input[offset - stride - 1] - input[offset - 1] - input[offset + stride - 1]);
 			}
 		}
 	}
 	else
 	{
-		for (int i = 1; i < maxi; ++i)
+		for (int i = 1; i < maxi; i++)
 		{
-			int offset = width * i + 1;
-			for (int j = 1; j < maxj; ++j, ++offset)
+			const unsigned char *input = pInputImage->pixels + i * stride;
+			short *output = pOutputImage->pixels + i * pOutputImage->GetStride();
+
+			for (int offset = 1; offset < maxj; offset++)
 			{
 				output[offset] =
-					input[offset - width + 1] + input[offset + 1] + input[offset + width + 1] -
-					input[offset - width - 1] - input[offset - 1] - input[offset + width - 1];
+					input[offset - stride + 1] + input[offset + 1] + input[offset + stride + 1] -
+					input[offset - stride - 1] - input[offset - 1] - input[offset + stride - 1];
 			}
 		}
 	}
@@ -1117,33 +1503,37 @@ bool ImageProcessor::Laplace1(const CByteImage *pInputImage, CShortImage *pOutpu
 	ZeroFrame(pOutputImage);
 
 	const int maxj = pInputImage->width - 1, maxi = pInputImage->height - 1;
-	const int width = pInputImage->width;
-	const unsigned char *input = pInputImage->pixels;
-	short *output = pOutputImage->pixels;
+	const int stride = pInputImage->GetStride();
 
 	if (bAbsoluteValue)
 	{
-		for (int i = 1, offset = width + 1; i < maxi; i++, offset += 2)
+		for (int i = 1; i < maxi; i++)
 		{
-			for (int j = 1; j < maxj; j++, offset++)
+			const unsigned char *input = pInputImage->pixels + i * stride;
+			short *output = pOutputImage->pixels + i * pOutputImage->GetStride();
+
+			for (int offset = 1; offset < maxj; offset++)
 			{
 				output[offset] =
-					abs(input[offset - width] +
+					abs(input[offset - stride] +
 					input[offset - 1] - (input[offset] << 2) + input[offset + 1] + 
-					input[offset + width]);
+					input[offset + stride]);
 			}
 		}
 	}
 	else
 	{
-		for (int i = 1, offset = width + 1; i < maxi; i++, offset += 2)
+		for (int i = 1; i < maxi; i++)
 		{
-			for (int j = 1; j < maxj; j++, offset++)
+			const unsigned char *input = pInputImage->pixels + i * stride;
+			short *output = pOutputImage->pixels + i * pOutputImage->GetStride();
+
+			for (int offset = 1; offset < maxj; offset++)
 			{
 				output[offset] =
-					input[offset - width] +
+					input[offset - stride] +
 					input[offset - 1] - (input[offset] << 2) + input[offset + 1] + 
-					input[offset + width];
+					input[offset + stride];
 			}
 		}
 	}
@@ -1167,33 +1557,37 @@ bool ImageProcessor::Laplace2(const CByteImage *pInputImage, CShortImage *pOutpu
 	ZeroFrame(pOutputImage);
 
 	const int maxj = pInputImage->width - 1, maxi = pInputImage->height - 1;
-	const int width = pInputImage->width;
-	const unsigned char *input = pInputImage->pixels;
-	short *output = pOutputImage->pixels;
+	const int stride = pInputImage->GetStride();
 
 	if (bAbsoluteValue)
 	{
-		for (int i = 1, offset = width + 1; i < maxi; i++, offset += 2)
+		for (int i = 1; i < maxi; i++)
 		{
-			for (int j = 1; j < maxj; j++, offset++)
+			const unsigned char *input = pInputImage->pixels + i * stride;
+			short *output = pOutputImage->pixels + i * pOutputImage->GetStride();
+
+			for (int offset = 1; offset < maxj; offset++)
 			{
 				output[offset] =
-					abs(input[offset - width - 1] + input[offset - width] + input[offset - width + 1] +
+					abs(input[offset - stride - 1] + input[offset - stride] + input[offset - stride + 1] +
 					input[offset - 1] - (input[offset] << 3) + input[offset + 1] + 
-					input[offset + width - 1] + input[offset + width] + input[offset + width + 1]);
+					input[offset + stride - 1] + input[offset + stride] + input[offset + stride + 1]);
 			}
 		}
 	}
 	else
 	{
-		for (int i = 1, offset = width + 1; i < maxi; i++, offset += 2)
+		for (int i = 1; i < maxi; i++)
 		{
-			for (int j = 1; j < maxj; j++, offset++)
+			const unsigned char *input = pInputImage->pixels + i * stride;
+			short *output = pOutputImage->pixels + i * pOutputImage->GetStride();
+
+			for (int offset = 1; offset < maxj; offset++)
 			{
 				output[offset] =
-					input[offset - width - 1] + input[offset - width] + input[offset - width + 1] +
+					input[offset - stride - 1] + input[offset - stride] + input[offset - stride + 1] +
 					input[offset - 1] - (input[offset] << 3) + input[offset + 1] + 
-					input[offset + width - 1] + input[offset + width] + input[offset + width + 1];
+					input[offset + stride - 1] + input[offset + stride] + input[offset + stride + 1];
 			}
 		}
 	}
@@ -1225,21 +1619,22 @@ bool ImageProcessor::CalculateGradientImagePrewitt(const CByteImage *pInputImage
 	ZeroFrame(pOutputImage);
 
 	const int maxu = pInputImage->width - 1, maxv = pInputImage->height - 1;
-	const int width = pInputImage->width;
-	const unsigned char *input = pInputImage->pixels;
-	unsigned char *output = pOutputImage->pixels;
+	const int stride = pInputImage->GetStride();
 
-	for (int v = 1, offset = width + 1; v < maxv; v++, offset += 2)
+	for (int v = 1; v < maxv; v++)
 	{
-		for (int u = 1; u < maxu; u++, offset++)
+		const unsigned char *input = pInputImage->pixels + v * stride;
+		unsigned char *output = pOutputImage->pixels + v * pOutputImage->GetStride();
+
+		for (int offset = 1; offset < maxu; offset++)
 		{
 			const int value_x = 
-				abs(input[offset + width - 1] + input[offset + width] + input[offset + width + 1] -
-				input[offset - width - 1] - input[offset - width] - input[offset - width + 1]);
+				abs(input[offset + stride - 1] + input[offset + stride] + input[offset + stride + 1] -
+				input[offset - stride - 1] - input[offset - stride] - input[offset - stride + 1]);
 				
 			const int value_y = 
-				abs(input[offset - width + 1] + input[offset + 1] + input[offset + width + 1] -
-				input[offset - width - 1] - input[offset - 1] - input[offset + width - 1]);
+				abs(input[offset - stride + 1] + input[offset + 1] + input[offset + stride + 1] -
+				input[offset - stride - 1] - input[offset - 1] - input[offset + stride - 1]);
 			
 			const int value = value_x > value_y ? value_x : value_y;
 
@@ -1279,21 +1674,22 @@ bool ImageProcessor::CalculateGradientImageSobel(const CByteImage *pInputImage,
 	ZeroFrame(pOutputImage);
 
 	const int maxu = pInputImage->width - 1, maxv = pInputImage->height - 1;
-	const int width = pInputImage->width;
-	const unsigned char *input = pInputImage->pixels;
-	unsigned char *output = pOutputImage->pixels;
+	const int stride = pInputImage->GetStride();
 
-	for (int v = 1, offset = width + 1; v < maxv; v++, offset += 2)
+	for (int v = 1; v < maxv; v++)
 	{
-		for (int u = 1; u < maxu; u++, offset++)
+		const unsigned char *input = pInputImage->pixels + v * stride;
+		unsigned char *output = pOutputImage->pixels + v * pOutputImage->GetStride();
+
+		for (int offset = 1; offset < maxu; offset++)
 		{
 			const int value_x = 
-				abs(input[offset + width - 1] + (input[offset + width] << 1) + input[offset + width + 1] -
-				input[offset - width - 1] - (input[offset - width] << 1) - input[offset - width + 1]);
+				abs(input[offset + stride - 1] + (input[offset + stride] << 1) + input[offset + stride + 1] -
+				input[offset - stride - 1] - (input[offset - stride] << 1) - input[offset - stride + 1]);
 				
 			const int value_y = 
-				abs(input[offset - width + 1] + (input[offset + 1] << 1) + input[offset + width + 1] -
-				input[offset - width - 1] - (input[offset - 1] << 1) - input[offset + width - 1]);
+				abs(input[offset - stride + 1] + (input[offset + 1] << 1) + input[offset + stride + 1] -
+				input[offset - stride - 1] - (input[offset - 1] << 1) - input[offset + stride - 1]);
 			
 			const int value = value_x > value_y ? value_x : value_y;
 			
@@ -1314,6 +1710,12 @@ bool ImageProcessor::CalculateGradientImageSobel(const CByteImage *pInputImage,
 
 bool ImageProcessor::CalculateGradientImage(const CByteImage *pInputImage, CByteImage *pOutputImage)
 {
+	if (pInputImage->IsPadded() || pOutputImage->IsPadded())
+	{
+		CUnpaddedImage<CByteImage> input(pInputImage), output(pOutputImage, true);
+		return CalculateGradientImage(input, output);
+	}
+	
 	if (pInputImage->width != pOutputImage->width || pInputImage->height != pOutputImage->height)
 	{
 		printf("error: input and output image do not match for ImageProcessor::CalculateGradientImage\n");
@@ -1384,6 +1786,12 @@ bool ImageProcessor::CalculateGradientImage(const CByteImage *pInputImage, CByte
 
 bool ImageProcessor::CalculateGradientImageBinary(const CByteImage *pInputImage, CByteImage *pOutputImage)
 {
+	if (pInputImage->IsPadded() || pOutputImage->IsPadded())
+	{
+		CUnpaddedImage<CByteImage> input(pInputImage), output(pOutputImage, true);
+		return CalculateGradientImageBinary(input, output);
+	}
+	
 	if (pInputImage->width != pOutputImage->width || pInputImage->height != pOutputImage->height ||
 		pInputImage->type != CByteImage::eGrayScale || pOutputImage->type != CByteImage::eGrayScale)
 	{
@@ -1423,33 +1831,348 @@ bool ImageProcessor::CalculateGradientImageBinary(const CByteImage *pInputImage,
 }
 
 
-static bool Dilate3x3(const CByteImage *pInputImage, CByteImage *pOutputImage, const MyRegion *pROI)
+// ****************************************************************************
+// Separable morphological filters (van Herk/Gil-Werman)
+// ****************************************************************************
+
+// The filters compute the maximum (dilation) or minimum (erosion) of a rectangle with 3 operations per pixel
+// and direction, independent of the size of the rectangle. A row of length n is padded to a multiple of the
+// window size m = 2k + 1 and divided into blocks of m values. Within each block, the prefix and suffix maxima
+// are computed. The maximum of the window starting at x is then max(suffix[x], prefix[x + 2k]).
+// The horizontal pass is computed per row, the vertical pass processes whole rows (OptimizedMorphologyRowMax/Min).
+//
+// Semantics (same as the generic square filters): Only input pixels (x, y) with kx <= x < width - kx and
+// ky <= y < height - ky, i.e. pixels for which the element fits into the image, are considered by Dilate.
+// Erode sets only such pixels to 255, all other pixels are set to 0. Non-zero input pixels are foreground.
+
+struct MorphologyMax
 {
-	OPTIMIZED_FUNCTION_HEADER_2_ROI(Dilate3x3, pInputImage, pOutputImage, pROI)
+	static inline unsigned char Identity() { return 0; }
+	static inline unsigned char Apply(unsigned char a, unsigned char b) { return a > b ? a : b; }
 	
-	if (pInputImage->width != pOutputImage->width || pInputImage->height != pOutputImage->height ||
-		pInputImage->type != pOutputImage->type || pInputImage->type != CByteImage::eGrayScale)
+	static inline void ApplyRow(const unsigned char *pInput1, const unsigned char *pInput2, unsigned char *pOutput, int nPixels, bool bBinarize)
 	{
-		printf("error: input and output image do not match for Dilate3x3\n");
-		return false;
-	}
+		OPTIMIZED_FUNCTION_HEADER_5(MorphologyRowMax, pInput1, pInput2, pOutput, nPixels, bBinarize)
 		
-	CByteImage *pSaveOutputImage = 0;
-	if (pInputImage->pixels == pOutputImage->pixels)
-	{
-		pSaveOutputImage = pOutputImage;
-		pOutputImage = new CByteImage(pInputImage);
+		for (int i = 0; i < nPixels; i++)
+		{
+			const unsigned char v = Apply(pInput1[i], pInput2[i]);
+			pOutput[i] = bBinarize ? (v ? 255 : 0) : v;
+		}
+		
+		OPTIMIZED_FUNCTION_FOOTER
 	}
+};
 
-	ImageProcessor::Zero(pOutputImage, pROI);
-
-	const int width = pInputImage->width;
-	const int height = pInputImage->height;
+struct MorphologyMin
+{
+	static inline unsigned char Identity() { return 255; }
+	static inline unsigned char Apply(unsigned char a, unsigned char b) { return a < b ? a : b; }
 	
-	const unsigned char *input = pInputImage->pixels;
-	unsigned char *output = pOutputImage->pixels;
-
-	int min_u, max_u, min_v, max_v;
+	static inline void ApplyRow(const unsigned char *pInput1, const unsigned char *pInput2, unsigned char *pOutput, int nPixels, bool bBinarize)
+	{
+		OPTIMIZED_FUNCTION_HEADER_5(MorphologyRowMin, pInput1, pInput2, pOutput, nPixels, bBinarize)
+		
+		for (int i = 0; i < nPixels; i++)
+		{
+			const unsigned char v = Apply(pInput1[i], pInput2[i]);
+			pOutput[i] = bBinarize ? (v ? 255 : 0) : v;
+		}
+		
+		OPTIMIZED_FUNCTION_FOOTER
+	}
+};
+
+struct MorphologyParameters
+{
+	const unsigned char *input;
+	int input_stride;
+	unsigned char *output;
+	int output_stride;
+	int width, height;
+	int min_x, max_x, min_y, max_y; // output region
+	int kx, ky; // half width and half height of the structuring element
+	bool bCross;
+	bool bDilate;
+};
+
+static inline int RoundUpToMultiple(int n, int m)
+{
+	return ((n + m - 1) / m) * m;
+}
+
+// pOutput[x] = op(g[x], ..., g[x + 2k]) for 0 <= x < nOutput, g must hold RoundUpToMultiple(nOutput + 2k, 2k + 1) values
+template <class Op>
+static void FilterRowVHGW(const unsigned char *g, int nOutput, int k, unsigned char *pPrefix, unsigned char *pSuffix, unsigned char *pOutput)
+{
+	const int m = 2 * k + 1;
+	const int n = RoundUpToMultiple(nOutput + 2 * k, m);
+	int i, j;
+	
+	for (i = 0; i < n; i += m)
+	{
+		pPrefix[i] = g[i];
+		for (j = i + 1; j < i + m; j++)
+			pPrefix[j] = Op::Apply(pPrefix[j - 1], g[j]);
+		
+		pSuffix[i + m - 1] = g[i + m - 1];
+		for (j = i + m - 2; j >= i; j--)
+			pSuffix[j] = Op::Apply(pSuffix[j + 1], g[j]);
+	}
+	
+	for (i = 0; i < nOutput; i++)
+		pOutput[i] = Op::Apply(pSuffix[i], pPrefix[i + 2 * k]);
+}
+
+// filters the region [min_x, max_x] x [min_y, max_y] with a (2kx + 1) x (2ky + 1) rectangle and writes the binarized result to output
+template <class Op>
+static void FilterRectangleVHGW(const MorphologyParameters &parameters, int min_x, int max_x, int min_y, int max_y, int kx, int ky, unsigned char *output, int output_stride)
+{
+	const int width = parameters.width;
+	const int height = parameters.height;
+	const unsigned char identity = Op::Identity();
+	
+	// valid input pixels
+	const int min_input_x = parameters.bDilate ? parameters.kx : 0;
+	const int max_input_x = parameters.bDilate ? width - 1 - parameters.kx : width - 1;
+	const int min_input_y = parameters.bDilate ? parameters.ky : 0;
+	const int max_input_y = parameters.bDilate ? height - 1 - parameters.ky : height - 1;
+	
+	const int nColumns = max_x - min_x + 1;
+	const int nRows = max_y - min_y + 1;
+	
+	// horizontal pass
+	const int nPaddedColumns = RoundUpToMultiple(nColumns + 2 * kx, 2 * kx + 1);
+	const int nPaddedRows = RoundUpToMultiple(nRows + 2 * ky, 2 * ky + 1);
+	
+	unsigned char *pRowBuffer = new unsigned char[3 * nPaddedColumns];
+	unsigned char *pHorizontal = new unsigned char[2 * nPaddedRows * nColumns + nColumns];
+	unsigned char *pSuffix = pHorizontal + nPaddedRows * nColumns;
+	unsigned char *pPrefix = pSuffix + nPaddedRows * nColumns;
+	
+	const int first_x = MY_MAX(min_x - kx, min_input_x);
+	const int last_x = MY_MIN(max_x + kx, max_input_x);
+	
+	int i, j;
+	
+	for (i = 0; i < nPaddedRows; i++)
+	{
+		const int y = min_y - ky + i;
+		unsigned char *h = pHorizontal + i * nColumns;
+		
+		if (i >= nRows + 2 * ky || y < min_input_y || y > max_input_y || first_x > last_x)
+		{
+			memset(h, identity, nColumns);
+			continue;
+		}
+		
+		const unsigned char *input = parameters.input + y * parameters.input_stride;
+		
+		if (kx == 0)
+		{
+			// first_x = min_x and last_x = max_x unless the region exceeds the valid input pixels
+			memset(h, identity, nColumns);
+			memcpy(h + first_x - min_x, input + first_x, last_x - first_x + 1);
+			continue;
+		}
+		
+		unsigned char *g = pRowBuffer;
+		memset(g, identity, nPaddedColumns);
+		memcpy(g + first_x - (min_x - kx), input + first_x, last_x - first_x + 1);
+		
+		FilterRowVHGW<Op>(g, nColumns, kx, pRowBuffer + nPaddedColumns, pRowBuffer + 2 * nPaddedColumns, h);
+	}
+	
+	// vertical pass: suffixes of the blocks, then prefixes along with the output
+	const int m = 2 * ky + 1;
+	
+	for (i = 0; i < nPaddedRows; i += m)
+	{
+		memcpy(pSuffix + (i + m - 1) * nColumns, pHorizontal + (i + m - 1) * nColumns, nColumns);
+		
+		for (j = i + m - 2; j >= i; j--)
+			Op::ApplyRow(pSuffix + (j + 1) * nColumns, pHorizontal + j * nColumns, pSuffix + j * nColumns, nColumns, false);
+	}
+	
+	const unsigned char *pCurrentPrefix = 0;
+	
+	for (i = 0; i < nRows + 2 * ky; i++)
+	{
+		if (i % m == 0)
+		{
+			pCurrentPrefix = pHorizontal + i * nColumns;
+		}
+		else
+		{
+			Op::ApplyRow(pCurrentPrefix, pHorizontal + i * nColumns, pPrefix, nColumns, false);
+			pCurrentPrefix = pPrefix;
+		}
+		
+		if (i >= 2 * ky)
+			Op::ApplyRow(pSuffix + (i - 2 * ky) * nColumns, pCurrentPrefix, output + (i - 2 * ky) * output_stride, nColumns, true);
+	}
+	
+	delete [] pRowBuffer;
+	delete [] pHorizontal;
+}
+
+template <class Op>
+static void FilterBandVHGW(const MorphologyParameters &parameters, int min_y, int max_y)
+{
+	const int width = parameters.width;
+	const int height = parameters.height;
+	const int kx = parameters.kx;
+	const int ky = parameters.ky;
+	
+	int min_x = parameters.min_x;
+	int max_x = parameters.max_x;
+	int y;
+	
+	if (!parameters.bDilate)
+	{
+		// only pixels for which the element fits into the image can be set by Erode
+		for (y = min_y; y <= max_y; y++)
+			memset(parameters.output + y * parameters.output_stride + min_x, 0, max_x - min_x + 1);
+		
+		min_x = MY_MAX(min_x, kx);
+		max_x = MY_MIN(max_x, width - 1 - kx);
+		min_y = MY_MAX(min_y, ky);
+		max_y = MY_MIN(max_y, height - 1 - ky);
+	}
+	
+	if (min_x > max_x || min_y > max_y)
+		return;
+	
+	unsigned char *output = parameters.output + min_y * parameters.output_stride + min_x;
+	
+	if (parameters.bCross)
+	{
+		// union (dilation) or intersection (erosion) of a horizontal and a vertical line
+		const int nColumns = max_x - min_x + 1;
+		unsigned char *pVertical = new unsigned char[(max_y - min_y + 1) * nColumns];
+		
+		FilterRectangleVHGW<Op>(parameters, min_x, max_x, min_y, max_y, kx, 0, output, parameters.output_stride);
+		FilterRectangleVHGW<Op>(parameters, min_x, max_x, min_y, max_y, 0, ky, pVertical, nColumns);
+		
+		for (y = min_y; y <= max_y; y++, output += parameters.output_stride)
+			Op::ApplyRow(output, pVertical + (y - min_y) * nColumns, output, nColumns, false);
+		
+		delete [] pVertical;
+	}
+	else
+	{
+		FilterRectangleVHGW<Op>(parameters, min_x, max_x, min_y, max_y, kx, ky, output, parameters.output_stride);
+	}
+}
+
+static void FilterRowsVHGW(void *pParameter, int nBegin, int nEnd)
+{
+	const MorphologyParameters &parameters = *(const MorphologyParameters *) pParameter;
+	
+	const int min_y = parameters.min_y + nBegin;
+	const int max_y = parameters.min_y + nEnd - 1;
+	
+	if (parameters.bDilate)
+		FilterBandVHGW<MorphologyMax>(parameters, min_y, max_y);
+	else
+		FilterBandVHGW<MorphologyMin>(parameters, min_y, max_y);
+}
+
+static bool ApplyMorphologyFilter(const CByteImage *pInputImage, CByteImage *pOutputImage, int nMaskWidth, int nMaskHeight,
+	bool bCross, bool bDilate, const MyRegion *pROI, const char *pFunctionName)
+{
+	if (pInputImage->width != pOutputImage->width || pInputImage->height != pOutputImage->height ||
+		pInputImage->type != pOutputImage->type || pInputImage->type != CByteImage::eGrayScale)
+	{
+		printf("error: input and output image do not match for %s\n", pFunctionName);
+		return false;
+	}
+	
+	if (nMaskWidth < 1 || nMaskHeight < 1 || nMaskWidth % 2 == 0 || nMaskHeight % 2 == 0)
+	{
+		printf("error: mask width and height must be uneven numbers greater or equal 1 for %s\n", pFunctionName);
+		return false;
+	}
+	
+	const int width = pInputImage->width;
+	const int height = pInputImage->height;
+	
+	MorphologyParameters parameters;
+	parameters.width = width;
+	parameters.height = height;
+	parameters.kx = nMaskWidth / 2;
+	parameters.ky = nMaskHeight / 2;
+	parameters.bCross = bCross;
+	parameters.bDilate = bDilate;
+	
+	if (pROI)
+	{
+		parameters.min_x = MY_MAX(pROI->min_x, 0);
+		parameters.max_x = MY_MIN(pROI->max_x, width - 1);
+		parameters.min_y = MY_MAX(pROI->min_y, 0);
+		parameters.max_y = MY_MIN(pROI->max_y, height - 1);
+	}
+	else
+	{
+		parameters.min_x = 0;
+		parameters.max_x = width - 1;
+		parameters.min_y = 0;
+		parameters.max_y = height - 1;
+	}
+	
+	if (parameters.min_x > parameters.max_x || parameters.min_y > parameters.max_y)
+		return true;
+	
+	// the bands are processed in parallel, an in-place operation needs a copy of the input
+	CByteImage *pInputCopy = 0;
+	if (pInputImage->pixels == pOutputImage->pixels)
+	{
+		pInputCopy = new CByteImage(pInputImage);
+		ImageProcessor::CopyImage(pInputImage, pInputCopy);
+		pInputImage = pInputCopy;
+	}
+	
+	parameters.input = pInputImage->pixels;
+	parameters.input_stride = pInputImage->GetStride();
+	parameters.output = pOutputImage->pixels;
+	parameters.output_stride = pOutputImage->GetStride();
+	
+	// each band computes its rows from the whole image, so that the result does not depend on the number of threads
+	Threading::ParallelFor(FilterRowsVHGW, &parameters, parameters.max_y - parameters.min_y + 1, MY_MAX(16, 4 * parameters.ky));
+	
+	delete pInputCopy;
+	
+	return true;
+}
+
+
+static bool Dilate3x3(const CByteImage *pInputImage, CByteImage *pOutputImage, const MyRegion *pROI)
+{
+	OPTIMIZED_FUNCTION_HEADER_2_ROI(Dilate3x3, pInputImage, pOutputImage, pROI)
+	
+	if (pInputImage->width != pOutputImage->width || pInputImage->height != pOutputImage->height ||
+		pInputImage->type != pOutputImage->type || pInputImage->type != CByteImage::eGrayScale)
+	{
+		printf("error: input and output image do not match for Dilate3x3\n");
+		return false;
+	}
+		
+	CByteImage *pSaveOutputImage = 0;
+	if (pInputImage->pixels == pOutputImage->pixels)
+	{
+		pSaveOutputImage = pOutputImage;
+		pOutputImage = new CByteImage(pInputImage);
+	}
+
+	ImageProcessor::Zero(pOutputImage, pROI);
+
+	const int width = pInputImage->width;
+	const int height = pInputImage->height;
+	
+	const unsigned char *input = pInputImage->pixels;
+	unsigned char *output = pOutputImage->pixels;
+
+	int min_u, max_u, min_v, max_v;
 
 	if (pROI)
 	{
@@ -1684,274 +2407,131 @@ static bool Erode3x3(const CByteImage *pInputImage, CByteImage *pOutputImage, co
 	return true;
 }
 
-bool ImageProcessor::Dilate(const CByteImage *pInputImage, CByteImage *pOutputImage, int nMaskSize, const MyRegion *pROI)
+struct DilateOperation
 {
-	if (nMaskSize == 3)
-	{
-		Dilate3x3(pInputImage, pOutputImage, pROI);
-		return false;
-	}
+	DilateOperation(int nMaskSize) : nMaskSize(nMaskSize) { }
+	
+	bool operator()(const CByteImage *pInputImage, CByteImage *pOutputImage) const { return ImageProcessor::Dilate(pInputImage, pOutputImage, nMaskSize); }
+	
+	int nMaskSize;
+};
 
+bool ImageProcessor::Dilate(const CByteImage *pInputImage, CByteImage *pOutputImage, int nMaskSize, const MyRegion *pROI)
+{
 	if (nMaskSize < 2)
 	{
 		printf("error: mask size is too small for ImageProcessor::Dilate\n");
 		return false;
 	}
 	
-	if (pInputImage->width != pOutputImage->width || pInputImage->height != pOutputImage->height ||
-		pInputImage->type != pOutputImage->type || pInputImage->type != CByteImage::eGrayScale)
+	if (nMaskSize != 3)
 	{
-		printf("error: input and output image do not match for ImageProcessor::Dilate\n");
-		return false;
+		const int nSize = 2 * ((nMaskSize - 1) / 2) + 1;
+		return ApplyMorphologyFilter(pInputImage, pOutputImage, nSize, nSize, false, true, pROI, "ImageProcessor::Dilate");
 	}
-
-	const int k = (nMaskSize - 1) / 2;
-		
-	CByteImage *pSaveOutputImage = 0;
-	if (pInputImage->pixels == pOutputImage->pixels)
+	
+	bool bResult;
+	if (!pROI && ProcessInRowBands(DilateOperation(nMaskSize), pInputImage, pOutputImage, nMaskSize / 2 + 1, bResult))
+		return bResult;
+	
+	if (pInputImage->IsPadded() || pOutputImage->IsPadded())
 	{
-		pSaveOutputImage = pOutputImage;
-		pOutputImage = new CByteImage(pInputImage);
+		CUnpaddedImage<CByteImage> input(pInputImage), output(pOutputImage, true);
+		return Dilate(input, output, nMaskSize, pROI);
 	}
-
-	ImageProcessor::Zero(pOutputImage, pROI);
-
-	const int width = pInputImage->width;
-	const int height = pInputImage->height;
 	
-	const unsigned char *input = pInputImage->pixels;
-	unsigned char *output = pOutputImage->pixels;
+	return Dilate3x3(pInputImage, pOutputImage, pROI);
+}
 
-	int min_u, max_u, min_v, max_v;
+bool ImageProcessor::Dilate(const CByteImage *pInputImage, CByteImage *pOutputImage, int nMaskWidth, int nMaskHeight, StructuringElementType element, const MyRegion *pROI)
+{
+	return ApplyMorphologyFilter(pInputImage, pOutputImage, nMaskWidth, nMaskHeight, element == eCrossElement, true, pROI, "ImageProcessor::Dilate");
+}
 
-	if (pROI)
-	{
-		min_u = pROI->min_x + 1;
-		max_u = pROI->max_x - 1;
-		min_v = pROI->min_y + 1;
-		max_v = pROI->max_y - 1;
+struct ErodeOperation
+{
+	ErodeOperation(int nMaskSize) : nMaskSize(nMaskSize) { }
+	
+	bool operator()(const CByteImage *pInputImage, CByteImage *pOutputImage) const { return ImageProcessor::Erode(pInputImage, pOutputImage, nMaskSize); }
+	
+	int nMaskSize;
+};
 
-		if (min_u < k) min_u = k;
-		if (min_u > width - 1 - k) min_u = width - 1 - k;
-		if (max_u < k) max_u = k;
-		if (max_u > width - 1 - k) max_u = width - 1 - k;
-		if (min_v < k) min_v = k;
-		if (min_v > height - 1 - k) min_v = height - 1 - k;
-		if (max_v < k) max_v = k;
-		if (max_v > height - 1 - k) max_v = height - 1 - k;
-	}
-	else
+bool ImageProcessor::Erode(const CByteImage *pInputImage, CByteImage *pOutputImage, int nMaskSize, const MyRegion *pROI)
+{
+	if (nMaskSize < 2)
 	{
-		min_u = k;
-		max_u = width - 1 - k;
-		min_v = k;
-		max_v = height - 1 - k;
+		printf("error: mask size is too small for ImageProcessor::Erode\n");
+		return false;
 	}
-
-	const int diff = width - (max_u - min_u + 1);
 	
-	bool *bLastY = new bool[width];
-	memset(bLastY, false, width * sizeof(bool));
-
-	for (int v = min_v, offset = min_v * width + min_u; v <= max_v; v++, offset += diff)
+	if (nMaskSize != 3)
 	{
-		bool bLastX = false;
-
-		for (int u = min_u; u <= max_u; u++, offset++)
-		{
-			if (input[offset])
-			{
-				if (bLastX)
-				{
-					if (bLastY[u])
-					{
-						output[offset + k * width + k] = 255;
-					}
-					else
-					{
-						for (int i = -k; i <= k; i++)
-							output[offset + i * width + k] = 255;
-						
-						bLastY[u] = true;
-					}
-				}
-				else
-				{
-					if (bLastY[u])
-					{
-						for (int i = -k; i <= k; i++)
-							output[offset + k * width + i] = 255;
-					}
-					else
-					{
-						for (int i = -k; i <= k; i++)
-							for (int j = -k; j <= k; j++)
-								output[offset + i * width + j] = 255;
-						
-						bLastY[u] = true;
-					}
-					
-					bLastX = true;
-				}
-			}
-			else
-			{
-				bLastX = false;
-				bLastY[u] = false;
-			}
-		}
+		const int nSize = 2 * ((nMaskSize - 1) / 2) + 1;
+		return ApplyMorphologyFilter(pInputImage, pOutputImage, nSize, nSize, false, false, pROI, "ImageProcessor::Erode");
 	}
 	
-	delete [] bLastY;
+	bool bResult;
+	if (!pROI && ProcessInRowBands(ErodeOperation(nMaskSize), pInputImage, pOutputImage, nMaskSize / 2 + 1, bResult))
+		return bResult;
 	
-	if (pSaveOutputImage)
+	if (pInputImage->IsPadded() || pOutputImage->IsPadded())
 	{
-		CopyImage(pOutputImage, pSaveOutputImage, pROI, true);
-		delete pOutputImage;
+		CUnpaddedImage<CByteImage> input(pInputImage), output(pOutputImage, true);
+		return Erode(input, output, nMaskSize, pROI);
 	}
+	
+	return Erode3x3(pInputImage, pOutputImage, pROI);
+}
 
-	return true;
+bool ImageProcessor::Erode(const CByteImage *pInputImage, CByteImage *pOutputImage, int nMaskWidth, int nMaskHeight, StructuringElementType element, const MyRegion *pROI)
+{
+	return ApplyMorphologyFilter(pInputImage, pOutputImage, nMaskWidth, nMaskHeight, element == eCrossElement, false, pROI, "ImageProcessor::Erode");
 }
 
-bool ImageProcessor::Erode(const CByteImage *pInputImage, CByteImage *pOutputImage, int nMaskSize, const MyRegion *pROI)
+
+static bool OpenClose(const CByteImage *pInputImage, CByteImage *pOutputImage, int nMaskWidth, int nMaskHeight,
+	ImageProcessor::StructuringElementType element, const MyRegion *pROI, bool bOpen)
 {
-	if (nMaskSize == 3)
+	if (pInputImage->width != pOutputImage->width || pInputImage->height != pOutputImage->height)
 	{
-		Erode3x3(pInputImage, pOutputImage, pROI);
-		return false;
-	}
-
-	if (nMaskSize < 2)
-	{
-		printf("error: mask size is too small for ImageProcessor::Erode\n");
+		printf("error: input and output image do not match for ImageProcessor::%s\n", bOpen ? "Open" : "Close");
 		return false;
 	}
 	
-	if (pInputImage->width != pOutputImage->width || pInputImage->height != pOutputImage->height ||
-		pInputImage->type != pOutputImage->type || pInputImage->type != CByteImage::eGrayScale)
-	{
-		printf("error: input and output image do not match for ImageProcessor::Erode\n");
-		return false;
-	}
-
-	const int k = (nMaskSize - 1) / 2;
-		
-	CByteImage *pSaveOutputImage = 0;
-	if (pInputImage->pixels == pOutputImage->pixels)
-	{
-		pSaveOutputImage = pOutputImage;
-		pOutputImage = new CByteImage(pInputImage);
-	}
-
-	ImageProcessor::Zero(pOutputImage, pROI);
-
-	const int width = pInputImage->width;
-	const int height = pInputImage->height;
+	CByteImage temp(pInputImage->width, pInputImage->height, CByteImage::eGrayScale);
+	
+	// the second operation reads the intermediate result within the element around the region
+	MyRegion region;
+	const MyRegion *pIntermediateROI = 0;
 	
-	const unsigned char *input = pInputImage->pixels;
-	unsigned char *output = pOutputImage->pixels;
-
-	int min_u, max_u, min_v, max_v;
-
 	if (pROI)
 	{
-		min_u = pROI->min_x + 1;
-		max_u = pROI->max_x - 1;
-		min_v = pROI->min_y + 1;
-		max_v = pROI->max_y - 1;
-
-		if (min_u < k) min_u = k;
-		if (min_u > width - 1 - k) min_u = width - 1 - k;
-		if (max_u < k) max_u = k;
-		if (max_u > width - 1 - k) max_u = width - 1 - k;
-		if (min_v < k) min_v = k;
-		if (min_v > height - 1 - k) min_v = height - 1 - k;
-		if (max_v < k) max_v = k;
-		if (max_v > height - 1 - k) max_v = height - 1 - k;
-	}
-	else
-	{
-		min_u = k;
-		max_u = width - 1 - k;
-		min_v = k;
-		max_v = height - 1 - k;
+		region.min_x = pROI->min_x - nMaskWidth / 2;
+		region.max_x = pROI->max_x + nMaskWidth / 2;
+		region.min_y = pROI->min_y - nMaskHeight / 2;
+		region.max_y = pROI->max_y + nMaskHeight / 2;
+		pIntermediateROI = &region;
 	}
-
-	const int diff = width - (max_u - min_u + 1);
 	
-	bool *bLastY = new bool[width];
-	memset(bLastY, false, width * sizeof(bool));
-
-	for (int v = min_v, offset = min_v * width + min_u; v <= max_v; v++, offset += diff)
+	if (bOpen)
 	{
-		bool bLastX = false;
-
-		for (int u = min_u; u <= max_u; u++)
-		{
-			if (bLastX)
-			{
-				if (bLastY[u])
-				{
-					if (!input[offset + k * width + k])
-					{
-						bLastX = false;
-						bLastY[u] = false;
-						goto next;
-					}
-				}
-				else
-				{
-					for (int i = -k; i <= k; i++)
-						if (!input[offset + i * width + k])
-						{
-							bLastX = false;
-							goto next;
-						}
-
-					bLastY[u] = true;
-				}
-			}
-			else
-			{
-				if (bLastY[u])
-				{
-					for (int i = -k; i <= k; i++)
-						if (!input[offset + k * width + i])
-						{
-							bLastY[u] = false;
-							goto next;
-						}
-				}
-				else
-				{
-					for (int i = -k; i <= k; i++)
-						for (int j = -k; j <= k; j++)
-							if (!input[offset + i * width + j])
-								goto next;
-
-					bLastY[u] = true;
-				}
-				
-				bLastX = true;
-			}
-				
-			output[offset] = 255;
-			
-			next:
-			
-			offset++;
-		}
+		return ImageProcessor::Erode(pInputImage, &temp, nMaskWidth, nMaskHeight, element, pIntermediateROI) &&
+			ImageProcessor::Dilate(&temp, pOutputImage, nMaskWidth, nMaskHeight, element, pROI);
 	}
 	
-	delete [] bLastY;
-	
-	if (pSaveOutputImage)
-	{
-		CopyImage(pOutputImage, pSaveOutputImage, pROI, true);
-		delete pOutputImage;
-	}
+	return ImageProcessor::Dilate(pInputImage, &temp, nMaskWidth, nMaskHeight, element, pIntermediateROI) &&
+		ImageProcessor::Erode(&temp, pOutputImage, nMaskWidth, nMaskHeight, element, pROI);
+}
 
-	return true;
+bool ImageProcessor::Open(const CByteImage *pInputImage, CByteImage *pOutputImage, int nMaskWidth, int nMaskHeight, StructuringElementType element, const MyRegion *pROI)
+{
+	return OpenClose(pInputImage, pOutputImage, nMaskWidth, nMaskHeight, element, pROI, true);
+}
+
+bool ImageProcessor::Close(const CByteImage *pInputImage, CByteImage *pOutputImage, int nMaskWidth, int nMaskHeight, StructuringElementType element, const MyRegion *pROI)
+{
+	return OpenClose(pInputImage, pOutputImage, nMaskWidth, nMaskHeight, element, pROI, false);
 }
 
 
@@ -1964,16 +2544,20 @@ bool ImageProcessor::HistogramEqualization(const CByteImage *pInputImage, CByteI
 		return false;
 	}
 	
-	const int nPixels = pInputImage->width * pInputImage->height;
-	const unsigned char *input = pInputImage->pixels;
-	unsigned char *output = pOutputImage->pixels;
-	const float fNormalizeConstant = 255.0f / nPixels;
+	const int width = pInputImage->width;
+	const int height = pInputImage->height;
+	const float fNormalizeConstant = 255.0f / (width * height);
 	int histogram[256] = { 0 };
-	int i;
+	int i, y;
 
 	// calculate histogram
-	for (i = 0; i < nPixels; i++)
-		histogram[input[i]]++;
+	for (y = 0; y < height; y++)
+	{
+		const unsigned char *input = pInputImage->pixels + y * pInputImage->GetStride();
+		
+		for (i = 0; i < width; i++)
+			histogram[input[i]]++;
+	}
 
 	// calculate normalized accumulated histogram
 	for (i = 1; i < 256; i++)
@@ -1983,8 +2567,14 @@ bool ImageProcessor::HistogramEqualization(const CByteImage *pInputImage, CByteI
 		histogram[i] = int(histogram[i] * fNormalizeConstant + 0.5f);
 
 	// apply normalization
-	for (i = 0; i < nPixels; i++)
-		output[i] = histogram[input[i]];
+	for (y = 0; y < height; y++)
+	{
+		const unsigned char *input = pInputImage->pixels + y * pInputImage->GetStride();
+		unsigned char *output = pOutputImage->pixels + y * pOutputImage->GetStride();
+		
+		for (i = 0; i < width; i++)
+			output[i] = histogram[input[i]];
+	}
 
 	return true;
 }
@@ -2000,16 +2590,21 @@ bool ImageProcessor::ApplyAffinePointOperation(const CByteImage *pInputImage, CB
 		return false;
 	}
 	
-	const int nBytes = pInputImage->width * pInputImage->height * pInputImage->bytesPerPixel;
-	const unsigned char *input = pInputImage->pixels;
-	unsigned char *output = pOutputImage->pixels;
+	const int nRows = GetRows(pInputImage);
+	const int nRowBytes = GetRowBytes(pInputImage);
 	
 	b += 0.5f;
 	
-	for (int i = 0; i < nBytes; i++)
+	for (int y = 0; y < nRows; y++)
 	{
-		const int v = int(a * input[i] + b);
-		output[i] = v < 0 ? 0 : (v > 255 ? 255 : (unsigned char) v);
+		const unsigned char *input = pInputImage->pixels + y * pInputImage->GetStride();
+		unsigned char *output = pOutputImage->pixels + y * pOutputImage->GetStride();
+		
+		for (int i = 0; i < nRowBytes; i++)
+		{
+			const int v = int(a * input[i] + b);
+			output[i] = v < 0 ? 0 : (v > 255 ? 255 : (unsigned char) v);
+		}
 	}
 	
 	OPTIMIZED_FUNCTION_FOOTER
@@ -2027,19 +2622,10 @@ bool ImageProcessor::Spread(const CByteImage *pInputImage, CByteImage *pOutputIm
 		return false;
 	}
 	
-	const int nPixels = pInputImage->width * pInputImage->height;
-	const unsigned char *input = pInputImage->pixels;
 	unsigned char min = 255, max = 0;
 
-	// calculate histogram
-	for (int i = 0; i < nPixels; i++)
-	{
-		if (input[i] < min)
-			min = input[i];
-			
-		if (input[i] > max)
-			max = input[i];
-	}
+	// calculate minimum and maximum
+	MinMaxValue(pInputImage, min, max);
 	
 	if (min == max)
 	{
@@ -2064,14 +2650,19 @@ bool ImageProcessor::HistogramStretching(const CByteImage *pInputImage, CByteIma
 		return false;
 	}
 	
-	const int nPixels = pInputImage->width * pInputImage->height;
-	const unsigned char *input = pInputImage->pixels;
+	const int width = pInputImage->width;
+	const int height = pInputImage->height;
 	int histogram[256] = { 0 };
 	int i;
 
 	// calculate histogram
-	for (i = 0; i < nPixels; i++)
-		histogram[input[i]]++;
+	for (int y = 0; y < height; y++)
+	{
+		const unsigned char *input = pInputImage->pixels + y * pInputImage->GetStride();
+		
+		for (i = 0; i < width; i++)
+			histogram[input[i]]++;
+	}
 
 	// calculate accumulated histogram
 	for (i = 1; i < 256; i++)
@@ -2113,8 +2704,17 @@ bool ImageProcessor::HistogramStretching(const CByteImage *pInputImage, CByteIma
 	return true;
 }
 
+struct InvertOperation
+{
+	bool operator()(const CByteImage *pInputImage, CByteImage *pOutputImage) const { return ImageProcessor::Invert(pInputImage, pOutputImage); }
+};
+
 bool ImageProcessor::Invert(const CByteImage *pInputImage, CByteImage *pOutputImage)
 {
+	bool bResult;
+	if (ProcessInRowBands(InvertOperation(), pInputImage, pOutputImage, 0, bResult))
+		return bResult;
+	
 	OPTIMIZED_FUNCTION_HEADER_2(Invert, pInputImage, pOutputImage)
 	
 	if (!pInputImage->IsCompatible(pOutputImage))
@@ -2123,12 +2723,17 @@ bool ImageProcessor::Invert(const CByteImage *pInputImage, CByteImage *pOutputIm
 		return false;
 	}
 
-	const int nBytes = pInputImage->width * pInputImage->height * pInputImage->bytesPerPixel;
-	const unsigned char *input = pInputImage->pixels;
-	unsigned char *output = pOutputImage->pixels;
+	const int nRows = GetRows(pInputImage);
+	const int nRowBytes = GetRowBytes(pInputImage);
 	
-	for (int i = 0; i < nBytes; i++)
-		output[i] = 255 - input[i];
+	for (int y = 0; y < nRows; y++)
+	{
+		const unsigned char *input = pInputImage->pixels + y * pInputImage->GetStride();
+		unsigned char *output = pOutputImage->pixels + y * pOutputImage->GetStride();
+		
+		for (int i = 0; i < nRowBytes; i++)
+			output[i] = 255 - input[i];
+	}
 	
 	OPTIMIZED_FUNCTION_FOOTER
 
@@ -2152,20 +2757,17 @@ bool ImageProcessor::ConvertImage(const CByteImage *pInputImage, CByteImage *pOu
 		return true;
 	}
 	
-	const int nPixels = pInputImage->width * pInputImage->height;
-
-	const unsigned char *input = pInputImage->pixels;
-	unsigned char *output = pOutputImage->pixels;
+	const int width = pInputImage->width;
+	const int height = pInputImage->height;
+	
+	int min_x = 0, max_x = width - 1, min_y = 0, max_y = height - 1;
 	
 	if (pROI)
 	{
-		const int width = pInputImage->width;
-		const int height = pInputImage->height;
-
-		int min_x = pROI->min_x;
-		int max_x = pROI->max_x;
-		int min_y = pROI->min_y;
-		int max_y = pROI->max_y;
+		min_x = pROI->min_x;
+		max_x = pROI->max_x;
+		min_y = pROI->min_y;
+		max_y = pROI->max_y;
 
 		if (min_x < 0) min_x = 0;
 		if (min_x > width - 1) min_x = width - 1;
@@ -2175,155 +2777,72 @@ bool ImageProcessor::ConvertImage(const CByteImage *pInputImage, CByteImage *pOu
 		if (min_y > height - 1) min_y = height - 1;
 		if (max_y < 0) max_y = 0;
 		if (max_y > height - 1) max_y = height - 1;
-
-		const int diff = width - (max_x - min_x + 1);
-		const int diff_rgb = 3 * diff;
-
-		if (pInputImage->type == CByteImage::eRGB24)
-		{
-			if (pOutputImage->type == CByteImage::eGrayScale)
-			{
-				if (bFast)
-				{
-					for (int y = min_y, offset_output = width * min_y + min_x, offset_input = 3 * offset_output; y <= max_y; y++, offset_output += diff, offset_input += diff_rgb)
-						for (int x = min_x; x <= max_x; x++, offset_output++, offset_input += 3)
-							output[offset_output] = (input[offset_input] + (input[offset_input + 1] << 1) + input[offset_input + 2] + 2) >> 2;
-				}
-				else
-				{
-					for (int y = min_y, offset_output = width * min_y + min_x, offset_input = 3 * offset_output; y <= max_y; y++, offset_output += diff, offset_input += diff_rgb)
-						for (int x = min_x; x <= max_x; x++, offset_output++, offset_input += 3)
-							output[offset_output] = (9797 * input[offset_input] + 19235 * input[offset_input + 1] + 3736 * input[offset_input + 2] + 16384) >> 15;
-				}
-			}
-			else if (pOutputImage->type == CByteImage::eRGB24Split)
-			{
-				unsigned char *pHelperR = output;
-				unsigned char *pHelperG = pHelperR + nPixels;
-				unsigned char *pHelperB = pHelperG + nPixels;
-				
-				for (int y = min_y, offset_output = width * min_y + min_x, offset_input = 3 * offset_output; y <= max_y; y++, offset_output += diff, offset_input += diff_rgb)
-					for (int x = min_x; x <= max_x; x++, offset_output++, offset_input += 3)
-					{
-						pHelperR[offset_output] = input[offset_input];
-						pHelperG[offset_output] = input[offset_input + 1];
-						pHelperB[offset_output] = input[offset_input + 2];
-					}
-			}
-		}
-		if (pInputImage->type == CByteImage::eRGB24Split)
-		{
-			const unsigned char *pHelperR = input;
-			const unsigned char *pHelperG = pHelperR + nPixels;
-			const unsigned char *pHelperB = pHelperG + nPixels;
-			
-			if (pOutputImage->type == CByteImage::eGrayScale)
-			{
-				if (bFast)
-				{
-					for (int y = min_y, offset = width * min_y + min_x; y <= max_y; y++, offset += diff)
-						for (int x = min_x; x <= max_x; x++, offset++)
-							output[offset] = (pHelperR[offset] + (pHelperG[offset] << 1) + pHelperB[offset] + 2) >> 2;
-				}
-				else
-				{
-					for (int y = min_y, offset = width * min_y + min_x; y <= max_y; y++, offset += diff)
-						for (int x = min_x; x <= max_x; x++, offset++)
-							output[offset] = (9797 * pHelperR[offset] + 19235 * pHelperG[offset] + 3736 * pHelperB[offset] + 16384) >> 15;
-				}
-			}
-			else if (pOutputImage->type == CByteImage::eRGB24)
-			{
-				for (int y = min_y, input_offset = width * min_y + min_x, output_offset = 3 * input_offset; y <= max_y; y++, input_offset += diff, output_offset += diff_rgb)
-					for (int x = min_x; x <= max_x; x++, input_offset++, output_offset += 3)
-					{
-						output[output_offset] = pHelperR[input_offset];
-						output[output_offset + 1] = pHelperG[input_offset];
-						output[output_offset + 2] = pHelperB[input_offset];
-					}
-			}
-		}
-		else if (pInputImage->type == CByteImage::eGrayScale)
-		{
-			if (pOutputImage->type == CByteImage::eRGB24)
-			{
-				for (int y = min_y, offset_input = width * min_y + min_x, offset_output = 3 * offset_input; y <= max_y; y++, offset_output += diff_rgb, offset_input += diff)
-					for (int x = min_x; x <= max_x; x++, offset_output += 3, offset_input++)
-					{
-						output[offset_output + 2] = input[offset_input];
-						output[offset_output + 1] = input[offset_input];
-						output[offset_output] = input[offset_input];
-					}
-			}
-			else if (pOutputImage->type == CByteImage::eRGB24Split)
-			{
-				unsigned char *pHelperR = output;
-				unsigned char *pHelperG = pHelperR + nPixels;
-				unsigned char *pHelperB = pHelperG + nPixels;
-				
-				for (int y = min_y, offset = width * min_y + min_x; y <= max_y; y++, offset += diff)
-					for (int x = min_x; x <= max_x; x++, offset++)
-						pHelperR[offset] = pHelperG[offset] = pHelperB[offset] = input[offset];
-			}
-		}
 	}
-	else
+	
+	// offsets of the channels of eRGB24Split images
+	const int input_channel_offset = pInputImage->GetStride() * height;
+	const int output_channel_offset = pOutputImage->GetStride() * height;
+	
+	for (int y = min_y; y <= max_y; y++)
 	{
+		const unsigned char *input = pInputImage->pixels + y * pInputImage->GetStride();
+		unsigned char *output = pOutputImage->pixels + y * pOutputImage->GetStride();
+		
 		if (pInputImage->type == CByteImage::eRGB24)
 		{
 			if (pOutputImage->type == CByteImage::eGrayScale)
 			{
 				if (bFast)
 				{
-					for (int offset = 0, i = 0; i < nPixels; i++, offset += 3)
-						output[i] = (input[offset] + (input[offset + 1] << 1) + input[offset + 2] + 2) >> 2;
+					for (int x = min_x, offset = 3 * min_x; x <= max_x; x++, offset += 3)
+						output[x] = (input[offset] + (input[offset + 1] << 1) + input[offset + 2] + 2) >> 2;
 				}
 				else
 				{
-					for (int offset = 0, i = 0; i < nPixels; i++, offset += 3)
-						output[i] = (9797 * input[offset] + 19235 * input[offset + 1] + 3736 * input[offset + 2] + 16384) >> 15;
+					for (int x = min_x, offset = 3 * min_x; x <= max_x; x++, offset += 3)
+						output[x] = (9797 * input[offset] + 19235 * input[offset + 1] + 3736 * input[offset + 2] + 16384) >> 15;
 				}
 			}
 			else if (pOutputImage->type == CByteImage::eRGB24Split)
 			{
 				unsigned char *pHelperR = output;
-				unsigned char *pHelperG = pHelperR + nPixels;
-				unsigned char *pHelperB = pHelperG + nPixels;
+				unsigned char *pHelperG = pHelperR + output_channel_offset;
+				unsigned char *pHelperB = pHelperG + output_channel_offset;
 				
-				for (int offset = 0, i = 0; i < nPixels; i++, offset += 3)
+				for (int x = min_x, offset = 3 * min_x; x <= max_x; x++, offset += 3)
 				{
-					pHelperR[i] = input[offset];
-					pHelperG[i] = input[offset + 1];
-					pHelperB[i] = input[offset + 2];
+					pHelperR[x] = input[offset];
+					pHelperG[x] = input[offset + 1];
+					pHelperB[x] = input[offset + 2];
 				}
 			}
 		}
 		else if (pInputImage->type == CByteImage::eRGB24Split)
 		{
 			const unsigned char *pHelperR = input;
-			const unsigned char *pHelperG = pHelperR + nPixels;
-			const unsigned char *pHelperB = pHelperG + nPixels;
+			const unsigned char *pHelperG = pHelperR + input_channel_offset;
+			const unsigned char *pHelperB = pHelperG + input_channel_offset;
 			
 			if (pOutputImage->type == CByteImage::eGrayScale)
 			{
 				if (bFast)
 				{
-					for (int i = 0; i < nPixels; i++)
-						output[i] = (pHelperR[i] + (pHelperG[i] << 1) + pHelperB[i] + 2) >> 2;
+					for (int x = min_x; x <= max_x; x++)
+						output[x] = (pHelperR[x] + (pHelperG[x] << 1) + pHelperB[x] + 2) >> 2;
 				}
 				else
 				{
-					for (int i = 0; i < nPixels; i++)
-						output[i] = (9797 * pHelperR[i] + 19235 * pHelperG[i] + 3736 * pHelperB[i] + 16384) >> 15;
+					for (int x = min_x; x <= max_x; x++)
+						output[x] = (9797 * pHelperR[x] + 19235 * pHelperG[x] + 3736 * pHelperB[x] + 16384) >> 15;
 				}
 			}
 			else if (pOutputImage->type == CByteImage::eRGB24)
 			{
-				for (int offset = 0, i = 0; i < nPixels; i++, offset += 3)
+				for (int x = min_x, offset = 3 * min_x; x <= max_x; x++, offset += 3)
 				{
-					output[offset] = pHelperR[i];
-					output[offset + 1] = pHelperG[i];
-					output[offset + 2] = pHelperB[i];
+					output[offset] = pHelperR[x];
+					output[offset + 1] = pHelperG[x];
+					output[offset + 2] = pHelperB[x];
 				}
 			}
 		}
@@ -2331,21 +2850,21 @@ bool ImageProcessor::ConvertImage(const CByteImage *pInputImage, CByteImage *pOu
 		{
 			if (pOutputImage->type == CByteImage::eRGB24)
 			{
-				for (int offset = 0, i = 0; i < nPixels; i++, offset += 3)
+				for (int x = min_x, offset = 3 * min_x; x <= max_x; x++, offset += 3)
 				{
-					output[offset + 2] = input[i];
-					output[offset + 1] = input[i];
-					output[offset] = input[i];
+					output[offset + 2] = input[x];
+					output[offset + 1] = input[x];
+					output[offset] = input[x];
 				}
 			}
 			else if (pOutputImage->type == CByteImage::eRGB24Split)
 			{
 				unsigned char *pHelperR = output;
-				unsigned char *pHelperG = pHelperR + nPixels;
-				unsigned char *pHelperB = pHelperG + nPixels;
+				unsigned char *pHelperG = pHelperR + output_channel_offset;
+				unsigned char *pHelperB = pHelperG + output_channel_offset;
 				
-				for (int i = 0; i < nPixels; i++)
-					pHelperR[i] = pHelperG[i] = pHelperB[i] = input[i];
+				for (int x = min_x; x <= max_x; x++)
+					pHelperR[x] = pHelperG[x] = pHelperB[x] = input[x];
 			}
 		}
 	}
@@ -2358,6 +2877,12 @@ bool ImageProcessor::ConvertImage(const CByteImage *pInputImage, CByteImage *pOu
 
 bool ImageProcessor::ConvertImage(const CFloatImage *pInputImage, CByteImage *pOutputImage, bool equalize)
 {
+    if (pOutputImage->IsPadded())
+    {
+        CUnpaddedImage<CByteImage> output(pOutputImage, true);
+        return ConvertImage(pInputImage, output, equalize);
+    }
+	
     if(pInputImage->numberOfChannels == 1 && pOutputImage->type != CByteImage::eGrayScale)
     {
         printf("error: ImageProcessor::ConvertImage cannot convert a single channel float image into mulitple channel byte image\n");
@@ -2462,6 +2987,12 @@ bool ImageProcessor::ConvertImage(const CFloatImage *pInputImage, CByteImage *pO
 
 bool ImageProcessor::ConvertImage(const CByteImage *pInputImage, CFloatImage *pOutputImage)
 {
+    if (pInputImage->IsPadded())
+    {
+        CUnpaddedImage<CByteImage> input(pInputImage);
+        return ConvertImage(input, pOutputImage);
+    }
+	
     if(pOutputImage->numberOfChannels == 1 && pInputImage->type != CByteImage::eGrayScale)
     {
         printf("error: ImageProcessor::ConvertImage cannot convert a single channel byte image into single channel byte image\n");
@@ -2508,19 +3039,23 @@ bool ImageProcessor::ConvertImage(const CFloatMatrix *pInputMatrix, CByteImage *
 		return false;
 	}
 		
-	const int nPixels = pInputMatrix->columns * pInputMatrix->rows;
-	const float *input = pInputMatrix->data;
-	unsigned char *output = pOutputImage->pixels;
+	const int width = pInputMatrix->columns;
+	const int height = pInputMatrix->rows;
 	float min = FLT_MAX, max = -FLT_MAX;
-	int i;
+	int x, y;
 	
-	for (i = 0; i < nPixels; i++)
+	for (y = 0; y < height; y++)
 	{
-		if (input[i] > max)
-			max = input[i];
+		const float *input = pInputMatrix->data + y * pInputMatrix->GetStride();
+		
+		for (x = 0; x < width; x++)
+		{
+			if (input[x] > max)
+				max = input[x];
 			
-		if (input[i] < min)
-			min = input[i];
+			if (input[x] < min)
+				min = input[x];
+		}
 	}
 	
 	const float divider = max - min;
@@ -2533,8 +3068,14 @@ bool ImageProcessor::ConvertImage(const CFloatMatrix *pInputMatrix, CByteImage *
 	{
 		const float factor = 255.0f / divider;
 		
-		for (i = 0; i < nPixels; i++)
-			output[i] = (unsigned char) ((input[i] - min) * factor);
+		for (y = 0; y < height; y++)
+		{
+			const float *input = pInputMatrix->data + y * pInputMatrix->GetStride();
+			unsigned char *output = pOutputImage->pixels + y * pOutputImage->GetStride();
+			
+			for (x = 0; x < width; x++)
+				output[x] = (unsigned char) ((input[x] - min) * factor);
+		}
 	}
 
 	return true;
@@ -2548,12 +3089,17 @@ bool ImageProcessor::ConvertImage(const CByteImage *pInputImage, CFloatMatrix *p
 		return false;
 	}
 		
-	const int nPixels = pOutputMatrix->columns * pOutputMatrix->rows;
-	const unsigned char *input = pInputImage->pixels;
-	float *output = pOutputMatrix->data;
+	const int width = pOutputMatrix->columns;
+	const int height = pOutputMatrix->rows;
 	
-	for (int i = 0; i < nPixels; i++)
-		output[i] = input[i];
+	for (int y = 0; y < height; y++)
+	{
+		const unsigned char *input = pInputImage->pixels + y * pInputImage->GetStride();
+		float *output = pOutputMatrix->data + y * pOutputMatrix->GetStride();
+		
+		for (int x = 0; x < width; x++)
+			output[x] = input[x];
+	}
 
 	return true;
 }
@@ -2566,31 +3112,41 @@ bool ImageProcessor::ConvertImage(const CShortImage *pInputImage, CByteImage *pO
 		return false;
 	}
 		
-	const int nPixels = pInputImage->width * pInputImage->height;
-	const short *input = pInputImage->pixels;
-	unsigned char *output = pOutputImage->pixels;
+	const int width = pInputImage->width;
+	const int height = pInputImage->height;
 	short min = SHRT_MAX, max = SHRT_MIN;
-	int i;
+	int x, y;
 	
-	for (i = 0; i < nPixels; i++)
+	for (y = 0; y < height; y++)
 	{
-		if (input[i] > max)
-			max = input[i];
+		const short *input = pInputImage->pixels + y * pInputImage->GetStride();
 		
-		if (input[i] < min)
-			min = input[i];
+		for (x = 0; x < width; x++)
+		{
+			if (input[x] > max)
+				max = input[x];
+			
+			if (input[x] < min)
+				min = input[x];
+		}
 	}
-
+	
 	const short divider = max - min;
-
+	
 	if (divider == 0)
 	{
 		Zero(pOutputImage);
 	}
 	else
 	{
-		for (i = 0; i < nPixels; i++)
-			output[i] = (unsigned char) ((255 * (input[i] - min)) / divider);
+		for (y = 0; y < height; y++)
+		{
+			const short *input = pInputImage->pixels + y * pInputImage->GetStride();
+			unsigned char *output = pOutputImage->pixels + y * pOutputImage->GetStride();
+			
+			for (x = 0; x < width; x++)
+				output[x] = (unsigned char) ((255 * (input[x] - min)) / divider);
+		}
 	}
 
 	return true;
@@ -2604,12 +3160,17 @@ bool ImageProcessor::ConvertImage(const CByteImage *pInputImage, CShortImage *pO
 		return false;
 	}
 		
-	const int nPixels = pOutputImage->width * pOutputImage->height;
-	const unsigned char *input = pInputImage->pixels;
-	short *output = pOutputImage->pixels;
+	const int width = pOutputImage->width;
+	const int height = pOutputImage->height;
 	
-	for (int i = 0; i < nPixels; i++)
-		output[i] = (short) input[i];
+	for (int y = 0; y < height; y++)
+	{
+		const unsigned char *input = pInputImage->pixels + y * pInputImage->GetStride();
+		short *output = pOutputImage->pixels + y * pOutputImage->GetStride();
+		
+		for (int x = 0; x < width; x++)
+			output[x] = (short) input[x];
+	}
 
 	return true;
 }
@@ -2622,12 +3183,17 @@ bool ImageProcessor::ConvertImage(const CByteImage *pInputImage, CIntImage *pOut
 		return false;
 	}
 	
-	const int nPixels = pOutputImage->width * pOutputImage->height;
-	const unsigned char *input = pInputImage->pixels;
-	int *output = pOutputImage->pixels;
+	const int width = pOutputImage->width;
+	const int height = pOutputImage->height;
 	
-	for (int i = 0; i < nPixels; i++)
-		output[i] = (int) input[i];
+	for (int y = 0; y < height; y++)
+	{
+		const unsigned char *input = pInputImage->pixels + y * pInputImage->GetStride();
+		int *output = pOutputImage->pixels + y * pOutputImage->GetStride();
+		
+		for (int x = 0; x < width; x++)
+			output[x] = (int) input[x];
+	}
 
 	return true;
 }
@@ -2640,19 +3206,23 @@ bool ImageProcessor::ConvertImage(const CIntImage *pInputImage, CByteImage *pOut
 		return false;
 	}
 	
-	const int nPixels = pInputImage->width * pInputImage->height;
-	const int *input = pInputImage->pixels;
-	unsigned char *output = pOutputImage->pixels;
-	int min = INT_MAX, max = INT_MIN;
-	int i;
+	const int width = pInputImage->width;
+	const int height = pInputImage->height;
+	int min = INT_MAX, max = INT_MIN;
+	int x, y;
 	
-	for (i = 0; i < nPixels; i++)
+	for (y = 0; y < height; y++)
 	{
-		if (input[i] > max)
-			max = input[i];
+		const int *input = pInputImage->pixels + y * pInputImage->GetStride();
 		
-		if (input[i] < min)
-			min = input[i];
+		for (x = 0; x < width; x++)
+		{
+			if (input[x] > max)
+				max = input[x];
+			
+			if (input[x] < min)
+				min = input[x];
+		}
 	}
 	
 	const int divider = max - min;
@@ -2663,8 +3233,14 @@ bool ImageProcessor::ConvertImage(const CIntImage *pInputImage, CByteImage *pOut
 	}
 	else
 	{
-		for (i = 0; i < nPixels; i++)
-			output[i] = (unsigned char) ((255 * (input[i] - min)) / divider);
+		for (y = 0; y < height; y++)
+		{
+			const int *input = pInputImage->pixels + y * pInputImage->GetStride();
+			unsigned char *output = pOutputImage->pixels + y * pOutputImage->GetStride();
+			
+			for (x = 0; x < width; x++)
+				output[x] = (unsigned char) ((255 * (input[x] - min)) / divider);
+		}
 	}
 
 	return true;
@@ -2679,12 +3255,17 @@ bool ImageProcessor::ConvertMatrix(const CFloatMatrix *pInputMatrix, CDoubleMatr
 		return false;
 	}
 		
-	const int nElements = pOutputMatrix->rows * pOutputMatrix->columns;
-	const float *input = pInputMatrix->data;
-	double *output = pOutputMatrix->data;
+	const int width = pOutputMatrix->columns;
+	const int height = pOutputMatrix->rows;
 	
-	for (int i = 0; i < nElements; i++)
-		output[i] = (double) input[i];
+	for (int y = 0; y < height; y++)
+	{
+		const float *input = pInputMatrix->data + y * pInputMatrix->GetStride();
+		double *output = pOutputMatrix->data + y * pOutputMatrix->columns;
+		
+		for (int x = 0; x < width; x++)
+			output[x] = (double) input[x];
+	}
 
 	return true;
 }
@@ -2697,12 +3278,17 @@ bool ImageProcessor::ConvertMatrix(const CDoubleMatrix *pInputMatrix, CFloatMatr
 		return false;
 	}
 		
-	const int nElements = pOutputMatrix->rows * pOutputMatrix->columns;
-	const double *input = pInputMatrix->data;
-	float *output = pOutputMatrix->data;
+	const int width = pOutputMatrix->columns;
+	const int height = pOutputMatrix->rows;
 	
-	for (int i = 0; i < nElements; i++)
-		output[i] = (float) input[i];
+	for (int y = 0; y < height; y++)
+	{
+		const double *input = pInputMatrix->data + y * pInputMatrix->columns;
+		float *output = pOutputMatrix->data + y * pOutputMatrix->GetStride();
+		
+		for (int x = 0; x < width; x++)
+			output[x] = (float) input[x];
+	}
 
 	return true;
 }
@@ -2735,9 +3321,6 @@ bool ImageProcessor::CopyImage(const CByteImage *pInputImage, CByteImage *pOutpu
 		const int width = pInputImage->width;
 		const int height = pInputImage->height;
 
-		unsigned char *input = pInputImage->pixels;
-		unsigned char *output = pOutputImage->pixels;
-
 		int min_x = pROI->min_x;
 		int max_x = pROI->max_x;
 		int min_y = pROI->min_y;
@@ -2761,69 +3344,43 @@ bool ImageProcessor::CopyImage(const CByteImage *pInputImage, CByteImage *pOutpu
 		if (min_y > height - 1) min_y = height - 1;
 		if (max_y < 0) max_y = 0;
 		if (max_y > height - 1) max_y = height - 1;
-
-		if (pInputImage->type == CByteImage::eGrayScale)
-		{
-			const int size = max_x - min_x + 1;
-			
-			if (bUseSameSize)
-			{
-				for (int y = min_y, offset = width * min_y + min_x; y <= max_y; y++, offset += width)
-					memcpy(output + offset, input + offset, size);
-			}
-			else
-			{
-				for (int y = min_y, offset = width * min_y + min_x, output_offset = 0; y <= max_y; y++, offset += width, output_offset += size)
-					memcpy(output + output_offset, input + offset, size);
-			}
-		}
-		else if (pInputImage->type == CByteImage::eRGB24)
-		{
-			const int size = 3 * (max_x - min_x + 1);
-			const int width3 = 3 * width;
-
-			if (bUseSameSize)
-			{
-				for (int y = min_y, offset = 3 * (width * min_y + min_x); y <= max_y; y++, offset += width3)
-					memcpy(output + offset, input + offset, size);
-			}
-			else
-			{
-				for (int y = min_y, offset = 3 * (width * min_y + min_x), output_offset = 0; y <= max_y; y++, offset += width3, output_offset += size)
-					memcpy(output + output_offset, input + offset, size);
-			}
-		}
-		else if (pInputImage->type == CByteImage::eRGB24Split)
+		
+		const int nChannels = pInputImage->type == CByteImage::eRGB24Split ? 3 : 1;
+		const int nBytesPerPixel = pInputImage->type == CByteImage::eRGB24 ? 3 : 1;
+		const int size = nBytesPerPixel * (max_x - min_x + 1);
+		const int input_stride = pInputImage->GetStride();
+		const int output_stride = pOutputImage->GetStride();
+		
+		for (int c = 0; c < nChannels; c++)
 		{
-			const int size = max_x - min_x + 1;
-			
-			unsigned char *pHelperR = output;
-			unsigned char *pHelperG = pHelperR + width * height;
-			unsigned char *pHelperB = pHelperG + width * height;
+			const unsigned char *input = pInputImage->pixels + c * input_stride * pInputImage->height + nBytesPerPixel * min_x;
+			unsigned char *output = pOutputImage->pixels + c * output_stride * pOutputImage->height;
 			
 			if (bUseSameSize)
 			{
-				for (int y = min_y, offset = width * min_y + min_x; y <= max_y; y++, offset += width)
-				{
-					memcpy(pHelperR + offset, input + offset, size);
-					memcpy(pHelperG + offset, input + offset, size);
-					memcpy(pHelperB + offset, input + offset, size);
-				}
+				output += nBytesPerPixel * min_x;
+				
+				for (int y = min_y; y <= max_y; y++)
+					memcpy(output + y * output_stride, input + y * input_stride, size);
 			}
 			else
 			{
-				for (int y = min_y, offset = 3 * (width * min_y + min_x), output_offset = 0; y <= max_y; y++, offset += width, output_offset += size)
-				{
-					memcpy(pHelperR + output_offset, input + offset, size);
-					memcpy(pHelperG + output_offset, input + offset, size);
-					memcpy(pHelperB + output_offset, input + offset, size);
-				}
+				for (int y = min_y, output_offset = 0; y <= max_y; y++, output_offset += output_stride)
+					memcpy(output + output_offset, input + y * input_stride, size);
 			}
 		}
 	}
+	else if (pInputImage->GetStride() == pOutputImage->GetStride())
+	{
+		memcpy(pOutputImage->pixels, pInputImage->pixels, pInputImage->GetStride() * GetRows(pInputImage));
+	}
 	else
 	{
-		memcpy(pOutputImage->pixels, pInputImage->pixels, pInputImage->width * pInputImage->height * pInputImage->bytesPerPixel);
+		const int nRows = GetRows(pInputImage);
+		const int nRowBytes = GetRowBytes(pInputImage);
+		
+		for (int y = 0; y < nRows; y++)
+			memcpy(pOutputImage->pixels + y * pOutputImage->GetStride(), pInputImage->pixels + y * pInputImage->GetStride(), nRowBytes);
 	}
 
 	return true;
@@ -2856,8 +3413,8 @@ bool ImageProcessor::CopyImage(const CShortImage *pInputImage, CShortImage *pOut
 		const int width = pInputImage->width;
 		const int height = pInputImage->height;
 
-		short *input = pInputImage->pixels;
-		short *output = pOutputImage->pixels;
+		const int input_stride = pInputImage->GetStride();
+		const int output_stride = pOutputImage->GetStride();
 
 		int min_x = pROI->min_x;
 		int max_x = pROI->max_x;
@@ -2883,26 +3440,27 @@ bool ImageProcessor::CopyImage(const CShortImage *pInputImage, CShortImage *pOut
 		if (max_y < 0) max_y = 0;
 		if (max_y > height - 1) max_y = height - 1;
 
+		const int size = (max_x - min_x + 1) * sizeof(short);
+		
 		if (bUseSameSize)
 		{
-			const int diff = width - (max_x - min_x + 1);
-
-			for (int y = min_y, offset = width * min_y + min_x; y <= max_y; y++, offset += diff)
-				for (int x = min_x; x <= max_x; x++, offset++)
-					output[offset] = input[offset];
+			for (int y = min_y; y <= max_y; y++)
+				memcpy(pOutputImage->pixels + y * output_stride + min_x, pInputImage->pixels + y * input_stride + min_x, size);
 		}
 		else
 		{
-			const int diff = width - (max_x - min_x + 1);
-
-			for (int y = min_y, offset = width * min_y + min_x, output_offset = 0; y <= max_y; y++, offset += diff)
-				for (int x = min_x; x <= max_x; x++, offset++, output_offset++)
-					output[output_offset] = input[offset];
+			for (int y = min_y, output_offset = 0; y <= max_y; y++, output_offset += output_stride)
+				memcpy(pOutputImage->pixels + output_offset, pInputImage->pixels + y * input_stride + min_x, size);
 		}
 	}
+	else if (pInputImage->GetStride() == pOutputImage->GetStride())
+	{
+		memcpy(pOutputImage->pixels, pInputImage->pixels, pInputImage->GetStride() * pInputImage->height * sizeof(short));
+	}
 	else
 	{
-		memcpy(pOutputImage->pixels, pInputImage->pixels, pInputImage->width * pInputImage->height * sizeof(short));
+		for (int y = 0; y < pInputImage->height; y++)
+			memcpy(pOutputImage->pixels + y * pOutputImage->GetStride(), pInputImage->pixels + y * pInputImage->GetStride(), pInputImage->width * sizeof(short));
 	}
 
 	return true;
@@ -2917,7 +3475,15 @@ bool ImageProcessor::CopyMatrix(const CFloatMatrix *pInputMatrix, CFloatMatrix *
 		return false;
 	}
 
-	memcpy(pOutputMatrix->data, pInputMatrix->data, pInputMatrix->rows * pInputMatrix->columns * sizeof(float));
+	if (pInputMatrix->GetStride() == pOutputMatrix->GetStride())
+	{
+		memcpy(pOutputMatrix->data, pInputMatrix->data, pInputMatrix->rows * pInputMatrix->GetStride() * sizeof(float));
+	}
+	else
+	{
+		for (int i = 0; i < pInputMatrix->rows; i++)
+			memcpy(pOutputMatrix->data + i * pOutputMatrix->GetStride(), pInputMatrix->data + i * pInputMatrix->GetStride(), pInputMatrix->columns * sizeof(float));
+	}
 
 	return true;
 }
@@ -2943,8 +3509,6 @@ void ImageProcessor::Zero(CByteImage *pImage, const MyRegion *pROI)
 		const int width = pImage->width;
 		const int height = pImage->height;
 
-		unsigned char *pixels = pImage->pixels;
-
 		int min_x = pROI->min_x;
 		int max_x = pROI->max_x;
 		int min_y = pROI->min_y;
@@ -2958,57 +3522,39 @@ void ImageProcessor::Zero(CByteImage *pImage, const MyRegion *pROI)
 		if (min_y > height - 1) min_y = height - 1;
 		if (max_y < 0) max_y = 0;
 		if (max_y > height - 1) max_y = height - 1;
-
-		if (pImage->type == CByteImage::eGrayScale)
-		{
-			const int size = max_x - min_x + 1;
-
-			for (int y = min_y, offset = width * min_y + min_x; y <= max_y; y++, offset += width)
-				memset(pixels + offset, 0, size);
-		}
-		else if (pImage->type == CByteImage::eRGB24)
-		{
-			const int size = 3 * (max_x - min_x + 1);
-			const int width3 = 3 * width;
-
-			for (int y = min_y, offset = 3 * (width * min_y + min_x); y <= max_y; y++, offset += width3)
-				memset(pixels, 0, size);
-		}
-		else if (pImage->type == CByteImage::eRGB24Split)
+		
+		const int nChannels = pImage->type == CByteImage::eRGB24Split ? 3 : 1;
+		const int nBytesPerPixel = pImage->type == CByteImage::eRGB24 ? 3 : 1;
+		const int size = nBytesPerPixel * (max_x - min_x + 1);
+		const int stride = pImage->GetStride();
+		
+		for (int c = 0; c < nChannels; c++)
 		{
-			const int size = max_x - min_x + 1;
+			unsigned char *pixels = pImage->pixels + c * stride * height + nBytesPerPixel * min_x;
 			
-			unsigned char *pHelperR = pixels;
-			unsigned char *pHelperG = pHelperR + width * height;
-			unsigned char *pHelperB = pHelperG + width * height;
-
-			for (int y = min_y, offset = width * min_y + min_x; y <= max_y; y++, offset += width)
-			{
-				memset(pHelperR + offset, 0, size);
-				memset(pHelperG + offset, 0, size);
-				memset(pHelperB + offset, 0, size);
-			}
+			for (int y = min_y; y <= max_y; y++)
+				memset(pixels + y * stride, 0, size);
 		}
 	}
 	else
 	{
-		memset(pImage->pixels, 0, pImage->width * pImage->height * pImage->bytesPerPixel);
+		memset(pImage->pixels, 0, pImage->GetStride() * GetRows(pImage));
 	}
 }
 
 void ImageProcessor::Zero(CShortImage *pImage)
 {
-	memset(pImage->pixels, 0, pImage->width * pImage->height * sizeof(*pImage->pixels));
+	memset(pImage->pixels, 0, pImage->GetStride() * pImage->height * sizeof(*pImage->pixels));
 }
 
 void ImageProcessor::Zero(CIntImage *pImage)
 {
-	memset(pImage->pixels, 0, pImage->width * pImage->height * sizeof(*pImage->pixels));
+	memset(pImage->pixels, 0, pImage->GetStride() * pImage->height * sizeof(*pImage->pixels));
 }
 
 void ImageProcessor::Zero(CFloatMatrix *pMatrix)
 {
-	memset(pMatrix->data, 0, pMatrix->columns * pMatrix->rows * sizeof(*pMatrix->data));
+	memset(pMatrix->data, 0, pMatrix->GetStride() * pMatrix->rows * sizeof(*pMatrix->data));
 }
 
 void ImageProcessor::Zero(CDoubleMatrix *pMatrix)
@@ -3021,16 +3567,17 @@ void ImageProcessor::ZeroFrame(CByteImage *pImage)
 {
 	const int width = pImage->width;
 	const int height = pImage->height;
+	const int stride = pImage->GetStride();
 	unsigned char *pixels = pImage->pixels;
 	
 	if (pImage->type == CByteImage::eGrayScale)
 	{
 		// zero top and bottom row
 		memset(pixels, 0, width);
-		memset(pixels + width * (height - 1), 0, width);
+		memset(pixels + stride * (height - 1), 0, width);
 		
 		// zero left and right column
-		for (int i = 0, offset = 0; i < height; i++, offset += width)
+		for (int i = 0, offset = 0; i < height; i++, offset += stride)
 		{
 			pixels[offset] = 0;
 			pixels[offset + width - 1] = 0;
@@ -3042,10 +3589,10 @@ void ImageProcessor::ZeroFrame(CByteImage *pImage)
 		
 		// zero top and bottom row
 		memset(pixels, 0, width3);
-		memset(pixels + width3 * (height - 1), 0, width3);
+		memset(pixels + stride * (height - 1), 0, width3);
 		
 		// zero left and right column
-		for (int i = 0, offset = 0; i < height; i++, offset += width3)
+		for (int i = 0, offset = 0; i < height; i++, offset += stride)
 		{
 			pixels[offset] = pixels[offset + 1] = pixels[offset + 2] = 0;
 			pixels[offset + width3 - 3] = pixels[offset + width3 - 2] = pixels[offset + width3 - 1] = 0;
@@ -3057,14 +3604,15 @@ void ImageProcessor::ZeroFrame(CShortImage *pImage)
 {
 	const int width = pImage->width;
 	const int height = pImage->height;
+	const int stride = pImage->GetStride();
 	short *pixels = pImage->pixels;
 	
 	// zero top and bottom row
 	memset(pixels, 0, width * sizeof(short));
-	memset(pixels + width * (height - 1), 0, width * sizeof(short));
+	memset(pixels + stride * (height - 1), 0, width * sizeof(short));
 	
 	// zero left and right column
-	for (int i = 0, offset = 0; i < height; i++, offset += width)
+	for (int i = 0, offset = 0; i < height; i++, offset += stride)
 	{
 		pixels[offset] = 0;
 		pixels[offset + width - 1] = 0;
@@ -3075,14 +3623,15 @@ void ImageProcessor::ZeroFrame(CIntImage *pImage)
 {
 	const int width = pImage->width;
 	const int height = pImage->height;
+	const int stride = pImage->GetStride();
 	int *pixels = pImage->pixels;
 	
 	// zero top and bottom row
 	memset(pixels, 0, width * sizeof(int));
-	memset(pixels + width * (height - 1), 0, width * sizeof(int));
+	memset(pixels + stride * (height - 1), 0, width * sizeof(int));
 	
 	// zero left and right column
-	for (int i = 0, offset = 0; i < height; i++, offset += width)
+	for (int i = 0, offset = 0; i < height; i++, offset += stride)
 	{
 		pixels[offset] = 0;
 		pixels[offset + width - 1] = 0;
@@ -3106,35 +3655,26 @@ bool ImageProcessor::CopyFrame(const CByteImage *pInputImage, CByteImage *pOutpu
 	
 	const int width = pInputImage->width;
 	const int height = pInputImage->height;
-		
-	if (pInputImage->type == CByteImage::eGrayScale)
-	{
-		memcpy(output, input, width);
-		memcpy(output + width * (height - 1), input + width * (height - 1), width);
-		
-		unsigned int offset = width;
-		const unsigned int offset2 = width - 1;
-		for (int y = 1; y < height-1; y++, offset += width)
-		{
-			output[offset] = input[offset];
-			output[offset + offset2] = input[offset + offset2];
-		}
-	}
-	else if (pInputImage->type == CByteImage::eRGB24)
+	const int input_stride = pInputImage->GetStride();
+	const int output_stride = pOutputImage->GetStride();
+	const int nBytesPerPixel = pInputImage->type == CByteImage::eRGB24 ? 3 : 1;
+	const int nRowBytes = nBytesPerPixel * width;
+	
+	// copy top and bottom row
+	memcpy(output, input, nRowBytes);
+	memcpy(output + output_stride * (height - 1), input + input_stride * (height - 1), nRowBytes);
+	
+	// copy left and right column
+	const int offset2 = nRowBytes - nBytesPerPixel;
+	for (int y = 1; y < height - 1; y++)
 	{
-		memcpy(output, input, 3*width);
-		memcpy(output + 3 * width * (height - 1), input + 3 * width * (height - 1), 3 * width);
+		const unsigned char *input_row = input + y * input_stride;
+		unsigned char *output_row = output + y * output_stride;
 		
-		unsigned int offset = 3 * width;
-		const unsigned int offset2 = 3 * (width - 1);
-		for (int y = 1; y < height - 1; y++, offset += 3 * width)
+		for (int i = 0; i < nBytesPerPixel; i++)
 		{
-			output[offset]   = input[offset];
-			output[offset + 1] = input[offset + 1];
-			output[offset + 2] = input[offset + 2];
-			output[offset + offset2] = input[offset + offset2];
-			output[offset + offset2 + 1] = input[offset + offset2 + 1];
-			output[offset + offset2 + 2] = input[offset + offset2 + 2];
+			output_row[i] = input_row[i];
+			output_row[offset2 + i] = input_row[offset2 + i];
 		}
 	}
 
@@ -3143,6 +3683,12 @@ bool ImageProcessor::CopyFrame(const CByteImage *pInputImage, CByteImage *pOutpu
 
 bool ImageProcessor::AdaptFrame(const CByteImage *pInputImage, CByteImage *pOutputImage)
 {
+	if (pInputImage->IsPadded() || pOutputImage->IsPadded())
+	{
+		CUnpaddedImage<CByteImage> input(pInputImage), output(pOutputImage, true);
+		return AdaptFrame(input, output);
+	}
+	
 	if (pInputImage->width != pOutputImage->width || pInputImage->height != pOutputImage->height || pInputImage->type != pOutputImage->type || pInputImage->type == CByteImage::eRGB24Split)
 	{
 		printf("error: input and output images do not match for ImageProcessor::CopyFrame\n");
@@ -3220,13 +3766,21 @@ bool ImageProcessor::ApplyHomography(const CByteImage *pInputImage, CByteImage *
 	return ApplyHomography(pInputImage, pOutputImage, A, bInterpolation);
 }
 
-bool ImageProcessor::ApplyHomography(const CByteImage *pInputImage, CByteImage *pOutputImage, const Mat3d &A, bool bInterpolation)
+struct ApplyHomographyParameters
 {
-	if (pInputImage->type != pOutputImage->type)
-	{
-		printf("error: input and output image do not match in ImageProcessor::ApplyHomography\n");
-		return false;
-	}
+	const CByteImage *pInputImage;
+	CByteImage *pOutputImage;
+	Mat3d A;
+	bool bInterpolation;
+};
+
+static void ApplyHomographyRows(void *pParameter, int nBegin, int nEnd)
+{
+	const ApplyHomographyParameters *pParameters = (const ApplyHomographyParameters *) pParameter;
+	const CByteImage *pInputImage = pParameters->pInputImage;
+	CByteImage *pOutputImage = pParameters->pOutputImage;
+	const Mat3d &A = pParameters->A;
+	const bool bInterpolation = pParameters->bInterpolation;
 
 	const float a1 = A.r1;
 	const float a2 = A.r2;
@@ -3238,17 +3792,9 @@ bool ImageProcessor::ApplyHomography(const CByteImage *pInputImage, CByteImage *
 	const float a8 = A.r8;
 	const float a9 = A.r9;
 
-	CByteImage *pSaveOutputImage = 0;
-	if (pInputImage->pixels == pOutputImage->pixels)
-	{
-		pSaveOutputImage = pOutputImage;
-		pOutputImage = new CByteImage(pInputImage);
-	}
-	
 	const int width = pInputImage->width;
 	const int height = pInputImage->height;
 	const int output_width = pOutputImage->width;
-	const int output_height = pOutputImage->height;
 	const unsigned char *input = pInputImage->pixels;
 	unsigned char *output = pOutputImage->pixels;
 	const CByteImage::ImageType type = pInputImage->type;
@@ -3257,7 +3803,7 @@ bool ImageProcessor::ApplyHomography(const CByteImage *pInputImage, CByteImage *
 	{
 		if (type == CByteImage::eGrayScale)
 		{
-			for (int v = 0, offset = 0; v < output_height; v++)
+			for (int v = nBegin, offset = nBegin * output_width; v < nEnd; v++)
 			{
 				for (int u = 0; u < output_width; u++, offset++)
 				{
@@ -3301,9 +3847,9 @@ bool ImageProcessor::ApplyHomography(const CByteImage *pInputImage, CByteImage *
 		}
 		else if (type == CByteImage::eRGB24)
 		{
-			for (int v = 0, offset = 0; v < height; v++)
+			for (int v = nBegin, offset = 3 * nBegin * output_width; v < nEnd; v++)
 			{
-				for (int u = 0; u < width; u++, offset += 3)
+				for (int u = 0; u < output_width; u++, offset += 3)
 				{
 					const float u_ = (a1 * u + a2 * v + a3) / (a7 * u + a8 * v + a9);
 					const float v_ = (a4 * u + a5 * v + a6) / (a7 * u + a8 * v + a9);
@@ -3373,7 +3919,7 @@ bool ImageProcessor::ApplyHomography(const CByteImage *pInputImage, CByteImage *
 	{
 		if (type == CByteImage::eGrayScale)
 		{
-			for (int v = 0, offset = 0; v < output_height; v++)
+			for (int v = nBegin, offset = nBegin * output_width; v < nEnd; v++)
 			{
 				for (int u = 0; u < output_width; u++, offset++)
 				{
@@ -3389,7 +3935,7 @@ bool ImageProcessor::ApplyHomography(const CByteImage *pInputImage, CByteImage *
 		}
 		else if (type == CByteImage::eRGB24)
 		{
-			for (int v = 0, offset = 0; v < output_height; v++)
+			for (int v = nBegin, offset = 3 * nBegin * output_width; v < nEnd; v++)
 			{
 				for (int u = 0; u < output_width; u++, offset += 3)
 				{
@@ -3409,204 +3955,66 @@ bool ImageProcessor::ApplyHomography(const CByteImage *pInputImage, CByteImage *
 			}
 		}
 	}
-
-	if (pSaveOutputImage)
-	{
-		CopyImage(pOutputImage, pSaveOutputImage);
-		delete pOutputImage;
-	}
-
-	return true;
 }
 
-bool ImageProcessor::Resize(const CByteImage *pInputImage, CByteImage *pOutputImage, const MyRegion *pROI, bool bInterpolation)
+bool ImageProcessor::ApplyHomography(const CByteImage *pInputImage, CByteImage *pOutputImage, const Mat3d &A, bool bInterpolation)
 {
-	if (pInputImage->type != pOutputImage->type || pInputImage->type == CByteImage::eRGB24Split)
+	if (pInputImage->IsPadded() || pOutputImage->IsPadded())
 	{
-		printf("error: input and output image do not match in ImageProcessor::Resize\n");
-		return false;
+		CUnpaddedImage<CByteImage> input(pInputImage), output(pOutputImage, true);
+		return ApplyHomography(input, output, A, bInterpolation);
 	}
-
-	if (pInputImage->width == pOutputImage->width && pInputImage->height == pOutputImage->height)
+	
+	if (pInputImage->type != pOutputImage->type)
 	{
-		CopyImage(pInputImage, pOutputImage);
+		printf("error: input and output image do not match in ImageProcessor::ApplyHomography\n");
 		return false;
 	}
 
-	const CByteImage::ImageType type = pInputImage->type;
-
-	const int output_width = pOutputImage->width;
-	const int output_height = pOutputImage->height;
-	unsigned char *output = pOutputImage->pixels;
-
-	const int input_width = pInputImage->width;
-	const int input_height = pInputImage->height;
-	const unsigned char *input = pInputImage->pixels;
-
-	const int start_x = pROI ? pROI->min_x : 0;
-	const int start_y = pROI ? pROI->min_y : 0;
-
-	const int width = pROI ? pROI->max_x - pROI->min_x + 1 : input_width;
-	const int height = pROI ? pROI->max_y - pROI->min_y + 1 : input_height;
-
-	if (pROI)
-	{
-		if (pROI->min_x < 0 || pROI->min_y < 0 || pROI->max_x >= input_width || pROI->max_y >= input_height)
-		{
-			printf("error: provided ROI in ImageProcessor::Resize exceeds input image boundaries\n");
-			return false;
-		}
-	}
-
-	if (width > output_width && width % output_width == 0 &&
-		height > output_height && height % output_height == 0)
+	CByteImage *pSaveOutputImage = 0;
+	if (pInputImage->pixels == pOutputImage->pixels)
 	{
-		if (type == CByteImage::eGrayScale)
-		{
-			const int a1 = width / output_width;
-			const int a4 = height / output_height;
-			const int delta = a4 * input_width - width;
-			
-			for (int v = 0, offset = 0, offset_ = start_y * input_width + start_x; v < output_height; v++, offset_ += delta)
-			{
-				for (int u = 0; u < output_width; u++, offset++, offset_ += a1)
-					output[offset] = input[offset_];
-			}
-		}
-		else if (type == CByteImage::eRGB24)
-		{
-			const int a1 = 3 * (width / output_width);
-			const int a4 = height / output_height;
-			const int delta = 3 * (a4 * input_width - width);
-			
-			for (int v = 0, offset = 0, offset_ = 3 * (start_y * input_width + start_x); v < output_height; v++, offset_ += delta)
-			{
-				for (int u = 0; u < output_width; u++, offset += 3, offset_ += a1)
-				{
-					output[offset] = input[offset_];
-					output[offset + 1] = input[offset_ + 1];
-					output[offset + 2] = input[offset_ + 2];
-				}
-			}
-		}
-		
-		return true;
+		pSaveOutputImage = pOutputImage;
+		pOutputImage = new CByteImage(pInputImage);
 	}
+	
+	// output rows are independent and are processed in row bands if the worker pool is enabled
+	ApplyHomographyParameters parameters = { pInputImage, pOutputImage, A, bInterpolation };
+	Threading::ParallelFor(ApplyHomographyRows, &parameters, pOutputImage->height, 16);
 
-	const float a1 = float(width) / output_width;
-	const float a4 = float(height) / output_height;
-
-	int *pXOffsets = 0, *pYOffsets = 0;
-	int *pXCoordinates = 0, *pYCoordinates = 0;
-
-	const int min_width = MY_MIN(width, output_width);
-	const int min_height = MY_MIN(height, output_height);
-	int i;
-
-	if (type == CByteImage::eGrayScale)
+	if (pSaveOutputImage)
 	{
-		pXOffsets = new int[output_width];
-		pYOffsets = new int[output_height];
-		
-		if (bInterpolation)
-		{
-			pXCoordinates = new int[output_width];
-			pYCoordinates = new int[output_height];
-
-			for (i = 0; i < output_width; i++)
-			{
-				register int x = (i * width) / output_width;
-
-				if (start_x + x < input_width - 1)
-				{
-					pXOffsets[i] = start_x + x;
-					pXCoordinates[i] = int((i * a1 - x) * 1024);
-				}
-				else
-				{
-					pXOffsets[i] = input_width - 2;
-					pXCoordinates[i] = 1024;
-				}
-			}
-
-			for (i = 0; i < output_height; i++)
-			{
-				register int y = (i * height) / output_height;
-
-				if (start_y + y < input_height - 1)
-				{
-					pYOffsets[i] = input_width * (start_y + y);
-					pYCoordinates[i] = int((i * a4 - y) * 1024);
-				}
-				else
-				{
-					pYOffsets[i] = input_width * (input_height - 2);
-					pYCoordinates[i] = 1024;
-				}
-			}
-		}
-		else
-		{
-			for (i = 0; i < output_width; i++)
-				pXOffsets[i] = start_x + (((i * width) << 1) + min_width - 1) / (output_width << 1);
-
-			for (i = 0; i < output_height; i++)
-				pYOffsets[i] = input_width * (start_y + (((i * height) << 1) + min_height - 1) / (output_height << 1));
-		}
+		CopyImage(pOutputImage, pSaveOutputImage);
+		delete pOutputImage;
 	}
-	else
-	{
-		pXOffsets = new int[3 * output_width];
-		pYOffsets = new int[output_height];
-		
-		int offset = 0;
-
-		if (bInterpolation)
-		{
-			pXCoordinates = new int[3 * output_width];
-			pYCoordinates = new int[output_height];
-
-			for (i = 0; i < output_width; i++, offset += 3)
-			{
-				register int x = (i * width) / output_width;
 
-				if (start_x + x < input_width - 1)
-				{
-					pXOffsets[offset] = 3 * (start_x + x);
-					pXCoordinates[offset] = int((i * a1 - x) * 1024);
-				}
-				else
-				{
-					pXOffsets[offset] = 3 * (input_width - 2);
-					pXCoordinates[offset] = 1024;
-				}
-			}
-
-			for (i = 0; i < output_height; i++)
-			{
-				register int y = (i * height) / output_height;
+	return true;
+}
 
-				if (start_y + y < input_height - 1)
-				{
-					pYOffsets[i] = 3 * input_width * (start_y + y);
-					pYCoordinates[i] = int((i * a4 - y) * 1024);
-				}
-				else
-				{
-					pYOffsets[i] = 3 * input_width * (input_height - 2);
-					pYCoordinates[i] = 1024;
-				}
-			}
-		}
-		else
-		{
-			for (i = 0; i < output_width; i++, offset += 3)
-				pXOffsets[offset] = 3 * (start_x + (((i * width) << 1) + min_width - 1) / (output_width << 1));
+struct ResizeParameters
+{
+	const CByteImage *pInputImage;
+	CByteImage *pOutputImage;
+	const int *pXOffsets;
+	const int *pYOffsets;
+	const int *pXCoordinates;
+	const int *pYCoordinates;
+	bool bInterpolation;
+};
 
-			for (i = 0; i < output_height; i++)
-				pYOffsets[i] = 3 * input_width * (start_y + (((i * height) << 1) + min_height - 1) / (output_height << 1));
-		}
-	}
+static void ResizeRows(void *pParameter, int nBegin, int nEnd)
+{
+	const ResizeParameters *pParameters = (const ResizeParameters *) pParameter;
+	const CByteImage::ImageType type = pParameters->pInputImage->type;
+	const int input_width = pParameters->pInputImage->width;
+	const unsigned char *input = pParameters->pInputImage->pixels;
+	const int output_width = pParameters->pOutputImage->width;
+	unsigned char *output = pParameters->pOutputImage->pixels + nBegin * pParameters->pOutputImage->GetStride();
+	const int *pXOffsets = pParameters->pXOffsets;
+	const int *pYOffsets = pParameters->pYOffsets;
+	const int *pXCoordinates = pParameters->pXCoordinates;
+	const int *pYCoordinates = pParameters->pYCoordinates;
+	const bool bInterpolation = pParameters->bInterpolation;
 
 	if (bInterpolation)
 	{
@@ -3614,7 +4022,7 @@ bool ImageProcessor::Resize(const CByteImage *pInputImage, CByteImage *pOutputIm
 		{
 			const int last_u = MY_MAX(0, output_width - output_width % 4);
 
-			for (int v = 0; v < output_height; v++)
+			for (int v = nBegin; v < nEnd; v++)
 			{
 				const unsigned char *input_helper = input + pYOffsets[v];
 				const int y = pYCoordinates[v];
@@ -3682,7 +4090,7 @@ bool ImageProcessor::Resize(const CByteImage *pInputImage, CByteImage *pOutputIm
 			const int output_width3 = 3 * output_width;
 			const int input_width3 = 3 * input_width;
 
-			for (int v = 0; v < output_height; v++)
+			for (int v = nBegin; v < nEnd; v++)
 			{
 				const unsigned char *input_helper = input + pYOffsets[v];
 				const int y = pYCoordinates[v];
@@ -3732,7 +4140,7 @@ bool ImageProcessor::Resize(const CByteImage *pInputImage, CByteImage *pOutputIm
 		{
 			const int last_u = MY_MAX(0, output_width - output_width % 4);
 
-			for (int v = 0; v < output_height; v++)
+			for (int v = nBegin; v < nEnd; v++)
 			{
 				const unsigned char *input_helper = input + pYOffsets[v];
 				int u;
@@ -3756,7 +4164,7 @@ bool ImageProcessor::Resize(const CByteImage *pInputImage, CByteImage *pOutputIm
 			const int output_width3 = 3 * output_width;
 			const int last_u = 3 * MY_MAX(0, output_width - output_width % 4);
 			
-			for (int v = 0; v < output_height; v++)
+			for (int v = nBegin; v < nEnd; v++)
 			{
 				const unsigned char *input_helper = input + pYOffsets[v];
 				int u;
@@ -3793,12 +4201,212 @@ bool ImageProcessor::Resize(const CByteImage *pInputImage, CByteImage *pOutputIm
 					output[u + 1] = input_helper[input_offset + 1];
 					output[u + 2] = input_helper[input_offset + 2];
 				}
-
-				output += output_width3;
+
+				output += output_width3;
+			}
+		}
+	}
+}
+
+bool ImageProcessor::Resize(const CByteImage *pInputImage, CByteImage *pOutputImage, const MyRegion *pROI, bool bInterpolation)
+{
+	if (pInputImage->IsPadded() || pOutputImage->IsPadded())
+	{
+		CUnpaddedImage<CByteImage> input(pInputImage), output(pOutputImage, true);
+		return Resize(input, output, pROI, bInterpolation);
+	}
+	
+	if (pInputImage->type != pOutputImage->type || pInputImage->type == CByteImage::eRGB24Split)
+	{
+		printf("error: input and output image do not match in ImageProcessor::Resize\n");
+		return false;
+	}
+
+	if (pInputImage->width == pOutputImage->width && pInputImage->height == pOutputImage->height)
+	{
+		CopyImage(pInputImage, pOutputImage);
+		return false;
+	}
+
+	const CByteImage::ImageType type = pInputImage->type;
+
+	const int output_width = pOutputImage->width;
+	const int output_height = pOutputImage->height;
+	unsigned char *output = pOutputImage->pixels;
+
+	const int input_width = pInputImage->width;
+	const int input_height = pInputImage->height;
+	const unsigned char *input = pInputImage->pixels;
+
+	const int start_x = pROI ? pROI->min_x : 0;
+	const int start_y = pROI ? pROI->min_y : 0;
+
+	const int width = pROI ? pROI->max_x - pROI->min_x + 1 : input_width;
+	const int height = pROI ? pROI->max_y - pROI->min_y + 1 : input_height;
+
+	if (pROI)
+	{
+		if (pROI->min_x < 0 || pROI->min_y < 0 || pROI->max_x >= input_width || pROI->max_y >= input_height)
+		{
+			printf("error: provided ROI in ImageProcessor::Resize exceeds input image boundaries\n");
+			return false;
+		}
+	}
+
+	if (width > output_width && width % output_width == 0 &&
+		height > output_height && height % output_height == 0)
+	{
+		if (type == CByteImage::eGrayScale)
+		{
+			const int a1 = width / output_width;
+			const int a4 = height / output_height;
+			const int delta = a4 * input_width - width;
+			
+			for (int v = 0, offset = 0, offset_ = start_y * input_width + start_x; v < output_height; v++, offset_ += delta)
+			{
+				for (int u = 0; u < output_width; u++, offset++, offset_ += a1)
+					output[offset] = input[offset_];
+			}
+		}
+		else if (type == CByteImage::eRGB24)
+		{
+			const int a1 = 3 * (width / output_width);
+			const int a4 = height / output_height;
+			const int delta = 3 * (a4 * input_width - width);
+			
+			for (int v = 0, offset = 0, offset_ = 3 * (start_y * input_width + start_x); v < output_height; v++, offset_ += delta)
+			{
+				for (int u = 0; u < output_width; u++, offset += 3, offset_ += a1)
+				{
+					output[offset] = input[offset_];
+					output[offset + 1] = input[offset_ + 1];
+					output[offset + 2] = input[offset_ + 2];
+				}
+			}
+		}
+		
+		return true;
+	}
+
+	const float a1 = float(width) / output_width;
+	const float a4 = float(height) / output_height;
+
+	int *pXOffsets = 0, *pYOffsets = 0;
+	int *pXCoordinates = 0, *pYCoordinates = 0;
+
+	const int min_width = MY_MIN(width, output_width);
+	const int min_height = MY_MIN(height, output_height);
+	int i;
+
+	if (type == CByteImage::eGrayScale)
+	{
+		pXOffsets = new int[output_width];
+		pYOffsets = new int[output_height];
+		
+		if (bInterpolation)
+		{
+			pXCoordinates = new int[output_width];
+			pYCoordinates = new int[output_height];
+
+			for (i = 0; i < output_width; i++)
+			{
+				register int x = (i * width) / output_width;
+
+				if (start_x + x < input_width - 1)
+				{
+					pXOffsets[i] = start_x + x;
+					pXCoordinates[i] = int((i * a1 - x) * 1024);
+				}
+				else
+				{
+					pXOffsets[i] = input_width - 2;
+					pXCoordinates[i] = 1024;
+				}
+			}
+
+			for (i = 0; i < output_height; i++)
+			{
+				register int y = (i * height) / output_height;
+
+				if (start_y + y < input_height - 1)
+				{
+					pYOffsets[i] = input_width * (start_y + y);
+					pYCoordinates[i] = int((i * a4 - y) * 1024);
+				}
+				else
+				{
+					pYOffsets[i] = input_width * (input_height - 2);
+					pYCoordinates[i] = 1024;
+				}
+			}
+		}
+		else
+		{
+			for (i = 0; i < output_width; i++)
+				pXOffsets[i] = start_x + (((i * width) << 1) + min_width - 1) / (output_width << 1);
+
+			for (i = 0; i < output_height; i++)
+				pYOffsets[i] = input_width * (start_y + (((i * height) << 1) + min_height - 1) / (output_height << 1));
+		}
+	}
+	else
+	{
+		pXOffsets = new int[3 * output_width];
+		pYOffsets = new int[output_height];
+		
+		int offset = 0;
+
+		if (bInterpolation)
+		{
+			pXCoordinates = new int[3 * output_width];
+			pYCoordinates = new int[output_height];
+
+			for (i = 0; i < output_width; i++, offset += 3)
+			{
+				register int x = (i * width) / output_width;
+
+				if (start_x + x < input_width - 1)
+				{
+					pXOffsets[offset] = 3 * (start_x + x);
+					pXCoordinates[offset] = int((i * a1 - x) * 1024);
+				}
+				else
+				{
+					pXOffsets[offset] = 3 * (input_width - 2);
+					pXCoordinates[offset] = 1024;
+				}
+			}
+
+			for (i = 0; i < output_height; i++)
+			{
+				register int y = (i * height) / output_height;
+
+				if (start_y + y < input_height - 1)
+				{
+					pYOffsets[i] = 3 * input_width * (start_y + y);
+					pYCoordinates[i] = int((i * a4 - y) * 1024);
+				}
+				else
+				{
+					pYOffsets[i] = 3 * input_width * (input_height - 2);
+					pYCoordinates[i] = 1024;
+				}
 			}
 		}
+		else
+		{
+			for (i = 0; i < output_width; i++, offset += 3)
+				pXOffsets[offset] = 3 * (start_x + (((i * width) << 1) + min_width - 1) / (output_width << 1));
+
+			for (i = 0; i < output_height; i++)
+				pYOffsets[i] = 3 * input_width * (start_y + (((i * height) << 1) + min_height - 1) / (output_height << 1));
+		}
 	}
 
+	// output rows are independent and are processed in row bands if the worker pool is enabled
+	ResizeParameters parameters = { pInputImage, pOutputImage, pXOffsets, pYOffsets, pXCoordinates, pYCoordinates, bInterpolation };
+	Threading::ParallelFor(ResizeRows, &parameters, output_height, 16);
+
 	delete [] pXOffsets;
 	delete [] pYOffsets;
 
@@ -3824,8 +4432,21 @@ bool ImageProcessor::Rotate(const CByteImage *pInputImage, CByteImage *pOutputIm
 		bInterpolation);
 }
 
+struct AmplifyOperation
+{
+	AmplifyOperation(float fFactor) : fFactor(fFactor) { }
+	
+	bool operator()(const CByteImage *pInputImage, CByteImage *pOutputImage) const { return ImageProcessor::Amplify(pInputImage, pOutputImage, fFactor); }
+	
+	float fFactor;
+};
+
 bool ImageProcessor::Amplify(const CByteImage *pInputImage, CByteImage *pOutputImage, float fFactor)
 {
+	bool bResult;
+	if (ProcessInRowBands(AmplifyOperation(fFactor), pInputImage, pOutputImage, 0, bResult))
+		return bResult;
+	
 	OPTIMIZED_FUNCTION_HEADER_3(Amplify, pInputImage, pOutputImage, fFactor)
 	
 	if (!pInputImage->IsCompatible(pOutputImage))
@@ -3834,14 +4455,19 @@ bool ImageProcessor::Amplify(const CByteImage *pInputImage, CByteImage *pOutputI
 		return false;
 	}
 		
-	const int nBytes = pInputImage->width * pInputImage->height * pInputImage->bytesPerPixel;
-	const unsigned char *input = pInputImage->pixels;
-	unsigned char *output = pOutputImage->pixels;
+	const int nRows = GetRows(pInputImage);
+	const int nRowBytes = GetRowBytes(pInputImage);
 	
-	for (int i = 0; i < nBytes; i++)
+	for (int y = 0; y < nRows; y++)
 	{
-		const int v = int(fFactor * input[i] + 0.5f);
-		output[i] = v < 0 ? 0 : (v > 255 ? 255 : (unsigned char) v);
+		const unsigned char *input = pInputImage->pixels + y * pInputImage->GetStride();
+		unsigned char *output = pOutputImage->pixels + y * pOutputImage->GetStride();
+		
+		for (int i = 0; i < nRowBytes; i++)
+		{
+			const int v = int(fFactor * input[i] + 0.5f);
+			output[i] = v < 0 ? 0 : (v > 255 ? 255 : (unsigned char) v);
+		}
 	}
 
 	OPTIMIZED_FUNCTION_FOOTER
@@ -3852,6 +4478,12 @@ bool ImageProcessor::Amplify(const CByteImage *pInputImage, CByteImage *pOutputI
 
 bool ImageProcessor::CalculateSaturationImage(const CByteImage *pInputImage, CByteImage *pOutputImage)
 {
+	if (pInputImage->IsPadded() || pOutputImage->IsPadded())
+	{
+		CUnpaddedImage<CByteImage> input(pInputImage), output(pOutputImage, true);
+		return CalculateSaturationImage(input, output);
+	}
+	
 	if (pInputImage->width != pOutputImage->width || pInputImage->height != pOutputImage->height ||
 		(pInputImage->type != CByteImage::eRGB24 && pInputImage->type != CByteImage::eRGB24Split) || pOutputImage->type != CByteImage::eGrayScale)
 	{
@@ -3898,8 +4530,21 @@ bool ImageProcessor::CalculateSaturationImage(const CByteImage *pInputImage, CBy
 }
 
 
+struct ThresholdBinarizeOperation
+{
+	ThresholdBinarizeOperation(unsigned char nThreshold) : nThreshold(nThreshold) { }
+	
+	bool operator()(const CByteImage *pInputImage, CByteImage *pOutputImage) const { return ImageProcessor::ThresholdBinarize(pInputImage, pOutputImage, nThreshold); }
+	
+	unsigned char nThreshold;
+};
+
 bool ImageProcessor::ThresholdBinarize(const CByteImage *pInputImage, CByteImage *pOutputImage, unsigned char nThreshold)
 {
+	bool bResult;
+	if (ProcessInRowBands(ThresholdBinarizeOperation(nThreshold), pInputImage, pOutputImage, 0, bResult))
+		return bResult;
+	
 	OPTIMIZED_FUNCTION_HEADER_3(ThresholdBinarize, pInputImage, pOutputImage, nThreshold)
 	
 	if (pInputImage->width != pOutputImage->width || pInputImage->height != pOutputImage->height ||
@@ -3909,20 +4554,39 @@ bool ImageProcessor::ThresholdBinarize(const CByteImage *pInputImage, CByteImage
 		return false;
 	}
 		
-	const int nPixels = pInputImage->width * pInputImage->height;
-	const unsigned char *input = pInputImage->pixels;
-	unsigned char *output = pOutputImage->pixels;
+	const int width = pInputImage->width;
+	const int height = pInputImage->height;
 
-	for (int i = 0; i < nPixels; i++)
-		output[i] = input[i] >= nThreshold ? 255 : 0;
+	for (int y = 0; y < height; y++)
+	{
+		const unsigned char *input = pInputImage->pixels + y * pInputImage->GetStride();
+		unsigned char *output = pOutputImage->pixels + y * pOutputImage->GetStride();
+		
+		for (int i = 0; i < width; i++)
+			output[i] = input[i] >= nThreshold ? 255 : 0;
+	}
 		
 	OPTIMIZED_FUNCTION_FOOTER
 
 	return true;
 }
 
+struct ThresholdBinarizeRangeOperation
+{
+	ThresholdBinarizeRangeOperation(unsigned char nMinThreshold, unsigned char nMaxThreshold) : nMinThreshold(nMinThreshold), nMaxThreshold(nMaxThreshold) { }
+	
+	bool operator()(const CByteImage *pInputImage, CByteImage *pOutputImage) const { return ImageProcessor::ThresholdBinarize(pInputImage, pOutputImage, nMinThreshold, nMaxThreshold); }
+	
+	unsigned char nMinThreshold;
+	unsigned char nMaxThreshold;
+};
+
 bool ImageProcessor::ThresholdBinarize(const CByteImage *pInputImage, CByteImage *pOutputImage, unsigned char nMinThreshold, unsigned char nMaxThreshold)
 {
+	bool bResult;
+	if (ProcessInRowBands(ThresholdBinarizeRangeOperation(nMinThreshold, nMaxThreshold), pInputImage, pOutputImage, 0, bResult))
+		return bResult;
+	
 	//OPTIMIZED_FUNCTION_HEADER_4(ThresholdBinarize, pInputImage, pOutputImage, nMinThreshold, nMaxThreshold)
 	
 	if (pInputImage->width != pOutputImage->width || pInputImage->height != pOutputImage->height ||
@@ -3932,20 +4596,44 @@ bool ImageProcessor::ThresholdBinarize(const CByteImage *pInputImage, CByteImage
 		return false;
 	}
 		
-	const int nPixels = pInputImage->width * pInputImage->height;
-	const unsigned char *input = pInputImage->pixels;
-	unsigned char *output = pOutputImage->pixels;
+	const int width = pInputImage->width;
+	const int height = pInputImage->height;
 
-	for (int i = 0; i < nPixels; i++)
-		output[i] = input[i] >= nMinThreshold && input[i] <= nMaxThreshold ? 255 : 0;
+	for (int y = 0; y < height; y++)
+	{
+		const unsigned char *input = pInputImage->pixels + y * pInputImage->GetStride();
+		unsigned char *output = pOutputImage->pixels + y * pOutputImage->GetStride();
+		
+		for (int i = 0; i < width; i++)
+			output[i] = input[i] >= nMinThreshold && input[i] <= nMaxThreshold ? 255 : 0;
+	}
 		
 	//OPTIMIZED_FUNCTION_FOOTER
 
 	return true;
 }
 
+struct ThresholdBinarizeMatrixOperation
+{
+	ThresholdBinarizeMatrixOperation(float fThreshold) : fThreshold(fThreshold) { }
+	
+	bool operator()(const CFloatMatrix *pInputMatrix, CFloatMatrix *pOutputMatrix) const { return ImageProcessor::ThresholdBinarize(pInputMatrix, pOutputMatrix, fThreshold); }
+	
+	float fThreshold;
+};
+
 bool ImageProcessor::ThresholdBinarize(const CFloatMatrix *pInputMatrix, CFloatMatrix *pOutputMatrix, float fThreshold)
 {
+	bool bResult;
+	if (ProcessInRowBands(ThresholdBinarizeMatrixOperation(fThreshold), pInputMatrix, pOutputMatrix, 0, bResult))
+		return bResult;
+	
+	if (pInputMatrix->IsPadded() || pOutputMatrix->IsPadded())
+	{
+		CUnpaddedImage<CFloatMatrix> input(pInputMatrix), output(pOutputMatrix, true);
+		return ThresholdBinarize(input, output, fThreshold);
+	}
+	
 	if (pInputMatrix->columns != pOutputMatrix->columns || pInputMatrix->rows != pOutputMatrix->rows)
 	{
 		printf("error: input and output matrix do not match for ImageProcessor::ThresholdBinarize\n");
@@ -3962,8 +4650,21 @@ bool ImageProcessor::ThresholdBinarize(const CFloatMatrix *pInputMatrix, CFloatM
 	return true;
 }
 
+struct ThresholdBinarizeInverseOperation
+{
+	ThresholdBinarizeInverseOperation(unsigned char nThreshold) : nThreshold(nThreshold) { }
+	
+	bool operator()(const CByteImage *pInputImage, CByteImage *pOutputImage) const { return ImageProcessor::ThresholdBinarizeInverse(pInputImage, pOutputImage, nThreshold); }
+	
+	unsigned char nThreshold;
+};
+
 bool ImageProcessor::ThresholdBinarizeInverse(const CByteImage *pInputImage, CByteImage *pOutputImage, unsigned char nThreshold)
 {
+	bool bResult;
+	if (ProcessInRowBands(ThresholdBinarizeInverseOperation(nThreshold), pInputImage, pOutputImage, 0, bResult))
+		return bResult;
+	
 	OPTIMIZED_FUNCTION_HEADER_3(ThresholdBinarizeInverse, pInputImage, pOutputImage, nThreshold)
 	
 	if (pInputImage->width != pOutputImage->width || pInputImage->height != pOutputImage->height ||
@@ -3973,20 +4674,38 @@ bool ImageProcessor::ThresholdBinarizeInverse(const CByteImage *pInputImage, CBy
 		return false;
 	}
 		
-	unsigned char *input = pInputImage->pixels;
-	unsigned char *output = pOutputImage->pixels;
-	const int nPixels = pInputImage->width * pInputImage->height;
+	const int width = pInputImage->width;
+	const int height = pInputImage->height;
 
-	for (int i = 0; i < nPixels; i++)
-		output[i] = input[i] <= nThreshold ? 255 : 0;
+	for (int y = 0; y < height; y++)
+	{
+		const unsigned char *input = pInputImage->pixels + y * pInputImage->GetStride();
+		unsigned char *output = pOutputImage->pixels + y * pOutputImage->GetStride();
+		
+		for (int i = 0; i < width; i++)
+			output[i] = input[i] <= nThreshold ? 255 : 0;
+	}
 	
 	OPTIMIZED_FUNCTION_FOOTER
 
 	return true;
 }
 
+struct ThresholdFilterOperation
+{
+	ThresholdFilterOperation(unsigned char nThreshold) : nThreshold(nThreshold) { }
+	
+	bool operator()(const CByteImage *pInputImage, CByteImage *pOutputImage) const { return ImageProcessor::ThresholdFilter(pInputImage, pOutputImage, nThreshold); }
+	
+	unsigned char nThreshold;
+};
+
 bool ImageProcessor::ThresholdFilter(const CByteImage *pInputImage, CByteImage *pOutputImage, unsigned char nThreshold)
 {
+	bool bResult;
+	if (ProcessInRowBands(ThresholdFilterOperation(nThreshold), pInputImage, pOutputImage, 0, bResult))
+		return bResult;
+	
 	OPTIMIZED_FUNCTION_HEADER_3(ThresholdFilter, pInputImage, pOutputImage, nThreshold)
 	
 	if (pInputImage->width != pOutputImage->width || pInputImage->height != pOutputImage->height ||
@@ -3996,20 +4715,38 @@ bool ImageProcessor::ThresholdFilter(const CByteImage *pInputImage, CByteImage *
 		return false;
 	}
 	
-	const int nPixels = pInputImage->width * pInputImage->height;
-	const unsigned char *input = pInputImage->pixels;
-	unsigned char *output = pOutputImage->pixels;
+	const int width = pInputImage->width;
+	const int height = pInputImage->height;
 
-	for (int i = 0; i < nPixels; i++)
-		output[i] = input[i] >= nThreshold ? input[i] : 0;
+	for (int y = 0; y < height; y++)
+	{
+		const unsigned char *input = pInputImage->pixels + y * pInputImage->GetStride();
+		unsigned char *output = pOutputImage->pixels + y * pOutputImage->GetStride();
+		
+		for (int i = 0; i < width; i++)
+			output[i] = input[i] >= nThreshold ? input[i] : 0;
+	}
 	
 	OPTIMIZED_FUNCTION_FOOTER
 
 	return true;
 }
 
+struct ThresholdFilterInverseOperation
+{
+	ThresholdFilterInverseOperation(unsigned char nThreshold) : nThreshold(nThreshold) { }
+	
+	bool operator()(const CByteImage *pInputImage, CByteImage *pOutputImage) const { return ImageProcessor::ThresholdFilterInverse(pInputImage, pOutputImage, nThreshold); }
+	
+	unsigned char nThreshold;
+};
+
 bool ImageProcessor::ThresholdFilterInverse(const CByteImage *pInputImage, CByteImage *pOutputImage, unsigned char nThreshold)
 {
+	bool bResult;
+	if (ProcessInRowBands(ThresholdFilterInverseOperation(nThreshold), pInputImage, pOutputImage, 0, bResult))
+		return bResult;
+	
 	OPTIMIZED_FUNCTION_HEADER_3(ThresholdFilterInverse, pInputImage, pOutputImage, nThreshold)
 	
 	if (pInputImage->width != pOutputImage->width || pInputImage->height != pOutputImage->height ||
@@ -4019,12 +4756,17 @@ bool ImageProcessor::ThresholdFilterInverse(const CByteImage *pInputImage, CByte
 		return false;
 	}
 		
-	unsigned char *input = pInputImage->pixels;
-	unsigned char *output = pOutputImage->pixels;
-	const int nPixels = pInputImage->width * pInputImage->height;
+	const int width = pInputImage->width;
+	const int height = pInputImage->height;
 
-	for (int i = 0; i < nPixels; i++)
-		output[i] = input[i] <= nThreshold ? input[i] : 0;
+	for (int y = 0; y < height; y++)
+	{
+		const unsigned char *input = pInputImage->pixels + y * pInputImage->GetStride();
+		unsigned char *output = pOutputImage->pixels + y * pOutputImage->GetStride();
+		
+		for (int i = 0; i < width; i++)
+			output[i] = input[i] <= nThreshold ? input[i] : 0;
+	}
 	
 	OPTIMIZED_FUNCTION_FOOTER
 
@@ -4034,6 +4776,12 @@ bool ImageProcessor::ThresholdFilterInverse(const CByteImage *pInputImage, CByte
 
 bool ImageProcessor::FilterRGB(const CByteImage *pInputImage, CByteImage *pOutputImage, CRGBColorModel *pColorModel, float fThreshold)
 {
+	if (pInputImage->IsPadded() || pOutputImage->IsPadded())
+	{
+		CUnpaddedImage<CByteImage> input(pInputImage), output(pOutputImage, true);
+		return FilterRGB(input, output, pColorModel, fThreshold);
+	}
+	
 	if (pInputImage->width != pOutputImage->width || pInputImage->height != pOutputImage->height ||
 		pInputImage->type != CByteImage::eRGB24 || pOutputImage->type != CByteImage::eGrayScale)
 	{
@@ -4082,10 +4830,32 @@ bool ImageProcessor::FilterHSV(const CByteImage *pInputImage, CByteImage *pOutpu
 	return FilterHSV2(pInputImage, pOutputImage, (unsigned char) min_hue, (unsigned char) max_hue, min_sat, max_sat, min_v, max_v, pROI);
 }
 
+struct FilterHSV2Operation
+{
+	FilterHSV2Operation(unsigned char min_hue, unsigned char max_hue, unsigned char min_sat, unsigned char max_sat, unsigned char min_v, unsigned char max_v) :
+		min_hue(min_hue), max_hue(max_hue), min_sat(min_sat), max_sat(max_sat), min_v(min_v), max_v(max_v) { }
+	
+	bool operator()(const CByteImage *pInputImage, CByteImage *pOutputImage) const { return ImageProcessor::FilterHSV2(pInputImage, pOutputImage, min_hue, max_hue, min_sat, max_sat, min_v, max_v); }
+	
+	unsigned char min_hue, max_hue;
+	unsigned char min_sat, max_sat;
+	unsigned char min_v, max_v;
+};
+
 bool ImageProcessor::FilterHSV2(const CByteImage *pInputImage, CByteImage *pOutputImage, unsigned char min_hue, unsigned char max_hue, unsigned char min_sat, unsigned char max_sat, unsigned char min_v, unsigned char max_v, const MyRegion *pROI)
 {
+	bool bResult;
+	if (!pROI && ProcessInRowBands(FilterHSV2Operation(min_hue, max_hue, min_sat, max_sat, min_v, max_v), pInputImage, pOutputImage, 0, bResult))
+		return bResult;
+	
 	OPTIMIZED_FUNCTION_HEADER_8_ROI(FilterHSV2, pInputImage, pOutputImage, min_hue, max_hue, min_sat, max_sat, min_v, max_v, pROI)
 	
+	if (pInputImage->IsPadded() || pOutputImage->IsPadded())
+	{
+		CUnpaddedImage<CByteImage> input(pInputImage), output(pOutputImage, true);
+		return FilterHSV2(input, output, min_hue, max_hue, min_sat, max_sat, min_v, max_v, pROI);
+	}
+	
 	if (pInputImage->width != pOutputImage->width || pInputImage->height != pOutputImage->height ||
 		(pInputImage->type != CByteImage::eRGB24 && pInputImage->type != CByteImage::eRGB24Split) || pOutputImage->type != CByteImage::eGrayScale)
 	{
@@ -4239,6 +5009,12 @@ bool ImageProcessor::FilterColor(const CByteImage *pInputImage, CByteImage *pOut
 // Original version of this function by Olaf Fischer
 bool ImageProcessor::Rotate180Degrees(const CByteImage *pInputImage, CByteImage *pOutputImage)
 {
+	if (pInputImage->IsPadded() || pOutputImage->IsPadded())
+	{
+		CUnpaddedImage<CByteImage> input(pInputImage), output(pOutputImage, true);
+		return Rotate180Degrees(input, output);
+	}
+	
 	if (pInputImage->width != pOutputImage->width || pInputImage->height != pOutputImage->height || pInputImage->type != pOutputImage->type || pInputImage->type == CByteImage::eRGB24Split)
 	{
 		printf("error: input and output image do not match for ImageProcessor::Rotate180Degrees\n");
@@ -4388,6 +5164,12 @@ static int _RegionGrowing(unsigned char *pixels, int width, int offset, int *sta
 
 int ImageProcessor::RegionGrowing(const CByteImage *pImage, MyRegion &resultRegion, int x, int y, int nMinimumPointsPerRegion, int nMaximumPointsPerRegion, bool bCalculateBoundingBox, bool bStorePixels)
 {
+	if (pImage->IsPadded())
+	{
+		CUnpaddedImage<CByteImage> image(pImage);
+		return RegionGrowing(image, resultRegion, x, y, nMinimumPointsPerRegion, nMaximumPointsPerRegion, bCalculateBoundingBox, bStorePixels);
+	}
+	
 	if (pImage->type != CByteImage::eGrayScale)
 	{
 		printf("error: input image should be grayscale for ImageProcessor::RegionGrowing\n");
@@ -4423,51 +5205,444 @@ int ImageProcessor::RegionGrowing(const CByteImage *pImage, MyRegion &resultRegi
 	// allocate memory
 	const int nPixels = temp_width * temp_height;
 
-	int *pStack = new int[nPixels];
-	int *pRegionPixels = new int[nPixels];
+	int *pStack = new int[nPixels];
+	int *pRegionPixels = new int[nPixels];
+
+	// perform region growing
+	const int nRegionPixels = _RegionGrowing(temp, temp_width, (y + 1) * temp_width + (x + 1), pStack, pRegionPixels, resultRegion, nMinimumPointsPerRegion, nMaximumPointsPerRegion, bCalculateBoundingBox);
+
+	if (resultRegion.pPixels)
+	{
+		delete [] resultRegion.pPixels;
+		resultRegion.pPixels = 0;
+	}
+	
+	if (nRegionPixels > 0)
+	{
+		if (bStorePixels)
+		{
+			resultRegion.pPixels = new int[nRegionPixels];
+
+			for (int j = 0; j < nRegionPixels; j++)
+			{
+				const int x = pRegionPixels[j] % temp_width;
+				const int y = pRegionPixels[j] / temp_width;
+
+				resultRegion.pPixels[j] = (y - 1) * width + x - 1;
+			}
+		}
+		
+		// correct coordinates
+		resultRegion.centroid.x -= 1.0f;
+		resultRegion.centroid.y -= 1.0f;
+
+		resultRegion.min_x -= 1;
+		resultRegion.min_y -= 1;
+		resultRegion.max_x -= 1;
+		resultRegion.max_y -= 1;
+
+		resultRegion.nSeedOffset = (resultRegion.nSeedOffset / temp_width - 1) * width + (resultRegion.nSeedOffset % temp_width - 1);
+	}
+
+	// free memory
+	delete pTempImage;
+	delete [] pStack;
+	delete [] pRegionPixels;
+
+	return nRegionPixels;
+}
+
+// Connected component labeling (4-connectivity) with union-find: the first pass assigns provisional
+// labels and accumulates the region statistics per run of foreground pixels, the second pass writes
+// the final labels and pixel lists. The first pass is processed in stripes of rows if the worker pool
+// is enabled; the stripes are merged along their boundary rows afterwards. Provisional labels are
+// assigned in raster order and each set is represented by its smallest label, i.e. by the label of
+// the first pixel of the region, so that the result does not depend on the stripes.
+struct RegionLabelingStatistics
+{
+	int nPixels;
+	int nSeedOffset;
+	double cx, cy;
+	int min_x, min_y, max_x, max_y;
+	int nRegion; // 1-based index of the region in the result list, 0 if not accepted
+};
+
+template <class TImage>
+struct RegionLabelingParameters
+{
+	const TImage *pImage;
+	int *pLabels;
+	int *pParents;
+	RegionLabelingStatistics *pStatistics;
+	int *pStripeLabels; // number of labels of the stripe starting at the respective row, -1 otherwise
+	int nLabelsPerRow;
+};
+
+static inline int FindRoot(int *pParents, int nLabel)
+{
+	while (pParents[nLabel] != nLabel)
+	{
+		pParents[nLabel] = pParents[pParents[nLabel]];
+		nLabel = pParents[nLabel];
+	}
+	
+	return nLabel;
+}
+
+static inline void Union(int *pParents, int nLabel1, int nLabel2)
+{
+	nLabel1 = FindRoot(pParents, nLabel1);
+	nLabel2 = FindRoot(pParents, nLabel2);
+	
+	if (nLabel1 < nLabel2)
+		pParents[nLabel2] = nLabel1;
+	else if (nLabel2 < nLabel1)
+		pParents[nLabel1] = nLabel2;
+}
+
+// finds the first run [start_x, end_x) of foreground pixels in row y with start_x >= x
+static inline bool FindNextRun(const CByteImage *pImage, int y, int x, int &start_x, int &end_x)
+{
+	const unsigned char *input = pImage->pixels + y * pImage->GetStride();
+	const int width = pImage->width;
+	
+	while (x < width && input[x] != 255)
+		x++;
+	
+	if (x == width)
+		return false;
+	
+	start_x = x;
+	
+	while (x < width && input[x] == 255)
+		x++;
+	
+	end_x = x;
+	
+	return true;
+}
+
+static inline int CountTrailingZeros(CBinaryImage::Word word)
+{
+#if defined(__GNUC__)
+	return __builtin_ctzll(word);
+#else
+	int n = 0;
+	
+	if (!(word & 0xffffffffULL)) { word >>= 32; n += 32; }
+	if (!(word & 0xffffULL)) { word >>= 16; n += 16; }
+	if (!(word & 0xffULL)) { word >>= 8; n += 8; }
+	if (!(word & 0xfULL)) { word >>= 4; n += 4; }
+	if (!(word & 0x3ULL)) { word >>= 2; n += 2; }
+	if (!(word & 0x1ULL)) n += 1;
+	
+	return n;
+#endif
+}
+
+// the bits beyond the width are zero, so that a run always ends within the row
+static inline bool FindNextRun(const CBinaryImage *pImage, int y, int x, int &start_x, int &end_x)
+{
+	typedef CBinaryImage::Word Word;
+	
+	const Word *words = pImage->words + y * pImage->stride;
+	const int nWords = pImage->stride;
+	
+	int i = x >> 6;
+	
+	if (i >= nWords)
+		return false;
+	
+	// foreground pixels at or after x
+	Word word = words[i] & (~Word(0) << (x & 63));
+	
+	while (!word)
+	{
+		if (++i == nWords)
+			return false;
+		
+		word = words[i];
+	}
+	
+	start_x = (i << 6) + CountTrailingZeros(word);
+	
+	// background pixels at or after start_x
+	word = ~words[i] & (~Word(0) << (start_x & 63));
+	
+	while (!word)
+	{
+		if (++i == nWords)
+		{
+			end_x = nWords << 6;
+			return true;
+		}
+		
+		word = ~words[i];
+	}
+	
+	end_x = (i << 6) + CountTrailingZeros(word);
+	
+	return true;
+}
+
+template <class TImage>
+static void LabelRegionStripe(void *pParameter, int nBegin, int nEnd)
+{
+	const RegionLabelingParameters<TImage> *pParameters = (const RegionLabelingParameters<TImage> *) pParameter;
+	const TImage *pImage = pParameters->pImage;
+	const int width = pImage->width;
+	int *pLabels = pParameters->pLabels;
+	int *pParents = pParameters->pParents;
+	RegionLabelingStatistics *pStatistics = pParameters->pStatistics;
+	
+	// each row can start at most (width + 1) / 2 new labels, label 0 is the background
+	const int nFirstLabel = nBegin * pParameters->nLabelsPerRow + 1;
+	int nNextLabel = nFirstLabel;
+	
+	for (int y = nBegin; y < nEnd; y++)
+	{
+		int *labels = pLabels + y * width;
+		const int *labels_above = y > nBegin ? labels - width : 0;
+		
+		memset(labels, 0, width * sizeof(int));
+		
+		int start_x, end_x;
+		
+		for (int x = 0; FindNextRun(pImage, y, x, start_x, end_x); x = end_x)
+		{
+			// label of the run: left neighbor is background
+			int label = labels_above ? labels_above[start_x] : 0;
+			
+			if (label == 0)
+			{
+				label = nNextLabel++;
+				pParents[label] = label;
+				
+				RegionLabelingStatistics &statistics = pStatistics[label];
+				statistics.nPixels = 0;
+				statistics.nSeedOffset = y * width + start_x;
+				statistics.cx = statistics.cy = 0.0;
+				statistics.min_x = statistics.max_x = start_x;
+				statistics.min_y = statistics.max_y = y;
+			}
+			
+			for (x = start_x; x < end_x; x++)
+			{
+				labels[x] = label;
+				
+				if (labels_above && labels_above[x] != 0 && labels_above[x] != label)
+					Union(pParents, label, labels_above[x]);
+			}
+			
+			// accumulate statistics of the run [start_x, end_x - 1]
+			const int n = end_x - start_x;
+			RegionLabelingStatistics &statistics = pStatistics[label];
+			statistics.nPixels += n;
+			statistics.cx += double(start_x + end_x - 1) * n / 2;
+			statistics.cy += double(y) * n;
+			
+			if (start_x < statistics.min_x)
+				statistics.min_x = start_x;
+			
+			if (end_x - 1 > statistics.max_x)
+				statistics.max_x = end_x - 1;
+			
+			if (y > statistics.max_y)
+				statistics.max_y = y;
+		}
+	}
+	
+	pParameters->pStripeLabels[nBegin] = nNextLabel - nFirstLabel;
+}
+
+static MyRegion &AddRegion(RegionList &regionList)
+{
+	regionList.resize(regionList.size() + 1);
+	return regionList.back();
+}
 
-	// perform region growing
-	const int nRegionPixels = _RegionGrowing(temp, temp_width, (y + 1) * temp_width + (x + 1), pStack, pRegionPixels, resultRegion, nMinimumPointsPerRegion, nMaximumPointsPerRegion, bCalculateBoundingBox);
+static MyRegion &AddRegion(CRegionArray &regionList)
+{
+	MyRegion &region = regionList.AddElement();
+	
+	// elements are reused after CRegionArray::Clear
+	if (region.pPixels)
+	{
+		delete [] region.pPixels;
+		region.pPixels = 0;
+	}
+	
+	return region;
+}
 
-	if (resultRegion.pPixels)
+template <class TImage, class TRegionList>
+static bool LabelRegions(const TImage *pImage, CIntImage *pLabelImage, TRegionList &regionList, int nMinimumPointsPerRegion, int nMaximumPointsPerRegion, bool bCalculateBoundingBox, bool bStorePixels)
+{
+	const int width = pImage->width;
+	const int height = pImage->height;
+	const int nLabelsPerRow = (width + 1) / 2;
+	const int nMaxLabels = height * nLabelsPerRow + 1;
+	
+	int *pLabels = new int[width * height];
+	int *pParents = new int[nMaxLabels];
+	RegionLabelingStatistics *pStatistics = new RegionLabelingStatistics[nMaxLabels];
+	int *pStripeLabels = new int[height];
+	int y;
+	
+	for (y = 0; y < height; y++)
+		pStripeLabels[y] = -1;
+	
+	// first pass
+	RegionLabelingParameters<TImage> parameters = { pImage, pLabels, pParents, pStatistics, pStripeLabels, nLabelsPerRow };
+	Threading::ParallelFor(LabelRegionStripe<TImage>, &parameters, height, 32);
+	
+	// merge stripes along their boundaries
+	for (y = 1; y < height; y++)
 	{
-		delete [] resultRegion.pPixels;
-		resultRegion.pPixels = 0;
+		if (pStripeLabels[y] != -1)
+		{
+			const int *labels = pLabels + y * width;
+			const int *labels_above = labels - width;
+			
+			for (int x = 0; x < width; x++)
+			{
+				if (labels[x] != 0 && labels_above[x] != 0)
+					Union(pParents, labels[x], labels_above[x]);
+			}
+		}
 	}
 	
-	if (nRegionPixels > 0)
+	// resolve the sets in ascending label order (the parent of each label is smaller than the label itself)
+	// and accumulate the statistics in the root labels
+	for (y = 0; y < height; y++)
+	{
+		if (pStripeLabels[y] <= 0)
+			continue;
+		
+		const int nFirstLabel = y * nLabelsPerRow + 1;
+		const int nLastLabel = nFirstLabel + pStripeLabels[y];
+		
+		for (int i = nFirstLabel; i < nLastLabel; i++)
+		{
+			const int root = pParents[pParents[i]];
+			pParents[i] = root;
+			
+			if (root != i)
+			{
+				const RegionLabelingStatistics &statistics = pStatistics[i];
+				RegionLabelingStatistics &root_statistics = pStatistics[root];
+				
+				root_statistics.nPixels += statistics.nPixels;
+				root_statistics.cx += statistics.cx;
+				root_statistics.cy += statistics.cy;
+				
+				if (statistics.min_x < root_statistics.min_x)
+					root_statistics.min_x = statistics.min_x;
+				
+				if (statistics.max_x > root_statistics.max_x)
+					root_statistics.max_x = statistics.max_x;
+				
+				if (statistics.max_y > root_statistics.max_y)
+					root_statistics.max_y = statistics.max_y;
+			}
+		}
+	}
+	
+	// fill region list, the roots are visited in the order of the first pixels of the regions
+	int nRegions = 0;
+	
+	for (y = 0; y < height; y++)
+	{
+		if (pStripeLabels[y] <= 0)
+			continue;
+		
+		const int nFirstLabel = y * nLabelsPerRow + 1;
+		const int nLastLabel = nFirstLabel + pStripeLabels[y];
+		
+		for (int i = nFirstLabel; i < nLastLabel; i++)
+		{
+			if (pParents[i] != i)
+				continue;
+			
+			RegionLabelingStatistics &statistics = pStatistics[i];
+			const int nPixels = statistics.nPixels;
+			
+			if ((nMinimumPointsPerRegion > 0 && nPixels < nMinimumPointsPerRegion) || (nMaximumPointsPerRegion > 0 && nPixels > nMaximumPointsPerRegion))
+			{
+				statistics.nRegion = 0;
+				continue;
+			}
+			
+			statistics.nRegion = ++nRegions;
+			
+			MyRegion &region = AddRegion(regionList);
+			
+			region.nPixels = nPixels;
+			region.nSeedOffset = statistics.nSeedOffset;
+			
+			// same arithmetic as for the bordered image in RegionGrowing
+			region.centroid.x = float(statistics.cx + nPixels) / nPixels - 1.0f;
+			region.centroid.y = float(statistics.cy + nPixels) / nPixels - 1.0f;
+			
+			if (bCalculateBoundingBox)
+			{
+				region.min_x = statistics.min_x;
+				region.min_y = statistics.min_y;
+				region.max_x = statistics.max_x;
+				region.max_y = statistics.max_y;
+				region.ratio = float(statistics.max_x - statistics.min_x + 1) / float(statistics.max_y - statistics.min_y + 1);
+			}
+			else
+			{
+				region.min_x = -1;
+				region.min_y = -1;
+				region.max_x = -1;
+				region.max_y = -1;
+				region.ratio = 0.0f;
+			}
+		}
+	}
+	
+	// second pass: final labels and pixel lists
+	if (pLabelImage || bStorePixels)
 	{
+		int *pPixelCounts = 0;
+		
 		if (bStorePixels)
 		{
-			resultRegion.pPixels = new int[nRegionPixels];
-
-			for (int j = 0; j < nRegionPixels; j++)
+			pPixelCounts = new int[nRegions + 1];
+			memset(pPixelCounts, 0, (nRegions + 1) * sizeof(int));
+			
+			for (int i = 0; i < nRegions; i++)
+				regionList[i].pPixels = new int[regionList[i].nPixels];
+		}
+		
+		for (y = 0; y < height; y++)
+		{
+			const int *labels = pLabels + y * width;
+			int *output = pLabelImage ? pLabelImage->pixels + y * pLabelImage->GetStride() : 0;
+			
+			for (int x = 0; x < width; x++)
 			{
-				const int x = pRegionPixels[j] % temp_width;
-				const int y = pRegionPixels[j] / temp_width;
-
-				resultRegion.pPixels[j] = (y - 1) * width + x - 1;
+				const int nRegion = labels[x] ? pStatistics[pParents[labels[x]]].nRegion : 0;
+				
+				if (output)
+					output[x] = nRegion;
+				
+				if (nRegion && pPixelCounts)
+					regionList[nRegion - 1].pPixels[pPixelCounts[nRegion]++] = y * width + x;
 			}
 		}
 		
-		// correct coordinates
-		resultRegion.centroid.x -= 1.0f;
-		resultRegion.centroid.y -= 1.0f;
-
-		resultRegion.min_x -= 1;
-		resultRegion.min_y -= 1;
-		resultRegion.max_x -= 1;
-		resultRegion.max_y -= 1;
-
-		resultRegion.nSeedOffset = (resultRegion.nSeedOffset / temp_width - 1) * width + (resultRegion.nSeedOffset % temp_width - 1);
+		delete [] pPixelCounts;
 	}
-
-	// free memory
-	delete pTempImage;
-	delete [] pStack;
-	delete [] pRegionPixels;
-
-	return nRegionPixels;
+	
+	delete [] pLabels;
+	delete [] pParents;
+	delete [] pStatistics;
+	delete [] pStripeLabels;
+	
+	return true;
 }
 
 bool ImageProcessor::FindRegions(const CByteImage *pImage, RegionList &regionList, int nMinimumPointsPerRegion, int nMaximumPointsPerRegion, bool bCalculateBoundingBox, bool bStorePixels)
@@ -4481,87 +5656,24 @@ bool ImageProcessor::FindRegions(const CByteImage *pImage, RegionList &regionLis
 		return false;
 	}
 
-	const int width = pImage->width;
-	const int height = pImage->height;
-	
-	// create image with additional 1 pixel border
-	CByteImage *pTempImage = new CByteImage(width + 2, height + 2, CByteImage::eGrayScale);
-
-	const int temp_width = pTempImage->width;
-	const int temp_height = pTempImage->height;
-
-	unsigned char *temp = pTempImage->pixels;
-		
-	// copy contents
-	unsigned char *temp_helper = temp + temp_width + 1;
-
-	for (int y = 0; y < pImage->height; y++)
-		memcpy(temp_helper + y * temp_width, pImage->pixels + y * width, width);
-
-	// zero frame
-	ImageProcessor::ZeroFrame(pTempImage);
-
-	// allocate memory
-	const int nPixels = temp_width * temp_height;
+	return LabelRegions(pImage, 0, regionList, nMinimumPointsPerRegion, nMaximumPointsPerRegion, bCalculateBoundingBox, bStorePixels);
+}
 
-	int *pStack = new int[nPixels];
-	int *pRegionPixels = new int[nPixels];
+bool ImageProcessor::FindRegions(const CByteImage *pImage, CRegionArray &regionList, int nMinimumPointsPerRegion, int nMaximumPointsPerRegion, bool bCalculateBoundingBox, bool bStorePixels)
+{
+	// clear result list
+	regionList.Clear();
 
-	// go through image
-	for (int i = 0; i < nPixels; i++)
+	if (pImage->type != CByteImage::eGrayScale)
 	{
-		if (temp[i] == 255)
-		{
-			MyRegion region;
-				
-			// do region growing
-			const int nRegionPixels = _RegionGrowing(temp, temp_width, i, pStack, pRegionPixels, region, nMinimumPointsPerRegion, nMaximumPointsPerRegion, bCalculateBoundingBox);
-			
-			if (nRegionPixels > 0)
-			{
-				// first add
-				regionList.push_back(region);
-
-				// then copy (this way a double copy through copy constructor is avoided)
-				// and correct coordinates
-				MyRegion &addedEntry = regionList.back();
-
-				// correct coordinates
-				addedEntry.centroid.x -= 1.0f;
-				addedEntry.centroid.y -= 1.0f;
-
-				addedEntry.min_x -= 1;
-				addedEntry.min_y -= 1;
-				addedEntry.max_x -= 1;
-				addedEntry.max_y -= 1;
-
-				if (bStorePixels)
-				{
-					addedEntry.pPixels = new int[nRegionPixels];
-
-					for (int j = 0; j < nRegionPixels; j++)
-					{
-						const int x = pRegionPixels[j] % temp_width;
-						const int y = pRegionPixels[j] / temp_width;
-
-						addedEntry.pPixels[j] = (y - 1) * width + x - 1;
-					}
-					
-					addedEntry.nSeedOffset = (addedEntry.nSeedOffset / temp_width - 1) * width + (addedEntry.nSeedOffset % temp_width - 1);
-				}
-			}
-		}
+		printf("error: input image should be grayscale for ImageProcessor::FindRegions\n");
+		return false;
 	}
 
-	// free memory
-	delete pTempImage;
-	delete [] pStack;
-	delete [] pRegionPixels;
-
-	return true;
+	return LabelRegions(pImage, 0, regionList, nMinimumPointsPerRegion, nMaximumPointsPerRegion, bCalculateBoundingBox, bStorePixels);
 }
 
-bool ImageProcessor::FindRegions(const CByteImage *pImage, CRegionArray &regionList, int nMinimumPointsPerRegion, int nMaximumPointsPerRegion, bool bCalculateBoundingBox, bool bStorePixels)
+bool ImageProcessor::FindRegions(const CByteImage *pImage, CIntImage *pLabelImage, CRegionArray &regionList, int nMinimumPointsPerRegion, int nMaximumPointsPerRegion, bool bCalculateBoundingBox, bool bStorePixels)
 {
 	// clear result list
 	regionList.Clear();
@@ -4572,91 +5684,65 @@ bool ImageProcessor::FindRegions(const CByteImage *pImage, CRegionArray &regionL
 		return false;
 	}
 
-	const int width = pImage->width;
-	const int height = pImage->height;
-	
-	// create image with additional 1 pixel border
-	CByteImage *pTempImage = new CByteImage(width + 2, height + 2, CByteImage::eGrayScale);
+	if (pImage->width != pLabelImage->width || pImage->height != pLabelImage->height)
+	{
+		printf("error: input image and label image do not match for ImageProcessor::FindRegions\n");
+		return false;
+	}
 
-	const int temp_width = pTempImage->width;
-	const int temp_height = pTempImage->height;
+	return LabelRegions(pImage, pLabelImage, regionList, nMinimumPointsPerRegion, nMaximumPointsPerRegion, bCalculateBoundingBox, bStorePixels);
+}
 
-	unsigned char *temp = pTempImage->pixels;
-		
-	// copy contents
-	unsigned char *temp_helper = temp + temp_width + 1;
+bool ImageProcessor::FindRegions(const CBinaryImage *pImage, RegionList &regionList, int nMinimumPointsPerRegion, int nMaximumPointsPerRegion, bool bCalculateBoundingBox, bool bStorePixels)
+{
+	// clear result list
+	regionList.clear();
 
-	for (int y = 0; y < pImage->height; y++)
-		memcpy(temp_helper + y * temp_width, pImage->pixels + y * width, width);
+	return LabelRegions(pImage, 0, regionList, nMinimumPointsPerRegion, nMaximumPointsPerRegion, bCalculateBoundingBox, bStorePixels);
+}
 
-	// zero frame
-	ImageProcessor::ZeroFrame(pTempImage);
+bool ImageProcessor::FindRegions(const CBinaryImage *pImage, CRegionArray &regionList, int nMinimumPointsPerRegion, int nMaximumPointsPerRegion, bool bCalculateBoundingBox, bool bStorePixels)
+{
+	// clear result list
+	regionList.Clear();
 
-	// allocate memory
-	const int nPixels = temp_width * temp_height;
+	return LabelRegions(pImage, 0, regionList, nMinimumPointsPerRegion, nMaximumPointsPerRegion, bCalculateBoundingBox, bStorePixels);
+}
 
-	int *pStack = new int[nPixels];
-	int *pRegionPixels = new int[nPixels];
+bool ImageProcessor::FindRegions(const CBinaryImage *pImage, CIntImage *pLabelImage, CRegionArray &regionList, int nMinimumPointsPerRegion, int nMaximumPointsPerRegion, bool bCalculateBoundingBox, bool bStorePixels)
+{
+	// clear result list
+	regionList.Clear();
 
-	// go through image
-	for (int i = 0; i < nPixels; i++)
+	if (pImage->width != pLabelImage->width || pImage->height != pLabelImage->height)
 	{
-		if (temp[i] == 255)
-		{
-			MyRegion region;
-				
-			// do region growing
-			const int nRegionPixels = _RegionGrowing(temp, temp_width, i, pStack, pRegionPixels, region, nMinimumPointsPerRegion, nMaximumPointsPerRegion, bCalculateBoundingBox);
-			
-			if (nRegionPixels > 0)
-			{
-				// first add
-				regionList.AddElement(region);
-
-				// then copy (this way a double copy through copy constructor is avoided)
-				// and correct coordinates
-				MyRegion &addedEntry = regionList[regionList.GetSize() - 1];
-
-				// correct coordinates
-				addedEntry.centroid.x -= 1.0f;
-				addedEntry.centroid.y -= 1.0f;
-
-				addedEntry.min_x -= 1;
-				addedEntry.min_y -= 1;
-				addedEntry.max_x -= 1;
-				addedEntry.max_y -= 1;
-
-				if (bStorePixels)
-				{
-					addedEntry.pPixels = new int[nRegionPixels];
-
-					for (int j = 0; j < nRegionPixels; j++)
-					{
-						const int x = pRegionPixels[j] % temp_width;
-						const int y = pRegionPixels[j] / temp_width;
-
-						addedEntry.pPixels[j] = (y - 1) * width + x - 1;
-					}
-					
-					addedEntry.nSeedOffset = (addedEntry.nSeedOffset / temp_width - 1) * width + (addedEntry.nSeedOffset % temp_width - 1);
-				}
-			}
-		}
+		printf("error: input image and label image do not match for ImageProcessor::FindRegions\n");
+		return false;
 	}
 
-	// free memory
-	delete pTempImage;
-	delete [] pStack;
-	delete [] pRegionPixels;
-
-	return true;
+	return LabelRegions(pImage, pLabelImage, regionList, nMinimumPointsPerRegion, nMaximumPointsPerRegion, bCalculateBoundingBox, bStorePixels);
 }
 
 
+struct CalculateHSVImageOperation
+{
+	bool operator()(const CByteImage *pInputImage, CByteImage *pOutputImage) const { return ImageProcessor::CalculateHSVImage(pInputImage, pOutputImage); }
+};
+
 bool ImageProcessor::CalculateHSVImage(const CByteImage *pInputImage, CByteImage *pOutputImage, const MyRegion *pROI)
 {
+	bool bResult;
+	if (!pROI && ProcessInRowBands(CalculateHSVImageOperation(), pInputImage, pOutputImage, 0, bResult))
+		return bResult;
+	
 	OPTIMIZED_FUNCTION_HEADER_2_ROI(CalculateHSVImage, pInputImage, pOutputImage, pROI)
 	
+	if (pInputImage->IsPadded() || pOutputImage->IsPadded())
+	{
+		CUnpaddedImage<CByteImage> input(pInputImage), output(pOutputImage, true);
+		return CalculateHSVImage(input, output, pROI);
+	}
+	
 	if (pInputImage->width != pOutputImage->width || pInputImage->height != pOutputImage->height ||
 		pInputImage->type != pOutputImage->type || (pInputImage->type != CByteImage::eRGB24 && pInputImage->type != CByteImage::eRGB24Split))
 	{
@@ -4870,6 +5956,12 @@ bool ImageProcessor::CalculateHSVImage(const CByteImage *pInputImage, CByteImage
 
 bool ImageProcessor::HoughTransformLines(const CByteImage *pImage, CByteImage *pVisualizationImage, Vec2dList &resultLines, int nLinesToExtract, int nMinHits)
 {
+	if (pImage->IsPadded() || (pVisualizationImage && pVisualizationImage->IsPadded()))
+	{
+		CUnpaddedImage<CByteImage> image(pImage), visualizationImage(pVisualizationImage, true);
+		return HoughTransformLines(image, visualizationImage, resultLines, nLinesToExtract, nMinHits);
+	}
+	
 	if (pImage->type == CByteImage::eGrayScale)
 	{
 		printf("error: input image must be of type CByteImage::eGrayScale\n");
@@ -4976,6 +6068,12 @@ bool ImageProcessor::HoughTransformLines(const CByteImage *pImage, CByteImage *p
 
 bool ImageProcessor::HoughTransformCircles(const CByteImage *pImage, CByteImage *pVisualizationImage, Vec3dList &resultCircles, int rmin, int rmax, int nCirclesToExtract, int nMinHits)
 {
+	if (pImage->IsPadded() || (pVisualizationImage && pVisualizationImage->IsPadded()))
+	{
+		CUnpaddedImage<CByteImage> image(pImage), visualizationImage(pVisualizationImage, true);
+		return HoughTransformCircles(image, visualizationImage, resultCircles, rmin, rmax, nCirclesToExtract, nMinHits);
+	}
+	
 	if (rmin > rmax)
 	{
 		printf("error: rmin (%i) may not be greater than rmax (%i) for ImageProcessor::HoughTransformCircles\n", rmin, rmax);
@@ -5417,6 +6515,12 @@ bool ImageProcessor::DetermineAffineTransformation(const Vec2d *pSourcePoints, c
 
 bool ImageProcessor::NormalizeColor(const CByteImage *pInputImage, CByteImage *pOutputImage)
 {
+	if (pInputImage->IsPadded() || pOutputImage->IsPadded())
+	{
+		CUnpaddedImage<CByteImage> input(pInputImage), output(pOutputImage, true);
+		return NormalizeColor(input, output);
+	}
+	
 	if (pInputImage->type == CByteImage::eGrayScale)
 	{
 		printf("error: input image must be of type CByteImage::eRGB24 or CByteImage::eRGB24Split for ImageProcessor::NormalizeColor\n");
@@ -5499,8 +6603,27 @@ bool ImageProcessor::NormalizeColor(const CByteImage *pInputImage, CByteImage *p
 }
 
 
+struct GaussianSmooth5x5MatrixOperation
+{
+	GaussianSmooth5x5MatrixOperation(float fVariance) : fVariance(fVariance) { }
+	
+	bool operator()(const CFloatMatrix *pInputImage, CFloatMatrix *pOutputImage) const { return ImageProcessor::GaussianSmooth5x5(pInputImage, pOutputImage, fVariance); }
+	
+	float fVariance;
+};
+
 bool ImageProcessor::GaussianSmooth5x5(const CFloatMatrix *pInputImage, CFloatMatrix *pOutputImage, float fVariance)
 {
+	bool bResult;
+	if (ProcessInRowBands(GaussianSmooth5x5MatrixOperation(fVariance), pInputImage, pOutputImage, 3, bResult))
+		return bResult;
+	
+	if (pInputImage->IsPadded() || pOutputImage->IsPadded())
+	{
+		CUnpaddedImage<CFloatMatrix> input(pInputImage), output(pOutputImage, true);
+		return GaussianSmooth5x5(input, output, fVariance);
+	}
+	
 	if (pInputImage->columns != pOutputImage->columns || pInputImage->rows != pOutputImage->rows)
 	{
 		printf("error: input and output matrix do not match for ImageProcessor::GaussianSmooth5x5\n");
@@ -5638,8 +6761,29 @@ bool ImageProcessor::GaussianSmooth5x5(const CFloatMatrix *pInputImage, CFloatMa
 	return true;
 }
 
+struct GaussianSmoothOperation
+{
+	GaussianSmoothOperation(float fVariance, int nKernelSize) : fVariance(fVariance), nKernelSize(nKernelSize) { }
+	
+	template <class TInput, class TOutput>
+	bool operator()(const TInput *pInputImage, TOutput *pOutputImage) const { return ImageProcessor::GaussianSmooth(pInputImage, pOutputImage, fVariance, nKernelSize); }
+	
+	float fVariance;
+	int nKernelSize;
+};
+
 bool ImageProcessor::GaussianSmooth(const CByteImage *pInputImage, CByteImage *pOutputImage, float fVariance, int nKernelSize)
 {
+	bool bResult;
+	if (nKernelSize > 0 && ProcessInRowBands(GaussianSmoothOperation(fVariance, nKernelSize), pInputImage, pOutputImage, nKernelSize / 2 + 1, bResult))
+		return bResult;
+	
+	if (pInputImage->IsPadded() || pOutputImage->IsPadded())
+	{
+		CUnpaddedImage<CByteImage> input(pInputImage), output(pOutputImage, true);
+		return GaussianSmooth(input, output, fVariance, nKernelSize);
+	}
+	
 	if (pInputImage->width != pOutputImage->width || pInputImage->height != pOutputImage->height || pInputImage->type != pOutputImage->type || pInputImage->type != CByteImage::eGrayScale)
 	{
 		printf("error: input and output image do not match for ImageProcessor::GaussianSmooth\n");
@@ -5779,6 +6923,17 @@ bool ImageProcessor::GaussianSmooth(const CByteImage *pInputImage, CByteImage *p
 
 bool ImageProcessor::GaussianSmooth(const CByteImage *pInputImage, CFloatMatrix *pOutputImage, float fVariance, int nKernelSize)
 {
+	bool bResult;
+	if (nKernelSize > 0 && ProcessInRowBands(GaussianSmoothOperation(fVariance, nKernelSize), pInputImage, pOutputImage, nKernelSize / 2 + 1, bResult))
+		return bResult;
+	
+	if (pInputImage->IsPadded() || pOutputImage->IsPadded())
+	{
+		CUnpaddedImage<CByteImage> input(pInputImage);
+		CUnpaddedImage<CFloatMatrix> output(pOutputImage, true);
+		return GaussianSmooth(input, output, fVariance, nKernelSize);
+	}
+	
 	if (pInputImage->width != pOutputImage->columns || pInputImage->height != pOutputImage->rows || pInputImage->type != CByteImage::eGrayScale)
 	{
 		printf("error: input image and output matrix do not match for ImageProcessor::GaussianSmooth\n");
@@ -5918,6 +7073,16 @@ bool ImageProcessor::GaussianSmooth(const CByteImage *pInputImage, CFloatMatrix
 
 bool ImageProcessor::GaussianSmooth(const CFloatMatrix *pInputImage, CFloatMatrix *pOutputImage, float fVariance, int nKernelSize)
 {
+	bool bResult;
+	if (nKernelSize > 0 && ProcessInRowBands(GaussianSmoothOperation(fVariance, nKernelSize), pInputImage, pOutputImage, nKernelSize / 2 + 1, bResult))
+		return bResult;
+	
+	if (pInputImage->IsPadded() || pOutputImage->IsPadded())
+	{
+		CUnpaddedImage<CFloatMatrix> input(pInputImage), output(pOutputImage, true);
+		return GaussianSmooth(input, output, fVariance, nKernelSize);
+	}
+	
 	if (pInputImage->columns != pOutputImage->columns || pInputImage->rows != pOutputImage->rows)
 	{
 		printf("error: input and output matrix do not match for ImageProcessor::GaussianSmooth\n");
@@ -6057,6 +7222,12 @@ bool ImageProcessor::GaussianSmooth(const CFloatMatrix *pInputImage, CFloatMatri
 
 bool ImageProcessor::HighPassX3(const CFloatMatrix *pInputImage, CFloatMatrix *pOutputImage)
 {
+	if (pInputImage->IsPadded() || pOutputImage->IsPadded())
+	{
+		CUnpaddedImage<CFloatMatrix> input(pInputImage), output(pOutputImage, true);
+		return HighPassX3(input, output);
+	}
+	
 	if (pInputImage->columns != pOutputImage->columns || pInputImage->rows != pOutputImage->rows)
 	{
 		printf("error: input and output image do not match for ImageProcessor::HighPassX3\n");
@@ -6100,6 +7271,12 @@ bool ImageProcessor::HighPassX3(const CFloatMatrix *pInputImage, CFloatMatrix *p
 
 bool ImageProcessor::HighPassY3(const CFloatMatrix *pInputImage, CFloatMatrix *pOutputImage)
 {
+	if (pInputImage->IsPadded() || pOutputImage->IsPadded())
+	{
+		CUnpaddedImage<CFloatMatrix> input(pInputImage), output(pOutputImage, true);
+		return HighPassY3(input, output);
+	}
+	
 	if (pInputImage->columns != pOutputImage->columns || pInputImage->rows != pOutputImage->rows)
 	{
 		printf("error: input and output image do not match for ImageProcessor::HighPassY3\n");
@@ -6142,6 +7319,12 @@ bool ImageProcessor::HighPassY3(const CFloatMatrix *pInputImage, CFloatMatrix *p
 
 bool ImageProcessor::FlipY(const CByteImage *pInputImage, CByteImage *pOutputImage)
 {
+	if (pInputImage->IsPadded() || pOutputImage->IsPadded())
+	{
+		CUnpaddedImage<CByteImage> input(pInputImage), output(pOutputImage, true);
+		return FlipY(input, output);
+	}
+	
 	if (pInputImage->width != pOutputImage->width || pInputImage->height != pOutputImage->height ||
 		pInputImage->type != pOutputImage->type)
 	{
@@ -6230,6 +7413,13 @@ bool ImageProcessor::FlipY(const CByteImage *pInputImage, CByteImage *pOutputIma
 
 bool ImageProcessor::CalculateIntegralImage(const CByteImage *pInputImage, CIntImage *pIntegralImage)
 {
+	if (pInputImage->IsPadded() || pIntegralImage->IsPadded())
+	{
+		CUnpaddedImage<CByteImage> input(pInputImage);
+		CUnpaddedImage<CIntImage> integralImage(pIntegralImage, true);
+		return CalculateIntegralImage(input, integralImage);
+	}
+	
 	if (pInputImage->width != pIntegralImage->width || pInputImage->height != pIntegralImage->height || pInputImage->type != CByteImage::eGrayScale)
 	{
 		printf("error: input and output image do not match for ImageProcessor::CalculateIntegralImage\n");
@@ -6285,6 +7475,13 @@ bool ImageProcessor::CalculateSummedAreaTable(const CByteImage *pInputImage, CIn
 // counts every pixel != 0 as 1
 bool ImageProcessor::CalculateBinarizedSummedAreaTable(const CByteImage *pInputImage, CIntImage *pSummedAreaTable)
 {
+	if (pInputImage->IsPadded() || pSummedAreaTable->IsPadded())
+	{
+		CUnpaddedImage<CByteImage> input(pInputImage);
+		CUnpaddedImage<CIntImage> summedAreaTable(pSummedAreaTable, true);
+		return CalculateBinarizedSummedAreaTable(input, summedAreaTable);
+	}
+	
 	if (pInputImage->width != pSummedAreaTable->width || pInputImage->height != pSummedAreaTable->height || pInputImage->type != CByteImage::eGrayScale)
 	{
 		printf("error: input and output image do not match for ImageProcessor::CalculateBinarizedSummedAreaTable\n");
@@ -6339,6 +7536,13 @@ bool ImageProcessor::CalculateBinarizedSummedAreaTable(const CByteImage *pInputI
 
 bool ImageProcessor::CalculateReverseSummedAreaTable(const CIntImage *pSummedAreaTable, CByteImage *pOutputImage)
 {
+	if (pSummedAreaTable->IsPadded() || pOutputImage->IsPadded())
+	{
+		CUnpaddedImage<CIntImage> summedAreaTable(pSummedAreaTable);
+		CUnpaddedImage<CByteImage> output(pOutputImage, true);
+		return CalculateReverseSummedAreaTable(summedAreaTable, output);
+	}
+	
 	if (pOutputImage->width != pSummedAreaTable->width || pOutputImage->height != pSummedAreaTable->height || pOutputImage->type != CByteImage::eGrayScale)
 	{
 		printf("error: input and output image do not match for ImageProcessor::CalculateReverseSummedAreaTable\n");
@@ -6396,11 +7600,12 @@ int ImageProcessor::GetAreaSum(const CIntImage *pIntegralImage, int min_x, int m
 	if (max_y < 0) max_y = 0;
 	if (max_y >= height) max_y = height - 1;
 	
+	const int stride = pIntegralImage->GetStride();
 	const int *pixels = pIntegralImage->pixels;
-	const int c1 = min_x < 0 || min_y < 0 ? 0 : pixels[min_y * width + min_x];
-	const int c2 = min_y < 0 ? 0 : pixels[min_y * width + max_x];
-	const int c3 = min_x < 0 ? 0 : pixels[max_y * width + min_x];
-	const int c4 = pixels[max_y * width + max_x];
+	const int c1 = min_x < 0 || min_y < 0 ? 0 : pixels[min_y * stride + min_x];
+	const int c2 = min_y < 0 ? 0 : pixels[min_y * stride + max_x];
+	const int c3 = min_x < 0 ? 0 : pixels[max_y * stride + min_x];
+	const int c4 = pixels[max_y * stride + max_x];
 	 
 	return c4 - c3 - c2 + c1;
 }
@@ -6411,10 +7616,10 @@ inline int ImageProcessor::GetAreaSumNoChecks(const CIntImage *pIntegralImage, i
 	min_x--;
 	min_y--;
 	
-	const int width = pIntegralImage->width;
+	const int stride = pIntegralImage->GetStride();
 	const int *pixels = pIntegralImage->pixels;
 	
-	return pixels[max_y * width + max_x] - pixels[max_y * width + min_x] - pixels[min_y * width + max_x] + pixels[min_y * width + min_x];
+	return pixels[max_y * stride + max_x] - pixels[max_y * stride + min_x] - pixels[min_y * stride + max_x] + pixels[min_y * stride + min_x];
 }
 
 int ImageProcessor::GetAreaSum(const CIntImage *pIntegralImage, const MyRegion *region)
@@ -6487,6 +7692,12 @@ bool ImageProcessor::Canny(const CByteImage *pInputImage, CByteImage *pOutputIma
 {
 	OPTIMIZED_FUNCTION_HEADER_4(Canny, pInputImage, pOutputImage, nLowThreshold, nHighThreshold)
 	
+	if (pInputImage->IsPadded() || pOutputImage->IsPadded())
+	{
+		CUnpaddedImage<CByteImage> input(pInputImage), output(pOutputImage, true);
+		return Canny(input, output, nLowThreshold, nHighThreshold);
+	}
+	
 	if (pInputImage->width != pOutputImage->width || pInputImage->height != pOutputImage->height ||
 		pInputImage->type != pOutputImage->type || pInputImage->type != CByteImage::eGrayScale)
 	{
@@ -6678,6 +7889,12 @@ bool ImageProcessor::Canny(const CByteImage *pInputImage, CVec2dArray &resultPoi
 {
 	OPTIMIZED_FUNCTION_HEADER_5(CannyList, pInputImage, resultPoints, resultDirections, nLowThreshold, nHighThreshold)
 	
+	if (pInputImage->IsPadded())
+	{
+		CUnpaddedImage<CByteImage> input(pInputImage);
+		return Canny(input, resultPoints, resultDirections, nLowThreshold, nHighThreshold);
+	}
+	
 	if (pInputImage->type != CByteImage::eGrayScale)
 	{
 		printf("error: input image must be of type eGrayScale for ImageProcessor::Canny (list)\n");
@@ -6808,6 +8025,13 @@ bool ImageProcessor::Canny(const CByteImage *pInputImage, CVec2dArray &resultPoi
 
 bool ImageProcessor::CalculateHarrisMap(const CByteImage *pInputImage, CIntImage *pOutputImage)
 {
+	if (pInputImage->IsPadded() || pOutputImage->IsPadded())
+	{
+		CUnpaddedImage<CByteImage> input(pInputImage);
+		CUnpaddedImage<CIntImage> output(pOutputImage, true);
+		return CalculateHarrisMap(input, output);
+	}
+	
 	if (pInputImage->type != CByteImage::eGrayScale || pInputImage->width != pOutputImage->width || pInputImage->height != pOutputImage->height)
 	{
 		printf("error: input image and output matrix do not match for ImageProcessor::CalculateHarrisMap\n");
@@ -6919,6 +8143,12 @@ int ImageProcessor::CalculateHarrisInterestPoints(const CByteImage *pInputImage,
 {
 	OPTIMIZED_FUNCTION_HEADER_5_RET(CalculateHarrisInterestPoints, pInputImage, pInterestPoints, nMaxPoints, fQualityLevel, fMinDistance)
 		
+	if (pInputImage->IsPadded())
+	{
+		CUnpaddedImage<CByteImage> input(pInputImage);
+		return CalculateHarrisInterestPoints(input, pInterestPoints, nMaxPoints, fQualityLevel, fMinDistance);
+	}
+	
 	if (pInputImage->type != CByteImage::eGrayScale)
 	{
 		printf("error: input image should be grayscale ImageProcessor::CalculateHarrisInterestPoints\n");
@@ -6965,117 +8195,516 @@ int ImageProcessor::CalculateHarrisInterestPoints(const CByteImage *pInputImage,
 	int nInterestPoints = 0;
 	for (i = 0; i < nCandidates && nInterestPoints < nMaxPoints; i++)
 	{
-		const int offset = pCandidateOffsets[i];
+		const int offset = pCandidateOffsets[i];
+		
+		const int x = offset % width;
+		const int y = offset / width;
+
+		bool bTake = true;
+
+		const int minx = x - nMinDistance < 0 ? 0 : x - nMinDistance;
+		const int miny = y - nMinDistance < 0 ? 0 : y - nMinDistance;
+		const int maxx = x + nMinDistance >= width ? width - 1 : x + nMinDistance;
+		const int maxy = y + nMinDistance >= height ? height - 1 : y + nMinDistance;
+		const int diff = width - (maxx - minx + 1);
+
+		for (int l = miny, offset2 = miny * width + minx; l <= maxy; l++, offset2 += diff)
+			for (int k = minx; k <= maxx; k++, offset2++)
+				if (image.pixels[l * width + k])
+				{
+					bTake = false;
+					break;
+				}
+
+		if (bTake)
+		{
+			// store  point
+			pInterestPoints[nInterestPoints].x = float(x);
+			pInterestPoints[nInterestPoints].y = float(y);
+			nInterestPoints++;
+
+			// mark location in grid for distance constraint check
+			image.pixels[offset] = 1;
+		}
+	}
+
+	delete [] pCandidateOffsets;
+	
+	return nInterestPoints;
+}
+
+
+struct AndOperation
+{
+	bool operator()(const CByteImage *pInputImage1, const CByteImage *pInputImage2, CByteImage *pOutputImage) const { return ImageProcessor::And(pInputImage1, pInputImage2, pOutputImage); }
+};
+
+bool ImageProcessor::And(const CByteImage *pInputImage1, const CByteImage *pInputImage2, CByteImage *pOutputImage)
+{
+	bool bResult;
+	if (ProcessInRowBands(AndOperation(), pInputImage1, pInputImage2, pOutputImage, bResult))
+		return bResult;
+	
+	OPTIMIZED_FUNCTION_HEADER_3(And, pInputImage1, pInputImage2, pOutputImage)
+	
+	if (!pInputImage1->IsCompatible(pInputImage2) || !pInputImage1->IsCompatible(pOutputImage))
+	{
+		printf("error: input images and output image do not match for ImageProcessor::And\n");
+		return false;
+	}
+	
+	const int nRows = GetRows(pInputImage1);
+	const int nRowBytes = GetRowBytes(pInputImage1);
+	
+	for (int y = 0; y < nRows; y++)
+	{
+		const unsigned char *input1 = pInputImage1->pixels + y * pInputImage1->GetStride();
+		const unsigned char *input2 = pInputImage2->pixels + y * pInputImage2->GetStride();
+		unsigned char *output = pOutputImage->pixels + y * pOutputImage->GetStride();
+		
+		for (int i = 0; i < nRowBytes; i++)
+			output[i] = input1[i] & input2[i];
+	}
+	
+	OPTIMIZED_FUNCTION_FOOTER
+
+	return true;
+}
+
+struct XorOperation
+{
+	bool operator()(const CByteImage *pInputImage1, const CByteImage *pInputImage2, CByteImage *pOutputImage) const { return ImageProcessor::Xor(pInputImage1, pInputImage2, pOutputImage); }
+};
+
+bool ImageProcessor::Xor(const CByteImage *pInputImage1, const CByteImage *pInputImage2, CByteImage *pOutputImage)
+{
+	bool bResult;
+	if (ProcessInRowBands(XorOperation(), pInputImage1, pInputImage2, pOutputImage, bResult))
+		return bResult;
+	
+	OPTIMIZED_FUNCTION_HEADER_3(Xor, pInputImage1, pInputImage2, pOutputImage)
+	
+	if (!pInputImage1->IsCompatible(pInputImage2) || !pInputImage1->IsCompatible(pOutputImage))
+	{
+		printf("error: input images and output image do not match for ImageProcessor::Xor\n");
+		return false;
+	}
+	
+	const int nRows = GetRows(pInputImage1);
+	const int nRowBytes = GetRowBytes(pInputImage1);
+	
+	for (int y = 0; y < nRows; y++)
+	{
+		const unsigned char *input1 = pInputImage1->pixels + y * pInputImage1->GetStride();
+		const unsigned char *input2 = pInputImage2->pixels + y * pInputImage2->GetStride();
+		unsigned char *output = pOutputImage->pixels + y * pOutputImage->GetStride();
+		
+		for (int i = 0; i < nRowBytes; i++)
+			output[i] = input1[i] ^ input2[i];
+	}
+	
+	OPTIMIZED_FUNCTION_FOOTER
+
+	return true;
+}
+
+struct OrOperation
+{
+	bool operator()(const CByteImage *pInputImage1, const CByteImage *pInputImage2, CByteImage *pOutputImage) const { return ImageProcessor::Or(pInputImage1, pInputImage2, pOutputImage); }
+};
+
+bool ImageProcessor::Or(const CByteImage *pInputImage1, const CByteImage *pInputImage2, CByteImage *pOutputImage)
+{
+	bool bResult;
+	if (ProcessInRowBands(OrOperation(), pInputImage1, pInputImage2, pOutputImage, bResult))
+		return bResult;
+	
+	OPTIMIZED_FUNCTION_HEADER_3(Or, pInputImage1, pInputImage2, pOutputImage)
+	
+	if (!pInputImage1->IsCompatible(pInputImage2) || !pInputImage1->IsCompatible(pOutputImage))
+	{
+		printf("error: input images and output image do not match for ImageProcessor::Or\n");
+		return false;
+	}
+	
+	const int nRows = GetRows(pInputImage1);
+	const int nRowBytes = GetRowBytes(pInputImage1);
+	
+	for (int y = 0; y < nRows; y++)
+	{
+		const unsigned char *input1 = pInputImage1->pixels + y * pInputImage1->GetStride();
+		const unsigned char *input2 = pInputImage2->pixels + y * pInputImage2->GetStride();
+		unsigned char *output = pOutputImage->pixels + y * pOutputImage->GetStride();
+		
+		for (int i = 0; i < nRowBytes; i++)
+			output[i] = input1[i] | input2[i];
+	}
+	
+	OPTIMIZED_FUNCTION_FOOTER
+
+	return true;
+}
+
+
+// ****************************************************************************
+// Binary images (CBinaryImage)
+// ****************************************************************************
+
+// Pixel x of a row is bit x % 64 of word x / 64. The bits beyond the width are zero
+// in all images and are kept zero by all functions of this section.
+
+typedef CBinaryImage::Word BinaryImageWord;
+
+bool ImageProcessor::ConvertImage(const CByteImage *pInputImage, CBinaryImage *pOutputImage)
+{
+	if (pInputImage->width != pOutputImage->width || pInputImage->height != pOutputImage->height || pInputImage->type != CByteImage::eGrayScale)
+	{
+		printf("error: input and output image do not match for ImageProcessor::ConvertImage\n");
+		return false;
+	}
+	
+	OPTIMIZED_FUNCTION_HEADER_2(ConvertImage_ByteToBinary, pInputImage, pOutputImage)
+	
+	const int width = pInputImage->width;
+	const int height = pInputImage->height;
+	const int nWords = pOutputImage->stride;
+	
+	for (int y = 0; y < height; y++)
+	{
+		const unsigned char *input = pInputImage->pixels + y * pInputImage->GetStride();
+		BinaryImageWord *output = pOutputImage->words + y * nWords;
+		
+		for (int i = 0, x = 0; i < nWords; i++, x += 64)
+		{
+			const int n = MY_MIN(64, width - x);
+			BinaryImageWord word = 0;
+			
+			for (int j = 0; j < n; j++)
+			{
+				if (input[x + j])
+					word |= BinaryImageWord(1) << j;
+			}
+			
+			output[i] = word;
+		}
+	}
+	
+	OPTIMIZED_FUNCTION_FOOTER
+	
+	return true;
+}
+
+bool ImageProcessor::ConvertImage(const CBinaryImage *pInputImage, CByteImage *pOutputImage)
+{
+	if (pInputImage->width != pOutputImage->width || pInputImage->height != pOutputImage->height || pOutputImage->type != CByteImage::eGrayScale)
+	{
+		printf("error: input and output image do not match for ImageProcessor::ConvertImage\n");
+		return false;
+	}
+	
+	OPTIMIZED_FUNCTION_HEADER_2(ConvertImage_BinaryToByte, pInputImage, pOutputImage)
+	
+	const int width = pInputImage->width;
+	const int height = pInputImage->height;
+	const int nWords = pInputImage->stride;
+	
+	for (int y = 0; y < height; y++)
+	{
+		const BinaryImageWord *input = pInputImage->words + y * nWords;
+		unsigned char *output = pOutputImage->pixels + y * pOutputImage->GetStride();
+		
+		for (int i = 0, x = 0; i < nWords; i++, x += 64)
+		{
+			const int n = MY_MIN(64, width - x);
+			const BinaryImageWord word = input[i];
+			
+			for (int j = 0; j < n; j++)
+				output[x + j] = (unsigned char) (0 - int((word >> j) & 1));
+		}
+	}
+	
+	OPTIMIZED_FUNCTION_FOOTER
+	
+	return true;
+}
+
+bool ImageProcessor::And(const CBinaryImage *pInputImage1, const CBinaryImage *pInputImage2, CBinaryImage *pOutputImage)
+{
+	if (!pInputImage1->IsCompatible(pInputImage2) || !pInputImage1->IsCompatible(pOutputImage))
+	{
+		printf("error: input images and output image do not match for ImageProcessor::And\n");
+		return false;
+	}
+	
+	const int nWords = pInputImage1->stride * pInputImage1->height;
+	const BinaryImageWord *input1 = pInputImage1->words;
+	const BinaryImageWord *input2 = pInputImage2->words;
+	BinaryImageWord *output = pOutputImage->words;
+	
+	for (int i = 0; i < nWords; i++)
+		output[i] = input1[i] & input2[i];
+	
+	return true;
+}
+
+bool ImageProcessor::Xor(const CBinaryImage *pInputImage1, const CBinaryImage *pInputImage2, CBinaryImage *pOutputImage)
+{
+	if (!pInputImage1->IsCompatible(pInputImage2) || !pInputImage1->IsCompatible(pOutputImage))
+	{
+		printf("error: input images and output image do not match for ImageProcessor::Xor\n");
+		return false;
+	}
+	
+	const int nWords = pInputImage1->stride * pInputImage1->height;
+	const BinaryImageWord *input1 = pInputImage1->words;
+	const BinaryImageWord *input2 = pInputImage2->words;
+	BinaryImageWord *output = pOutputImage->words;
+	
+	for (int i = 0; i < nWords; i++)
+		output[i] = input1[i] ^ input2[i];
+	
+	return true;
+}
+
+bool ImageProcessor::Or(const CBinaryImage *pInputImage1, const CBinaryImage *pInputImage2, CBinaryImage *pOutputImage)
+{
+	if (!pInputImage1->IsCompatible(pInputImage2) || !pInputImage1->IsCompatible(pOutputImage))
+	{
+		printf("error: input images and output image do not match for ImageProcessor::Or\n");
+		return false;
+	}
+	
+	const int nWords = pInputImage1->stride * pInputImage1->height;
+	const BinaryImageWord *input1 = pInputImage1->words;
+	const BinaryImageWord *input2 = pInputImage2->words;
+	BinaryImageWord *output = pOutputImage->words;
+	
+	for (int i = 0; i < nWords; i++)
+		output[i] = input1[i] | input2[i];
+	
+	return true;
+}
+
+bool ImageProcessor::Invert(const CBinaryImage *pInputImage, CBinaryImage *pOutputImage)
+{
+	if (!pInputImage->IsCompatible(pOutputImage))
+	{
+		printf("error: input and output image do not match for ImageProcessor::Invert\n");
+		return false;
+	}
+	
+	const int nWords = pInputImage->stride;
+	const BinaryImageWord mask = pInputImage->GetLastWordMask();
+	
+	for (int y = 0; y < pInputImage->height; y++)
+	{
+		const BinaryImageWord *input = pInputImage->words + y * nWords;
+		BinaryImageWord *output = pOutputImage->words + y * nWords;
+		
+		for (int i = 0; i < nWords; i++)
+			output[i] = ~input[i];
+		
+		output[nWords - 1] &= mask;
+	}
+	
+	return true;
+}
+
+static inline int CountBits(BinaryImageWord x)
+{
+	x = x - ((x >> 1) & 0x5555555555555555ULL);
+	x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+	x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+	return int((x * 0x0101010101010101ULL) >> 56);
+}
+
+int ImageProcessor::CountPixels(const CBinaryImage *pImage)
+{
+	const int nWords = pImage->stride * pImage->height;
+	const BinaryImageWord *words = pImage->words;
+	int nPixels = 0;
+	
+	for (int i = 0; i < nWords; i++)
+		nPixels += CountBits(words[i]);
+	
+	return nPixels;
+}
+
+// sets the bits of the pixels min_x..max_x in the row mask pMask
+static void CalculateColumnMask(BinaryImageWord *pMask, int nWords, int min_x, int max_x)
+{
+	for (int i = 0; i < nWords; i++)
+	{
+		const int first = MY_MAX(min_x - 64 * i, 0);
+		const int last = MY_MIN(max_x - 64 * i, 63);
 		
-		const int x = offset % width;
-		const int y = offset / width;
-
-		bool bTake = true;
+		if (first > last)
+			pMask[i] = 0;
+		else
+			pMask[i] = (~BinaryImageWord(0) >> (63 - last)) & (~BinaryImageWord(0) << first);
+	}
+}
 
-		const int minx = x - nMinDistance < 0 ? 0 : x - nMinDistance;
-		const int miny = y - nMinDistance < 0 ? 0 : y - nMinDistance;
-		const int maxx = x + nMinDistance >= width ? width - 1 : x + nMinDistance;
-		const int maxy = y + nMinDistance >= height ? height - 1 : y + nMinDistance;
-		const int diff = width - (maxx - minx + 1);
+// bit x of the result holds the pixel x - 1 and x + 1, respectively
+#define BINARY_IMAGE_WEST(row, i, nWords) (((row)[i] << 1) | ((i) > 0 ? (row)[(i) - 1] >> 63 : 0))
+#define BINARY_IMAGE_EAST(row, i, nWords) (((row)[i] >> 1) | ((i) + 1 < (nWords) ? (row)[(i) + 1] << 63 : 0))
 
-		for (int l = miny, offset2 = miny * width + minx; l <= maxy; l++, offset2 += diff)
-			for (int k = minx; k <= maxx; k++, offset2++)
-				if (image.pixels[l * width + k])
+// Dilate: OR of the horizontal 3-neighborhoods of the rows y - 1, y, y + 1, with only the pixels
+// that are not at the image border as input. Erode: AND of the same neighborhoods, with only the
+// pixels that are not at the image border as output. Each output row is written after the input
+// rows it depends on have been read, so that the operation works in-place.
+static bool Morphology3x3(const CBinaryImage *pInputImage, CBinaryImage *pOutputImage, bool bDilate)
+{
+	const int height = pInputImage->height;
+	const int nWords = pInputImage->stride;
+	
+	BinaryImageWord *pBuffer = new BinaryImageWord[5 * nWords];
+	BinaryImageWord *pColumnMask = pBuffer;
+	BinaryImageWord *pMaskedRow = pBuffer + nWords;
+	BinaryImageWord *pRows[3] = { pBuffer + 2 * nWords, pBuffer + 3 * nWords, pBuffer + 4 * nWords };
+	
+	CalculateColumnMask(pColumnMask, nWords, 1, pInputImage->width - 2);
+	
+	const BinaryImageWord empty = bDilate ? 0 : ~BinaryImageWord(0);
+	int i, y;
+	
+	// pRows[y % 3] holds the horizontal neighborhood of row y
+	for (y = -1; y < height; y++)
+	{
+		const int next_y = y + 1;
+		BinaryImageWord *h = pRows[(next_y + 3) % 3];
+		
+		if (next_y < height)
+		{
+			const BinaryImageWord *input = pInputImage->words + next_y * nWords;
+			
+			if (bDilate)
+			{
+				if (next_y >= 1 && next_y <= height - 2)
 				{
-					bTake = false;
-					break;
+					for (i = 0; i < nWords; i++)
+						pMaskedRow[i] = input[i] & pColumnMask[i];
 				}
-
-		if (bTake)
+				else
+				{
+					memset(pMaskedRow, 0, nWords * sizeof(BinaryImageWord));
+				}
+				
+				for (i = 0; i < nWords; i++)
+					h[i] = pMaskedRow[i] | BINARY_IMAGE_WEST(pMaskedRow, i, nWords) | BINARY_IMAGE_EAST(pMaskedRow, i, nWords);
+			}
+			else
+			{
+				for (i = 0; i < nWords; i++)
+					h[i] = input[i] & BINARY_IMAGE_WEST(input, i, nWords) & BINARY_IMAGE_EAST(input, i, nWords);
+			}
+		}
+		
+		if (y < 0)
+			continue;
+		
+		BinaryImageWord *output = pOutputImage->words + y * nWords;
+		
+		if (!bDilate && (y == 0 || y == height - 1))
 		{
-			// store  point
-			pInterestPoints[nInterestPoints].x = float(x);
-			pInterestPoints[nInterestPoints].y = float(y);
-			nInterestPoints++;
-
-			// mark location in grid for distance constraint check
-			image.pixels[offset] = 1;
+			memset(output, 0, nWords * sizeof(BinaryImageWord));
+			continue;
+		}
+		
+		const BinaryImageWord *above = y > 0 ? pRows[(y - 1 + 3) % 3] : 0;
+		const BinaryImageWord *center = pRows[y % 3];
+		const BinaryImageWord *below = next_y < height ? pRows[next_y % 3] : 0;
+		
+		for (i = 0; i < nWords; i++)
+		{
+			const BinaryImageWord a = above ? above[i] : empty;
+			const BinaryImageWord b = below ? below[i] : empty;
+			
+			if (bDilate)
+				output[i] = a | center[i] | b;
+			else
+				output[i] = a & center[i] & b & pColumnMask[i];
 		}
 	}
-
-	delete [] pCandidateOffsets;
 	
-	return nInterestPoints;
+	delete [] pBuffer;
+	
+	return true;
 }
 
-
-bool ImageProcessor::And(const CByteImage *pInputImage1, const CByteImage *pInputImage2, CByteImage *pOutputImage)
+bool ImageProcessor::Dilate(const CBinaryImage *pInputImage, CBinaryImage *pOutputImage)
 {
-	OPTIMIZED_FUNCTION_HEADER_3(And, pInputImage1, pInputImage2, pOutputImage)
-	
-	if (!pInputImage1->IsCompatible(pInputImage2) || !pInputImage1->IsCompatible(pOutputImage))
+	if (!pInputImage->IsCompatible(pOutputImage))
 	{
-		printf("error: input images and output image do not match for ImageProcessor::And\n");
+		printf("error: input and output image do not match for ImageProcessor::Dilate\n");
 		return false;
 	}
 	
-	const int nBytes = pInputImage1->width * pInputImage1->height * pInputImage1->bytesPerPixel;
-	
-	const unsigned char *input1 = pInputImage1->pixels;
-	const unsigned char *input2 = pInputImage2->pixels;
-	unsigned char *output = pOutputImage->pixels;
-	for (int i = 0; i < nBytes; i++)
-		output[i] = input1[i] & input2[i];
-	
-	OPTIMIZED_FUNCTION_FOOTER
-
-	return true;
+	return Morphology3x3(pInputImage, pOutputImage, true);
 }
 
-bool ImageProcessor::Xor(const CByteImage *pInputImage1, const CByteImage *pInputImage2, CByteImage *pOutputImage)
+bool ImageProcessor::Erode(const CBinaryImage *pInputImage, CBinaryImage *pOutputImage)
 {
-	OPTIMIZED_FUNCTION_HEADER_3(Xor, pInputImage1, pInputImage2, pOutputImage)
-	
-	if (!pInputImage1->IsCompatible(pInputImage2) || !pInputImage1->IsCompatible(pOutputImage))
+	if (!pInputImage->IsCompatible(pOutputImage))
 	{
-		printf("error: input images and output image do not match for ImageProcessor::Xor\n");
+		printf("error: input and output image do not match for ImageProcessor::Erode\n");
 		return false;
 	}
 	
-	const int nBytes = pInputImage1->width * pInputImage1->height * pInputImage1->bytesPerPixel;
-	
-	const unsigned char *input1 = pInputImage1->pixels;
-	const unsigned char *input2 = pInputImage2->pixels;
-	unsigned char *output = pOutputImage->pixels;
-	for (int i = 0; i < nBytes; i++)
-		output[i] = input1[i] ^ input2[i];
-	
-	OPTIMIZED_FUNCTION_FOOTER
-
-	return true;
+	return Morphology3x3(pInputImage, pOutputImage, false);
 }
 
-bool ImageProcessor::Or(const CByteImage *pInputImage1, const CByteImage *pInputImage2, CByteImage *pOutputImage)
+bool ImageProcessor::CalculateGradientImageBinary(const CBinaryImage *pInputImage, CBinaryImage *pOutputImage)
 {
-	OPTIMIZED_FUNCTION_HEADER_3(Or, pInputImage1, pInputImage2, pOutputImage)
-	
-	if (!pInputImage1->IsCompatible(pInputImage2) || !pInputImage1->IsCompatible(pOutputImage))
+	if (!pInputImage->IsCompatible(pOutputImage))
 	{
-		printf("error: input images and output image do not match for ImageProcessor::Or\n");
+		printf("error: input and output image do not match for ImageProcessor::CalculateGradientImageBinary\n");
 		return false;
 	}
 	
-	const int nBytes = pInputImage1->width * pInputImage1->height * pInputImage1->bytesPerPixel;
+	const int height = pInputImage->height;
+	const int nWords = pInputImage->stride;
 	
-	const unsigned char *input1 = pInputImage1->pixels;
-	const unsigned char *input2 = pInputImage2->pixels;
-	unsigned char *output = pOutputImage->pixels;
-	for (int i = 0; i < nBytes; i++)
-		output[i] = input1[i] | input2[i];
+	if (height == 0 || nWords == 0)
+		return true;
+	
+	// the last column is set to 0
+	BinaryImageWord *pColumnMask = new BinaryImageWord[nWords];
+	CalculateColumnMask(pColumnMask, nWords, 0, pInputImage->width - 2);
+	
+	// row y only depends on the rows y and y + 1 and word i only on the words i and i + 1
+	for (int y = 0; y < height - 1; y++)
+	{
+		const BinaryImageWord *input = pInputImage->words + y * nWords;
+		const BinaryImageWord *input_below = input + nWords;
+		BinaryImageWord *output = pOutputImage->words + y * nWords;
+		
+		for (int i = 0; i < nWords; i++)
+		{
+			const BinaryImageWord center = input[i];
+			output[i] = ((center ^ BINARY_IMAGE_EAST(input, i, nWords)) | (center ^ input_below[i])) & pColumnMask[i];
+		}
+	}
+	
+	memset(pOutputImage->words + (height - 1) * nWords, 0, nWords * sizeof(BinaryImageWord));
+	
+	delete [] pColumnMask;
 	
-	OPTIMIZED_FUNCTION_FOOTER
-
 	return true;
 }
 
 
+struct AddOperation
+{
+	bool operator()(const CByteImage *pInputImage1, const CByteImage *pInputImage2, CByteImage *pOutputImage) const { return ImageProcessor::Add(pInputImage1, pInputImage2, pOutputImage); }
+};
+
 bool ImageProcessor::Add(const CByteImage *pInputImage1, const CByteImage *pInputImage2, CByteImage *pOutputImage)
 {
+	bool bResult;
+	if (ProcessInRowBands(AddOperation(), pInputImage1, pInputImage2, pOutputImage, bResult))
+		return bResult;
+	
 	OPTIMIZED_FUNCTION_HEADER_3(Add, pInputImage1, pInputImage2, pOutputImage)
 	
 	if (!pInputImage1->IsCompatible(pInputImage2) || !pInputImage1->IsCompatible(pOutputImage))
@@ -7084,22 +8713,35 @@ bool ImageProcessor::Add(const CByteImage *pInputImage1, const CByteImage *pInpu
 		return false;
 	}
 	
-	const int nBytes = pInputImage1->width * pInputImage1->height * pInputImage1->bytesPerPixel;
+	const int nRows = GetRows(pInputImage1);
+	const int nRowBytes = GetRowBytes(pInputImage1);
 	
-	const unsigned char *input1 = pInputImage1->pixels;
-	const unsigned char *input2 = pInputImage2->pixels;
-	unsigned char *output = pOutputImage->pixels;
-
-	for (int i = 0; i < nBytes; i++)
-		output[i] = input1[i] + input2[i];
+	for (int y = 0; y < nRows; y++)
+	{
+		const unsigned char *input1 = pInputImage1->pixels + y * pInputImage1->GetStride();
+		const unsigned char *input2 = pInputImage2->pixels + y * pInputImage2->GetStride();
+		unsigned char *output = pOutputImage->pixels + y * pOutputImage->GetStride();
+		
+		for (int i = 0; i < nRowBytes; i++)
+			output[i] = input1[i] + input2[i];
+	}
 	
 	OPTIMIZED_FUNCTION_FOOTER
 
 	return true;
 }
 
+struct AddWithSaturationOperation
+{
+	bool operator()(const CByteImage *pInputImage1, const CByteImage *pInputImage2, CByteImage *pOutputImage) const { return ImageProcessor::AddWithSaturation(pInputImage1, pInputImage2, pOutputImage); }
+};
+
 bool ImageProcessor::AddWithSaturation(const CByteImage *pInputImage1, const CByteImage *pInputImage2, CByteImage *pOutputImage)
 {
+	bool bResult;
+	if (ProcessInRowBands(AddWithSaturationOperation(), pInputImage1, pInputImage2, pOutputImage, bResult))
+		return bResult;
+	
 	OPTIMIZED_FUNCTION_HEADER_3(AddWithSaturation, pInputImage1, pInputImage2, pOutputImage)
 	
 	if (!pInputImage1->IsCompatible(pInputImage2) || !pInputImage1->IsCompatible(pOutputImage))
@@ -7108,22 +8750,35 @@ bool ImageProcessor::AddWithSaturation(const CByteImage *pInputImage1, const CBy
 		return false;
 	}
 		
-	const int nBytes = pInputImage1->width * pInputImage1->height * pInputImage1->bytesPerPixel;
+	const int nRows = GetRows(pInputImage1);
+	const int nRowBytes = GetRowBytes(pInputImage1);
 	
-	const unsigned char *input1 = pInputImage1->pixels;
-	const unsigned char *input2 = pInputImage2->pixels;
-	unsigned char *output = pOutputImage->pixels;
-
-	for (int i = 0; i < nBytes; i++)
-		output[i] = MY_MIN((unsigned int) input1[i] + (unsigned int) input2[i], 255);
+	for (int y = 0; y < nRows; y++)
+	{
+		const unsigned char *input1 = pInputImage1->pixels + y * pInputImage1->GetStride();
+		const unsigned char *input2 = pInputImage2->pixels + y * pInputImage2->GetStride();
+		unsigned char *output = pOutputImage->pixels + y * pOutputImage->GetStride();
+		
+		for (int i = 0; i < nRowBytes; i++)
+			output[i] = MY_MIN((unsigned int) input1[i] + (unsigned int) input2[i], 255);
+	}
 	
 	OPTIMIZED_FUNCTION_FOOTER
 
 	return true;
 }
 
+struct SubtractOperation
+{
+	bool operator()(const CByteImage *pInputImage1, const CByteImage *pInputImage2, CByteImage *pOutputImage) const { return ImageProcessor::Subtract(pInputImage1, pInputImage2, pOutputImage); }
+};
+
 bool ImageProcessor::Subtract(const CByteImage *pInputImage1, const CByteImage *pInputImage2, CByteImage *pOutputImage)
 {
+	bool bResult;
+	if (ProcessInRowBands(SubtractOperation(), pInputImage1, pInputImage2, pOutputImage, bResult))
+		return bResult;
+	
 	OPTIMIZED_FUNCTION_HEADER_3(Subtract, pInputImage1, pInputImage2, pOutputImage)
 	
 	if (!pInputImage1->IsCompatible(pInputImage2) || !pInputImage1->IsCompatible(pOutputImage))
@@ -7132,22 +8787,35 @@ bool ImageProcessor::Subtract(const CByteImage *pInputImage1, const CByteImage *
 		return false;
 	}
 	
-	const int nBytes = pInputImage1->width * pInputImage1->height * pInputImage1->bytesPerPixel;
-	
-	const unsigned char *input1 = pInputImage1->pixels;
-	const unsigned char *input2 = pInputImage2->pixels;
-	unsigned char *output = pOutputImage->pixels;
+	const int nRows = GetRows(pInputImage1);
+	const int nRowBytes = GetRowBytes(pInputImage1);
 	
-	for (int i = 0; i < nBytes; i++)
-		output[i] = input1[i] - input2[i];
+	for (int y = 0; y < nRows; y++)
+	{
+		const unsigned char *input1 = pInputImage1->pixels + y * pInputImage1->GetStride();
+		const unsigned char *input2 = pInputImage2->pixels + y * pInputImage2->GetStride();
+		unsigned char *output = pOutputImage->pixels + y * pOutputImage->GetStride();
+		
+		for (int i = 0; i < nRowBytes; i++)
+			output[i] = input1[i] - input2[i];
+	}
 	
 	OPTIMIZED_FUNCTION_FOOTER
 
 	return true;
 }
 
+struct SubtractWithSaturationOperation
+{
+	bool operator()(const CByteImage *pInputImage1, const CByteImage *pInputImage2, CByteImage *pOutputImage) const { return ImageProcessor::SubtractWithSaturation(pInputImage1, pInputImage2, pOutputImage); }
+};
+
 bool ImageProcessor::SubtractWithSaturation(const CByteImage *pInputImage1, const CByteImage *pInputImage2, CByteImage *pOutputImage)
 {
+	bool bResult;
+	if (ProcessInRowBands(SubtractWithSaturationOperation(), pInputImage1, pInputImage2, pOutputImage, bResult))
+		return bResult;
+	
 	OPTIMIZED_FUNCTION_HEADER_3(SubtractWithSaturation, pInputImage1, pInputImage2, pOutputImage)
 	
 	if (!pInputImage1->IsCompatible(pInputImage2) || !pInputImage1->IsCompatible(pOutputImage))
@@ -7156,22 +8824,35 @@ bool ImageProcessor::SubtractWithSaturation(const CByteImage *pInputImage1, cons
 		return false;
 	}
 	
-	const int nBytes = pInputImage1->width * pInputImage1->height * pInputImage1->bytesPerPixel;
-	
-	const unsigned char *input1 = pInputImage1->pixels;
-	const unsigned char *input2 = pInputImage2->pixels;
-	unsigned char *output = pOutputImage->pixels;
+	const int nRows = GetRows(pInputImage1);
+	const int nRowBytes = GetRowBytes(pInputImage1);
 	
-	for (int i = 0; i < nBytes; i++)
-		output[i] = MY_MAX((int) input1[i] - (int) input2[i], 0);
+	for (int y = 0; y < nRows; y++)
+	{
+		const unsigned char *input1 = pInputImage1->pixels + y * pInputImage1->GetStride();
+		const unsigned char *input2 = pInputImage2->pixels + y * pInputImage2->GetStride();
+		unsigned char *output = pOutputImage->pixels + y * pOutputImage->GetStride();
+		
+		for (int i = 0; i < nRowBytes; i++)
+			output[i] = MY_MAX((int) input1[i] - (int) input2[i], 0);
+	}
 	
 	OPTIMIZED_FUNCTION_FOOTER
 
 	return true;
 }
 
+struct AbsoluteDifferenceOperation
+{
+	bool operator()(const CByteImage *pInputImage1, const CByteImage *pInputImage2, CByteImage *pOutputImage) const { return ImageProcessor::AbsoluteDifference(pInputImage1, pInputImage2, pOutputImage); }
+};
+
 bool ImageProcessor::AbsoluteDifference(const CByteImage *pInputImage1, const CByteImage *pInputImage2, CByteImage *pOutputImage)
 {
+	bool bResult;
+	if (ProcessInRowBands(AbsoluteDifferenceOperation(), pInputImage1, pInputImage2, pOutputImage, bResult))
+		return bResult;
+	
 	OPTIMIZED_FUNCTION_HEADER_3(AbsoluteDifference, pInputImage1, pInputImage2, pOutputImage)
 	
 	if (!pInputImage1->IsCompatible(pInputImage2) || !pInputImage1->IsCompatible(pOutputImage))
@@ -7180,22 +8861,35 @@ bool ImageProcessor::AbsoluteDifference(const CByteImage *pInputImage1, const CB
 		return false;
 	}
 		
-	const int nBytes = pInputImage1->width * pInputImage1->height * pInputImage1->bytesPerPixel;
+	const int nRows = GetRows(pInputImage1);
+	const int nRowBytes = GetRowBytes(pInputImage1);
 	
-	const unsigned char *input1 = pInputImage1->pixels;
-	const unsigned char *input2 = pInputImage2->pixels;
-	unsigned char *output = pOutputImage->pixels;
-	
-	for (int i = 0; i < nBytes; i++)
-		output[i] = abs((int) input1[i] - (int) input2[i]);
+	for (int y = 0; y < nRows; y++)
+	{
+		const unsigned char *input1 = pInputImage1->pixels + y * pInputImage1->GetStride();
+		const unsigned char *input2 = pInputImage2->pixels + y * pInputImage2->GetStride();
+		unsigned char *output = pOutputImage->pixels + y * pOutputImage->GetStride();
+		
+		for (int i = 0; i < nRowBytes; i++)
+			output[i] = abs((int) input1[i] - (int) input2[i]);
+	}
 	
 	OPTIMIZED_FUNCTION_FOOTER
 
 	return true;
 }
 
+struct AverageOperation
+{
+	bool operator()(const CByteImage *pInputImage1, const CByteImage *pInputImage2, CByteImage *pOutputImage) const { return ImageProcessor::Average(pInputImage1, pInputImage2, pOutputImage); }
+};
+
 bool ImageProcessor::Average(const CByteImage *pInputImage1, const CByteImage *pInputImage2, CByteImage *pOutputImage)
 {
+	bool bResult;
+	if (ProcessInRowBands(AverageOperation(), pInputImage1, pInputImage2, pOutputImage, bResult))
+		return bResult;
+	
 	OPTIMIZED_FUNCTION_HEADER_3(Average, pInputImage1, pInputImage2, pOutputImage)
 	
 	if (!pInputImage1->IsCompatible(pInputImage2) || !pInputImage1->IsCompatible(pOutputImage))
@@ -7204,22 +8898,35 @@ bool ImageProcessor::Average(const CByteImage *pInputImage1, const CByteImage *p
 		return false;
 	}
 		
-	const int nBytes = pInputImage1->width * pInputImage1->height * pInputImage1->bytesPerPixel;
-	
-	const unsigned char *input1 = pInputImage1->pixels;
-	const unsigned char *input2 = pInputImage2->pixels;
-	unsigned char *output = pOutputImage->pixels;
+	const int nRows = GetRows(pInputImage1);
+	const int nRowBytes = GetRowBytes(pInputImage1);
 	
-	for (int i = 0; i < nBytes; i++)
-		output[i] = ((unsigned int) input1[i] + (unsigned int) input2[i] + 1) >> 1;
+	for (int y = 0; y < nRows; y++)
+	{
+		const unsigned char *input1 = pInputImage1->pixels + y * pInputImage1->GetStride();
+		const unsigned char *input2 = pInputImage2->pixels + y * pInputImage2->GetStride();
+		unsigned char *output = pOutputImage->pixels + y * pOutputImage->GetStride();
+		
+		for (int i = 0; i < nRowBytes; i++)
+			output[i] = ((unsigned int) input1[i] + (unsigned int) input2[i] + 1) >> 1;
+	}
 	
 	OPTIMIZED_FUNCTION_FOOTER
 
 	return true;
 }
 
+struct MinOperation
+{
+	bool operator()(const CByteImage *pInputImage1, const CByteImage *pInputImage2, CByteImage *pOutputImage) const { return ImageProcessor::Min(pInputImage1, pInputImage2, pOutputImage); }
+};
+
 bool ImageProcessor::Min(const CByteImage *pInputImage1, const CByteImage *pInputImage2, CByteImage *pOutputImage)
 {
+	bool bResult;
+	if (ProcessInRowBands(MinOperation(), pInputImage1, pInputImage2, pOutputImage, bResult))
+		return bResult;
+	
 	OPTIMIZED_FUNCTION_HEADER_3(Min, pInputImage1, pInputImage2, pOutputImage)
 	
 	if (!pInputImage1->IsCompatible(pInputImage2) || !pInputImage1->IsCompatible(pOutputImage))
@@ -7228,22 +8935,35 @@ bool ImageProcessor::Min(const CByteImage *pInputImage1, const CByteImage *pInpu
 		return false;
 	}
 		
-	const int nBytes = pInputImage1->width * pInputImage1->height * pInputImage1->bytesPerPixel;
-	
-	const unsigned char *input1 = pInputImage1->pixels;
-	const unsigned char *input2 = pInputImage2->pixels;
-	unsigned char *output = pOutputImage->pixels;
+	const int nRows = GetRows(pInputImage1);
+	const int nRowBytes = GetRowBytes(pInputImage1);
 	
-	for (int i = 0; i < nBytes; i++)
-		output[i] = MY_MIN(input1[i], input2[i]);
+	for (int y = 0; y < nRows; y++)
+	{
+		const unsigned char *input1 = pInputImage1->pixels + y * pInputImage1->GetStride();
+		const unsigned char *input2 = pInputImage2->pixels + y * pInputImage2->GetStride();
+		unsigned char *output = pOutputImage->pixels + y * pOutputImage->GetStride();
+		
+		for (int i = 0; i < nRowBytes; i++)
+			output[i] = MY_MIN(input1[i], input2[i]);
+	}
 	
 	OPTIMIZED_FUNCTION_FOOTER
 
 	return true;
 }
 
+struct MaxOperation
+{
+	bool operator()(const CByteImage *pInputImage1, const CByteImage *pInputImage2, CByteImage *pOutputImage) const { return ImageProcessor::Max(pInputImage1, pInputImage2, pOutputImage); }
+};
+
 bool ImageProcessor::Max(const CByteImage *pInputImage1, const CByteImage *pInputImage2, CByteImage *pOutputImage)
 {
+	bool bResult;
+	if (ProcessInRowBands(MaxOperation(), pInputImage1, pInputImage2, pOutputImage, bResult))
+		return bResult;
+	
 	OPTIMIZED_FUNCTION_HEADER_3(Max, pInputImage1, pInputImage2, pOutputImage)
 	
 	if (!pInputImage1->IsCompatible(pInputImage2) || !pInputImage1->IsCompatible(pOutputImage))
@@ -7252,14 +8972,18 @@ bool ImageProcessor::Max(const CByteImage *pInputImage1, const CByteImage *pInpu
 		return false;
 	}
 		
-	const int nBytes = pInputImage1->width * pInputImage1->height * pInputImage1->bytesPerPixel;
-	
-	const unsigned char *input1 = pInputImage1->pixels;
-	const unsigned char *input2 = pInputImage2->pixels;
-	unsigned char *output = pOutputImage->pixels;
+	const int nRows = GetRows(pInputImage1);
+	const int nRowBytes = GetRowBytes(pInputImage1);
 	
-	for (int i = 0; i < nBytes; i++)
-		output[i] = MY_MAX(input1[i], input2[i]);
+	for (int y = 0; y < nRows; y++)
+	{
+		const unsigned char *input1 = pInputImage1->pixels + y * pInputImage1->GetStride();
+		const unsigned char *input2 = pInputImage2->pixels + y * pInputImage2->GetStride();
+		unsigned char *output = pOutputImage->pixels + y * pOutputImage->GetStride();
+		
+		for (int i = 0; i < nRowBytes; i++)
+			output[i] = MY_MAX(input1[i], input2[i]);
+	}
 	
 	OPTIMIZED_FUNCTION_FOOTER
 
@@ -7279,14 +9003,19 @@ unsigned char ImageProcessor::MaxValue(const CByteImage *pInputImage)
 		return 0;
 	}
 	
-	const int nPixels = pInputImage->width * pInputImage->height;
-	const unsigned char *input = pInputImage->pixels;
+	const int width = pInputImage->width;
+	const int height = pInputImage->height;
 	max = 0;
 	
-	for (int i = 0; i < nPixels; i++)
+	for (int y = 0; y < height; y++)
 	{
-		if (input[i] > max)
-			max = input[i];
+		const unsigned char *input = pInputImage->pixels + y * pInputImage->GetStride();
+		
+		for (int i = 0; i < width; i++)
+		{
+			if (input[i] > max)
+				max = input[i];
+		}
 	}
 	
 	OPTIMIZED_FUNCTION_FOOTER
@@ -7300,14 +9029,19 @@ short ImageProcessor::MaxValue(const CShortImage *pInputImage)
 	
 	OPTIMIZED_FUNCTION_HEADER_2(MaxValue_Short, pInputImage, max)
 	
-	const int nPixels = pInputImage->width * pInputImage->height;
-	const short *input = pInputImage->pixels;
+	const int width = pInputImage->width;
+	const int height = pInputImage->height;
 	max = SHRT_MIN;
 	
-	for (int i = 0; i < nPixels; i++)
+	for (int y = 0; y < height; y++)
 	{
-		if (input[i] > max)
-			max = input[i];
+		const short *input = pInputImage->pixels + y * pInputImage->GetStride();
+		
+		for (int i = 0; i < width; i++)
+		{
+			if (input[i] > max)
+				max = input[i];
+		}
 	}
 	
 	OPTIMIZED_FUNCTION_FOOTER
@@ -7321,14 +9055,19 @@ int ImageProcessor::MaxValue(const CIntImage *pInputImage)
 	
 	OPTIMIZED_FUNCTION_HEADER_2(MaxValue_Int, pInputImage, max)
 	
-	const int nPixels = pInputImage->width * pInputImage->height;
-	const int *input = pInputImage->pixels;
+	const int width = pInputImage->width;
+	const int height = pInputImage->height;
 	max = INT_MIN;
 	
-	for (int i = 0; i < nPixels; i++)
+	for (int y = 0; y < height; y++)
 	{
-		if (input[i] > max)
-			max = input[i];
+		const int *input = pInputImage->pixels + y * pInputImage->GetStride();
+		
+		for (int i = 0; i < width; i++)
+		{
+			if (input[i] > max)
+				max = input[i];
+		}
 	}
 	
 	OPTIMIZED_FUNCTION_FOOTER
@@ -7348,14 +9087,19 @@ unsigned char ImageProcessor::MinValue(const CByteImage *pInputImage)
 		return 0;
 	}
 	
-	const int nPixels = pInputImage->width * pInputImage->height;
-	const unsigned char *input = pInputImage->pixels;
+	const int width = pInputImage->width;
+	const int height = pInputImage->height;
 	min = 255;
 	
-	for (int i = 0; i < nPixels; i++)
+	for (int y = 0; y < height; y++)
 	{
-		if (input[i] < min)
-			min = input[i];
+		const unsigned char *input = pInputImage->pixels + y * pInputImage->GetStride();
+		
+		for (int i = 0; i < width; i++)
+		{
+			if (input[i] < min)
+				min = input[i];
+		}
 	}
 	
 	OPTIMIZED_FUNCTION_FOOTER
@@ -7369,14 +9113,19 @@ short ImageProcessor::MinValue(const CShortImage *pInputImage)
 	
 	OPTIMIZED_FUNCTION_HEADER_2(MinValue_Short, pInputImage, min)
 	
-	const int nPixels = pInputImage->width * pInputImage->height;
-	const short *input = pInputImage->pixels;
+	const int width = pInputImage->width;
+	const int height = pInputImage->height;
 	min = SHRT_MAX;
 	
-	for (int i = 0; i < nPixels; i++)
+	for (int y = 0; y < height; y++)
 	{
-		if (input[i] < min)
-			min = input[i];
+		const short *input = pInputImage->pixels + y * pInputImage->GetStride();
+		
+		for (int i = 0; i < width; i++)
+		{
+			if (input[i] < min)
+				min = input[i];
+		}
 	}
 	
 	OPTIMIZED_FUNCTION_FOOTER
@@ -7390,14 +9139,19 @@ int ImageProcessor::MinValue(const CIntImage *pInputImage)
 	
 	OPTIMIZED_FUNCTION_HEADER_2(MinValue_Int, pInputImage, min)
 	
-	const int nPixels = pInputImage->width * pInputImage->height;
-	const int *input = pInputImage->pixels;
+	const int width = pInputImage->width;
+	const int height = pInputImage->height;
 	min = INT_MAX;
 	
-	for (int i = 0; i < nPixels; i++)
+	for (int y = 0; y < height; y++)
 	{
-		if (input[i] < min)
-			min = input[i];
+		const int *input = pInputImage->pixels + y * pInputImage->GetStride();
+		
+		for (int i = 0; i < width; i++)
+		{
+			if (input[i] < min)
+				min = input[i];
+		}
 	}
 	
 	OPTIMIZED_FUNCTION_FOOTER
@@ -7415,18 +9169,23 @@ bool ImageProcessor::MinMaxValue(const CByteImage *pInputImage, unsigned char &m
 		return false;
 	}
 	
-	const int nPixels = pInputImage->width * pInputImage->height;
-	const unsigned char *input = pInputImage->pixels;
+	const int width = pInputImage->width;
+	const int height = pInputImage->height;
 	min = 255;
 	max = 0;
 	
-	for (int i = 0; i < nPixels; i++)
+	for (int y = 0; y < height; y++)
 	{
-		if (input[i] < min)
-			min = input[i];
+		const unsigned char *input = pInputImage->pixels + y * pInputImage->GetStride();
+		
+		for (int i = 0; i < width; i++)
+		{
+			if (input[i] < min)
+				min = input[i];
 		
-		if (input[i] > max)
-			max = input[i];
+			if (input[i] > max)
+				max = input[i];
+		}
 	}
 	
 	OPTIMIZED_FUNCTION_FOOTER
@@ -7438,18 +9197,23 @@ void ImageProcessor::MinMaxValue(const CShortImage *pInputImage, short &min, sho
 {
 	OPTIMIZED_FUNCTION_HEADER_3(MinMaxValue_Short, pInputImage, min, max)
 	
-	const int nPixels = pInputImage->width * pInputImage->height;
-	const short *input = pInputImage->pixels;
+	const int width = pInputImage->width;
+	const int height = pInputImage->height;
 	min = SHRT_MAX;
 	max = SHRT_MIN;
 	
-	for (int i = 0; i < nPixels; i++)
+	for (int y = 0; y < height; y++)
 	{
-		if (input[i] < min)
-			min = input[i];
+		const short *input = pInputImage->pixels + y * pInputImage->GetStride();
 		
-		if (input[i] > max)
-			max = input[i];
+		for (int i = 0; i < width; i++)
+		{
+			if (input[i] < min)
+				min = input[i];
+		
+			if (input[i] > max)
+				max = input[i];
+		}
 	}
 	
 	OPTIMIZED_FUNCTION_FOOTER
@@ -7459,18 +9223,23 @@ void ImageProcessor::MinMaxValue(const CIntImage *pInputImage, int &min, int &ma
 {
 	OPTIMIZED_FUNCTION_HEADER_3(MinMaxValue_Int, pInputImage, min, max)
 	
-	const int nPixels = pInputImage->width * pInputImage->height;
-	const int *input = pInputImage->pixels;
+	const int width = pInputImage->width;
+	const int height = pInputImage->height;
 	min = INT_MAX;
 	max = INT_MIN;
 	
-	for (int i = 0; i < nPixels; i++)
+	for (int y = 0; y < height; y++)
 	{
-		if (input[i] < min)
-			min = input[i];
+		const int *input = pInputImage->pixels + y * pInputImage->GetStride();
+		
+		for (int i = 0; i < width; i++)
+		{
+			if (input[i] < min)
+				min = input[i];
 		
-		if (input[i] > max)
-			max = input[i];
+			if (input[i] > max)
+				max = input[i];
+		}
 	}
 	
 	OPTIMIZED_FUNCTION_FOOTER
@@ -7489,11 +9258,16 @@ unsigned int ImageProcessor::PixelSum(const CByteImage *pImage)
 		return -1;
 	}
 
-	const int nPixels = pImage->width * pImage->height;
-	const unsigned char *pixels = pImage->pixels;
+	const int width = pImage->width;
+	const int height = pImage->height;
 	
-	for (int i = 0; i < nPixels; i++)
+	for (int y = 0; y < height; y++)
+	{
+		const unsigned char *pixels = pImage->pixels + y * pImage->GetStride();
+		
+		for (int i = 0; i < width; i++)
 		sum += pixels[i];
+	}
 
 	OPTIMIZED_FUNCTION_FOOTER
 	
@@ -7545,8 +9319,27 @@ unsigned int ImageProcessor::PixelSum(const CByteImage *pImage)
 // the use of this software, even if advised of the possibility of such damage.
 ////////////////////////////////////////////////////////////////////////////////////////
 
+struct ConvertBayerPatternOperation
+{
+	ConvertBayerPatternOperation(ImageProcessor::BayerPatternType type) : type(type) { }
+	
+	bool operator()(const CByteImage *pBayerImage, CByteImage *pOutputImage) const { return ImageProcessor::ConvertBayerPattern(pBayerImage, pOutputImage, type); }
+	
+	ImageProcessor::BayerPatternType type;
+};
+
 bool ImageProcessor::ConvertBayerPattern(const CByteImage *pBayerImage, CByteImage *pOutputImage, BayerPatternType type)
 {
+	bool bResult;
+	if (ProcessInRowBands(ConvertBayerPatternOperation(type), pBayerImage, pOutputImage, 3, bResult, 2))
+		return bResult;
+	
+	if (pBayerImage->IsPadded() || pOutputImage->IsPadded())
+	{
+		CUnpaddedImage<CByteImage> bayerImage(pBayerImage), output(pOutputImage, true);
+		return ConvertBayerPattern(bayerImage, output, type);
+	}
+	
 	if (pBayerImage->type != CByteImage::eGrayScale || pOutputImage->type != CByteImage::eRGB24)
 	{
 		printf("error: input image must be of type eGrayScale and output image of type eRGB24 for ImageProcessor::ConvertBayerPattern\n");
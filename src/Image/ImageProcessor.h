@@ -69,6 +69,7 @@ class CRGBColorModel;
 class CByteImage;
 class CShortImage;
 class CIntImage;
+class CBinaryImage;
 class CFloatImage;
 class CColorParameterSet;
 struct Mat3d;
@@ -85,11 +86,16 @@ struct Mat3d;
 	\brief Central namespace offering various image processing routines and functions.
 	
 	The ImageProcessor namespace provides various image processing functions, mostly operating on
-	instances of CByteImage, but also CShortImage and CIntImage, and conversion functions between these types.
+	instances of CByteImage, but also CShortImage, CIntImage and CBinaryImage, and conversion functions between these types.
 	Among the offered functions are filtering (edge filters, smoothing filters), color segmentation,
 	edge detection, corner detection, line/circle detection, histogram-based operators, morphological operators,
 	arithmetic operators, logical operators, affine point operators, homography transformations, resize,
 	thresholding and region growing.
+	
+	The pixel-wise and filtering functions (smoothing and edge filters, GeneralFilter, Dilate/Erode, HSV conversion and filtering,
+	Bayer pattern conversion, Resize, ApplyHomography, thresholding and the arithmetic and logical operators) process the image in
+	row bands on multiple cores if the worker pool has been enabled with Threading::SetNumberOfWorkerThreads (disabled by default).
+	The results are identical to the results of the single-threaded computation.
 */
 namespace ImageProcessor
 {
@@ -215,6 +221,32 @@ namespace ImageProcessor
 	*/
 	bool ConvertImage(const CByteImage *pInputImage, CIntImage *pOutputImage);
 	
+	/*!
+		\brief Converts a grayscale CByteImage to a CBinaryImage.
+	 
+		Pixels with a non-zero value are set to 1, all other pixels are set to 0.
+	
+		The width and height of pInputImage and pOutputImage must match.<br>
+		pInputImage must be of type CByteImage::eGrayScale.
+	 
+		@param pInputImage The input image.
+		@param pOutputImage The output image.
+	*/
+	bool ConvertImage(const CByteImage *pInputImage, CBinaryImage *pOutputImage);
+	
+	/*!
+		\brief Converts a CBinaryImage to a grayscale CByteImage.
+	 
+		Pixels with the value 1 are set to 255, all other pixels are set to 0.
+	
+		The width and height of pInputImage and pOutputImage must match.<br>
+		pOutputImage must be of type CByteImage::eGrayScale.
+	 
+		@param pInputImage The input image.
+		@param pOutputImage The output image.
+	*/
+	bool ConvertImage(const CBinaryImage *pInputImage, CByteImage *pOutputImage);
+	
 	/*!
 		\brief Converts a CFloatMatrix to a CDoubleMatrix.
 
@@ -846,6 +878,19 @@ namespace ImageProcessor
 	*/
 	bool CalculateGradientImageBinary(const CByteImage *pInputImage, CByteImage *pOutputImage);
 
+	/*!
+		\brief Calculates the gradient image of a CBinaryImage and writes the result to a CBinaryImage.
+		
+		Computes the same result as CalculateGradientImageBinary(const CByteImage*, CByteImage*) with 64 pixels per operation:
+		a pixel is set if it differs from its right or its bottom neighbor. The last column and the last row are set to 0.
+		
+		The width and height of pInputImage and pOutputImage must match. pInputImage and pOutputImage may share the same memory area.
+	 
+		@param pInputImage The input image.
+		@param pOutputImage The output image.
+	*/
+	bool CalculateGradientImageBinary(const CBinaryImage *pInputImage, CBinaryImage *pOutputImage);
+
 
 	/*!
 		\brief Applies an affine point operation to a CByteImage and writes the result to a CByteImage.
@@ -1180,6 +1225,16 @@ namespace ImageProcessor
 	*/
 	bool Invert(const CByteImage *pInputImage, CByteImage *pOutputImage);
 
+	/*!
+		\brief Calculates the inverted image of a CBinaryImage and writes the result to a CBinaryImage.
+		
+		The width and height of pInputImage and pOutputImage must match.
+		
+		@param pInputImage The input image.
+		@param pOutputImage The output image.
+	*/
+	bool Invert(const CBinaryImage *pInputImage, CBinaryImage *pOutputImage);
+
 	/*!
 		\brief Multiplies each byte value of a CByteImage with a floating point factor and writes the result to a CByteImage.
 	 
@@ -1396,6 +1451,47 @@ namespace ImageProcessor
 	*/
 	bool Or(const CByteImage *pInputImage1, const CByteImage *pInputImage2, CByteImage *pOutputImage);
 
+	/*!
+		\brief Applies the operator AND to two instances of CBinaryImage and writes the result to a CBinaryImage.
+		
+		The width and height of pInputImage1, pInputImage2 and pOutputImage must match. The images may share the same memory area.
+
+		@param pInputImage1 The first input image.
+		@param pInputImage2 The second input image.
+		@param pOutputImage The output image.
+	*/
+	bool And(const CBinaryImage *pInputImage1, const CBinaryImage *pInputImage2, CBinaryImage *pOutputImage);
+
+	/*!
+		\brief Applies the operator XOR to two instances of CBinaryImage and writes the result to a CBinaryImage.
+		
+		The width and height of pInputImage1, pInputImage2 and pOutputImage must match. The images may share the same memory area.
+
+		@param pInputImage1 The first input image.
+		@param pInputImage2 The second input image.
+		@param pOutputImage The output image.
+	*/
+	bool Xor(const CBinaryImage *pInputImage1, const CBinaryImage *pInputImage2, CBinaryImage *pOutputImage);
+
+	/*!
+		\brief Applies the operator OR to two instances of CBinaryImage and writes the result to a CBinaryImage.
+		
+		The width and height of pInputImage1, pInputImage2 and pOutputImage must match. The images may share the same memory area.
+
+		@param pInputImage1 The first input image.
+		@param pInputImage2 The second input image.
+		@param pOutputImage The output image.
+	*/
+	bool Or(const CBinaryImage *pInputImage1, const CBinaryImage *pInputImage2, CBinaryImage *pOutputImage);
+
+	/*!
+		\brief Counts the pixels of a CBinaryImage that are set.
+		
+		@param pImage The input image.
+		@return The number of pixels with the value 1.
+	*/
+	int CountPixels(const CBinaryImage *pImage);
+
 
 	/*!
 		\brief Applies a morphological dilate operation to a binary CByteImage and writes the result to a binary CByteImage.
@@ -1409,7 +1505,7 @@ namespace ImageProcessor
 
 		@param pInputImage The input image.
 		@param pOutputImage The output image.
-		@param nMaskSize Determines the size of the structure element. A squared structure element of size nMaskSize x nMaskSize is used. nMaskSize must be an uneven number greater or equal 3.
+		@param nMaskSize Determines the size of the structure element. A squared structure element of size nMaskSize x nMaskSize is used. nMaskSize must be an uneven number greater or equal 3. Sizes greater than 3 are computed with Dilate(const CByteImage*, CByteImage*, int, int, StructuringElementType, const MyRegion*).
 		@param pROI Describes the area containing the pixels on which the operation shall be executed. If pROI is 0, then the whole image is processed.
 	*/
 	bool Dilate(const CByteImage *pInputImage, CByteImage *pOutputImage, int nMaskSize = 3, const MyRegion *pROI = 0);
@@ -1426,11 +1522,100 @@ namespace ImageProcessor
 		
 		@param pInputImage The input image.
 		@param pOutputImage The output image.
-		@param nMaskSize Determines the size of the structure element. A squared structure element of size nMaskSize x nMaskSize is used. nMaskSize must be an uneven number greater or equal 3.
+		@param nMaskSize Determines the size of the structure element. A squared structure element of size nMaskSize x nMaskSize is used. nMaskSize must be an uneven number greater or equal 3. Sizes greater than 3 are computed with Erode(const CByteImage*, CByteImage*, int, int, StructuringElementType, const MyRegion*).
 		@param pROI Describes the area containing the pixels on which the operation shall be executed. If pROI is 0, then the whole image is processed.
 	*/
 	bool Erode(const CByteImage *pInputImage, CByteImage *pOutputImage, int nMaskSize = 3, const MyRegion *pROI = 0);
 
+	/*!
+		\brief The shapes of structuring elements supported by the rectangular morphological operators.
+	 
+		eRectangleElement denotes a nMaskWidth x nMaskHeight rectangle, eCrossElement the union of the horizontal line of length nMaskWidth
+		and the vertical line of length nMaskHeight through the center.
+	*/
+	enum StructuringElementType
+	{
+		eRectangleElement,
+		eCrossElement
+	};
+
+	/*!
+		\brief Applies a morphological dilate operation with a rectangular or cross-shaped structure element to a binary CByteImage.
+		
+		The filter is separated into a horizontal and a vertical pass, each computed with the van Herk/Gil-Werman algorithm,
+		so that the computational effort per pixel does not depend on the size of the structure element.
+		Only input pixels for which the structure element fits into the image are considered, as for Dilate(const CByteImage*, CByteImage*, int, const MyRegion*).
+		
+		The width and height of pInputImage and pOutputImage must match.<br>
+		pInputImage and pOutputImage must be both of type CByteImage::eGrayScale and may share the same memory area.
+
+		@param pInputImage The input image.
+		@param pOutputImage The output image.
+		@param nMaskWidth The width of the structure element. Must be an uneven number greater or equal 1.
+		@param nMaskHeight The height of the structure element. Must be an uneven number greater or equal 1.
+		@param element The shape of the structure element.
+		@param pROI If not 0, only the pixels within pROI are written. Their values are identical to the result for the whole image.
+	*/
+	bool Dilate(const CByteImage *pInputImage, CByteImage *pOutputImage, int nMaskWidth, int nMaskHeight, StructuringElementType element, const MyRegion *pROI = 0);
+
+	/*!
+		\brief Applies a morphological erode operation with a rectangular or cross-shaped structure element to a binary CByteImage.
+		
+		The filter is computed as in Dilate(const CByteImage*, CByteImage*, int, int, StructuringElementType, const MyRegion*).
+		Pixels for which the structure element does not fit into the image are set to 0.
+
+		@param pInputImage The input image.
+		@param pOutputImage The output image.
+		@param nMaskWidth The width of the structure element. Must be an uneven number greater or equal 1.
+		@param nMaskHeight The height of the structure element. Must be an uneven number greater or equal 1.
+		@param element The shape of the structure element.
+		@param pROI If not 0, only the pixels within pROI are written. Their values are identical to the result for the whole image.
+	*/
+	bool Erode(const CByteImage *pInputImage, CByteImage *pOutputImage, int nMaskWidth, int nMaskHeight, StructuringElementType element, const MyRegion *pROI = 0);
+
+	/*!
+		\brief Applies a morphological opening (erode followed by dilate) to a binary CByteImage.
+		
+		See Dilate(const CByteImage*, CByteImage*, int, int, StructuringElementType, const MyRegion*) for the parameters.
+		If pROI is not 0, the intermediate result is only computed for the pixels needed by the second operation.
+	*/
+	bool Open(const CByteImage *pInputImage, CByteImage *pOutputImage, int nMaskWidth, int nMaskHeight, StructuringElementType element = eRectangleElement, const MyRegion *pROI = 0);
+
+	/*!
+		\brief Applies a morphological closing (dilate followed by erode) to a binary CByteImage.
+		
+		See Dilate(const CByteImage*, CByteImage*, int, int, StructuringElementType, const MyRegion*) for the parameters.
+		If pROI is not 0, the intermediate result is only computed for the pixels needed by the second operation.
+	*/
+	bool Close(const CByteImage *pInputImage, CByteImage *pOutputImage, int nMaskWidth, int nMaskHeight, StructuringElementType element = eRectangleElement, const MyRegion *pROI = 0);
+
+	/*!
+		\brief Applies a morphological dilate operation with a 3x3 structure element to a CBinaryImage.
+		
+		Computes the same result as Dilate(const CByteImage*, CByteImage*, int, const MyRegion*) with nMaskSize = 3 for the whole image,
+		i.e. the pixels at the image border are not considered as input pixels.
+		The rows are processed in 64 bit words by combining shifted copies of the three neighboring rows.
+		
+		The width and height of pInputImage and pOutputImage must match. pInputImage and pOutputImage may share the same memory area.
+
+		@param pInputImage The input image.
+		@param pOutputImage The output image.
+	*/
+	bool Dilate(const CBinaryImage *pInputImage, CBinaryImage *pOutputImage);
+
+	/*!
+		\brief Applies a morphological erode operation with a 3x3 structure element to a CBinaryImage.
+		
+		Computes the same result as Erode(const CByteImage*, CByteImage*, int, const MyRegion*) with nMaskSize = 3 for the whole image,
+		i.e. the pixels at the image border are set to 0.
+		
+		The width and height of pInputImage and pOutputImage must match. pInputImage and pOutputImage may share the same memory area.
+
+		@param pInputImage The input image.
+		@param pOutputImage The output image.
+	*/
+	bool Erode(const CBinaryImage *pInputImage, CBinaryImage *pOutputImage);
+
 	/*!
 		\brief Performs a region growing on a binary CByteImage on the basis of one seed point and stores the computed region in a MyRegion.
 	 
@@ -1457,8 +1642,8 @@ namespace ImageProcessor
 		It is recommended to use the function FindRegions(const CByteImage*, CRegionArray&, int, int, bool, bool) instead. The only difference is the type of the parameter regionList, which is a std::vector<MyRegion> here
 		and a CDynamicArrayTemplate<MyRegion> in the other case, which is more efficient.
 	 
-		This function chooses every foreground pixel as seed point and performs a region growing (4-connectivity) by calling the function RegionGrowing(const CByteImage*, MyRegion&, int, int, int, int, bool, bool).
-		Already visited pixels are marked so that only not unvisited pixels can serve as seed points.
+		The regions (4-connectivity) are computed by connected component labeling with union-find, see FindRegions(const CByteImage*, CIntImage*, CRegionArray&, int, int, bool, bool).
+		The regions are sorted by the position of their first pixel in the image (row by row), which is also stored in MyRegion::nSeedOffset.
 	 
 		The input image is assumed to encode background with the value 0 and foreground with the value 255.
 
@@ -1474,8 +1659,8 @@ namespace ImageProcessor
 	/*!
 		\brief Performs region growing on a binary CByteImage, segmenting all regions in the image.
 	 	 
-		This function chooses every foreground pixel as seed point and performs a region growing (4-connectivity) by calling the function RegionGrowing(const CByteImage*, MyRegion&, int, int, int, int, bool, bool).
-		Already visited pixels are marked so that only not unvisited pixels can serve as seed points.
+		The regions (4-connectivity) are computed by connected component labeling with union-find, see FindRegions(const CByteImage*, CIntImage*, CRegionArray&, int, int, bool, bool).
+		The regions are sorted by the position of their first pixel in the image (row by row), which is also stored in MyRegion::nSeedOffset.
 	 
 		The input image is assumed to encode background with the value 0 and foreground with the value 255.
 	 
@@ -1488,6 +1673,60 @@ namespace ImageProcessor
 	*/
 	bool FindRegions(const CByteImage *pImage, CRegionArray &regionList, int nMinimumPointsPerRegion = 0, int nMaximumPointsPerRegion = 0, bool bCalculateBoundingBox = true, bool bStorePixels = false);
 
+	/*!
+		\brief Segments all regions of a binary CByteImage and computes a label image.
+	 	 
+		The regions (4-connectivity) are computed by connected component labeling with union-find in two passes over the image:
+		the first pass assigns provisional labels and accumulates the region statistics (number of pixels, centroid, bounding box),
+		the second pass writes the label image and the pixel lists.
+		If the worker pool is enabled (see Threading::SetNumberOfWorkerThreads), the first pass is processed in stripes of rows in parallel,
+		which are merged afterwards. The result does not depend on the number of threads.
+		
+		The regions are sorted by the position of their first pixel in the image (row by row), which is also stored in MyRegion::nSeedOffset.
+		The pixels of each region (see bStorePixels) are stored in row-major order.
+	 
+		The input image is assumed to encode background with the value 0 and foreground with the value 255.
+	 
+		@param pImage The input image. Must be a binary image of type CByteImage::eGrayScale.
+		@param pLabelImage The output label image. Must have the same size as pImage. The pixels of the region regionList[i] are set to i + 1,
+		all other pixels (background and regions not fulfilling the size constraints) are set to 0.
+		@param regionList The list of regions. CRegionArray is a typedef for CDynamicArrayTemplate<MyRegion>.
+		@param nMinimumPointsPerRegion Specifies the minimum number of pixels the region must contain. The default value nMinimumPointsPerRegion = 0 means that no lower bound is checked.
+		@param nMaximumPointsPerRegion Specifies the maximum number of pixels the region may contain. The default value nMaximumPointsPerRegion = 0 means that no upper bound is checked.
+		@param bCalculateBoundingBox Calculate bounding box (members min_x, min_y, max_x, max_y, ratio of MyRegion) or not.
+		@param bStorePixels Store pixels belonging to the region in the member MyRegion::pPixels. Memory is handled automatically (allocation/deletion). Setting bStorePixels to false saves computation time.
+	*/
+	bool FindRegions(const CByteImage *pImage, CIntImage *pLabelImage, CRegionArray &regionList, int nMinimumPointsPerRegion = 0, int nMaximumPointsPerRegion = 0, bool bCalculateBoundingBox = true, bool bStorePixels = false);
+
+	/*!
+		\brief Segments all regions of a CBinaryImage.
+	 	 
+		Computes the same result as FindRegions(const CByteImage*, CIntImage*, CRegionArray&, int, int, bool, bool) for the corresponding CByteImage.
+		The runs of foreground pixels are extracted word-wise, so that empty areas of the image are skipped 64 pixels at a time.
+	 
+		@param pImage The input image.
+		@param regionList The list of regions. RegionList is a typedef for std::vector<MyRegion>.
+		@param nMinimumPointsPerRegion Specifies the minimum number of pixels the region must contain. The default value nMinimumPointsPerRegion = 0 means that no lower bound is checked.
+		@param nMaximumPointsPerRegion Specifies the maximum number of pixels the region may contain. The default value nMaximumPointsPerRegion = 0 means that no upper bound is checked.
+		@param bCalculateBoundingBox Calculate bounding box (members min_x, min_y, max_x, max_y, ratio of MyRegion) or not.
+		@param bStorePixels Store pixels belonging to the region in the member MyRegion::pPixels.
+	*/
+	bool FindRegions(const CBinaryImage *pImage, RegionList &regionList, int nMinimumPointsPerRegion = 0, int nMaximumPointsPerRegion = 0, bool bCalculateBoundingBox = true, bool bStorePixels = false);
+
+	/*!
+		\brief Segments all regions of a CBinaryImage.
+		
+		See FindRegions(const CBinaryImage*, RegionList&, int, int, bool, bool). CRegionArray is a typedef for CDynamicArrayTemplate<MyRegion>.
+	*/
+	bool FindRegions(const CBinaryImage *pImage, CRegionArray &regionList, int nMinimumPointsPerRegion = 0, int nMaximumPointsPerRegion = 0, bool bCalculateBoundingBox = true, bool bStorePixels = false);
+
+	/*!
+		\brief Segments all regions of a CBinaryImage and computes a label image.
+		
+		See FindRegions(const CByteImage*, CIntImage*, CRegionArray&, int, int, bool, bool). pLabelImage must have the same size as pImage.
+	*/
+	bool FindRegions(const CBinaryImage *pImage, CIntImage *pLabelImage, CRegionArray &regionList, int nMinimumPointsPerRegion = 0, int nMaximumPointsPerRegion = 0, bool bCalculateBoundingBox = true, bool bStorePixels = false);
+
 	/*!
 		\brief Performs the Hough transform for straight lines on a CByteImage.
 	 
@@ -47,6 +47,8 @@
 
 #include "IntImage.h"
 
+#include "Helpers/helpers.h"
+
 
 
 // ****************************************************************************
@@ -57,24 +59,25 @@ CIntImage::CIntImage()
 {
 	width = 0;
 	height = 0;
+	stride = 0;
 	pixels = 0;
 	m_bOwnMemory = false;
 }
 
-CIntImage::CIntImage(int nImageWidth, int nImageHeight, bool bHeaderOnly)
+CIntImage::CIntImage(int nImageWidth, int nImageHeight, bool bHeaderOnly, bool bPadded)
 {
 	width = nImageWidth;
 	height = nImageHeight;
 
 	if (bHeaderOnly)
 	{
+		stride = width;
 		pixels = 0;
 		m_bOwnMemory = false;
 	}
 	else
 	{
-        	pixels = new int[width * height];
-		m_bOwnMemory = true;
+		AllocateMemory(bPadded);
 	}
 }
 
@@ -85,13 +88,13 @@ CIntImage::CIntImage(const CIntImage &image, bool bHeaderOnly)
 	
 	if (bHeaderOnly)
 	{
+		stride = image.stride;
 		pixels = 0;
 		m_bOwnMemory = false;
 	}
 	else
 	{
-		pixels = new int[width * height];
-		m_bOwnMemory = true;
+		AllocateMemory(image.IsPadded());
 	}
 }
 
@@ -102,13 +105,13 @@ CIntImage::CIntImage(const CIntImage *pImage, bool bHeaderOnly)
 	
 	if (bHeaderOnly)
 	{
+		stride = pImage->stride;
 		pixels = 0;
 		m_bOwnMemory = false;
 	}
 	else
 	{
-		pixels = new int[width * height];
-		m_bOwnMemory = true;
+		AllocateMemory(pImage->IsPadded());
 	}
 }
 
@@ -122,12 +125,26 @@ CIntImage::~CIntImage()
 // Methods
 // ****************************************************************************
 
+bool CIntImage::IsPadded() const
+{
+	return stride != 0 && stride != width;
+}
+
+void CIntImage::AllocateMemory(bool bPadded)
+{
+	const int nAlignment = IVT_ROW_ALIGNMENT / sizeof(int);
+	
+	stride = bPadded ? (width + nAlignment - 1) / nAlignment * nAlignment : width;
+	pixels = (int *) aligned_malloc(stride * height * sizeof(int), IVT_ROW_ALIGNMENT);
+	m_bOwnMemory = true;
+}
+
 void CIntImage::FreeMemory()
 {
 	if (pixels)
 	{
 		if (m_bOwnMemory)
-            		delete [] pixels;
+			aligned_free(pixels);
 
 		pixels = 0;
 		m_bOwnMemory = false;
@@ -57,24 +57,31 @@ class CIntImage
 public:
 	// constructors
 	CIntImage();
-	CIntImage(int nImageWidth, int nImageHeight, bool bHeaderOnly = false);
+	CIntImage(int nImageWidth, int nImageHeight, bool bHeaderOnly = false, bool bPadded = false);
 
-	// copy constructors (will copy header and allocate memory)
+	// copy constructors (will copy header including row layout and allocate memory)
 	CIntImage(const CIntImage *pImage, bool bHeaderOnly = false);
 	CIntImage(const CIntImage &image, bool bHeaderOnly = false);
 
 	// destructor
 	~CIntImage();
 
+	// public methods
+	bool IsPadded() const;
+	// distance between two rows, also for headers filled in manually with stride = 0 (unpadded)
+	int GetStride() const { return stride ? stride : width; }
+
 
 	// public attributes - not clean OOP design but easy access
 	int width;
 	int height;
 	int *pixels;
+	int stride; // distance between two rows in pixels (padded rows start at multiples of IVT_ROW_ALIGNMENT bytes)
 
 
 private:
 	// private methods
+	void AllocateMemory(bool bPadded);
 	void FreeMemory();
 
 	// private attributes - only used internally
@@ -69,12 +69,14 @@ IplImage* IplImageAdaptor::Adapt(const CByteImage *pImage, bool bAllocateMemory)
 	if (bAllocateMemory)
 	{
 		pIplImage = cvCreateImage(cvSize(pImage->width, pImage->height), IPL_DEPTH_8U, pImage->bytesPerPixel);
-		memcpy(pIplImage->imageData, pImage->pixels, pImage->width * pImage->height * pImage->bytesPerPixel);
+		
+		for (int y = 0; y < pImage->height; y++)
+			memcpy(pIplImage->imageData + y * pIplImage->widthStep, pImage->pixels + y * pImage->GetStride(), pImage->width * pImage->bytesPerPixel);
 	}
 	else
 	{
 		pIplImage = cvCreateImageHeader(cvSize(pImage->width, pImage->height), IPL_DEPTH_8U, pImage->bytesPerPixel);
-		cvSetImageData(pIplImage, (char *) pImage->pixels, pImage->width * pImage->bytesPerPixel);
+		cvSetImageData(pIplImage, (char *) pImage->pixels, pImage->GetStride());
 	}
 
 	return pIplImage;
@@ -87,12 +89,15 @@ CByteImage* IplImageAdaptor::Adapt(const IplImage *pIplImage, bool bAllocateMemo
 	if (bAllocateMemory)
 	{
 		pImage = new CByteImage(pIplImage->width, pIplImage->height, pIplImage->nChannels == 1 ? CByteImage::eGrayScale : CByteImage::eRGB24);
-		memcpy(pImage->pixels, pIplImage->imageData, pImage->width * pImage->height * pImage->bytesPerPixel);
+		
+		for (int y = 0; y < pImage->height; y++)
+			memcpy(pImage->pixels + y * pImage->GetStride(), pIplImage->imageData + y * pIplImage->widthStep, pImage->width * pImage->bytesPerPixel);
 	}
 	else
 	{
 		pImage = new CByteImage(pIplImage->width, pIplImage->height, pIplImage->nChannels == 1 ? CByteImage::eGrayScale : CByteImage::eRGB24, true);
 		pImage->pixels = (unsigned char *) pIplImage->imageData;
+		pImage->stride = pIplImage->widthStep;
 	}
 
 	return pImage;
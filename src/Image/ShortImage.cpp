@@ -47,6 +47,8 @@
 
 #include "ShortImage.h"
 
+#include "Helpers/helpers.h"
+
 
 
 // ****************************************************************************
@@ -57,24 +59,25 @@ CShortImage::CShortImage()
 {
 	width = 0;
 	height = 0;
+	stride = 0;
 	pixels = 0;
 	m_bOwnMemory = false;
 }
 
-CShortImage::CShortImage(int nImageWidth, int nImageHeight, bool bHeaderOnly)
+CShortImage::CShortImage(int nImageWidth, int nImageHeight, bool bHeaderOnly, bool bPadded)
 {
 	width = nImageWidth;
 	height = nImageHeight;
 
 	if (bHeaderOnly)
 	{
+		stride = width;
 		pixels = 0;
 		m_bOwnMemory = false;
 	}
 	else
 	{
-        pixels = new short[width * height];
-		m_bOwnMemory = true;
+		AllocateMemory(bPadded);
 	}
 }
 
@@ -85,13 +88,13 @@ CShortImage::CShortImage(const CShortImage &image, bool bHeaderOnly)
 	
 	if (bHeaderOnly)
 	{
+		stride = image.stride;
 		pixels = 0;
 		m_bOwnMemory = false;
 	}
 	else
 	{
-		pixels = new short[width * height];
-		m_bOwnMemory = true;
+		AllocateMemory(image.IsPadded());
 	}
 }
 
@@ -102,13 +105,13 @@ CShortImage::CShortImage(const CShortImage *pImage, bool bHeaderOnly)
 	
 	if (bHeaderOnly)
 	{
+		stride = pImage->stride;
 		pixels = 0;
 		m_bOwnMemory = false;
 	}
 	else
 	{
-		pixels = new short[width * height];
-		m_bOwnMemory = true;
+		AllocateMemory(pImage->IsPadded());
 	}
 }
 
@@ -122,12 +125,26 @@ CShortImage::~CShortImage()
 // Methods
 // ****************************************************************************
 
+bool CShortImage::IsPadded() const
+{
+	return stride != 0 && stride != width;
+}
+
+void CShortImage::AllocateMemory(bool bPadded)
+{
+	const int nAlignment = IVT_ROW_ALIGNMENT / sizeof(short);
+	
+	stride = bPadded ? (width + nAlignment - 1) / nAlignment * nAlignment : width;
+	pixels = (short *) aligned_malloc(stride * height * sizeof(short), IVT_ROW_ALIGNMENT);
+	m_bOwnMemory = true;
+}
+
 void CShortImage::FreeMemory()
 {
 	if (pixels)
 	{
 		if (m_bOwnMemory)
-            delete [] pixels;
+			aligned_free(pixels);
 
 		pixels = 0;
 		m_bOwnMemory = false;
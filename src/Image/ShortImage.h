@@ -56,24 +56,31 @@ class CShortImage
 public:
 	// constructors
 	CShortImage();
-	CShortImage(int nImageWidth, int nImageHeight, bool bHeaderOnly = false);
+	CShortImage(int nImageWidth, int nImageHeight, bool bHeaderOnly = false, bool bPadded = false);
 
-	// copy constructors (will copy header and allocate memory)
+	// copy constructors (will copy header including row layout and allocate memory)
 	CShortImage(const CShortImage *pImage, bool bHeaderOnly = false);
 	CShortImage(const CShortImage &image, bool bHeaderOnly = false);
 
 	// destructor
 	~CShortImage();
 
+	// public methods
+	bool IsPadded() const;
+	// distance between two rows, also for headers filled in manually with stride = 0 (unpadded)
+	int GetStride() const { return stride ? stride : width; }
+
 
 	// public attributes - not clean OOP design but easy access
 	int width;
 	int height;
 	short *pixels;
+	int stride; // distance between two rows in pixels (padded rows start at multiples of IVT_ROW_ALIGNMENT bytes)
 
 
 private:
 	// private methods
+	void AllocateMemory(bool bPadded);
 	void FreeMemory();
 
 	// private attributes - only used internally
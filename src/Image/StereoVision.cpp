@@ -53,6 +53,7 @@
 #include "Math/FloatMatrix.h"
 #include "Helpers/OptimizedFunctions.h"
 #include "Helpers/helpers.h"
+#include "Threading/WorkerPool.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -61,6 +62,389 @@
 #include <limits.h>
 
 
+#if defined(USE_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define STEREO_SIMD_AVAILABLE
+#include <emmintrin.h>
+#endif
+
+
+
+// ****************************************************************************
+// Static functions
+// ****************************************************************************
+
+// The window costs of all disparities of a pixel are stored next to each other
+// (padded to a multiple of 16), so that all steps operate on vectors of disparities:
+// the absolute differences of the last nWindowSize rows are kept in a ring buffer,
+// the column sums are updated by adding the new and subtracting the oldest row,
+// and the window sums are updated by adding the new and subtracting the oldest column sum.
+// Column sums and window sums use 16 bit if nWindowSize * nWindowSize * 255 fits, 32 bit otherwise.
+
+struct ProcessFastParameters
+{
+	const CByteImage *pLeftImage;
+	const CByteImage *pRightImage;
+	CByteImage *pDepthImage;
+	
+	int nWindowSize;
+	int nErrorThreshold;
+	const int *pDisparities;
+	int nDisparities;
+	int nPaddedDisparities;
+	int d_step;
+
+	// windows are given by their bottom right pixel (c, r); the result is written to (c - nWindowSize / 2, r - nWindowSize / 2)
+	int c_min;
+	int c_max;
+};
+
+static void CalculateAbsoluteDifferences(const ProcessFastParameters *pParameters, int r, int c_begin, int c_end, unsigned char *pResult)
+{
+	const int nDisparities = pParameters->nDisparities;
+	const int nPaddedDisparities = pParameters->nPaddedDisparities;
+	const int *pDisparities = pParameters->pDisparities;
+	const int width = pParameters->pLeftImage->width;
+
+	const unsigned char *pLeft = pParameters->pLeftImage->pixels + r * pParameters->pLeftImage->GetStride();
+	const unsigned char *pRight = pParameters->pRightImage->pixels + r * pParameters->pRightImage->GetStride();
+
+#ifdef STEREO_SIMD_AVAILABLE
+	if (pParameters->d_step == 1 || pParameters->d_step == -1)
+	{
+		// the right pixels of consecutive disparities are contiguous in memory, in reversed order for d_step = 1
+		unsigned char *pReversed = 0;
+		
+		if (pParameters->d_step == 1)
+		{
+			pReversed = new unsigned char[width];
+			
+			for (int i = 0; i < width; i++)
+				pReversed[i] = pRight[width - 1 - i];
+		}
+
+		const int nFullDisparities = nDisparities & ~15;
+
+		for (int c = c_begin; c < c_end; c++, pResult += nPaddedDisparities)
+		{
+			const __m128i left = _mm_set1_epi8((char) pLeft[c]);
+			const unsigned char *pRightHelper = pReversed ? pReversed + width - 1 - c + pDisparities[0] : pRight + c - pDisparities[0];
+			int k;
+
+			for (k = 0; k < nFullDisparities; k += 16)
+			{
+				const __m128i right = _mm_loadu_si128((const __m128i *) (pRightHelper + k));
+				_mm_storeu_si128((__m128i *) (pResult + k), _mm_or_si128(_mm_subs_epu8(left, right), _mm_subs_epu8(right, left)));
+			}
+
+			for (; k < nDisparities; k++)
+				pResult[k] = (unsigned char) abs(pLeft[c] - pRightHelper[k]);
+
+			for (; k < nPaddedDisparities; k++)
+				pResult[k] = 255;
+		}
+
+		delete [] pReversed;
+
+		return;
+	}
+#endif
+
+	for (int c = c_begin; c < c_end; c++, pResult += nPaddedDisparities)
+	{
+		int k;
+		
+		for (k = 0; k < nDisparities; k++)
+			pResult[k] = (unsigned char) abs(pLeft[c] - pRight[c - pDisparities[k]]);
+
+		for (; k < nPaddedDisparities; k++)
+			pResult[k] = 255;
+	}
+}
+
+// pSum[k] += pAdd[k] - pSubtract[k] (pSubtract may be 0)
+static inline void UpdateColumnSum(unsigned short *pSum, const unsigned char *pAdd, const unsigned char *pSubtract, int nPaddedDisparities)
+{
+#ifdef STEREO_SIMD_AVAILABLE
+	const __m128i zero = _mm_setzero_si128();
+
+	for (int k = 0; k < nPaddedDisparities; k += 16)
+	{
+		const __m128i add = _mm_loadu_si128((const __m128i *) (pAdd + k));
+		__m128i sum0 = _mm_add_epi16(_mm_loadu_si128((const __m128i *) (pSum + k)), _mm_unpacklo_epi8(add, zero));
+		__m128i sum1 = _mm_add_epi16(_mm_loadu_si128((const __m128i *) (pSum + k + 8)), _mm_unpackhi_epi8(add, zero));
+
+		if (pSubtract)
+		{
+			const __m128i subtract = _mm_loadu_si128((const __m128i *) (pSubtract + k));
+			sum0 = _mm_sub_epi16(sum0, _mm_unpacklo_epi8(subtract, zero));
+			sum1 = _mm_sub_epi16(sum1, _mm_unpackhi_epi8(subtract, zero));
+		}
+
+		_mm_storeu_si128((__m128i *) (pSum + k), sum0);
+		_mm_storeu_si128((__m128i *) (pSum + k + 8), sum1);
+	}
+#else
+	for (int k = 0; k < nPaddedDisparities; k++)
+		pSum[k] = (unsigned short) (pSum[k] + pAdd[k] - (pSubtract ? pSubtract[k] : 0));
+#endif
+}
+
+static inline void UpdateColumnSum(int *pSum, const unsigned char *pAdd, const unsigned char *pSubtract, int nPaddedDisparities)
+{
+#ifdef STEREO_SIMD_AVAILABLE
+	const __m128i zero = _mm_setzero_si128();
+
+	for (int k = 0; k < nPaddedDisparities; k += 16)
+	{
+		__m128i add = _mm_loadu_si128((const __m128i *) (pAdd + k));
+		__m128i subtract = pSubtract ? _mm_loadu_si128((const __m128i *) (pSubtract + k)) : zero;
+
+		// differences of 16 bit, sign extended to 32 bit
+		const __m128i diff0 = _mm_sub_epi16(_mm_unpacklo_epi8(add, zero), _mm_unpacklo_epi8(subtract, zero));
+		const __m128i diff1 = _mm_sub_epi16(_mm_unpackhi_epi8(add, zero), _mm_unpackhi_epi8(subtract, zero));
+		const __m128i diffs[4] =
+		{
+			_mm_srai_epi32(_mm_unpacklo_epi16(diff0, diff0), 16), _mm_srai_epi32(_mm_unpackhi_epi16(diff0, diff0), 16),
+			_mm_srai_epi32(_mm_unpacklo_epi16(diff1, diff1), 16), _mm_srai_epi32(_mm_unpackhi_epi16(diff1, diff1), 16)
+		};
+
+		for (int i = 0; i < 4; i++)
+			_mm_storeu_si128((__m128i *) (pSum + k + 4 * i), _mm_add_epi32(_mm_loadu_si128((const __m128i *) (pSum + k + 4 * i)), diffs[i]));
+	}
+#else
+	for (int k = 0; k < nPaddedDisparities; k++)
+		pSum[k] += pAdd[k] - (pSubtract ? pSubtract[k] : 0);
+#endif
+}
+
+// pSum[k] += pAdd[k] - pSubtract[k] (pSubtract may be 0)
+static inline void UpdateWindowSum(unsigned short *pSum, const unsigned short *pAdd, const unsigned short *pSubtract, int nPaddedDisparities)
+{
+#ifdef STEREO_SIMD_AVAILABLE
+	for (int k = 0; k < nPaddedDisparities; k += 8)
+	{
+		__m128i sum = _mm_add_epi16(_mm_loadu_si128((const __m128i *) (pSum + k)), _mm_loadu_si128((const __m128i *) (pAdd + k)));
+		
+		if (pSubtract)
+			sum = _mm_sub_epi16(sum, _mm_loadu_si128((const __m128i *) (pSubtract + k)));
+		
+		_mm_storeu_si128((__m128i *) (pSum + k), sum);
+	}
+#else
+	for (int k = 0; k < nPaddedDisparities; k++)
+		pSum[k] = (unsigned short) (pSum[k] + pAdd[k] - (pSubtract ? pSubtract[k] : 0));
+#endif
+}
+
+static inline void UpdateWindowSum(int *pSum, const int *pAdd, const int *pSubtract, int nPaddedDisparities)
+{
+#ifdef STEREO_SIMD_AVAILABLE
+	for (int k = 0; k < nPaddedDisparities; k += 4)
+	{
+		__m128i sum = _mm_add_epi32(_mm_loadu_si128((const __m128i *) (pSum + k)), _mm_loadu_si128((const __m128i *) (pAdd + k)));
+		
+		if (pSubtract)
+			sum = _mm_sub_epi32(sum, _mm_loadu_si128((const __m128i *) (pSubtract + k)));
+		
+		_mm_storeu_si128((__m128i *) (pSum + k), sum);
+	}
+#else
+	for (int k = 0; k < nPaddedDisparities; k++)
+		pSum[k] += pAdd[k] - (pSubtract ? pSubtract[k] : 0);
+#endif
+}
+
+// returns the minimum of pSum[0..nPaddedDisparities - 1] and its first index
+// (the padded entries are never smaller than the other entries)
+static inline int FindMinimum(const unsigned short *pSum, int nPaddedDisparities, int &nBestIndex)
+{
+#ifdef STEREO_SIMD_AVAILABLE
+	// unsigned comparison by flipping the sign bit
+	const __m128i sign = _mm_set1_epi16((short) 0x8000);
+	const __m128i eight = _mm_set1_epi16(8);
+	__m128i index = _mm_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7);
+	__m128i best = _mm_set1_epi16(0x7fff);
+	__m128i bestIndex = _mm_setzero_si128();
+
+	for (int k = 0; k < nPaddedDisparities; k += 8, index = _mm_add_epi16(index, eight))
+	{
+		const __m128i value = _mm_xor_si128(_mm_loadu_si128((const __m128i *) (pSum + k)), sign);
+		const __m128i mask = _mm_cmplt_epi16(value, best);
+		best = _mm_min_epi16(value, best);
+		bestIndex = _mm_or_si128(_mm_and_si128(mask, index), _mm_andnot_si128(mask, bestIndex));
+	}
+
+	short pBest[8], pBestIndex[8];
+	_mm_storeu_si128((__m128i *) pBest, best);
+	_mm_storeu_si128((__m128i *) pBestIndex, bestIndex);
+
+	int nBest = pBest[0];
+	nBestIndex = pBestIndex[0];
+	
+	for (int i = 1; i < 8; i++)
+	{
+		if (pBest[i] < nBest || (pBest[i] == nBest && pBestIndex[i] < nBestIndex))
+		{
+			nBest = pBest[i];
+			nBestIndex = pBestIndex[i];
+		}
+	}
+
+	return nBest + 32768;
+#else
+	int nBest = pSum[0];
+	nBestIndex = 0;
+
+	for (int k = 1; k < nPaddedDisparities; k++)
+	{
+		if (pSum[k] < nBest)
+		{
+			nBest = pSum[k];
+			nBestIndex = k;
+		}
+	}
+
+	return nBest;
+#endif
+}
+
+static inline int FindMinimum(const int *pSum, int nPaddedDisparities, int &nBestIndex)
+{
+#ifdef STEREO_SIMD_AVAILABLE
+	const __m128i four = _mm_set1_epi32(4);
+	__m128i index = _mm_setr_epi32(0, 1, 2, 3);
+	__m128i best = _mm_set1_epi32(INT_MAX);
+	__m128i bestIndex = _mm_setzero_si128();
+
+	for (int k = 0; k < nPaddedDisparities; k += 4, index = _mm_add_epi32(index, four))
+	{
+		const __m128i value = _mm_loadu_si128((const __m128i *) (pSum + k));
+		const __m128i mask = _mm_cmplt_epi32(value, best);
+		best = _mm_or_si128(_mm_and_si128(mask, value), _mm_andnot_si128(mask, best));
+		bestIndex = _mm_or_si128(_mm_and_si128(mask, index), _mm_andnot_si128(mask, bestIndex));
+	}
+
+	int pBest[4], pBestIndex[4];
+	_mm_storeu_si128((__m128i *) pBest, best);
+	_mm_storeu_si128((__m128i *) pBestIndex, bestIndex);
+
+	int nBest = pBest[0];
+	nBestIndex = pBestIndex[0];
+	
+	for (int i = 1; i < 4; i++)
+	{
+		if (pBest[i] < nBest || (pBest[i] == nBest && pBestIndex[i] < nBestIndex))
+		{
+			nBest = pBest[i];
+			nBestIndex = pBestIndex[i];
+		}
+	}
+
+	return nBest;
+#else
+	int nBest = pSum[0];
+	nBestIndex = 0;
+
+	for (int k = 1; k < nPaddedDisparities; k++)
+	{
+		if (pSum[k] < nBest)
+		{
+			nBest = pSum[k];
+			nBestIndex = k;
+		}
+	}
+
+	return nBest;
+#endif
+}
+
+// processes the windows with bottom row r in [nWindowSize - 1 + nBegin, nWindowSize - 1 + nEnd)
+template <typename TSum>
+static void ProcessFastRows(void *pParameter, int nBegin, int nEnd)
+{
+	const ProcessFastParameters *pParameters = (const ProcessFastParameters *) pParameter;
+	const int nWindowSize = pParameters->nWindowSize;
+	const int nPaddedDisparities = pParameters->nPaddedDisparities;
+	const int c_min = pParameters->c_min;
+	const int c_max = pParameters->c_max;
+	
+	// column range of the absolute differences
+	const int nFirstColumn = c_min - nWindowSize + 1;
+	const int nColumns = c_max - nFirstColumn + 1;
+	const int nRowSize = nColumns * nPaddedDisparities;
+
+	// ring buffer of the absolute differences of the last nWindowSize rows plus one spare row
+	unsigned char *pDifferences = new unsigned char[(nWindowSize + 1) * nRowSize];
+	unsigned char **ppRows = new unsigned char*[nWindowSize + 1];
+	TSum *pColumnSums = new TSum[nRowSize];
+	TSum *pWindowSum = new TSum[nPaddedDisparities];
+	int i;
+
+	for (i = 0; i <= nWindowSize; i++)
+		ppRows[i] = pDifferences + i * nRowSize;
+
+	for (i = 0; i < nRowSize; i++)
+		pColumnSums[i] = 0;
+
+	CByteImage *pDepthImage = pParameters->pDepthImage;
+	const int nOutputOffset = - (nWindowSize / 2) * (pDepthImage->GetStride() + 1);
+
+	for (int r = nBegin; r < nEnd + nWindowSize - 1; r++)
+	{
+		const int nSlot = r % nWindowSize;
+
+		if (r - nBegin >= nWindowSize)
+		{
+			// add the new row and remove the row leaving the window
+			unsigned char *pNewRow = ppRows[nWindowSize];
+			CalculateAbsoluteDifferences(pParameters, r, nFirstColumn, c_max + 1, pNewRow);
+			
+			for (i = 0; i < nRowSize; i += nPaddedDisparities)
+				UpdateColumnSum(pColumnSums + i, pNewRow + i, ppRows[nSlot] + i, nPaddedDisparities);
+			
+			ppRows[nWindowSize] = ppRows[nSlot];
+			ppRows[nSlot] = pNewRow;
+		}
+		else
+		{
+			CalculateAbsoluteDifferences(pParameters, r, nFirstColumn, c_max + 1, ppRows[nSlot]);
+
+			for (i = 0; i < nRowSize; i += nPaddedDisparities)
+				UpdateColumnSum(pColumnSums + i, ppRows[nSlot] + i, 0, nPaddedDisparities);
+		}
+
+		if (r < nBegin + nWindowSize - 1)
+			continue;
+
+		// slide the window along the row
+		unsigned char *pDepth = pDepthImage->pixels + r * pDepthImage->GetStride() + nOutputOffset;
+		
+		for (int k = 0; k < nPaddedDisparities; k++)
+			pWindowSum[k] = 0;
+
+		for (i = 0; i < nWindowSize - 1; i++)
+			UpdateWindowSum(pWindowSum, pColumnSums + i * nPaddedDisparities, 0, nPaddedDisparities);
+
+		for (int c = c_min; c <= c_max; c++)
+		{
+			i = c - nFirstColumn;
+			UpdateWindowSum(pWindowSum, pColumnSums + i * nPaddedDisparities, c == c_min ? 0 : pColumnSums + (i - nWindowSize) * nPaddedDisparities, nPaddedDisparities);
+
+			int nBestIndex;
+			const int nBest = FindMinimum(pWindowSum, nPaddedDisparities, nBestIndex);
+
+			if (nBest < pParameters->nErrorThreshold)
+				pDepth[c] = (unsigned char) abs(pParameters->pDisparities[nBestIndex]);
+		}
+	}
+
+	delete [] pDifferences;
+	delete [] ppRows;
+	delete [] pColumnSums;
+	delete [] pWindowSum;
+}
+
+
 
 // *****************************************************************
 // Constructor / Destructor
@@ -220,120 +604,47 @@ void CStereoVision::_ProcessFast(const CByteImage *pLeftImage, const CByteImage
 	else if (d_step < 0)
 		for (d = d1; d >= d2; d += d_step);
 	d2 = d + d_step;
-		
+
 	const int width = pLeftImage->width;
 	const int height = pLeftImage->height;
-	const int nPixels = width * height;
-	
-	// allocate memory
-	int *H_SUM = new int[nWindowSize * width];
-	int *V_SUM = new int[width];
-	int *SAD = new int[width];
-	int *MIN_SSAD = new int[width * height];
-	
-	for (int i = 0; i < nPixels; i++)
-		MIN_SSAD[i] = nErrorThreshold;
-	
-	const int window_offset = - (nWindowSize / 2) * (width + 1);
-	const int start_c = MY_MAX(nWindowSize, d2) + nWindowSize;
-	
-	const unsigned char *pLeftImageData = pLeftImage->pixels;
-	const unsigned char *pRightImageData = pRightImage->pixels;
-	unsigned char *pDepthImageData = pDepthImage->pixels + window_offset;
 
-	// run correlation algorithm
+	// disparities in the order of evaluation (the first minimum wins)
+	int nDisparities = 0;
 	for (d = d1; d != d2; d += d_step)
-	{
-		int c, r;
-		
-		// initialize
-		for (r = 0; r < nWindowSize; r++)
-		{
-			const unsigned char *pLeftImageData_helper = pLeftImageData + r * width;
-			const unsigned char *pRightImageData_helper = pRightImageData + r * width - d;
-			
-			H_SUM[r * width + start_c - 1] = 0;
-
-			for (c = start_c - nWindowSize; c < start_c; c++)
-			{
-				SAD[c] = abs(pLeftImageData_helper[c] - pRightImageData_helper[c]);
-				H_SUM[r * width + start_c - 1] += SAD[c];
-			}
-			
-			for (c = start_c; c < width; c++)
-			{
-				SAD[c] = abs(pLeftImageData_helper[c] - pRightImageData_helper[c]);
-				H_SUM[r * width + c] = H_SUM[r * width + c - 1] + SAD[c] - SAD[c - nWindowSize];
-			}
-		}
-
-		int *pMinHelper = MIN_SSAD + (nWindowSize - 1) * width; // for topmost_row
-		unsigned char *pDepthHelper = pDepthImageData + (nWindowSize - 1) * width; // for topmost_row
-		for (c = start_c - 1; c < width; c++)
-		{
-			V_SUM[c] = 0;
-			for (r = 0; r < nWindowSize; r++)
-				V_SUM[c] += H_SUM[r * width + c];
-
-			// required for writing topmost row
-			// <topmost_row>
-			if (V_SUM[c] < pMinHelper[c])
-			{
-				pMinHelper[c] = V_SUM[c];
-				pDepthHelper[c] = abs(d);
-			}
-			// </topmost_row>
-		}
-		
-		// go
-		for (r = nWindowSize; r < height; r++)
-		{
-			const unsigned char *pLeftImageData_helper = pLeftImageData + r * width;
-			const unsigned char *pRightImageData_helper = pRightImageData + r * width - d;
-			
-			int *hsum_helper = H_SUM + (r % nWindowSize) * width;
-			int *pMinHelper = MIN_SSAD + r * width;
-			unsigned char *pDepthHelper = pDepthImageData + r * width;
-			
-			const int save = hsum_helper[start_c - 1]; // for leftmost_column
-			hsum_helper[start_c - 1] = 0;
-			for (c = start_c - nWindowSize; c < start_c; c++)
-			{
-				SAD[c] = abs(pLeftImageData_helper[c] - pRightImageData_helper[c]);
-				hsum_helper[start_c - 1] += SAD[c];
-			}
-
-			// required for writing leftmost column
-			// <leftmost_column>
-			const int result = V_SUM[start_c - 1] = V_SUM[start_c - 1] + hsum_helper[start_c - 1] - save;
-			if (result < pMinHelper[start_c - 1])
-			{
-				pMinHelper[start_c - 1] = result;
-				pDepthHelper[start_c - 1] = abs(d);
-			}
-			// </leftmost_column>
+		nDisparities++;
 
-			// core loop
-			for (c = start_c; c < width; c++)
-			{
-				SAD[c] = abs(pLeftImageData_helper[c] - pRightImageData_helper[c]);
-
-				const int save = hsum_helper[c];
-				hsum_helper[c] = hsum_helper[c - 1] + SAD[c] - SAD[c - nWindowSize];
-				const int result = V_SUM[c] = V_SUM[c] + hsum_helper[c] - save;
+	int *pDisparities = new int[nDisparities];
+	int d_min = d1, d_max = d1;
+	
+	for (int k = 0; k < nDisparities; k++)
+	{
+		pDisparities[k] = d1 + k * d_step;
+		d_min = MY_MIN(d_min, pDisparities[k]);
+		d_max = MY_MAX(d_max, pDisparities[k]);
+	}
 
-				if (result < pMinHelper[c])
-				{
-					pMinHelper[c] = result;
-					pDepthHelper[c] = abs(d);
-				}
-			}
-		}
+	ProcessFastParameters parameters;
+	parameters.pLeftImage = pLeftImage;
+	parameters.pRightImage = pRightImage;
+	parameters.pDepthImage = pDepthImage;
+	parameters.nWindowSize = nWindowSize;
+	parameters.nErrorThreshold = nErrorThreshold;
+	parameters.pDisparities = pDisparities;
+	parameters.nDisparities = nDisparities;
+	parameters.nPaddedDisparities = (nDisparities + 15) & ~15;
+	parameters.d_step = d_step;
+
+	// all window columns c - nWindowSize + 1 .. c and c - d must lie within the images
+	parameters.c_min = MY_MAX(nWindowSize, MY_MAX(d2, d_max + 1)) + nWindowSize - 1;
+	parameters.c_max = width - 1 + MY_MIN(d_min, 0);
+
+	if (parameters.c_min <= parameters.c_max && height >= nWindowSize)
+	{
+		if (nWindowSize * nWindowSize * 255 <= 65535)
+			Threading::ParallelFor(ProcessFastRows<unsigned short>, &parameters, height - nWindowSize + 1, 16);
+		else
+			Threading::ParallelFor(ProcessFastRows<int>, &parameters, height - nWindowSize + 1, 16);
 	}
-	
-	// free memory
-	delete [] H_SUM;
-	delete [] V_SUM;
-	delete [] SAD;
-	delete [] MIN_SSAD;
+
+	delete [] pDisparities;
 }
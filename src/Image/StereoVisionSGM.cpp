@@ -0,0 +1,948 @@
+// ****************************************************************************
+// This file is part of the Integrating Vision Toolkit (IVT).
+//
+// The IVT is maintained by the Karlsruhe Institute of Technology (KIT)
+// (www.kit.edu) in cooperation with the company Keyetech (www.keyetech.de).
+//
+// Copyright (C) 2014 Karlsruhe Institute of Technology (KIT).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the KIT nor the names of its contributors may be
+//    used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE KIT AND CONTRIBUTORS “AS IS” AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE KIT OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ****************************************************************************
+// ****************************************************************************
+// Filename:  StereoVisionSGM.cpp
+// Author:    agent
+// Date:      17.10.2026
+// ****************************************************************************
+
+
+// ****************************************************************************
+// Includes
+// ****************************************************************************
+
+#include <new> // for explicitly using correct new/delete operators on VC DSPs
+
+#include "StereoVisionSGM.h"
+
+#include "ByteImage.h"
+#include "ShortImage.h"
+#include "Threading/WorkerPool.h"
+
+#include <stdio.h>
+#include <string.h>
+
+
+#if defined(USE_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define SGM_SIMD_AVAILABLE
+#include <emmintrin.h>
+#endif
+
+
+
+// ****************************************************************************
+// Defines
+// ****************************************************************************
+
+// census window of 9x7 pixels without the center pixel, stored in two planes of 32 bit words;
+// the comparisons are packed into bytes, the first comparison of a byte being its most significant bit
+#define CENSUS_RADIUS_X			4
+#define CENSUS_RADIUS_Y			3
+#define CENSUS_BITS				62
+#define CENSUS_MAX_COST			62
+
+#define SAD_MAX_COST			255
+
+// aggregated costs of a pixel are stored in blocks of 8 values with a guard value at both ends
+#define PATH_GUARD_VALUE		0x7fff
+#define PATH_DATA_OFFSET		8
+
+
+
+// ****************************************************************************
+// Static functions
+// ****************************************************************************
+
+struct SGMContext
+{
+	const CByteImage *pLeftImage;
+	const CByteImage *pRightImage;
+	CShortImage *pDisparityImage;
+
+	int width;
+	int height;
+	int nMinDisparity;
+	int nDisparities;
+	int nPaddedDisparities;
+	int nEntrySize;
+	int P1;
+	int P2;
+	int nUniquenessRatio;
+	int nMaxLeftRightDifference;
+
+	const unsigned int *pLeftCensus;
+	const unsigned int *pRightCensus;
+	unsigned char *pCosts;
+	short *pSums;
+
+	// state of the vertical and diagonal sweeps
+	int nDirections;
+	int pDirectionsX[3];
+	short *pPrevious;
+	short *pCurrent;
+	int *pPreviousMinima;
+	int *pCurrentMinima;
+	bool bFirstRow;
+
+	// census transform
+	const CByteImage *pCensusImage;
+	unsigned int *pCensus;
+	int nPixels;
+};
+
+static inline int CountBits(unsigned int x)
+{
+	x = x - ((x >> 1) & 0x55555555);
+	x = (x & 0x33333333) + ((x >> 2) & 0x33333333);
+	x = (x + (x >> 4)) & 0x0f0f0f0f;
+	return (x * 0x01010101) >> 24;
+}
+
+static void CensusTransformRows(void *pParameter, int nBegin, int nEnd)
+{
+	const SGMContext *pContext = (const SGMContext *) pParameter;
+	const CByteImage *pImage = pContext->pCensusImage;
+	const int width = pContext->width;
+	const int height = pContext->height;
+	const int nRowSize = width + 2 * CENSUS_RADIUS_X;
+
+	// window rows with replicated borders
+	unsigned char *pRows = new unsigned char[(2 * CENSUS_RADIUS_Y + 1) * nRowSize];
+	int pOffsets[CENSUS_BITS], k = 0;
+
+	for (int j = 0; j <= 2 * CENSUS_RADIUS_Y; j++)
+		for (int i = 0; i <= 2 * CENSUS_RADIUS_X; i++)
+			if (j != CENSUS_RADIUS_Y || i != CENSUS_RADIUS_X)
+				pOffsets[k++] = j * nRowSize + i;
+
+	for (int y = nBegin; y < nEnd; y++)
+	{
+		for (int j = 0; j <= 2 * CENSUS_RADIUS_Y; j++)
+		{
+			int yy = y + j - CENSUS_RADIUS_Y;
+			if (yy < 0) yy = 0; else if (yy >= height) yy = height - 1;
+
+			const unsigned char *pInput = pImage->pixels + yy * pImage->GetStride();
+			unsigned char *pRow = pRows + j * nRowSize;
+
+			memcpy(pRow + CENSUS_RADIUS_X, pInput, width);
+			
+			for (int i = 0; i < CENSUS_RADIUS_X; i++)
+			{
+				pRow[i] = pInput[0];
+				pRow[CENSUS_RADIUS_X + width + i] = pInput[width - 1];
+			}
+		}
+
+		unsigned int *pCensus0 = pContext->pCensus + y * width;
+		unsigned int *pCensus1 = pCensus0 + pContext->nPixels;
+		int x = 0;
+
+#ifdef SGM_SIMD_AVAILABLE
+		const __m128i bias = _mm_set1_epi8((char) 0x80);
+
+		for (; x + 16 <= width; x += 16)
+		{
+			const unsigned char *p = pRows + x;
+			const __m128i center = _mm_xor_si128(_mm_loadu_si128((const __m128i *) (p + CENSUS_RADIUS_Y * nRowSize + CENSUS_RADIUS_X)), bias);
+			__m128i planes[8];
+
+			for (int nPlane = 0; nPlane < 8; nPlane++)
+			{
+				const int k_end = 8 * nPlane + 8 < CENSUS_BITS ? 8 * nPlane + 8 : CENSUS_BITS;
+				__m128i byte = _mm_setzero_si128();
+
+				for (int k = 8 * nPlane; k < k_end; k++)
+				{
+					const __m128i value = _mm_xor_si128(_mm_loadu_si128((const __m128i *) (p + pOffsets[k])), bias);
+					byte = _mm_sub_epi8(_mm_add_epi8(byte, byte), _mm_cmpgt_epi8(center, value));
+				}
+
+				planes[nPlane] = byte;
+			}
+
+			for (int i = 0; i < 2; i++)
+			{
+				unsigned int *pCensus = i == 0 ? pCensus0 + x : pCensus1 + x;
+				const __m128i lo01 = _mm_unpacklo_epi8(planes[4 * i], planes[4 * i + 1]);
+				const __m128i hi01 = _mm_unpackhi_epi8(planes[4 * i], planes[4 * i + 1]);
+				const __m128i lo23 = _mm_unpacklo_epi8(planes[4 * i + 2], planes[4 * i + 3]);
+				const __m128i hi23 = _mm_unpackhi_epi8(planes[4 * i + 2], planes[4 * i + 3]);
+
+				_mm_storeu_si128((__m128i *) pCensus, _mm_unpacklo_epi16(lo01, lo23));
+				_mm_storeu_si128((__m128i *) (pCensus + 4), _mm_unpackhi_epi16(lo01, lo23));
+				_mm_storeu_si128((__m128i *) (pCensus + 8), _mm_unpacklo_epi16(hi01, hi23));
+				_mm_storeu_si128((__m128i *) (pCensus + 12), _mm_unpackhi_epi16(hi01, hi23));
+			}
+		}
+#endif
+		
+		for (; x < width; x++)
+		{
+			const unsigned char *p = pRows + x;
+			const int center = p[CENSUS_RADIUS_Y * nRowSize + CENSUS_RADIUS_X];
+			unsigned int words[2] = { 0, 0 };
+
+			for (int k = 0; k < CENSUS_BITS; k++)
+			{
+				const int nByte = k >> 3;
+				const int nBitsInByte = CENSUS_BITS - 8 * nByte < 8 ? CENSUS_BITS - 8 * nByte : 8;
+				const int nShift = 8 * (nByte & 3) + nBitsInByte - 1 - (k & 7);
+				words[nByte >> 2] |= (unsigned int) (p[pOffsets[k]] < center) << nShift;
+			}
+
+			pCensus0[x] = words[0];
+			pCensus1[x] = words[1];
+		}
+	}
+
+	delete [] pRows;
+}
+
+#ifdef SGM_SIMD_AVAILABLE
+static inline __m128i CountBits(__m128i x0, __m128i x1)
+{
+	const __m128i m1 = _mm_set1_epi32(0x55555555);
+	const __m128i m2 = _mm_set1_epi32(0x33333333);
+	const __m128i m4 = _mm_set1_epi32(0x0f0f0f0f);
+
+	x0 = _mm_sub_epi32(x0, _mm_and_si128(_mm_srli_epi32(x0, 1), m1));
+	x1 = _mm_sub_epi32(x1, _mm_and_si128(_mm_srli_epi32(x1, 1), m1));
+	x0 = _mm_add_epi32(_mm_and_si128(x0, m2), _mm_and_si128(_mm_srli_epi32(x0, 2), m2));
+	x1 = _mm_add_epi32(_mm_and_si128(x1, m2), _mm_and_si128(_mm_srli_epi32(x1, 2), m2));
+	x0 = _mm_and_si128(_mm_add_epi32(x0, _mm_srli_epi32(x0, 4)), m4);
+	x1 = _mm_and_si128(_mm_add_epi32(x1, _mm_srli_epi32(x1, 4)), m4);
+
+	// sum of the byte counts of both words (each byte is at most 16)
+	x0 = _mm_add_epi32(x0, x1);
+	x0 = _mm_add_epi32(x0, _mm_srli_epi32(x0, 8));
+	x0 = _mm_add_epi32(x0, _mm_srli_epi32(x0, 16));
+
+	return _mm_and_si128(x0, _mm_set1_epi32(0x7f));
+}
+#endif
+
+static void CalculateCensusCostRows(void *pParameter, int nBegin, int nEnd)
+{
+	const SGMContext *pContext = (const SGMContext *) pParameter;
+	const int width = pContext->width;
+	const int nPixels = pContext->nPixels;
+	const int nDisparities = pContext->nDisparities;
+	const int nPaddedDisparities = pContext->nPaddedDisparities;
+	const int nMinDisparity = pContext->nMinDisparity;
+
+	for (int y = nBegin; y < nEnd; y++)
+	{
+		const unsigned int *pLeftCensus = pContext->pLeftCensus + y * width;
+		const unsigned int *pRightCensus0 = pContext->pRightCensus + y * width;
+		const unsigned int *pRightCensus1 = pRightCensus0 + nPixels;
+		unsigned char *pCosts = pContext->pCosts + y * width * nPaddedDisparities;
+
+		for (int x = 0; x < width; x++, pCosts += nPaddedDisparities)
+		{
+			const unsigned int l0 = pLeftCensus[x];
+			const unsigned int l1 = pLeftCensus[x + nPixels];
+			const int xr_max = x - nMinDisparity;
+
+			// range of disparities for which x - disparity lies within the right image
+			int d_min = x - width + 1 - nMinDisparity, d_max = xr_max;
+			if (d_min < 0) d_min = 0;
+			if (d_max > nDisparities - 1) d_max = nDisparities - 1;
+
+			int d = 0;
+			
+			for (; d < d_min && d < nPaddedDisparities; d++)
+				pCosts[d] = CENSUS_MAX_COST;
+
+#ifdef SGM_SIMD_AVAILABLE
+			const __m128i left0 = _mm_set1_epi32((int) l0);
+			const __m128i left1 = _mm_set1_epi32((int) l1);
+
+			// blocks of 8 disparities correspond to 8 right pixels in reversed order
+			for (; d + 8 <= d_max + 1; d += 8)
+			{
+				const int xr = xr_max - d;
+				
+				const __m128i r00 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) (pRightCensus0 + xr - 3)), 0x1b);
+				const __m128i r01 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) (pRightCensus1 + xr - 3)), 0x1b);
+				const __m128i r10 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) (pRightCensus0 + xr - 7)), 0x1b);
+				const __m128i r11 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) (pRightCensus1 + xr - 7)), 0x1b);
+				
+				const __m128i c0 = CountBits(_mm_xor_si128(left0, r00), _mm_xor_si128(left1, r01));
+				const __m128i c1 = CountBits(_mm_xor_si128(left0, r10), _mm_xor_si128(left1, r11));
+				const __m128i c = _mm_packs_epi32(c0, c1);
+
+				_mm_storel_epi64((__m128i *) (pCosts + d), _mm_packus_epi16(c, c));
+			}
+#endif
+
+			for (; d <= d_max; d++)
+			{
+				const int xr = xr_max - d;
+				pCosts[d] = (unsigned char) (CountBits(l0 ^ pRightCensus0[xr]) + CountBits(l1 ^ pRightCensus1[xr]));
+			}
+
+			for (; d < nPaddedDisparities; d++)
+				pCosts[d] = CENSUS_MAX_COST;
+		}
+	}
+}
+
+static void CalculateSADCostRows(void *pParameter, int nBegin, int nEnd)
+{
+	const SGMContext *pContext = (const SGMContext *) pParameter;
+	const int width = pContext->width;
+	const int height = pContext->height;
+	const int nDisparities = pContext->nDisparities;
+	const int nPaddedDisparities = pContext->nPaddedDisparities;
+	const int nMinDisparity = pContext->nMinDisparity;
+	const int stride = pContext->pLeftImage->GetStride();
+
+	int *pColumnSums = new int[width];
+
+	for (int y = nBegin; y < nEnd; y++)
+	{
+		const unsigned char *ppLeftRows[3], *ppRightRows[3];
+
+		for (int i = 0; i < 3; i++)
+		{
+			int yy = y + i - 1;
+			if (yy < 0) yy = 0; else if (yy >= height) yy = height - 1;
+			ppLeftRows[i] = pContext->pLeftImage->pixels + yy * stride;
+			ppRightRows[i] = pContext->pRightImage->pixels + yy * pContext->pRightImage->GetStride();
+		}
+
+		unsigned char *pCosts = pContext->pCosts + y * width * nPaddedDisparities;
+
+		for (int d = 0; d < nPaddedDisparities; d++)
+		{
+			const int dd = nMinDisparity + d;
+
+			// range of x for which x - dd lies within the right image
+			int x_min = dd > 0 ? dd : 0;
+			int x_max = dd < 0 ? width - 1 + dd : width - 1;
+
+			if (d >= nDisparities || x_min > x_max)
+			{
+				x_min = width;
+				x_max = width - 1;
+			}
+
+			for (int x = x_min; x <= x_max; x++)
+			{
+				int sum = 0;
+
+				for (int i = 0; i < 3; i++)
+				{
+					const int diff = ppLeftRows[i][x] - ppRightRows[i][x - dd];
+					sum += diff < 0 ? -diff : diff;
+				}
+
+				pColumnSums[x] = sum;
+			}
+
+			for (int x = 0; x < width; x++)
+			{
+				if (x < x_min || x > x_max)
+				{
+					pCosts[x * nPaddedDisparities + d] = SAD_MAX_COST;
+					continue;
+				}
+
+				const int sum = (pColumnSums[x > x_min ? x - 1 : x] + pColumnSums[x] + pColumnSums[x < x_max ? x + 1 : x]) >> 3;
+				pCosts[x * nPaddedDisparities + d] = (unsigned char) (sum < SAD_MAX_COST ? sum : SAD_MAX_COST);
+			}
+		}
+	}
+
+	delete [] pColumnSums;
+}
+
+// computes the path costs of one pixel from the path costs of its predecessor (or starts the path if pPrevious is 0)
+// and adds them to the aggregated costs; returns the minimum path cost
+static inline int AggregatePixel(const short *pPrevious, int nPreviousMinimum, const unsigned char *pCosts,
+	short *pCurrent, short *pSums, int nPaddedDisparities, int P1, int P2)
+{
+#ifdef SGM_SIMD_AVAILABLE
+	const __m128i zero = _mm_setzero_si128();
+	__m128i minimum = _mm_set1_epi16(PATH_GUARD_VALUE);
+
+	if (!pPrevious)
+	{
+		for (int d = 0; d < nPaddedDisparities; d += 8)
+		{
+			const __m128i c = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *) (pCosts + d)), zero);
+			_mm_storeu_si128((__m128i *) (pCurrent + d), c);
+			_mm_storeu_si128((__m128i *) (pSums + d), _mm_adds_epi16(_mm_loadu_si128((const __m128i *) (pSums + d)), c));
+			minimum = _mm_min_epi16(minimum, c);
+		}
+	}
+	else
+	{
+		const int nJump = nPreviousMinimum + P2 < PATH_GUARD_VALUE ? nPreviousMinimum + P2 : PATH_GUARD_VALUE;
+		const __m128i p1 = _mm_set1_epi16((short) P1);
+		const __m128i jump = _mm_set1_epi16((short) nJump);
+		const __m128i previousMinimum = _mm_set1_epi16((short) nPreviousMinimum);
+
+		for (int d = 0; d < nPaddedDisparities; d += 8)
+		{
+			const __m128i c = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *) (pCosts + d)), zero);
+			__m128i m = _mm_loadu_si128((const __m128i *) (pPrevious + d));
+			m = _mm_min_epi16(m, _mm_adds_epi16(_mm_loadu_si128((const __m128i *) (pPrevious + d - 1)), p1));
+			m = _mm_min_epi16(m, _mm_adds_epi16(_mm_loadu_si128((const __m128i *) (pPrevious + d + 1)), p1));
+			m = _mm_min_epi16(m, jump);
+
+			const __m128i l = _mm_add_epi16(c, _mm_sub_epi16(m, previousMinimum));
+			_mm_storeu_si128((__m128i *) (pCurrent + d), l);
+			_mm_storeu_si128((__m128i *) (pSums + d), _mm_adds_epi16(_mm_loadu_si128((const __m128i *) (pSums + d)), l));
+			minimum = _mm_min_epi16(minimum, l);
+		}
+	}
+
+	minimum = _mm_min_epi16(minimum, _mm_srli_si128(minimum, 8));
+	minimum = _mm_min_epi16(minimum, _mm_srli_si128(minimum, 4));
+	minimum = _mm_min_epi16(minimum, _mm_srli_si128(minimum, 2));
+
+	return (short) _mm_cvtsi128_si32(minimum);
+#else
+	int minimum = PATH_GUARD_VALUE;
+
+	if (!pPrevious)
+	{
+		for (int d = 0; d < nPaddedDisparities; d++)
+		{
+			const int l = pCosts[d];
+			pCurrent[d] = (short) l;
+			pSums[d] = (short) (pSums[d] + l);
+			if (l < minimum) minimum = l;
+		}
+	}
+	else
+	{
+		const int nJump = nPreviousMinimum + P2;
+
+		for (int d = 0; d < nPaddedDisparities; d++)
+		{
+			int m = pPrevious[d];
+			if (pPrevious[d - 1] + P1 < m) m = pPrevious[d - 1] + P1;
+			if (pPrevious[d + 1] + P1 < m) m = pPrevious[d + 1] + P1;
+			if (nJump < m) m = nJump;
+
+			const int l = pCosts[d] + m - nPreviousMinimum;
+			pCurrent[d] = (short) l;
+			pSums[d] = (short) (pSums[d] + l);
+			if (l < minimum) minimum = l;
+		}
+	}
+
+	return minimum;
+#endif
+}
+
+static void InitPathBuffer(short *pBuffer, int nEntries, int nEntrySize)
+{
+	for (int i = 0; i < nEntries * nEntrySize; i++)
+		pBuffer[i] = PATH_GUARD_VALUE;
+}
+
+static void AggregateHorizontalRows(void *pParameter, int nBegin, int nEnd)
+{
+	const SGMContext *pContext = (const SGMContext *) pParameter;
+	const int width = pContext->width;
+	const int nPaddedDisparities = pContext->nPaddedDisparities;
+	const int nEntrySize = pContext->nEntrySize;
+
+	short *pBuffer = new short[2 * nEntrySize];
+	InitPathBuffer(pBuffer, 2, nEntrySize);
+
+	for (int y = nBegin; y < nEnd; y++)
+	{
+		const unsigned char *pCosts = pContext->pCosts + y * width * nPaddedDisparities;
+		short *pSums = pContext->pSums + y * width * nPaddedDisparities;
+
+		// left to right and right to left
+		for (int nDirection = 0; nDirection < 2; nDirection++)
+		{
+			short *pPrevious = pBuffer + PATH_DATA_OFFSET;
+			short *pCurrent = pBuffer + nEntrySize + PATH_DATA_OFFSET;
+			int nPreviousMinimum = 0;
+
+			for (int i = 0; i < width; i++)
+			{
+				const int x = nDirection == 0 ? i : width - 1 - i;
+				const int offset = x * nPaddedDisparities;
+
+				nPreviousMinimum = AggregatePixel(i == 0 ? 0 : pPrevious, nPreviousMinimum, pCosts + offset,
+					pCurrent, pSums + offset, nPaddedDisparities, pContext->P1, pContext->P2);
+
+				short *pTemp = pPrevious;
+				pPrevious = pCurrent;
+				pCurrent = pTemp;
+			}
+		}
+	}
+
+	delete [] pBuffer;
+}
+
+static void AggregateVerticalRow(void *pParameter, int nBegin, int nEnd)
+{
+	const SGMContext *pContext = (const SGMContext *) pParameter;
+	const int width = pContext->width;
+	const int nPaddedDisparities = pContext->nPaddedDisparities;
+	const int nEntrySize = pContext->nEntrySize;
+
+	for (int k = 0; k < pContext->nDirections; k++)
+	{
+		const int dx = pContext->pDirectionsX[k];
+		const short *pPrevious = pContext->pPrevious + k * width * nEntrySize + PATH_DATA_OFFSET;
+		const int *pPreviousMinima = pContext->pPreviousMinima + k * width;
+		short *pCurrent = pContext->pCurrent + k * width * nEntrySize + PATH_DATA_OFFSET;
+		int *pCurrentMinima = pContext->pCurrentMinima + k * width;
+
+		for (int x = nBegin; x < nEnd; x++)
+		{
+			const int xp = x - dx;
+			const int offset = x * nPaddedDisparities;
+			const bool bStart = pContext->bFirstRow || xp < 0 || xp >= width;
+
+			pCurrentMinima[x] = AggregatePixel(bStart ? 0 : pPrevious + xp * nEntrySize, bStart ? 0 : pPreviousMinima[xp],
+				pContext->pCosts + offset, pCurrent + x * nEntrySize, pContext->pSums + offset,
+				nPaddedDisparities, pContext->P1, pContext->P2);
+		}
+	}
+}
+
+// returns the minimum of p[nBegin..nEnd - 1]
+static inline int MinimumCost(const short *p, int nBegin, int nEnd)
+{
+	int minimum = PATH_GUARD_VALUE;
+	int i = nBegin;
+
+#ifdef SGM_SIMD_AVAILABLE
+	if (nEnd - nBegin >= 8)
+	{
+		__m128i m = _mm_loadu_si128((const __m128i *) (p + i));
+
+		for (i += 8; i + 8 <= nEnd; i += 8)
+			m = _mm_min_epi16(m, _mm_loadu_si128((const __m128i *) (p + i)));
+
+		m = _mm_min_epi16(m, _mm_srli_si128(m, 8));
+		m = _mm_min_epi16(m, _mm_srli_si128(m, 4));
+		m = _mm_min_epi16(m, _mm_srli_si128(m, 2));
+		minimum = (short) _mm_cvtsi128_si32(m);
+	}
+#endif
+
+	for (; i < nEnd; i++)
+		if (p[i] < minimum)
+			minimum = p[i];
+
+	return minimum;
+}
+
+static void SelectDisparityRows(void *pParameter, int nBegin, int nEnd)
+{
+	const SGMContext *pContext = (const SGMContext *) pParameter;
+	const int width = pContext->width;
+	const int nDisparities = pContext->nDisparities;
+	const int nPaddedDisparities = pContext->nPaddedDisparities;
+	const int nMinDisparity = pContext->nMinDisparity;
+	const int nUniquenessRatio = pContext->nUniquenessRatio;
+	const int nMaxLeftRightDifference = pContext->nMaxLeftRightDifference;
+
+	short *pRightDisparities = 0, *pRightCosts = 0;
+	
+	if (nMaxLeftRightDifference >= 0)
+	{
+		pRightDisparities = new short[width];
+		pRightCosts = new short[width];
+	}
+
+	for (int y = nBegin; y < nEnd; y++)
+	{
+		const short *pSums = pContext->pSums + y * width * nPaddedDisparities;
+		short *pOutput = pContext->pDisparityImage->pixels + y * pContext->pDisparityImage->GetStride();
+		int x;
+
+		if (pRightDisparities)
+		{
+			// disparity of the right pixel xr: minimum of the aggregated costs of the left pixels xr + nMinDisparity + d
+			for (x = 0; x < width; x++)
+			{
+				pRightDisparities[x] = -1;
+				pRightCosts[x] = PATH_GUARD_VALUE;
+			}
+
+			for (x = 0; x < width; x++)
+			{
+				const short *pPixelSums = pSums + x * nPaddedDisparities;
+				const int xr_max = x - nMinDisparity;
+
+				int d_min = x - width + 1 - nMinDisparity, d_max = x - nMinDisparity;
+				if (d_min < 0) d_min = 0;
+				if (d_max > nDisparities - 1) d_max = nDisparities - 1;
+
+				int d = d_min;
+
+#ifdef SGM_SIMD_AVAILABLE
+				// blocks of 8 disparities correspond to 8 right pixels in reversed order
+				for (; d + 8 <= d_max + 1; d += 8)
+				{
+					__m128i cost = _mm_loadu_si128((const __m128i *) (pPixelSums + d));
+					cost = _mm_shuffle_epi32(_mm_shufflehi_epi16(_mm_shufflelo_epi16(cost, 0x1b), 0x1b), 0x4e);
+
+					const __m128i disparity = _mm_add_epi16(_mm_setr_epi16(7, 6, 5, 4, 3, 2, 1, 0), _mm_set1_epi16((short) d));
+
+					__m128i *pRight = (__m128i *) (pRightCosts + xr_max - d - 7);
+					__m128i *pRightDisparity = (__m128i *) (pRightDisparities + xr_max - d - 7);
+					const __m128i rightCost = _mm_loadu_si128(pRight);
+					const __m128i rightDisparity = _mm_loadu_si128(pRightDisparity);
+					const __m128i mask = _mm_cmplt_epi16(cost, rightCost);
+
+					_mm_storeu_si128(pRight, _mm_min_epi16(cost, rightCost));
+					_mm_storeu_si128(pRightDisparity, _mm_or_si128(_mm_and_si128(mask, disparity), _mm_andnot_si128(mask, rightDisparity)));
+				}
+#endif
+
+				for (; d <= d_max; d++)
+				{
+					const int xr = xr_max - d;
+
+					if (pPixelSums[d] < pRightCosts[xr])
+					{
+						pRightDisparities[xr] = (short) d;
+						pRightCosts[xr] = pPixelSums[d];
+					}
+				}
+			}
+		}
+
+		for (x = 0; x < width; x++)
+		{
+			const short *pPixelSums = pSums + x * nPaddedDisparities;
+
+			// only disparities for which x - disparity lies within the right image
+			int d_min = x - width + 1 - nMinDisparity, d_max = x - nMinDisparity;
+			if (d_min < 0) d_min = 0;
+			if (d_max > nDisparities - 1) d_max = nDisparities - 1;
+
+			pOutput[x] = SGM_INVALID_DISPARITY;
+
+			if (d_min > d_max)
+				continue;
+
+			const int nBestCost = MinimumCost(pPixelSums, d_min, d_max + 1);
+			int nBest = d_min;
+
+			while (pPixelSums[nBest] != nBestCost)
+				nBest++;
+
+			if (nUniquenessRatio > 0)
+			{
+				const int nSecondCost1 = MinimumCost(pPixelSums, d_min, nBest - 1);
+				const int nSecondCost2 = MinimumCost(pPixelSums, nBest + 2, d_max + 1);
+				const int nSecondCost = nSecondCost1 < nSecondCost2 ? nSecondCost1 : nSecondCost2;
+
+				if (nSecondCost * 100 < nBestCost * (100 + nUniquenessRatio))
+					continue;
+			}
+
+			if (pRightDisparities)
+			{
+				const int diff = pRightDisparities[x - nMinDisparity - nBest] - nBest;
+
+				if (diff > nMaxLeftRightDifference || -diff > nMaxLeftRightDifference)
+					continue;
+			}
+
+			int disparity = (nMinDisparity + nBest) << SGM_DISPARITY_SHIFT;
+
+			if (nBest > d_min && nBest < d_max)
+			{
+				// parabola fit through the aggregated costs of the neighboring disparities
+				const int c0 = pPixelSums[nBest - 1];
+				const int c2 = pPixelSums[nBest + 1];
+				const int denominator = c0 + c2 - 2 * nBestCost;
+
+				if (denominator > 0)
+					disparity += ((c0 - c2) * (1 << SGM_DISPARITY_SHIFT) + denominator) / (2 * denominator);
+			}
+
+			pOutput[x] = (short) disparity;
+		}
+	}
+
+	delete [] pRightDisparities;
+	delete [] pRightCosts;
+}
+
+
+
+// ****************************************************************************
+// Constructor / Destructor
+// ****************************************************************************
+
+CStereoVisionSGM::CStereoVisionSGM()
+{
+	m_costFunction = eCensus;
+	m_nPaths = 8;
+	m_nP1 = 10;
+	m_nP2 = 120;
+	m_nUniquenessRatio = 10;
+	m_nMaxLeftRightDifference = 1;
+
+	m_pCensus = 0;
+	m_pCosts = 0;
+	m_pAggregatedCosts = 0;
+	m_pPathBuffer = 0;
+	m_pPathMinima = 0;
+	m_nAllocatedPixels = 0;
+	m_nAllocatedVolume = 0;
+	m_nAllocatedPathBuffer = 0;
+	m_nAllocatedPathMinima = 0;
+}
+
+CStereoVisionSGM::~CStereoVisionSGM()
+{
+	FreeBuffers();
+}
+
+
+// ****************************************************************************
+// Methods
+// ****************************************************************************
+
+bool CStereoVisionSGM::SetNumberOfPaths(int nPaths)
+{
+	if (nPaths != 4 && nPaths != 8)
+	{
+		printf("error: number of paths must be 4 or 8 for CStereoVisionSGM::SetNumberOfPaths\n");
+		return false;
+	}
+
+	m_nPaths = nPaths;
+
+	return true;
+}
+
+bool CStereoVisionSGM::SetPenalties(int nP1, int nP2)
+{
+	// 8 paths * (max cost + P2) must not exceed the range of short
+	if (nP1 < 0 || nP2 < nP1 || nP2 > 3000)
+	{
+		printf("error: penalties must satisfy 0 <= P1 <= P2 <= 3000 for CStereoVisionSGM::SetPenalties\n");
+		return false;
+	}
+
+	m_nP1 = nP1;
+	m_nP2 = nP2;
+
+	return true;
+}
+
+void CStereoVisionSGM::FreeBuffers()
+{
+	delete [] m_pCensus;
+	delete [] m_pCosts;
+	delete [] m_pAggregatedCosts;
+	delete [] m_pPathBuffer;
+	delete [] m_pPathMinima;
+
+	m_pCensus = 0;
+	m_pCosts = 0;
+	m_pAggregatedCosts = 0;
+	m_pPathBuffer = 0;
+	m_pPathMinima = 0;
+	m_nAllocatedPixels = 0;
+	m_nAllocatedVolume = 0;
+	m_nAllocatedPathBuffer = 0;
+	m_nAllocatedPathMinima = 0;
+}
+
+void CStereoVisionSGM::AllocateBuffers(int nPixels, int nVolume, int nPathEntries, int nPathEntrySize)
+{
+	if (nPixels > m_nAllocatedPixels)
+	{
+		delete [] m_pCensus;
+		m_pCensus = new unsigned int[4 * nPixels];
+		m_nAllocatedPixels = nPixels;
+	}
+
+	if (nVolume > m_nAllocatedVolume)
+	{
+		delete [] m_pCosts;
+		delete [] m_pAggregatedCosts;
+		m_pCosts = new unsigned char[nVolume];
+		m_pAggregatedCosts = new short[nVolume];
+		m_nAllocatedVolume = nVolume;
+	}
+
+	if (nPathEntries * nPathEntrySize > m_nAllocatedPathBuffer)
+	{
+		delete [] m_pPathBuffer;
+		m_pPathBuffer = new short[nPathEntries * nPathEntrySize];
+		m_nAllocatedPathBuffer = nPathEntries * nPathEntrySize;
+	}
+
+	if (nPathEntries > m_nAllocatedPathMinima)
+	{
+		delete [] m_pPathMinima;
+		m_pPathMinima = new int[nPathEntries];
+		m_nAllocatedPathMinima = nPathEntries;
+	}
+}
+
+bool CStereoVisionSGM::Process(const CByteImage *pLeftImage, const CByteImage *pRightImage, CShortImage *pDisparityImage,
+	int nMinDisparity, int nNumberOfDisparities)
+{
+	const int width = pLeftImage->width;
+	const int height = pLeftImage->height;
+
+	if (pLeftImage->type != CByteImage::eGrayScale || pRightImage->type != CByteImage::eGrayScale)
+	{
+		printf("error: input images must be of type eGrayScale for CStereoVisionSGM::Process\n");
+		return false;
+	}
+
+	if (pRightImage->width != width || pRightImage->height != height ||
+		pDisparityImage->width != width || pDisparityImage->height != height)
+	{
+		printf("error: input and output images must be of the same size for CStereoVisionSGM::Process\n");
+		return false;
+	}
+
+	const int nAbsoluteMinDisparity = nMinDisparity < 0 ? -nMinDisparity : nMinDisparity;
+
+	if (nNumberOfDisparities < 1 || (nAbsoluteMinDisparity + nNumberOfDisparities) << SGM_DISPARITY_SHIFT > 32767)
+	{
+		printf("error: invalid disparity range for CStereoVisionSGM::Process\n");
+		return false;
+	}
+
+	// disparities are padded to a multiple of 8 for the vectorized aggregation
+	const int nPaddedDisparities = (nNumberOfDisparities + 7) & ~7;
+	const int nEntrySize = nPaddedDisparities + 2 * PATH_DATA_OFFSET;
+	const int nVerticalDirections = m_nPaths == 8 ? 3 : 1;
+
+	AllocateBuffers(width * height, width * height * nPaddedDisparities, 2 * nVerticalDirections * width, nEntrySize);
+
+	SGMContext context;
+	context.pLeftImage = pLeftImage;
+	context.pRightImage = pRightImage;
+	context.pDisparityImage = pDisparityImage;
+	context.width = width;
+	context.height = height;
+	context.nMinDisparity = nMinDisparity;
+	context.nDisparities = nNumberOfDisparities;
+	context.nPaddedDisparities = nPaddedDisparities;
+	context.nEntrySize = nEntrySize;
+	context.P1 = m_nP1;
+	context.P2 = m_nP2;
+	context.nUniquenessRatio = m_nUniquenessRatio;
+	context.nMaxLeftRightDifference = m_nMaxLeftRightDifference;
+	context.pLeftCensus = m_pCensus;
+	context.pRightCensus = m_pCensus + 2 * width * height;
+	context.nPixels = width * height;
+	context.pCosts = m_pCosts;
+	context.pSums = m_pAggregatedCosts;
+
+	// matching costs
+	if (m_costFunction == eCensus)
+	{
+		context.pCensusImage = pLeftImage;
+		context.pCensus = m_pCensus;
+		Threading::ParallelFor(CensusTransformRows, &context, height, 16);
+
+		context.pCensusImage = pRightImage;
+		context.pCensus = m_pCensus + 2 * width * height;
+		Threading::ParallelFor(CensusTransformRows, &context, height, 16);
+
+		Threading::ParallelFor(CalculateCensusCostRows, &context, height, 8);
+	}
+	else
+	{
+		Threading::ParallelFor(CalculateSADCostRows, &context, height, 8);
+	}
+
+	// path aggregation
+	memset(m_pAggregatedCosts, 0, width * height * nPaddedDisparities * sizeof(short));
+
+	Threading::ParallelFor(AggregateHorizontalRows, &context, height, 8);
+
+	context.nDirections = nVerticalDirections;
+	context.pDirectionsX[0] = 0;
+	context.pDirectionsX[1] = -1;
+	context.pDirectionsX[2] = 1;
+
+	InitPathBuffer(m_pPathBuffer, 2 * nVerticalDirections * width, nEntrySize);
+
+	// top to bottom and bottom to top, each together with the diagonals in the same vertical direction
+	for (int nSweep = 0; nSweep < 2; nSweep++)
+	{
+		context.pPrevious = m_pPathBuffer;
+		context.pCurrent = m_pPathBuffer + nVerticalDirections * width * nEntrySize;
+		context.pPreviousMinima = m_pPathMinima;
+		context.pCurrentMinima = m_pPathMinima + nVerticalDirections * width;
+
+		for (int i = 0; i < height; i++)
+		{
+			const int y = nSweep == 0 ? i : height - 1 - i;
+			const int offset = y * width * nPaddedDisparities;
+
+			context.bFirstRow = i == 0;
+			context.pCosts = m_pCosts + offset;
+			context.pSums = m_pAggregatedCosts + offset;
+
+			Threading::ParallelFor(AggregateVerticalRow, &context, width, 64);
+
+			short *pTemp = context.pPrevious;
+			context.pPrevious = context.pCurrent;
+			context.pCurrent = pTemp;
+
+			int *pTempMinima = context.pPreviousMinima;
+			context.pPreviousMinima = context.pCurrentMinima;
+			context.pCurrentMinima = pTempMinima;
+		}
+	}
+
+	context.pCosts = m_pCosts;
+	context.pSums = m_pAggregatedCosts;
+
+	// disparity selection
+	Threading::ParallelFor(SelectDisparityRows, &context, height, 8);
+
+	return true;
+}
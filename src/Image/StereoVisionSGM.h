@@ -0,0 +1,190 @@
+// ****************************************************************************
+// This file is part of the Integrating Vision Toolkit (IVT).
+//
+// The IVT is maintained by the Karlsruhe Institute of Technology (KIT)
+// (www.kit.edu) in cooperation with the company Keyetech (www.keyetech.de).
+//
+// Copyright (C) 2014 Karlsruhe Institute of Technology (KIT).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the KIT nor the names of its contributors may be
+//    used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE KIT AND CONTRIBUTORS “AS IS” AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE KIT OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ****************************************************************************
+// ****************************************************************************
+// Filename:  StereoVisionSGM.h
+// Author:    agent
+// Date:      17.10.2026
+// ****************************************************************************
+
+
+#ifndef _STEREO_VISION_SGM_H_
+#define _STEREO_VISION_SGM_H_
+
+
+// ****************************************************************************
+// Defines
+// ****************************************************************************
+
+// value written to the disparity image for pixels without a valid disparity
+#define SGM_INVALID_DISPARITY	(-32768)
+
+// number of fractional bits of the disparities written by CStereoVisionSGM::Process
+#define SGM_DISPARITY_SHIFT		4
+
+
+
+// ****************************************************************************
+// Forward declarations
+// ****************************************************************************
+
+class CByteImage;
+class CShortImage;
+
+
+
+// ****************************************************************************
+// CStereoVisionSGM
+// ****************************************************************************
+
+/*!
+	\ingroup StereoProcessing
+	\brief Calculation of dense disparity maps with Semi-Global Matching (SGM).
+
+	The matching costs are computed for each pixel of the left image and each disparity of the range
+	[nMinDisparity, nMinDisparity + nNumberOfDisparities), either as the Hamming distance of 9x7 census transforms (default)
+	or as the 3x3 sum of absolute differences (scaled by 1/8 and saturated to 255).
+	The costs are aggregated along 4 or 8 paths with the smoothness penalties P1 (disparity changes of one pixel)
+	and P2 (larger disparity changes). The disparity of each pixel is then selected by a winner-takes-all decision with
+	an optional uniqueness test and left-right consistency check, and refined to subpixel accuracy by fitting a parabola.
+
+	The cost volume and the aggregated costs are stored with the disparity as the innermost dimension,
+	so that the memory consumption is proportional to width * height * nNumberOfDisparities (3 bytes per entry).
+	The buffers are kept between calls and only reallocated if a larger volume is needed.
+	If the IVT is built with USE_SIMD, the census transform, the census costs, the path aggregation and the disparity selection use SSE2.
+
+	The cost computation, the aggregation and the disparity selection are distributed to the library-wide worker pool
+	if it has been enabled with Threading::SetNumberOfWorkerThreads(int). The result does not depend on the number of threads.
+
+	The input images must be rectified and of type CByteImage::eGrayScale.
+	The disparity d of a pixel (x, y) in the left image refers to the pixel (x - d, y) in the right image.
+*/
+class CStereoVisionSGM
+{
+public:
+	// enums
+	enum CostFunction
+	{
+		eCensus,
+		eSAD
+	};
+
+	// constructor
+	CStereoVisionSGM();
+
+	// destructor
+	~CStereoVisionSGM();
+
+
+	// public methods
+	/*!
+		\brief Sets the function used for computing the matching costs (default: eCensus).
+	*/
+	void SetCostFunction(CostFunction costFunction) { m_costFunction = costFunction; }
+
+	/*!
+		\brief Sets the number of aggregation paths, which must be 4 (horizontal and vertical) or 8 (additionally the diagonals). The default is 8.
+
+		@return true on success and false if nPaths is neither 4 nor 8.
+	*/
+	bool SetNumberOfPaths(int nPaths);
+
+	/*!
+		\brief Sets the smoothness penalties (default: P1 = 10, P2 = 120).
+
+		The penalties are specified in units of the matching costs, which are in the range 0..62 for census and 0..255 for SAD.
+
+		@return true on success and false if the condition 0 <= nP1 <= nP2 <= 3000 is not satisfied.
+	*/
+	bool SetPenalties(int nP1, int nP2);
+
+	/*!
+		\brief Sets the uniqueness ratio in percent (default: 10).
+
+		A disparity is rejected if the aggregated cost of another disparity, which is not a direct neighbor,
+		is less than (100 + nPercent)% of the minimum cost. A value of 0 disables the test.
+	*/
+	void SetUniquenessRatio(int nPercent) { m_nUniquenessRatio = nPercent < 0 ? 0 : nPercent; }
+
+	/*!
+		\brief Sets the maximum difference of the left and the right disparity in pixels (default: 1).
+
+		The right disparities are derived from the aggregated costs of the left image. A negative value disables the check.
+	*/
+	void SetLeftRightCheck(int nMaxDifference) { m_nMaxLeftRightDifference = nMaxDifference; }
+
+	/*!
+		\brief Computes the disparity map for a rectified stereo image pair.
+
+		The disparities are written with SGM_DISPARITY_SHIFT fractional bits, i.e. the value 16 * d for the disparity d.
+		Pixels without a valid disparity are set to SGM_INVALID_DISPARITY.
+
+		@param[in] pLeftImage The left image. Must be of type CByteImage::eGrayScale.
+		@param[in] pRightImage The right image. Must be of type CByteImage::eGrayScale and of the same size as pLeftImage.
+		@param[out] pDisparityImage The disparity map. Must be of the same size as pLeftImage.
+		@param[in] nMinDisparity The minimum disparity.
+		@param[in] nNumberOfDisparities The number of disparities to search, starting with nMinDisparity.
+		@return true on success and false on failure.
+	*/
+	bool Process(const CByteImage *pLeftImage, const CByteImage *pRightImage, CShortImage *pDisparityImage,
+		int nMinDisparity, int nNumberOfDisparities);
+	
+
+private:
+	// private methods
+	void AllocateBuffers(int nPixels, int nVolume, int nPathEntries, int nPathEntrySize);
+	void FreeBuffers();
+
+	// private attributes
+	CostFunction m_costFunction;
+	int m_nPaths;
+	int m_nP1;
+	int m_nP2;
+	int m_nUniquenessRatio;
+	int m_nMaxLeftRightDifference;
+
+	unsigned int *m_pCensus;
+	unsigned char *m_pCosts;
+	short *m_pAggregatedCosts;
+	short *m_pPathBuffer;
+	int *m_pPathMinima;
+	int m_nAllocatedPixels;
+	int m_nAllocatedVolume;
+	int m_nAllocatedPathBuffer;
+	int m_nAllocatedPathMinima;
+};
+
+
+
+#endif /* _STEREO_VISION_SGM_H_ */
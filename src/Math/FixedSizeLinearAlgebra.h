@@ -0,0 +1,431 @@
+// ****************************************************************************
+// This file is part of the Integrating Vision Toolkit (IVT).
+//
+// The IVT is maintained by the Karlsruhe Institute of Technology (KIT)
+// (www.kit.edu) in cooperation with the company Keyetech (www.keyetech.de).
+//
+// Copyright (C) 2014 Karlsruhe Institute of Technology (KIT).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the KIT nor the names of its contributors may be
+//    used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE KIT AND CONTRIBUTORS “AS IS” AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE KIT OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ****************************************************************************
+// ****************************************************************************
+// Filename:  FixedSizeLinearAlgebra.h
+// Author:    agent
+// Date:      17.10.2026
+// ****************************************************************************
+
+
+#ifndef _FIXED_SIZE_LINEAR_ALGEBRA_H_
+#define _FIXED_SIZE_LINEAR_ALGEBRA_H_
+
+
+// ****************************************************************************
+// Necessary includes
+// ****************************************************************************
+
+#include "Math/Math2d.h"
+#include "Math/Math3d.h"
+
+#include <math.h>
+
+
+
+// ****************************************************************************
+// FixedSizeLinearAlgebra
+// ****************************************************************************
+
+/*!
+	\ingroup MathOperations
+	\brief Solvers for small systems whose size is known at compile time.
+
+	In contrast to the functions in LinearAlgebra, these functions work on the stack only and do not allocate any memory,
+	so that they are suited for the inner loops of e.g. RANSAC. All computations are carried out in double precision.
+*/
+namespace FixedSizeLinearAlgebra
+{
+	/*!
+		\brief Solves the linear system A x = b with Gaussian elimination and partial pivoting.
+
+		A and b are overwritten. Returns false if the absolute value of a pivot is smaller than fEpsilon (the matrix is singular or nearly so).
+	*/
+	template <int N> bool SolveLinearSystem(double (&A)[N][N], double (&b)[N], double (&x)[N], double fEpsilon = 1e-10)
+	{
+		int i, j, k;
+		
+		for (k = 0; k < N; k++)
+		{
+			// find pivot
+			int nPivot = k;
+			double max = fabs(A[k][k]);
+			
+			for (i = k + 1; i < N; i++)
+			{
+				if (fabs(A[i][k]) > max)
+				{
+					max = fabs(A[i][k]);
+					nPivot = i;
+				}
+			}
+			
+			if (max < fEpsilon)
+				return false;
+			
+			if (nPivot != k)
+			{
+				for (j = k; j < N; j++)
+				{
+					const double temp = A[k][j];
+					A[k][j] = A[nPivot][j];
+					A[nPivot][j] = temp;
+				}
+				
+				const double temp = b[k];
+				b[k] = b[nPivot];
+				b[nPivot] = temp;
+			}
+			
+			// eliminate
+			const double factor = 1.0 / A[k][k];
+			
+			for (i = k + 1; i < N; i++)
+			{
+				const double m = A[i][k] * factor;
+				
+				for (j = k + 1; j < N; j++)
+					A[i][j] -= m * A[k][j];
+				
+				b[i] -= m * b[k];
+			}
+		}
+		
+		// back substitution
+		for (k = N - 1; k >= 0; k--)
+		{
+			double sum = b[k];
+			
+			for (j = k + 1; j < N; j++)
+				sum -= A[k][j] * x[j];
+			
+			x[k] = sum / A[k][k];
+		}
+		
+		return true;
+	}
+	
+	/*!
+		\brief Calculates the eigenvalues and eigenvectors of the symmetric matrix A with the cyclic Jacobi method.
+
+		A is overwritten. The i-th eigenvector is stored in the i-th column of eigenvectors.
+	*/
+	template <int N> void SymmetricEigenvectors(double (&A)[N][N], double (&eigenvalues)[N], double (&eigenvectors)[N][N])
+	{
+		int i, j, k;
+		
+		for (i = 0; i < N; i++)
+			for (j = 0; j < N; j++)
+				eigenvectors[i][j] = i == j ? 1.0 : 0.0;
+		
+		for (int nSweep = 0; nSweep < 50; nSweep++)
+		{
+			double off = 0.0, diagonal = 0.0;
+			
+			for (i = 0; i < N; i++)
+			{
+				diagonal += A[i][i] * A[i][i];
+				
+				for (j = i + 1; j < N; j++)
+					off += A[i][j] * A[i][j];
+			}
+			
+			if (off <= 1e-30 * diagonal || off == 0.0)
+				break;
+			
+			for (i = 0; i < N - 1; i++)
+			{
+				for (j = i + 1; j < N; j++)
+				{
+					if (A[i][j] == 0.0)
+						continue;
+					
+					// rotation that annihilates A[i][j]
+					const double theta = (A[j][j] - A[i][i]) / (2.0 * A[i][j]);
+					const double t = (theta >= 0.0 ? 1.0 : -1.0) / (fabs(theta) + sqrt(theta * theta + 1.0));
+					const double c = 1.0 / sqrt(t * t + 1.0);
+					const double s = t * c;
+					
+					for (k = 0; k < N; k++)
+					{
+						const double a_ki = A[k][i], a_kj = A[k][j];
+						A[k][i] = c * a_ki - s * a_kj;
+						A[k][j] = s * a_ki + c * a_kj;
+					}
+					
+					for (k = 0; k < N; k++)
+					{
+						const double a_ik = A[i][k], a_jk = A[j][k];
+						A[i][k] = c * a_ik - s * a_jk;
+						A[j][k] = s * a_ik + c * a_jk;
+					}
+					
+					for (k = 0; k < N; k++)
+					{
+						const double v_ki = eigenvectors[k][i], v_kj = eigenvectors[k][j];
+						eigenvectors[k][i] = c * v_ki - s * v_kj;
+						eigenvectors[k][j] = s * v_ki + c * v_kj;
+					}
+				}
+			}
+		}
+		
+		for (i = 0; i < N; i++)
+			eigenvalues[i] = A[i][i];
+	}
+	
+	/*!
+		\brief Calculates the similarity transformation that moves the centroid of the points to the origin
+		and scales them to an average distance of sqrt(2) from it (Hartley normalization).
+
+		The normalized coordinates of the i-th point are ((x - cx) * s, (y - cy) * s).
+		Returns false if all points are identical.
+	*/
+	inline bool CalculateNormalization(const Vec2d *pPoints, int nPoints, double &cx, double &cy, double &s)
+	{
+		int i;
+		
+		cx = cy = 0.0;
+		
+		for (i = 0; i < nPoints; i++)
+		{
+			cx += pPoints[i].x;
+			cy += pPoints[i].y;
+		}
+		
+		cx /= nPoints;
+		cy /= nPoints;
+		
+		double distance = 0.0;
+		
+		for (i = 0; i < nPoints; i++)
+		{
+			const double dx = pPoints[i].x - cx;
+			const double dy = pPoints[i].y - cy;
+			distance += sqrt(dx * dx + dy * dy);
+		}
+		
+		if (distance == 0.0)
+			return false;
+		
+		s = 1.4142135623730951 * nPoints / distance;
+		
+		return true;
+	}
+	
+	/*!
+		\brief Calculates the transformation T'^-1 * B * T from a transformation B between normalized coordinates
+		(see CalculateNormalization) and stores it in A with A.r9 = 1.
+
+		Returns false if the resulting transformation cannot be scaled to A.r9 = 1.
+	*/
+	inline bool Denormalize(const double (&B)[3][3], double cx, double cy, double s, double tx, double ty, double ts, Mat3d &A)
+	{
+		// B * T with T = (s 0 -s*cx, 0 s -s*cy, 0 0 1)
+		double BT[3][3];
+		
+		for (int i = 0; i < 3; i++)
+		{
+			BT[i][0] = B[i][0] * s;
+			BT[i][1] = B[i][1] * s;
+			BT[i][2] = B[i][2] - s * (B[i][0] * cx + B[i][1] * cy);
+		}
+		
+		// T'^-1 * (B * T) with T'^-1 = (1/ts 0 tx, 0 1/ts ty, 0 0 1)
+		const double its = 1.0 / ts;
+		double R[3][3];
+		
+		for (int j = 0; j < 3; j++)
+		{
+			R[0][j] = its * BT[0][j] + tx * BT[2][j];
+			R[1][j] = its * BT[1][j] + ty * BT[2][j];
+			R[2][j] = BT[2][j];
+		}
+		
+		if (fabs(R[2][2]) < 1e-12)
+			return false;
+		
+		const double f = 1.0 / R[2][2];
+		
+		Math3d::SetMat(A, float(R[0][0] * f), float(R[0][1] * f), float(R[0][2] * f),
+			float(R[1][0] * f), float(R[1][1] * f), float(R[1][2] * f),
+			float(R[2][0] * f), float(R[2][1] * f), 1.0f);
+		
+		return true;
+	}
+	
+	/*!
+		\brief Determines an affine transformation A with A * pSourcePoints[i] = pTargetPoints[i] from N >= 3 point correspondences.
+
+		The points are normalized (see CalculateNormalization). For N = 3, the system is solved directly,
+		otherwise in the sense of least squares by means of the normal equations. Returns false for degenerate configurations.
+	*/
+	template <int N> bool DetermineAffineTransformation(const Vec2d *pSourcePoints, const Vec2d *pTargetPoints, Mat3d &A)
+	{
+		typedef char SizeCheck[N >= 3 ? 1 : -1];
+		(void) sizeof(SizeCheck);
+		
+		double cx, cy, s, tx, ty, ts;
+		
+		if (!CalculateNormalization(pSourcePoints, N, cx, cy, s) || !CalculateNormalization(pTargetPoints, N, tx, ty, ts))
+			return false;
+		
+		double M[3][3], Mx[3][3], bx[3], by[3], x[3], y[3];
+		int i, j;
+		
+		if (N == 3)
+		{
+			for (i = 0; i < 3; i++)
+			{
+				M[i][0] = (pSourcePoints[i].x - cx) * s;
+				M[i][1] = (pSourcePoints[i].y - cy) * s;
+				M[i][2] = 1.0;
+				bx[i] = (pTargetPoints[i].x - tx) * ts;
+				by[i] = (pTargetPoints[i].y - ty) * ts;
+			}
+		}
+		else
+		{
+			// normal equations
+			for (i = 0; i < 3; i++)
+			{
+				bx[i] = by[i] = 0.0;
+				
+				for (j = 0; j < 3; j++)
+					M[i][j] = 0.0;
+			}
+			
+			for (int k = 0; k < N; k++)
+			{
+				const double r[3] = { (pSourcePoints[k].x - cx) * s, (pSourcePoints[k].y - cy) * s, 1.0 };
+				const double u = (pTargetPoints[k].x - tx) * ts;
+				const double v = (pTargetPoints[k].y - ty) * ts;
+				
+				for (i = 0; i < 3; i++)
+				{
+					for (j = 0; j < 3; j++)
+						M[i][j] += r[i] * r[j];
+					
+					bx[i] += r[i] * u;
+					by[i] += r[i] * v;
+				}
+			}
+		}
+		
+		for (i = 0; i < 3; i++)
+			for (j = 0; j < 3; j++)
+				Mx[i][j] = M[i][j];
+		
+		if (!SolveLinearSystem<3>(Mx, bx, x) || !SolveLinearSystem<3>(M, by, y))
+			return false;
+		
+		const double B[3][3] = { { x[0], x[1], x[2] }, { y[0], y[1], y[2] }, { 0.0, 0.0, 1.0 } };
+		
+		return Denormalize(B, cx, cy, s, tx, ty, ts, A);
+	}
+	
+	/*!
+		\brief Determines a homography A with A * pSourcePoints[i] = pTargetPoints[i] (in homogeneous coordinates) from N >= 4 point correspondences.
+
+		The points are normalized (see CalculateNormalization) and the system from LinearAlgebra::DetermineHomography is set up with the normalized coordinates.
+		For N = 4, it is solved directly, otherwise in the sense of least squares by means of the normal equations.
+		Returns false for degenerate configurations.
+	*/
+	template <int N> bool DetermineHomography(const Vec2d *pSourcePoints, const Vec2d *pTargetPoints, Mat3d &A)
+	{
+		typedef char SizeCheck[N >= 4 ? 1 : -1];
+		(void) sizeof(SizeCheck);
+		
+		double cx, cy, s, tx, ty, ts;
+		
+		if (!CalculateNormalization(pSourcePoints, N, cx, cy, s) || !CalculateNormalization(pTargetPoints, N, tx, ty, ts))
+			return false;
+		
+		double M[8][8], b[8], h[8];
+		int i, j, k;
+		
+		if (N == 4)
+		{
+			for (k = 0; k < 4; k++)
+			{
+				const double u = (pSourcePoints[k].x - cx) * s, v = (pSourcePoints[k].y - cy) * s;
+				const double u_ = (pTargetPoints[k].x - tx) * ts, v_ = (pTargetPoints[k].y - ty) * ts;
+				double *r1 = M[2 * k], *r2 = M[2 * k + 1];
+				
+				r1[0] = u; r1[1] = v; r1[2] = 1.0; r1[3] = 0.0; r1[4] = 0.0; r1[5] = 0.0; r1[6] = -u * u_; r1[7] = -v * u_;
+				r2[0] = 0.0; r2[1] = 0.0; r2[2] = 0.0; r2[3] = u; r2[4] = v; r2[5] = 1.0; r2[6] = -u * v_; r2[7] = -v * v_;
+				b[2 * k] = u_;
+				b[2 * k + 1] = v_;
+			}
+		}
+		else
+		{
+			// normal equations
+			for (i = 0; i < 8; i++)
+			{
+				b[i] = 0.0;
+				
+				for (j = 0; j < 8; j++)
+					M[i][j] = 0.0;
+			}
+			
+			for (k = 0; k < N; k++)
+			{
+				const double u = (pSourcePoints[k].x - cx) * s, v = (pSourcePoints[k].y - cy) * s;
+				const double u_ = (pTargetPoints[k].x - tx) * ts, v_ = (pTargetPoints[k].y - ty) * ts;
+				const double r1[8] = { u, v, 1.0, 0.0, 0.0, 0.0, -u * u_, -v * u_ };
+				const double r2[8] = { 0.0, 0.0, 0.0, u, v, 1.0, -u * v_, -v * v_ };
+				
+				for (i = 0; i < 8; i++)
+				{
+					for (j = 0; j < 8; j++)
+						M[i][j] += r1[i] * r1[j] + r2[i] * r2[j];
+					
+					b[i] += r1[i] * u_ + r2[i] * v_;
+				}
+			}
+		}
+		
+		if (!SolveLinearSystem<8>(M, b, h))
+			return false;
+		
+		const double B[3][3] = { { h[0], h[1], h[2] }, { h[3], h[4], h[5] }, { h[6], h[7], 1.0 } };
+		
+		return Denormalize(B, cx, cy, s, tx, ty, ts, A);
+	}
+}
+
+
+
+#endif /* _FIXED_SIZE_LINEAR_ALGEBRA_H_ */
@@ -63,24 +63,25 @@ CFloatMatrix::CFloatMatrix()
 {
 	columns = 0;
 	rows = 0;
+	stride = 0;
 	data = 0;
 	m_bOwnMemory = false;
 }
 
-CFloatMatrix::CFloatMatrix(int nColumns, int nRows, bool bHeaderOnly)
+CFloatMatrix::CFloatMatrix(int nColumns, int nRows, bool bHeaderOnly, bool bPadded)
 {
 	columns = nColumns;
 	rows = nRows;
 
 	if (bHeaderOnly)
 	{
+		stride = columns;
 		data = 0;
 		m_bOwnMemory = false;
 	}
 	else
 	{
-        data = new float[columns * rows];
-		m_bOwnMemory = true;
+		AllocateMemory(bPadded);
 	}
 }
 
@@ -91,13 +92,13 @@ CFloatMatrix::CFloatMatrix(const CFloatMatrix &matrix, bool bHeaderOnly)
 	
 	if (bHeaderOnly)
 	{
+		stride = matrix.stride;
 		data = 0;
 		m_bOwnMemory = false;
 	}
 	else
 	{
-		data = new float[columns * rows];
-		m_bOwnMemory = true;
+		AllocateMemory(matrix.IsPadded());
 	}
 }
 
@@ -108,13 +109,13 @@ CFloatMatrix::CFloatMatrix(const CFloatMatrix *pMatrix, bool bHeaderOnly)
 	
 	if (bHeaderOnly)
 	{
+		stride = pMatrix->stride;
 		data = 0;
 		m_bOwnMemory = false;
 	}
 	else
 	{
-		data = new float[columns * rows];
-		m_bOwnMemory = true;
+		AllocateMemory(pMatrix->IsPadded());
 	}
 }
 
@@ -128,12 +129,26 @@ CFloatMatrix::~CFloatMatrix()
 // Methods
 // ****************************************************************************
 
+bool CFloatMatrix::IsPadded() const
+{
+	return stride != 0 && stride != columns;
+}
+
+void CFloatMatrix::AllocateMemory(bool bPadded)
+{
+	const int nAlignment = IVT_ROW_ALIGNMENT / sizeof(float);
+	
+	stride = bPadded ? (columns + nAlignment - 1) / nAlignment * nAlignment : columns;
+	data = (float *) aligned_malloc(stride * rows * sizeof(float), IVT_ROW_ALIGNMENT);
+	m_bOwnMemory = true;
+}
+
 void CFloatMatrix::FreeMemory()
 {
 	if (data)
 	{
 		if (m_bOwnMemory)
-            delete [] data;
+			aligned_free(data);
 
 		data = 0;
 		m_bOwnMemory = false;
@@ -172,13 +187,10 @@ bool CFloatMatrix::LoadFromFile(const char *pFileName)
 	}
 	
 	// allocate memory for data and read data
+	FreeMemory();
 	columns = nColumns;
 	rows = nRows;
-	if (data && m_bOwnMemory)
-		delete [] data;
-		
-	data = new float[columns * rows];
-	m_bOwnMemory = true;
+	AllocateMemory(false);
 	
 	if (fread(data, columns * rows * sizeof(float), 1, f) != 1)
 	{
@@ -202,6 +214,17 @@ bool CFloatMatrix::SaveToFile(const char *pFileName)
 	if (!data || !rows || !columns)
 		return false;
 
+	if (IsPadded())
+	{
+		// write an unpadded copy
+		CFloatMatrix matrix(columns, rows);
+		
+		for (int i = 0; i < rows; i++)
+			memcpy(matrix.data + i * columns, data + i * stride, columns * sizeof(float));
+		
+		return matrix.SaveToFile(pFileName);
+	}
+
 	FILE *f = fopen(pFileName, "wb");
 	if (!f)
 		return false;
@@ -58,9 +58,9 @@ class CFloatMatrix
 public:
 	// constructors
 	CFloatMatrix();
-	CFloatMatrix(int nColumns, int nRows, bool bHeaderOnly = false);
+	CFloatMatrix(int nColumns, int nRows, bool bHeaderOnly = false, bool bPadded = false);
 
-	// copy constructors (will copy header and allocate memory)
+	// copy constructors (will copy header including row layout and allocate memory)
 	CFloatMatrix(const CFloatMatrix *pMatrix, bool bHeaderOnly = false);
 	CFloatMatrix(const CFloatMatrix &matrix, bool bHeaderOnly = false);
 
@@ -70,17 +70,21 @@ public:
 	// public methods
 	bool LoadFromFile(const char *pFileName);
 	bool SaveToFile(const char *pFileName);
+	bool IsPadded() const;
+	// distance between two rows, also for headers filled in manually with stride = 0 (unpadded)
+	int GetStride() const { return stride ? stride : columns; }
 	
 	// operators
-	inline float& operator() (const int nColumn, const int nRow) { return data[nRow * columns + nColumn]; }
-	inline float* operator[] (const int nRow) { return data + nRow * columns; }
+	inline float& operator() (const int nColumn, const int nRow) { return data[nRow * GetStride() + nColumn]; }
+	inline float* operator[] (const int nRow) { return data + nRow * GetStride(); }
 
-	inline const float& operator() (const int nColumn, const int nRow) const { return data[nRow * columns + nColumn]; }
-	inline const float* operator[] (const int nRow) const { return data + nRow * columns; }
+	inline const float& operator() (const int nColumn, const int nRow) const { return data[nRow * GetStride() + nColumn]; }
+	inline const float* operator[] (const int nRow) const { return data + nRow * GetStride(); }
 
 
 private:
 	// private methods
+	void AllocateMemory(bool bPadded);
 	void FreeMemory();
 	
 
@@ -89,6 +93,7 @@ public:
 	int columns;
 	int rows;
 	float *data;
+	int stride; // distance between two rows in elements (padded matrices are only supported by ImageProcessor)
 
 private:
 	// private attributes - only used internally
@@ -53,6 +53,7 @@
 #include "Math/FloatVector.h"
 #include "Math/DoubleMatrix.h"
 #include "Math/DoubleVector.h"
+#include "Math/FixedSizeLinearAlgebra.h"
 
 #include <stdio.h>
 #include <math.h>
@@ -1726,3 +1727,60 @@ bool LinearAlgebra::DetermineHomography(const Vec2d *pSourcePoints, const Vec2d
 	
 	return true;
 }
+
+bool LinearAlgebra::DetermineHomographyDLT(const Vec2d *pSourcePoints, const Vec2d *pTargetPoints, int nPoints, Mat3d &A)
+{
+	if (nPoints < 4)
+	{
+		printf("error: not enough input point pairs for LinearAlgebra::DetermineHomographyDLT (must be at least 4)\n");
+		return false;
+	}
+	
+	double cx, cy, s, tx, ty, ts;
+	
+	if (!FixedSizeLinearAlgebra::CalculateNormalization(pSourcePoints, nPoints, cx, cy, s) ||
+		!FixedSizeLinearAlgebra::CalculateNormalization(pTargetPoints, nPoints, tx, ty, ts))
+		return false;
+	
+	// M^T M for the rows (u, v, 1, 0, 0, 0, -u u', -v u', -u') and (0, 0, 0, u, v, 1, -u v', -v v', -v')
+	double MTM[9][9];
+	int i, j, k;
+	
+	for (i = 0; i < 9; i++)
+		for (j = 0; j < 9; j++)
+			MTM[i][j] = 0.0;
+	
+	for (k = 0; k < nPoints; k++)
+	{
+		const double u = (pSourcePoints[k].x - cx) * s, v = (pSourcePoints[k].y - cy) * s;
+		const double u_ = (pTargetPoints[k].x - tx) * ts, v_ = (pTargetPoints[k].y - ty) * ts;
+		const double r1[9] = { u, v, 1.0, 0.0, 0.0, 0.0, -u * u_, -v * u_, -u_ };
+		const double r2[9] = { 0.0, 0.0, 0.0, u, v, 1.0, -u * v_, -v * v_, -v_ };
+		
+		for (i = 0; i < 9; i++)
+			for (j = i; j < 9; j++)
+				MTM[i][j] += r1[i] * r1[j] + r2[i] * r2[j];
+	}
+	
+	for (i = 0; i < 9; i++)
+		for (j = 0; j < i; j++)
+			MTM[i][j] = MTM[j][i];
+	
+	double eigenvalues[9], eigenvectors[9][9];
+	FixedSizeLinearAlgebra::SymmetricEigenvectors<9>(MTM, eigenvalues, eigenvectors);
+	
+	int nMin = 0;
+	
+	for (i = 1; i < 9; i++)
+		if (eigenvalues[i] < eigenvalues[nMin])
+			nMin = i;
+	
+	const double B[3][3] =
+	{
+		{ eigenvectors[0][nMin], eigenvectors[1][nMin], eigenvectors[2][nMin] },
+		{ eigenvectors[3][nMin], eigenvectors[4][nMin], eigenvectors[5][nMin] },
+		{ eigenvectors[6][nMin], eigenvectors[7][nMin], eigenvectors[8][nMin] }
+	};
+	
+	return FixedSizeLinearAlgebra::Denormalize(B, cx, cy, s, tx, ty, ts, A);
+}
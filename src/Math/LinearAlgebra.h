@@ -212,6 +212,24 @@ namespace LinearAlgebra
 		@param nPoints Number of points. Must be at least 4.
 	*/
 	bool DetermineHomography(const Vec2d *pSourcePoints, const Vec2d *pTargetPoints, int nPoints, Mat3d &A, bool bUseSVD = false);
+
+	/*!
+		\brief Determines a homography based on a set of 2d-2d point correspondences with the normalized direct linear transformation (DLT).
+
+		The points are normalized to the centroid and an average distance of sqrt(2) (see FixedSizeLinearAlgebra::CalculateNormalization).
+		The homography is then given by the eigenvector of the smallest eigenvalue of M^T M, where M is the 2n x 9 matrix of the homogeneous system
+		corresponding to the one in DetermineHomography. In contrast to DetermineHomography, no memory is allocated and the result is not biased by fixing a9 = 1
+		before the minimization, which makes this function suited for refitting a homography to the inliers of RANSAC.
+
+		The n-th entry in pSourcePoints must correspond with the n-th entry in pTargetPoints.
+
+		@param pSourcePoints The source points.
+		@param pTargetPoints The target points.
+		@param nPoints Number of points. Must be at least 4.
+		@param A The result, scaled so that a9 = 1.
+		@return false if nPoints < 4 or the configuration is degenerate.
+	*/
+	bool DetermineHomographyDLT(const Vec2d *pSourcePoints, const Vec2d *pTargetPoints, int nPoints, Mat3d &A);
 }
 
 
@@ -1414,6 +1414,7 @@ cvSVD( const CFloatMatrix* aarr, CFloatMatrix* warr, CFloatMatrix* uarr, CFloatM
     {
 		tmat.rows = m;
 		tmat.columns = n;
+		tmat.stride = n;
 		tmat.data = (float *)(buffer + a_buf_offset * pix_size);
 
         if( !t_svd )
@@ -1427,6 +1428,7 @@ cvSVD( const CFloatMatrix* aarr, CFloatMatrix* warr, CFloatMatrix* uarr, CFloatM
     {
 		ustub.rows = u_cols;
 		ustub.columns = u_rows;
+		ustub.stride = u_rows;
 		ustub.data = (float *)(buffer + u_buf_offset * pix_size);
         u = &ustub;
     }
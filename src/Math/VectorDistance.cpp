@@ -0,0 +1,749 @@
+// ****************************************************************************
+// This file is part of the Integrating Vision Toolkit (IVT).
+//
+// The IVT is maintained by the Karlsruhe Institute of Technology (KIT)
+// (www.kit.edu) in cooperation with the company Keyetech (www.keyetech.de).
+//
+// Copyright (C) 2014 Karlsruhe Institute of Technology (KIT).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the KIT nor the names of its contributors may be
+//    used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE KIT AND CONTRIBUTORS “AS IS” AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE KIT OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ****************************************************************************
+// ****************************************************************************
+// Filename:  VectorDistance.cpp
+// Author:    agent
+// Date:      17.10.2026
+// ****************************************************************************
+
+
+// ****************************************************************************
+// Includes
+// ****************************************************************************
+
+#include "VectorDistance.h"
+#include "Helpers/OptimizedFunctionsSIMD.h"
+#include "Threading/WorkerPool.h"
+
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+
+#if defined(USE_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define SIMD_AVAILABLE
+#endif
+
+
+#ifdef SIMD_AVAILABLE
+
+#include <emmintrin.h>
+#include <immintrin.h>
+
+#if defined(_MSC_VER)
+#define SIMD_TARGET_AVX2
+#else
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+#endif /* SIMD_AVAILABLE */
+
+
+
+// ****************************************************************************
+// Static functions
+// ****************************************************************************
+
+static unsigned int SquaredDistanceGeneric(const unsigned char *pVector1, const unsigned char *pVector2, int nDimension)
+{
+	unsigned int sum = 0;
+
+	for (int i = 0; i < nDimension; i++)
+	{
+		const int d = pVector1[i] - pVector2[i];
+		sum += d * d;
+	}
+
+	return sum;
+}
+
+#ifdef SIMD_AVAILABLE
+
+static unsigned int SquaredDistanceSSE2(const unsigned char *pVector1, const unsigned char *pVector2, int nDimension)
+{
+	const __m128i zero = _mm_setzero_si128();
+	__m128i sum = _mm_setzero_si128();
+	int i;
+
+	for (i = 0; i + 16 <= nDimension; i += 16)
+	{
+		const __m128i a = _mm_loadu_si128((const __m128i *) (pVector1 + i));
+		const __m128i b = _mm_loadu_si128((const __m128i *) (pVector2 + i));
+
+		// differences in [-255, 255] as 16 bit values, squares summed pairwise to 32 bit
+		const __m128i dl = _mm_sub_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+		const __m128i dh = _mm_sub_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+
+		sum = _mm_add_epi32(sum, _mm_madd_epi16(dl, dl));
+		sum = _mm_add_epi32(sum, _mm_madd_epi16(dh, dh));
+	}
+
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+
+	return (unsigned int) _mm_cvtsi128_si32(sum) + SquaredDistanceGeneric(pVector1 + i, pVector2 + i, nDimension - i);
+}
+
+SIMD_TARGET_AVX2 static unsigned int SquaredDistanceAVX2(const unsigned char *pVector1, const unsigned char *pVector2, int nDimension)
+{
+	__m256i sum = _mm256_setzero_si256();
+	int i;
+
+	for (i = 0; i + 32 <= nDimension; i += 32)
+	{
+		const __m256i dl = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (pVector1 + i))), _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (pVector2 + i))));
+		const __m256i dh = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (pVector1 + i + 16))), _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (pVector2 + i + 16))));
+
+		sum = _mm256_add_epi32(sum, _mm256_madd_epi16(dl, dl));
+		sum = _mm256_add_epi32(sum, _mm256_madd_epi16(dh, dh));
+	}
+
+	__m128i sum128 = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+	sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, _MM_SHUFFLE(1, 0, 3, 2)));
+	sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, _MM_SHUFFLE(2, 3, 0, 1)));
+
+	unsigned int result = (unsigned int) _mm_cvtsi128_si32(sum128);
+
+	// the remainder is computed here, because calling non-VEX SSE code with dirty upper halves of the YMM registers is expensive
+	for (; i < nDimension; i++)
+	{
+		const int d = pVector1[i] - pVector2[i];
+		result += d * d;
+	}
+
+	return result;
+}
+
+#endif /* SIMD_AVAILABLE */
+
+
+typedef unsigned int (*SquaredDistanceFunction)(const unsigned char *pVector1, const unsigned char *pVector2, int nDimension);
+
+static SquaredDistanceFunction GetSquaredDistanceFunction()
+{
+#ifdef SIMD_AVAILABLE
+	const OptimizedFunctionsSIMD::InstructionSet instructionSet = OptimizedFunctionsSIMD::GetInstructionSet();
+
+	if (instructionSet >= OptimizedFunctionsSIMD::eAVX2)
+		return SquaredDistanceAVX2;
+
+	if (instructionSet >= OptimizedFunctionsSIMD::eSSE2)
+		return SquaredDistanceSSE2;
+#endif
+
+	return SquaredDistanceGeneric;
+}
+
+
+// ****************************************************************************
+// Blocked exhaustive search for float vectors
+// ****************************************************************************
+
+// number of queries processed together by the kernels
+#define NN_QUERY_GROUP_SIZE	4
+
+// size of the blocks of vectors (in bytes) kept in the cache while processing all queries of a task
+#define NN_VECTOR_BLOCK_SIZE	(96 * 1024)
+
+
+// number of candidates per query found with the expansion |q|^2 + |v|^2 - 2 q * v, which are rescored exactly in the end
+#define NN_CANDIDATES		8
+
+// candidates of one query, sorted ascendingly
+static inline void UpdateCandidates(float fDistance, int nIndex, float *pBest, int *pBestIndex)
+{
+	if (fDistance < pBest[NN_CANDIDATES - 1])
+	{
+		int i;
+
+		for (i = NN_CANDIDATES - 1; i > 0 && fDistance < pBest[i - 1]; i--)
+		{
+			pBest[i] = pBest[i - 1];
+			pBestIndex[i] = pBestIndex[i - 1];
+		}
+
+		pBest[i] = fDistance;
+		pBestIndex[i] = nIndex;
+	}
+}
+
+// The kernels compare the vectors [nFirst, nLast) with a group of NN_QUERY_GROUP_SIZE queries
+// (stored consecutively in pQueries) and update the NN_CANDIDATES candidates of each query in pBest/pBestIndex.
+// Vector i is stored at pVectors + (i - nFirst) * nDimension, its squared norm at pVectorNorms[i - nFirst].
+typedef void (*TwoNearestNeighborsBlockFunction)(const float *pQueries, const float *pQueryNorms, const float *pVectors, const float *pVectorNorms, int nDimension, int nFirst, int nLast, float *pBest, int *pBestIndex);
+
+static void TwoNearestNeighborsBlockGeneric(const float *pQueries, const float *pQueryNorms, const float *pVectors, const float *pVectorNorms, int nDimension, int nFirst, int nLast, float *pBest, int *pBestIndex)
+{
+	const float *pQuery0 = pQueries;
+	const float *pQuery1 = pQuery0 + nDimension;
+	const float *pQuery2 = pQuery1 + nDimension;
+	const float *pQuery3 = pQuery2 + nDimension;
+
+	for (int i = nFirst; i < nLast; i++)
+	{
+		const float *pVector = pVectors + (i - nFirst) * nDimension;
+		float dot0 = 0.0f, dot1 = 0.0f, dot2 = 0.0f, dot3 = 0.0f;
+
+		for (int k = 0; k < nDimension; k++)
+		{
+			const float v = pVector[k];
+			dot0 += pQuery0[k] * v;
+			dot1 += pQuery1[k] * v;
+			dot2 += pQuery2[k] * v;
+			dot3 += pQuery3[k] * v;
+		}
+
+		UpdateCandidates(pQueryNorms[0] + pVectorNorms[i - nFirst] - 2.0f * dot0, i, pBest + 0 * NN_CANDIDATES, pBestIndex + 0 * NN_CANDIDATES);
+		UpdateCandidates(pQueryNorms[1] + pVectorNorms[i - nFirst] - 2.0f * dot1, i, pBest + 1 * NN_CANDIDATES, pBestIndex + 1 * NN_CANDIDATES);
+		UpdateCandidates(pQueryNorms[2] + pVectorNorms[i - nFirst] - 2.0f * dot2, i, pBest + 2 * NN_CANDIDATES, pBestIndex + 2 * NN_CANDIDATES);
+		UpdateCandidates(pQueryNorms[3] + pVectorNorms[i - nFirst] - 2.0f * dot3, i, pBest + 3 * NN_CANDIDATES, pBestIndex + 3 * NN_CANDIDATES);
+	}
+}
+
+#ifdef SIMD_AVAILABLE
+
+static void TwoNearestNeighborsBlockSSE2(const float *pQueries, const float *pQueryNorms, const float *pVectors, const float *pVectorNorms, int nDimension, int nFirst, int nLast, float *pBest, int *pBestIndex)
+{
+	const float *pQuery0 = pQueries;
+	const float *pQuery1 = pQuery0 + nDimension;
+	const float *pQuery2 = pQuery1 + nDimension;
+	const float *pQuery3 = pQuery2 + nDimension;
+	const __m128 queryNorms = _mm_loadu_ps(pQueryNorms);
+	const __m128 minusTwo = _mm_set1_ps(-2.0f);
+	const int nSIMDDimension = nDimension & ~3;
+
+	for (int i = nFirst; i < nLast; i += 2)
+	{
+		// the second vector is the first one again, if only one vector is left
+		const int j = i + 1 < nLast ? i + 1 : i;
+		const float *pVectorA = pVectors + (i - nFirst) * nDimension;
+		const float *pVectorB = pVectors + (j - nFirst) * nDimension;
+
+		__m128 sum0a = _mm_setzero_ps(), sum1a = _mm_setzero_ps(), sum2a = _mm_setzero_ps(), sum3a = _mm_setzero_ps();
+		__m128 sum0b = _mm_setzero_ps(), sum1b = _mm_setzero_ps(), sum2b = _mm_setzero_ps(), sum3b = _mm_setzero_ps();
+		int k;
+
+		for (k = 0; k < nSIMDDimension; k += 4)
+		{
+			const __m128 a = _mm_loadu_ps(pVectorA + k);
+			const __m128 b = _mm_loadu_ps(pVectorB + k);
+			const __m128 q0 = _mm_loadu_ps(pQuery0 + k);
+			const __m128 q1 = _mm_loadu_ps(pQuery1 + k);
+			const __m128 q2 = _mm_loadu_ps(pQuery2 + k);
+			const __m128 q3 = _mm_loadu_ps(pQuery3 + k);
+
+			sum0a = _mm_add_ps(sum0a, _mm_mul_ps(q0, a));
+			sum1a = _mm_add_ps(sum1a, _mm_mul_ps(q1, a));
+			sum2a = _mm_add_ps(sum2a, _mm_mul_ps(q2, a));
+			sum3a = _mm_add_ps(sum3a, _mm_mul_ps(q3, a));
+			sum0b = _mm_add_ps(sum0b, _mm_mul_ps(q0, b));
+			sum1b = _mm_add_ps(sum1b, _mm_mul_ps(q1, b));
+			sum2b = _mm_add_ps(sum2b, _mm_mul_ps(q2, b));
+			sum3b = _mm_add_ps(sum3b, _mm_mul_ps(q3, b));
+		}
+
+		// horizontal sums of four accumulators at once
+		_MM_TRANSPOSE4_PS(sum0a, sum1a, sum2a, sum3a);
+		_MM_TRANSPOSE4_PS(sum0b, sum1b, sum2b, sum3b);
+		__m128 dotsA = _mm_add_ps(_mm_add_ps(sum0a, sum1a), _mm_add_ps(sum2a, sum3a));
+		__m128 dotsB = _mm_add_ps(_mm_add_ps(sum0b, sum1b), _mm_add_ps(sum2b, sum3b));
+
+		if (k < nDimension)
+		{
+			float tailA[4] = { 0.0f, 0.0f, 0.0f, 0.0f }, tailB[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+			for (; k < nDimension; k++)
+			{
+				tailA[0] += pQuery0[k] * pVectorA[k]; tailB[0] += pQuery0[k] * pVectorB[k];
+				tailA[1] += pQuery1[k] * pVectorA[k]; tailB[1] += pQuery1[k] * pVectorB[k];
+				tailA[2] += pQuery2[k] * pVectorA[k]; tailB[2] += pQuery2[k] * pVectorB[k];
+				tailA[3] += pQuery3[k] * pVectorA[k]; tailB[3] += pQuery3[k] * pVectorB[k];
+			}
+
+			dotsA = _mm_add_ps(dotsA, _mm_loadu_ps(tailA));
+			dotsB = _mm_add_ps(dotsB, _mm_loadu_ps(tailB));
+		}
+
+		float distancesA[4], distancesB[4];
+		_mm_storeu_ps(distancesA, _mm_add_ps(_mm_add_ps(queryNorms, _mm_set1_ps(pVectorNorms[i - nFirst])), _mm_mul_ps(minusTwo, dotsA)));
+		_mm_storeu_ps(distancesB, _mm_add_ps(_mm_add_ps(queryNorms, _mm_set1_ps(pVectorNorms[j - nFirst])), _mm_mul_ps(minusTwo, dotsB)));
+
+		for (int q = 0; q < 4; q++)
+		{
+			UpdateCandidates(distancesA[q], i, pBest + q * NN_CANDIDATES, pBestIndex + q * NN_CANDIDATES);
+
+			if (j != i)
+				UpdateCandidates(distancesB[q], j, pBest + q * NN_CANDIDATES, pBestIndex + q * NN_CANDIDATES);
+		}
+	}
+}
+
+SIMD_TARGET_AVX2 static void TwoNearestNeighborsBlockAVX2(const float *pQueries, const float *pQueryNorms, const float *pVectors, const float *pVectorNorms, int nDimension, int nFirst, int nLast, float *pBest, int *pBestIndex)
+{
+	const float *pQuery0 = pQueries;
+	const float *pQuery1 = pQuery0 + nDimension;
+	const float *pQuery2 = pQuery1 + nDimension;
+	const float *pQuery3 = pQuery2 + nDimension;
+	const __m128 queryNorms = _mm_loadu_ps(pQueryNorms);
+	const __m128 minusTwo = _mm_set1_ps(-2.0f);
+	const int nSIMDDimension = nDimension & ~7;
+
+	for (int i = nFirst; i < nLast; i += 2)
+	{
+		// the second vector is the first one again, if only one vector is left
+		const int j = i + 1 < nLast ? i + 1 : i;
+		const float *pVectorA = pVectors + (i - nFirst) * nDimension;
+		const float *pVectorB = pVectors + (j - nFirst) * nDimension;
+
+		__m256 sum0a = _mm256_setzero_ps(), sum1a = _mm256_setzero_ps(), sum2a = _mm256_setzero_ps(), sum3a = _mm256_setzero_ps();
+		__m256 sum0b = _mm256_setzero_ps(), sum1b = _mm256_setzero_ps(), sum2b = _mm256_setzero_ps(), sum3b = _mm256_setzero_ps();
+		int k;
+
+		for (k = 0; k < nSIMDDimension; k += 8)
+		{
+			const __m256 a = _mm256_loadu_ps(pVectorA + k);
+			const __m256 b = _mm256_loadu_ps(pVectorB + k);
+			const __m256 q0 = _mm256_loadu_ps(pQuery0 + k);
+			const __m256 q1 = _mm256_loadu_ps(pQuery1 + k);
+			const __m256 q2 = _mm256_loadu_ps(pQuery2 + k);
+			const __m256 q3 = _mm256_loadu_ps(pQuery3 + k);
+
+			sum0a = _mm256_add_ps(sum0a, _mm256_mul_ps(q0, a));
+			sum1a = _mm256_add_ps(sum1a, _mm256_mul_ps(q1, a));
+			sum2a = _mm256_add_ps(sum2a, _mm256_mul_ps(q2, a));
+			sum3a = _mm256_add_ps(sum3a, _mm256_mul_ps(q3, a));
+			sum0b = _mm256_add_ps(sum0b, _mm256_mul_ps(q0, b));
+			sum1b = _mm256_add_ps(sum1b, _mm256_mul_ps(q1, b));
+			sum2b = _mm256_add_ps(sum2b, _mm256_mul_ps(q2, b));
+			sum3b = _mm256_add_ps(sum3b, _mm256_mul_ps(q3, b));
+		}
+
+		// horizontal sums of four accumulators at once
+		const __m256 hA = _mm256_hadd_ps(_mm256_hadd_ps(sum0a, sum1a), _mm256_hadd_ps(sum2a, sum3a));
+		const __m256 hB = _mm256_hadd_ps(_mm256_hadd_ps(sum0b, sum1b), _mm256_hadd_ps(sum2b, sum3b));
+		__m128 dotsA = _mm_add_ps(_mm256_castps256_ps128(hA), _mm256_extractf128_ps(hA, 1));
+		__m128 dotsB = _mm_add_ps(_mm256_castps256_ps128(hB), _mm256_extractf128_ps(hB, 1));
+
+		// the remainder is computed here, because calling non-VEX SSE code with dirty upper halves of the YMM registers is expensive
+		if (k < nDimension)
+		{
+			float tailA[4] = { 0.0f, 0.0f, 0.0f, 0.0f }, tailB[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+			for (; k < nDimension; k++)
+			{
+				tailA[0] += pQuery0[k] * pVectorA[k]; tailB[0] += pQuery0[k] * pVectorB[k];
+				tailA[1] += pQuery1[k] * pVectorA[k]; tailB[1] += pQuery1[k] * pVectorB[k];
+				tailA[2] += pQuery2[k] * pVectorA[k]; tailB[2] += pQuery2[k] * pVectorB[k];
+				tailA[3] += pQuery3[k] * pVectorA[k]; tailB[3] += pQuery3[k] * pVectorB[k];
+			}
+
+			dotsA = _mm_add_ps(dotsA, _mm_loadu_ps(tailA));
+			dotsB = _mm_add_ps(dotsB, _mm_loadu_ps(tailB));
+		}
+
+		float distancesA[4], distancesB[4];
+		_mm_storeu_ps(distancesA, _mm_add_ps(_mm_add_ps(queryNorms, _mm_set1_ps(pVectorNorms[i - nFirst])), _mm_mul_ps(minusTwo, dotsA)));
+		_mm_storeu_ps(distancesB, _mm_add_ps(_mm_add_ps(queryNorms, _mm_set1_ps(pVectorNorms[j - nFirst])), _mm_mul_ps(minusTwo, dotsB)));
+
+		for (int q = 0; q < 4; q++)
+		{
+			UpdateCandidates(distancesA[q], i, pBest + q * NN_CANDIDATES, pBestIndex + q * NN_CANDIDATES);
+
+			if (j != i)
+				UpdateCandidates(distancesB[q], j, pBest + q * NN_CANDIDATES, pBestIndex + q * NN_CANDIDATES);
+		}
+	}
+}
+
+#endif /* SIMD_AVAILABLE */
+
+static TwoNearestNeighborsBlockFunction GetTwoNearestNeighborsBlockFunction()
+{
+#ifdef SIMD_AVAILABLE
+	const OptimizedFunctionsSIMD::InstructionSet instructionSet = OptimizedFunctionsSIMD::GetInstructionSet();
+
+	if (instructionSet >= OptimizedFunctionsSIMD::eAVX2)
+		return TwoNearestNeighborsBlockAVX2;
+
+	if (instructionSet >= OptimizedFunctionsSIMD::eSSE2)
+		return TwoNearestNeighborsBlockSSE2;
+#endif
+
+	return TwoNearestNeighborsBlockGeneric;
+}
+
+static inline float SquaredDistanceFloat(const float *pVector1, const float *pVector2, int nDimension)
+{
+	float sum = 0.0f;
+
+	for (int i = 0; i < nDimension; i++)
+	{
+		const float v = pVector1[i] - pVector2[i];
+		sum += v * v;
+	}
+
+	return sum;
+}
+
+// Bound for the rounding error of the expansion above: each of |q|^2, |v|^2 and q * v is a sum of nDimension products,
+// whose rounding error is at most nDimension * 2^-24 times the sum of the absolute values of the products in any order of
+// summation, and |q * v| <= |q| |v|. The centering of the queries and vectors is covered by the factor 2.
+static inline float ExpansionErrorBound(int nDimension, float fQueryNorm, float fMaxVectorNorm)
+{
+	const float r = sqrtf(fQueryNorm) + sqrtf(fMaxVectorNorm);
+	return 2.0f * (nDimension + 4) * FLT_EPSILON * r * r;
+}
+
+struct TwoNearestNeighborsParameters
+{
+	TwoNearestNeighborsBlockFunction function;
+	const float *pQueries;
+	int nQueries;
+	const float *pVectors;
+	const float *pSquaredNorms;
+	const float *pMean;
+	float fMaxSquaredNorm;
+	int nDimension;
+	int nVectors;
+	int *pIndices;
+	float *pSquaredDistances;
+};
+
+static inline void CenterVectors(const float *pVectors, const float *pMean, int nDimension, int nVectors, float *pOutput)
+{
+	for (int i = 0; i < nVectors; i++, pVectors += nDimension, pOutput += nDimension)
+	{
+		for (int k = 0; k < nDimension; k++)
+			pOutput[k] = pVectors[k] - pMean[k];
+	}
+}
+
+// exhaustive search with sums of squared differences, in case the candidates could not be verified
+static void TwoNearestNeighborsExact(const float *pQuery, const float *pVectors, int nDimension, int nVectors, int *pIndices, float *pSquaredDistances)
+{
+	pIndices[0] = pIndices[1] = -1;
+	pSquaredDistances[0] = pSquaredDistances[1] = FLT_MAX;
+
+	for (int i = 0; i < nVectors; i++)
+	{
+		const float fDistance = SquaredDistanceFloat(pQuery, pVectors + i * nDimension, nDimension);
+
+		if (fDistance < pSquaredDistances[1])
+		{
+			if (fDistance < pSquaredDistances[0])
+			{
+				pIndices[1] = pIndices[0];
+				pSquaredDistances[1] = pSquaredDistances[0];
+				pIndices[0] = i;
+				pSquaredDistances[0] = fDistance;
+			}
+			else
+			{
+				pIndices[1] = i;
+				pSquaredDistances[1] = fDistance;
+			}
+		}
+	}
+}
+
+static void TwoNearestNeighborsTask(void *pParameter, int nFirstGroup, int nLastGroup)
+{
+	const TwoNearestNeighborsParameters *pParameters = (const TwoNearestNeighborsParameters *) pParameter;
+	const int nDimension = pParameters->nDimension;
+	const int nVectors = pParameters->nVectors;
+	const float *pMean = pParameters->pMean;
+	const int nGroups = nLastGroup - nFirstGroup;
+	const int nFirstQuery = nFirstGroup * NN_QUERY_GROUP_SIZE;
+	const int nLastQuery = nLastGroup * NN_QUERY_GROUP_SIZE < pParameters->nQueries ? nLastGroup * NN_QUERY_GROUP_SIZE : pParameters->nQueries;
+	const int nTaskQueries = nLastQuery - nFirstQuery;
+	int i, j;
+
+	// centered queries, the last group is filled up with copies of the last query
+	float *pQueries = new float[nGroups * NN_QUERY_GROUP_SIZE * nDimension];
+	CenterVectors(pParameters->pQueries + nFirstQuery * nDimension, pMean, nDimension, nTaskQueries, pQueries);
+
+	for (i = nTaskQueries; i < nGroups * NN_QUERY_GROUP_SIZE; i++)
+		memcpy(pQueries + i * nDimension, pQueries + (nTaskQueries - 1) * nDimension, nDimension * sizeof(float));
+
+	// squared norms of the queries and candidates
+	float *pQueryNorms = new float[nGroups * NN_QUERY_GROUP_SIZE];
+	float *pBest = new float[nGroups * NN_QUERY_GROUP_SIZE * NN_CANDIDATES];
+	int *pBestIndex = new int[nGroups * NN_QUERY_GROUP_SIZE * NN_CANDIDATES];
+
+	VectorDistance::SquaredNorms(pQueries, nDimension, nGroups * NN_QUERY_GROUP_SIZE, pQueryNorms);
+
+	for (i = 0; i < nGroups * NN_QUERY_GROUP_SIZE * NN_CANDIDATES; i++)
+	{
+		pBest[i] = FLT_MAX;
+		pBestIndex[i] = -1;
+	}
+
+	// blocks of vectors are centered and compared with all queries while they are in the cache
+	int nBlockSize = NN_VECTOR_BLOCK_SIZE / (nDimension * (int) sizeof(float));
+
+	if (nBlockSize < 2)
+		nBlockSize = 2;
+
+	float *pBlock = new float[nBlockSize * nDimension];
+
+	for (int nFirst = 0; nFirst < nVectors; nFirst += nBlockSize)
+	{
+		const int nLast = nFirst + nBlockSize < nVectors ? nFirst + nBlockSize : nVectors;
+
+		CenterVectors(pParameters->pVectors + nFirst * nDimension, pMean, nDimension, nLast - nFirst, pBlock);
+
+		for (i = 0; i < nGroups; i++)
+		{
+			const int nOffset = i * NN_QUERY_GROUP_SIZE;
+
+			pParameters->function(pQueries + nOffset * nDimension, pQueryNorms + nOffset, pBlock, pParameters->pSquaredNorms + nFirst, nDimension, nFirst, nLast, pBest + nOffset * NN_CANDIDATES, pBestIndex + nOffset * NN_CANDIDATES);
+		}
+	}
+
+	// rescore the candidates with sums of squared differences; the result is verified if no other vector
+	// can be closer than the second nearest candidate according to the bound for the rounding error
+	for (i = nFirstQuery; i < nLastQuery; i++)
+	{
+		const float *pQuery = pParameters->pQueries + i * nDimension;
+		const float *pCandidates = pBest + (i - nFirstQuery) * NN_CANDIDATES;
+		const int *pCandidateIndices = pBestIndex + (i - nFirstQuery) * NN_CANDIDATES;
+		int *pIndices = pParameters->pIndices + 2 * i;
+		float *pDistances = pParameters->pSquaredDistances + 2 * i;
+
+		pIndices[0] = pIndices[1] = -1;
+		pDistances[0] = pDistances[1] = FLT_MAX;
+
+		for (j = 0; j < NN_CANDIDATES && pCandidateIndices[j] != -1; j++)
+		{
+			const int nIndex = pCandidateIndices[j];
+			const float fDistance = SquaredDistanceFloat(pQuery, pParameters->pVectors + nIndex * nDimension, nDimension);
+
+			if (fDistance < pDistances[1] || (fDistance == pDistances[1] && nIndex < pIndices[1]))
+			{
+				if (fDistance < pDistances[0] || (fDistance == pDistances[0] && nIndex < pIndices[0]))
+				{
+					pIndices[1] = pIndices[0];
+					pDistances[1] = pDistances[0];
+					pIndices[0] = nIndex;
+					pDistances[0] = fDistance;
+				}
+				else
+				{
+					pIndices[1] = nIndex;
+					pDistances[1] = fDistance;
+				}
+			}
+		}
+
+		// all vectors are candidates if the last candidate is not set
+		if (pCandidateIndices[NN_CANDIDATES - 1] != -1)
+		{
+			const float fBound = ExpansionErrorBound(nDimension, pQueryNorms[i - nFirstQuery], pParameters->fMaxSquaredNorm);
+			const float fRoundingFactor = 1.0f + 2.0f * (nDimension + 2) * FLT_EPSILON;
+
+			if (pCandidates[NN_CANDIDATES - 1] - fBound <= pDistances[1] * fRoundingFactor)
+				TwoNearestNeighborsExact(pQuery, pParameters->pVectors, nDimension, nVectors, pIndices, pDistances);
+		}
+	}
+
+	delete [] pQueries;
+	delete [] pQueryNorms;
+	delete [] pBest;
+	delete [] pBestIndex;
+	delete [] pBlock;
+}
+
+
+
+// ****************************************************************************
+// Functions
+// ****************************************************************************
+
+unsigned int VectorDistance::SquaredDistance(const unsigned char *pVector1, const unsigned char *pVector2, int nDimension)
+{
+	static const SquaredDistanceFunction function = GetSquaredDistanceFunction();
+
+	return function(pVector1, pVector2, nDimension);
+}
+
+int VectorDistance::NearestNeighbor(const unsigned char *pQuery, const unsigned char *pVectors, int nDimension, int nVectors, unsigned int &nSquaredDistance)
+{
+	static const SquaredDistanceFunction function = GetSquaredDistanceFunction();
+
+	unsigned int min = 0xffffffff;
+	int best_i = -1;
+
+	for (int i = 0; i < nVectors; i++, pVectors += nDimension)
+	{
+		const unsigned int distance = function(pQuery, pVectors, nDimension);
+
+		if (distance < min)
+		{
+			min = distance;
+			best_i = i;
+		}
+	}
+
+	nSquaredDistance = min;
+
+	return best_i;
+}
+
+void VectorDistance::SquaredNorms(const float *pVectors, int nDimension, int nVectors, float *pSquaredNorms, const float *pCenter)
+{
+	for (int i = 0; i < nVectors; i++, pVectors += nDimension)
+	{
+		float sum = 0.0f;
+
+		if (pCenter)
+		{
+			for (int k = 0; k < nDimension; k++)
+			{
+				const float v = pVectors[k] - pCenter[k];
+				sum += v * v;
+			}
+		}
+		else
+		{
+			for (int k = 0; k < nDimension; k++)
+				sum += pVectors[k] * pVectors[k];
+		}
+
+		pSquaredNorms[i] = sum;
+	}
+}
+
+void VectorDistance::Mean(const float *pVectors, int nDimension, int nVectors, float *pMean)
+{
+	double *pSum = new double[nDimension];
+	int k;
+
+	for (k = 0; k < nDimension; k++)
+		pSum[k] = 0.0;
+
+	for (int i = 0; i < nVectors; i++, pVectors += nDimension)
+	{
+		for (k = 0; k < nDimension; k++)
+			pSum[k] += pVectors[k];
+	}
+
+	for (k = 0; k < nDimension; k++)
+		pMean[k] = nVectors > 0 ? float(pSum[k] / nVectors) : 0.0f;
+
+	delete [] pSum;
+}
+
+void VectorDistance::TwoNearestNeighbors(const float *pQueries, int nQueries, const float *pVectors, const float *pSquaredNorms, const float *pMean, int nDimension, int nVectors, int *pIndices, float *pSquaredDistances)
+{
+	if (nQueries < 1)
+		return;
+
+	if (nVectors < 1 || nDimension < 1)
+	{
+		for (int i = 0; i < 2 * nQueries; i++)
+		{
+			pIndices[i] = -1;
+			pSquaredDistances[i] = FLT_MAX;
+		}
+
+		return;
+	}
+
+	static const TwoNearestNeighborsBlockFunction function = GetTwoNearestNeighborsBlockFunction();
+
+	float *pComputedSquaredNorms = 0;
+	float *pComputedMean = 0;
+
+	if (!pSquaredNorms)
+	{
+		pComputedMean = new float[nDimension];
+		Mean(pVectors, nDimension, nVectors, pComputedMean);
+		pMean = pComputedMean;
+
+		pComputedSquaredNorms = new float[nVectors];
+		SquaredNorms(pVectors, nDimension, nVectors, pComputedSquaredNorms, pMean);
+		pSquaredNorms = pComputedSquaredNorms;
+	}
+	else if (!pMean)
+	{
+		// the norms refer to the origin
+		pComputedMean = new float[nDimension];
+		memset(pComputedMean, 0, nDimension * sizeof(float));
+		pMean = pComputedMean;
+	}
+
+	TwoNearestNeighborsParameters parameters;
+	parameters.function = function;
+	parameters.pQueries = pQueries;
+	parameters.nQueries = nQueries;
+	parameters.pVectors = pVectors;
+	parameters.pSquaredNorms = pSquaredNorms;
+	parameters.pMean = pMean;
+	parameters.fMaxSquaredNorm = 0.0f;
+	parameters.nDimension = nDimension;
+	parameters.nVectors = nVectors;
+	parameters.pIndices = pIndices;
+	parameters.pSquaredDistances = pSquaredDistances;
+
+	for (int i = 0; i < nVectors; i++)
+	{
+		if (pSquaredNorms[i] > parameters.fMaxSquaredNorm)
+			parameters.fMaxSquaredNorm = pSquaredNorms[i];
+	}
+
+	const int nGroups = (nQueries + NN_QUERY_GROUP_SIZE - 1) / NN_QUERY_GROUP_SIZE;
+
+	Threading::ParallelFor(TwoNearestNeighborsTask, &parameters, nGroups, 4);
+
+	delete [] pComputedSquaredNorms;
+	delete [] pComputedMean;
+}
+
+void VectorDistance::Quantize(const float *pInput, unsigned char *pOutput, int nDimension, float fFactor)
+{
+	for (int i = 0; i < nDimension; i++)
+	{
+		const float v = fFactor * pInput[i] + 0.5f;
+		pOutput[i] = v <= 0.0f ? 0 : (v >= 255.0f ? 255 : (unsigned char) int(v));
+	}
+}
+
+void VectorDistance::Dequantize(const unsigned char *pInput, float *pOutput, int nDimension, float fFactor)
+{
+	const float fInverseFactor = 1.0f / fFactor;
+
+	for (int i = 0; i < nDimension; i++)
+		pOutput[i] = pInput[i] * fInverseFactor;
+}
@@ -0,0 +1,128 @@
+// ****************************************************************************
+// This file is part of the Integrating Vision Toolkit (IVT).
+//
+// The IVT is maintained by the Karlsruhe Institute of Technology (KIT)
+// (www.kit.edu) in cooperation with the company Keyetech (www.keyetech.de).
+//
+// Copyright (C) 2014 Karlsruhe Institute of Technology (KIT).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the KIT nor the names of its contributors may be
+//    used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE KIT AND CONTRIBUTORS “AS IS” AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE KIT OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ****************************************************************************
+// ****************************************************************************
+// Filename:  VectorDistance.h
+// Author:    agent
+// Date:      17.10.2026
+// ****************************************************************************
+
+
+#ifndef _VECTOR_DISTANCE_H_
+#define _VECTOR_DISTANCE_H_
+
+
+
+// ****************************************************************************
+// VectorDistance
+// ****************************************************************************
+
+/*!
+	\namespace VectorDistance
+	\brief Distance kernels for feature vectors.
+
+	The functions for 8 bit vectors use SSE2 or AVX2 (selected at runtime, see OptimizedFunctionsSIMD::GetInstructionSet())
+	if the IVT is built with USE_SIMD defined, and produce the same results as the generic implementation.
+	The same holds for the exhaustive search for float vectors (TwoNearestNeighbors).
+*/
+namespace VectorDistance
+{
+	/*!
+		\brief Computes the squared euclidean distance between two 8 bit vectors.
+
+		The result is exact for all nDimension < 66051.
+	*/
+	unsigned int SquaredDistance(const unsigned char *pVector1, const unsigned char *pVector2, int nDimension);
+
+	/*!
+		\brief Searches the nearest neighbor of an 8 bit vector among nVectors vectors stored consecutively in pVectors.
+
+		\param[in] pQuery The query vector.
+		\param[in] pVectors The vectors, vector i starts at pVectors + i * nDimension.
+		\param[in] nDimension The dimension of the vectors.
+		\param[in] nVectors The number of vectors.
+		\param[out] nSquaredDistance The squared euclidean distance to the nearest neighbor.
+		\return The index of the nearest neighbor (the first one in case of equal distances), -1 if nVectors < 1.
+	*/
+	int NearestNeighbor(const unsigned char *pQuery, const unsigned char *pVectors, int nDimension, int nVectors, unsigned int &nSquaredDistance);
+
+	/*!
+		\brief Computes the squared euclidean norms of nVectors float vectors stored consecutively in pVectors.
+
+		If pCenter is not 0, the squared norms of the differences to pCenter are computed.
+	*/
+	void SquaredNorms(const float *pVectors, int nDimension, int nVectors, float *pSquaredNorms, const float *pCenter = 0);
+
+	/*!
+		\brief Computes the mean of nVectors float vectors stored consecutively in pVectors.
+	*/
+	void Mean(const float *pVectors, int nDimension, int nVectors, float *pMean);
+
+	/*!
+		\brief Searches the two nearest neighbors of each of nQueries float vectors among nVectors float vectors by exhaustive search.
+
+		The queries and vectors are centered with the mean of the vectors, and the distances are computed as |q|^2 + |v|^2 - 2 q * v
+		in tiles of four queries and two vectors with SIMD instructions, with the vectors processed in cache-sized blocks.
+		The queries are distributed over the worker pool of the IVT (see Threading::SetNumberOfWorkerThreads).
+		The best eight candidates of each query are rescored with sums of squared differences. If the bound for the rounding error
+		of the expansion does not rule out that another vector is closer than the second nearest candidate, the query is searched
+		exhaustively with sums of squared differences. Therefore the result is exact, i.e. equal to that of a straightforward search.
+		In case of equal distances, the vector with the lower index is preferred.
+
+		\param[in] pQueries The queries, query i starts at pQueries + i * nDimension.
+		\param[in] nQueries The number of queries.
+		\param[in] pVectors The vectors, vector i starts at pVectors + i * nDimension.
+		\param[in] pSquaredNorms The squared norms of the differences of the vectors to pMean (see SquaredNorms), or 0 for computing the mean and the norms in this call.
+		\param[in] pMean The mean of the vectors (see Mean) used for pSquaredNorms, 0 if pSquaredNorms refer to the origin. Ignored if pSquaredNorms is 0.
+		\param[in] nDimension The dimension of the vectors.
+		\param[in] nVectors The number of vectors.
+		\param[out] pIndices Indices of the nearest and second nearest neighbor of query i are written to pIndices[2 * i] and pIndices[2 * i + 1], -1 if not available.
+		\param[out] pSquaredDistances The corresponding squared euclidean distances, FLT_MAX if not available.
+	*/
+	void TwoNearestNeighbors(const float *pQueries, int nQueries, const float *pVectors, const float *pSquaredNorms, const float *pMean, int nDimension, int nVectors, int *pIndices, float *pSquaredDistances);
+
+	/*!
+		\brief Quantizes a float vector to 8 bit: pOutput[i] is fFactor * pInput[i], rounded and clamped to [0, 255].
+	*/
+	void Quantize(const float *pInput, unsigned char *pOutput, int nDimension, float fFactor);
+
+	/*!
+		\brief Inverse of Quantize(const float*, unsigned char*, int, float): pOutput[i] = pInput[i] * (1 / fFactor).
+	*/
+	void Dequantize(const unsigned char *pInput, float *pOutput, int nDimension, float fFactor);
+}
+
+
+
+#endif /* _VECTOR_DISTANCE_H_ */
@@ -48,6 +48,7 @@
 #include "ParticleFilterFramework.h"
 
 #include "Helpers/helpers.h"
+#include "Threading/WorkerPool.h"
 
 #include <math.h>
 #include <stdio.h>
@@ -55,6 +56,49 @@
 
 
 
+// ****************************************************************************
+// Defines
+// ****************************************************************************
+
+// minimum number of particles per task when distributing the evaluation to the worker pool
+#define PF_MIN_PARTICLES_PER_TASK	16
+
+
+
+// ****************************************************************************
+// Static functions
+// ****************************************************************************
+
+// upper quantile z with P(X > z) = p of the standard normal distribution for 0 < p <= 0.5
+// (rational approximation 26.2.23 from Abramowitz and Stegun, absolute error < 4.5e-4)
+static double NormalQuantile(double p)
+{
+	const double t = sqrt(-2.0 * log(p));
+	return t - (2.515517 + 0.802853 * t + 0.010328 * t * t) / (1.0 + 1.432788 * t + 0.189269 * t * t + 0.001308 * t * t * t);
+}
+
+// selects nSamples indices of the particles with the weights pi by systematic resampling; dOffset is in [0, 1]
+static void SystematicResampling(const double *pi, int nParticles, double dSum, int nSamples, double dOffset, int *pSamples)
+{
+	const double step = dSum / nSamples;
+	const double offset = dOffset * step;
+
+	double cumulative = pi[0];
+	int j = 0;
+
+	for (int i = 0; i < nSamples; i++)
+	{
+		const double position = offset + i * step;
+
+		while (position >= cumulative && j < nParticles - 1)
+			cumulative += pi[++j];
+
+		pSamples[i] = j;
+	}
+}
+
+
+
 // ****************************************************************************
 // Constructor / Destructor
 // ****************************************************************************
@@ -62,6 +106,7 @@
 CParticleFilterFramework::CParticleFilterFramework(int nParticles, int nDimension)
 {
 	m_nParticles = nParticles;
+	m_nMaxParticles = nParticles;
 	m_nDimension = nDimension;
 
 	mean_configuration = new double[nDimension];
@@ -73,14 +118,34 @@ CParticleFilterFramework::CParticleFilterFramework(int nParticles, int nDimensio
 
 	int i;
 
-	// allocate memory
-	s = new double*[nParticles];
-	for (i = 0; i < nParticles; i++)
-		s[i] = new double[nDimension];
+	// allocate memory (the rows of s and s_temp point into one block each)
+	m_pSampleData = new double[nParticles * nDimension];
+	m_pTempSampleData = new double[nParticles * nDimension];
+	m_pComponentData = new double[nParticles * nDimension];
 
+	s = new double*[nParticles];
 	s_temp = new double*[nParticles];
 	for (i = 0; i < nParticles; i++)
-		s_temp[i] = new double[nDimension];
+	{
+		s[i] = m_pSampleData + i * nDimension;
+		s_temp[i] = m_pTempSampleData + i * nDimension;
+	}
+
+	s_components = new double*[nDimension];
+	for (i = 0; i < nDimension; i++)
+		s_components[i] = m_pComponentData + i * nParticles;
+
+	m_pBaseSamples = new int[nParticles];
+	m_nNextBaseSample = 0;
+
+	m_bParallelEvaluation = false;
+
+	m_pBinSizes = 0;
+	m_pBinTable = 0;
+	m_nBinTableSize = 0;
+	m_nMinParticles = nParticles;
+	m_dKLDEpsilon = 0.05;
+	m_dKLDQuantile = 0.0;
 
 	c = new double[nParticles];
 	pi = new double[nParticles];
@@ -91,6 +156,14 @@ CParticleFilterFramework::CParticleFilterFramework(int nParticles, int nDimensio
 	{
 		c[i] = 0.0;
 		pi[i] = 0.0;
+		m_pBaseSamples[i] = i;
+	}
+
+	for (i = 0; i < nParticles * nDimension; i++)
+	{
+		m_pSampleData[i] = 0;
+		m_pTempSampleData[i] = 0;
+		m_pComponentData[i] = 0;
 	}
 }
 
@@ -102,15 +175,15 @@ CParticleFilterFramework::~CParticleFilterFramework()
 	delete [] lower_limit;
 	delete [] upper_limit;
 
-	int i;
-
-	for (i = 0; i < m_nParticles; i++)
-		delete [] s[i];
 	delete [] s;
-
-	for (i = 0; i < m_nParticles; i++)
-		delete [] s_temp[i];
 	delete [] s_temp;
+	delete [] s_components;
+	delete [] m_pSampleData;
+	delete [] m_pTempSampleData;
+	delete [] m_pComponentData;
+	delete [] m_pBaseSamples;
+	delete [] m_pBinSizes;
+	delete [] m_pBinTable;
 
 	delete [] c;
 	delete [] pi;
@@ -184,34 +257,173 @@ void CParticleFilterFramework::GetPredictedConfiguration(double *pPredictedConfi
 
 int CParticleFilterFramework::PickBaseSample()
 {
-	double choice = uniform_random() * c_total;
+	if (m_nNextBaseSample >= m_nParticles)
+		m_nNextBaseSample = 0;
 
-	int low = 0;
-	int high = m_nParticles;
+	return m_pBaseSamples[m_nNextBaseSample++];
+}
 
-	while (high > (low + 1))
+void CParticleFilterFramework::CalculateBaseSamples()
+{
+	int i;
+
+	m_nNextBaseSample = 0;
+
+	double sum = 0.0;
+	for (i = 0; i < m_nParticles; i++)
+		sum += pi[i];
+
+	if (!(sum > 0.0 && sum <= DBL_MAX))
 	{
-		int middle = (high + low) / 2;
-    
-		if (choice > c[middle])
-			low = middle;
-		else
-			high = middle;
+		// no valid weights
+		for (i = 0; i < m_nParticles; i++)
+			m_pBaseSamples[i] = i;
+
+		return;
 	}
 
-	return low;
+	int nSamples = m_nParticles;
+
+	if (m_pBinSizes)
+	{
+		// KLD-sampling: count the bins occupied by the posterior, represented by the maximum number of resampled particles
+		SystematicResampling(pi, m_nParticles, sum, m_nMaxParticles, uniform_random(), m_pBaseSamples);
+
+		const int k = CountOccupiedBins(m_pBaseSamples, m_nMaxParticles);
+
+		nSamples = m_nMinParticles;
+
+		if (k > 1)
+		{
+			const double a = 2.0 / (9.0 * (k - 1));
+			const double b = 1.0 - a + sqrt(a) * m_dKLDQuantile;
+			const double n = (k - 1) / (2.0 * m_dKLDEpsilon) * b * b * b;
+
+			if (n >= m_nMaxParticles)
+				nSamples = m_nMaxParticles;
+			else if (n > m_nMinParticles)
+				nSamples = int(ceil(n));
+		}
+	}
+
+	// systematic resampling: one random offset, then equidistant positions in the cumulative distribution
+	SystematicResampling(pi, m_nParticles, sum, nSamples, uniform_random(), m_pBaseSamples);
+
+	m_nParticles = nSamples;
 }
 
-double CParticleFilterFramework::ParticleFilter(double *pResultMeanConfiguration, double dSigmaFactor)
+int CParticleFilterFramework::CountOccupiedBins(const int *pSamples, int nSamples)
 {
-	// push previous state through process model
-	// use dynamic model and add noise
-	PredictNewBases(dSigmaFactor);
+	const unsigned int nMask = m_nBinTableSize - 1;
+	int nBins = 0, i;
+
+	for (i = 0; i < m_nBinTableSize; i++)
+		m_pBinTable[i] = 0;
+
+	for (i = 0; i < nSamples; i++)
+	{
+		// the samples are sorted, each particle only needs to be inserted once
+		if (i > 0 && pSamples[i] == pSamples[i - 1])
+			continue;
+
+		const double *pParticle = s[pSamples[i]];
+
+		// hash of the bin coordinates (0 marks an empty entry)
+		unsigned int hash = 2166136261u;
+
+		for (int j = 0; j < m_nDimension; j++)
+		{
+			const unsigned int bin = (unsigned int) int(floor(pParticle[j] / m_pBinSizes[j]));
+			hash = (hash ^ bin) * 16777619u;
+		}
+
+		if (hash == 0)
+			hash = 1;
+
+		unsigned int index = (hash ^ (hash >> 16)) & nMask;
+
+		while (m_pBinTable[index] != 0 && m_pBinTable[index] != hash)
+			index = (index + 1) & nMask;
+
+		if (m_pBinTable[index] == 0)
+		{
+			m_pBinTable[index] = hash;
+			nBins++;
+		}
+	}
+
+	return nBins;
+}
+
+bool CParticleFilterFramework::SetKLDSampling(int nMinParticles, const double *pBinSizes, double dEpsilon, double dDelta)
+{
+	if (nMinParticles < 1 || nMinParticles > m_nMaxParticles)
+	{
+		printf("error: nMinParticles must be in the range [1, %i] for CParticleFilterFramework::SetKLDSampling\n", m_nMaxParticles);
+		return false;
+	}
+
+	if (dEpsilon <= 0.0 || dDelta <= 0.0 || dDelta > 0.5)
+	{
+		printf("error: dEpsilon must be greater than 0 and dDelta must be in the range (0, 0.5] for CParticleFilterFramework::SetKLDSampling\n");
+		return false;
+	}
 
-	// apply bayesian measurement weighting
-	c_total = 0;
 	int i;
-	for (i = 0; i < m_nParticles; i++)
+
+	for (i = 0; i < m_nDimension; i++)
+		if (!(pBinSizes[i] > 0))
+		{
+			printf("error: bin sizes must be greater than 0 for CParticleFilterFramework::SetKLDSampling\n");
+			return false;
+		}
+
+	if (!m_pBinSizes)
+	{
+		m_pBinSizes = new double[m_nDimension];
+
+		// hash table with a load factor of at most 0.5
+		m_nBinTableSize = 1;
+		while (m_nBinTableSize < 2 * m_nMaxParticles)
+			m_nBinTableSize *= 2;
+
+		m_pBinTable = new unsigned int[m_nBinTableSize];
+	}
+
+	for (i = 0; i < m_nDimension; i++)
+		m_pBinSizes[i] = pBinSizes[i];
+
+	m_nMinParticles = nMinParticles;
+	m_dKLDEpsilon = dEpsilon;
+	m_dKLDQuantile = NormalQuantile(dDelta);
+
+	return true;
+}
+
+void CParticleFilterFramework::DisableKLDSampling()
+{
+	delete [] m_pBinSizes;
+	delete [] m_pBinTable;
+
+	m_pBinSizes = 0;
+	m_pBinTable = 0;
+	m_nBinTableSize = 0;
+}
+
+void CParticleFilterFramework::UpdateParticleComponents()
+{
+	for (int i = 0; i < m_nParticles; i++)
+	{
+		const double *pParticle = s[i];
+
+		for (int j = 0; j < m_nDimension; j++)
+			s_components[j][i] = pParticle[j];
+	}
+}
+
+void CParticleFilterFramework::CalculateProbabilities(int nFirst, int nLast)
+{
+	for (int i = nFirst; i < nLast; i++)
 	{
 		// update model (calculate forward kinematics)
 		UpdateModel(i);
@@ -219,6 +431,32 @@ double CParticleFilterFramework::ParticleFilter(double *pResultMeanConfiguration
 		// evaluate likelihood function (compare edges,...)
 		pi[i] = CalculateProbability(false);
 	}
+}
+
+void CParticleFilterFramework::CalculateProbabilitiesTask(void *pParameter, int nFirst, int nLast)
+{
+	((CParticleFilterFramework *) pParameter)->CalculateProbabilities(nFirst, nLast);
+}
+
+double CParticleFilterFramework::ParticleFilter(double *pResultMeanConfiguration, double dSigmaFactor)
+{
+	// draw the base samples for PredictNewBases
+	CalculateBaseSamples();
+
+	// push previous state through process model
+	// use dynamic model and add noise
+	PredictNewBases(dSigmaFactor);
+
+	UpdateParticleComponents();
+
+	// apply bayesian measurement weighting
+	if (m_bParallelEvaluation)
+		Threading::ParallelFor(CalculateProbabilitiesTask, this, m_nParticles, PF_MIN_PARTICLES_PER_TASK);
+	else
+		CalculateProbabilities(0, m_nParticles);
+	
+	c_total = 0;
+	int i;
 	
 	CalculateFinalProbabilities();
 	
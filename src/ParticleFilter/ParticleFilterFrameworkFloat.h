@@ -51,6 +51,24 @@
 /*!
 	\ingroup Tracking
 	\brief Framework for the implementation of particle filters using the data type float.
+
+	The particles are stored row by row in one block of memory (s[i][j] is the component j of particle i). In addition,
+	s_components[j][i] holds the same values as a structure of arrays, which is updated after PredictNewBases(float)
+	for the evaluation of the likelihoods.
+
+	ParticleFilter(float *, float) evaluates the likelihoods with CalculateProbabilities(int, int). The default implementation calls
+	UpdateModel(int) and CalculateProbability(bool) for each particle of the range. Subclasses can override it with a batched
+	evaluation and set m_bParallelEvaluation to true if their implementation can be called concurrently for disjoint ranges;
+	the particles are then distributed to the worker pool of the IVT if it has been enabled with Threading::SetNumberOfWorkerThreads(int).
+
+	The base samples returned by PickBaseSample() are determined by systematic resampling in O(n) at the beginning of
+	ParticleFilter(float *, float), i.e. before PredictNewBases(float) is called.
+
+	The number of particles given to the constructor is the maximum number of particles. With SetKLDSampling, the number of
+	active particles m_nParticles is adapted in each call of ParticleFilter(float *, float) by KLD-sampling (Fox 2003): the number of bins
+	of the state space occupied by the resampled particles determines the number of particles needed to bound the Kullback-Leibler
+	divergence between the sample-based and the true posterior. Subclasses must therefore use m_nParticles in PredictNewBases(float)
+	instead of a copy of the number given to the constructor.
 */
 class CParticleFilterFrameworkFloat
 {
@@ -70,17 +88,29 @@ public:
 	virtual void GetMeanConfiguration(float *pMeanConfiguration);
 	virtual void GetPredictedConfiguration(float *pPredictedConfiguration);
 
+	// enables KLD-sampling with the given bin size for each dimension; the number of particles is adapted within [nMinParticles, maximum number of particles]
+	// dEpsilon is the bound of the KL divergence and dDelta the probability that the bound is exceeded (0 < dDelta <= 0.5)
+	bool SetKLDSampling(int nMinParticles, const float *pBinSizes, double dEpsilon = 0.05, double dDelta = 0.01);
+	void DisableKLDSampling();
+	int GetNumberOfParticles() const { return m_nParticles; }
+	int GetMaxNumberOfParticles() const { return m_nMaxParticles; }
+
 
 protected:
 	// protected methods
+	// returns the next base sample of the systematic resampling (see class description)
 	int PickBaseSample();
+	void CalculateBaseSamples();
 	void CalculateMean();
+	void UpdateParticleComponents();
 
 	// virtual methods (framework methods to be implemented: design pattern "framwork" with "template methods")
 	virtual void UpdateModel(int nParticle) = 0;
 	virtual void PredictNewBases(float fSigmaFactor) = 0;
 	virtual double CalculateProbability(bool bSeparateCall = true) = 0;
 	virtual void CalculateFinalProbabilities() { }
+	// calculates pi[i] for nFirst <= i < nLast
+	virtual void CalculateProbabilities(int nFirst, int nLast);
 	
 
 	// protected attributes
@@ -94,12 +124,38 @@ protected:
 	// particle related attributes
 	int m_nDimension;
 	int m_nParticles;
+	int m_nMaxParticles;
 	double c_total;
 	float **s;
 	float **s_temp;
+	float **s_components;
 	double *c;
 	double *pi;
 	float *temp;
+
+	// must only be set to true if CalculateProbabilities(int, int) can be called concurrently for disjoint ranges
+	bool m_bParallelEvaluation;
+
+
+private:
+	// private methods
+	static void CalculateProbabilitiesTask(void *pParameter, int nFirst, int nLast);
+	int CountOccupiedBins(const int *pSamples, int nSamples);
+
+	// private attributes
+	float *m_pSampleData;
+	float *m_pTempSampleData;
+	float *m_pComponentData;
+	int *m_pBaseSamples;
+	int m_nNextBaseSample;
+
+	// KLD-sampling
+	float *m_pBinSizes;
+	unsigned int *m_pBinTable;
+	int m_nBinTableSize;
+	int m_nMinParticles;
+	double m_dKLDEpsilon;
+	double m_dKLDQuantile;
 };
 
 
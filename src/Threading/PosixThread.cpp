@@ -101,5 +101,6 @@ void CPosixThread::_Stop()
 
 void CPosixThread::ThreadMethodFinished()
 {
-	pthread_exit(NULL);
+	// the thread terminates by returning from ThreadRoutine, which sets m_bCompletelyDone
+	// (calling pthread_exit here would make CThreadBase::Stop wait for its full timeout)
 }
@@ -0,0 +1,252 @@
+// ****************************************************************************
+// This file is part of the Integrating Vision Toolkit (IVT).
+//
+// The IVT is maintained by the Karlsruhe Institute of Technology (KIT)
+// (www.kit.edu) in cooperation with the company Keyetech (www.keyetech.de).
+//
+// Copyright (C) 2014 Karlsruhe Institute of Technology (KIT).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the KIT nor the names of its contributors may be
+//    used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE KIT AND CONTRIBUTORS “AS IS” AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE KIT OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ****************************************************************************
+// ****************************************************************************
+// Filename:  WorkerPool.cpp
+// Author:    agent
+// Date:      17.10.2026
+// ****************************************************************************
+
+
+// ****************************************************************************
+// Includes
+// ****************************************************************************
+
+#include <new> // for explicitly using correct new/delete operators on VC DSPs
+
+#include "WorkerPool.h"
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+
+
+// ****************************************************************************
+// Library-wide worker pool
+// ****************************************************************************
+
+class CGlobalWorkerPool
+{
+public:
+	CGlobalWorkerPool() : pPool(0) { }
+	~CGlobalWorkerPool() { delete pPool; }
+
+	CWorkerPool *pPool;
+};
+
+static CGlobalWorkerPool globalWorkerPool;
+
+
+void Threading::SetNumberOfWorkerThreads(int nThreads)
+{
+	if (nThreads < 1)
+		nThreads = 1;
+
+	if (nThreads == GetNumberOfWorkerThreads())
+		return;
+
+	delete globalWorkerPool.pPool;
+	globalWorkerPool.pPool = nThreads > 1 ? new CWorkerPool(nThreads) : 0;
+}
+
+int Threading::GetNumberOfWorkerThreads()
+{
+	return globalWorkerPool.pPool ? globalWorkerPool.pPool->GetNumberOfThreads() : 1;
+}
+
+int Threading::GetNumberOfProcessors()
+{
+#ifdef WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return (int) info.dwNumberOfProcessors;
+#else
+	const long nProcessors = sysconf(_SC_NPROCESSORS_ONLN);
+	return nProcessors > 0 ? (int) nProcessors : 1;
+#endif
+}
+
+void Threading::ParallelFor(WorkerPoolMethodType pMethod, void *pParameter, int nItems, int nMinItemsPerTask)
+{
+	if (globalWorkerPool.pPool)
+		globalWorkerPool.pPool->Execute(pMethod, pParameter, nItems, nMinItemsPerTask);
+	else if (nItems > 0)
+		pMethod(pParameter, 0, nItems);
+}
+
+bool Threading::TryParallelFor(WorkerPoolMethodType pMethod, void *pParameter, int nItems, int nMinItemsPerTask)
+{
+	return globalWorkerPool.pPool && globalWorkerPool.pPool->TryExecute(pMethod, pParameter, nItems, nMinItemsPerTask);
+}
+
+
+
+// ****************************************************************************
+// Constructor / Destructor
+// ****************************************************************************
+
+CWorkerPool::CWorkerPool(int nThreads)
+{
+	m_nThreads = nThreads < 1 ? 1 : nThreads;
+	m_pWorkers = 0;
+
+	m_pMethod = 0;
+	m_pParameter = 0;
+	m_nItems = 0;
+	m_nTasks = 0;
+	m_nPendingTasks = 0;
+	m_bBusy = false;
+	m_bExit = false;
+
+	// the calling thread processes the first task itself
+	if (m_nThreads > 1)
+	{
+		m_pWorkers = new Worker[m_nThreads - 1];
+
+		for (int i = 0; i < m_nThreads - 1; i++)
+		{
+			m_pWorkers[i].pPool = this;
+			m_pWorkers[i].nIndex = i + 1;
+			m_pWorkers[i].thread.Start(m_pWorkers + i, WorkerThreadMethod);
+		}
+	}
+}
+
+CWorkerPool::~CWorkerPool()
+{
+	if (m_pWorkers)
+	{
+		m_bExit = true;
+
+		for (int i = 0; i < m_nThreads - 1; i++)
+			m_pWorkers[i].startEvent.Signal();
+
+		for (int i = 0; i < m_nThreads - 1; i++)
+			m_pWorkers[i].thread.Stop();
+
+		delete [] m_pWorkers;
+	}
+}
+
+
+// ****************************************************************************
+// Methods
+// ****************************************************************************
+
+int CWorkerPool::WorkerThreadMethod(void *pParameter)
+{
+	Worker *pWorker = (Worker *) pParameter;
+	CWorkerPool *pPool = pWorker->pPool;
+
+	while (true)
+	{
+		pWorker->startEvent.Wait();
+
+		if (pPool->m_bExit)
+			break;
+
+		pPool->RunTask(pWorker->nIndex);
+
+		pPool->m_counterMutex.Lock();
+		const bool bLast = --pPool->m_nPendingTasks == 0;
+		pPool->m_counterMutex.UnLock();
+
+		if (bLast)
+			pPool->m_doneEvent.Signal();
+	}
+
+	return 0;
+}
+
+void CWorkerPool::RunTask(int nTask)
+{
+	// contiguous chunks, the first nItems % nTasks chunks are one item larger
+	const int nSize = m_nItems / m_nTasks;
+	const int nRemainder = m_nItems % m_nTasks;
+	const int nBegin = nTask * nSize + (nTask < nRemainder ? nTask : nRemainder);
+	const int nEnd = nBegin + nSize + (nTask < nRemainder ? 1 : 0);
+
+	if (nBegin < nEnd)
+		m_pMethod(m_pParameter, nBegin, nEnd);
+}
+
+bool CWorkerPool::TryExecute(WorkerPoolMethodType pMethod, void *pParameter, int nItems, int nMinItemsPerTask)
+{
+	if (nMinItemsPerTask < 1)
+		nMinItemsPerTask = 1;
+
+	int nTasks = nItems / nMinItemsPerTask;
+	if (nTasks > m_nThreads)
+		nTasks = m_nThreads;
+
+	if (nTasks <= 1)
+		return false;
+
+	// reserve the pool; nested or concurrent calls are rejected
+	m_mutex.Lock();
+	const bool bBusy = m_bBusy;
+	m_bBusy = true;
+	m_mutex.UnLock();
+
+	if (bBusy)
+		return false;
+
+	m_pMethod = pMethod;
+	m_pParameter = pParameter;
+	m_nItems = nItems;
+	m_nTasks = nTasks;
+	m_nPendingTasks = nTasks - 1;
+
+	for (int i = 1; i < nTasks; i++)
+		m_pWorkers[i - 1].startEvent.Signal();
+
+	RunTask(0);
+
+	m_doneEvent.Wait();
+
+	m_mutex.Lock();
+	m_bBusy = false;
+	m_mutex.UnLock();
+
+	return true;
+}
+
+void CWorkerPool::Execute(WorkerPoolMethodType pMethod, void *pParameter, int nItems, int nMinItemsPerTask)
+{
+	if (nItems > 0 && !TryExecute(pMethod, pParameter, nItems, nMinItemsPerTask))
+		pMethod(pParameter, 0, nItems);
+}
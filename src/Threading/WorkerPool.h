@@ -0,0 +1,159 @@
+// ****************************************************************************
+// This file is part of the Integrating Vision Toolkit (IVT).
+//
+// The IVT is maintained by the Karlsruhe Institute of Technology (KIT)
+// (www.kit.edu) in cooperation with the company Keyetech (www.keyetech.de).
+//
+// Copyright (C) 2014 Karlsruhe Institute of Technology (KIT).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the KIT nor the names of its contributors may be
+//    used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE KIT AND CONTRIBUTORS “AS IS” AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE KIT OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ****************************************************************************
+// ****************************************************************************
+// Filename:  WorkerPool.h
+// Author:    agent
+// Date:      17.10.2026
+// ****************************************************************************
+
+
+#ifndef _WORKER_POOL_H_
+#define _WORKER_POOL_H_
+
+
+// ****************************************************************************
+// Necessary includes
+// ****************************************************************************
+
+#include "Thread.h"
+#include "Mutex.h"
+#include "Event.h"
+
+
+
+// ****************************************************************************
+// Typedefs
+// ****************************************************************************
+
+typedef void (*WorkerPoolMethodType)(void *pParameter, int nBegin, int nEnd);
+
+
+
+// ****************************************************************************
+// CWorkerPool
+// ****************************************************************************
+
+/*!
+	\ingroup Threading
+	\brief Pool of persistent worker threads for data-parallel loops.
+
+	Execute() splits the range [0, nItems) into at most GetNumberOfThreads() contiguous chunks
+	and calls the given method once per chunk. The calling thread processes the first chunk itself,
+	the remaining chunks are processed by the worker threads. The call returns after all chunks have been processed.
+
+	The partitioning is deterministic and depends only on nItems, nMinItemsPerTask and the number of threads.
+	If the pool is already executing a loop (nested call from within a task or concurrent call from another thread),
+	Execute() processes the range serially in the calling thread instead of blocking.
+	TryExecute() does not process anything in this case (and if the range is too small for more than one chunk) and returns false,
+	so that the caller can fall back to its serial code path.
+
+	The library-wide pool used by the IVT is configured with Threading::SetNumberOfWorkerThreads(..) and is disabled by default.
+*/
+class CWorkerPool
+{
+public:
+	// constructor
+	CWorkerPool(int nThreads);
+
+	// destructor
+	~CWorkerPool();
+
+
+	// public methods
+	int GetNumberOfThreads() const { return m_nThreads; }
+	void Execute(WorkerPoolMethodType pMethod, void *pParameter, int nItems, int nMinItemsPerTask = 1);
+	bool TryExecute(WorkerPoolMethodType pMethod, void *pParameter, int nItems, int nMinItemsPerTask = 1);
+
+
+private:
+	// private struct
+	struct Worker
+	{
+		CThread thread;
+		CEvent startEvent;
+		CWorkerPool *pPool;
+		int nIndex;
+	};
+
+	// private methods
+	static int WorkerThreadMethod(void *pParameter);
+	void RunTask(int nTask);
+
+	// private attributes
+	int m_nThreads;
+	Worker *m_pWorkers;
+
+	CMutex m_mutex;
+	CMutex m_counterMutex;
+	CEvent m_doneEvent;
+
+	WorkerPoolMethodType m_pMethod;
+	void *m_pParameter;
+	int m_nItems;
+	int m_nTasks;
+	int m_nPendingTasks;
+	bool m_bBusy;
+	volatile bool m_bExit;
+};
+
+
+
+// ****************************************************************************
+// Library-wide worker pool
+// ****************************************************************************
+
+namespace Threading
+{
+	// sets the number of threads of the worker pool used by the IVT; values <= 1 disable parallel processing (default)
+	// must not be called while other threads are using the pool
+	void SetNumberOfWorkerThreads(int nThreads);
+
+	// returns the number of threads of the worker pool, 1 if disabled
+	int GetNumberOfWorkerThreads();
+
+	// returns the number of logical processors of the system
+	int GetNumberOfProcessors();
+
+	// calls pMethod for contiguous chunks of [0, nItems); uses the worker pool if enabled, otherwise calls pMethod(pParameter, 0, nItems)
+	void ParallelFor(WorkerPoolMethodType pMethod, void *pParameter, int nItems, int nMinItemsPerTask = 1);
+
+	// like ParallelFor, but returns false without calling pMethod if the range cannot be processed in parallel
+	// (pool disabled or busy, e.g. when called from within a task, or fewer than 2 * nMinItemsPerTask items)
+	bool TryParallelFor(WorkerPoolMethodType pMethod, void *pParameter, int nItems, int nMinItemsPerTask = 1);
+}
+
+
+
+#endif /* _WORKER_POOL_H_ */
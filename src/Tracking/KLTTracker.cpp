@@ -48,19 +48,319 @@
 #include "KLTTracker.h"
 
 #include "Image/ByteImage.h"
+#include "Image/ShortImage.h"
 #include "Image/ImageProcessor.h"
 #include "Math/Math2d.h"
+#include "Threading/WorkerPool.h"
 
 #include <stdio.h>
+#include <string.h>
 #include <float.h>
 #include <math.h>
 
 
+#if defined(USE_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define KLT_SIMD_AVAILABLE
+#include <emmintrin.h>
+#endif
+
+
 // ****************************************************************************
 // Defines
 // ****************************************************************************
 
-#define KLT_ITERATIONS	20
+#define KLT_ITERATIONS				20
+
+// minimum number of points per task when distributing the points to the worker pool
+#define KLT_MIN_POINTS_PER_TASK		32
+
+
+
+// ****************************************************************************
+// Static functions
+// ****************************************************************************
+
+// central differences of the pixels (1..width-2, 1..height-2), the border pixels are set to 0
+static void CalculateGradients(const CByteImage *pImage, CShortImage *pGradientX, CShortImage *pGradientY)
+{
+	const int width = pImage->width;
+	const int height = pImage->height;
+	
+	const unsigned char *pixels = pImage->pixels;
+	short *gx = pGradientX->pixels;
+	short *gy = pGradientY->pixels;
+	
+	if (width < 3 || height < 3)
+	{
+		memset(gx, 0, width * height * sizeof(short));
+		memset(gy, 0, width * height * sizeof(short));
+		return;
+	}
+	
+	memset(gx, 0, width * sizeof(short));
+	memset(gy, 0, width * sizeof(short));
+	memset(gx + (height - 1) * width, 0, width * sizeof(short));
+	memset(gy + (height - 1) * width, 0, width * sizeof(short));
+	
+	for (int y = 1; y < height - 1; y++)
+	{
+		const unsigned char *p = pixels + y * width;
+		short *pgx = gx + y * width;
+		short *pgy = gy + y * width;
+		
+		pgx[0] = pgx[width - 1] = 0;
+		pgy[0] = pgy[width - 1] = 0;
+		
+		int x = 1;
+		
+		#ifdef KLT_SIMD_AVAILABLE
+		const __m128i zero = _mm_setzero_si128();
+		
+		for (; x + 8 <= width - 1; x += 8)
+		{
+			const __m128i left = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *) (p + x - 1)), zero);
+			const __m128i right = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *) (p + x + 1)), zero);
+			const __m128i top = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *) (p + x - width)), zero);
+			const __m128i bottom = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *) (p + x + width)), zero);
+			
+			_mm_storeu_si128((__m128i *) (pgx + x), _mm_sub_epi16(right, left));
+			_mm_storeu_si128((__m128i *) (pgy + x), _mm_sub_epi16(bottom, top));
+		}
+		#endif
+		
+		for (; x < width - 1; x++)
+		{
+			pgx[x] = short(p[x + 1] - p[x - 1]);
+			pgy[x] = short(p[x + width] - p[x - width]);
+		}
+	}
+}
+
+
+// The window functions process nRows rows of nStride values, i.e. up to 3 pixels more than the window per row
+// plus one column and one row for the bilinear interpolation; the SIMD code reads up to 8 bytes or 8 shorts per row and block.
+// The callers ensure that these pixels lie within the image buffer.
+
+#ifdef KLT_SIMD_AVAILABLE
+
+// converts the pixels p[0..3] and p[1..4]
+static inline void LoadBytes(const unsigned char *p, __m128 &v0, __m128 &v1)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i v = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *) p), zero);
+	
+	v0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(v, zero));
+	v1 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_srli_si128(v, 2), zero));
+}
+
+// converts the pixels p[0..3] and p[1..4]
+static inline void LoadShorts(const short *p, __m128 &v0, __m128 &v1)
+{
+	const __m128i v = _mm_loadu_si128((const __m128i *) p);
+	
+	v0 = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16));
+	v1 = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(_mm_srli_si128(v, 2), _mm_srli_si128(v, 2)), 16));
+}
+
+#endif
+
+// the windows are processed in columns of 4 values from top to bottom, so that the lower row of the interpolation is loaded only once
+
+static void InterpolateWindow(const unsigned char *pixels, int width, int nRows, int nStride, const float *pWeights, float *pResult)
+{
+	#ifdef KLT_SIMD_AVAILABLE
+	const __m128 f00 = _mm_set1_ps(pWeights[0]);
+	const __m128 f10 = _mm_set1_ps(pWeights[1]);
+	const __m128 f01 = _mm_set1_ps(pWeights[2]);
+	const __m128 f11 = _mm_set1_ps(pWeights[3]);
+	
+	for (int j = 0; j < nStride; j += 4)
+	{
+		const unsigned char *p = pixels + j;
+		__m128 a0, a1, b0, b1;
+		
+		LoadBytes(p, a0, a1);
+		
+		for (int i = 0, offset = j; i < nRows; i++, offset += nStride)
+		{
+			p += width;
+			LoadBytes(p, b0, b1);
+			
+			_mm_storeu_ps(pResult + offset, _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(f00, a0), _mm_mul_ps(f10, a1)), _mm_mul_ps(f01, b0)), _mm_mul_ps(f11, b1)));
+			
+			a0 = b0;
+			a1 = b1;
+		}
+	}
+	#else
+	const float f00 = pWeights[0], f10 = pWeights[1], f01 = pWeights[2], f11 = pWeights[3];
+	
+	for (int i = 0; i < nRows; i++, pixels += width, pResult += nStride)
+		for (int j = 0; j < nStride; j++)
+		{
+			const unsigned char *p = pixels + j;
+			pResult[j] = f00 * p[0] + f10 * p[1] + f01 * p[width] + f11 * p[width + 1];
+		}
+	#endif
+}
+
+static void InterpolateWindow(const short *pixels, int width, int nRows, int nStride, const float *pWeights, float *pResult)
+{
+	#ifdef KLT_SIMD_AVAILABLE
+	const __m128 f00 = _mm_set1_ps(pWeights[0]);
+	const __m128 f10 = _mm_set1_ps(pWeights[1]);
+	const __m128 f01 = _mm_set1_ps(pWeights[2]);
+	const __m128 f11 = _mm_set1_ps(pWeights[3]);
+	
+	for (int j = 0; j < nStride; j += 4)
+	{
+		const short *p = pixels + j;
+		__m128 a0, a1, b0, b1;
+		
+		LoadShorts(p, a0, a1);
+		
+		for (int i = 0, offset = j; i < nRows; i++, offset += nStride)
+		{
+			p += width;
+			LoadShorts(p, b0, b1);
+			
+			_mm_storeu_ps(pResult + offset, _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(f00, a0), _mm_mul_ps(f10, a1)), _mm_mul_ps(f01, b0)), _mm_mul_ps(f11, b1)));
+			
+			a0 = b0;
+			a1 = b1;
+		}
+	}
+	#else
+	const float f00 = pWeights[0], f10 = pWeights[1], f01 = pWeights[2], f11 = pWeights[3];
+	
+	for (int i = 0; i < nRows; i++, pixels += width, pResult += nStride)
+		for (int j = 0; j < nStride; j++)
+		{
+			const short *p = pixels + j;
+			pResult[j] = f00 * p[0] + f10 * p[1] + f01 * p[width] + f11 * p[width + 1];
+		}
+	#endif
+}
+
+// b = sum((I - J) * (IX, IY)) over the window, J being interpolated from pixelsJ; IX and IY are 0 in the padding columns
+static void CalculateMismatchVector(const unsigned char *pixelsJ, int width, int nRows, int nStride, const float *pWeights,
+	const float *pGrayValues, const float *IX, const float *IY, float &bx, float &by)
+{
+	#ifdef KLT_SIMD_AVAILABLE
+	const __m128 f00 = _mm_set1_ps(pWeights[0]);
+	const __m128 f10 = _mm_set1_ps(pWeights[1]);
+	const __m128 f01 = _mm_set1_ps(pWeights[2]);
+	const __m128 f11 = _mm_set1_ps(pWeights[3]);
+	
+	__m128 sx = _mm_setzero_ps();
+	__m128 sy = _mm_setzero_ps();
+	
+	for (int j = 0; j < nStride; j += 4)
+	{
+		const unsigned char *p = pixelsJ + j;
+		__m128 a0, a1, b0, b1;
+		
+		LoadBytes(p, a0, a1);
+		
+		for (int i = 0, offset = j; i < nRows; i++, offset += nStride)
+		{
+			p += width;
+			LoadBytes(p, b0, b1);
+			
+			const __m128 v = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(f00, a0), _mm_mul_ps(f10, a1)), _mm_mul_ps(f01, b0)), _mm_mul_ps(f11, b1));
+			const __m128 dI = _mm_sub_ps(_mm_loadu_ps(pGrayValues + offset), v);
+			
+			sx = _mm_add_ps(sx, _mm_mul_ps(_mm_loadu_ps(IX + offset), dI));
+			sy = _mm_add_ps(sy, _mm_mul_ps(_mm_loadu_ps(IY + offset), dI));
+			
+			a0 = b0;
+			a1 = b1;
+		}
+	}
+	
+	float px[4], py[4];
+	_mm_storeu_ps(px, sx);
+	_mm_storeu_ps(py, sy);
+	
+	bx = (px[0] + px[1]) + (px[2] + px[3]);
+	by = (py[0] + py[1]) + (py[2] + py[3]);
+	#else
+	const float f00 = pWeights[0], f10 = pWeights[1], f01 = pWeights[2], f11 = pWeights[3];
+	
+	bx = 0.0f;
+	by = 0.0f;
+	
+	for (int i = 0, offset = 0; i < nRows; i++, pixelsJ += width)
+		for (int j = 0; j < nStride; j++, offset++)
+		{
+			const unsigned char *p = pixelsJ + j;
+			const float dI = pGrayValues[offset] - (f00 * p[0] + f10 * p[1] + f01 * p[width] + f11 * p[width + 1]);
+			
+			bx += IX[offset] * dI;
+			by += IY[offset] * dI;
+		}
+	#endif
+}
+
+// sums of IX * IX, IX * IY and IY * IY over the window; sets the padding columns of IX and IY to 0 before
+static void CalculateGradientMatrix(float *IX, float *IY, int nRows, int nColumns, int nStride, float &gxx, float &gxy, float &gyy)
+{
+	int i, j;
+	
+	for (i = 0; i < nRows; i++)
+		for (j = nColumns; j < nStride; j++)
+		{
+			IX[i * nStride + j] = 0.0f;
+			IY[i * nStride + j] = 0.0f;
+		}
+	
+	const int nValues = nRows * nStride;
+	
+	#ifdef KLT_SIMD_AVAILABLE
+	__m128 sxx = _mm_setzero_ps();
+	__m128 sxy = _mm_setzero_ps();
+	__m128 syy = _mm_setzero_ps();
+	
+	for (i = 0; i < nValues; i += 4)
+	{
+		const __m128 ix = _mm_loadu_ps(IX + i);
+		const __m128 iy = _mm_loadu_ps(IY + i);
+		
+		sxx = _mm_add_ps(sxx, _mm_mul_ps(ix, ix));
+		sxy = _mm_add_ps(sxy, _mm_mul_ps(ix, iy));
+		syy = _mm_add_ps(syy, _mm_mul_ps(iy, iy));
+	}
+	
+	float pxx[4], pxy[4], pyy[4];
+	_mm_storeu_ps(pxx, sxx);
+	_mm_storeu_ps(pxy, sxy);
+	_mm_storeu_ps(pyy, syy);
+	
+	gxx = (pxx[0] + pxx[1]) + (pxx[2] + pxx[3]);
+	gxy = (pxy[0] + pxy[1]) + (pxy[2] + pxy[3]);
+	gyy = (pyy[0] + pyy[1]) + (pyy[2] + pyy[3]);
+	#else
+	gxx = gxy = gyy = 0.0f;
+	
+	for (i = 0; i < nValues; i++)
+	{
+		gxx += IX[i] * IX[i];
+		gxy += IX[i] * IY[i];
+		gyy += IY[i] * IY[i];
+	}
+	#endif
+}
+
+static void CalculateBilinearWeights(float x, float y, float *pWeights)
+{
+	const float dx = x - floorf(x);
+	const float dy = y - floorf(y);
+	
+	pWeights[0] = (1.0f - dx) * (1.0f - dy);
+	pWeights[1] = dx * (1.0f - dy);
+	pWeights[2] = (1.0f - dx) * dy;
+	pWeights[3] = dx * dy;
+}
 
 
 
@@ -70,8 +370,8 @@
 
 CKLTTracker::CKLTTracker(int width_, int height_, int nLevels, int nHalfWindowSize) : width(width_), height(height_), m_nLevels(nLevels), m_nHalfWindowSize(nHalfWindowSize)
 {
-	m_ppPyramidI = new CByteImage*[nLevels + 1];
-	m_ppPyramidJ = new CByteImage*[nLevels + 1];
+	m_pPyramidI = new PyramidLevel[nLevels + 1];
+	m_pPyramidJ = new PyramidLevel[nLevels + 1];
 	
 	int w = width;
 	int h = height;
@@ -81,8 +381,12 @@ CKLTTracker::CKLTTracker(int width_, int height_, int nLevels, int nHalfWindowSi
 	// allocate pyramid images
 	for (i = 0; i <= nLevels; i++)
 	{
-		m_ppPyramidI[i] = new CByteImage(w, h, CByteImage::eGrayScale);
-		m_ppPyramidJ[i] = new CByteImage(w, h, CByteImage::eGrayScale);
+		m_pPyramidI[i].pImage = new CByteImage(w, h, CByteImage::eGrayScale);
+		m_pPyramidI[i].pGradientX = new CShortImage(w, h);
+		m_pPyramidI[i].pGradientY = new CShortImage(w, h);
+		m_pPyramidJ[i].pImage = new CByteImage(w, h, CByteImage::eGrayScale);
+		m_pPyramidJ[i].pGradientX = new CShortImage(w, h);
+		m_pPyramidJ[i].pGradientY = new CShortImage(w, h);
 		
 		w /= 2;
 		h /= 2;
@@ -93,6 +397,11 @@ CKLTTracker::CKLTTracker(int width_, int height_, int nLevels, int nHalfWindowSi
 	for (i = m_nLevels; i >= 0; i--)
 		m_pScaleFactors[i] = 1.0f / powf(2.0f, (float) i);
 	
+	// scratch memory for one task (template window and its gradients)
+	m_nWindowStride = (2 * nHalfWindowSize + 1 + 3) & ~3;
+	m_nScratchTasks = 1;
+	m_pScratch = new float[3 * (2 * nHalfWindowSize + 1) * m_nWindowStride];
+	
 	m_bInitialized = false;
 }
 
@@ -100,14 +409,19 @@ CKLTTracker::~CKLTTracker()
 {
 	for (int i = 0; i <= m_nLevels; i++)
 	{
-		delete m_ppPyramidI[i];
-		delete m_ppPyramidJ[i];
+		delete m_pPyramidI[i].pImage;
+		delete m_pPyramidI[i].pGradientX;
+		delete m_pPyramidI[i].pGradientY;
+		delete m_pPyramidJ[i].pImage;
+		delete m_pPyramidJ[i].pGradientX;
+		delete m_pPyramidJ[i].pGradientY;
 	}
 	
-	delete [] m_ppPyramidI;
-	delete [] m_ppPyramidJ;
+	delete [] m_pPyramidI;
+	delete [] m_pPyramidJ;
 	
 	delete [] m_pScaleFactors;
+	delete [] m_pScratch;
 }
 
 
@@ -115,200 +429,245 @@ CKLTTracker::~CKLTTracker()
 // Methods
 // ****************************************************************************
 
-bool CKLTTracker::Track(const CByteImage *pImage, const Vec2d *pPoints, int nPoints, Vec2d *pResultPoints)
+void CKLTTracker::BuildPyramid(const CByteImage *pImage, PyramidLevel *pPyramid)
 {
-	if (pImage->type != CByteImage::eGrayScale)
-	{
-		printf("error: image must be of type eGrayScale for CKLTTracker::Track\n");
-		return false;
-	}
+	// copy image to become level 0 of pyramid
+	ImageProcessor::CopyImage(pImage, pPyramid[0].pImage);
 	
-	if (!m_bInitialized)
+	// compute levels 1 to m_nLevels of pyramid
+	for (int i = 1; i <= m_nLevels; i++)
+		ImageProcessor::Resize(pPyramid[i - 1].pImage, pPyramid[i].pImage);
+	
+	for (int i = 0; i <= m_nLevels; i++)
+		CalculateGradients(pPyramid[i].pImage, pPyramid[i].pGradientX, pPyramid[i].pGradientY);
+}
+
+void CKLTTracker::TrackPoint(const Vec2d &point, Vec2d &resultPoint, PointStatus &status, float *pScratch) const
+{
+	const float ux = point.x;
+	const float uy = point.y;
+	
+	if (ux < 0.0f && uy < 0.0f)
 	{
-		// copy image to become level 0 of pyramid
-		ImageProcessor::CopyImage(pImage, m_ppPyramidI[0]);
-		
-		// compute levels 1 to m_nLevels - 1 of pyramid
-		for (int i = 1; i <= m_nLevels; i++)
-			ImageProcessor::Resize(m_ppPyramidI[i - 1], m_ppPyramidI[i]);
-		
-		m_bInitialized = true;
+		Math2d::SetVec(resultPoint, -1.0f, -1.0f);
+		status = eInvalidInput;
+		return;
 	}
 	
-	int i;
-	
-	// copy image to become level 0 of pyramid
-	ImageProcessor::CopyImage(pImage, m_ppPyramidJ[0]);
+	const int nWindowSize = 2 * m_nHalfWindowSize + 1;
+	const int nStride = m_nWindowStride;
 	
-	// compute levels 1 to m_nLevels - 1 of pyramid
-	for (i = 1; i <= m_nLevels; i++)
-		ImageProcessor::Resize(m_ppPyramidJ[i - 1], m_ppPyramidJ[i]);
+	float *pGrayValues = pScratch;
+	float *IX = pScratch + nWindowSize * nStride;
+	float *IY = IX + nWindowSize * nStride;
 	
-	const int nWindowSize = 2 * m_nHalfWindowSize + 1;
-	const int nWindowSizePlus2 = nWindowSize + 2;
+	float weights[4];
 	
-	Vec2d d;
+	Vec2d g = { 0.0f, 0.0f };
+	Vec2d d = { 0.0f, 0.0f };
 	
-	float *IX = new float[nWindowSizePlus2 * nWindowSizePlus2];
-	float *IY = new float[nWindowSizePlus2 * nWindowSizePlus2];
-	float *pGrayValues = new float[nWindowSizePlus2 * nWindowSizePlus2];
+	status = eTracked;
 	
-	// track each point
-	for (i = 0; i < nPoints; i++)
+	for (int l = m_nLevels; l >= 0; l--)
 	{
-		const float ux = pPoints[i].x;
-		const float uy = pPoints[i].y;
+		const int w = m_pPyramidI[l].pImage->width;
+		const int h = m_pPyramidI[l].pImage->height;
+		
+		const float px_ = m_pScaleFactors[l] * ux;
+		const float py_ = m_pScaleFactors[l] * uy;
+		
+		const int px = int(floorf(px_));
+		const int py = int(floorf(py_));
+		
+		Math2d::SetVec(d, 0.0f, 0.0f);
 		
-		if (ux < 0.0f && uy < 0.0f)
+		if (px - m_nHalfWindowSize < 1 || px + m_nHalfWindowSize + 3 > w || py - m_nHalfWindowSize < 1 || py + m_nHalfWindowSize + 3 > h)
 		{
-			Math2d::SetVec(pResultPoints[i], -1.0f, -1.0f);
+			// window does not fit into this level, propagate the current estimate
+			if (l != 0)
+				Math2d::MulVecScalar(g, 2.0f, g);
+			else
+				status = eNotConverged;
+			
 			continue;
 		}
 		
-		Vec2d g = { 0.0f, 0.0f };
-		
-		for (int l = m_nLevels; l >= 0; l--)
+		// interpolate the template window and its gradients (the gradients of the interpolated
+		// window equal the interpolated gradients, since the interpolation is linear)
 		{
-			const int w = m_ppPyramidI[l]->width;
-			const int h = m_ppPyramidI[l]->height;
+			const int offset = (py - m_nHalfWindowSize) * w + px - m_nHalfWindowSize;
 			
-			const float px_ = m_pScaleFactors[l] * ux;
-			const float py_ = m_pScaleFactors[l] * uy;
+			CalculateBilinearWeights(px_, py_, weights);
 			
-			const int px = int(floorf(px_));
-			const int py = int(floorf(py_));
+			InterpolateWindow(m_pPyramidI[l].pImage->pixels + offset, w, nWindowSize, nStride, weights, pGrayValues);
+			InterpolateWindow(m_pPyramidI[l].pGradientX->pixels + offset, w, nWindowSize, nStride, weights, IX);
+			InterpolateWindow(m_pPyramidI[l].pGradientY->pixels + offset, w, nWindowSize, nStride, weights, IY);
+		}
+		
+		float gxx, gxy, gyy;
+		CalculateGradientMatrix(IX, IY, nWindowSize, nWindowSize, nStride, gxx, gxy, gyy);
+		
+		Vec2d v = { 0.0f, 0.0f };
+		
+		if (fabsf(gxx * gyy - gxy * gxy) > FLT_EPSILON) // determinant check
+		{
+			const Mat2d G = { gxx, gxy, gxy, gyy };
+			Mat2d G_;
+			Math2d::Invert(G, G_);
 			
-			if (px - m_nHalfWindowSize < 1 || px + m_nHalfWindowSize + 3 > w || py - m_nHalfWindowSize < 1 || py + m_nHalfWindowSize + 3 > h)
-			{
-				Math2d::MulVecScalar(g, 2.0f, g);
-				continue;
-			}
+			const unsigned char *pixelsJ = m_pPyramidJ[l].pImage->pixels;
 			
-			const unsigned char *pixelsI = m_ppPyramidI[l]->pixels;
+			bool bConverged = false;
 			
+			for (int k = 0; k < KLT_ITERATIONS; k++)
 			{
-				const int diff = w - nWindowSizePlus2;
+				const float x = px_ + g.x + v.x;
+				const float y = py_ + g.y + v.y;
 				
-				const float dx = px_ - floorf(px_);
-				const float dy = py_ - floorf(py_);
+				const int xb = int(floorf(x));
+				const int yb = int(floorf(y));
 				
-				const float f00 = (1.0f - dx) * (1.0f - dy);
-				const float f10 = dx * (1.0f - dy);
-				const float f01 = (1.0f - dx) * dy;
-				const float f11 = dx * dy;
+				if (xb - m_nHalfWindowSize < 1 || xb + m_nHalfWindowSize + 3 >= w || yb - m_nHalfWindowSize < 1 || yb + m_nHalfWindowSize + 3 >= h)
+					break;
 				
-				for (int j = nWindowSizePlus2, offset = (py - m_nHalfWindowSize - 1) * w + px - m_nHalfWindowSize - 1, offset2 = 0; j; j--, offset += diff)
-					for (int jj = nWindowSizePlus2; jj; jj--, offset++, offset2++)
-						pGrayValues[offset2] = f00 * pixelsI[offset] + f10 * pixelsI[offset + 1] + f01 * pixelsI[offset + w] + f11 * pixelsI[offset + w + 1];
-			}
-			
-			float gxx = 0.0f, gxy = 0.0f, gyy = 0.0f;
-			
-			for (int j = nWindowSize, offset = nWindowSizePlus2 + 1; j; j--, offset += 2)
-				for (int jj = nWindowSize; jj; jj--, offset++)
-				{
-					const float ix = pGrayValues[offset + 1] - pGrayValues[offset - 1];
-					const float iy = pGrayValues[offset + nWindowSizePlus2] - pGrayValues[offset - nWindowSizePlus2];
-					
-					IX[offset] = ix;
-					IY[offset] = iy;
-					
-					gxx += ix * ix;
-					gyy += iy * iy;
-					gxy += ix * iy;
-				}
-			
-			Vec2d v = { 0.0f, 0.0f };
-			
-			if (fabsf(gxx * gyy - gxy * gxy) > FLT_EPSILON) // determinant check
-			{
-				const Mat2d G = { gxx, gxy, gxy, gyy };
-				Mat2d G_;
-				Math2d::Invert(G, G_);
+				CalculateBilinearWeights(x, y, weights);
+				
+				Vec2d b;
+				CalculateMismatchVector(pixelsJ + (yb - m_nHalfWindowSize) * w + xb - m_nHalfWindowSize, w, nWindowSize, nStride, weights, pGrayValues, IX, IY, b.x, b.y);
+				
+				Vec2d n;
+				Math2d::MulMatVec(G_, b, n);
+				
+				Math2d::MulVecScalar(n, 2.0f, n); // take into account leaving out factor 0.5 for gradient computation
 				
-				const unsigned char *pixelsJ = m_ppPyramidJ[l]->pixels;
+				Math2d::AddToVec(v, n);
 				
-				for (int k = 0; k < KLT_ITERATIONS; k++)
+				if (Math2d::SquaredLength(n) < 0.03f)
 				{
-					const float dxJ = g.x + v.x;
-					const float dyJ = g.y + v.y;
-					
-					const int xb = int(floorf(px_ + dxJ));
-					const int yb = int(floorf(py_ + dyJ));
-					
-					if (xb - m_nHalfWindowSize < 1 || xb + m_nHalfWindowSize + 3 >= w || yb - m_nHalfWindowSize < 1 || yb + m_nHalfWindowSize + 3 >= h)
-						break;
-					
-					float bx = 0.0f, by = 0.0f;
-					
-					{
-						const int diff = w - nWindowSize;
-						
-						const float dx = px_ + dxJ - floorf(px_ + dxJ);
-						const float dy = py_ + dyJ - floorf(py_ + dyJ);
-						
-						const float f00 = (1.0f - dx) * (1.0f - dy);
-						const float f10 = dx * (1.0f - dy);
-						const float f01 = (1.0f - dx) * dy;
-						const float f11 = dx * dy;
-						
-						for (int j = nWindowSize, offset = (yb - m_nHalfWindowSize) * w + xb - m_nHalfWindowSize, offset2 = nWindowSizePlus2 + 1; j; j--, offset += diff, offset2 += 2)
-							for (int jj = nWindowSize; jj; jj--, offset++, offset2++)
-							{
-								const float dI = pGrayValues[offset2] - (f00 * pixelsJ[offset] + f10 * pixelsJ[offset + 1] + f01 * pixelsJ[offset + w] + f11 * pixelsJ[offset + w + 1]);
-								
-								bx += IX[offset2] * dI;
-								by += IY[offset2] * dI;
-							}
-					}
-					
-					const Vec2d b = { bx, by };
-					
-					Vec2d n;
-					Math2d::MulMatVec(G_, b, n);
-					
-					Math2d::MulVecScalar(n, 2.0f, n); // take into account leaving out factor 0.5 for gradient computation
-					
-					Math2d::AddToVec(v, n);
-					
-					if (Math2d::SquaredLength(n) < 0.03f)
-						break;
+					bConverged = true;
+					break;
 				}
 			}
 			
-			Math2d::SetVec(d, v);
-			
-			if (l != 0)
-			{
-				g.x = 2.0f * (g.x + d.x);
-				g.y = 2.0f * (g.y + d.y);
-			}
+			if (l == 0 && !bConverged)
+				status = eNotConverged;
+		}
+		else if (l == 0)
+		{
+			status = eNoTexture;
 		}
 		
-		Math2d::AddToVec(d, g);
+		Math2d::SetVec(d, v);
 		
-		const float x = ux + d.x;
-		const float y = uy + d.y;
+		if (l != 0)
+		{
+			g.x = 2.0f * (g.x + d.x);
+			g.y = 2.0f * (g.y + d.y);
+		}
+	}
+	
+	Math2d::AddToVec(d, g);
+	
+	const float x = ux + d.x;
+	const float y = uy + d.y;
+	
+	const int x_ = int(floorf(x));
+	const int y_ = int(floorf(y));
+	
+	if (x_ > m_nHalfWindowSize && x_ < width - m_nHalfWindowSize - 3 && y_ > m_nHalfWindowSize && y_ < height - m_nHalfWindowSize - 3)
+	{
+		Math2d::SetVec(resultPoint, x, y);
+	}
+	else
+	{
+		Math2d::SetVec(resultPoint, -1.0f, -1.0f);
+		status = eOutOfImage;
+	}
+}
+
+
+struct KLTTrackParameters
+{
+	const CKLTTracker *pTracker;
+	const Vec2d *pPoints;
+	Vec2d *pResultPoints;
+	CKLTTracker::PointStatus *pStatus;
+	float *pScratch;
+	int nScratchSize;
+	int nPoints;
+	int nTasks;
+};
+
+void CKLTTracker::TrackPoints(void *pParameter, int nFirst, int nLast)
+{
+	const KLTTrackParameters &parameters = *(const KLTTrackParameters *) pParameter;
+	
+	// each task processes a contiguous range of points with its own scratch memory
+	for (int t = nFirst; t < nLast; t++)
+	{
+		const int nStart = int((long long) parameters.nPoints * t / parameters.nTasks);
+		const int nEnd = int((long long) parameters.nPoints * (t + 1) / parameters.nTasks);
 		
-		const int x_ = int(floorf(x));
-		const int y_ = int(floorf(y));
+		float *pScratch = parameters.pScratch + t * parameters.nScratchSize;
 		
-		if (x_ > m_nHalfWindowSize && x_ < width - m_nHalfWindowSize - 3 && y_ > m_nHalfWindowSize && y_ < height - m_nHalfWindowSize - 3)
-			Math2d::SetVec(pResultPoints[i], x, y);
-		else
-			Math2d::SetVec(pResultPoints[i], -1.0f, -1.0f);
+		for (int i = nStart; i < nEnd; i++)
+		{
+			PointStatus status;
+			parameters.pTracker->TrackPoint(parameters.pPoints[i], parameters.pResultPoints[i], status, pScratch);
+			
+			if (parameters.pStatus)
+				parameters.pStatus[i] = status;
+		}
+	}
+}
+
+bool CKLTTracker::Track(const CByteImage *pImage, const Vec2d *pPoints, int nPoints, Vec2d *pResultPoints, PointStatus *pStatus)
+{
+	if (pImage->type != CByteImage::eGrayScale)
+	{
+		printf("error: image must be of type eGrayScale for CKLTTracker::Track\n");
+		return false;
 	}
 	
-	// swap pyramids
-	CByteImage **ppTemp = m_ppPyramidI;
-	m_ppPyramidI = m_ppPyramidJ;
-	m_ppPyramidJ = ppTemp;
+	if (pImage->width != width || pImage->height != height)
+	{
+		printf("error: image size does not match the size given to the constructor in CKLTTracker::Track\n");
+		return false;
+	}
 	
-	// free memory
-	delete [] IX;
-	delete [] IY;
-	delete [] pGrayValues;
+	if (!m_bInitialized)
+	{
+		BuildPyramid(pImage, m_pPyramidI);
+		m_bInitialized = true;
+	}
+	
+	BuildPyramid(pImage, m_pPyramidJ);
+	
+	// distribute the points to the worker pool
+	int nTasks = nPoints / KLT_MIN_POINTS_PER_TASK;
+	
+	if (nTasks > Threading::GetNumberOfWorkerThreads())
+		nTasks = Threading::GetNumberOfWorkerThreads();
+	
+	if (nTasks < 1)
+		nTasks = 1;
+	
+	const int nScratchSize = 3 * (2 * m_nHalfWindowSize + 1) * m_nWindowStride;
+	
+	if (nTasks > m_nScratchTasks)
+	{
+		delete [] m_pScratch;
+		m_pScratch = new float[nTasks * nScratchSize];
+		m_nScratchTasks = nTasks;
+	}
+	
+	KLTTrackParameters parameters = { this, pPoints, pResultPoints, pStatus, m_pScratch, nScratchSize, nPoints, nTasks };
+	Threading::ParallelFor(TrackPoints, &parameters, nTasks, 1);
+	
+	// the pyramid of the current image becomes the pyramid of the previous image
+	PyramidLevel *pTemp = m_pPyramidI;
+	m_pPyramidI = m_pPyramidJ;
+	m_pPyramidJ = pTemp;
 	
 	return true;
 }
-
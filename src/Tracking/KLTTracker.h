@@ -48,6 +48,7 @@
 // ****************************************************************************
 
 class CByteImage;
+class CShortImage;
 struct Vec2d;
 
 
@@ -59,10 +60,25 @@ struct Vec2d;
 /*!
 	\ingroup Tracking
 	\brief Implementation of the Kanade Lucas Tomasi optical flow tracking algorithm.
+
+	The image pyramid of each frame is built once, together with the gradient images of all levels, and serves
+	as the pyramid of the previous frame in the next call of Track(). The points are distributed over the worker pool
+	of the IVT if it has been enabled with Threading::SetNumberOfWorkerThreads(int); the result does not depend on the number of threads.
+	If the IVT is built with USE_SIMD, the interpolation of the windows uses SSE2.
 */
 class CKLTTracker
 {
 public:
+	// enums
+	enum PointStatus
+	{
+		eTracked,		// the point has been tracked successfully
+		eInvalidInput,	// both coordinates of the input point were negative, the result is (-1, -1)
+		eOutOfImage,	// the tracked point left the image (including the border of the window size), the result is (-1, -1)
+		eNoTexture,		// the gradient matrix of the window was singular at the finest level, the result has not been refined at this level
+		eNotConverged	// the maximum number of iterations was reached or the window left the image at the finest level
+	};
+
 	// constructor
 	CKLTTracker(int width, int height, int nLevels, int nHalfWindowSize);
 	
@@ -71,17 +87,39 @@ public:
 	
 		
 	// public methods
-	bool Track(const CByteImage *pImage, const Vec2d *pPoints, int nPoints, Vec2d *pResultPoints);
+	// pImage must be a grayscale image of the size given to the constructor
+	// pStatus (optional) receives the status of each point
+	bool Track(const CByteImage *pImage, const Vec2d *pPoints, int nPoints, Vec2d *pResultPoints, PointStatus *pStatus = 0);
 	
 	
 private:
+	// private structs
+	struct PyramidLevel
+	{
+		CByteImage *pImage;
+		// central differences (not divided by 2), 0 at the image borders
+		CShortImage *pGradientX;
+		CShortImage *pGradientY;
+	};
+	
+	// private methods
+	void BuildPyramid(const CByteImage *pImage, PyramidLevel *pPyramid);
+	void TrackPoint(const Vec2d &point, Vec2d &resultPoint, PointStatus &status, float *pScratch) const;
+	static void TrackPoints(void *pParameter, int nFirst, int nLast);
+	
 	// private attributes
-	CByteImage **m_ppPyramidI, **m_ppPyramidJ;
+	PyramidLevel *m_pPyramidI, *m_pPyramidJ;
 	float *m_pScaleFactors;
 	const int m_nLevels;
 	const int m_nHalfWindowSize;
 	const int width, height;
 	bool m_bInitialized;
+	
+	// row length of the window buffers (window size rounded up to a multiple of 4)
+	int m_nWindowStride;
+	// scratch memory for the windows, one block per task
+	float *m_pScratch;
+	int m_nScratchTasks;
 };
 
 
@@ -521,6 +521,8 @@ bool CLinux1394Capture::InitCameraMode()
 		m_pTempImageHeader->bytesPerPixel = 3;
 		m_pTempImageHeader->type = CByteImage::eRGB24;
 	}
+	
+	m_pTempImageHeader->stride = m_pTempImageHeader->width * m_pTempImageHeader->bytesPerPixel;
 
 	return true;
 }
@@ -534,11 +536,12 @@ void CLinux1394Capture::ConvertYUV411(CByteImage* pInput, CByteImage* pOutput)
 	int y1,y2,y3,y4,u,v;
 	int r,g,b;
 	
-	unsigned char* output = pOutput->pixels;
 	unsigned char* input = pInput->pixels;
 	// read chunks
 	for(int i = 0 ; i < height ; i++)
 	{
+		unsigned char* output = pOutput->pixels + i * pOutput->GetStride();
+		
 		for(int j = 0 ; j < width / 4 ; j++)
 		{
 			u  = input[0];
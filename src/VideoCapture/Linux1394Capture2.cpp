@@ -605,6 +605,7 @@ bool CLinux1394Capture2::InitCameraMode()
 		m_pTempImageHeader->height = height;
 		m_pTempImageHeader->bytesPerPixel = 1;
 		m_pTempImageHeader->type = CByteImage::eGrayScale;
+		m_pTempImageHeader->stride = width;
 		
 		return true;
 	}
@@ -726,6 +727,8 @@ bool CLinux1394Capture2::InitCameraMode()
 		m_pTempImageHeader->bytesPerPixel = 3;
 		m_pTempImageHeader->type = CByteImage::eRGB24;
 	}
+	
+	m_pTempImageHeader->stride = m_pTempImageHeader->width * m_pTempImageHeader->bytesPerPixel;
 
 	return true;
 }
@@ -739,11 +742,12 @@ void CLinux1394Capture2::ConvertYUV411(CByteImage* pInput, CByteImage* pOutput)
 	int y1,y2,y3,y4,u,v;
 	int r,g,b;
 	
-	unsigned char* output = pOutput->pixels;
 	unsigned char* input = pInput->pixels;
 	// read chunks
 	for(int i = 0 ; i < height ; i++)
 	{
+		unsigned char* output = pOutput->pixels + i * pOutput->GetStride();
+		
 		for(int j = 0 ; j < width / 4 ; j++)
 		{
 			u  = input[0];
@@ -818,6 +822,10 @@ bool CLinux1394Capture2::CaptureImage(CByteImage **ppImages)
 		}
 
 		m_pTempImageHeader->pixels = (unsigned char *) pCurrentFrame->image;
+		
+		// wrap the DMA buffer including its row padding
+		if (m_colorMode != eYUV411ToRGB24)
+			m_pTempImageHeader->stride = pCurrentFrame->stride;
 
 		switch (m_colorMode)
 		{
@@ -869,6 +877,7 @@ bool CLinux1394Capture2::CaptureBayerPatternImage(CByteImage **ppImages)
 		}
 
 		m_pTempImageHeader->pixels = (unsigned char *) pCurrentFrame->image;
+		m_pTempImageHeader->stride = pCurrentFrame->stride;
 		
 		if(m_bFormat7Mode)
 		{
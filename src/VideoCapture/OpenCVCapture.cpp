@@ -121,21 +121,25 @@ bool COpenCVCapture::CaptureImage(CByteImage **ppImages)
 	else if (m_pIplImage->nChannels == 3 && pImage->type != CByteImage::eRGB24)
 		return false;
 	
-	const int nBytes = pImage->width * pImage->height * pImage->bytesPerPixel;
-	unsigned char *input = (unsigned char *) m_pIplImage->imageData;
-	unsigned char *output = pImage->pixels;
-
-	if (pImage->type == CByteImage::eGrayScale)
-	{
-		memcpy(output, input, nBytes);
-	}
-	else if (pImage->type == CByteImage::eRGB24)
+	const int nRowBytes = pImage->width * pImage->bytesPerPixel;
+	
+	for (int y = 0; y < pImage->height; y++)
 	{
-		for (int i = 0; i < nBytes; i += 3)
+		const unsigned char *input = (unsigned char *) m_pIplImage->imageData + y * m_pIplImage->widthStep;
+		unsigned char *output = pImage->pixels + y * pImage->GetStride();
+		
+		if (pImage->type == CByteImage::eGrayScale)
+		{
+			memcpy(output, input, nRowBytes);
+		}
+		else if (pImage->type == CByteImage::eRGB24)
 		{
-			output[i] = input[i + 2];
-			output[i + 1] = input[i + 1];
-			output[i + 2] = input[i];
+			for (int i = 0; i < nRowBytes; i += 3)
+			{
+				output[i] = input[i + 2];
+				output[i + 1] = input[i + 1];
+				output[i + 2] = input[i];
+			}
 		}
 	}
 
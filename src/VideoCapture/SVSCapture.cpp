@@ -136,8 +136,13 @@ bool CSVSCapture::CaptureImage(CByteImage **ppImages)
 	}
 	else
 	{
-		memcpy(ppImages[1]->pixels, svs_image->left, width * height * m_nBytesPerPixel);
-		memcpy(ppImages[0]->pixels, svs_image->right, width * height * m_nBytesPerPixel);
+		const int nRowBytes = width * m_nBytesPerPixel;
+		
+		for (int y = 0; y < height; y++)
+		{
+			memcpy(ppImages[1]->pixels + y * ppImages[1]->GetStride(), svs_image->left + y * nRowBytes, nRowBytes);
+			memcpy(ppImages[0]->pixels + y * ppImages[0]->GetStride(), svs_image->right + y * nRowBytes, nRowBytes);
+		}
 	}
 
 	return true;
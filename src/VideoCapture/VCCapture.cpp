@@ -109,7 +109,7 @@ bool CVCCapture::CaptureImage(CByteImage ** ppImages)
 		std::copy(scr_pixels, scr_pixels+w, img_pixels);
 
 		scr_pixels += m_pitch;
-		img_pixels += ppImages[0]->width;
+		img_pixels += ppImages[0]->GetStride();
 	}
 
 	return true;
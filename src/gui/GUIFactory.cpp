@@ -184,15 +184,7 @@ bool LoadImageFromFile(const char *filename, CByteImage *pImage)
 		int width = img.width();
 		int height = img.height();
 		
-		if (pImage->m_bOwnMemory)
-			delete [] pImage->pixels;
-		
-		pImage->width = width;
-		pImage->height = height;
-		pImage->bytesPerPixel = (img.depth() == 8 ? 1 : 3);
-		pImage->type = (img.depth() <= 8 ? CByteImage::eGrayScale : CByteImage::eRGB24);
-		pImage->pixels = new unsigned char[pImage->bytesPerPixel * width*height];
-		pImage->m_bOwnMemory = true;
+		pImage->Set(width, height, img.depth() <= 8 ? CByteImage::eGrayScale : CByteImage::eRGB24);
 		
 		uchar *ptr = img.bits();
 		if (img.depth() == 32)
@@ -318,15 +310,7 @@ bool LoadImageFromFile(const char *filename, CByteImage *pImage)
 		
 		if (bits_per_sample == 8 && (channels == 1 || channels == 3  || channels == 4))
 		{
-			if (pImage->m_bOwnMemory)
-				delete [] pImage->pixels;
-		
-			pImage->width = width;
-			pImage->height = height;
-			pImage->bytesPerPixel = channels;
-			pImage->type = (channels == 3 ? CByteImage::eGrayScale : CByteImage::eRGB24);
-			pImage->pixels = new unsigned char[pImage->bytesPerPixel * width * height];
-			pImage->m_bOwnMemory = true;
+			pImage->Set(width, height, channels == 1 ? CByteImage::eGrayScale : CByteImage::eRGB24);
 			
 			if (channels == 1)
 			{
@@ -509,15 +493,7 @@ bool LoadImageFromFile(const char *filename, CByteImage *pImage)
 	pPicture->Render(hdcTemp, 0, 0, lWidthPixels, lHeightPixels, 0, 0, lWidth, lHeight, 0);
 
 	
-	if (pImage->m_bOwnMemory)
-		delete [] pImage->pixels;
-	
-	pImage->width = lWidthPixels;
-	pImage->height = lHeightPixels;
-	pImage->bytesPerPixel = 3;
-	pImage->type = CByteImage::eRGB24;
-	pImage->pixels = new unsigned char[pImage->bytesPerPixel * lWidthPixels*lHeightPixels];
-	pImage->m_bOwnMemory = true;
+	pImage->Set(lWidthPixels, lHeightPixels, CByteImage::eRGB24);
 
 	unsigned char *output = pImage->pixels;
 
@@ -604,15 +580,7 @@ bool LoadImageFromFile(const char *filename, CByteImage *pImage)
 	
 	if (CocoaLoadImage(filename, &ptr, &width, &height, &type))
 	{
-		if (pImage->m_bOwnMemory)
-			delete [] pImage->pixels;
-	
-		pImage->width = width;
-		pImage->height = height;
-		pImage->bytesPerPixel = (type == 1 ? 1 : 3);
-		pImage->type = (type == 1 ? CByteImage::eGrayScale : CByteImage::eRGB24);
-		pImage->pixels = new unsigned char[pImage->bytesPerPixel * width * height];
-		pImage->m_bOwnMemory = true;
+		pImage->Set(width, height, type == 1 ? CByteImage::eGrayScale : CByteImage::eRGB24);
 		
 		memcpy(pImage->pixels, ptr, pImage->bytesPerPixel * width * height);
 	
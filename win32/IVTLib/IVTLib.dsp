@@ -209,6 +209,14 @@ SOURCE=..\..\src\Image\ShortImage.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\src\Image\BinaryImage.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\src\Image\BinaryImage.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\src\Image\StereoMatcher.cpp
 # End Source File
 # Begin Source File
@@ -223,6 +231,14 @@ SOURCE=..\..\src\Image\StereoVision.cpp
 
 SOURCE=..\..\src\Image\StereoVision.h
 # End Source File
+# Begin Source File
+
+SOURCE=..\..\src\Image\StereoVisionSGM.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\src\Image\StereoVisionSGM.h
+# End Source File
 # End Group
 # Begin Group "ObjectFinder"
 
@@ -349,6 +365,14 @@ SOURCE=..\..\src\Helpers\PerformanceLib.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\src\Helpers\OptimizedFunctionsSIMD.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\src\Helpers\OptimizedFunctionsSIMD.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\src\Helpers\Quicksort.cpp
 # End Source File
 # Begin Source File
@@ -391,6 +415,10 @@ SOURCE=..\..\src\DataProcessing\RANSAC.cpp
 
 SOURCE=..\..\src\DataProcessing\RANSAC.h
 # End Source File
+# Begin Source File
+
+SOURCE=..\..\src\DataProcessing\RANSACTemplate.h
+# End Source File
 # End Group
 # Begin Group "Interfaces"
 
@@ -521,6 +549,18 @@ SOURCE=..\..\src\Math\LinearAlgebra.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\src\Math\FixedSizeLinearAlgebra.h
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\src\Math\VectorDistance.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\src\Math\VectorDistance.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\src\Math\Matd.cpp
 # End Source File
 # Begin Source File
@@ -657,6 +697,14 @@ SOURCE=..\..\src\Threading\Threading.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\src\Threading\WorkerPool.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\src\Threading\WorkerPool.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\src\Threading\WindowsThread.cpp
 # End Source File
 # Begin Source File
@@ -688,6 +736,22 @@ SOURCE=..\..\src\DataStructures\KdTree\KdTree.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\src\DataStructures\KdTree\KdForest.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\src\DataStructures\KdTree\KdForest.h
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\src\DataStructures\KdTree\KdIndexFile.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\src\DataStructures\KdTree\KdIndexFile.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\src\DataStructures\KdTree\KdUtils.h
 # End Source File
 # End Group
@@ -811,6 +875,14 @@ SOURCE=..\..\src\Features\FeatureSet.cpp
 
 SOURCE=..\..\src\Features\FeatureSet.h
 # End Source File
+# Begin Source File
+
+SOURCE=..\..\src\Features\FeatureMatrix.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\src\Features\FeatureMatrix.h
+# End Source File
 # End Group
 # Begin Group "Networking"
 